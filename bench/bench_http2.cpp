@@ -0,0 +1,355 @@
+/**
+ * @file bench_http2.cpp
+ * @brief 相同并发下 HTTP/1.1 多连接与 h2c 单连接多路复用的连接数、内存与吞吐对比
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 03:18:40
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_http2 [h1|h2] [并发数，默认500] [轮数，默认200]
+ *   - h1: 每个并发一条 keep-alive 连接，每轮各发一个请求
+ *   - h2: 一条连接，每轮同时打开 N 个流
+ * 服务端与客户端在同一进程内，两种方式需分别运行；打印服务端连接数、
+ * 建立并发后的 RSS 增量(含服务端 Buffer/Channel/HttpContext 等每连接开销)与吞吐。
+ */
+#include "net/http/http2.h"
+#include "net/http/hpack.h"
+#include "net/http/http_server.h"
+#include "net/http/http_context.h"
+#include "net/http/http_response.h"
+#include "net/event_loop.h"
+#include "net/tcp_connection.h"
+#include "base/event_loop_thread.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+/// @brief 当前驻留内存(KB)
+long CurrentRssKb()
+{
+    long pages = 0;
+    long resident = 0;
+    if(FILE *fp = std::fopen("/proc/self/statm", "r"))
+    {
+        if(std::fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+        {
+            resident = 0;
+        }
+        std::fclose(fp);
+    }
+    return resident * (::sysconf(_SC_PAGESIZE) / 1024);
+}
+
+double NowSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int ConnectTo(uint16_t port)
+{
+    for(int i = 0; i < 50; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = ::htons(port);
+        addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+        if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+        {
+            // 窗口更新与下一轮请求是两次小写，避免 Nagle 与对端延迟确认叠加
+            int on = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            return fd;
+        }
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return -1;
+}
+
+bool SendAll(int fd, const std::string &data)
+{
+    size_t sent = 0;
+    while(sent < data.size())
+    {
+        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+        if(n <= 0)
+        {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/// @brief 读完一个带 Content-Length 的 HTTP/1.1 响应
+bool ReadHttp1Response(int fd, std::string &in)
+{
+    char buf[4096];
+    while(true)
+    {
+        const size_t head_end = in.find("\r\n\r\n");
+        if(std::string::npos != head_end)
+        {
+            const size_t pos = in.find("Content-Length: ");
+            const size_t body = pos < head_end ? std::strtoul(in.c_str() + pos + 16, nullptr, 10) : 0;
+            if(in.size() >= head_end + 4 + body)
+            {
+                in.erase(0, head_end + 4 + body);
+                return true;
+            }
+        }
+        const ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if(n <= 0)
+        {
+            return false;
+        }
+        in.append(buf, static_cast<size_t>(n));
+    }
+}
+
+class Http1Client
+{
+public:
+    bool connect(uint16_t port, int conns)
+    {
+        for(int i = 0; i < conns; ++i)
+        {
+            const int fd = ConnectTo(port);
+            if(fd < 0)
+            {
+                return false;
+            }
+            _fds.push_back(fd);
+        }
+        _in.resize(_fds.size());
+        return true;
+    }
+
+    ~Http1Client()
+    {
+        for(int fd : _fds)
+        {
+            ::close(fd);
+        }
+    }
+
+    bool round()
+    {
+        static const std::string kRequest = "GET /hello HTTP/1.1\r\nHost: bench\r\n\r\n";
+        for(int fd : _fds)
+        {
+            if(!SendAll(fd, kRequest))
+            {
+                return false;
+            }
+        }
+        for(size_t i = 0; i < _fds.size(); ++i)
+        {
+            if(!ReadHttp1Response(_fds[i], _in[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::vector<int> _fds;
+    std::vector<std::string> _in;
+};
+
+class Http2Client
+{
+public:
+    explicit Http2Client(int streams) :_streams(streams) {}
+
+    ~Http2Client()
+    {
+        if(_fd >= 0)
+        {
+            ::close(_fd);
+        }
+    }
+
+    bool connect(uint16_t port)
+    {
+        _fd = ConnectTo(port);
+        if(_fd < 0)
+        {
+            return false;
+        }
+        std::string out(kHttp2ClientPreface);
+        // 放大本端窗口，避免响应被客户端流控拖慢
+        AppendHttp2Settings(&out, {{Http2Setting::kInitialWindowSize, kHttp2MaxWindowSize}});
+        AppendHttp2WindowUpdate(&out, 0, kHttp2MaxWindowSize - kHttp2DefaultWindowSize);
+        return SendAll(_fd, out);
+    }
+
+    bool round()
+    {
+        std::string out;
+        HpackHeaderList headers{{":method", "GET"}, {":scheme", "http"}, {":path", "/hello"}, {":authority", "bench"}};
+        for(int i = 0; i < _streams; ++i)
+        {
+            std::string block;
+            _encoder.encode(headers, &block);
+            AppendHttp2Headers(&out, _nextStreamId, block, true, kHttp2DefaultMaxFrameSize);
+            _nextStreamId += 2;
+        }
+        if(!SendAll(_fd, out))
+        {
+            return false;
+        }
+
+        // 只统计流结束数，响应头部无需解码
+        int ended = 0;
+        uint32_t data_bytes = 0;
+        char buf[65536];
+        size_t pos = 0;
+        while(ended < _streams)
+        {
+            while(_in.size() - pos >= kHttp2FrameHeaderSize)
+            {
+                const Http2FrameHeader header = ParseHttp2FrameHeader(_in.data() + pos);
+                if(_in.size() - pos < kHttp2FrameHeaderSize + header.length)
+                {
+                    break;
+                }
+                if(Http2FrameType::kSettings == header.type && !(header.flags & Http2Flags::kAck))
+                {
+                    std::string ack;
+                    AppendHttp2SettingsAck(&ack);
+                    SendAll(_fd, ack);
+                }
+                else if((Http2FrameType::kHeaders == header.type || Http2FrameType::kData == header.type)
+                        && (header.flags & Http2Flags::kEndStream))
+                {
+                    ++ended;
+                }
+                else if(Http2FrameType::kRstStream == header.type || Http2FrameType::kGoAway == header.type)
+                {
+                    std::fprintf(stderr, "unexpected frame type %d\n", static_cast<int>(header.type));
+                    return false;
+                }
+                if(Http2FrameType::kData == header.type)
+                {
+                    data_bytes += header.length;
+                }
+                pos += kHttp2FrameHeaderSize + header.length;
+            }
+            if(ended >= _streams)
+            {
+                break;
+            }
+            _in.erase(0, pos);
+            pos = 0;
+            const ssize_t n = ::recv(_fd, buf, sizeof(buf), 0);
+            if(n <= 0)
+            {
+                return false;
+            }
+            _in.append(buf, static_cast<size_t>(n));
+        }
+        _in.erase(0, pos);
+        if(data_bytes > 0)
+        {
+            std::string update;
+            AppendHttp2WindowUpdate(&update, 0, data_bytes);
+            return SendAll(_fd, update);
+        }
+        return true;
+    }
+
+private:
+    const int _streams;
+    int _fd{-1};
+    uint32_t _nextStreamId{1};
+    HpackEncoder _encoder;
+    std::string _in;
+};
+
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+
+    const bool h2 = argc > 1 && std::strcmp(argv[1], "h2") == 0;
+    const int concurrency = argc > 2 ? std::atoi(argv[2]) : 500;
+    const int rounds = argc > 3 ? std::atoi(argv[3]) : 200;
+    const uint16_t port = 18000 + (::getpid() % 2000);
+
+    EventLoopThread loop_thread(nullptr, "bench_http2");
+    EventLoop *loop = loop_thread.startLoop();
+    std::shared_ptr<HttpServer> server;
+    std::promise<void> started;
+    loop->runInLoop([&]() {
+        server = std::make_shared<HttpServer>(loop, InetAddress(port, "127.0.0.1"), "bench-http2", false);
+        Http2Session::Config config;
+        config.maxConcurrentStreams = static_cast<uint32_t>(concurrency);
+        server->enableHttp2(config);
+        server->Get("/hello", [](TcpConnectionPtr, HttpContextPtr ctx) {
+            auto resp = ctx->response();
+            resp->setVersion(Version::kHttp11);
+            resp->setStateCode(StateCode::k200Ok);
+            resp->body().appendData("hello");
+        });
+        server->start();
+        started.set_value();
+    });
+    started.get_future().wait();
+
+    const long rss_before = CurrentRssKb();
+    Http1Client h1_client;
+    Http2Client h2_client(concurrency);
+    auto round = [&]() { return h2 ? h2_client.round() : h1_client.round(); };
+    if(!(h2 ? h2_client.connect(port) : h1_client.connect(port, concurrency)) || !round())
+    {
+        std::fprintf(stderr, "connect or warm-up failed\n");
+        return 1;
+    }
+    const long rss_after = CurrentRssKb();
+
+    const double begin = NowSeconds();
+    for(int i = 0; i < rounds; ++i)
+    {
+        if(!round())
+        {
+            std::fprintf(stderr, "round %d failed\n", i);
+            return 1;
+        }
+    }
+    const double secs = NowSeconds() - begin;
+
+    std::printf("%-6s %12s %12s %14s %14s\n", "mode", "concurrency", "server-conns", "rss-delta(KB)", "req/s");
+    std::printf("%-6s %12d %12d %14ld %14.0f\n", h2 ? "h2c" : "http1", concurrency, h2 ? 1 : concurrency,
+                rss_after - rss_before, static_cast<double>(concurrency) * rounds / secs);
+
+    std::promise<void> stopped;
+    loop->runInLoop([&]() {
+        server.reset();
+        stopped.set_value();
+    });
+    stopped.get_future().wait();
+    return 0;
+}
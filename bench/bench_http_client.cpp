@@ -0,0 +1,194 @@
+/**
+ * @file bench_http_client.cpp
+ * @brief HttpClient 对本地 HttpServer 的吞吐: 每请求新建连接 / keep-alive 连接池 / 流水线
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 18:47:10
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_http_client [请求数，默认20000] [并发请求数，默认64] [每主机连接数，默认8] [服务端IO线程数，默认2]
+ * 闭环压测: 始终保持 N 个请求在途，每完成一个立即发出下一个，客户端独占一个循环线程。
+ *   - close:    请求带 Connection: close，每个请求一次 connect/close
+ *   - pool:     keep-alive 连接池，pipelineDepth = 1
+ *   - pipeline: keep-alive 连接池，pipelineDepth = 8
+ * reused% 为落在已完成过请求的连接上的请求占比。
+ */
+#include "net/http/http_client.h"
+#include "net/http/http_server.h"
+#include "net/http/http_context.h"
+#include "net/http/http_response.h"
+#include "net/event_loop.h"
+#include "net/net_log.h"
+#include "base/event_loop_thread.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <string>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+double NowSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct RunResult {
+    bool ok{false};
+    double seconds{0.0};
+    HttpClient::Stats stats;
+};
+
+/**
+ * @brief 在客户端循环线程中驱动的闭环请求源
+ */
+struct Driver: std::enable_shared_from_this<Driver> {
+    HttpClient::Ptr client;
+    InetAddress server;
+    bool close{false};
+    int total{0};
+    int issued{0};
+    int done{0};
+    int failed{0};
+    std::promise<void> finished;
+
+    Driver(HttpClient::Ptr c, const InetAddress &addr)
+        :client(std::move(c))
+        ,server(addr)
+    {}
+
+    void issue()
+    {
+        if(issued >= total)
+        {
+            return;
+        }
+        ++issued;
+        HttpRequest req;
+        req.setMethod(HttpRequest::Method::kGet);
+        req.setPath("/hello");
+        if(close)
+        {
+            req.addHeader("Connection", "close");
+        }
+        client->request(server, std::move(req), [self = shared_from_this()](HttpClient::Result result) {
+            if(!result.ok() || 200 != result.response->stateCode()())
+            {
+                ++self->failed;
+            }
+            if(++self->done == self->total)
+            {
+                self->finished.set_value();
+                return;
+            }
+            self->issue();
+        });
+    }
+};
+
+RunResult RunMode(EventLoop *loop, uint16_t port, bool close, size_t pipeline, int requests, int concurrency, size_t connections)
+{
+    RunResult result;
+    HttpClient::Config config;
+    config.maxConnectionsPerHost = connections;
+    config.pipelineDepth = pipeline;
+    auto client = std::make_shared<HttpClient>(loop, config);
+    auto driver = std::make_shared<Driver>(client, InetAddress(port, "127.0.0.1"));
+    driver->close = close;
+    driver->total = requests;
+    std::future<void> finished = driver->finished.get_future();
+
+    const double start = NowSeconds();
+    loop->runInLoop([driver, concurrency]() {
+        for(int i = 0; i < concurrency; ++i)
+        {
+            driver->issue();
+        }
+    });
+    if(finished.wait_for(std::chrono::seconds(120)) != std::future_status::ready)
+    {
+        return result;
+    }
+    result.seconds = NowSeconds() - start;
+
+    std::promise<void> collected;
+    loop->runInLoop([&]() {
+        result.stats = client->stats();
+        result.ok = 0 == driver->failed;
+        // 客户端在循环线程中销毁
+        driver.reset();
+        client.reset();
+        collected.set_value();
+    });
+    collected.get_future().wait();
+    return result;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+
+    const int requests = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const int concurrency = argc > 2 ? std::atoi(argv[2]) : 64;
+    const size_t connections = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 8;
+    const int threads = argc > 4 ? std::atoi(argv[4]) : 2;
+
+    const uint16_t port = static_cast<uint16_t>(24000 + ::getpid() % 2000);
+    EventLoopThread server_thread(nullptr, "bench_http_server");
+    EventLoop *server_loop = server_thread.startLoop();
+    std::shared_ptr<HttpServer> server;
+    std::promise<void> started;
+    server_loop->runInLoop([&]() {
+        server = std::make_shared<HttpServer>(server_loop, InetAddress(port, "127.0.0.1"), "bench-http-client", false, TcpServer::KReusePort);
+        server->setThreadNum(threads);
+        server->Get("/hello", [](TcpConnectionPtr conn, HttpContextPtr ctx) {
+            auto resp = ctx->response();
+            resp->setVersion(Version::kHttp11);
+            resp->setStateCode(StateCode::k200Ok);
+            resp->body().appendData("hello world");
+        });
+        server->start();
+        started.set_value();
+    });
+    started.get_future().wait();
+
+    EventLoopThread client_thread(nullptr, "bench_http_client");
+    EventLoop *client_loop = client_thread.startLoop();
+
+    struct Mode { const char *name; bool close; size_t pipeline; };
+    const Mode modes[] = {{"close", true, 1}, {"pool", false, 1}, {"pipeline", false, 8}};
+
+    std::printf("%-9s %9s %6s %6s %10s %9s %8s\n",
+                "mode", "requests", "conc", "conns", "req/s", "connects", "reused%");
+    for(const Mode &mode : modes)
+    {
+        const RunResult result = RunMode(client_loop, port, mode.close, mode.pipeline, requests, concurrency, connections);
+        if(!result.ok)
+        {
+            std::fprintf(stderr, "mode %s failed\n", mode.name);
+            return 1;
+        }
+        std::printf("%-9s %9d %6d %6zu %10.0f %9lu %8.1f\n", mode.name, requests, concurrency, connections,
+                    requests / result.seconds, static_cast<unsigned long>(result.stats.connects),
+                    100.0 * result.stats.reusedRequests / requests);
+    }
+
+    std::promise<void> stopped;
+    server_loop->runInLoop([&]() {
+        server.reset();
+        server_loop->quit();
+        stopped.set_value();
+    });
+    stopped.get_future().wait_for(std::chrono::seconds(2));
+    return 0;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file bench_http_headers.cpp
+ * @brief HTTP头部解析/查找/序列化耗时
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 14:02:11
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_http_headers [迭代次数，默认200000]
+ * parse:     HttpContext 解析16个头部的请求，并查找 Connection/Content-Length/Host/Accept-Encoding
+ * serialize: HttpResponse 设置8个头部后 headerString
+ * response:  典型JSON响应(200 + 64字节Body，keep-alive/close 交替) toString
+ * container: 仅比较容器本身，旧实现(unordered_map+大小写敏感、按值返回) vs HttpHeaders
+ */
+#include "net/http/http_context.h"
+#include "net/http/http_headers.h"
+#include "net/http/http_request.h"
+#include "net/http/http_response.h"
+#include "net/buffer.h"
+#include "base/time_stamp.h"
+#include "net/net_log.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+const char kRequest[] =
+    "GET /api/v1/projects/42/files?name=kit HTTP/1.1\r\n"
+    "Host: api.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "Cookie: session=8f2a9c1d7e6b5a4f; theme=dark; lang=zh\r\n"
+    "Referer: https://api.example.com/projects\r\n"
+    "If-None-Match: \"5e8f-1a2b3c\"\r\n"
+    "If-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "X-Request-Id: 7d3c2b1a-0f9e-8d7c-6b5a-4f3e2d1c0b9a\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+/// @brief kRequest 中的16个头部
+std::vector<std::pair<std::string, std::string>> RequestHeaders()
+{
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string raw(kRequest);
+    size_t pos = raw.find("\r\n") + 2;
+    while(pos < raw.size())
+    {
+        size_t eol = raw.find("\r\n", pos);
+        if(eol == pos)
+        {
+            break;
+        }
+        size_t colon = raw.find(':', pos);
+        headers.emplace_back(raw.substr(pos, colon - pos), raw.substr(colon + 2, eol - colon - 2));
+        pos = eol + 2;
+    }
+    return headers;
+}
+
+template<class Fn>
+double NsPerOp(int iterations, Fn &&fn)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i)
+    {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+    size_t sink = 0;
+
+    double parse_ns = NsPerOp(iterations, [&](){
+        HttpContext context;
+        Buffer buf;
+        buf.append(kRequest, sizeof(kRequest) - 1);
+        context.parseRequest(buf, TimeStamp());
+        auto req = context.request();
+        sink += req->getHeader("Connection").size();
+        sink += req->getHeader("Content-Length").size();
+        sink += req->getHeader("Host").size();
+        sink += req->getHeader("Accept-Encoding").size();
+    });
+
+    double serialize_ns = NsPerOp(iterations, [&](){
+        HttpResponse resp;
+        resp.setVersion(Version::kHttp11);
+        resp.setStateCode(StateCode::k200Ok);
+        resp.addHeader("Server", "kit_server");
+        resp.addHeader("Content-Type", "application/json");
+        resp.addHeader("Cache-Control", "no-cache");
+        resp.addHeader("ETag", "\"5e8f-1a2b3c\"");
+        resp.addHeader("Last-Modified", "Sun, 06 Nov 1994 08:49:37 GMT");
+        resp.addHeader("Vary", "Accept-Encoding");
+        resp.addHeader("X-Request-Id", "7d3c2b1a-0f9e-8d7c-6b5a-4f3e2d1c0b9a");
+        resp.addHeader("Access-Control-Allow-Origin", "*");
+        sink += resp.headerString().size();
+    });
+
+    const std::string json_body(64, 'x');
+    int64_t n = 0;
+    double response_ns = NsPerOp(iterations, [&](){
+        HttpResponse resp;
+        resp.setVersion(Version::kHttp11);
+        resp.setStateCode(StateCode::k200Ok);
+        resp.setConnectionClosed(0 == (++n & 7));
+        resp.body().setContentType(ContentType::kJsonType);
+        resp.body().appendData(json_body);
+        sink += resp.toString().size();
+    });
+
+    const auto fields = RequestHeaders();
+    double legacy_ns = NsPerOp(iterations, [&](){
+        std::unordered_map<std::string, std::string> headers;
+        for(auto &field : fields)
+        {
+            headers[field.first] = field.second;
+        }
+        auto get = [&](const std::string &key){
+            auto it = headers.find(key);
+            return it == headers.end() ? std::string() : it->second;
+        };
+        sink += get("Connection").size();
+        sink += get("Content-Length").size();
+        sink += get("Host").size();
+        sink += get("Accept-Encoding").size();
+    });
+
+    double flat_ns = NsPerOp(iterations, [&](){
+        HttpHeaders headers;
+        for(auto &field : fields)
+        {
+            headers.combine(field.first, field.second);
+        }
+        sink += headers.get(HttpHeaderId::kConnection).size();
+        sink += headers.get(HttpHeaderId::kContentLength).size();
+        sink += headers.get("host").size();
+        sink += headers.get("accept-encoding").size();
+    });
+
+    std::printf("parse+lookup: %8.0f ns/op\n", parse_ns);
+    std::printf("serialize:    %8.0f ns/op\n", serialize_ns);
+    std::printf("response:     %8.0f ns/op\n", response_ns);
+    std::printf("container unordered_map: %8.0f ns/op\n", legacy_ns);
+    std::printf("container HttpHeaders:   %8.0f ns/op\n", flat_ns);
+    std::printf("(sink=%zu)\n", sink);
+    return 0;
+}
@@ -0,0 +1,200 @@
+/**
+ * @file bench_http_parser.cpp
+ * @brief HTTP请求解析器对比: llhttp / 自研(标量) / 自研(SSE4.2) / 自研(AVX2)
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 16:42:08
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_http_parser [每个用例的迭代次数，默认100000]
+ * 语料: tiny(最小GET)、headers(16个常见头部)、cookie(2KB Cookie)、
+ *       pipelined(单个缓冲内16个请求)、chunked(分块请求体，自研解析器不支持，记为 n/a)
+ * 输出每个请求的平均耗时(ns)与输入吞吐(MB/s)；最后单独统计各级别只做分隔符切分(不建对象)的耗时
+ */
+#include "net/http/http_context.h"
+#include "net/http/http_scanner.h"
+#include "net/buffer.h"
+#include "base/time_stamp.h"
+#include "net/net_log.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+struct Corpus {
+    const char *name;
+    std::string data;
+    /// @brief data 中包含的请求个数
+    int requests;
+    bool chunked;
+};
+
+const char kHeaderHeavy[] =
+    "GET /api/v1/projects/42/files?name=kit HTTP/1.1\r\n"
+    "Host: api.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "Cookie: session=8f2a9c1d7e6b5a4f; theme=dark; lang=zh\r\n"
+    "Referer: https://api.example.com/projects\r\n"
+    "If-None-Match: \"5e8f-1a2b3c\"\r\n"
+    "If-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "X-Request-Id: 7d3c2b1a-0f9e-8d7c-6b5a-4f3e2d1c0b9a\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+std::vector<Corpus> BuildCorpus()
+{
+    std::vector<Corpus> corpus;
+    corpus.push_back({"tiny", "GET / HTTP/1.1\r\nHost: a\r\n\r\n", 1, false});
+    corpus.push_back({"headers", kHeaderHeavy, 1, false});
+
+    std::string cookie = "GET /index.html HTTP/1.1\r\nHost: www.example.com\r\nCookie: ";
+    for(int i = 0; i < 64; ++i)
+    {
+        cookie += "k" + std::to_string(i) + "=0123456789abcdef0123456; ";
+    }
+    cookie += "end=1\r\nAccept: */*\r\n\r\n";
+    corpus.push_back({"cookie", cookie, 1, false});
+
+    std::string pipelined;
+    for(int i = 0; i < 16; ++i)
+    {
+        pipelined += "GET /item/" + std::to_string(i) + " HTTP/1.1\r\nHost: api.example.com\r\nAccept: */*\r\n\r\n";
+    }
+    corpus.push_back({"pipelined", pipelined, 16, false});
+
+    corpus.push_back({"chunked",
+        "POST /upload HTTP/1.1\r\nHost: api.example.com\r\nContent-Type: text/plain\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n"
+        "10\r\n0123456789abcdef\r\n10\r\n0123456789abcdef\r\n8\r\n01234567\r\n0\r\n\r\n", 1, true});
+    return corpus;
+}
+
+/// @return 每个请求的耗时(ns)，解析失败返回负数
+double Run(const Corpus &c, HttpContext::ParserType type, int iterations)
+{
+    int parsed = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i)
+    {
+        Buffer buf;
+        buf.append(c.data.data(), c.data.size());
+        while(buf.readableBytes() > 0)
+        {
+            HttpContext context(type);
+            if(!context.parseRequest(buf, TimeStamp()) || !context.gotAll())
+            {
+                return -1;
+            }
+            ++parsed;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    if(parsed != iterations * c.requests)
+    {
+        return -1;
+    }
+    return std::chrono::duration<double, std::nano>(end - begin).count() / parsed;
+}
+
+/// @brief 只做逐行切分: 每行找 ':'/'\r'，再找行尾CRLF
+double RunTokenize(const Corpus &c, int iterations)
+{
+    size_t sink = 0;
+    const char *begin = c.data.data();
+    const char *end = begin + c.data.size();
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i)
+    {
+        const char *p = begin;
+        while(p < end)
+        {
+            const char *delim = HttpFindEither(p, end, ':', '\r');
+            const char *crlf = HttpFindCRLF(delim ? delim : p, end);
+            if(!crlf)
+            {
+                break;
+            }
+            sink += static_cast<size_t>(crlf - p);
+            p = crlf + 2;
+        }
+    }
+    auto stop = std::chrono::steady_clock::now();
+    if(0 == sink)
+    {
+        return -1;
+    }
+    return std::chrono::duration<double, std::nano>(stop - start).count() / (static_cast<double>(iterations) * c.requests);
+}
+
+void Print(const Corpus &c, double ns)
+{
+    if(ns < 0)
+    {
+        std::printf(" %20s", "n/a");
+        return;
+    }
+    const double bytes_per_req = static_cast<double>(c.data.size()) / c.requests;
+    std::printf(" %9.0f ns %6.0f MB/s", ns, bytes_per_req * 1e3 / ns);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const HttpScanLevel best = DetectHttpScanLevel();
+    const auto corpus = BuildCorpus();
+
+    std::printf("cpu best scan level: %s\n", HttpScanLevelName(best));
+    std::printf("%-10s %20s", "corpus", "llhttp");
+    for(uint8_t l = 0; l <= static_cast<uint8_t>(best); ++l)
+    {
+        std::printf(" %20s", (std::string("custom-") + HttpScanLevelName(static_cast<HttpScanLevel>(l))).c_str());
+    }
+    std::printf("\n");
+
+    for(const auto &c : corpus)
+    {
+        std::printf("%-10s", c.name);
+        Print(c, Run(c, HttpContext::kLLhttpParser, iterations));
+        for(uint8_t l = 0; l <= static_cast<uint8_t>(best); ++l)
+        {
+            SetHttpScanLevel(static_cast<HttpScanLevel>(l));
+            Print(c, c.chunked ? -1 : Run(c, HttpContext::kCustomParser, iterations));
+        }
+        SetHttpScanLevel(best);
+        std::printf("\n");
+    }
+
+    std::printf("\ntokenize only (no request objects)\n");
+    for(const auto &c : corpus)
+    {
+        std::printf("%-10s %20s", c.name, "");
+        for(uint8_t l = 0; l <= static_cast<uint8_t>(best); ++l)
+        {
+            SetHttpScanLevel(static_cast<HttpScanLevel>(l));
+            Print(c, RunTokenize(c, iterations * 10));
+        }
+        SetHttpScanLevel(best);
+        std::printf("\n");
+    }
+    return 0;
+}
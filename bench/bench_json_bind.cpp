@@ -0,0 +1,202 @@
+/**
+ * @file bench_json_bind.cpp
+ * @brief 典型 API 报文的 JSON 绑定与响应序列化: nlohmann DOM 路径 vs 流式读写
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 12:51:37
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_json_bind [迭代次数，默认20000]
+ * 报文: order 单个订单(3 个商品，约 370 字节)；page 50 个订单的分页列表(约 19KB)
+ * bind:
+ *   nlohmann  原 BindWithJson: body().data() 拷贝出 vector，parse 成 DOM 再 get<T>()
+ *   stream    JsonDecode 直接从 body().view() 解析到对象
+ * reply:
+ *   nlohmann  nljson j = obj; j.dump() 得到字符串后 appendData 进响应 Body
+ *   stream    HttpResponse::setJsonBody，JsonWriter 直接写入 Body
+ */
+#include "base/json_stream.h"
+#include "net/http/http_response.h"
+#include "net/http/http_util.h"
+#include "net/net_log.h"
+#include "nlohmann/json.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace shop {
+
+struct Item {
+    std::string sku;
+    std::string name;
+    int32_t qty{0};
+    double price{0.0};
+};
+KIT_JSON_FIELDS(Item, sku, name, qty, price)
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Item, sku, name, qty, price)
+
+struct Order {
+    int64_t id{0};
+    std::string user;
+    std::string status;
+    bool paid{false};
+    double total{0.0};
+    int64_t created_at{0};
+    std::vector<std::string> tags;
+    std::vector<Item> items;
+};
+KIT_JSON_FIELDS(Order, id, user, status, paid, total, created_at, tags, items)
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Order, id, user, status, paid, total, created_at, tags, items)
+
+struct Page {
+    int32_t page{0};
+    int32_t size{0};
+    int64_t total{0};
+    std::vector<Order> orders;
+};
+KIT_JSON_FIELDS(Page, page, size, total, orders)
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Page, page, size, total, orders)
+
+}
+
+namespace {
+
+template<class Fn>
+double NsPerOp(int iterations, Fn &&fn)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i)
+    {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+}
+
+shop::Order MakeOrder(int64_t id)
+{
+    shop::Order order;
+    order.id = 1000000 + id;
+    order.user = "user_" + std::to_string(id % 97) + "@example.com";
+    order.status = id % 3 ? "shipped" : "pending \"review\"";
+    order.paid = id % 2;
+    order.created_at = 1760000000000LL + id * 1379;
+    order.tags = {"vip", "express", "\xe5\x8d\x8e\xe5\x8d\x97"};
+    for(int i = 0; i < 3; ++i)
+    {
+        shop::Item item;
+        item.sku = "SKU-" + std::to_string(id * 10 + i);
+        item.name = "Widget model " + std::to_string(i) + " / blue";
+        item.qty = i + 1;
+        item.price = 19.99 + i * 5.5;
+        order.total += item.price * item.qty;
+        order.items.push_back(std::move(item));
+    }
+    return order;
+}
+
+struct Result {
+    double nlohmann_ns{0};
+    double stream_ns{0};
+};
+
+/// @brief 模拟请求 Body，分别用两条路径绑定到 T
+template<typename T>
+Result BenchBind(const std::string &json, int iterations, size_t *sink)
+{
+    Body body(ContentType(ContentType::kJsonType));
+    body.appendData(json);
+
+    Result res;
+    res.nlohmann_ns = NsPerOp(iterations, [&]() {
+        T obj = nljson::parse(body.data()).get<T>();
+        *sink += sizeof(obj);
+    });
+    res.stream_ns = NsPerOp(iterations, [&]() {
+        T obj;
+        if(JsonDecode(body.view(), &obj))
+        {
+            *sink += sizeof(obj);
+        }
+    });
+    return res;
+}
+
+/// @brief 把对象序列化进响应 Body
+template<typename T>
+Result BenchReply(const T &obj, int iterations, size_t *sink)
+{
+    Result res;
+    res.nlohmann_ns = NsPerOp(iterations, [&]() {
+        HttpResponse resp;
+        resp.body().setContentType(ContentType::kJsonType);
+        nljson root = obj;
+        resp.body().appendData(root.dump());
+        *sink += resp.body().size();
+    });
+    res.stream_ns = NsPerOp(iterations, [&]() {
+        HttpResponse resp;
+        resp.setJsonBody(obj);
+        *sink += resp.body().size();
+    });
+    return res;
+}
+
+void PrintRow(const char *name, const char *op, size_t bytes, const Result &res)
+{
+    std::printf("%-6s %-6s %7zu %12.0f %10.1f %12.0f %10.1f %8.2fx\n", name, op, bytes,
+                res.nlohmann_ns, bytes / res.nlohmann_ns * 1e3,
+                res.stream_ns, bytes / res.stream_ns * 1e3,
+                res.nlohmann_ns / res.stream_ns);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+
+    const shop::Order order = MakeOrder(7);
+    shop::Page page;
+    page.page = 3;
+    page.size = 50;
+    page.total = 12345;
+    for(int i = 0; i < 50; ++i)
+    {
+        page.orders.push_back(MakeOrder(i));
+    }
+
+    const std::string order_json = JsonEncode(order);
+    const std::string page_json = JsonEncode(page);
+    // 两条路径的结果必须一致，否则比较没有意义
+    if(nljson::parse(order_json) != nljson(order) || nljson::parse(page_json) != nljson(page))
+    {
+        std::fprintf(stderr, "payload mismatch\n");
+        return 1;
+    }
+    shop::Page check;
+    if(!JsonDecode(nljson(page).dump(), &check) || JsonEncode(check) != page_json)
+    {
+        std::fprintf(stderr, "stream round trip mismatch\n");
+        return 1;
+    }
+
+    size_t sink = 0;
+    const int page_iterations = std::max(1, iterations / 50);
+    std::printf("%-6s %-6s %7s %12s %10s %12s %10s %9s\n",
+                "body", "op", "bytes", "nlohmann ns", "MB/s", "stream ns", "MB/s", "speedup");
+    PrintRow("order", "bind", order_json.size(), BenchBind<shop::Order>(order_json, iterations, &sink));
+    PrintRow("order", "reply", order_json.size(), BenchReply(order, iterations, &sink));
+    PrintRow("page", "bind", page_json.size(), BenchBind<shop::Page>(page_json, page_iterations, &sink));
+    PrintRow("page", "reply", page_json.size(), BenchReply(page, page_iterations, &sink));
+    std::printf("(sink=%zu)\n", sink);
+    return 0;
+}
@@ -0,0 +1,824 @@
+/**
+ * @file bench_loadgen.cpp
+ * @brief wrk 风格压测工具: 基于 EventLoopThreadPool 的多连接/流水线/请求混合，闭环与开环(协同遗漏修正)两种模式
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 23:10:26
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_loadgen [选项]
+ *   -t N                客户端 IO 线程数，默认 2
+ *   -c N                连接总数，均分到各线程，默认 64
+ *   -d SEC              每个场景的压测时长(秒，可为小数)，默认 5
+ *   -p N                每条连接的流水线深度，默认 1
+ *   -R N                开环模式的总请求速率(req/s)，不指定时取同一目标闭环 QPS 的一半
+ *   --mode M            closed | open | both，默认 both
+ *   --target T          echo | http | all，默认 all
+ *   --mix SPEC          HTTP 请求混合，可选 get(GET /hello)、post(POST /echo)、large(GET /large 64KB)，
+ *                       如 get=8,post=1,large=1，默认 get=1
+ *   --size N            echo 报文 / POST Body 字节数，默认 64
+ *   --addr IP:PORT      压测外部服务(需指定单个 target)，不启动内置服务
+ *   --server-threads N  内置服务的 IO 线程数，默认 2
+ *   --quick             CI 短模式，相当于 -t 1 -c 8 -d 0.5 --server-threads 1，需放在其他选项之前
+ *   --min-qps N         闭环场景 QPS 低于 N 时判定失败
+ *   --max-p99-us N      任一场景 p99 延迟超过 N 微秒时判定失败
+ *
+ * 闭环: 每条连接始终保持 p 个请求在途，收到响应立即补发，延迟从实际发出算起。
+ * 开环: 每条连接按固定间隔排定每个请求的应发时刻，到点才发；在途已满时排队等待，
+ *       延迟从应发时刻算起(同 wrk2)。服务端卡顿期间本应发出的请求同样计入延迟，
+ *       不会因为客户端跟着变慢而漏记(协同遗漏)。定时器精度为毫秒，开环延迟含不超过 1ms 的发送调度误差。
+ * 只统计压测窗口内收到的响应；延迟记录在 metrics::Histogram 中，分位值为所在桶上界，相对误差不超过 1/16。
+ * 任一场景出现错误、没有完成任何请求或越过 --min-qps/--max-p99-us 门限时返回非 0，
+ * CMake 在 MUDUO_BENCH 下以 --quick 注册为 ctest 用例 bench_loadgen_quick。
+ */
+#include "net/http/http_server.h"
+#include "net/http/http_context.h"
+#include "net/http/http_response.h"
+#include "net/http/http_body_sink.h"
+#include "net/tcp_client.h"
+#include "net/tcp_server.h"
+#include "net/event_loop.h"
+#include "net/inet_address.h"
+#include "net/net_log.h"
+#include "base/event_loop_thread.h"
+#include "base/event_loop_thread_pool.h"
+#include "base/metrics.h"
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+enum class Target
+{
+    kEcho,
+    kHttp,
+};
+
+const char* TargetName(Target target)
+{
+    return Target::kEcho == target ? "echo" : "http";
+}
+
+struct Options {
+    int32_t threads{2};
+    int32_t connections{64};
+    double seconds{5.0};
+    size_t pipeline{1};
+    double rate{0.0};
+    bool closed{true};
+    bool open{true};
+    bool echo{true};
+    bool http{true};
+    std::string mix{"get=1"};
+    size_t size{64};
+    std::string addr;
+    int32_t serverThreads{2};
+    /// @brief 通过门限，0 表示不检查
+    double minQps{0.0};
+    double maxP99Us{0.0};
+};
+
+void Usage(const char *prog)
+{
+    std::fprintf(stderr,
+                 "usage: %s [-t threads] [-c connections] [-d seconds] [-p pipeline] [-R rate]\n"
+                 "          [--mode closed|open|both] [--target echo|http|all] [--mix get=8,post=1,large=1]\n"
+                 "          [--size bytes] [--addr ip:port] [--server-threads n] [--quick]\n"
+                 "          [--min-qps n] [--max-p99-us n]\n", prog);
+}
+
+bool ParseOptions(int argc, char **argv, Options *opt)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if("--quick" == arg)
+        {
+            opt->threads = 1;
+            opt->connections = 8;
+            opt->seconds = 0.5;
+            opt->serverThreads = 1;
+            continue;
+        }
+        if(i + 1 >= argc)
+        {
+            return false;
+        }
+        const char *value = argv[++i];
+        if("-t" == arg) opt->threads = std::atoi(value);
+        else if("-c" == arg) opt->connections = std::atoi(value);
+        else if("-d" == arg) opt->seconds = std::atof(value);
+        else if("-p" == arg) opt->pipeline = std::strtoul(value, nullptr, 10);
+        else if("-R" == arg) opt->rate = std::atof(value);
+        else if("--mix" == arg) opt->mix = value;
+        else if("--size" == arg) opt->size = std::strtoul(value, nullptr, 10);
+        else if("--addr" == arg) opt->addr = value;
+        else if("--server-threads" == arg) opt->serverThreads = std::atoi(value);
+        else if("--min-qps" == arg) opt->minQps = std::atof(value);
+        else if("--max-p99-us" == arg) opt->maxP99Us = std::atof(value);
+        else if("--mode" == arg)
+        {
+            const std::string mode = value;
+            opt->closed = "closed" == mode || "both" == mode;
+            opt->open = "open" == mode || "both" == mode;
+            if(!opt->closed && !opt->open)
+            {
+                return false;
+            }
+        }
+        else if("--target" == arg)
+        {
+            const std::string target = value;
+            opt->echo = "echo" == target || "all" == target;
+            opt->http = "http" == target || "all" == target;
+            if(!opt->echo && !opt->http)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return opt->threads > 0 && opt->connections > 0 && opt->seconds > 0 && opt->pipeline > 0 && opt->size > 0
+           && (opt->addr.empty() || opt->echo != opt->http);
+}
+
+std::string BuildHttpRequest(const std::string &kind, const std::string &host, size_t size)
+{
+    std::string req;
+    if("get" == kind)
+    {
+        req = "GET /hello HTTP/1.1\r\n";
+    }
+    else if("large" == kind)
+    {
+        req = "GET /large HTTP/1.1\r\n";
+    }
+    else if("post" == kind)
+    {
+        req = "POST /echo HTTP/1.1\r\n";
+    }
+    else
+    {
+        return req;
+    }
+    req.append("Host: ").append(host).append("\r\nUser-Agent: kit_muduo-loadgen\r\n");
+    if("post" == kind)
+    {
+        req.append("Content-Type: application/octet-stream\r\nContent-Length: ").append(std::to_string(size)).append("\r\n\r\n");
+        req.append(size, 'x');
+    }
+    else
+    {
+        req.append("\r\n");
+    }
+    return req;
+}
+
+/**
+ * @brief 按权重展开一个周期的请求序列(平滑加权轮询)，权重大的请求均匀分散在周期内
+ */
+std::vector<uint32_t> WeightedSequence(const std::vector<uint32_t> &weights)
+{
+    int64_t total = 0;
+    for(uint32_t w : weights)
+    {
+        total += w;
+    }
+    std::vector<uint32_t> sequence;
+    std::vector<int64_t> current(weights.size(), 0);
+    for(int64_t n = 0; n < total; ++n)
+    {
+        size_t best = 0;
+        for(size_t i = 0; i < weights.size(); ++i)
+        {
+            current[i] += weights[i];
+            if(current[i] > current[best])
+            {
+                best = i;
+            }
+        }
+        current[best] -= total;
+        sequence.push_back(static_cast<uint32_t>(best));
+    }
+    return sequence;
+}
+
+/**
+ * @brief 一个场景的只读参数，各客户端线程共享
+ */
+struct Plan {
+    Target target{Target::kEcho};
+    InetAddress server;
+    bool open{false};
+    /// @brief 开环总速率(req/s)
+    double rate{0.0};
+    int32_t connections{0};
+    size_t pipeline{1};
+    size_t echoSize{0};
+    /// @brief 预先编码好的请求报文，echo 只有一条
+    std::vector<std::string> wires;
+    std::vector<uint32_t> sequence;
+    metrics::Histogram *latency{nullptr};
+};
+
+struct Counters {
+    uint64_t completed{0};
+    uint64_t errors{0};
+    uint64_t bytesIn{0};
+    uint64_t bytesOut{0};
+
+    void merge(const Counters &other)
+    {
+        completed += other.completed;
+        errors += other.errors;
+        bytesIn += other.bytesIn;
+        bytesOut += other.bytesOut;
+    }
+};
+
+/// @brief 响应 Body 只计数不保存，避免大响应的拷贝影响客户端自身的开销
+class DiscardSink: public HttpBodySink
+{
+public:
+    bool onData(const char *data, size_t len) override
+    {
+        _receivedBytes += len;
+        return true;
+    }
+};
+
+/**
+ * @brief 单个客户端 IO 线程上的一组连接，只在该线程中访问
+ */
+class Worker: public std::enable_shared_from_this<Worker>
+{
+public:
+    Worker(EventLoop *loop, const Plan &plan, int32_t firstIndex, int32_t count, std::atomic<int32_t> *ready)
+        :_loop(loop)
+        ,_plan(plan)
+        ,_firstIndex(firstIndex)
+        ,_conns(count)
+        ,_ready(ready)
+    {}
+
+    void connect()
+    {
+        std::weak_ptr<Worker> weak = weak_from_this();
+        for(size_t i = 0; i < _conns.size(); ++i)
+        {
+            Conn &c = _conns[i];
+            const int32_t index = _firstIndex + static_cast<int32_t>(i);
+            c.cursor = _plan.sequence.empty() ? 0 : index % _plan.sequence.size();
+            c.client = std::make_unique<TcpClient>(_loop, _plan.server, "loadgen#" + std::to_string(index));
+            c.client->setConnectionCallback([weak, i](const TcpConnectionPtr &conn) {
+                if(std::shared_ptr<Worker> self = weak.lock())
+                {
+                    self->onConnection(i, conn);
+                }
+            });
+            c.client->setMessageCallback([weak, i](const TcpConnectionPtr &conn, Buffer *buf, TimeStamp receiveTime) {
+                std::shared_ptr<Worker> self = weak.lock();
+                if(!self)
+                {
+                    buf->resetAll();
+                    return;
+                }
+                self->onMessage(i, buf, receiveTime);
+            });
+            // 压测中被断开的连接自动重连，丢失的在途请求计为错误
+            c.client->enableRetry();
+            c.client->connect();
+        }
+    }
+
+    void begin(int64_t startNs, int64_t endNs)
+    {
+        _startNs = startNs;
+        _endNs = endNs;
+        _running = true;
+        if(_plan.open)
+        {
+            // 每条连接的请求间隔，连接之间错开起点，避免所有连接在同一时刻集中发送
+            _intervalNs = static_cast<int64_t>(1e9 * _plan.connections / _plan.rate);
+            for(size_t i = 0; i < _conns.size(); ++i)
+            {
+                _conns[i].nextDue = startNs + _intervalNs * (_firstIndex + static_cast<int64_t>(i)) / _plan.connections;
+            }
+            std::weak_ptr<Worker> weak = weak_from_this();
+            _timer = _loop->runEvery(1, [weak]() {
+                if(std::shared_ptr<Worker> self = weak.lock())
+                {
+                    self->onTick();
+                }
+            });
+        }
+        const int64_t now = metrics::NowNs();
+        for(Conn &c : _conns)
+        {
+            pump(c, now);
+        }
+    }
+
+    /// @brief 停止发送并在本线程中关闭全部连接
+    Counters stop()
+    {
+        _running = false;
+        if(_timer)
+        {
+            _loop->cancel(_timer);
+            _timer.reset();
+        }
+        for(Conn &c : _conns)
+        {
+            c.client.reset();
+            c.tcp.reset();
+        }
+        return _counters;
+    }
+
+private:
+    struct Conn {
+        std::unique_ptr<TcpClient> client;
+        TcpConnectionPtr tcp;
+        bool everConnected{false};
+        /// @brief 在途请求的计时起点(ns)，闭环为实际发出时刻，开环为应发时刻
+        std::deque<int64_t> inflight;
+        HttpContextPtr ctx;
+        std::shared_ptr<DiscardSink> sink;
+        size_t echoBytes{0};
+        size_t cursor{0};
+        /// @brief 开环: 下一个请求的应发时刻
+        int64_t nextDue{0};
+    };
+
+    void onConnection(size_t idx, const TcpConnectionPtr &conn)
+    {
+        Conn &c = _conns[idx];
+        if(conn->connected())
+        {
+            c.tcp = conn;
+            c.echoBytes = 0;
+            resetContext(c);
+            if(!c.everConnected)
+            {
+                c.everConnected = true;
+                _ready->fetch_add(1);
+            }
+            pump(c, metrics::NowNs());
+            return;
+        }
+        if(_running)
+        {
+            _counters.errors += c.inflight.size();
+        }
+        c.inflight.clear();
+        c.tcp.reset();
+    }
+
+    void onMessage(size_t idx, Buffer *buf, TimeStamp receiveTime)
+    {
+        Conn &c = _conns[idx];
+        const int64_t now = metrics::NowNs();
+        if(_running && now <= _endNs)
+        {
+            _counters.bytesIn += buf->readableBytes();
+        }
+
+        if(Target::kEcho == _plan.target)
+        {
+            c.echoBytes += buf->readableBytes();
+            buf->resetAll();
+            while(c.echoBytes >= _plan.echoSize && !c.inflight.empty())
+            {
+                c.echoBytes -= _plan.echoSize;
+                complete(c, true, now);
+            }
+        }
+        else
+        {
+            while(buf->readableBytes() > 0)
+            {
+                if(c.inflight.empty() || !c.ctx->parseResponse(*buf, receiveTime))
+                {
+                    // 多出的数据或解析失败，连接已不可用
+                    buf->resetAll();
+                    fail(c);
+                    return;
+                }
+                if(!c.ctx->gotAll())
+                {
+                    break;
+                }
+                const int32_t code = c.ctx->response()->stateCode()();
+                resetContext(c);
+                complete(c, code >= 200 && code < 400, now);
+            }
+        }
+        pump(c, now);
+    }
+
+    void onTick()
+    {
+        const int64_t now = metrics::NowNs();
+        for(Conn &c : _conns)
+        {
+            pump(c, now);
+        }
+    }
+
+    void resetContext(Conn &c)
+    {
+        if(Target::kHttp != _plan.target)
+        {
+            return;
+        }
+        if(!c.sink)
+        {
+            c.sink = std::make_shared<DiscardSink>();
+        }
+        c.ctx = std::make_shared<HttpContext>();
+        c.ctx->setResponseBodySink(c.sink);
+    }
+
+    void complete(Conn &c, bool ok, int64_t now)
+    {
+        const int64_t stamp = c.inflight.front();
+        c.inflight.pop_front();
+        if(!_running || now > _endNs)
+        {
+            return;
+        }
+        if(!ok)
+        {
+            ++_counters.errors;
+            return;
+        }
+        ++_counters.completed;
+        _plan.latency->record(now - stamp);
+    }
+
+    void fail(Conn &c)
+    {
+        if(_running)
+        {
+            _counters.errors += c.inflight.size();
+        }
+        c.inflight.clear();
+        if(c.tcp)
+        {
+            c.tcp->forceClose();
+        }
+    }
+
+    /// @brief 补发请求: 闭环填满流水线；开环只发已到应发时刻的请求
+    void pump(Conn &c, int64_t now)
+    {
+        if(!_running || !c.tcp || !c.tcp->connected() || now >= _endNs)
+        {
+            return;
+        }
+        while(c.inflight.size() < _plan.pipeline)
+        {
+            int64_t stamp = now;
+            if(_plan.open)
+            {
+                if(c.nextDue > now)
+                {
+                    break;
+                }
+                stamp = c.nextDue;
+                c.nextDue += _intervalNs;
+            }
+            const std::string &wire = _plan.wires[_plan.sequence[c.cursor]];
+            c.cursor = (c.cursor + 1) % _plan.sequence.size();
+            c.inflight.push_back(stamp);
+            _counters.bytesOut += wire.size();
+            c.tcp->send(wire.data(), wire.size());
+        }
+    }
+
+private:
+    EventLoop *_loop;
+    const Plan &_plan;
+    const int32_t _firstIndex;
+    std::vector<Conn> _conns;
+    std::atomic<int32_t> *_ready;
+    bool _running{false};
+    int64_t _startNs{0};
+    int64_t _endNs{0};
+    int64_t _intervalNs{0};
+    TimerPtr _timer;
+    Counters _counters;
+};
+
+struct ScenarioResult {
+    bool ok{false};
+    int32_t connected{0};
+    double seconds{0.0};
+    Counters counters;
+    metrics::Histogram::Snapshot latency;
+
+    double qps() const { return seconds > 0 ? counters.completed / seconds : 0.0; }
+};
+
+ScenarioResult RunScenario(EventLoopThreadPool &pool, const Options &opt, const Plan &plan)
+{
+    ScenarioResult result;
+    std::vector<EventLoop*> loops = pool.getAllLoops();
+    std::vector<std::shared_ptr<Worker>> workers;
+    std::atomic<int32_t> ready{0};
+
+    int32_t first = 0;
+    for(size_t i = 0; i < loops.size(); ++i)
+    {
+        const int32_t count = opt.connections / static_cast<int32_t>(loops.size())
+                              + (static_cast<int32_t>(i) < opt.connections % static_cast<int32_t>(loops.size()) ? 1 : 0);
+        auto worker = std::make_shared<Worker>(loops[i], plan, first, count, &ready);
+        first += count;
+        workers.push_back(worker);
+        loops[i]->runInLoop([worker]() { worker->connect(); });
+    }
+    for(int i = 0; i < 300 && ready.load() < opt.connections; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    result.connected = ready.load();
+
+    if(result.connected > 0)
+    {
+        const int64_t start = metrics::NowNs();
+        const int64_t end = start + static_cast<int64_t>(opt.seconds * 1e9);
+        for(size_t i = 0; i < loops.size(); ++i)
+        {
+            loops[i]->runInLoop([worker = workers[i], start, end]() { worker->begin(start, end); });
+        }
+        std::this_thread::sleep_for(std::chrono::nanoseconds(end - metrics::NowNs()));
+        result.seconds = opt.seconds;
+        // 窗口结束后不再发新请求，等在途响应收完再断开，避免服务端写到已关闭的连接
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    for(size_t i = 0; i < loops.size(); ++i)
+    {
+        std::promise<Counters> stopped;
+        loops[i]->runInLoop([&stopped, &worker = workers[i]]() {
+            const Counters counters = worker->stop();
+            // 连接的回调只弱引用 Worker，在循环线程中释放
+            worker.reset();
+            stopped.set_value(counters);
+        });
+        result.counters.merge(stopped.get_future().get());
+    }
+    result.latency = plan.latency->snapshot();
+    result.ok = result.connected > 0 && result.counters.completed > 0 && 0 == result.counters.errors;
+    return result;
+}
+
+double Us(int64_t ns)
+{
+    return ns / 1000.0;
+}
+
+void PrintResult(Target target, const Plan &plan, const ScenarioResult &r)
+{
+    char rate[32] = "-";
+    if(plan.open)
+    {
+        std::snprintf(rate, sizeof(rate), "%.0f", plan.rate);
+    }
+    std::printf("%-5s %-6s %6d %5zu %9s %10lu %7lu %10.0f %8.2f %8.1f %8.1f %8.1f %8.1f %9.1f\n",
+                TargetName(target), plan.open ? "open" : "closed", r.connected, plan.pipeline, rate,
+                static_cast<unsigned long>(r.counters.completed), static_cast<unsigned long>(r.counters.errors),
+                r.qps(), r.seconds > 0 ? r.counters.bytesIn / r.seconds / (1024.0 * 1024.0) : 0.0,
+                Us(static_cast<int64_t>(r.latency.mean())), Us(r.latency.percentile(0.50)),
+                Us(r.latency.percentile(0.99)), Us(r.latency.percentile(0.999)), Us(r.latency.max));
+    std::fflush(stdout);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+    // 压测结束时对端可能仍在写，忽略 SIGPIPE 交给连接关闭流程处理
+    ::signal(SIGPIPE, SIG_IGN);
+
+    Options opt;
+    if(!ParseOptions(argc, argv, &opt))
+    {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    // 请求混合
+    std::vector<std::string> kinds;
+    std::vector<uint32_t> weights;
+    size_t pos = 0;
+    while(pos < opt.mix.size())
+    {
+        size_t comma = opt.mix.find(',', pos);
+        if(std::string::npos == comma)
+        {
+            comma = opt.mix.size();
+        }
+        const std::string item = opt.mix.substr(pos, comma - pos);
+        const size_t eq = item.find('=');
+        const std::string kind = item.substr(0, eq);
+        const int weight = std::string::npos == eq ? 1 : std::atoi(item.c_str() + eq + 1);
+        if(BuildHttpRequest(kind, "", 0).empty() || weight <= 0)
+        {
+            std::fprintf(stderr, "bad mix item: %s\n", item.c_str());
+            return 2;
+        }
+        kinds.push_back(kind);
+        weights.push_back(static_cast<uint32_t>(weight));
+        pos = comma + 1;
+    }
+
+    // 内置目标: echo TcpServer 与 HttpServer 共用一个主循环线程，各自有 IO 线程池
+    const uint16_t echo_port = static_cast<uint16_t>(26000 + ::getpid() % 2000 * 2);
+    const uint16_t http_port = echo_port + 1;
+    EventLoopThread server_thread(nullptr, "loadgen_server");
+    EventLoop *server_loop = nullptr;
+    std::shared_ptr<TcpServer> echo_server;
+    std::shared_ptr<HttpServer> http_server;
+    if(opt.addr.empty())
+    {
+        server_loop = server_thread.startLoop();
+        std::promise<void> started;
+        server_loop->runInLoop([&]() {
+            echo_server = std::make_shared<TcpServer>(server_loop, InetAddress(echo_port, "127.0.0.1"), "loadgen-echo", TcpServer::KReusePort);
+            echo_server->setThreadNum(opt.serverThreads);
+            echo_server->setConnectionCallback([](const TcpConnectionPtr &conn) {});
+            echo_server->setMessageCallback([](const TcpConnectionPtr &conn, Buffer *buf, TimeStamp) {
+                conn->send(buf->peek(), buf->readableBytes());
+                buf->resetAll();
+            });
+            echo_server->start();
+
+            http_server = std::make_shared<HttpServer>(server_loop, InetAddress(http_port, "127.0.0.1"), "loadgen-http", false, TcpServer::KReusePort);
+            http_server->setThreadNum(opt.serverThreads);
+            http_server->Get("/hello", [](TcpConnectionPtr conn, HttpContextPtr ctx) {
+                auto resp = ctx->response();
+                resp->setVersion(Version::kHttp11);
+                resp->setStateCode(StateCode::k200Ok);
+                resp->body().appendData("hello world");
+            });
+            http_server->Post("/echo", [](TcpConnectionPtr conn, HttpContextPtr ctx) {
+                const std::string_view body = ctx->request()->body().view();
+                auto resp = ctx->response();
+                resp->setVersion(Version::kHttp11);
+                resp->setStateCode(StateCode::k200Ok);
+                resp->body().appendData(body.data(), body.size());
+            });
+            static const std::string s_large(64 * 1024, 'L');
+            http_server->Get("/large", [](TcpConnectionPtr conn, HttpContextPtr ctx) {
+                auto resp = ctx->response();
+                resp->setVersion(Version::kHttp11);
+                resp->setStateCode(StateCode::k200Ok);
+                resp->body().appendData(s_large);
+            });
+            http_server->start();
+            started.set_value();
+        });
+        started.get_future().wait();
+    }
+
+    // 客户端: 主线程持有基础循环(不运行)，请求都在线程池的 IO 线程中收发
+    EventLoop base_loop;
+    EventLoopThreadPool pool(&base_loop, "loadgen");
+    pool.setThreadNum(opt.threads);
+    pool.start();
+
+    std::printf("threads %d, connections %d, duration %.2fs, pipeline %zu, size %zu, http mix %s\n",
+                opt.threads, opt.connections, opt.seconds, opt.pipeline, opt.size, opt.mix.c_str());
+    std::printf("%-5s %-6s %6s %5s %9s %10s %7s %10s %8s %8s %8s %8s %8s %9s\n",
+                "target", "mode", "conns", "pipe", "rate", "requests", "errors", "req/s", "MB/s",
+                "mean(us)", "p50", "p99", "p999", "max");
+
+    bool all_ok = true;
+    std::vector<Target> targets;
+    if(opt.echo)
+    {
+        targets.push_back(Target::kEcho);
+    }
+    if(opt.http)
+    {
+        targets.push_back(Target::kHttp);
+    }
+    for(Target target : targets)
+    {
+        Plan plan;
+        plan.target = target;
+        if(!opt.addr.empty())
+        {
+            const size_t colon = opt.addr.rfind(':');
+            plan.server = InetAddress(static_cast<uint16_t>(std::atoi(opt.addr.c_str() + colon + 1)), opt.addr.substr(0, colon));
+        }
+        else
+        {
+            plan.server = InetAddress(Target::kEcho == target ? echo_port : http_port, "127.0.0.1");
+        }
+        plan.connections = opt.connections;
+        plan.pipeline = opt.pipeline;
+        plan.echoSize = opt.size;
+        if(Target::kEcho == target)
+        {
+            plan.wires.push_back(std::string(opt.size, 'e'));
+            plan.sequence.push_back(0);
+        }
+        else
+        {
+            for(const std::string &kind : kinds)
+            {
+                plan.wires.push_back(BuildHttpRequest(kind, plan.server.toIpPort(), opt.size));
+            }
+            plan.sequence = WeightedSequence(weights);
+        }
+
+        double closed_qps = 0.0;
+        for(int32_t mode = 0; mode < 2; ++mode)
+        {
+            plan.open = 1 == mode;
+            if((!plan.open && !opt.closed) || (plan.open && !opt.open))
+            {
+                continue;
+            }
+            if(plan.open)
+            {
+                plan.rate = opt.rate > 0 ? opt.rate : closed_qps / 2;
+                if(plan.rate <= 0)
+                {
+                    std::fprintf(stderr, "%s open: no rate, pass -R\n", TargetName(target));
+                    all_ok = false;
+                    continue;
+                }
+            }
+            const std::string metric = std::string("kit_loadgen_") + TargetName(target) + (plan.open ? "_open" : "_closed") + "_latency_ns";
+            plan.latency = &metrics::MetricsRegistry::Instance().histogram(metric, "Load generator request latency (ns)");
+
+            const ScenarioResult result = RunScenario(pool, opt, plan);
+            PrintResult(target, plan, result);
+            if(!plan.open)
+            {
+                closed_qps = result.qps();
+            }
+            if(!result.ok)
+            {
+                std::fprintf(stderr, "%s %s failed: connected %d/%d, completed %lu, errors %lu\n",
+                             TargetName(target), plan.open ? "open" : "closed", result.connected, opt.connections,
+                             static_cast<unsigned long>(result.counters.completed),
+                             static_cast<unsigned long>(result.counters.errors));
+                all_ok = false;
+            }
+            if(!plan.open && opt.minQps > 0 && result.qps() < opt.minQps)
+            {
+                std::fprintf(stderr, "%s closed failed: %.0f req/s below --min-qps %.0f\n",
+                             TargetName(target), result.qps(), opt.minQps);
+                all_ok = false;
+            }
+            const double p99_us = Us(result.latency.percentile(0.99));
+            if(opt.maxP99Us > 0 && p99_us > opt.maxP99Us)
+            {
+                std::fprintf(stderr, "%s %s failed: p99 %.1fus above --max-p99-us %.0f\n",
+                             TargetName(target), plan.open ? "open" : "closed", p99_us, opt.maxP99Us);
+                all_ok = false;
+            }
+        }
+    }
+
+    if(server_loop)
+    {
+        // 服务端析构前等客户端断开在 IO 线程中处理完
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::promise<void> stopped;
+        server_loop->runInLoop([&]() {
+            echo_server.reset();
+            http_server.reset();
+            stopped.set_value();
+        });
+        stopped.get_future().wait();
+    }
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+/**
+ * @file bench_middleware_chain.cpp
+ * @brief 中间件链分发开销压测
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 21:48:12
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_middleware_chain [请求数]
+ * 分别挂载 0/5/20 个空中间件，对比两种实现的单次分发耗时与堆分配次数:
+ *   - compiled: HttpServletDispatch::use，路由变化时编译为扁平数组，分发时按下标遍历
+ *   - naive:    每个请求按前缀筛选 std::function 组成临时链，模拟常见的动态拼装写法
+ */
+#include "net/event_loop.h"
+#include "net/http/http_context.h"
+#include "net/http/http_request.h"
+#include "net/http/http_response.h"
+#include "net/http/http_servlet.h"
+#include "net/inet_address.h"
+#include "net/tcp_connection.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+std::atomic<uint64_t> g_allocs{0};
+
+}
+
+// 统计堆分配次数
+void* operator new(size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if(void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+class NoopServlet : public HttpServlet
+{
+public:
+    NoopServlet() :HttpServlet("NoopServlet") {}
+
+    void handle(TcpConnectionPtr conn, HttpContextPtr ctx) override
+    {
+        ctx->response()->setStateCode(StateCode::k200Ok);
+    }
+};
+
+class NoopMiddleware : public HttpMiddleware
+{
+public:
+    explicit NoopMiddleware(const std::string &name) :HttpMiddleware(name) {}
+
+    Action before(const TcpConnectionPtr &conn, const HttpContextPtr &ctx) override
+    {
+        ++hits;
+        return Action::kContinue;
+    }
+
+    void after(const TcpConnectionPtr &conn, const HttpContextPtr &ctx) override { ++hits; }
+
+    uint64_t hits{0};
+};
+
+struct NaiveEntry
+{
+    std::string prefix;
+    std::function<bool(const TcpConnectionPtr&, const HttpContextPtr&)> before;
+    std::function<void(const TcpConnectionPtr&, const HttpContextPtr&)> after;
+};
+
+struct Result
+{
+    double ns_per_req{0};
+    double allocs_per_req{0};
+};
+
+template<typename Fn>
+Result Measure(int iters, Fn &&fn)
+{
+    // 预热，让线程本地快照等一次性分配不计入
+    for(int i = 0; i < 1000; ++i)
+    {
+        fn();
+    }
+    const uint64_t allocs = g_allocs.load();
+    auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < iters; ++i)
+    {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    Result result;
+    result.ns_per_req = std::chrono::duration<double, std::nano>(end - begin).count() / iters;
+    result.allocs_per_req = static_cast<double>(g_allocs.load() - allocs) / iters;
+    return result;
+}
+
+Result RunCompiled(const TcpConnectionPtr &conn, const HttpContextPtr &ctx, int middlewares, int iters)
+{
+    HttpServletDispatch dispatch;
+    dispatch.addRoute(ExpectHttpMethods::Get, "/api/v1/item", std::make_shared<NoopServlet>());
+    for(int i = 0; i < middlewares; ++i)
+    {
+        // 一半全局、一半限定 /api/ 前缀，两者都会编入该路由的链
+        dispatch.use(i % 2 ? "/api/" : "", std::make_shared<NoopMiddleware>("mw" + std::to_string(i)));
+    }
+    return Measure(iters, [&]() { dispatch.handle(conn, ctx); });
+}
+
+Result RunNaive(const TcpConnectionPtr &conn, const HttpContextPtr &ctx, int middlewares, int iters)
+{
+    HttpServletDispatch dispatch;
+    dispatch.addRoute(ExpectHttpMethods::Get, "/api/v1/item", std::make_shared<NoopServlet>());
+    std::vector<NaiveEntry> entries;
+    uint64_t hits = 0;
+    for(int i = 0; i < middlewares; ++i)
+    {
+        entries.push_back(NaiveEntry{i % 2 ? "/api/" : "",
+            [&hits](const TcpConnectionPtr&, const HttpContextPtr&) { ++hits; return true; },
+            [&hits](const TcpConnectionPtr&, const HttpContextPtr&) { ++hits; }});
+    }
+
+    return Measure(iters, [&]() {
+        const std::string path = ctx->request()->path();
+        std::vector<std::function<bool(const TcpConnectionPtr&, const HttpContextPtr&)>> befores;
+        std::vector<std::function<void(const TcpConnectionPtr&, const HttpContextPtr&)>> afters;
+        for(const auto &entry : entries)
+        {
+            if(entry.prefix.empty() || 0 == path.compare(0, entry.prefix.size(), entry.prefix))
+            {
+                befores.push_back(entry.before);
+                afters.push_back(entry.after);
+            }
+        }
+        size_t entered = 0;
+        while(entered < befores.size() && befores[entered](conn, ctx))
+        {
+            ++entered;
+        }
+        dispatch.handle(conn, ctx);
+        while(entered > 0)
+        {
+            afters[--entered](conn, ctx);
+        }
+    });
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+
+    int iters = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    EventLoop loop;
+    auto conn = std::make_shared<TcpConnection>(&loop, "bench", 0, InetAddress(), InetAddress());
+    auto ctx = std::make_shared<HttpContext>();
+    ctx->request()->setPath("/api/v1/item");
+    ctx->request()->setMethod(HttpRequest::Method::kGet);
+
+    std::printf("middleware chain bench: %d req\n", iters);
+    std::printf("%-12s %14s %14s %14s %14s\n", "middlewares", "compiled(ns)", "allocs/req", "naive(ns)", "allocs/req");
+    for(int middlewares : {0, 5, 20})
+    {
+        Result compiled = RunCompiled(conn, ctx, middlewares, iters);
+        Result naive = RunNaive(conn, ctx, middlewares, iters);
+        std::printf("%-12d %14.1f %14.2f %14.1f %14.2f\n", middlewares,
+                    compiled.ns_per_req, compiled.allocs_per_req, naive.ns_per_req, naive.allocs_per_req);
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+/**
+ * @file bench_multipart.cpp
+ * @brief 上传表单解析: MultiFormConvert / MultiFormParser 与增量 MultipartForm 的耗时与分配量对比
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 15:36:08
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_multipart [迭代次数，默认20] [分块大小，默认65536]
+ *   - convert: MultiFormConvert::parse(std::string)
+ *   - parser:  MultiFormParser::parse(const char*, size_t)
+ *   - views:   MultipartForm::parse，part 内容为输入的视图
+ *   - stream:  MultipartForm 分块 feed，part 内容复制到内存(spillBytes = 0)
+ *   - spill:   MultipartForm 分块 feed，超过 1MB 的 part 落盘到 /tmp
+ * 统计每次解析的 operator new 次数与字节数。
+ */
+#include "base/multipart.h"
+#include "base/content_parser.h"
+#include "net/net_log.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace kit_muduo;
+
+namespace {
+
+std::atomic<uint64_t> g_allocs{0};
+std::atomic<uint64_t> g_allocBytes{0};
+
+const char kContentType[] = "multipart/form-data; boundary=----KitBench9f8e7d6c";
+const char kBoundary[] = "------KitBench9f8e7d6c";
+
+/// @brief 伪随机二进制内容，与真实上传文件一样没有明显的重复模式
+std::string RandomBytes(size_t len, uint32_t seed)
+{
+    std::string data(len, '\0');
+    for(size_t i = 0; i < len; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = static_cast<char>(seed >> 24);
+    }
+    return data;
+}
+
+std::string MakeForm(int fields, int files, size_t fileSize)
+{
+    std::string body;
+    for(int i = 0; i < fields; ++i)
+    {
+        body += kBoundary;
+        body += "\r\nContent-Disposition: form-data; name=\"field" + std::to_string(i) + "\"\r\n\r\n";
+        body += "value of field " + std::to_string(i) + "\r\n";
+    }
+    for(int i = 0; i < files; ++i)
+    {
+        body += kBoundary;
+        body += "\r\nContent-Disposition: form-data; name=\"file" + std::to_string(i) + "\"; filename=\"f" + std::to_string(i) + ".bin\"\r\n";
+        body += "Content-Type: application/octet-stream\r\n\r\n";
+        body += RandomBytes(fileSize, static_cast<uint32_t>(i + 1));
+        body += "\r\n";
+    }
+    body += kBoundary;
+    body += "--\r\n";
+    return body;
+}
+
+struct Result {
+    double ms{0};
+    double allocs{0};
+    double allocBytes{0};
+    size_t parts{0};
+};
+
+template<typename Fn>
+Result Measure(int iterations, Fn &&fn)
+{
+    Result res;
+    const uint64_t allocs = g_allocs.load();
+    const uint64_t bytes = g_allocBytes.load();
+    const auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i)
+    {
+        res.parts = fn();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    res.ms = std::chrono::duration<double, std::milli>(end - begin).count() / iterations;
+    res.allocs = static_cast<double>(g_allocs.load() - allocs) / iterations;
+    res.allocBytes = static_cast<double>(g_allocBytes.load() - bytes) / iterations;
+    return res;
+}
+
+size_t Stream(const std::string &body, size_t chunk, size_t spillBytes)
+{
+    MultipartForm::Config config;
+    config.spillBytes = spillBytes;
+    MultipartForm form(config);
+    if(!form.begin(kContentType))
+    {
+        return 0;
+    }
+    for(size_t off = 0; off < body.size(); off += chunk)
+    {
+        if(!form.feed(body.data() + off, std::min(chunk, body.size() - off)))
+        {
+            return 0;
+        }
+    }
+    return form.finish() ? form.parts().size() : 0;
+}
+
+void PrintRow(const char *payload, const char *mode, size_t bytes, const Result &res)
+{
+    std::printf("%-14s %-8s %6zu %9.3f %9.1f %9.1f %10.2f\n", payload, mode, res.parts, res.ms,
+                bytes / (res.ms / 1000.0) / (1024.0 * 1024.0), res.allocs, res.allocBytes / (1024.0 * 1024.0));
+}
+
+void RunPayload(const char *name, const std::string &body, int iterations, size_t chunk)
+{
+    PrintRow(name, "convert", body.size(), Measure(iterations, [&]() {
+        return MultiFormConvert::parse(body, kContentType).size();
+    }));
+    PrintRow(name, "parser", body.size(), Measure(iterations, [&]() {
+        return MultiFormParser::parse(body.data(), body.size(), kContentType).size();
+    }));
+    PrintRow(name, "views", body.size(), Measure(iterations, [&]() {
+        MultipartForm form;
+        return form.parse(body.data(), body.size(), kContentType) ? form.parts().size() : 0;
+    }));
+    PrintRow(name, "stream", body.size(), Measure(iterations, [&]() {
+        return Stream(body, chunk, 0);
+    }));
+    PrintRow(name, "spill", body.size(), Measure(iterations, [&]() {
+        return Stream(body, chunk, 1024 * 1024);
+    }));
+}
+
+}
+
+void* operator new(size_t size)
+{
+    ++g_allocs;
+    g_allocBytes += size;
+    if(void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+    const size_t chunk = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64 * 1024;
+
+    const std::string single = MakeForm(10, 1, 4 * 1024 * 1024);
+    const std::string many = MakeForm(0, 16, 256 * 1024);
+
+    // 各实现的结果必须一致，否则比较没有意义
+    for(const std::string *body : {&single, &many})
+    {
+        MultipartForm form;
+        auto legacy = MultiFormParser::parse(body->data(), body->size(), kContentType);
+        if(!form.parse(body->data(), body->size(), kContentType) || legacy.size() != form.parts().size())
+        {
+            std::fprintf(stderr, "part count mismatch: %s\n", form.error() ? form.error() : "");
+            return 1;
+        }
+        for(const auto &part : form.parts())
+        {
+            const auto &data = legacy[part.name].data;
+            if(part.data() != std::string_view(data.data(), data.size()))
+            {
+                std::fprintf(stderr, "part %s mismatch\n", part.name.c_str());
+                return 1;
+            }
+        }
+    }
+
+    std::printf("%-14s %-8s %6s %9s %9s %9s %10s\n", "payload", "mode", "parts", "ms/op", "MB/s", "allocs", "alloc MB");
+    RunPayload("10f+4MB", single, iterations, chunk);
+    RunPayload("16x256KB", many, iterations, chunk);
+    return 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file bench_route_dispatch.cpp
+ * @brief 路由分发多线程扩展性压测
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 10:12:40
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_route_dispatch [每线程请求数]
+ * 对比两种模式:
+ *   - rcu:   直接调用 HttpServletDispatch::handle（无锁快照）
+ *   - mutex: 外层再加一把全局互斥锁，模拟改造前 match() 持有 route_mtx_ 的行为
+ */
+#include "net/event_loop.h"
+#include "net/http/http_context.h"
+#include "net/http/http_request.h"
+#include "net/http/http_response.h"
+#include "net/http/http_servlet.h"
+#include "net/inet_address.h"
+#include "net/tcp_connection.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+class NoopServlet : public HttpServlet
+{
+public:
+    NoopServlet() :HttpServlet("NoopServlet") {}
+
+    void handle(TcpConnectionPtr conn, HttpContextPtr ctx) override
+    {
+        ctx->response()->setStateCode(StateCode::k200Ok);
+    }
+};
+
+void SetupRoutes(HttpServletDispatch &dispatch)
+{
+    auto svl = std::make_shared<NoopServlet>();
+    for(int i = 0; i < 64; ++i)
+    {
+        dispatch.addRoute(ExpectHttpMethods::Get, "/api/v1/item" + std::to_string(i), svl);
+    }
+    for(int i = 0; i < 16; ++i)
+    {
+        dispatch.addRoute(ExpectHttpMethods::Get, "/api/v2/group" + std::to_string(i) + "/:id", svl);
+    }
+    dispatch.addRoute(ExpectHttpMethods::Get, "/static/*", svl);
+}
+
+double RunOnce(HttpServletDispatch &dispatch, TcpConnectionPtr conn, int threads, int iters, std::mutex *global_mtx)
+{
+    static const char *kPaths[] = {
+        "/api/v1/item3", "/api/v1/item42", "/api/v2/group7/1001", "/static/app.js", "/missing",
+    };
+    constexpr int kPathNum = sizeof(kPaths) / sizeof(kPaths[0]);
+
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]() {
+            std::vector<HttpContextPtr> ctxs;
+            for(int i = 0; i < kPathNum; ++i)
+            {
+                auto ctx = std::make_shared<HttpContext>();
+                ctx->request()->setPath(kPaths[i]);
+                ctx->request()->setMethod(HttpRequest::Method::kGet);
+                ctxs.push_back(ctx);
+            }
+            ready.fetch_add(1);
+            while(!go.load(std::memory_order_acquire)) {}
+
+            for(int i = 0; i < iters; ++i)
+            {
+                const auto &ctx = ctxs[(i + t) % kPathNum];
+                if(global_mtx)
+                {
+                    std::lock_guard<std::mutex> lock(*global_mtx);
+                    dispatch.handle(conn, ctx);
+                }
+                else
+                {
+                    dispatch.handle(conn, ctx);
+                }
+            }
+        });
+    }
+
+    while(ready.load() != threads) {}
+    auto begin = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for(auto &w : workers)
+    {
+        w.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double sec = std::chrono::duration<double>(end - begin).count();
+    return static_cast<double>(threads) * iters / sec;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+
+    int iters = argc > 1 ? std::atoi(argv[1]) : 200000;
+    EventLoop loop;
+    auto conn = std::make_shared<TcpConnection>(&loop, "bench", 0, InetAddress(), InetAddress());
+    HttpServletDispatch dispatch;
+    SetupRoutes(dispatch);
+
+    const unsigned hw = std::thread::hardware_concurrency();
+    std::printf("route dispatch bench: %d req/thread, hw threads %u\n", iters, hw);
+    std::printf("%-8s %12s %12s %10s\n", "threads", "rcu(req/s)", "mutex(req/s)", "speedup");
+
+    std::mutex global_mtx;
+    for(int threads : {1, 2, 4, 8, 16})
+    {
+        double rcu = RunOnce(dispatch, conn, threads, iters, nullptr);
+        double locked = RunOnce(dispatch, conn, threads, iters, &global_mtx);
+        std::printf("%-8d %12.0f %12.0f %9.2fx\n", threads, rcu, locked, rcu / locked);
+    }
+
+    return 0;
+}
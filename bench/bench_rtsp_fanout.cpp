@@ -0,0 +1,263 @@
+/**
+ * @file bench_rtsp_fanout.cpp
+ * @brief RTSP 扇出: 每帧打包一次、包缓冲共享给 N 个观众 与 每个观众各自拷贝一份 的耗时与分配次数对比
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 06:58:12
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_rtsp_fanout [观众数，默认1000] [帧数，默认300] [帧大小，默认30000]
+ *   - shared: RtspMediaSource::pushFrame，TCP interleaved 观众通道号与默认一致，
+ *             每个连接的发送队列只引用同一组包缓冲，包缓冲来自复用池
+ *   - copy:   同样打包一次，但每个观众发送前把每个包拷贝成独立的 std::string
+ * 观众为进程内 socketpair 的对端，单独线程持续读空；统计 operator new 次数与每帧耗时。
+ */
+#include "net/rtsp/rtsp_server.h"
+#include "net/rtsp/rtp.h"
+#include "net/event_loop.h"
+#include "net/tcp_connection.h"
+#include "net/buffer.h"
+#include "net/inet_address.h"
+#include "net/net_log.h"
+#include "base/event_loop_thread.h"
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::rtsp;
+
+namespace {
+
+std::atomic<uint64_t> g_allocs{0};
+
+double NowSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// @brief 关键帧 + 若干 P 帧的 Annex-B 码流
+std::string MakeFrame(bool idr, size_t size)
+{
+    std::string frame("\x00\x00\x00\x01", 4);
+    frame.push_back(static_cast<char>(idr ? 0x65 : 0x41));
+    frame.resize(4 + size, '\x5A');
+    return frame;
+}
+
+/// @brief 读空所有观众 socket 的线程
+class Drainer
+{
+public:
+    explicit Drainer(const std::vector<int> &fds)
+        :_epfd(::epoll_create1(EPOLL_CLOEXEC))
+    {
+        for(int fd : fds)
+        {
+            epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            ::epoll_ctl(_epfd, EPOLL_CTL_ADD, fd, &ev);
+        }
+        _thread = std::thread([this]() { run(); });
+    }
+
+    ~Drainer()
+    {
+        _stop = true;
+        _thread.join();
+        ::close(_epfd);
+    }
+
+    uint64_t bytes() const { return _bytes.load(); }
+
+private:
+    void run()
+    {
+        std::vector<epoll_event> events(256);
+        char buf[65536];
+        while(!_stop)
+        {
+            const int n = ::epoll_wait(_epfd, events.data(), static_cast<int>(events.size()), 10);
+            for(int i = 0; i < n; ++i)
+            {
+                ssize_t len;
+                while((len = ::recv(events[i].data.fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+                {
+                    _bytes += static_cast<uint64_t>(len);
+                }
+            }
+        }
+    }
+
+private:
+    int _epfd;
+    std::thread _thread;
+    std::atomic<bool> _stop{false};
+    std::atomic<uint64_t> _bytes{0};
+};
+
+}
+
+void* operator new(size_t size)
+{
+    ++g_allocs;
+    if(void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+
+    const int viewers = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 300;
+    const size_t frame_size = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 30000;
+
+    EventLoopThread loop_thread(nullptr, "bench_rtsp");
+    EventLoop *loop = loop_thread.startLoop();
+
+    // 观众连接: socketpair 一端交给 TcpConnection，另一端由 Drainer 读空
+    std::vector<TcpConnectionPtr> conns;
+    std::vector<int> peers;
+    for(int i = 0; i < viewers; ++i)
+    {
+        int sv[2];
+        if(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sv) < 0)
+        {
+            std::perror("socketpair");
+            return 1;
+        }
+        int buf_size = 4 * 1024 * 1024;
+        ::setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &buf_size, sizeof(buf_size));
+        ::setsockopt(sv[1], SOL_SOCKET, SO_RCVBUF, &buf_size, sizeof(buf_size));
+        auto conn = std::make_shared<TcpConnection>(loop, "viewer-" + std::to_string(i), sv[0], InetAddress(), InetAddress());
+        conn->setConnectionCallback([](const TcpConnectionPtr&) {});
+        conn->setMessageCallback([](const TcpConnectionPtr&, Buffer *buf, TimeStamp) { buf->resetAll(); });
+        conns.push_back(std::move(conn));
+        peers.push_back(sv[1]);
+    }
+    std::promise<void> established;
+    loop->runInLoop([&]() {
+        for(auto &conn : conns)
+        {
+            conn->connectEstablished();
+        }
+        established.set_value();
+    });
+    established.get_future().wait();
+    Drainer drainer(peers);
+
+    auto source = std::make_shared<RtspMediaSource>("/bench");
+    source->addTrack(RtspMediaSource::TrackConfig());
+    for(int i = 0; i < viewers; ++i)
+    {
+        RtspMediaSource::Sink sink;
+        sink.conn = conns[i];
+        sink.tracks.resize(1);
+        sink.tracks[0].enabled = true;
+        sink.tracks[0].channel = 0;
+        sink.maxPendingBytes = static_cast<size_t>(-1);
+        source->attach(conns[i].get(), std::move(sink));
+    }
+
+    // 拷贝模式的打包器与共享模式一致，只是投递时逐观众拷贝
+    RtpPacketizer packetizer(RtpPacketizer::Codec::kH264, 96, 1, 0);
+    const std::string idr = MakeFrame(true, frame_size);
+    const std::string p_frame = MakeFrame(false, frame_size / 4);
+
+    auto wait_drained = [&](uint64_t expect) {
+        while(drainer.bytes() < expect)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+
+    std::printf("%-7s %8s %8s %14s %16s %12s\n", "mode", "viewers", "frames", "us/frame", "allocs/frame", "MB/s");
+    for(const bool shared : {true, false})
+    {
+        const uint64_t bytes_before = drainer.bytes();
+        uint64_t expect = bytes_before;
+        const uint64_t allocs_before = g_allocs.load();
+        const double begin = NowSeconds();
+        for(int f = 0; f < frames; ++f)
+        {
+            const std::string &frame = 0 == f % 30 ? idr : p_frame;
+            const uint32_t ts = static_cast<uint32_t>(f) * 3000;
+            if(shared)
+            {
+                source->pushFrame(0, frame.data(), frame.size(), ts);
+            }
+            else
+            {
+                std::vector<SharedBuffer> packets;
+                packetizer.packetize(frame.data(), frame.size(), ts, &packets);
+                for(const TcpConnectionPtr &conn : conns)
+                {
+                    for(const SharedBuffer &packet : packets)
+                    {
+                        conn->send(std::string(*packet));
+                    }
+                }
+            }
+            // 每帧的期望字节: 以 RTP 包数估算，读端追上后再推下一帧，两种模式的背压一致
+            const size_t nal = frame.size() - 4;
+            const size_t fragments = nal <= kDefaultRtpMtu ? 1 : (nal - 1 + kDefaultRtpMtu - 3) / (kDefaultRtpMtu - 2);
+            const size_t frame_bytes = nal <= kDefaultRtpMtu
+                ? kInterleavedHeaderSize + kRtpHeaderSize + nal
+                : fragments * (kInterleavedHeaderSize + kRtpHeaderSize + 2) + nal - 1;
+            expect += frame_bytes * static_cast<uint64_t>(viewers);
+            wait_drained(expect);
+        }
+        const double secs = NowSeconds() - begin;
+        const uint64_t allocs = g_allocs.load() - allocs_before;
+        std::printf("%-7s %8d %8d %14.1f %16.1f %12.1f\n", shared ? "shared" : "copy", viewers, frames,
+                    secs * 1e6 / frames, static_cast<double>(allocs) / frames,
+                    (drainer.bytes() - bytes_before) / secs / (1024.0 * 1024.0));
+    }
+
+    const RtspMediaSource::Stats stats = source->stats();
+    std::printf("shared pool: acquired %lu, allocated %lu\n",
+                static_cast<unsigned long>(stats.pool.acquired), static_cast<unsigned long>(stats.pool.allocated));
+
+    std::promise<void> stopped;
+    loop->runInLoop([&]() {
+        for(auto &conn : conns)
+        {
+            conn->connectDestroyed();
+        }
+        stopped.set_value();
+    });
+    stopped.get_future().wait();
+    for(int fd : peers)
+    {
+        ::close(fd);
+    }
+    return 0;
+}
@@ -0,0 +1,248 @@
+/**
+ * @file bench_static_file.cpp
+ * @brief 静态文件服务吞吐对比：改造前(整读进内存) vs 描述符缓存+sendfile vs 热点资源内存缓存
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 11:30:52
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_static_file [每种文件的请求数，默认2000]
+ * 服务端与客户端在同一进程内，单个keep-alive连接串行请求，
+ * 对 4KB/64KB/1MB/16MB 文件分别打印 req/s 与 MB/s。
+ * hot 路由开启 HttpAssetCache，只有不超过单个上限(默认64KB)的文件走内存缓存。
+ */
+#include "net/http/http_server.h"
+#include "net/http/http_servlet.h"
+#include "net/http/http_context.h"
+#include "net/http/http_request.h"
+#include "net/http/http_response.h"
+#include "net/event_loop.h"
+#include "net/tcp_connection.h"
+#include "base/event_loop_thread.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+/**
+ * @brief 改造前的 StaticFileServlet: 每次请求 fstream 整读文件再拷贝进Body
+ */
+class LegacyStaticFileServlet: public HttpServlet
+{
+public:
+    explicit LegacyStaticFileServlet(const std::string &rootDir)
+        :HttpServlet("LegacyFileServlet")
+        ,_root_dir(rootDir)
+    {}
+
+    void handle(TcpConnectionPtr conn, HttpContextPtr ctx) override
+    {
+        auto resp = ctx->response();
+        auto req = ctx->request();
+
+        resp->setVersion(Version::kHttp11);
+        resp->setStateCode(StateCode::k200Ok);
+        resp->body().setContentType(ContentType::kOctetStream);
+
+        const std::string &path = req->path();
+        const std::string target_path = _root_dir + path.substr(path.find_last_of("/"));
+
+        std::fstream tmp_f(target_path, std::ios::in | std::ios::binary);
+        if(!tmp_f.is_open())
+        {
+            resp->setStateCode(StateCode::k500InternalServerError);
+            return;
+        }
+        std::string data;
+        tmp_f.seekg(0, std::ios::end);
+        uint64_t file_size = tmp_f.tellg();
+        tmp_f.seekg(0, std::ios::beg);
+        data.resize(file_size);
+        tmp_f.read((char*)data.data(), file_size);
+        resp->body().appendData(data);
+    }
+
+private:
+    std::string _root_dir;
+};
+
+int ConnectTo(uint16_t port)
+{
+    for(int i = 0; i < 50; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = ::htons(port);
+        addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+        if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+        {
+            return fd;
+        }
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return -1;
+}
+
+/**
+ * @brief 读取一个完整响应(依据 Content-Length)，返回Body长度，失败返回-1
+ */
+long ReadResponse(int fd, std::string &pending)
+{
+    static char buf[256 * 1024];
+    size_t header_end = std::string::npos;
+    while((header_end = pending.find("\r\n\r\n")) == std::string::npos)
+    {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if(n <= 0)
+        {
+            return -1;
+        }
+        pending.append(buf, n);
+    }
+
+    auto pos = pending.find("Content-Length: ");
+    if(std::string::npos == pos || pos > header_end)
+    {
+        return -1;
+    }
+    size_t body_len = std::strtoul(pending.c_str() + pos + 16, nullptr, 10);
+    size_t need = header_end + 4 + body_len;
+
+    // Body直接读走丢弃，避免大文件反复拷贝
+    size_t have = pending.size();
+    while(have < need)
+    {
+        ssize_t n = ::recv(fd, buf, std::min(sizeof(buf), need - have), 0);
+        if(n <= 0)
+        {
+            return -1;
+        }
+        have += static_cast<size_t>(n);
+    }
+    pending.erase(0, std::min(need, pending.size()));
+    return static_cast<long>(body_len);
+}
+
+void WriteFile(const std::string &path, size_t size)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    std::string block(64 * 1024, 'f');
+    for(size_t written = 0; written < size; written += block.size())
+    {
+        out.write(block.data(), std::min(block.size(), size - written));
+    }
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+
+    const int requests = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const uint16_t port = 20000 + (::getpid() % 2000);
+
+    char dir_tmpl[] = "/tmp/bench_static_XXXXXX";
+    const std::string root = ::mkdtemp(dir_tmpl);
+    struct FileCase { const char *name; size_t size; };
+    const std::vector<FileCase> cases = {
+        {"f_4k.bin", 4 * 1024},
+        {"f_64k.bin", 64 * 1024},
+        {"f_1m.bin", 1024 * 1024},
+        {"f_16m.bin", 16 * 1024 * 1024},
+    };
+    for(auto &c : cases)
+    {
+        WriteFile(root + "/" + c.name, c.size);
+    }
+
+    EventLoopThread loop_thread(nullptr, "bench_static");
+    EventLoop *loop = loop_thread.startLoop();
+
+    std::shared_ptr<HttpServer> server;
+    std::promise<void> started;
+    loop->runInLoop([&](){
+        server = std::make_shared<HttpServer>(loop, InetAddress(port, "127.0.0.1"), "bench-static", true, TcpServer::KReusePort);
+        server->setThreadNum(1);
+        server->Get("/legacy/*", std::make_shared<LegacyStaticFileServlet>(root));
+        auto new_servlet = std::make_shared<StaticFileServlet>(root, "/new");
+        new_servlet->setAssetCache(nullptr);
+        server->Get("/new/*", new_servlet);
+        server->Get("/hot/*", std::make_shared<StaticFileServlet>(root, "/hot"));
+        server->start();
+        started.set_value();
+    });
+    started.get_future().wait();
+
+    int fd = ConnectTo(port);
+    if(fd < 0)
+    {
+        std::fprintf(stderr, "connect failed\n");
+        return 1;
+    }
+
+    std::printf("%-10s %-8s %10s %12s %12s\n", "file", "impl", "requests", "req/s", "MB/s");
+    for(auto &c : cases)
+    {
+        // 大文件请求数按比例缩减，保证单项耗时可控
+        const int n = std::max(20, static_cast<int>(requests / std::max<size_t>(1, c.size / (256 * 1024))));
+        for(const char *impl : {"legacy", "new", "hot"})
+        {
+            const std::string req = std::string("GET /") + impl + "/" + c.name + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+            std::string pending;
+            auto begin = std::chrono::steady_clock::now();
+            size_t bytes = 0;
+            for(int i = 0; i < n; ++i)
+            {
+                ::send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+                long body = ReadResponse(fd, pending);
+                if(body != static_cast<long>(c.size))
+                {
+                    std::fprintf(stderr, "bad response: impl=%s file=%s body=%ld\n", impl, c.name, body);
+                    return 1;
+                }
+                bytes += static_cast<size_t>(body);
+            }
+            const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            std::printf("%-10s %-8s %10d %12.0f %12.1f\n", c.name, impl, n, n / sec, bytes / sec / 1024 / 1024);
+        }
+    }
+    ::close(fd);
+
+    for(auto &c : cases)
+    {
+        ::unlink((root + "/" + c.name).c_str());
+    }
+    ::rmdir(root.c_str());
+
+    std::promise<void> stopped;
+    loop->runInLoop([&](){
+        server.reset();
+        loop->quit();
+        stopped.set_value();
+    });
+    stopped.get_future().wait_for(std::chrono::seconds(2));
+    return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file bench_stream_rss.cpp
+ * @brief 大响应峰值内存(RSS)对比：流式响应 vs 整体缓存响应
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 15:20:08
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_stream_rss [stream|buffered] [响应大小MB，默认1024]
+ * 服务端与客户端在同一进程内，客户端读取并丢弃全部数据，
+ * 结束后打印进程峰值RSS(ru_maxrss)与吞吐。
+ */
+#include "net/http/http_server.h"
+#include "net/http/http_stream_writer.h"
+#include "net/http/http_context.h"
+#include "net/http/http_response.h"
+#include "net/event_loop.h"
+#include "net/tcp_connection.h"
+#include "base/event_loop_thread.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <string>
+#include <thread>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+long PeakRssKb()
+{
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+int ConnectTo(uint16_t port)
+{
+    for(int i = 0; i < 50; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = ::htons(port);
+        addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+        if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+        {
+            return fd;
+        }
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return -1;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+
+    const bool buffered = argc > 1 && std::strcmp(argv[1], "buffered") == 0;
+    const size_t total_mb = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1024;
+    const size_t total = total_mb * 1024 * 1024;
+    constexpr size_t kChunk = 64 * 1024;
+    const uint16_t port = 18000 + (::getpid() % 2000);
+
+    EventLoopThread loop_thread(nullptr, "bench_stream");
+    EventLoop *loop = loop_thread.startLoop();
+
+    std::shared_ptr<HttpServer> server;
+    std::promise<void> started;
+    loop->runInLoop([&](){
+        server = std::make_shared<HttpServer>(loop, InetAddress(port, "127.0.0.1"), "bench-stream", true, TcpServer::KReusePort);
+        server->setThreadNum(1);
+        server->Get("/data", [=](TcpConnectionPtr conn, HttpContextPtr ctx) {
+            auto resp = ctx->response();
+            resp->setStateCode(StateCode::k200Ok);
+            resp->setVersion(Version::kHttp11);
+            const std::string chunk(kChunk, 'd');
+            if(buffered)
+            {
+                // 改造前的做法：整个Body先进入内存，再一次性 toString + send
+                for(size_t sent = 0; sent < total; sent += kChunk)
+                {
+                    resp->body().appendData(chunk);
+                }
+                return;
+            }
+
+            HttpStreamWriter writer(conn, ctx);
+            for(size_t sent = 0; sent < total; sent += kChunk)
+            {
+                if(!writer.write(chunk))
+                {
+                    break;
+                }
+            }
+            writer.end();
+        });
+        server->start();
+        started.set_value();
+    });
+    started.get_future().wait();
+
+    const long rss_before = PeakRssKb();
+    int fd = ConnectTo(port);
+    if(fd < 0)
+    {
+        std::fprintf(stderr, "connect failed\n");
+        return 1;
+    }
+
+    const std::string req = "GET /data HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+    ::send(fd, req.data(), req.size(), 0);
+
+    auto begin = std::chrono::steady_clock::now();
+    size_t received = 0;
+    static char buf[256 * 1024];
+    while(true)
+    {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if(n <= 0)
+        {
+            break;
+        }
+        received += static_cast<size_t>(n);
+    }
+    auto end = std::chrono::steady_clock::now();
+    ::close(fd);
+
+    const double sec = std::chrono::duration<double>(end - begin).count();
+    std::printf("mode=%s body=%zuMB received=%zu bytes time=%.2fs throughput=%.1fMB/s\n",
+                buffered ? "buffered" : "stream", total_mb, received, sec, received / sec / 1024 / 1024);
+    std::printf("peak RSS: before=%ldKB after=%ldKB delta=%ldKB\n", rss_before, PeakRssKb(), PeakRssKb() - rss_before);
+
+    std::promise<void> stopped;
+    loop->runInLoop([&](){
+        server.reset();
+        loop->quit();
+        stopped.set_value();
+    });
+    stopped.get_future().wait_for(std::chrono::seconds(2));
+    return 0;
+}
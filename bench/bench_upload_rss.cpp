@@ -0,0 +1,210 @@
+/**
+ * @file bench_upload_rss.cpp
+ * @brief 大请求体上传内存曲线：流式Body接收器 vs 整体累积
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 18:11:30
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_upload_rss [sink|buffered] [上传大小MB，默认2048]
+ * 服务端与客户端在同一进程，采样线程每250ms读取一次 VmRSS，
+ * sink 模式下RSS曲线应保持平坦。
+ */
+#include "net/http/http_server.h"
+#include "net/http/http_context.h"
+#include "net/http/http_response.h"
+#include "net/http/http_body_sink.h"
+#include "net/event_loop.h"
+#include "base/event_loop_thread.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+long CurrentRssKb()
+{
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    while(std::getline(in, line))
+    {
+        if(line.compare(0, 6, "VmRSS:") == 0)
+        {
+            return std::strtol(line.c_str() + 6, nullptr, 10);
+        }
+    }
+    return 0;
+}
+
+long PeakRssKb()
+{
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+int ConnectTo(uint16_t port)
+{
+    for(int i = 0; i < 50; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = ::htons(port);
+        addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+        if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+        {
+            return fd;
+        }
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return -1;
+}
+
+class DiscardServlet : public HttpServlet
+{
+public:
+    explicit DiscardServlet(bool useSink)
+        :HttpServlet("DiscardServlet")
+        ,_useSink(useSink)
+    {}
+
+    HttpBodySink::Ptr createBodySink(TcpConnectionPtr conn, HttpContextPtr ctx) override
+    {
+        if(!_useSink)
+        {
+            return nullptr;
+        }
+        return std::make_shared<FunctionBodySink>([](const char *, size_t) { return true; });
+    }
+
+    void handle(TcpConnectionPtr conn, HttpContextPtr ctx) override
+    {
+        auto sink = ctx->bodySink();
+        uint64_t bytes = sink ? sink->receivedBytes() : ctx->request()->body().size();
+        auto resp = ctx->response();
+        resp->setVersion(Version::kHttp11);
+        resp->setStateCode(StateCode::k200Ok);
+        resp->body().appendData(std::to_string(bytes));
+    }
+
+private:
+    bool _useSink;
+};
+
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+
+    const bool use_sink = !(argc > 1 && std::strcmp(argv[1], "buffered") == 0);
+    const size_t total_mb = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2048;
+    const size_t total = total_mb * 1024 * 1024;
+    const uint16_t port = 20000 + (::getpid() % 2000);
+
+    EventLoopThread loop_thread(nullptr, "bench_upload");
+    EventLoop *loop = loop_thread.startLoop();
+
+    std::shared_ptr<HttpServer> server;
+    std::promise<void> started;
+    loop->runInLoop([&](){
+        server = std::make_shared<HttpServer>(loop, InetAddress(port, "127.0.0.1"), "bench-upload", true, TcpServer::KReusePort);
+        server->setThreadNum(1);
+        server->Post("/upload", std::make_shared<DiscardServlet>(use_sink));
+        server->start();
+        started.set_value();
+    });
+    started.get_future().wait();
+
+    std::atomic<bool> sampling{true};
+    std::vector<long> samples;
+    std::thread sampler([&]() {
+        while(sampling.load())
+        {
+            samples.push_back(CurrentRssKb());
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        }
+    });
+
+    int fd = ConnectTo(port);
+    if(fd < 0)
+    {
+        std::fprintf(stderr, "connect failed\n");
+        return 1;
+    }
+
+    const std::string header = "POST /upload HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n"
+                               "Content-Length: " + std::to_string(total) + "\r\n\r\n";
+    ::send(fd, header.data(), header.size(), 0);
+
+    auto begin = std::chrono::steady_clock::now();
+    static char chunk[256 * 1024];
+    std::memset(chunk, 'u', sizeof(chunk));
+    size_t sent = 0;
+    while(sent < total)
+    {
+        size_t len = std::min(sizeof(chunk), total - sent);
+        ssize_t n = ::send(fd, chunk, len, 0);
+        if(n <= 0)
+        {
+            break;
+        }
+        sent += static_cast<size_t>(n);
+    }
+
+    std::string resp;
+    char buf[4096];
+    ssize_t n = 0;
+    while((n = ::recv(fd, buf, sizeof(buf), 0)) > 0)
+    {
+        resp.append(buf, static_cast<size_t>(n));
+    }
+    auto end = std::chrono::steady_clock::now();
+    ::close(fd);
+
+    sampling.store(false);
+    sampler.join();
+
+    const double sec = std::chrono::duration<double>(end - begin).count();
+    const size_t body_pos = resp.find("\r\n\r\n");
+    std::printf("mode=%s upload=%zuMB sent=%zu server_received=%s time=%.2fs throughput=%.1fMB/s\n",
+                use_sink ? "sink" : "buffered", total_mb, sent,
+                body_pos == std::string::npos ? "?" : resp.substr(body_pos + 4).c_str(),
+                sec, sent / sec / 1024 / 1024);
+    std::printf("VmRSS samples(KB):");
+    for(size_t i = 0; i < samples.size(); i += (samples.size() / 16 + 1))
+    {
+        std::printf(" %ld", samples[i]);
+    }
+    std::printf("\npeak RSS: %ldKB\n", PeakRssKb());
+
+    std::promise<void> stopped;
+    loop->runInLoop([&](){
+        server.reset();
+        loop->quit();
+        stopped.set_value();
+    });
+    stopped.get_future().wait_for(std::chrono::seconds(2));
+    return 0;
+}
@@ -0,0 +1,339 @@
+/**
+ * @file bench_video_viewers.cpp
+ * @brief 模拟 N 个 HLS 直播观众: 共享分片缓存 与 每次 sendfile 读文件 的吞吐对比
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 10:41:55
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_video_viewers [观众数，默认200] [分片数，默认20] [分片大小，默认1048576] [IO线程数，默认4]
+ * 每一轮发布一个新分片(写文件后 fdatasync + POSIX_FADV_DONTNEED，首个读者落到磁盘)，
+ * 然后所有观众在各自的 keep-alive 连接上先拉播放列表、再拉最新分片，与直播观众的行为一致。
+ *   - cache:   VideoServlet 默认配置，分片复制到共享的 memfd，N 个观众从同一份内存 sendfile
+ *   - nocache: segmentCacheBytes = 0，每个请求都从源文件 sendfile
+ * disk MB 取自 /proc/self/io 的 read_bytes(实际块设备读取量)，理想值为 分片数 x 分片大小。
+ * /tmp 为 tmpfs 时 DONTNEED 不生效，disk MB 恒为 0。
+ */
+#include "net/http/http_video.h"
+#include "net/http/http_asset_cache.h"
+#include "net/http/http_server.h"
+#include "net/event_loop.h"
+#include "net/net_log.h"
+#include "base/event_loop_thread.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+double NowSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int ConnectTo(uint16_t port)
+{
+    for(int i = 0; i < 50; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = ::htons(port);
+        addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+        if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+        {
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+            return fd;
+        }
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return -1;
+}
+
+/// @brief 进程累计从块设备读取的字节数，不可用时返回 0
+uint64_t DiskReadBytes()
+{
+    FILE *f = std::fopen("/proc/self/io", "r");
+    if(nullptr == f)
+    {
+        return 0;
+    }
+    char line[128];
+    unsigned long long bytes = 0;
+    while(std::fgets(line, sizeof(line), f))
+    {
+        if(std::sscanf(line, "read_bytes: %llu", &bytes) == 1)
+        {
+            break;
+        }
+    }
+    std::fclose(f);
+    return bytes;
+}
+
+/// @brief 发布分片: 写入后落盘并丢弃页缓存
+bool PublishSegment(const std::string &path, const std::string &content)
+{
+    const std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0 || ::write(fd, content.data(), content.size()) != static_cast<ssize_t>(content.size()))
+    {
+        return false;
+    }
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+    // 先写临时文件再改名，观众不会读到写了一半的分片
+    return ::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+/**
+ * @brief 一个观众: 一条 keep-alive 连接上依次发送本轮请求并读完响应
+ */
+struct Viewer {
+    int fd{-1};
+    std::vector<std::string> requests;
+    size_t next{0};
+    std::string header;
+    /// @brief 当前响应剩余的 Body 字节，-1 表示还在读头部
+    long remaining{-1};
+    uint64_t bytes{0};
+    bool failed{false};
+};
+
+/// @brief 处理可读事件，返回本次读完的响应数
+int OnReadable(Viewer &viewer)
+{
+    static char buf[256 * 1024];
+    int completed = 0;
+    while(true)
+    {
+        ssize_t n = ::recv(viewer.fd, buf, sizeof(buf), 0);
+        if(n <= 0)
+        {
+            if(0 == n || (errno != EAGAIN && errno != EWOULDBLOCK))
+            {
+                viewer.failed = true;
+            }
+            return completed;
+        }
+        size_t pos = 0;
+        while(pos < static_cast<size_t>(n))
+        {
+            if(viewer.remaining < 0)
+            {
+                viewer.header.append(buf + pos, static_cast<size_t>(n) - pos);
+                pos = static_cast<size_t>(n);
+                const size_t end = viewer.header.find("\r\n\r\n");
+                if(std::string::npos == end)
+                {
+                    continue;
+                }
+                if(viewer.header.compare(0, 12, "HTTP/1.1 200") != 0)
+                {
+                    viewer.failed = true;
+                    return completed;
+                }
+                const size_t cl = viewer.header.find("Content-Length: ");
+                const long body = std::strtol(viewer.header.c_str() + cl + 16, nullptr, 10);
+                // 头部之后已读到的字节回退给 Body 计数
+                const size_t extra = viewer.header.size() - end - 4;
+                viewer.header.clear();
+                viewer.remaining = body;
+                pos -= extra;
+            }
+            const size_t take = std::min<size_t>(static_cast<size_t>(viewer.remaining), static_cast<size_t>(n) - pos);
+            viewer.remaining -= static_cast<long>(take);
+            viewer.bytes += take;
+            pos += take;
+            if(0 == viewer.remaining)
+            {
+                viewer.remaining = -1;
+                ++completed;
+                if(viewer.next < viewer.requests.size())
+                {
+                    const std::string &req = viewer.requests[viewer.next++];
+                    ::send(viewer.fd, req.data(), req.size(), MSG_NOSIGNAL);
+                }
+            }
+        }
+    }
+}
+
+struct RunResult {
+    uint64_t requests{0};
+    uint64_t bytes{0};
+    uint64_t diskBytes{0};
+    double seconds{0};
+    bool ok{true};
+};
+
+RunResult RunMode(uint16_t port, const std::string &root, int viewers, int segments, size_t segmentSize)
+{
+    RunResult result;
+    const uint64_t disk_before = DiskReadBytes();
+
+    std::vector<Viewer> clients(viewers);
+    int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    for(int i = 0; i < viewers; ++i)
+    {
+        clients[i].fd = ConnectTo(port);
+        if(clients[i].fd < 0)
+        {
+            result.ok = false;
+            return result;
+        }
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u32 = static_cast<uint32_t>(i);
+        ::epoll_ctl(epfd, EPOLL_CTL_ADD, clients[i].fd, &ev);
+    }
+
+    std::string content(segmentSize, '\0');
+    std::vector<epoll_event> events(1024);
+    for(int s = 0; s < segments; ++s)
+    {
+        for(size_t i = 0; i < content.size(); i += 4096)
+        {
+            content[i] = static_cast<char>(s);
+        }
+        const std::string name = "seg" + std::to_string(s) + ".ts";
+        if(!PublishSegment(root + "/live/" + name, content))
+        {
+            result.ok = false;
+            break;
+        }
+
+        const double begin = NowSeconds();
+        const std::string playlist = "GET /video/live/index.m3u8 HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+        const std::string segment = "GET /video/live/" + name + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+        int pending = 0;
+        for(Viewer &viewer : clients)
+        {
+            viewer.requests = {segment};
+            viewer.next = 0;
+            ::send(viewer.fd, playlist.data(), playlist.size(), MSG_NOSIGNAL);
+            pending += 2;
+        }
+        while(pending > 0 && result.ok)
+        {
+            const int n = ::epoll_wait(epfd, events.data(), static_cast<int>(events.size()), 2000);
+            if(n <= 0)
+            {
+                result.ok = false;
+                break;
+            }
+            for(int i = 0; i < n; ++i)
+            {
+                Viewer &viewer = clients[events[i].data.u32];
+                pending -= OnReadable(viewer);
+                result.ok = result.ok && !viewer.failed;
+            }
+        }
+        result.seconds += NowSeconds() - begin;
+        result.requests += static_cast<uint64_t>(viewers) * 2;
+    }
+
+    result.diskBytes = DiskReadBytes() - disk_before;
+    for(Viewer &viewer : clients)
+    {
+        result.bytes += viewer.bytes;
+        ::close(viewer.fd);
+    }
+    ::close(epfd);
+    return result;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+
+    const int viewers = argc > 1 ? std::atoi(argv[1]) : 200;
+    const int segments = argc > 2 ? std::atoi(argv[2]) : 20;
+    const size_t segment_size = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1024 * 1024;
+    const int threads = argc > 4 ? std::atoi(argv[4]) : 4;
+
+    std::printf("%-8s %8s %9s %10s %10s %8s %8s %9s\n",
+                "mode", "viewers", "requests", "req/s", "MB/s", "hit%", "bypass", "disk MB");
+    for(const bool cached : {true, false})
+    {
+        char dir_tmpl[] = "/tmp/bench_video_XXXXXX";
+        const std::string root = ::mkdtemp(dir_tmpl);
+        ::mkdir((root + "/live").c_str(), 0755);
+
+        VideoServlet::Config config;
+        config.settleMs = 0;
+        config.playlistTtlMs = 200;
+        config.segmentCacheBytes = cached ? 256 * 1024 * 1024 : 0;
+        auto servlet = std::make_shared<VideoServlet>(root, "/video", config);
+
+        const uint16_t port = static_cast<uint16_t>(22000 + (::getpid() % 2000) * 2 + (cached ? 0 : 1));
+        EventLoopThread loop_thread(nullptr, "bench_video");
+        EventLoop *loop = loop_thread.startLoop();
+        std::shared_ptr<HttpServer> server;
+        std::promise<void> started;
+        loop->runInLoop([&](){
+            server = std::make_shared<HttpServer>(loop, InetAddress(port, "127.0.0.1"), "bench-video", false, TcpServer::KReusePort);
+            server->setThreadNum(threads);
+            server->Get("/video/*/*", servlet);
+            server->start();
+            started.set_value();
+        });
+        started.get_future().wait();
+
+        const RunResult result = RunMode(port, root, viewers, segments, segment_size);
+        if(!result.ok)
+        {
+            std::fprintf(stderr, "mode %s failed\n", cached ? "cache" : "nocache");
+            return 1;
+        }
+        double hit = 0.0;
+        unsigned long bypass = 0;
+        if(auto cache = servlet->segmentCache())
+        {
+            const HttpAssetCache::Stats stats = cache->stats();
+            hit = stats.hits + stats.misses ? 100.0 * stats.hits / (stats.hits + stats.misses) : 0.0;
+            bypass = static_cast<unsigned long>(stats.fill_bypasses);
+        }
+        std::printf("%-8s %8d %9lu %10.0f %10.1f %8.1f %8lu %9.1f\n", cached ? "cache" : "nocache",
+                    viewers, static_cast<unsigned long>(result.requests),
+                    result.requests / result.seconds, result.bytes / result.seconds / (1024.0 * 1024.0),
+                    hit, bypass, result.diskBytes / (1024.0 * 1024.0));
+
+        std::promise<void> stopped;
+        loop->runInLoop([&](){
+            server.reset();
+            loop->quit();
+            stopped.set_value();
+        });
+        stopped.get_future().wait_for(std::chrono::seconds(2));
+        const std::string cmd = "rm -rf '" + root + "'";
+        if(std::system(cmd.c_str()) != 0)
+        {
+            std::fprintf(stderr, "cleanup %s failed\n", root.c_str());
+        }
+    }
+    return 0;
+}
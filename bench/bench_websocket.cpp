@@ -0,0 +1,141 @@
+/**
+ * @file bench_websocket.cpp
+ * @brief WebSocket 掩码吞吐与广播编码开销压测
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 23:41:26
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法: bench_websocket [连接数]
+ *   - mask:      各实现级别(标量/SSE2/AVX2)对 64KB 负载解掩码的吞吐
+ *   - broadcast: 一条消息发给 N 个连接，共享帧(编码一次，各连接引用同一缓冲)
+ *                与逐连接编码的耗时与堆内存分配量；发送队列以 SharedBuffer 数组模拟
+ */
+#include "net/http/websocket.h"
+#include "net/http/http_scanner.h"
+#include "net/call_backs.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+std::atomic<uint64_t> g_alloc_bytes{0};
+
+}
+
+// 统计堆分配字节数
+void* operator new(size_t size)
+{
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if(void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+double NowSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void BenchMask()
+{
+    const uint8_t key[4] = {0x12, 0x34, 0x56, 0x78};
+    std::string data(64 * 1024, 'x');
+    const int rounds = 20000;
+
+    std::printf("%-10s %12s\n", "mask", "GB/s");
+    const HttpScanLevel best = DetectHttpScanLevel();
+    for(uint8_t l = 0; l <= static_cast<uint8_t>(best); ++l)
+    {
+        const HttpScanLevel level = static_cast<HttpScanLevel>(l);
+        const double begin = NowSeconds();
+        for(int i = 0; i < rounds; ++i)
+        {
+            // 奇数相位覆盖非对齐的起点
+            WebSocketMaskWith(level, &data[0], data.size(), key, i & 3);
+        }
+        const double secs = NowSeconds() - begin;
+        std::printf("%-10s %12.2f\n", HttpScanLevelName(level), static_cast<double>(data.size()) * rounds / secs / 1e9);
+    }
+}
+
+struct BroadcastResult
+{
+    double us{0};
+    double kb{0};
+};
+
+template<typename Fn>
+BroadcastResult MeasureBroadcast(std::vector<std::vector<SharedBuffer>> &queues, int rounds, Fn &&fn)
+{
+    const uint64_t bytes = g_alloc_bytes.load();
+    const double begin = NowSeconds();
+    for(int i = 0; i < rounds; ++i)
+    {
+        fn();
+        for(auto &q : queues)
+        {
+            q.clear();
+        }
+    }
+    BroadcastResult result;
+    result.us = (NowSeconds() - begin) * 1e6 / rounds;
+    result.kb = static_cast<double>(g_alloc_bytes.load() - bytes) / rounds / 1024;
+    return result;
+}
+
+void BenchBroadcast(int conns)
+{
+    const int rounds = 200;
+    std::printf("\n%-10s %10s %14s %14s %14s %14s\n", "broadcast", "conns", "shared(us)", "alloc(KB)", "per-conn(us)", "alloc(KB)");
+    for(size_t len : {64u, 4096u, 65536u})
+    {
+        const std::string payload(len, 'm');
+        std::vector<std::vector<SharedBuffer>> queues(conns);
+        for(auto &q : queues)
+        {
+            q.reserve(1);
+        }
+
+        BroadcastResult shared = MeasureBroadcast(queues, rounds, [&]() {
+            SharedBuffer frame = std::make_shared<const std::string>(WebSocketCodec::Encode(WebSocketOpcode::kText, payload.data(), payload.size()));
+            for(auto &q : queues)
+            {
+                q.push_back(frame);
+            }
+        });
+        BroadcastResult per_conn = MeasureBroadcast(queues, rounds, [&]() {
+            for(auto &q : queues)
+            {
+                q.push_back(std::make_shared<const std::string>(WebSocketCodec::Encode(WebSocketOpcode::kText, payload.data(), payload.size())));
+            }
+        });
+        std::printf("%-10zu %10d %14.1f %14.1f %14.1f %14.1f\n", len, conns, shared.us, shared.kb, per_conn.us, per_conn.kb);
+    }
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    const int conns = argc > 1 ? std::atoi(argv[1]) : 1000;
+    BenchMask();
+    BenchBroadcast(conns);
+    return 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file digest.h
+ * @brief SHA-1 摘要与 Base64 编解码
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 22:40:16
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_DIGEST_H__
+#define __KIT_DIGEST_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace kit_muduo {
+
+using Sha1Digest = std::array<uint8_t, 20>;
+
+/**
+ * @brief 增量计算 SHA-1(FIPS 180-4)
+ * @note 仅用于协议握手(如 WebSocket Sec-WebSocket-Accept)，不应用于安全场景
+ */
+class Sha1
+{
+public:
+    Sha1();
+
+    void update(const void *data, size_t len);
+    /// @brief 结束计算，之后需 reset 才能复用
+    Sha1Digest finish();
+    void reset();
+
+private:
+    void compress(const uint8_t block[64]);
+
+private:
+    uint32_t _state[5];
+    uint8_t _block[64];
+    size_t _blockLen{0};
+    uint64_t _totalLen{0};
+};
+
+/// @brief 一次性计算 SHA-1
+Sha1Digest Sha1Sum(const void *data, size_t len);
+
+/// @brief 标准 Base64 编码(带 '=' 填充)
+std::string Base64Encode(const void *data, size_t len);
+
+/**
+ * @brief 标准 Base64 解码，要求长度为4的倍数且填充合法
+ * @return 含非法字符或填充错误时返回 false
+ */
+bool Base64Decode(std::string_view in, std::string *out);
+
+}   // kit_muduo
+#endif
@@ -0,0 +1,623 @@
+/**
+ * @file json_stream.h
+ * @brief 流式 JSON 读写: 直接写入输出缓冲的写入器、无 DOM 的字节解析器与字段反射宏
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 11:32:06
+ * @copyright Copyright (c) 2026 Kewin Li
+ *
+ * 用法:
+ *   struct User { int64_t id; std::string name; std::vector<std::string> tags; };
+ *   KIT_JSON_FIELDS(User, id, name, tags)      // 与 User 同一命名空间、命名空间作用域
+ *
+ *   JsonEncode(user, &out);                    // out 为 std::string / Buffer / http::Body
+ *   JsonDecode(body.view(), &user, &err);      // 直接从字节解析到对象
+ *
+ * 解析按声明的类型逐字段读取: 未声明的键跳过，缺失的键保持原值，类型不符即失败。
+ */
+#ifndef __KIT_JSON_STREAM_H__
+#define __KIT_JSON_STREAM_H__
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define KIT_JSON_EXPAND(x) x
+#define KIT_JSON_GET_MACRO(_1,_2,_3,_4,_5,_6,_7,_8,_9,_10,_11,_12,_13,_14,_15,_16,_17,_18,_19,_20,_21,_22,_23,_24,_25,_26,_27,_28,_29,_30,_31,_32, NAME, ...) NAME
+#define KIT_JSON_PASTE(func, ...) KIT_JSON_EXPAND(KIT_JSON_GET_MACRO(__VA_ARGS__, \
+        KIT_JSON_PASTE32, KIT_JSON_PASTE31, KIT_JSON_PASTE30, KIT_JSON_PASTE29, KIT_JSON_PASTE28, KIT_JSON_PASTE27, KIT_JSON_PASTE26, KIT_JSON_PASTE25, \
+        KIT_JSON_PASTE24, KIT_JSON_PASTE23, KIT_JSON_PASTE22, KIT_JSON_PASTE21, KIT_JSON_PASTE20, KIT_JSON_PASTE19, KIT_JSON_PASTE18, KIT_JSON_PASTE17, \
+        KIT_JSON_PASTE16, KIT_JSON_PASTE15, KIT_JSON_PASTE14, KIT_JSON_PASTE13, KIT_JSON_PASTE12, KIT_JSON_PASTE11, KIT_JSON_PASTE10, KIT_JSON_PASTE9, \
+        KIT_JSON_PASTE8, KIT_JSON_PASTE7, KIT_JSON_PASTE6, KIT_JSON_PASTE5, KIT_JSON_PASTE4, KIT_JSON_PASTE3, KIT_JSON_PASTE2, KIT_JSON_PASTE1)(func, __VA_ARGS__))
+#define KIT_JSON_PASTE1(func, v1) func(v1)
+#define KIT_JSON_PASTE2(func, v1, v2) func(v1) KIT_JSON_PASTE1(func, v2)
+#define KIT_JSON_PASTE3(func, v1, v2, v3) func(v1) KIT_JSON_PASTE2(func, v2, v3)
+#define KIT_JSON_PASTE4(func, v1, v2, v3, v4) func(v1) KIT_JSON_PASTE3(func, v2, v3, v4)
+#define KIT_JSON_PASTE5(func, v1, v2, v3, v4, v5) func(v1) KIT_JSON_PASTE4(func, v2, v3, v4, v5)
+#define KIT_JSON_PASTE6(func, v1, v2, v3, v4, v5, v6) func(v1) KIT_JSON_PASTE5(func, v2, v3, v4, v5, v6)
+#define KIT_JSON_PASTE7(func, v1, v2, v3, v4, v5, v6, v7) func(v1) KIT_JSON_PASTE6(func, v2, v3, v4, v5, v6, v7)
+#define KIT_JSON_PASTE8(func, v1, v2, v3, v4, v5, v6, v7, v8) func(v1) KIT_JSON_PASTE7(func, v2, v3, v4, v5, v6, v7, v8)
+#define KIT_JSON_PASTE9(func, v1, v2, v3, v4, v5, v6, v7, v8, v9) func(v1) KIT_JSON_PASTE8(func, v2, v3, v4, v5, v6, v7, v8, v9)
+#define KIT_JSON_PASTE10(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10) func(v1) KIT_JSON_PASTE9(func, v2, v3, v4, v5, v6, v7, v8, v9, v10)
+#define KIT_JSON_PASTE11(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11) func(v1) KIT_JSON_PASTE10(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11)
+#define KIT_JSON_PASTE12(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12) func(v1) KIT_JSON_PASTE11(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12)
+#define KIT_JSON_PASTE13(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13) func(v1) KIT_JSON_PASTE12(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13)
+#define KIT_JSON_PASTE14(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14) func(v1) KIT_JSON_PASTE13(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14)
+#define KIT_JSON_PASTE15(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15) func(v1) KIT_JSON_PASTE14(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15)
+#define KIT_JSON_PASTE16(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16) func(v1) KIT_JSON_PASTE15(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16)
+#define KIT_JSON_PASTE17(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17) func(v1) KIT_JSON_PASTE16(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17)
+#define KIT_JSON_PASTE18(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18) func(v1) KIT_JSON_PASTE17(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18)
+#define KIT_JSON_PASTE19(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19) func(v1) KIT_JSON_PASTE18(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19)
+#define KIT_JSON_PASTE20(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20) func(v1) KIT_JSON_PASTE19(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20)
+#define KIT_JSON_PASTE21(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21) func(v1) KIT_JSON_PASTE20(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21)
+#define KIT_JSON_PASTE22(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22) func(v1) KIT_JSON_PASTE21(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22)
+#define KIT_JSON_PASTE23(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23) func(v1) KIT_JSON_PASTE22(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23)
+#define KIT_JSON_PASTE24(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24) func(v1) KIT_JSON_PASTE23(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24)
+#define KIT_JSON_PASTE25(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25) func(v1) KIT_JSON_PASTE24(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25)
+#define KIT_JSON_PASTE26(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26) func(v1) KIT_JSON_PASTE25(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26)
+#define KIT_JSON_PASTE27(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26, v27) func(v1) KIT_JSON_PASTE26(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26, v27)
+#define KIT_JSON_PASTE28(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26, v27, v28) func(v1) KIT_JSON_PASTE27(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26, v27, v28)
+#define KIT_JSON_PASTE29(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26, v27, v28, v29) func(v1) KIT_JSON_PASTE28(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26, v27, v28, v29)
+#define KIT_JSON_PASTE30(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26, v27, v28, v29, v30) func(v1) KIT_JSON_PASTE29(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26, v27, v28, v29, v30)
+#define KIT_JSON_PASTE31(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26, v27, v28, v29, v30, v31) func(v1) KIT_JSON_PASTE30(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26, v27, v28, v29, v30, v31)
+#define KIT_JSON_PASTE32(func, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26, v27, v28, v29, v30, v31, v32) func(v1) KIT_JSON_PASTE31(func, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16, v17, v18, v19, v20, v21, v22, v23, v24, v25, v26, v27, v28, v29, v30, v31, v32)
+
+/// @brief 声明类型的 JSON 字段(最多 32 个)，生成供 JsonWrite/JsonRead 通过 ADL 找到的 KitJsonVisit
+#define KIT_JSON_FIELDS(Type, ...)                                                          \
+    template<typename KitJsonVisitor>                                                       \
+    inline void KitJsonVisit(Type &kit_json_obj, KitJsonVisitor &&kit_json_visitor)         \
+    {                                                                                       \
+        KIT_JSON_EXPAND(KIT_JSON_PASTE(KIT_JSON_VISIT_FIELD, __VA_ARGS__))                  \
+    }                                                                                       \
+    template<typename KitJsonVisitor>                                                       \
+    inline void KitJsonVisit(const Type &kit_json_obj, KitJsonVisitor &&kit_json_visitor)   \
+    {                                                                                       \
+        KIT_JSON_EXPAND(KIT_JSON_PASTE(KIT_JSON_VISIT_FIELD, __VA_ARGS__))                  \
+    }
+
+/// @brief 访问者返回 true 时停止遍历(解析时命中键后即返回)
+#define KIT_JSON_VISIT_FIELD(field)                                                         \
+    if(kit_json_visitor(std::string_view(#field, sizeof(#field) - 1), kit_json_obj.field))  \
+    {                                                                                       \
+        return;                                                                             \
+    }
+
+namespace kit_muduo {
+
+/**
+ * @brief 流式 JSON 写入器，按调用顺序直接追加到输出容器，不构造中间 DOM
+ * @tparam Out 需提供 append(const char*, size_t)，可选 push_back(char)，如 std::string、Buffer、http::Body
+ * @note 逗号只用一个标志维护: 容器结束后所在层必然已有元素，不需要层级栈；
+ *       键值配对与括号匹配由调用者保证
+ */
+template<typename Out>
+class JsonWriter
+{
+public:
+    explicit JsonWriter(Out *out)
+        :_out(out)
+    {}
+
+    void beginObject() { separate(); put('{'); _needComma = false; }
+    void endObject() { put('}'); _needComma = true; }
+    void beginArray() { separate(); put('['); _needComma = false; }
+    void endArray() { put(']'); _needComma = true; }
+
+    void key(std::string_view name)
+    {
+        separate();
+        writeString(name);
+        put(':');
+        _needComma = false;
+    }
+
+    void nullValue() { separate(); append("null", 4); _needComma = true; }
+
+    void boolValue(bool val)
+    {
+        separate();
+        val ? append("true", 4) : append("false", 5);
+        _needComma = true;
+    }
+
+    void intValue(int64_t val) { writeNumber(val); }
+    void uintValue(uint64_t val) { writeNumber(val); }
+
+    /// @brief 最短往返表示，整数值补 ".0"；NaN/Inf 写 null(与 nlohmann 一致)
+    void doubleValue(double val)
+    {
+        if(!std::isfinite(val))
+        {
+            nullValue();
+            return;
+        }
+        separate();
+        char buf[32];
+        const auto res = std::to_chars(buf, buf + sizeof(buf), val);
+        size_t len = static_cast<size_t>(res.ptr - buf);
+        if(std::string_view(buf, len).find_first_of(".eE") == std::string_view::npos)
+        {
+            buf[len++] = '.';
+            buf[len++] = '0';
+        }
+        append(buf, len);
+        _needComma = true;
+    }
+
+    void stringValue(std::string_view val)
+    {
+        separate();
+        writeString(val);
+        _needComma = true;
+    }
+
+    /// @brief 原样写入一段已序列化的 JSON 值
+    void rawValue(std::string_view json)
+    {
+        separate();
+        append(json.data(), json.size());
+        _needComma = true;
+    }
+
+    Out* output() const { return _out; }
+
+private:
+    void append(const char *data, size_t len) { _out->append(data, len); }
+
+    void put(char c)
+    {
+        if constexpr(kHasPushBack)
+        {
+            _out->push_back(c);
+        }
+        else
+        {
+            _out->append(&c, 1);
+        }
+    }
+
+    void separate()
+    {
+        if(_needComma)
+        {
+            put(',');
+        }
+    }
+
+    template<typename Int>
+    void writeNumber(Int val)
+    {
+        separate();
+        char buf[24];
+        const auto res = std::to_chars(buf, buf + sizeof(buf), val);
+        append(buf, static_cast<size_t>(res.ptr - buf));
+        _needComma = true;
+    }
+
+    /// @brief 转义 '"'、'\\' 与控制字符，其余字节(含 UTF-8)按段原样追加
+    void writeString(std::string_view str)
+    {
+        static const char kHex[] = "0123456789abcdef";
+        put('"');
+        const char *run = str.data();
+        const char *end = str.data() + str.size();
+        for(const char *p = run; p < end; ++p)
+        {
+            const unsigned char c = static_cast<unsigned char>(*p);
+            if(c >= 0x20 && c != '"' && c != '\\')
+            {
+                continue;
+            }
+            append(run, static_cast<size_t>(p - run));
+            run = p + 1;
+            switch(c)
+            {
+                case '"': append("\\\"", 2); break;
+                case '\\': append("\\\\", 2); break;
+                case '\b': append("\\b", 2); break;
+                case '\f': append("\\f", 2); break;
+                case '\n': append("\\n", 2); break;
+                case '\r': append("\\r", 2); break;
+                case '\t': append("\\t", 2); break;
+                default:
+                {
+                    const char esc[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0x0f]};
+                    append(esc, sizeof(esc));
+                    break;
+                }
+            }
+        }
+        append(run, static_cast<size_t>(end - run));
+        put('"');
+    }
+
+private:
+    template<typename O, typename = void>
+    struct HasPushBack: std::false_type {};
+    template<typename O>
+    struct HasPushBack<O, std::void_t<decltype(std::declval<O&>().push_back('c'))>>: std::true_type {};
+    /// @brief 单字符优先走 push_back，比 append(&c, 1) 少一次区间插入
+    static constexpr bool kHasPushBack = HasPushBack<Out>::value;
+
+    Out *_out;
+    bool _needComma{false};
+};
+
+/**
+ * @brief 无 DOM 的 JSON 解析器，游标直接在输入字节上移动
+ *
+ * 调用者按期望的结构逐个读取；出错时记录首个错误与位置，之后所有读取返回 false。
+ * 对象/数组的逗号同样只用一个标志维护: 嵌套容器读完后外层必然不是首个元素。
+ * 嵌套深度超过 kMaxDepth 即失败，递归类型也不会被恶意输入撑爆栈。
+ */
+class JsonReader
+{
+public:
+    /// @brief 对象/数组允许的最大嵌套深度
+    static constexpr int kMaxDepth = 256;
+
+    JsonReader(const char *data, size_t len)
+        :_begin(data)
+        ,_cur(data)
+        ,_end(data + len)
+    {}
+
+    bool ok() const { return nullptr == _error; }
+    const char* error() const { return _error; }
+    /// @brief 出错位置(相对输入起点的字节偏移)
+    size_t offset() const { return static_cast<size_t>(_cur - _begin); }
+    /// @brief "错误描述 at offset N"
+    std::string errorMessage() const;
+
+    /// @brief 记录错误(仅保留首个)，总是返回 false
+    bool fail(const char *msg);
+
+    /// @brief 下一个值是 null 时消费并返回 true，否则不移动游标
+    bool consumeNull();
+    bool readBool(bool *val);
+    /// @brief 读取整数；写成小数/指数形式但值为整数的(如 3.0)同样接受
+    bool readInt(int64_t *val);
+    bool readUint(uint64_t *val);
+    bool readDouble(double *val);
+    bool readString(std::string *val);
+
+    /// @brief 读取 '{'
+    bool beginObject();
+    /**
+     * @brief 读取下一个键及其后的 ':'
+     * @param[out] key 无转义时直接指向输入，有转义时指向内部缓冲，到下一次读取键前有效
+     * @return 遇到 '}' 或出错时返回 false，以 ok() 区分
+     */
+    bool nextKey(std::string_view *key);
+    /// @brief 读取 '['
+    bool beginArray();
+    /// @brief 定位到下一个元素，遇到 ']' 或出错时返回 false
+    bool nextElement();
+
+    /// @brief 跳过一个任意类型的值
+    bool skipValue();
+    /// @brief 确认输入只剩空白
+    bool finish();
+
+private:
+    void skipSpace()
+    {
+        while(_cur < _end && (' ' == *_cur || '\n' == *_cur || '\r' == *_cur || '\t' == *_cur))
+        {
+            ++_cur;
+        }
+    }
+
+    bool expect(char c);
+    bool consumeLiteral(const char *literal, size_t len);
+    /// @brief 按 JSON 语法扫描一个数字，返回其范围与是否为整数写法
+    bool scanNumber(const char **start, const char **stop, bool *integral);
+    /// @brief 读取字符串；无转义时 *view 指向输入，否则解码到 out
+    bool scanString(std::string_view *view, std::string *out);
+
+private:
+    const char *_begin;
+    const char *_cur;
+    const char *_end;
+    const char *_error{nullptr};
+    bool _first{false};
+    int _depth{0};
+    /// @brief 含转义的键/被跳过的字符串解码到这里
+    std::string _scratch;
+};
+
+namespace json_detail {
+
+template<typename T>
+inline constexpr bool kAlwaysFalse = false;
+
+/// @brief 只用于探测 KitJsonVisit 是否存在
+struct ProbeVisitor {
+    template<typename Field>
+    bool operator()(std::string_view, Field&) const { return false; }
+};
+
+template<typename T>
+struct IsVector: std::false_type {};
+template<typename T, typename A>
+struct IsVector<std::vector<T, A>>: std::true_type {};
+
+template<typename T>
+struct IsOptional: std::false_type {};
+template<typename T>
+struct IsOptional<std::optional<T>>: std::true_type {};
+
+/// @brief 以 std::string 为键的 map/unordered_map，按 JSON 对象读写
+template<typename T>
+struct IsStringMap: std::false_type {};
+template<typename V, typename C, typename A>
+struct IsStringMap<std::map<std::string, V, C, A>>: std::true_type {};
+template<typename V, typename H, typename E, typename A>
+struct IsStringMap<std::unordered_map<std::string, V, H, E, A>>: std::true_type {};
+
+}   // json_detail
+
+/// @brief 类型是否通过 KIT_JSON_FIELDS 声明了字段
+template<typename T, typename = void>
+struct IsJsonReflected: std::false_type {};
+
+template<typename T>
+struct IsJsonReflected<T, std::void_t<decltype(KitJsonVisit(std::declval<T&>(), std::declval<json_detail::ProbeVisitor&>()))>>
+    : std::true_type {};
+
+/**
+ * @brief 把值写入 JSON 写入器
+ * 支持 bool/整数/浮点/字符串、optional(空为 null)、vector、以 string 为键的 map，
+ * 以及声明了 KIT_JSON_FIELDS 的类型(按声明顺序输出字段)
+ */
+template<typename Out, typename T>
+void JsonWrite(JsonWriter<Out> &writer, const T &val)
+{
+    if constexpr(std::is_same_v<T, bool>)
+    {
+        writer.boolValue(val);
+    }
+    else if constexpr(std::is_integral_v<T> && std::is_signed_v<T>)
+    {
+        writer.intValue(val);
+    }
+    else if constexpr(std::is_integral_v<T>)
+    {
+        writer.uintValue(val);
+    }
+    else if constexpr(std::is_floating_point_v<T>)
+    {
+        writer.doubleValue(static_cast<double>(val));
+    }
+    else if constexpr(std::is_convertible_v<const T&, std::string_view>)
+    {
+        writer.stringValue(val);
+    }
+    else if constexpr(json_detail::IsOptional<T>::value)
+    {
+        if(val)
+        {
+            JsonWrite(writer, *val);
+        }
+        else
+        {
+            writer.nullValue();
+        }
+    }
+    else if constexpr(json_detail::IsVector<T>::value)
+    {
+        writer.beginArray();
+        for(const auto &item : val)
+        {
+            JsonWrite(writer, item);
+        }
+        writer.endArray();
+    }
+    else if constexpr(json_detail::IsStringMap<T>::value)
+    {
+        writer.beginObject();
+        for(const auto &item : val)
+        {
+            writer.key(item.first);
+            JsonWrite(writer, item.second);
+        }
+        writer.endObject();
+    }
+    else if constexpr(IsJsonReflected<T>::value)
+    {
+        writer.beginObject();
+        KitJsonVisit(val, [&writer](std::string_view name, const auto &field) {
+            writer.key(name);
+            JsonWrite(writer, field);
+            return false;
+        });
+        writer.endObject();
+    }
+    else
+    {
+        static_assert(json_detail::kAlwaysFalse<T>, "type is not JSON serializable, declare it with KIT_JSON_FIELDS");
+    }
+}
+
+/**
+ * @brief 从解析器读取一个值到 val，支持的类型同 JsonWrite
+ * @note 对象中未声明的键跳过，缺失的键保持原值；整数越界、类型不符均失败
+ */
+template<typename T>
+bool JsonRead(JsonReader &reader, T &val)
+{
+    if constexpr(std::is_same_v<T, bool>)
+    {
+        return reader.readBool(&val);
+    }
+    else if constexpr(std::is_integral_v<T> && std::is_signed_v<T>)
+    {
+        int64_t num = 0;
+        if(!reader.readInt(&num))
+        {
+            return false;
+        }
+        if constexpr(sizeof(T) < sizeof(int64_t))
+        {
+            if(num < std::numeric_limits<T>::min() || num > std::numeric_limits<T>::max())
+            {
+                return reader.fail("integer out of range");
+            }
+        }
+        val = static_cast<T>(num);
+        return true;
+    }
+    else if constexpr(std::is_integral_v<T>)
+    {
+        uint64_t num = 0;
+        if(!reader.readUint(&num))
+        {
+            return false;
+        }
+        if constexpr(sizeof(T) < sizeof(uint64_t))
+        {
+            if(num > std::numeric_limits<T>::max())
+            {
+                return reader.fail("integer out of range");
+            }
+        }
+        val = static_cast<T>(num);
+        return true;
+    }
+    else if constexpr(std::is_floating_point_v<T>)
+    {
+        double num = 0;
+        if(!reader.readDouble(&num))
+        {
+            return false;
+        }
+        val = static_cast<T>(num);
+        return true;
+    }
+    else if constexpr(std::is_same_v<T, std::string>)
+    {
+        return reader.readString(&val);
+    }
+    else if constexpr(json_detail::IsOptional<T>::value)
+    {
+        if(reader.consumeNull())
+        {
+            val.reset();
+            return true;
+        }
+        return JsonRead(reader, val.emplace());
+    }
+    else if constexpr(json_detail::IsVector<T>::value)
+    {
+        if(!reader.beginArray())
+        {
+            return false;
+        }
+        val.clear();
+        while(reader.nextElement())
+        {
+            if(!JsonRead(reader, val.emplace_back()))
+            {
+                return false;
+            }
+        }
+        return reader.ok();
+    }
+    else if constexpr(json_detail::IsStringMap<T>::value)
+    {
+        if(!reader.beginObject())
+        {
+            return false;
+        }
+        val.clear();
+        std::string_view key;
+        while(reader.nextKey(&key))
+        {
+            if(!JsonRead(reader, val[std::string(key)]))
+            {
+                return false;
+            }
+        }
+        return reader.ok();
+    }
+    else if constexpr(IsJsonReflected<T>::value)
+    {
+        if(!reader.beginObject())
+        {
+            return false;
+        }
+        std::string_view key;
+        while(reader.nextKey(&key))
+        {
+            bool matched = false;
+            KitJsonVisit(val, [&reader, &matched, key](std::string_view name, auto &field) {
+                if(name != key)
+                {
+                    return false;
+                }
+                matched = true;
+                JsonRead(reader, field);
+                return true;
+            });
+            if(!(matched ? reader.ok() : reader.skipValue()))
+            {
+                return false;
+            }
+        }
+        return reader.ok();
+    }
+    else
+    {
+        static_assert(json_detail::kAlwaysFalse<T>, "type is not JSON deserializable, declare it with KIT_JSON_FIELDS");
+        return false;
+    }
+}
+
+/// @brief 把值序列化追加到 out(std::string / Buffer / http::Body 等)
+template<typename T, typename Out>
+void JsonEncode(const T &val, Out *out)
+{
+    JsonWriter<Out> writer(out);
+    JsonWrite(writer, val);
+}
+
+template<typename T>
+std::string JsonEncode(const T &val)
+{
+    std::string out;
+    JsonEncode(val, &out);
+    return out;
+}
+
+/**
+ * @brief 从 JSON 文本直接解析到对象
+ * @param[out] err 失败时写入错误描述与偏移，可为空
+ * @note 失败时 obj 可能已被部分写入
+ */
+template<typename T>
+bool JsonDecode(std::string_view json, T *obj, std::string *err = nullptr)
+{
+    JsonReader reader(json.data(), json.size());
+    if(JsonRead(reader, *obj) && reader.finish())
+    {
+        return true;
+    }
+    if(err)
+    {
+        *err = reader.errorMessage();
+    }
+    return false;
+}
+
+}   // kit_muduo
+
+#endif
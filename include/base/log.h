@@ -25,8 +25,10 @@
 #include "base/singleton.h"
 
 /********1、流式输出 ********/
+// 借助只执行一次的 for 先判断级别，被过滤时 << 右侧的表达式不会求值
 #define LOG_LEVEL_OUT(logger, level, module) \
-    kit_muduo::LogAttrWrap(std::make_shared<kit_muduo::LogAttr>(logger, level, logger->getName(), module, __FILE__, __LINE__, 0, kit_muduo::GetThreadTid(), kit_muduo::GetThreadPid(), kit_muduo::GetThreadName().c_str(), kit_muduo::GetTimeStampMs())).getSS()
+    for(auto _kit_ss_logger = logger; _kit_ss_logger && _kit_ss_logger->getLevel() <= level; _kit_ss_logger.reset()) \
+        kit_muduo::LogAttrWrap(std::make_shared<kit_muduo::LogAttr>(_kit_ss_logger, level, _kit_ss_logger->getName(), module, __FILE__, __LINE__, 0, kit_muduo::GetThreadTid(), kit_muduo::GetThreadPid(), kit_muduo::GetThreadName().c_str(), kit_muduo::GetTimeStampMs())).getSS()
 
 
 #define KIT_DEBUG(logger, module) LOG_LEVEL_OUT(logger, kit_muduo::LogLevel::DEBUG, module)
@@ -36,8 +38,15 @@
 #define KIT_FATAL(logger, module) LOG_LEVEL_OUT(logger, kit_muduo::LogLevel::FATAL, module)
 
 /********2、变参输出********/
+// 先判断级别，被过滤的日志不再构造 LogAttr、不做格式化
 #define LOG_LEVEL_FMT_OUT(logger, level, module, fmt, ...) \
-    kit_muduo::LogAttrWrap(std::make_shared<kit_muduo::LogAttr>(logger, level, logger->getName(), module, __FILE__, __LINE__, 0, kit_muduo::GetThreadTid(), kit_muduo::GetThreadPid(), kit_muduo::GetThreadName().c_str(), kit_muduo::GetTimeStampMs())).getAttr()->format(fmt, ##__VA_ARGS__ )
+    do { \
+        auto _kit_fmt_logger = logger; \
+        if(_kit_fmt_logger->getLevel() <= level) \
+        { \
+            kit_muduo::LogAttrWrap(std::make_shared<kit_muduo::LogAttr>(_kit_fmt_logger, level, _kit_fmt_logger->getName(), module, __FILE__, __LINE__, 0, kit_muduo::GetThreadTid(), kit_muduo::GetThreadPid(), kit_muduo::GetThreadName().c_str(), kit_muduo::GetTimeStampMs())).getAttr()->format(fmt, ##__VA_ARGS__ ); \
+        } \
+    } while(0)
 
 #define KIT_FMT_DEBUG(logger, module, fmt, ...) LOG_LEVEL_FMT_OUT(logger, kit_muduo::LogLevel::DEBUG, module, fmt, ##__VA_ARGS__)
 #define KIT_FMT_INFO(logger, module, fmt, ...) LOG_LEVEL_FMT_OUT(logger, kit_muduo::LogLevel::INFO, module, fmt, ##__VA_ARGS__)
@@ -19,11 +19,22 @@
 #include <unordered_map>
 #include <utility>
 #include <cassert>
+#include <cstdint>
 
 namespace kit_muduo {
 
+/// @brief 默认权重: 每个条目计 1，容量即条目数
+struct LruUnitWeigher
+{
+    template<class V>
+    size_t operator()(const V&) const { return 1; }
+};
 
-template<class K, class V>
+/**
+ * @brief LRU缓存
+ * @tparam Weigher 条目权重，容量为权重之和的上限(如按字节预算时返回条目字节数)
+ */
+template<class K, class V, class Weigher = LruUnitWeigher>
 class LruCache: Noncopyable
 {
 public:
@@ -31,14 +42,25 @@ public:
   
     using ListIterator = typename std::list<std::pair<K, V>>::iterator;
 
-    LruCache(size_t capacity = kDefaultCapacity)
+    LruCache(size_t capacity = kDefaultCapacity, Weigher weigher = Weigher())
         :capacity_(capacity)
+        ,weigher_(std::move(weigher))
     {
 
     }
 
-    void put(const K& key, const V& value)
+    /**
+     * @return 单个条目权重超过容量时不缓存(同名旧值一并移除)，返回 false
+     */
+    bool put(const K& key, const V& value)
     {
+        const size_t weight = weigher_(value);
+        if(weight > capacity_)
+        {
+            erase(key);
+            return false;
+        }
+
         std::unique_lock<std::shared_mutex> lock(rw_mutex_);
 
         ListIterator list_it;
@@ -46,7 +68,8 @@ public:
         if(it != map_.end())
         {
             // 更新当前值
-            it->second->second = std::move(value);
+            weight_ -= weigher_(it->second->second);
+            it->second->second = value;
             list_it = it->second;
         }
         else 
@@ -55,6 +78,7 @@ public:
             map_[key] = list_.begin();
             list_it = list_.begin();
         }
+        weight_ += weight;
 
         // 先把队列中的节点提升一次
         promoteUnLocked();
@@ -62,11 +86,12 @@ public:
         //把当前的操作节点提升
         list_.splice(list_.begin(), list_, list_it);
 
-        // 淘汰删除一定在最后
-        if(map_.size() > capacity_)
+        // 淘汰删除一定在最后，当前节点在队头且不超过容量，不会被淘汰
+        while(weight_ > capacity_)
         {
             eliminateUnLocked();
         }
+        return true;
     }
 
     bool tryGet(const K& key, V& out_value)
@@ -112,6 +137,7 @@ public:
             return;
         }
 
+        weight_ -= weigher_(it->second->second);
         list_.erase(it->second);
         map_.erase(it);
         lock.unlock();
@@ -123,6 +149,31 @@ public:
         }
     }
 
+    /**
+     * @brief 删除满足 pred(key, value) 的全部条目
+     * @return 删除的条目数
+     */
+    template<class Pred>
+    size_t eraseIf(Pred pred)
+    {
+        std::unique_lock<std::shared_mutex> lock(rw_mutex_);
+        size_t removed = 0;
+        for(auto it = list_.begin(); it != list_.end(); )
+        {
+            if(!pred(it->first, it->second))
+            {
+                ++it;
+                continue;
+            }
+            weight_ -= weigher_(it->second);
+            map_.erase(it->first);
+            it = list_.erase(it);
+            ++removed;
+        }
+        // 延迟提升队列中残留的key在提升时会因查不到而跳过
+        return removed;
+    }
+
     bool head(V &out_value)
     {
         std::shared_lock<std::shared_mutex> lock(rw_mutex_);
@@ -163,6 +214,7 @@ public:
         std::unique_lock<std::shared_mutex> lock(rw_mutex_);
         list_.clear();
         map_.clear();
+        weight_ = 0;
         {
             std::lock_guard<std::mutex> lock2(pending_mutex_);
             pending_promotions_.clear();
@@ -189,15 +241,32 @@ public:
         return capacity_; 
     }
 
+    /// @brief 当前条目权重之和
+    size_t weight() const
+    {
+        std::shared_lock<std::shared_mutex> lock(rw_mutex_);
+        return weight_;
+    }
+
+    /// @brief 累计因超出容量被淘汰的条目数
+    uint64_t evictions() const
+    {
+        std::shared_lock<std::shared_mutex> lock(rw_mutex_);
+        return evictions_;
+    }
+
 
 
 private:
     void eliminateUnLocked()
     {
         auto it = list_.rbegin();
+        weight_ -= weigher_(it->second);
         auto n = map_.erase(it->first);
         assert(n == 1);
+        (void)n;
         list_.pop_back();
+        ++evictions_;
         assert(map_.size() == list_.size());
     }
 
@@ -230,6 +299,9 @@ private:
     static constexpr size_t kDefaultCapacity = 32;
 
     size_t capacity_;
+    Weigher weigher_;
+    size_t weight_{0};
+    uint64_t evictions_{0};
 
     std::unordered_map<K, ListIterator> map_;
     std::list<Node> list_;
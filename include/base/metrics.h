@@ -0,0 +1,204 @@
+/**
+ * @file metrics.h
+ * @brief 进程内指标: 计数器/仪表/延迟直方图，按线程分片无锁记录，采集时汇总
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 19:05:12
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_METRICS_H__
+#define __KIT_METRICS_H__
+
+#include "base/noncopyable.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace kit_muduo::metrics {
+
+/// @brief 单调时钟(ns)，用于计算耗时
+int64_t NowNs();
+
+/// @brief 每个指标的最大分片数，线程数超过时多个线程共用一个分片(仍是原子操作)
+constexpr size_t kMaxShards = 64;
+
+/// @brief 当前线程的分片下标，线程首次记录时分配
+size_t ThreadShard();
+
+enum class MetricType: uint8_t
+{
+    kCounter,
+    kGauge,
+    kHistogram,
+};
+
+/**
+ * @brief 按线程分片的整数值，每个分片独占一条缓存行
+ */
+class ShardedValue: Noncopyable
+{
+public:
+    void add(int64_t n) { _cells[ThreadShard()].value.fetch_add(n, std::memory_order_relaxed); }
+
+    /// @brief 汇总全部分片
+    int64_t value() const;
+
+protected:
+    ShardedValue() = default;
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<int64_t> value{0};
+    };
+    std::array<Cell, kMaxShards> _cells;
+};
+
+/**
+ * @brief 单调递增计数器
+ */
+class Counter: public ShardedValue
+{
+public:
+    void inc(int64_t n = 1) { add(n); }
+
+private:
+    friend class MetricsRegistry;
+    Counter() = default;
+};
+
+/**
+ * @brief 可增可减的仪表(如活跃连接数、队列深度)
+ * @note 只支持增量修改，采集值为全部增量之和
+ */
+class Gauge: public ShardedValue
+{
+public:
+    void inc(int64_t n = 1) { add(n); }
+    void dec(int64_t n = 1) { add(-n); }
+
+private:
+    friend class MetricsRegistry;
+    Gauge() = default;
+};
+
+/**
+ * @brief HDR风格的对数-线性直方图
+ * @note 小于 2^kSubBucketBits 的值精确记录，之上每个2的幂区间再等分为
+ *       2^kSubBucketBits 个桶，相对误差不超过 1/16；超过 2^kMaxValueBits-1 的值截断。
+ *       分片在线程首次记录时才分配
+ */
+class Histogram: Noncopyable
+{
+public:
+    static constexpr int32_t kSubBucketBits = 4;
+    static constexpr int32_t kMaxValueBits = 40;
+    static constexpr size_t kSubBucketCount = size_t(1) << kSubBucketBits;
+    static constexpr size_t kBucketCount = (kMaxValueBits - kSubBucketBits + 1) * kSubBucketCount;
+    static constexpr int64_t kMaxValue = (int64_t(1) << kMaxValueBits) - 1;
+
+    struct Snapshot {
+        uint64_t count{0};
+        int64_t sum{0};
+        int64_t max{0};
+        /// @brief 各桶计数，下标含义见 BucketLowerBound/BucketUpperBound
+        std::vector<uint64_t> buckets;
+
+        double mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+
+        /**
+         * @brief 分位值(所在桶的上界，不超过 max)
+         * @param[in] q 0~1，如 0.99
+         */
+        int64_t percentile(double q) const;
+    };
+
+    ~Histogram();
+
+    /// @brief 记录一个值，负数按 0 处理
+    void record(int64_t value);
+
+    Snapshot snapshot() const;
+
+    static size_t BucketIndex(int64_t value);
+    static int64_t BucketLowerBound(size_t index);
+    static int64_t BucketUpperBound(size_t index);
+
+private:
+    friend class MetricsRegistry;
+    Histogram();
+
+    struct Shard {
+        std::atomic<uint64_t> buckets[kBucketCount];
+        std::atomic<int64_t> sum{0};
+        std::atomic<int64_t> max{0};
+
+        Shard();
+    };
+
+    Shard& shard();
+
+private:
+    std::array<std::atomic<Shard*>, kMaxShards> _shards;
+};
+
+/**
+ * @brief 指标注册表(进程单例)
+ * @note 注册加锁且返回的引用永久有效，热路径应缓存引用后直接记录；
+ *       同名重复注册返回同一个指标
+ */
+class MetricsRegistry: Noncopyable
+{
+public:
+    struct Sample {
+        std::string name;
+        std::string help;
+        MetricType type{MetricType::kCounter};
+        /// @brief 计数器/仪表的值
+        int64_t value{0};
+        /// @brief 直方图的汇总
+        Histogram::Snapshot histogram;
+    };
+
+    static MetricsRegistry& Instance();
+
+    Counter& counter(const std::string &name, const std::string &help);
+    Gauge& gauge(const std::string &name, const std::string &help);
+    Histogram& histogram(const std::string &name, const std::string &help);
+
+    /// @brief 汇总全部指标，按名称排序
+    std::vector<Sample> snapshot() const;
+
+private:
+    struct Entry {
+        MetricType type{MetricType::kCounter};
+        std::string help;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    /// @brief 查找或创建，类型冲突时返回空，调用方需持有 _mutex
+    Entry* findOrCreateUnLocked(const std::string &name, const std::string &help, MetricType type);
+
+private:
+    mutable std::mutex _mutex;
+    std::map<std::string, Entry> _entries;
+    /// @brief 与已有指标类型冲突的注册，单独保存不参与导出，保证返回的引用有效
+    std::vector<Entry> _orphans;
+};
+
+/**
+ * @brief 按 Prometheus 文本格式(0.0.4)输出指标
+ * @note 直方图折算到固定的 1/2.5/5 x 10^n (100 ~ 1e10) 累计桶，细桶按上界归入，
+ *       边界附近的计数偏差不超过 1/16
+ */
+std::string FormatPrometheus(const std::vector<MetricsRegistry::Sample> &samples);
+
+}   // kit_muduo::metrics
+#endif
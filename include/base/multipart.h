@@ -0,0 +1,223 @@
+/**
+ * @file multipart.h
+ * @brief 增量 multipart/form-data 解析: 分块输入、part 内容视图、大 part 落盘
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 14:05:18
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_MULTIPART_H__
+#define __KIT_MULTIPART_H__
+
+#include "base/noncopyable.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace kit_muduo {
+
+/**
+ * @brief 增量 multipart 解析器(RFC 7578 / 2046)
+ *
+ * 可按任意大小分块 feed，part 头部解析完成、内容片段、part 结束分别回调。
+ * 内容片段直接指向输入块，不做拷贝；分隔符 "\n--boundary" 用 memmem(Horspool 变体)查找，
+ * 块末尾可能是分隔符开头的几个字节留到下一块再判断。
+ * 与 MultiFormParser 一致: 兼容只有 LF 的换行，分隔符后的字符不合法时视为内容中的误匹配。
+ */
+class MultipartReader: Noncopyable
+{
+public:
+    /// @brief part 头部，视图指向解析器内部缓冲，到下一个 part 开始前有效
+    struct PartInfo {
+        std::string_view name;
+        std::string_view filename;
+        std::string_view contentType;
+        /// @brief 全部头部(原始名称与值)
+        std::vector<std::pair<std::string_view, std::string_view>> headers;
+
+        /// @brief 按名称(大小写不敏感)查找头部，不存在返回空视图
+        std::string_view header(std::string_view key) const;
+        bool isFile() const { return !filename.empty(); }
+    };
+
+    /// @brief 回调返回 false 中止解析
+    using PartBeginCallBack = std::function<bool(const PartInfo&)>;
+    using PartDataCallBack = std::function<bool(const char*, size_t)>;
+    using PartEndCallBack = std::function<bool()>;
+
+    /// @brief 单个 part 头部的默认长度上限
+    static constexpr size_t kDefaultMaxHeaderBytes = 16 * 1024;
+
+    explicit MultipartReader(std::string_view boundary, size_t maxHeaderBytes = kDefaultMaxHeaderBytes);
+
+    /// @brief 从 Content-Type 中取 boundary 参数，不存在返回空串
+    static std::string BoundaryOf(std::string_view contentType);
+
+    void setPartBeginCallback(PartBeginCallBack cb) { _onPartBegin = std::move(cb); }
+    void setPartDataCallback(PartDataCallBack cb) { _onPartData = std::move(cb); }
+    void setPartEndCallback(PartEndCallBack cb) { _onPartEnd = std::move(cb); }
+
+    /**
+     * @brief 输入一块数据
+     * @return 格式错误或回调中止时返回 false，之后的输入都被忽略
+     */
+    bool feed(const char *data, size_t len);
+
+    /**
+     * @brief 输入结束，未读到结束分隔符时失败
+     */
+    bool finish();
+
+    bool ok() const { return nullptr == _error; }
+    const char* error() const { return _error; }
+    /// @brief 已读到结束分隔符
+    bool done() const { return kEpilogue == _state; }
+    /// @brief 已开始的 part 数
+    size_t partCount() const { return _partCount; }
+
+private:
+    enum State
+    {
+        /// @brief 查找分隔符(前导内容或 part 内容)
+        kScan,
+        /// @brief 分隔符之后: 可选空白，然后 "--" 或换行
+        kSuffix,
+        kSuffixDash,
+        kSuffixLF,
+        kHeaders,
+        /// @brief 结束分隔符之后的内容全部忽略
+        kEpilogue,
+    };
+
+    bool fail(const char *msg);
+    const char* find(const char *begin, const char *end) const;
+    bool validSuffix(char c) const;
+    /// @brief [begin, end) 末尾可能是分隔符开头(及其前的 '\r')的字节数
+    size_t holdLength(const char *begin, const char *end) const;
+
+    const char* scan(const char *p, const char *end);
+    const char* scanCarry(const char *p, const char *end);
+    const char* readHeaders(const char *p, const char *end);
+    bool parseHeaders();
+    void emit(const char *data, size_t len);
+    void onDelimiter();
+
+private:
+    /// @brief "\n--boundary"
+    std::string _needle;
+    size_t _maxHeaderBytes;
+
+    State _state{kScan};
+    bool _inPart{false};
+    const char *_error{nullptr};
+    size_t _partCount{0};
+
+    /// @brief 上一块末尾尚不能确定是否属于分隔符的字节
+    std::string _carry;
+    std::string _window;
+
+    std::string _header;
+    size_t _lineStart{0};
+    PartInfo _info;
+
+    PartBeginCallBack _onPartBegin;
+    PartDataCallBack _onPartData;
+    PartEndCallBack _onPartEnd;
+};
+
+/**
+ * @brief 收集 multipart 表单的全部 part
+ *
+ * - parse(): Body 已完整在内存中，part 内容是输入的视图，不复制
+ * - begin()/feed()/finish(): 分块输入(如 HttpBodySink)，part 内容复制到内存，
+ *   超过 spillBytes 的 part 转存到临时文件，内存中最多保留 spillBytes
+ * 临时文件在表单析构时删除，需要保留时用 moveFile() 取走。
+ */
+class MultipartForm: Noncopyable
+{
+public:
+    struct Config {
+        /// @brief 分块输入时单个 part 超过该大小即落盘，0 表示始终在内存中
+        size_t spillBytes{1024 * 1024};
+        /// @brief 临时文件目录
+        std::string tempDir{"/tmp"};
+        size_t maxParts{1024};
+        size_t maxHeaderBytes{MultipartReader::kDefaultMaxHeaderBytes};
+    };
+
+    struct Part {
+        std::string name;
+        std::string filename;
+        std::string contentType;
+        /// @brief name/filename/Content-Type 之外的头部
+        std::vector<std::pair<std::string, std::string>> headers;
+        uint64_t size{0};
+        /// @brief 落盘后的临时文件路径，空表示内容在内存中
+        std::string file;
+
+        /// @brief 内存中的内容，落盘的 part 为空
+        std::string_view data() const { return _borrowed ? _view : std::string_view(_owned); }
+        bool isFile() const { return !filename.empty(); }
+        bool spilled() const { return !file.empty(); }
+
+    private:
+        friend class MultipartForm;
+        std::string_view _view;
+        std::string _owned;
+        bool _borrowed{false};
+        int32_t _fd{-1};
+    };
+
+    MultipartForm();
+    explicit MultipartForm(Config config);
+    ~MultipartForm();
+
+    /**
+     * @brief 一次性解析完整 Body，part 内容直接引用 data
+     * @note data 需在表单使用期间保持有效
+     */
+    bool parse(const char *data, size_t len, std::string_view contentType);
+
+    /// @brief 开始分块输入，Content-Type 中没有 boundary 时失败
+    bool begin(std::string_view contentType);
+    bool feed(const char *data, size_t len);
+    bool finish();
+
+    const std::vector<Part>& parts() const { return _parts; }
+    /// @brief 第一个名为 name 的 part，不存在返回空
+    const Part* find(std::string_view name) const;
+
+    /**
+     * @brief 把落盘的 part 重命名到 path，之后不再自动删除
+     */
+    bool moveFile(size_t index, const std::string &path);
+
+    const char* error() const { return _error; }
+    const Config& config() const { return _config; }
+
+private:
+    bool start(std::string_view contentType, bool borrow);
+    bool fail(const char *msg);
+    bool onPartBegin(const MultipartReader::PartInfo &info);
+    bool onPartData(const char *data, size_t len);
+    bool onPartEnd();
+    bool spill(Part &part);
+    void closePartFile(Part &part);
+
+private:
+    const Config _config;
+    std::unique_ptr<MultipartReader> _reader;
+    std::vector<Part> _parts;
+    /// @brief parse() 时内容引用输入
+    bool _borrow{false};
+    const char *_error{nullptr};
+};
+
+}   // kit_muduo
+
+#endif
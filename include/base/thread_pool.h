@@ -207,8 +207,7 @@ public:
         }
 
         // taskQue_.push(ptask);
-        task_que_.emplace([task](){ (*task)(); });
-        ++cur_task_count_;
+        pushTaskUnLocked([task](){ (*task)(); });
         lock.unlock();
         notEmpty_.notify_one();
 
@@ -278,6 +277,13 @@ private:
             && cur_task_count_ == 0;
     }
 
+    using Task = std::function<void()>;
+
+    /**
+     * @brief 任务入队并计数，调用方需持有 task_que_mutex_
+     */
+    void pushTaskUnLocked(Task task);
+
     /**
      * @brief 增加线程
      */
@@ -325,9 +331,14 @@ private:
     int32_t thread_max_idle_interval_{0};
 
 
-    using Task = std::function<void()>;
+    struct QueuedTask
+    {
+        Task task;
+        /// @brief 入队时间(ns)，用于统计排队耗时
+        int64_t enqueue_ns{0};
+    };
     /// @brief 任务队列
-    std::queue<Task> task_que_;
+    std::queue<QueuedTask> task_que_;
     /// @brief 当前未处理任务数量
     std::atomic_int32_t cur_task_count_{0};
     /// @brief 任务队列数量上限
@@ -0,0 +1,92 @@
+/**
+ * @file trace.h
+ * @brief 轻量请求追踪: 按采样率记录耗时区间到线程本地环形缓冲，按需导出 Chrome trace-event JSON
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 20:30:18
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_TRACE_H__
+#define __KIT_TRACE_H__
+
+#include "base/noncopyable.h"
+#include "base/metrics.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace kit_muduo::trace {
+
+namespace detail {
+/// @brief 采样阈值，0 表示关闭追踪
+extern std::atomic<uint32_t> g_sampleThreshold;
+}
+
+/**
+ * @brief 设置采样率
+ * @param[in] rate 0~1，0 关闭追踪，1 全部采样
+ */
+void SetSampleRate(double rate);
+double SampleRate();
+
+/// @brief 追踪是否开启，关闭时只有这一次原子读
+inline bool Enabled() { return 0 != detail::g_sampleThreshold.load(std::memory_order_relaxed); }
+
+/**
+ * @brief 按采样率决定是否追踪一次请求
+ * @return 采中时返回非0的追踪id，否则返回0
+ */
+uint64_t Sample();
+
+/**
+ * @brief 设置每个线程环形缓冲的容量(事件数)，只影响之后首次记录的线程
+ */
+void SetRingCapacity(size_t capacity);
+
+/**
+ * @brief 记录一个已结束的区间 [beginNs, endNs)，时间取 metrics::NowNs() 的单调时钟
+ * @note traceId 为0时直接返回；name 需为静态字符串，detail 可为空
+ */
+void Record(uint64_t traceId, const char *name, int64_t beginNs, int64_t endNs, const std::string &detail = "");
+
+/**
+ * @brief 导出全部线程缓冲中的事件，Chrome trace-event JSON 格式(chrome://tracing、Perfetto 可直接打开)
+ */
+std::string DumpChromeTrace();
+
+/// @brief 清空全部线程缓冲并释放已退出线程的缓冲
+void Clear();
+
+/**
+ * @brief 作用域区间，析构时记录；traceId 为0时不做任何事
+ */
+class Span: Noncopyable
+{
+public:
+    Span(uint64_t traceId, const char *name)
+        :_traceId(traceId)
+        ,_name(name)
+    {
+        if(_traceId)
+        {
+            _beginNs = metrics::NowNs();
+        }
+    }
+
+    ~Span()
+    {
+        if(_traceId)
+        {
+            Record(_traceId, _name, _beginNs, metrics::NowNs());
+        }
+    }
+
+private:
+    uint64_t _traceId;
+    const char *_name;
+    int64_t _beginNs{0};
+};
+
+}   // kit_muduo::trace
+#endif
@@ -68,6 +68,12 @@ public:
 
     void send(const void* buf, size_t len, const InetAddress &peer_addr);
 
+    /**
+     * @brief 以共享缓冲 [offset, end) 作为一个报文发送，跨线程或需排队时只引用缓冲，不拷贝
+     * @note 同一份缓冲发给多个对端(如RTP扇出)时使用
+     */
+    void send(const SharedBuffer &message, size_t offset, const InetAddress &peer_addr);
+
     /**
      * @brief 平滑关闭。若还有待发送报文，等待写完后注销 Channel。
      */
@@ -82,6 +88,20 @@ public:
     static const int32_t kMTU = 1500;
 
 private:
+    /**
+     * @brief 待异步发送的单条UDP报文，shared 非空时报文为 shared 的 [offset, end)
+     */
+    struct PendingDatagram
+    {
+        std::vector<uint8_t> payload;
+        InetAddress peer_addr;
+        SharedBuffer shared;
+        size_t offset{0};
+
+        const void* data() const { return shared ? static_cast<const void*>(shared->data() + offset) : payload.data(); }
+        size_t size() const { return shared ? shared->size() - offset : payload.size(); }
+    };
+
     AsyncUdpDatagram(EventLoop *base_loop, const std::string& name, int32_t sockfd);
 
     static void Destroy(AsyncUdpDatagram *datagram);
@@ -99,9 +119,11 @@ private:
      */
     void notifyError(int32_t err, const InetAddress &peer_addr);
 
-    ssize_t sendDatagramInLoop(const std::vector<uint8_t>& message, const InetAddress &peer_addr);
+    ssize_t sendDatagramInLoop(const PendingDatagram &datagram);
+
+    void sendInLoop(PendingDatagram datagram);
 
-    void sendInLoop(const std::vector<uint8_t>& message, const InetAddress &peer_addr);
+    void queueSend(PendingDatagram datagram);
 
     void closeInLoop();
 
@@ -112,15 +134,6 @@ private:
     void queueWriteCompleteCallback();
 
 private:
-    /**
-     * @brief 待异步发送的单条UDP报文
-     */
-    struct PendingDatagram
-    {
-        std::vector<uint8_t> payload;
-        InetAddress peer_addr;
-    };
-
     EventLoop *base_loop_;
     UdpDatagram datagram_;
     std::unique_ptr<Channel> channel_;
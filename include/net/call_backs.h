@@ -12,6 +12,7 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace kit_muduo {
@@ -39,6 +40,8 @@ using TcpConnectionPtr = std::shared_ptr<TcpConnection>;
 using UdpDatagramPtr = std::shared_ptr<UdpDatagram>;
 using AsyncUdpDatagramPtr = std::shared_ptr<AsyncUdpDatagram>;
 using ContextPtr = std::shared_ptr<void>;
+/// @brief 只读共享发送缓冲，多个连接/多次响应可引用同一份数据
+using SharedBuffer = std::shared_ptr<const std::string>;
 
 /**********HTTP************/
 using HttpServerPtr = std::shared_ptr<http::HttpServer>;
@@ -0,0 +1,105 @@
+/**
+ * @file connector.h
+ * @brief 客户端主动连接器: 非阻塞 connect、失败退避重试、自连接检测
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 16:20:45
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_CONNECTOR_H__
+#define __KIT_CONNECTOR_H__
+
+#include "base/noncopyable.h"
+#include "net/call_backs.h"
+#include "net/inet_address.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace kit_muduo {
+
+class EventLoop;
+class Channel;
+
+/**
+ * @brief 非阻塞 connect
+ *
+ * connect 返回 EINPROGRESS 时监听可写事件，可写后以 SO_ERROR 判断结果。
+ * 成功时把已连接的 fd 交给 NewConnectionCb(由回调方封装为 TcpConnection)，失败时调用 ErrorCb。
+ * 开启重试后，可重试的错误(拒绝连接、地址不可用、网络不可达等)按指数退避加随机抖动，
+ * 由循环定时器重新发起，不再调用 ErrorCb；参数错误类的失败仍直接回调。
+ * 连到本机未监听端口时，内核可能把临时端口分配成目标端口而"连上自己"，按连接被拒绝处理。
+ * 所有状态只在所属循环线程中修改，start/stop 可在任意线程调用。
+ */
+class Connector: Noncopyable, public std::enable_shared_from_this<Connector>
+{
+public:
+    using Ptr = std::shared_ptr<Connector>;
+    using NewConnectionCb = std::function<void(int32_t sockfd)>;
+    /// @brief 连接失败，参数为 errno
+    using ErrorCb = std::function<void(int32_t err)>;
+
+    /// @brief 重试退避参数
+    struct Backoff {
+        int64_t initialDelayMs{500};
+        int64_t maxDelayMs{30000};
+        /// @brief 每次延迟在 [1-jitter, 1+jitter] 倍之间随机，避免大量客户端同时重连
+        double jitter{0.2};
+    };
+
+    Connector(EventLoop *loop, const InetAddress &serverAddr);
+    ~Connector();
+
+    void setNewConnectionCallback(NewConnectionCb cb) { _newConnectionCallback = std::move(cb); }
+    void setErrorCallback(ErrorCb cb) { _errorCallback = std::move(cb); }
+
+    /// @brief 开启失败重试，需在 start 前设置
+    void setRetry(bool on) { _retry = on; }
+    void setBackoff(const Backoff &backoff) { _backoff = backoff; _retryDelayMs = backoff.initialDelayMs; }
+
+    const InetAddress& serverAddr() const { return _serverAddr; }
+
+    void start();
+    /// @brief 放弃正在进行的连接和等待中的重试，之后不再回调
+    void stop();
+    /// @brief 连接断开后重新开始，退避延迟回到初始值，需在循环线程调用
+    void restart();
+
+    /**
+     * @brief 在 delayMs 上叠加 ±jitter 比例的随机抖动
+     */
+    static int64_t JitterDelay(int64_t delayMs, double jitter);
+
+private:
+    enum State { kDisconnected, kConnecting, kConnected };
+
+    void startInLoop();
+    void stopInLoop();
+    void connect();
+    void connecting(int32_t sockfd);
+    void handleWrite();
+    void handleError();
+    void fail(int32_t sockfd, int32_t err);
+    /// @brief 按当前退避延迟安排下一次连接
+    void retry();
+    /// @brief 摘除 channel 并返回其 fd，channel 本身延后到下一轮释放
+    int32_t removeAndResetChannel();
+
+private:
+    EventLoop *_loop;
+    const InetAddress _serverAddr;
+    std::atomic_bool _connect{false};
+    bool _retry{false};
+    State _state{kDisconnected};
+    Backoff _backoff;
+    int64_t _retryDelayMs{Backoff().initialDelayMs};
+    TimerPtr _retryTimer;
+    std::unique_ptr<Channel> _channel;
+    NewConnectionCb _newConnectionCallback;
+    ErrorCb _errorCallback;
+};
+
+}   // kit_muduo
+
+#endif
@@ -32,6 +32,17 @@ class EventLoop: Noncopyable
 public:
     using Func = std::function<void()>;
 
+    /// @brief 事件循环状态快照
+    struct Stats {
+        pid_t thread_id{0};
+        bool looping{false};
+        /// @brief 已注册的channel数量(含wakeup与定时器fd)
+        size_t channels{0};
+        size_t timers{0};
+        /// @brief 待执行的回调数量
+        size_t pending_funcs{0};
+    };
+
     EventLoop();
     ~EventLoop();
 
@@ -91,6 +102,11 @@ public:
 
     bool isInLoopThread() const { return _threadId == GetThreadPid(); }
 
+    /**
+     * @brief 状态快照，需在loop线程调用(跨线程请通过 runInLoop 采集)
+     */
+    Stats stats() const;
+
 private:
     /**
      * @brief 处理wakeup读事件
@@ -0,0 +1,167 @@
+/**
+ * @file hpack.h
+ * @brief HPACK(RFC 7541): HTTP/2 头部压缩，静态表/动态表与 Huffman 编解码
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 01:05:18
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HPACK_H__
+#define __KIT_HPACK_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kit_muduo::http {
+
+struct HpackHeader
+{
+    std::string name;
+    std::string value;
+    /// @brief 编码为 never-indexed，中间代理也不得索引(凭据等)
+    bool sensitive{false};
+};
+using HpackHeaderList = std::vector<HpackHeader>;
+
+/// @brief 追加 Huffman 编码(末尾以 EOS 前缀的1补齐)
+void HuffmanEncode(std::string_view in, std::string *out);
+/// @brief Huffman 编码后的字节数
+size_t HuffmanEncodedLength(std::string_view in);
+/**
+ * @brief 追加 Huffman 解码结果
+ * @return 含 EOS、填充超过7位或填充不全为1时返回 false
+ */
+bool HuffmanDecode(std::string_view in, std::string *out);
+
+/**
+ * @brief 动态表，索引从 1 开始且 1 为最新插入的条目(调用方需先减去静态表长度)
+ */
+class HpackDynamicTable
+{
+public:
+    explicit HpackDynamicTable(size_t maxSize) :_maxSize(maxSize) {}
+
+    /// @brief 插入，必要时淘汰最旧的条目；条目本身超过上限时清空表
+    void add(std::string name, std::string value);
+    const HpackHeader* get(size_t index) const;
+    void setMaxSize(size_t maxSize);
+
+    size_t size() const { return _size; }
+    size_t maxSize() const { return _maxSize; }
+    size_t count() const { return _entries.size(); }
+
+    /**
+     * @brief 查找，name_only 置为只匹配了名称的最小索引
+     * @return 名称与值都匹配的索引，没有返回0
+     */
+    size_t find(std::string_view name, std::string_view value, size_t *nameOnly) const;
+
+    /// @brief 条目占用的表大小(RFC 7541 4.1)
+    static size_t EntrySize(size_t nameLen, size_t valueLen) { return nameLen + valueLen + 32; }
+
+private:
+    void evict(size_t limit);
+
+private:
+    /// @brief 最新的在前
+    std::deque<HpackHeader> _entries;
+    size_t _size{0};
+    size_t _maxSize;
+};
+
+/**
+ * @brief 解码器，每个连接一个，所有头部块必须按收到的顺序解码
+ */
+class HpackDecoder
+{
+public:
+    enum class Result {
+        kOk,
+        /// @brief 头部列表超过 maxHeaderListSize，动态表已同步，可只拒绝该流
+        kTooLarge,
+        /// @brief 压缩错误，连接不可再用(COMPRESSION_ERROR)
+        kError,
+    };
+
+    /**
+     * @param[in] maxTableSize 本端 SETTINGS_HEADER_TABLE_SIZE，对端的表大小更新不得超过它
+     * @param[in] maxHeaderListSize 解码后头部列表上限(名称+值+32 之和)
+     */
+    explicit HpackDecoder(size_t maxTableSize = 4096, size_t maxHeaderListSize = 64 * 1024);
+
+    Result decode(const uint8_t *data, size_t len, HpackHeaderList *headers);
+    Result decode(std::string_view block, HpackHeaderList *headers)
+    { return decode(reinterpret_cast<const uint8_t*>(block.data()), block.size(), headers); }
+
+    const HpackDynamicTable& table() const { return _table; }
+
+private:
+    const HpackHeader* lookup(size_t index) const;
+
+private:
+    const size_t _maxTableSize;
+    const size_t _maxHeaderListSize;
+    HpackDynamicTable _table;
+};
+
+/**
+ * @brief 编码器，每个连接一个，头部块必须按编码的顺序发出
+ * @note 索引策略: 完全匹配用索引；否则名称走索引、值按字面量，且通常会插入动态表；
+ *       sensitive 或短凭据类头部用 never-indexed；取值每次都变的头部(content-length、:path 等)
+ *       不插入动态表以免冲掉有用的条目
+ */
+class HpackEncoder
+{
+public:
+    explicit HpackEncoder(size_t maxTableSize = 4096);
+
+    /**
+     * @brief 对端 SETTINGS_HEADER_TABLE_SIZE 变化，下一个头部块开头会带表大小更新
+     */
+    void setMaxTableSize(size_t maxSize);
+
+    /// @brief 字面量是否尝试 Huffman(更短时才使用)，默认开启
+    void setHuffman(bool on) { _huffman = on; }
+
+    /// @brief 追加编码结果
+    void encode(const HpackHeaderList &headers, std::string *out);
+    /// @brief 编码单个头部
+    void encode(std::string_view name, std::string_view value, bool sensitive, std::string *out);
+
+    const HpackDynamicTable& table() const { return _table; }
+
+private:
+    void flushTableSizeUpdate(std::string *out);
+    void appendString(std::string_view str, std::string *out) const;
+
+private:
+    HpackDynamicTable _table;
+    bool _huffman{true};
+    /// @brief 待通知的表大小更新，期间出现过的最小值需先发出
+    bool _sizeUpdatePending{false};
+    size_t _minPendingSize{0};
+};
+
+/**
+ * @brief 静态表(索引 1..61)
+ */
+const HpackHeader* HpackStaticEntry(size_t index);
+constexpr size_t kHpackStaticTableSize = 61;
+
+/**
+ * @brief 整数编码(RFC 7541 5.1)
+ * @param[in] prefixBits 首字节可用的低位数(1~8)
+ * @param[in] firstByteFlags 首字节高位的标志位
+ */
+void HpackEncodeInteger(uint64_t value, int prefixBits, uint8_t firstByteFlags, std::string *out);
+/**
+ * @brief 整数解码，成功时前移 *pos
+ */
+bool HpackDecodeInteger(const uint8_t *data, size_t len, size_t *pos, int prefixBits, uint64_t *value);
+
+}   // kit_muduo::http
+#endif
@@ -0,0 +1,310 @@
+/**
+ * @file http2.h
+ * @brief HTTP/2 明文(h2c): 帧编解码、流多路复用与流量控制
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 01:48:36
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP2_H__
+#define __KIT_HTTP2_H__
+
+#include "base/noncopyable.h"
+#include "net/call_backs.h"
+#include "net/http/hpack.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace kit_muduo {
+
+class Buffer;
+class EventLoop;
+
+namespace http {
+
+class HttpResponse;
+
+/// @brief 客户端连接前言
+constexpr std::string_view kHttp2ClientPreface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t kHttp2FrameHeaderSize = 9;
+/// @brief 协议规定的初始窗口与最小帧长
+constexpr uint32_t kHttp2DefaultWindowSize = 65535;
+constexpr uint32_t kHttp2DefaultMaxFrameSize = 16384;
+constexpr uint32_t kHttp2MaxWindowSize = 0x7fffffff;
+
+enum class Http2FrameType: uint8_t {
+    kData = 0x0,
+    kHeaders = 0x1,
+    kPriority = 0x2,
+    kRstStream = 0x3,
+    kSettings = 0x4,
+    kPushPromise = 0x5,
+    kPing = 0x6,
+    kGoAway = 0x7,
+    kWindowUpdate = 0x8,
+    kContinuation = 0x9,
+};
+
+namespace Http2Flags {
+    constexpr uint8_t kEndStream = 0x1;
+    constexpr uint8_t kAck = 0x1;
+    constexpr uint8_t kEndHeaders = 0x4;
+    constexpr uint8_t kPadded = 0x8;
+    constexpr uint8_t kPriority = 0x20;
+}
+
+enum class Http2Setting: uint16_t {
+    kHeaderTableSize = 0x1,
+    kEnablePush = 0x2,
+    kMaxConcurrentStreams = 0x3,
+    kInitialWindowSize = 0x4,
+    kMaxFrameSize = 0x5,
+    kMaxHeaderListSize = 0x6,
+};
+
+enum class Http2ErrorCode: uint32_t {
+    kNoError = 0x0,
+    kProtocolError = 0x1,
+    kInternalError = 0x2,
+    kFlowControlError = 0x3,
+    kSettingsTimeout = 0x4,
+    kStreamClosed = 0x5,
+    kFrameSizeError = 0x6,
+    kRefusedStream = 0x7,
+    kCancel = 0x8,
+    kCompressionError = 0x9,
+    kConnectError = 0xa,
+    kEnhanceYourCalm = 0xb,
+    kInadequateSecurity = 0xc,
+    kHttp11Required = 0xd,
+};
+
+const char* Http2ErrorCodeName(Http2ErrorCode code);
+
+struct Http2FrameHeader
+{
+    uint32_t length{0};
+    Http2FrameType type{Http2FrameType::kData};
+    uint8_t flags{0};
+    uint32_t streamId{0};
+};
+
+/**
+ * @brief 解析9字节帧头(忽略流id的保留位)，调用方保证至少有 kHttp2FrameHeaderSize 字节
+ */
+Http2FrameHeader ParseHttp2FrameHeader(const char *data);
+
+/// @brief 追加一个完整的帧
+void AppendHttp2Frame(std::string *out, Http2FrameType type, uint8_t flags, uint32_t streamId, std::string_view payload);
+void AppendHttp2Settings(std::string *out, const std::vector<std::pair<Http2Setting, uint32_t>> &settings);
+void AppendHttp2SettingsAck(std::string *out);
+void AppendHttp2WindowUpdate(std::string *out, uint32_t streamId, uint32_t increment);
+void AppendHttp2RstStream(std::string *out, uint32_t streamId, Http2ErrorCode code);
+void AppendHttp2GoAway(std::string *out, uint32_t lastStreamId, Http2ErrorCode code, std::string_view debug = {});
+/**
+ * @brief 追加 HEADERS 帧，头部块超过 maxFrameSize 时拆出 CONTINUATION
+ */
+void AppendHttp2Headers(std::string *out, uint32_t streamId, std::string_view block, bool endStream, uint32_t maxFrameSize);
+
+/**
+ * @brief 一个 h2 连接的会话(服务端)，除 submitResponse 外都只在连接所属IO线程调用
+ *
+ * 建立: 先验知识方式由 start() 发出服务器 SETTINGS 后等待客户端前言；
+ *       Upgrade 方式由 startUpgrade() 把升级的 HTTP/1.1 请求作为流1(半关闭)分发。
+ *
+ * 流: 每个流一个 HttpContext，请求头经 HPACK 解码后映射为 HttpRequest(伪头部转为
+ *     方法/路径/Host)，Body 走与 HTTP/1 相同的 HttpContext::onBodyData 路径(含Body接收器)，
+ *     收到 END_STREAM 后交给请求回调，之后与 HTTP/1 请求一样在业务线程池中分发。
+ *     超过 maxConcurrentStreams 的新流以 REFUSED_STREAM 拒绝。
+ *
+ * 流量控制: 发送方向按连接与流两级窗口切分 DATA，窗口耗尽的流等待 WINDOW_UPDATE；
+ *           接收方向超窗即报 FLOW_CONTROL_ERROR，数据被消费后消费量过半窗口时回补。
+ *
+ * 不支持: 服务器推送、优先级调度(PRIORITY 帧只校验格式)、流式响应(HttpStreamWriter 与 SSE)。
+ */
+class Http2Session: public std::enable_shared_from_this<Http2Session>, Noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<Http2Session>;
+    /// @brief 为新流创建请求上下文(挂接Body接收器选择)
+    using ContextFactory = std::function<HttpContextPtr(const TcpConnectionPtr&)>;
+    /// @brief 一个流的请求已完整接收，在IO线程调用
+    using RequestCallback = std::function<void(TcpConnectionPtr, HttpContextPtr)>;
+
+    struct Config {
+        /// @brief 同时打开的流上限
+        uint32_t maxConcurrentStreams{128};
+        /// @brief 本端每个流的接收窗口(SETTINGS_INITIAL_WINDOW_SIZE)
+        uint32_t initialWindowSize{kHttp2DefaultWindowSize};
+        /// @brief 本端连接级接收窗口，大于默认值时建立后立即以 WINDOW_UPDATE 放大
+        uint32_t connectionWindowSize{1024 * 1024};
+        /// @brief 本端可接收的最大帧负载
+        uint32_t maxFrameSize{kHttp2DefaultMaxFrameSize};
+        /// @brief 本端 HPACK 解码动态表上限
+        uint32_t headerTableSize{4096};
+        /// @brief 解码后请求头部列表上限，超过时回复 431
+        uint32_t maxHeaderListSize{64 * 1024};
+    };
+
+    struct Stats {
+        /// @brief 当前打开的流
+        size_t activeStreams{0};
+        uint64_t streams{0};
+        /// @brief 因并发上限被拒绝的流
+        uint64_t refused{0};
+        /// @brief 本端发出的 RST_STREAM
+        uint64_t resets{0};
+        /// @brief 等待窗口的 DATA 字节
+        size_t blockedBytes{0};
+    };
+
+    Http2Session(const TcpConnectionPtr &conn, Config config, ContextFactory factory, RequestCallback cb);
+    ~Http2Session();
+
+    /**
+     * @brief 先验知识方式: 发送服务器 SETTINGS，之后的数据从客户端前言开始
+     */
+    void start();
+
+    /**
+     * @brief Upgrade 方式: 调用方已发出 101，应用 HTTP2-Settings 并把升级的请求作为流1分发
+     * @param[in] settingsPayload HTTP2-Settings 头部 base64url 解码后的 SETTINGS 负载
+     * @param[in] ctx 已解析完整的升级请求
+     * @return 负载无效时返回 false，调用方应关闭连接
+     */
+    bool startUpgrade(std::string_view settingsPayload, const HttpContextPtr &ctx);
+
+    void onData(Buffer &buf);
+    /// @brief 连接断开，丢弃所有流
+    void onDisconnected();
+
+    /**
+     * @brief 发送流的响应，线程安全；响应在调用线程中转换为 h2 头部与Body，编码与发送在IO线程
+     * @param[in] headOnly HEAD 请求只发头部
+     * @note 流已被对端重置或连接已关闭时丢弃
+     */
+    void submitResponse(uint32_t streamId, HttpResponse &resp, bool headOnly);
+
+    /// @brief 以 GOAWAY(NO_ERROR) 通知对端不再接受新流，已有的流处理完后关闭连接
+    void shutdown();
+
+    /// @brief 只在IO线程调用
+    Stats stats() const;
+    size_t activeStreams() const { return _streams.size(); }
+
+private:
+    struct Stream {
+        HttpContextPtr ctx;
+        /// @brief 对端允许本端发送的字节数，SETTINGS 变化时可以为负
+        int64_t sendWindow{0};
+        /// @brief 本端剩余接收窗口
+        int64_t recvWindow{0};
+        /// @brief 已消费未回补的接收字节
+        uint32_t recvConsumed{0};
+        /// @brief 已收到 END_STREAM(半关闭 remote)
+        bool remoteClosed{false};
+        /// @brief Content-Length，-1 表示未声明
+        int64_t contentLength{-1};
+        uint64_t receivedBytes{0};
+        /// @brief 已提交响应头，待发送的Body
+        bool responded{false};
+        std::string pending;
+        size_t pendingOffset{0};
+    };
+
+    /// @brief 在调用线程中由 HttpResponse 转换出的响应
+    struct Reply {
+        int32_t status{200};
+        HpackHeaderList headers;
+        std::string body;
+    };
+
+    static Reply BuildReply(HttpResponse &resp, bool headOnly);
+
+    void sendPreface();
+    /// @brief 处理一个完整的帧，返回 false 表示连接已出错关闭
+    bool handleFrame(const Http2FrameHeader &header, const char *payload);
+    bool onDataFrame(const Http2FrameHeader &header, const char *payload);
+    bool onHeadersFrame(const Http2FrameHeader &header, const char *payload);
+    bool onContinuationFrame(const Http2FrameHeader &header, const char *payload);
+    bool onHeaderBlock();
+    bool onSettingsFrame(const Http2FrameHeader &header, const char *payload);
+    bool applySettings(const char *payload, size_t len);
+    bool onWindowUpdateFrame(const Http2FrameHeader &header, const char *payload);
+
+    /// @brief 头部列表映射为请求，不合法时返回 false(流错误)
+    bool buildRequest(HpackHeaderList &headers, Stream &stream);
+    /// @brief 请求完整接收，交给请求回调
+    void finishRequest(uint32_t streamId);
+
+    void sendReply(uint32_t streamId, Reply reply);
+    /// @brief IO线程中取出所有已提交的响应，编码后合并为一次写
+    void drainReplies();
+    /// @brief 按两级窗口发送各流待发的 DATA
+    void flushPending();
+    void closeStream(uint32_t streamId);
+    void resetStream(uint32_t streamId, Http2ErrorCode code);
+    /// @brief 连接错误: 发送 GOAWAY 并关闭连接
+    bool connectionError(Http2ErrorCode code, const char *reason);
+    void flushOutput();
+
+private:
+    EventLoop *_loop;
+    std::weak_ptr<TcpConnection> _conn;
+    const Config _config;
+    ContextFactory _factory;
+    RequestCallback _callback;
+
+    HpackDecoder _decoder;
+    HpackEncoder _encoder;
+    /// @brief 待写出的帧，每轮处理结束时一次发送
+    std::string _out;
+
+    std::map<uint32_t, Stream> _streams;
+    uint32_t _lastStreamId{0};
+
+    bool _prefaceReceived{false};
+    bool _settingsReceived{false};
+    bool _settingsAcked{false};
+    bool _goAwaySent{false};
+    bool _goAwayReceived{false};
+    bool _closed{false};
+
+    /// @brief 正在接收的头部块(HEADERS + CONTINUATION)
+    std::string _headerBlock;
+    uint32_t _headerStreamId{0};
+    bool _headerEndStream{false};
+    /// @brief 头部块解码后要以该错误重置流(仍需解码以保持 HPACK 同步)
+    Http2ErrorCode _headerError{Http2ErrorCode::kNoError};
+
+    /// @brief 对端设置
+    uint32_t _peerInitialWindow{kHttp2DefaultWindowSize};
+    uint32_t _peerMaxFrameSize{kHttp2DefaultMaxFrameSize};
+    /// @brief 本端新流的接收窗口，SETTINGS 被确认前按协议默认值
+    uint32_t _streamRecvInitial{kHttp2DefaultWindowSize};
+
+    int64_t _sendWindow{kHttp2DefaultWindowSize};
+    int64_t _recvWindow{kHttp2DefaultWindowSize};
+    uint32_t _recvConsumed{0};
+
+    /// @brief 业务线程提交、等待IO线程发送的响应；非空时已有一个 drainReplies 在排队
+    std::mutex _replyMutex;
+    std::vector<std::pair<uint32_t, Reply>> _replyQueue;
+
+    std::atomic<uint64_t> _streamsTotal{0};
+    std::atomic<uint64_t> _refused{0};
+    std::atomic<uint64_t> _resets{0};
+};
+
+}   // http
+}   // kit_muduo
+#endif
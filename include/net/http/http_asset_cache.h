@@ -0,0 +1,142 @@
+/**
+ * @file http_asset_cache.h
+ * @brief 小文件热点资源内存缓存
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 13:05:37
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_ASSET_CACHE_H__
+#define __KIT_HTTP_ASSET_CACHE_H__
+
+#include "base/noncopyable.h"
+#include "net/call_backs.h"
+#include "net/http/http_file_cache.h"
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace kit_muduo::http {
+
+/**
+ * @brief 按字节预算做LRU淘汰的热点资源缓存
+ * @note 每个条目保存文件内容与预先序列化好的 200 响应头(keep-alive/close 两种，
+ *       不含 Date 与结尾空行)，命中时响应就是 头部+Date块+内容 三块共享缓冲的
+ *       一次 writev；超过校验间隔后按 stat 校验 inode/大小/修改时间，变化则失效
+ *
+ * 存储方式:
+ *   - kBuffer:  内容读入 std::string，适合小文件，头部与内容一次 writev
+ *   - kMemFile: 内容复制到封存的 memfd，头部 writev 后内容走 sendfile，
+ *               适合大文件(视频分片)，发送不经用户态拷贝
+ */
+class HttpAssetCache: Noncopyable
+{
+public:
+    enum class Storage { kBuffer, kMemFile };
+
+    struct Asset {
+        /// @brief 状态行+头部，Connection: keep-alive，不含结尾空行
+        SharedBuffer header_keep_alive;
+        /// @brief 状态行+头部，Connection: close，不含结尾空行
+        SharedBuffer header_close;
+        /// @brief kBuffer 存储的内容
+        SharedBuffer body;
+        /// @brief kMemFile 存储的内容
+        SharedFilePtr body_file;
+        std::string etag;
+
+        uint64_t inode{0};
+        uint64_t device{0};
+        uint64_t size{0};
+        int64_t mtime_ns{0};
+        /// @brief 上次校验时间(毫秒)
+        std::atomic<int64_t> checked_ms{0};
+
+        /// @brief 计入预算的字节数
+        size_t bytes() const
+        {
+            return header_keep_alive->size() + header_close->size()
+                + (body ? body->size() : 0) + (body_file ? body_file->size() : 0);
+        }
+    };
+    using AssetPtr = std::shared_ptr<Asset>;
+
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t evictions{0};
+        /// @brief 因文件变化失效的条目数
+        uint64_t invalidations{0};
+        /// @brief 同一资源正由其它线程读入时放弃填充的次数
+        uint64_t fill_bypasses{0};
+        size_t bytes{0};
+        size_t entries{0};
+    };
+
+    /**
+     * @param[in] budgetBytes 缓存总字节预算
+     * @param[in] maxAssetBytes 可缓存的单个文件上限
+     * @param[in] revalidateMs 条目校验间隔，0 表示每次都 stat
+     * @param[in] storage 内容存储方式
+     */
+    explicit HttpAssetCache(size_t budgetBytes = 16 * 1024 * 1024,
+                            size_t maxAssetBytes = 64 * 1024,
+                            int32_t revalidateMs = 1000,
+                            Storage storage = Storage::kBuffer);
+
+    /**
+     * @brief 查找热点资源，未命中或文件已变化时返回空
+     */
+    AssetPtr get(const std::string &path);
+
+    /**
+     * @brief 由已打开的文件构建条目并放入缓存
+     * @param[in] contentType 响应的 Content-Type
+     * @param[in] extraHeaders 额外的头部行，每行以 "\r\n" 结尾(如 "Vary: Accept-Encoding\r\n")
+     * @return 文件超过单个上限、读取失败或其它线程正在读入同一路径时返回空，
+     *         调用方按未缓存发送(sendfile)，避免 N 个并发未命中各读一遍磁盘
+     */
+    AssetPtr put(const std::string &path, const HttpFileCache::Entry &entry, const std::string &contentType,
+                 const std::string &extraHeaders = "");
+
+    void invalidate(const std::string &path);
+    void clear();
+
+    Stats stats() const;
+    size_t budgetBytes() const { return _budgetBytes; }
+    size_t maxAssetBytes() const { return _maxAssetBytes; }
+    Storage storage() const { return _storage; }
+
+private:
+    using LruList = std::list<std::pair<std::string, AssetPtr>>;
+
+    /// @brief 调用方需持有 _mutex
+    void eraseUnLocked(std::unordered_map<std::string, LruList::iterator>::iterator it);
+
+private:
+    const size_t _budgetBytes;
+    const size_t _maxAssetBytes;
+    const int32_t _revalidateMs;
+    const Storage _storage;
+
+    mutable std::mutex _mutex;
+    LruList _list;
+    std::unordered_map<std::string, LruList::iterator> _map;
+    size_t _bytes{0};
+    /// @brief 正在读入的路径
+    std::unordered_set<std::string> _filling;
+
+    std::atomic<uint64_t> _hits{0};
+    std::atomic<uint64_t> _misses{0};
+    std::atomic<uint64_t> _evictions{0};
+    std::atomic<uint64_t> _invalidations{0};
+    std::atomic<uint64_t> _fill_bypasses{0};
+};
+
+}   // kit_muduo::http
+#endif
@@ -0,0 +1,134 @@
+/**
+ * @file http_body_sink.h
+ * @brief HTTP请求Body流式接收
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 17:02:45
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_BODY_SINK_H__
+#define __KIT_HTTP_BODY_SINK_H__
+
+#include "base/noncopyable.h"
+#include "base/multipart.h"
+
+#include <memory>
+#include <string>
+#include <functional>
+#include <cstdint>
+
+namespace kit_muduo::http {
+
+/**
+ * @brief Body接收器：解析器每解析出一段Body就回调一次，Body不再累积到 HttpRequest::body()
+ * @note 回调运行在连接所属的IO线程；返回 false 会中止本次请求(响应400并关闭连接)
+ */
+class HttpBodySink: Noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<HttpBodySink>;
+
+    virtual ~HttpBodySink() = default;
+
+    /**
+     * @brief 收到一段Body数据
+     */
+    virtual bool onData(const char *data, size_t len) = 0;
+
+    /**
+     * @brief Body接收完毕，随后才会分发到业务servlet
+     */
+    virtual bool onComplete() { return true; }
+
+    /**
+     * @brief Body未接收完毕连接就断开或解析出错
+     */
+    virtual void onAbort() {}
+
+    /// @brief 已接收字节数
+    uint64_t receivedBytes() const { return _receivedBytes; }
+
+protected:
+    uint64_t _receivedBytes{0};
+};
+
+/**
+ * @brief 函数回调形式的Body接收器
+ */
+class FunctionBodySink: public HttpBodySink
+{
+public:
+    using DataCallBack = std::function<bool(const char*, size_t)>;
+    using CompleteCallBack = std::function<bool()>;
+
+    explicit FunctionBodySink(DataCallBack onData, CompleteCallBack onComplete = nullptr);
+
+    bool onData(const char *data, size_t len) override;
+    bool onComplete() override;
+
+private:
+    DataCallBack _dataCallback;
+    CompleteCallBack _completeCallback;
+};
+
+/**
+ * @brief 将Body直接写入文件，未完整接收时删除残留文件
+ */
+class FileBodySink: public HttpBodySink
+{
+public:
+    /**
+     * @param[in] path 目标文件路径，已存在时截断
+     * @param[in] maxBytes 允许的最大Body长度，0表示不限制
+     */
+    explicit FileBodySink(const std::string &path, uint64_t maxBytes = 0);
+    ~FileBodySink();
+
+    bool onData(const char *data, size_t len) override;
+    bool onComplete() override;
+    void onAbort() override;
+
+    const std::string &path() const { return _path; }
+    bool completed() const { return _completed; }
+
+private:
+    void closeFile();
+
+private:
+    std::string _path;
+    uint64_t _maxBytes;
+    int32_t _fd;
+    bool _completed{false};
+};
+
+/**
+ * @brief 边接收边解析 multipart/form-data，part 内容不在 HttpRequest::body() 中整体累积
+ * 小 part 保存在内存中，超过 spillBytes 的 part 落盘到临时文件(见 MultipartForm)
+ */
+class MultipartBodySink: public HttpBodySink
+{
+public:
+    /**
+     * @param[in] contentType 请求的 Content-Type，需带 boundary 参数
+     * @param[in] maxBytes 允许的最大Body长度，0表示不限制
+     */
+    explicit MultipartBodySink(std::string_view contentType, uint64_t maxBytes = 0);
+    MultipartBodySink(std::string_view contentType, uint64_t maxBytes, MultipartForm::Config config);
+
+    bool onData(const char *data, size_t len) override;
+    bool onComplete() override;
+
+    MultipartForm& form() { return _form; }
+    const MultipartForm& form() const { return _form; }
+    bool completed() const { return _completed; }
+
+private:
+    uint64_t _maxBytes;
+    MultipartForm _form;
+    bool _started;
+    bool _completed{false};
+};
+
+}   // kit_muduo::http
+
+#endif
@@ -0,0 +1,204 @@
+/**
+ * @file http_client.h
+ * @brief 非阻塞 HTTP/1.1 客户端: 按主机的 keep-alive 连接池、流水线请求队列、定时器驱动的超时
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 16:58:27
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_CLIENT_H__
+#define __KIT_HTTP_CLIENT_H__
+
+#include "base/noncopyable.h"
+#include "net/call_backs.h"
+#include "net/connector.h"
+#include "net/inet_address.h"
+#include "net/http/http_request.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kit_muduo {
+
+class EventLoop;
+class Timer;
+
+namespace http {
+
+/**
+ * @brief 运行在单个 EventLoop 上的 HTTP/1.1 客户端
+ *
+ * - 每个 host:port 一个连接池，最多 maxConnectionsPerHost 条 keep-alive 连接，空闲超过 idleTimeoutMs 关闭
+ * - 请求先进入该主机的队列，分配给在途请求最少的连接；pipelineDepth > 1 时同一连接可连续发出多个请求，
+ *   响应按发出顺序对应。非幂等请求(POST 等)之后不再在该连接上追加请求(RFC 7230 6.3.2)
+ * - 复用的连接在响应开始前被对端关闭(keep-alive 竞态)时，幂等请求自动重发一次
+ * - 超时由循环的定时器每 timerIntervalMs 检查一次: 请求从提交起计时，超时的请求所在连接会被关闭
+ *
+ * request() 可在任意线程调用，回调总在循环线程中执行；future 版本不能在循环线程中等待。
+ * 须由 shared_ptr 持有，内部回调只弱引用客户端，析构时未完成的请求以 kCancelled 结束。
+ */
+class HttpClient: Noncopyable, public std::enable_shared_from_this<HttpClient>
+{
+public:
+    using Ptr = std::shared_ptr<HttpClient>;
+
+    enum Error
+    {
+        kOk,
+        kConnectFailed,
+        kTimeout,
+        /// @brief 收完响应前连接被关闭
+        kConnectionClosed,
+        kBadResponse,
+        /// @brief 主机的排队请求数超过上限
+        kQueueFull,
+        /// @brief 客户端已销毁
+        kCancelled,
+    };
+    static const char* ErrorString(Error err);
+
+    struct Result {
+        Error error{kOk};
+        /// @brief 成功时为完整响应
+        HttpResponsePtr response;
+
+        bool ok() const { return kOk == error; }
+    };
+    using ResponseCallBack = std::function<void(Result)>;
+
+    struct Config {
+        size_t maxConnectionsPerHost{8};
+        /// @brief 单连接上已发出未收到响应的最大请求数，1 表示不使用流水线
+        size_t pipelineDepth{1};
+        /// @brief 单个主机等待连接的请求上限
+        size_t maxQueuedPerHost{64 * 1024};
+        int64_t connectTimeoutMs{3000};
+        /// @brief 请求从提交到收完响应的时限
+        int64_t requestTimeoutMs{10000};
+        int64_t idleTimeoutMs{60000};
+        /// @brief 超时检查间隔，决定超时精度
+        int64_t timerIntervalMs{50};
+        /// @brief 请求未带 User-Agent 时补上，空表示不补
+        std::string userAgent{"kit_muduo"};
+    };
+
+    /// @brief 累计计数与当前状态
+    struct Stats {
+        uint64_t requests{0};
+        uint64_t responses{0};
+        uint64_t failures{0};
+        uint64_t connects{0};
+        uint64_t connectFailures{0};
+        /// @brief 在已完成过请求的连接上发出的请求数
+        uint64_t reusedRequests{0};
+        /// @brief 连接关闭后自动重发的请求数
+        uint64_t retries{0};
+        size_t connections{0};
+        size_t idleConnections{0};
+        size_t queued{0};
+        size_t inflight{0};
+    };
+
+    explicit HttpClient(EventLoop *loop);
+    HttpClient(EventLoop *loop, Config config);
+    ~HttpClient();
+
+    /**
+     * @brief 发送请求
+     * @param[in] server 目标地址
+     * @param[in] req 方法、路径(可带查询串)、头部与Body；未带 Host 时按 server 补上
+     * @param[in] cb 在循环线程中回调，每个请求恰好一次
+     */
+    void request(const InetAddress &server, HttpRequest req, ResponseCallBack cb);
+    std::future<Result> request(const InetAddress &server, HttpRequest req);
+
+    void get(const InetAddress &server, const std::string &path, ResponseCallBack cb);
+    std::future<Result> get(const InetAddress &server, const std::string &path);
+
+    EventLoop* getLoop() const { return _loop; }
+    const Config& config() const { return _config; }
+
+    /**
+     * @brief 状态快照，需在循环线程调用
+     */
+    Stats stats() const;
+
+    /**
+     * @brief 把请求序列化为 HTTP/1.1 报文，补齐 Host/User-Agent/Content-Length
+     */
+    static std::string Serialize(const HttpRequest &req, const std::string &host, const std::string &userAgent);
+
+private:
+    struct Pending {
+        std::string wire;
+        ResponseCallBack cb;
+        int64_t deadlineMs{0};
+        bool head{false};
+        bool idempotent{true};
+        bool retried{false};
+    };
+
+    struct Host;
+
+    /// @brief 池中的一条连接，作为 TcpConnection 的上下文
+    struct Conn {
+        TcpConnectionPtr conn;
+        Host *host{nullptr};
+        HttpContextPtr ctx;
+        /// @brief 已发出、按顺序等待响应的请求
+        std::deque<Pending> inflight;
+        int64_t idleSinceMs{0};
+        uint64_t served{0};
+        bool closing{false};
+    };
+    using ConnPtr = std::shared_ptr<Conn>;
+
+    struct Host {
+        InetAddress addr;
+        std::string key;
+        std::vector<ConnPtr> conns;
+        /// @brief 进行中的连接及其开始时间
+        std::vector<std::pair<Connector::Ptr, int64_t>> connecting;
+        std::deque<Pending> queue;
+    };
+
+    void submit(const InetAddress &server, Pending pending);
+    Host& hostOf(const InetAddress &server);
+    /// @brief 把队列中的请求分配给空闲连接，不够时新建连接
+    void dispatch(Host &host);
+    void startConnect(Host &host);
+    void onConnected(Host *host, Connector *connector, int32_t sockfd);
+    void onConnectFailed(Host *host, Connector *connector, int32_t err);
+    void removeConnector(Host &host, Connector *connector);
+
+    void onMessage(const TcpConnectionPtr &conn, Buffer *buf, TimeStamp receiveTime);
+    void onClose(const TcpConnectionPtr &conn);
+    /// @brief 连接不再可用: 从池中摘除，在途请求重发或失败
+    void retire(const ConnPtr &c, Error err);
+    void requeueOrFail(Host &host, std::deque<Pending> &pendings, Error err);
+    void failQueue(Host &host, Error err);
+    void finish(Pending &pending, Error err, HttpResponsePtr response);
+
+    void ensureTimer();
+    void onTimer();
+
+private:
+    EventLoop *_loop;
+    const Config _config;
+    /// @brief 节点不会移动，Conn/回调中可保存 Host 指针；主机条目不删除
+    std::unordered_map<std::string, Host> _hosts;
+    std::shared_ptr<Timer> _timer;
+    Stats _stats;
+    uint64_t _nextConnId{0};
+};
+
+}   // http
+}   // kit_muduo
+
+#endif
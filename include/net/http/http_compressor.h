@@ -0,0 +1,181 @@
+/**
+ * @file http_compressor.h
+ * @brief 响应压缩(gzip/deflate)及压缩结果缓存
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 18:20:41
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_COMPRESSOR_H__
+#define __KIT_HTTP_COMPRESSOR_H__
+
+#include "base/noncopyable.h"
+#include "net/call_backs.h"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace kit_muduo::http {
+
+class HttpRequest;
+class HttpResponse;
+
+/**
+ * @brief 内容编码
+ */
+enum class HttpEncoding: uint8_t
+{
+    kIdentity = 0,
+    kGzip,
+    kDeflate,
+};
+
+/// @brief 可用编码的位掩码
+namespace HttpEncodingMask {
+    constexpr uint32_t Gzip    = 1 << 0;
+    constexpr uint32_t Deflate = 1 << 1;
+    constexpr uint32_t All     = Gzip | Deflate;
+}
+
+/// @brief Content-Encoding 中的名称，identity 返回空
+std::string_view HttpEncodingName(HttpEncoding encoding);
+
+/**
+ * @brief 按 Accept-Encoding(含q值与"*")在 allowed 中选择编码，q值相同时 gzip 优先
+ * @return 没有可接受的压缩编码时返回 kIdentity
+ */
+HttpEncoding NegotiateEncoding(std::string_view acceptEncoding, uint32_t allowed = HttpEncodingMask::All);
+
+/**
+ * @brief 压缩 [data, data+len)
+ * @param[in] level zlib 压缩级别 1~9
+ * @return zlib 出错时返回 false
+ */
+bool HttpCompress(const char *data, size_t len, HttpEncoding encoding, int32_t level, std::string *out);
+
+/**
+ * @brief 压缩表示的 ETag: 在原 ETag 的引号内追加 "-gzip"/"-deflate"，弱校验前缀保留
+ */
+std::string VariantETag(std::string_view etag, HttpEncoding encoding);
+
+/**
+ * @brief 压缩结果缓存键: 方法、路径与查询串、响应 Vary 所列请求头的取值、ETag
+ * @note ETag 只在同一资源内唯一，必须带上请求身份才能在所有路由间共享缓存；
+ *       Accept-Encoding 由编码本身区分，不计入
+ * @return 无 ETag、弱 ETag(W/ 只保证语义等价而非字节一致)或 Vary: * 时返回空，表示不走缓存
+ */
+std::string CompressCacheKey(const HttpRequest &req, std::string_view etag, std::string_view vary = std::string_view());
+
+/**
+ * @brief 响应压缩器
+ * @note 协商、阈值与类型过滤后就地压缩响应Body，并补上 Content-Encoding 与
+ *       Vary: Accept-Encoding；带强 ETag 的响应按 请求身份+ETag+编码 缓存压缩结果，
+ *       缓存按字节预算做LRU淘汰。压缩在调用线程完成，HttpServer 在业务线程池中调用
+ */
+class HttpCompressor: Noncopyable
+{
+public:
+    struct Config {
+        /// @brief 小于该长度的Body不压缩
+        size_t minBytes{1024};
+        /// @brief zlib 压缩级别
+        int32_t level{6};
+        /// @brief 启用的编码
+        uint32_t encodings{HttpEncodingMask::All};
+        /// @brief 可压缩的 Content-Type 前缀(大小写不敏感)
+        std::vector<std::string> mimeTypes{"text/", "application/json", "application/javascript",
+                                           "application/xml", "image/svg+xml"};
+        /// @brief 压缩结果缓存的字节预算，0 表示不缓存
+        size_t cacheBytes{8 * 1024 * 1024};
+        /// @brief 可缓存的单个压缩结果上限
+        size_t maxCacheEntryBytes{1024 * 1024};
+        /// @brief 静态文件存在同名 .gz 时直接发送
+        bool precompressed{true};
+    };
+
+    struct Stats {
+        /// @brief 实际压缩的响应数(含命中缓存)
+        uint64_t compressed{0};
+        /// @brief 压缩后不变小而放弃的响应数
+        uint64_t incompressible{0};
+        uint64_t cache_hits{0};
+        uint64_t cache_misses{0};
+        uint64_t evictions{0};
+        /// @brief 压缩前后的累计字节数
+        uint64_t bytes_in{0};
+        uint64_t bytes_out{0};
+        size_t cache_bytes{0};
+        size_t cache_entries{0};
+    };
+
+    HttpCompressor();
+    explicit HttpCompressor(Config config);
+
+    const Config& config() const { return _config; }
+
+    /**
+     * @brief 为请求选择编码，未启用任何编码时返回 kIdentity
+     */
+    HttpEncoding negotiate(const HttpRequest &req) const;
+
+    /// @brief Content-Type 是否在可压缩列表中(忽略参数部分)
+    bool compressible(std::string_view contentType) const;
+
+    /**
+     * @brief 压缩已生成的内存响应
+     * @note 跳过: 非 200、HEAD、流式/分段/预序列化响应、已有 Content-Encoding、
+     *       Cache-Control: no-transform、Body 低于阈值或类型不匹配
+     * @return 响应被压缩时返回 true
+     */
+    bool apply(const HttpRequest &req, HttpResponse &resp);
+
+    /**
+     * @brief 查找 key(由 CompressCacheKey 生成)在 encoding 下的压缩结果，未命中返回空
+     */
+    SharedBuffer lookup(const std::string &key, HttpEncoding encoding);
+
+    /**
+     * @brief 压缩 [data, data+len)，key 非空时放入缓存
+     * @return 压缩失败返回空
+     */
+    SharedBuffer store(const std::string &key, HttpEncoding encoding, const char *data, size_t len);
+
+    /**
+     * @brief 记录一次压缩结果，out 不小于 in 时计为放弃压缩
+     * @note apply 内部已记录；自行发送 lookup/store 结果的调用方(如静态文件)需要调用
+     */
+    void record(size_t bytesIn, size_t bytesOut);
+
+    void clear();
+    Stats stats() const;
+
+private:
+    using LruList = std::list<std::pair<std::string, SharedBuffer>>;
+
+    void insert(const std::string &key, SharedBuffer value);
+
+private:
+    const Config _config;
+
+    mutable std::mutex _mutex;
+    LruList _list;
+    std::unordered_map<std::string, LruList::iterator> _map;
+    size_t _bytes{0};
+
+    std::atomic<uint64_t> _compressed{0};
+    std::atomic<uint64_t> _incompressible{0};
+    std::atomic<uint64_t> _hits{0};
+    std::atomic<uint64_t> _misses{0};
+    std::atomic<uint64_t> _evictions{0};
+    std::atomic<uint64_t> _bytesIn{0};
+    std::atomic<uint64_t> _bytesOut{0};
+};
+
+}   // kit_muduo::http
+#endif
@@ -10,12 +10,15 @@
 #define __KIT_HTTP_CONTEXT_H__
 
 #include "net/http/http_request.h"
+#include "net/http/http_body_sink.h"
 #include "net/call_backs.h"
 #include "base/content_parser.h"
+#include "base/json_stream.h"
 
 #include <memory>
 #include <atomic>
 #include <string>
+#include <functional>
 
 namespace kit_muduo {
 
@@ -25,10 +28,23 @@ class TimeStamp;
 namespace http {
 
 class HttpParser;
+class WebSocketConnection;
+class Http2Session;
 
-class HttpContext
+/// @brief 类型是否提供 static bool from_multi_form(const PartMap&, T&)
+template<typename T, typename = void>
+struct HasFromMultiForm: std::false_type {};
+
+template<typename T>
+struct HasFromMultiForm<T, std::void_t<decltype(T::from_multi_form(std::declval<MultiFormParser::PartMap&>(), std::declval<T&>()))>>
+    : std::true_type {};
+
+class HttpContext: public std::enable_shared_from_this<HttpContext>
 {
 public:
+    /// @brief 请求头解析完成且存在Body时调用，返回非空则Body改为流式交给该接收器
+    using BodySinkResolver = std::function<HttpBodySink::Ptr(const HttpContextPtr&)>;
+
     /**
      * @brief 解析有限状态机
      */
@@ -40,8 +56,18 @@ public:
         kGotAll,
     };
 
+    /**
+     * @brief 报文解析器实现
+     */
+    enum ParserType
+    {
+        /// @brief llhttp，支持 chunked 等完整语义(默认)
+        kLLhttpParser,
+        /// @brief 自研解析器，分隔符扫描走 SIMD 快速路径，不支持 chunked
+        kCustomParser,
+    };
 
-    HttpContext();
+    explicit HttpContext(ParserType parserType = kLLhttpParser);
     ~HttpContext();
 
     bool parseRequest(const std::string &data, TimeStamp receiveTime);
@@ -49,6 +75,14 @@ public:
 
     bool parseResponse(const std::string &data, TimeStamp receiveTime);
     bool parseResponse(Buffer &buf, TimeStamp receiveTime);
+    /**
+     * @brief 连接已关闭: 以关闭界定长度(无 Content-Length 且非 chunked)的响应在此完成
+     * @return false 响应不完整
+     */
+    bool finishResponse();
+    /// @brief 待解析的响应对应 HEAD 请求，头部中的 Content-Length 不代表后面有Body
+    void setResponseToHead(bool on) { _responseToHead = on; }
+    bool responseToHead() const { return _responseToHead; }
     HttpParseState state() const { return _state; }
     void setState(HttpParseState state) { _state = state; }
 
@@ -62,6 +96,75 @@ public:
        return _request->getRouteParam(key);
     }
 
+    void setBodySinkResolver(BodySinkResolver resolver) { _bodySinkResolver = std::move(resolver); }
+
+    /// @brief 当前请求的Body接收器，为空表示Body累积在 request()->body()
+    HttpBodySink::Ptr bodySink() const { return _bodySink; }
+    void setBodySink(HttpBodySink::Ptr sink) { _bodySink = std::move(sink); }
+
+    /// @brief 响应Body接收器，设置后解析出的响应Body交给它，不再累积到 response()->body()
+    HttpBodySink::Ptr responseBodySink() const { return _responseBodySink; }
+    void setResponseBodySink(HttpBodySink::Ptr sink) { _responseBodySink = std::move(sink); }
+
+    /**
+     * @brief 记录采样结果与开始解析的时间(ns)，每个请求只在首次收到数据时调用
+     * @param[in] traceId 未采中时为0
+     */
+    void startTrace(uint64_t traceId, int64_t beginNs)
+    {
+        _traceId = traceId;
+        _traceBeginNs = beginNs;
+    }
+    /// @brief 是否已做过采样决策
+    bool traceStarted() const { return 0 != _traceBeginNs; }
+    uint64_t traceId() const { return _traceId; }
+    int64_t traceBeginNs() const { return _traceBeginNs; }
+
+    /// @brief 连接已升级为 WebSocket 时非空，之后的数据都交给它
+    std::shared_ptr<WebSocketConnection> webSocket() const { return _webSocket; }
+    void setWebSocket(std::shared_ptr<WebSocketConnection> ws) { _webSocket = std::move(ws); }
+
+    /// @brief 连接为 HTTP/2 时连接级上下文持有会话，之后的数据都交给它
+    std::shared_ptr<Http2Session> http2Session() const { return _http2Session; }
+    void setHttp2Session(std::shared_ptr<Http2Session> session) { _http2Session = std::move(session); }
+
+    /// @brief 请求来自 HTTP/2 流时记录所属会话与流id，响应经会话按流发送
+    void setHttp2Stream(std::weak_ptr<Http2Session> session, uint32_t streamId)
+    {
+        _http2Stream = std::move(session);
+        _http2StreamId = streamId;
+    }
+    bool isHttp2() const { return 0 != _http2StreamId; }
+    uint32_t http2StreamId() const { return _http2StreamId; }
+    std::shared_ptr<Http2Session> http2StreamSession() const { return _http2Stream.lock(); }
+
+    /******以下供解析器在解析请求时调用******/
+    /**
+     * @brief 请求头解析完成
+     * @param[in] hasBody 是否还有Body(Content-Length>0 或 chunked)
+     */
+    void onHeadersComplete(bool hasBody);
+    /**
+     * @brief 解析出一段请求Body
+     * @return false 接收器拒绝，需中止解析
+     */
+    bool onBodyData(const char *data, size_t len);
+    /**
+     * @brief 请求Body解析完成
+     */
+    bool onBodyComplete();
+
+    /******以下供解析器在解析响应时调用******/
+    /**
+     * @brief 解析出一段响应Body
+     * @return false 接收器拒绝，需中止解析
+     */
+    bool onResponseBodyData(const char *data, size_t len);
+    /**
+     * @brief 响应Body解析完成
+     */
+    bool onResponseBodyComplete();
+
     /**
      * @brief  从HttpRequest中自动根据Content-Type解析出body
      * @param[in] body 
@@ -94,20 +197,47 @@ public:
 
         return false;
     }
+    /**
+     * @brief JSON Body 绑定到对象
+     * 声明了 KIT_JSON_FIELDS 的类型直接从 Body 字节解析到对象，不经过 nlohmann DOM；
+     * 其余类型沿用 nlohmann(需提供 from_json)
+     */
     template<typename T>
     bool BindWithJson(T *obj)
     {
-        *obj = nljson::parse(_request->body().data()).get<T>();
-        return true;
+        const std::string_view body = _request->body().view();
+        if constexpr(IsJsonReflected<T>::value)
+        {
+            std::string err;
+            if(!JsonDecode(body, obj, &err))
+            {
+                std::cerr << "HttpContext::BindWithJson error! " << err << std::endl;
+                return false;
+            }
+            return true;
+        }
+        else
+        {
+            *obj = nljson::parse(body.begin(), body.end()).get<T>();
+            return true;
+        }
     }
 
+    /// @brief 类型未提供 from_multi_form 时不支持表单绑定
     template<typename T>
     bool BindWithMultiForm(T *obj)
     {
-        const auto &data = _request->body().data();
-        auto parts = MultiFormParser::parse(data.data(), data.size(), _request->getHeader("Content-Type"));
-        
-        return T::from_multi_form(parts, *obj);
+        if constexpr(HasFromMultiForm<T>::value)
+        {
+            const auto &data = _request->body().data();
+            auto parts = MultiFormParser::parse(data.data(), data.size(), std::string(_request->header(HttpHeaderId::kContentType)));
+
+            return T::from_multi_form(parts, *obj);
+        }
+        else
+        {
+            return false;
+        }
     }
 
 
@@ -126,6 +256,27 @@ private:
     HttpResponsePtr _response;
     /// @brief HTTP报文解析器
     std::shared_ptr<HttpParser> _parser;
+    /// @brief Body接收器选择
+    BodySinkResolver _bodySinkResolver;
+    /// @brief Body接收器
+    HttpBodySink::Ptr _bodySink;
+    /// @brief Body是否已完整交给接收器
+    bool _bodyCompleted{false};
+    /// @brief 响应Body接收器
+    HttpBodySink::Ptr _responseBodySink;
+    /// @brief 响应对应 HEAD 请求
+    bool _responseToHead{false};
+    /// @brief 追踪id，0 表示本请求不追踪
+    uint64_t _traceId{0};
+    /// @brief 首次收到请求数据的时间(ns)
+    int64_t _traceBeginNs{0};
+    /// @brief 升级后的 WebSocket 会话
+    std::shared_ptr<WebSocketConnection> _webSocket;
+    /// @brief HTTP/2 会话(仅连接级上下文)
+    std::shared_ptr<Http2Session> _http2Session;
+    /// @brief 请求所属的 HTTP/2 会话与流，会话持有流的上下文，这里只能弱引用
+    std::weak_ptr<Http2Session> _http2Stream;
+    uint32_t _http2StreamId{0};
 };
 
 
@@ -0,0 +1,81 @@
+/**
+ * @file http_file_cache.h
+ * @brief 静态文件描述符缓存
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 10:40:21
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_FILE_CACHE_H__
+#define __KIT_HTTP_FILE_CACHE_H__
+
+#include "base/noncopyable.h"
+#include "base/lru_cache.h"
+#include "net/shared_file.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <ctime>
+
+namespace kit_muduo::http {
+
+/**
+ * @brief 缓存已打开的静态文件及其响应元数据(ETag/Last-Modified)
+ * @note 条目按数量做LRU淘汰以限制占用的描述符；超过校验间隔后重新 stat，
+ *       文件被修改或替换时重新打开。已发出的旧描述符由发送队列持有直到发完。
+ *       不存在的路径(如没有 .gz 的预压缩探测)同样缓存一个校验间隔，期间不再 open
+ */
+class HttpFileCache: Noncopyable
+{
+public:
+    struct Entry {
+        /// @brief 为空表示路径不存在(负缓存)，get 不会返回这种条目
+        SharedFilePtr file;
+        /// @brief 负缓存条目打开失败的errno
+        int32_t err{0};
+        /// @brief 强校验ETag(含引号)
+        std::string etag;
+        /// @brief HTTP-date格式的修改时间
+        std::string last_modified;
+        /// @brief 修改时间(秒)，用于 If-Modified-Since 比较
+        time_t mtime{0};
+        /// @brief 上次校验时间(毫秒)
+        std::atomic<int64_t> checked_ms{0};
+    };
+    using EntryPtr = std::shared_ptr<Entry>;
+
+    /**
+     * @param[in] capacity 最多缓存的文件数
+     * @param[in] revalidateMs 条目校验间隔，0 表示每次都 stat
+     */
+    explicit HttpFileCache(size_t capacity = 1024, int32_t revalidateMs = 1000);
+
+    /**
+     * @brief 获取文件条目，未缓存或已过期时打开/校验
+     * @param[out] err 失败时的errno，可为空
+     * @return 失败时返回空
+     */
+    EntryPtr get(const std::string &path, int32_t *err = nullptr);
+
+    void invalidate(const std::string &path);
+
+    size_t size() const { return _cache.size(); }
+    uint64_t hits() const { return _hits.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return _misses.load(std::memory_order_relaxed); }
+
+    /// @brief 根据文件元数据生成强ETag
+    static std::string MakeETag(const SharedFile &file);
+
+private:
+    EntryPtr open(const std::string &path, int64_t nowMs, int32_t *err);
+
+private:
+    LruCache<std::string, EntryPtr> _cache;
+    int32_t _revalidateMs;
+    std::atomic<uint64_t> _hits{0};
+    std::atomic<uint64_t> _misses{0};
+};
+
+}   // kit_muduo::http
+#endif
@@ -0,0 +1,60 @@
+/**
+ * @file http_header_cache.h
+ * @brief 响应头预渲染片段与 Date 头缓存
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 17:35:10
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_HEADER_CACHE_H__
+#define __KIT_HTTP_HEADER_CACHE_H__
+
+#include "net/call_backs.h"
+
+#include <cstdint>
+#include <ctime>
+#include <string_view>
+
+namespace kit_muduo::http {
+
+/// @brief "Connection: keep-alive\r\nKeep-Alive: timeout=5, max=100\r\n" 或 "Connection: close\r\n"
+std::string_view HttpConnectionFragment(bool keepAlive);
+
+/**
+ * @brief "Content-Type: <type>; charset=utf-8\r\n"，multipart 额外带 boundary
+ * @return kUnknowType 返回空
+ */
+std::string_view HttpContentTypeFragment(int32_t contentType);
+
+/**
+ * @brief 进程内共享的 Date 头，每秒由定时器重新渲染一次
+ * @note 每个线程(IO loop/业务线程)持有一份当前值的引用，只有秒数变化后
+ *       才去取新值；没有定时器驱动时退化为读取时按 time() 判断是否过期
+ */
+class HttpDateCache
+{
+public:
+    /// @brief 刷新间隔(ms)
+    static constexpr int64_t kRefreshIntervalMs = 1000;
+
+    /// @brief "Date: <IMF-fixdate>\r\n"，视图在本线程下次调用前有效
+    static std::string_view DateLine();
+
+    /**
+     * @brief "Date: <IMF-fixdate>\r\n\r\n"，可直接作为 iovec 接在不含结尾空行的预序列化头部之后
+     */
+    static SharedBuffer DateBlock();
+
+    /// @brief 以 now 重新渲染，now 不晚于已发布的秒数时直接返回(Date 只前进不倒退)
+    static void Refresh(time_t now);
+
+    /// @brief 登记/注销一个定时刷新的驱动方(HttpServer)
+    static void Retain();
+    static void Release();
+
+private:
+    static const SharedBuffer& Current();
+};
+
+}   // kit_muduo::http
+#endif
@@ -0,0 +1,160 @@
+/**
+ * @file http_headers.h
+ * @brief HTTP头部容器(大小写不敏感、小容量内联存储)
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 14:20:45
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_HEADERS_H__
+#define __KIT_HTTP_HEADERS_H__
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace kit_muduo::http {
+
+/**
+ * @brief 预先驻留的常用头部ID，按ID访问为O(1)
+ */
+enum class HttpHeaderId: uint8_t
+{
+    kUnknown = 0,
+    kAccept,
+    kAcceptEncoding,
+    kAcceptLanguage,
+    kAcceptRanges,
+    kAllow,
+    kAuthorization,
+    kCacheControl,
+    kConnection,
+    kContentEncoding,
+    kContentLength,
+    kContentRange,
+    kContentType,
+    kCookie,
+    kDate,
+    kETag,
+    kExpect,
+    kHost,
+    kIfModifiedSince,
+    kIfNoneMatch,
+    kIfRange,
+    kKeepAlive,
+    kLastModified,
+    kLocation,
+    kRange,
+    kServer,
+    kSetCookie,
+    kTransferEncoding,
+    kUpgrade,
+    kUserAgent,
+    kVary,
+    kMax,
+};
+
+/// @brief 头部ID的标准写法，kUnknown 返回空
+std::string_view HttpHeaderName(HttpHeaderId id);
+
+/// @brief 按名称(大小写不敏感)查找驻留ID，未驻留返回 kUnknown
+HttpHeaderId LookupHttpHeaderId(std::string_view name);
+
+/// @brief ASCII大小写不敏感比较
+bool HeaderNameEquals(std::string_view a, std::string_view b);
+
+/// @brief 去掉首尾的空格与制表符(RFC 9110 OWS)
+std::string_view TrimHttpSpace(std::string_view str);
+
+/// @brief 逗号分隔的头部值中是否含有 token(大小写不敏感)，如 Connection/Upgrade
+bool HeaderHasToken(std::string_view value, std::string_view token);
+
+/**
+ * @brief 头部容器：按插入顺序保存 (名称, 值)，名称大小写不敏感
+ * @note 不超过 kInlineCapacity 个头部时不申请堆内存(字符串本身的SSO除外)；
+ *       常用头部经驻留ID索引，查找无需哈希与逐个比较
+ */
+class HttpHeaders
+{
+public:
+    static constexpr size_t kInlineCapacity = 16;
+
+    struct Entry {
+        /// @brief 名称，保持首次写入时的大小写
+        std::string first;
+        /// @brief 值
+        std::string second;
+        HttpHeaderId id{HttpHeaderId::kUnknown};
+    };
+
+    using iterator = Entry*;
+    using const_iterator = const Entry*;
+
+    HttpHeaders();
+    ~HttpHeaders();
+    HttpHeaders(const HttpHeaders &other);
+    HttpHeaders(HttpHeaders &&other) noexcept;
+    HttpHeaders& operator=(const HttpHeaders &other);
+    HttpHeaders& operator=(HttpHeaders &&other) noexcept;
+
+    size_t size() const { return _size; }
+    bool empty() const { return 0 == _size; }
+    void clear();
+
+    iterator begin() { return _data; }
+    iterator end() { return _data + _size; }
+    const_iterator begin() const { return _data; }
+    const_iterator end() const { return _data + _size; }
+
+    const_iterator find(std::string_view name) const;
+    const_iterator find(HttpHeaderId id) const;
+    bool has(std::string_view name) const { return find(name) != end(); }
+    bool has(HttpHeaderId id) const { return find(id) != end(); }
+
+    /// @brief 取值视图，不存在返回空视图；视图在容器被修改前有效
+    std::string_view get(std::string_view name) const;
+    std::string_view get(HttpHeaderId id) const;
+
+    /// @brief 设置头部，同名(大小写不敏感)已存在时覆盖其值
+    void set(std::string_view name, std::string_view value);
+    void set(HttpHeaderId id, std::string_view value);
+
+    /// @brief 追加一个头部，不检查重名(如多个 Set-Cookie)
+    void add(std::string_view name, std::string_view value);
+
+    /**
+     * @brief 合并同名头部: 不存在时追加，存在时以 ", " 拼接到已有值后
+     */
+    void combine(std::string_view name, std::string_view value);
+
+    /// @brief 删除同名的全部头部，返回删除个数
+    size_t erase(std::string_view name);
+
+private:
+    Entry* inlineData() { return reinterpret_cast<Entry*>(_inline); }
+    bool isInline() const { return _data == reinterpret_cast<const Entry*>(_inline); }
+
+    Entry& append(std::string_view name, std::string_view value, HttpHeaderId id);
+    void grow();
+    void destroyAll();
+    void rebuildIndex();
+    void copyFrom(const HttpHeaders &other);
+    void moveFrom(HttpHeaders &other);
+
+    /// @brief 未驻留名称的线性查找
+    Entry* findUnknown(std::string_view name) const;
+
+private:
+    Entry *_data;
+    size_t _size;
+    size_t _capacity;
+    /// @brief 驻留ID -> 首个同ID头部的下标+1，0表示不存在
+    uint8_t _index[static_cast<size_t>(HttpHeaderId::kMax)];
+    alignas(Entry) unsigned char _inline[sizeof(Entry) * kInlineCapacity];
+};
+
+}   // kit_muduo::http
+#endif
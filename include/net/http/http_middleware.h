@@ -0,0 +1,95 @@
+/**
+ * @file http_middleware.h
+ * @brief HTTP中间件: servlet前后的横切逻辑(鉴权、CORS、限流等)
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 21:20:05
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_MIDDLEWARE_H__
+#define __KIT_HTTP_MIDDLEWARE_H__
+
+#include "net/call_backs.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace kit_muduo::http {
+
+/**
+ * @brief 中间件基类
+ *
+ * 执行顺序: 按注册顺序调用 before，全部放行后执行servlet，再按相反顺序调用 after。
+ * before 返回 kRespond 表示已在 ctx->response() 中写好响应(如 401)，
+ * 后续中间件的 before 与servlet都不再执行，已执行过 before 的中间件仍会收到 after。
+ * servlet 抛出异常时响应状态码置为 500，after 同样逆序调用后异常继续上抛。
+ *
+ * @note 与servlet在同一线程中执行(启用业务线程池时为业务线程)，实现需线程安全；
+ *       流式响应在servlet返回时已发出，此时 after 只能观察不能再修改响应
+ */
+class HttpMiddleware
+{
+public:
+    using Ptr = std::shared_ptr<HttpMiddleware>;
+
+    enum class Action {
+        /// @brief 放行，继续后续中间件与servlet
+        kContinue,
+        /// @brief 短路，直接使用当前响应
+        kRespond,
+    };
+
+    explicit HttpMiddleware(const std::string &name) :_name(name) { }
+    virtual ~HttpMiddleware() = default;
+
+    virtual Action before(const TcpConnectionPtr &conn, const HttpContextPtr &ctx) { return Action::kContinue; }
+
+    virtual void after(const TcpConnectionPtr &conn, const HttpContextPtr &ctx) { }
+
+    const std::string& name() const { return _name; }
+
+private:
+    std::string _name;
+};
+
+/**
+ * @brief 由回调组成的中间件，before/after 可为空
+ */
+class FunctionMiddleware: public HttpMiddleware
+{
+public:
+    using BeforeCb = std::function<Action(const TcpConnectionPtr&, const HttpContextPtr&)>;
+    using AfterCb = std::function<void(const TcpConnectionPtr&, const HttpContextPtr&)>;
+
+    FunctionMiddleware(const std::string &name, BeforeCb before, AfterCb after = nullptr)
+        :HttpMiddleware(name)
+        ,_before(std::move(before))
+        ,_after(std::move(after))
+    {
+    }
+
+    Action before(const TcpConnectionPtr &conn, const HttpContextPtr &ctx) override
+    {
+        return _before ? _before(conn, ctx) : Action::kContinue;
+    }
+
+    void after(const TcpConnectionPtr &conn, const HttpContextPtr &ctx) override
+    {
+        if(_after)
+        {
+            _after(conn, ctx);
+        }
+    }
+
+private:
+    BeforeCb _before;
+    AfterCb _after;
+};
+
+/// @brief 编译后的中间件链，指针由路由表快照持有的 HttpMiddleware::Ptr 保活
+using MiddlewareChain = std::vector<HttpMiddleware*>;
+
+}   // kit_muduo::http
+#endif
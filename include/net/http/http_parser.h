@@ -10,6 +10,7 @@
 #define __KIT_HTTP_PARSER_H__
 
 #include "net/call_backs.h"
+#include "net/http/http_headers.h"
 
 #include <llhttp.h>
 #include <string>
@@ -39,8 +40,18 @@ public:
 
     virtual bool parse(Buffer &buf) = 0;
     virtual bool parse(const std::string &data) = 0;
+    /**
+     * @brief 输入结束(连接关闭)，完成以关闭界定长度的报文
+     * @return false 报文不完整或解析器不支持
+     */
+    virtual bool finish() { return false; }
     void setType(int32_t type) { _type= type; }
 
+    /// @brief 拆分 path 与 query，query 参数URL解码后写入请求(HTTP/2 的 :path 也走这里)
+    static void parseUrl(const std::string &url, const HttpRequestPtr &request);
+
+    static void parseQueryParams(const std::string &query, const HttpRequestPtr &request);
+
 protected:
     HttpContext *_context;
     /// @brief 解析模式 指示给哪个变量赋值
@@ -61,10 +72,6 @@ public:
     bool parse(const std::string &data) override;
 private:
     bool processRequestLine(const char *start, const char *end);
-
-    const char* findCRLF(Buffer &buf) const;
-
-    const char* findCRLF(const char *start, const char *end) const;
 private:
     size_t expected_body_len_{0};
     size_t read_len_{0};
@@ -79,7 +86,15 @@ public:
     struct HeaderContext {
         std::string cur_header;
         std::string url;
-        std::unordered_map<std::string, std::string> headers;
+        std::string method;
+        /// @brief 协议名(HTTP/RTSP)，与 version 组成完整版本
+        std::string protocol;
+        std::string version;
+        HttpHeaders headers;
+        /// @brief 上一个回调是否为头部值，用于区分被拆分的字段名/值与下一个头部
+        bool in_value{false};
+        /// @brief 当前正在写入的头部下标(同名合并时不一定是最后一个)
+        size_t value_index{0};
     };
 
     LLhttpParser(HttpContext *context);
@@ -88,9 +103,13 @@ public:
 
     bool parse(const std::string &data) override;
 
+    bool finish() override;
+
 private:
     static  int onMethod(llhttp_t* parser, const char *data, size_t len);
 
+    static int onMethodComplete(llhttp_t* parser);
+
     static  int onStatus(llhttp_t* parser, const char *data, size_t len);
 
     static int onStatusComplete(llhttp_t* parser);
@@ -99,6 +118,8 @@ private:
 
     static int onUrlComplete(llhttp_t* parser);
 
+    static int onProtocol(llhttp_t* parser, const char *data, size_t len);
+
     static int onVersion(llhttp_t* parser, const char *data, size_t len);
 
     static int onVersionComplete(llhttp_t* parser);
@@ -113,11 +134,9 @@ private:
     // 该回调函数必须设置
     static int onMessageComplete(llhttp_t* parser);
 
+    /// @brief 一个头部值接收完毕，去掉尾部空白
+    void finishHeaderValue();
 
-    void parseQueryParams(const std::string &query, const HttpRequestPtr &request);
-
-
-    void parseUrl(const std::string &url, const HttpRequestPtr &request);
 
 private:
     /// @brief llhttp库句柄
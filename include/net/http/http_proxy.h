@@ -0,0 +1,138 @@
+/**
+ * @file http_proxy.h
+ * @brief 反向代理: 上游负载均衡、健康检查、keep-alive 连接复用、Body 流式转发与背压
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 21:18:36
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_PROXY_H__
+#define __KIT_HTTP_PROXY_H__
+
+#include "net/http/http_servlet.h"
+#include "net/inet_address.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace kit_muduo {
+
+class EventLoop;
+
+namespace http {
+
+/**
+ * @brief 反向代理 servlet
+ *
+ * 请求在下游连接所属的 IO 线程中转发给一组上游 HTTP/1.1 服务:
+ *   - 按 balance 选择上游，只在健康的上游中选；全部不健康时仍然尝试，避免误判导致整体不可用
+ *   - 每个 IO 线程为每个上游保留 keep-alive 空闲连接，上游连接始终在下游连接的线程中读写，不跨线程
+ *   - 请求/响应 Body 不落到 HttpRequest::body()/HttpResponse::body(): 解析器每交出一段，
+ *     就直接写到对端连接(内核写缓冲区满时才拷入输出缓冲区)；长度已知时原样转发，
+ *     否则按对端能力改用 chunked 或以关闭界定
+ *   - 一端输出积压超过 highWaterMark 时暂停读取另一端，积压写完后恢复，内存占用与 Body 大小无关
+ *   - 连接失败计入上游连续失败次数并换下一个上游重试，全部失败时回 502；无进展超过 ioTimeoutMs 回 504
+ *   - 同一下游连接上的流水线请求按到达顺序逐个转发，响应顺序与请求一致
+ *
+ * 带 Body 的请求在头部解析完成时就开始转发，中间件此时尚未执行；转发到下游的响应会等到
+ * handle 被调用之后才写出，中间件拒绝的请求只是不会收到上游响应(由 ioTimeoutMs 回收)。
+ * 路由通配符不跨 '/'，需要代理多层路径时按层数注册多条路由。
+ */
+class ProxyServlet: public HttpServlet
+{
+public:
+    using Ptr = std::shared_ptr<ProxyServlet>;
+
+    enum class Balance
+    {
+        kRoundRobin,
+        /// @brief 当前在途请求最少的上游(所有 IO 线程合计)
+        kLeastConnections,
+    };
+
+    struct Config {
+        Balance balance{Balance::kRoundRobin};
+        /// @brief 转发前去掉的路径前缀(如路由 "/api/*" 配 "/api")，空表示原样转发
+        std::string stripPrefix;
+        /// @brief 每个 IO 线程、每个上游保留的空闲连接上限
+        size_t maxIdlePerUpstream{32};
+        int64_t idleTimeoutMs{30 * 1000};
+        int64_t connectTimeoutMs{3000};
+        /// @brief 一次转发在两个方向上都没有数据流动的时限
+        int64_t ioTimeoutMs{30 * 1000};
+        /// @brief 超时检查间隔，决定超时精度
+        int64_t timerIntervalMs{100};
+        /// @brief 单方向输出积压上限，超过后暂停读取数据来源一端
+        size_t highWaterMark{256 * 1024};
+        /// @brief 主动健康检查的请求路径，空表示只检查能否建立 TCP 连接
+        std::string healthCheckPath;
+        int64_t healthCheckIntervalMs{2000};
+        /// @brief 连续失败多少次标记为不健康(主动检查与转发中的连接失败都计入)，一次成功即恢复
+        int32_t unhealthyThreshold{3};
+    };
+
+    /// @brief 单个上游的状态快照
+    struct UpstreamStats {
+        std::string addr;
+        bool healthy{true};
+        /// @brief 当前在途请求数
+        int32_t active{0};
+        uint64_t requests{0};
+        uint64_t failures{0};
+    };
+
+    struct Stats {
+        uint64_t requests{0};
+        uint64_t responses{0};
+        uint64_t badGateway{0};
+        uint64_t gatewayTimeout{0};
+        uint64_t connects{0};
+        /// @brief 使用空闲 keep-alive 连接转发的请求数
+        uint64_t reused{0};
+        /// @brief 复用的连接在响应前被上游关闭后重发的请求数
+        uint64_t retries{0};
+    };
+
+    explicit ProxyServlet(const std::vector<InetAddress> &upstreams);
+    ProxyServlet(const std::vector<InetAddress> &upstreams, Config config);
+    ~ProxyServlet();
+
+    void handle(TcpConnectionPtr conn, HttpContextPtr ctx) override;
+
+    HttpBodySink::Ptr createBodySink(TcpConnectionPtr conn, HttpContextPtr ctx) override;
+
+    /// @brief 没有Body的请求在IO线程按到达顺序排队，保证流水线响应顺序
+    void prepare(TcpConnectionPtr conn, HttpContextPtr ctx) override;
+    bool needsPrepare() const override { return true; }
+
+    /**
+     * @brief 在 loop 上按 healthCheckIntervalMs 周期检查所有上游
+     * @note 需在 loop 退出前调用 stopHealthCheck 或析构 servlet
+     */
+    void startHealthCheck(EventLoop *loop);
+    void stopHealthCheck();
+
+    /// @brief 上游状态快照，可在任意线程调用
+    std::vector<UpstreamStats> upstreamStats() const;
+    Stats stats() const;
+    const Config& config() const;
+
+private:
+    struct Upstream;
+    struct UpConn;
+    struct LoopState;
+    struct Core;
+    class Exchange;
+    class RequestSink;
+    class ResponseSink;
+    struct HealthChecker;
+
+    /// @brief 转发中的回调都持有 Core，servlet 先于在途请求销毁也是安全的
+    std::shared_ptr<Core> _core;
+};
+
+}   // http
+}   // kit_muduo
+#endif
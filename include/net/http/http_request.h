@@ -10,6 +10,7 @@
 #define __KIT_HTTP_REQUEST_H__
 #include "base/time_stamp.h"
 #include "net/http/http_util.h"
+#include "net/http/http_headers.h"
 #include "net/buffer.h"
 
 #include <string>
@@ -26,7 +27,9 @@ class HttpRequest
 public:
     struct Method
     {
-        enum { kInvaild, kGet, kPost, kHead, kPut, kDelete };
+        /// @brief kOptions 及之后为 RTSP 方法(OPTIONS 在 HTTP 路由中不参与匹配)
+        enum { kInvaild, kGet, kPost, kHead, kPut, kDelete,
+               kOptions, kDescribe, kSetup, kPlay, kPause, kTeardown, kGetParameter, kSetParameter };
 
         explicit Method(int32_t method = kInvaild) :method(method) { }
 
@@ -44,6 +47,14 @@ public:
                 case kHead: return "HEAD";
                 case kPut: return "PUT";
                 case kDelete: return "DELETE";
+                case kOptions: return "OPTIONS";
+                case kDescribe: return "DESCRIBE";
+                case kSetup: return "SETUP";
+                case kPlay: return "PLAY";
+                case kPause: return "PAUSE";
+                case kTeardown: return "TEARDOWN";
+                case kGetParameter: return "GET_PARAMETER";
+                case kSetParameter: return "SET_PARAMETER";
                 default:
                     return "Invaild";
             }
@@ -57,6 +68,14 @@ public:
             if("HEAD" == methodStr) return Method(kHead);
             if("PUT" == methodStr) return Method(kPut);
             if("DELETE" == methodStr) return Method(kDelete);
+            if("OPTIONS" == methodStr) return Method(kOptions);
+            if("DESCRIBE" == methodStr) return Method(kDescribe);
+            if("SETUP" == methodStr) return Method(kSetup);
+            if("PLAY" == methodStr) return Method(kPlay);
+            if("PAUSE" == methodStr) return Method(kPause);
+            if("TEARDOWN" == methodStr) return Method(kTeardown);
+            if("GET_PARAMETER" == methodStr) return Method(kGetParameter);
+            if("SET_PARAMETER" == methodStr) return Method(kSetParameter);
             return Method();
         }
     private:
@@ -86,6 +105,10 @@ public:
 
     void addQureyParam(const std::string &key, const std::string &val) { query_params_[key] = val; }
 
+    /// @brief 原始查询串('?' 之后、未解码)，转发请求时原样带上
+    const std::string& query() const { return query_; }
+    void setQuery(const std::string &query) { query_ = query; }
+
     std::string getRouteParam(const std::string &key) const
     {
         auto it = route_params_.find(key);
@@ -103,9 +126,13 @@ public:
     bool addHeader(const char *start, const char *colon, const char *end);
     std::string getHeader(const std::string &key) const;
 
-    const std::unordered_map<std::string, std::string>& headers() const { return headers_; }
-    std::unordered_map<std::string, std::string>& headers() { return headers_; }
-    void setHeaders(const std::unordered_map<std::string, std::string> &headers) { headers_ = std::move(headers); }
+    /// @brief 头部值视图(名称大小写不敏感)，不存在返回空视图
+    std::string_view header(std::string_view key) const { return headers_.get(key); }
+    std::string_view header(HttpHeaderId id) const { return headers_.get(id); }
+
+    const HttpHeaders& headers() const { return headers_; }
+    HttpHeaders& headers() { return headers_; }
+    void setHeaders(HttpHeaders headers) { headers_ = std::move(headers); }
 
 
     void setReceiveTime(TimeStamp receiveTime) { receive_time_ = receiveTime; }
@@ -133,12 +160,14 @@ protected:
     std::string path_;
     /// @brief 请求参数
     ParamMap query_params_;
+    /// @brief 原始查询串
+    std::string query_;
     /// @brief 动态路由参数
     ParamMap route_params_;
     /// @brief 协议版本
     Version version_;
     /// @brief 头部字段
-    std::unordered_map<std::string, std::string> headers_;
+    HttpHeaders headers_;
     /// @brief Body结构
     Body body_;
     /// @brief 接收请求时间点
@@ -10,8 +10,12 @@
 #define __KIT_HTTP_RESPONSE_H__
 
 #include "net/http/http_util.h"
+#include "net/http/http_headers.h"
 #include "net/buffer.h"
 #include "base/time_stamp.h"
+#include "net/shared_file.h"
+#include "net/call_backs.h"
+#include "base/json_stream.h"
 
 #include <vector>
 #include <algorithm>
@@ -43,9 +47,13 @@ public:
     bool addHeader(const char *start, const char *colon, const char *end);
     std::string getHeader(const std::string &key) const;
 
-    const std::unordered_map<std::string, std::string>& headers() const { return headers_; }
-    const std::unordered_map<std::string, std::string>& headers() { return headers_; }
-    void setHeaders(const std::unordered_map<std::string, std::string> &headers) { headers_ = headers; }
+    /// @brief 头部值视图(名称大小写不敏感)，不存在返回空视图
+    std::string_view header(std::string_view key) const { return headers_.get(key); }
+    std::string_view header(HttpHeaderId id) const { return headers_.get(id); }
+
+    const HttpHeaders& headers() const { return headers_; }
+    HttpHeaders& headers() { return headers_; }
+    void setHeaders(HttpHeaders headers) { headers_ = std::move(headers); }
 
     void setConnectionClosed(bool on) { connection_closed_ = on; }
     bool connectionClosed() const { return connection_closed_; }
@@ -57,22 +65,87 @@ public:
     Body& body() { return body_; }
     void setBody(const Body &body) { body_ = body; }
 
+    /**
+     * @brief 以流式写入器把对象直接序列化进Body，Content-Type 置为 JSON
+     * @note T 需声明 KIT_JSON_FIELDS 或为 JsonWrite 支持的基础/容器类型
+     */
+    template<typename T>
+    void setJsonBody(const T &obj)
+    {
+        body_.reset();
+        body_.setContentType(ContentType::kJsonType);
+        JsonEncode(obj, &body_);
+    }
+
+    /// @brief 响应已由 HttpStreamWriter 流式发出，服务器不再整体发送
+    void setStreaming(bool on) { streaming_ = on; }
+    bool streaming() const { return streaming_; }
+
+    /// @brief 响应将在异步操作完成后由处理者自行发送，服务器不在 servlet 返回时发送
+    void setDeferred(bool on) { deferred_ = on; }
+    bool deferred() const { return deferred_; }
+
+    /// @brief Body分段：内存数据或文件区间(sendfile零拷贝)，非空时取代 body()
+    struct BodySegment {
+        std::string data;
+        SharedFilePtr file;
+        off_t offset{0};
+        size_t length{0};
+    };
+
+    void addDataSegment(std::string data);
+    void addFileSegment(const SharedFilePtr &file, off_t offset, size_t length);
+    const std::vector<BodySegment>& segments() const { return segments_; }
+    /// @brief 全部分段的字节数
+    size_t segmentBytes() const { return segment_bytes_; }
+
+    /**
+     * @brief 设置预序列化的完整响应(状态行+头部+Body)，非空时服务器直接以 writev 发送，
+     *        不再序列化其余字段
+     * @note 可同时带文件分段: 预序列化部分只含状态行与头部，Body 随后按分段 sendfile
+     */
+    void setSerialized(std::vector<SharedBuffer> buffers) { serialized_ = std::move(buffers); }
+    const std::vector<SharedBuffer>& serialized() const { return serialized_; }
+
+    /**
+     * @brief 序列化状态行与头部(以空行结尾)，不含Body
+     */
+    std::string headerString();
+
+    /**
+     * @brief 序列化状态行与头部，不含 Date 与结尾空行，
+     *        发送时接上 HttpDateCache::DateBlock() 即为完整头部
+     * @param[in] keepAlive 生成 keep-alive 还是 close 形式的 Connection 头
+     */
+    std::string headerPrefix(bool keepAlive);
 
     std::string toString();
 
+private:
+    std::string renderHeader(bool keep_alive, bool complete);
+
 protected:
     /// @brief 状态码
     StateCode state_code_;
     /// @brief 协议版本
     Version version_;
     /// @brief 头部字段
-    std::unordered_map<std::string, std::string> headers_;
+    HttpHeaders headers_;
     /// @brief 连接是否关闭
     bool connection_closed_;
     /// @brief Body结构
     Body body_;
     /// @brief 收到响应时间
     TimeStamp receive_time_;
+    /// @brief 是否为流式响应
+    bool streaming_{false};
+    /// @brief 是否为延迟发送的响应
+    bool deferred_{false};
+    /// @brief Body分段
+    std::vector<BodySegment> segments_;
+    size_t segment_bytes_{0};
+    /// @brief 预序列化的完整响应
+    std::vector<SharedBuffer> serialized_;
 };
 
 
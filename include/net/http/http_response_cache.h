@@ -0,0 +1,161 @@
+/**
+ * @file http_response_cache.h
+ * @brief 响应缓存中间件: 按方法/路径/查询参数/Vary 头缓存预序列化响应
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 22:05:37
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_RESPONSE_CACHE_H__
+#define __KIT_HTTP_RESPONSE_CACHE_H__
+
+#include "base/lru_cache.h"
+#include "net/http/http_servlet.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kit_muduo::http {
+
+/**
+ * @brief 响应缓存
+ * @note 作为中间件挂到 HttpServletDispatch(可限定路由前缀)，流程:
+ *       - before: 计算键，命中且未过期时直接给出预序列化响应(状态行+头部、Date块、Body 三块共享缓冲)；
+ *         未命中时同一个键只放行一个请求(leader)执行servlet，其余业务线程上的请求等待其结果；
+ *         在IO线程中执行时(未启用业务线程池)不等待，直接执行servlet
+ *       - after: leader 的响应可缓存时序列化入缓存并唤醒等待者，不可缓存(含servlet抛出异常)时
+ *         等待者各自执行servlet
+ *
+ *       可缓存: 方法在 methods 内、状态码在 statusCodes 内、内存Body(非流式/延迟/分段/预序列化)、
+ *       无 Set-Cookie、Cache-Control 不含 no-store/no-cache/private、响应的 Vary 头均在 varyHeaders 内。
+ *       响应的 Cache-Control: s-maxage/max-age 覆盖默认TTL。
+ *       请求带 Authorization 或 Cache-Control: no-cache/no-store 时绕过缓存。
+ *
+ *       命中的响应已预序列化，不再经过 HttpCompressor；需要压缩的路由可把 Accept-Encoding
+ *       加入 varyHeaders 并由servlet自行压缩。
+ */
+class HttpResponseCache: public HttpMiddleware
+{
+public:
+    using Ptr = std::shared_ptr<HttpResponseCache>;
+
+    struct Config {
+        /// @brief 响应未给出 max-age 时的默认TTL
+        int64_t ttlMs{1000};
+        /// @brief 缓存总字节预算(头部+Body)
+        size_t maxBytes{64 * 1024 * 1024};
+        /// @brief 可缓存的单个响应上限
+        size_t maxEntryBytes{1024 * 1024};
+        /// @brief 可缓存的方法
+        MethodMask methods{ExpectHttpMethods::Get | ExpectHttpMethods::Head};
+        /// @brief 可缓存的状态码
+        std::vector<int32_t> statusCodes{StateCode::k200Ok};
+        /// @brief 参与键的查询参数，未列出的参数不影响命中
+        std::vector<std::string> queryParams;
+        /// @brief 参与键的请求头(大小写不敏感)
+        std::vector<std::string> varyHeaders;
+        /// @brief 等待同键 leader 的上限，超时后自行执行servlet
+        int64_t coalesceTimeoutMs{5000};
+    };
+
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        /// @brief 等到 leader 结果后命中的请求数
+        uint64_t coalesced{0};
+        /// @brief 过期被移除的条目数
+        uint64_t expired{0};
+        uint64_t stores{0};
+        /// @brief leader 响应不可缓存的次数
+        uint64_t uncacheable{0};
+        /// @brief 绕过缓存的请求数
+        uint64_t bypassed{0};
+        uint64_t evictions{0};
+        size_t bytes{0};
+        size_t entries{0};
+    };
+
+    HttpResponseCache();
+    explicit HttpResponseCache(Config config, const std::string &name = "ResponseCache");
+
+    Action before(const TcpConnectionPtr &conn, const HttpContextPtr &ctx) override;
+    void after(const TcpConnectionPtr &conn, const HttpContextPtr &ctx) override;
+
+    const Config& config() const { return _config; }
+
+    /**
+     * @brief 生成缓存键: 方法、路径、选中的查询参数与 Vary 头取值
+     */
+    std::string makeKey(const HttpRequest &req) const;
+
+    /// @brief 移除某个路径下的全部条目(任意方法/参数/Vary 组合)
+    size_t invalidate(const std::string &path);
+
+    void clear();
+    Stats stats() const;
+
+private:
+    struct Entry {
+        std::string path;
+        int32_t status{0};
+        /// @brief 状态行+头部，不含 Date 与结尾空行
+        SharedBuffer header_keep_alive;
+        SharedBuffer header_close;
+        SharedBuffer body;
+        int64_t expire_ns{0};
+
+        size_t bytes() const { return header_keep_alive->size() + header_close->size() + body->size(); }
+    };
+    using EntryPtr = std::shared_ptr<const Entry>;
+
+    struct EntryWeigher {
+        size_t operator()(const EntryPtr &entry) const { return entry->bytes(); }
+    };
+
+    /// @brief 一次进行中的未命中填充
+    struct Flight {
+        const HttpContext *leader{nullptr};
+        int64_t start_ns{0};
+        bool done{false};
+        EntryPtr entry;
+        std::condition_variable cond;
+    };
+    using FlightPtr = std::shared_ptr<Flight>;
+
+    bool bypass(const HttpRequest &req) const;
+    /// @brief 查找未过期的条目，过期的顺带移除
+    EntryPtr lookup(const std::string &key);
+    /**
+     * @brief 响应可缓存时构建条目
+     * @return 不可缓存返回空
+     */
+    EntryPtr build(const HttpRequest &req, HttpResponse &resp) const;
+    void finish(const std::string &key, const HttpContext *leader, EntryPtr entry);
+
+    static void Serve(HttpResponse &resp, const Entry &entry);
+
+private:
+    const Config _config;
+
+    LruCache<std::string, EntryPtr, EntryWeigher> _cache;
+
+    std::mutex _flightMutex;
+    std::unordered_map<std::string, FlightPtr> _flights;
+
+    std::atomic<uint64_t> _hits{0};
+    std::atomic<uint64_t> _misses{0};
+    std::atomic<uint64_t> _coalesced{0};
+    std::atomic<uint64_t> _expired{0};
+    std::atomic<uint64_t> _stores{0};
+    std::atomic<uint64_t> _uncacheable{0};
+    std::atomic<uint64_t> _bypassed{0};
+};
+
+}   // kit_muduo::http
+#endif
@@ -0,0 +1,52 @@
+/**
+ * @file http_scanner.h
+ * @brief HTTP报文分隔符扫描(SSE4.2/AVX2 加速，运行时按CPU分派)
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 16:10:22
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_SCANNER_H__
+#define __KIT_HTTP_SCANNER_H__
+
+#include <cstdint>
+
+namespace kit_muduo::http {
+
+/**
+ * @brief 扫描实现级别
+ */
+enum class HttpScanLevel: uint8_t
+{
+    kScalar = 0,
+    /// @brief 16字节: pcmpestri 多字符查找 + pcmpeqb 单字符查找
+    kSSE42,
+    /// @brief 32字节: vpcmpeqb
+    kAVX2,
+};
+
+const char* HttpScanLevelName(HttpScanLevel level);
+
+/// @brief 当前CPU支持的最高级别
+HttpScanLevel DetectHttpScanLevel();
+
+/// @brief 当前使用的级别，进程启动时取 DetectHttpScanLevel()
+HttpScanLevel HttpScanLevelInUse();
+
+/**
+ * @brief 切换扫描实现，CPU不支持时返回false且不切换
+ * @note 供基准测试/排查使用，应在解析开始前调用
+ */
+bool SetHttpScanLevel(HttpScanLevel level);
+
+/// @brief 查找 [begin, end) 中第一个 c，找不到返回 nullptr
+const char* HttpFindByte(const char *begin, const char *end, char c);
+
+/// @brief 查找 [begin, end) 中第一个 a 或 b，找不到返回 nullptr
+const char* HttpFindEither(const char *begin, const char *end, char a, char b);
+
+/// @brief 查找第一个 "\r\n"，返回指向 '\r' 的指针，找不到返回 nullptr
+const char* HttpFindCRLF(const char *begin, const char *end);
+
+}   // kit_muduo::http
+#endif
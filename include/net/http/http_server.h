@@ -14,10 +14,14 @@
 #include "net/tcp_server.h"
 #include "net/http/http_servlet.h"
 #include "net/http/http_request.h"
+#include "net/http/http_compressor.h"
+#include "net/http/websocket.h"
+#include "net/http/http2.h"
 #include "net/call_backs.h"
 #include "base/thread_pool.h"
 
 #include <string>
+#include <unordered_map>
 
 
 
@@ -38,7 +42,7 @@ public:
 
     HttpServer(kit_muduo::EventLoop *loop, const InetAddress &addr, const std::string &name, bool isPool = true, TcpServer::Option option = TcpServer::Option::kNoRusePort);
 
-    ~HttpServer() = default;
+    ~HttpServer();
 
     void start();
 
@@ -53,8 +57,27 @@ public:
 
     std::shared_ptr<HttpServletDispatch> getServletDispatch() { return _dispatch; }
 
+    /**
+     * @brief 设置响应压缩器，传空关闭；压缩在业务线程中于servlet处理之后执行
+     * @note 应在 start() 之前设置
+     */
+    void setCompressor(std::shared_ptr<HttpCompressor> compressor) { _compressor = std::move(compressor); }
+    std::shared_ptr<HttpCompressor> compressor() const { return _compressor; }
+
     TcpConnectionPtr getConnection(const std::string &name) { return _server.getConnection(name); }
 
+    /**
+     * @brief 注册内置观测端点(GET)
+     *   {prefix}/metrics            进程指标，Prometheus 文本格式
+     *   {prefix}/debug/connections  本服务器各连接的收发字节数与缓冲区大小(JSON)
+     *   {prefix}/debug/loops        各事件循环的channel、定时器与待执行回调数(JSON)
+     *   {prefix}/debug/trace        已采样请求的追踪区间，Chrome trace-event JSON
+     * @note 快照由各IO线程通过 runInLoop 自行采集，采集完成后在业务线程池中渲染并发送，
+     *       不阻塞IO线程；端点不做鉴权，只应在内网或管理端口上开启
+     * @return 任一路由注册失败时返回 false
+     */
+    bool enableIntrospection(const std::string &prefix = "");
+
 
     RouteResult addRoute(MethodMask methods, const std::string &url, HttpServlet::Ptr svl);
 
@@ -72,6 +95,28 @@ public:
     bool Delete(const std::string &url, HttpServlet::Ptr svl);
     bool Delete(const std::string &url, const FunctionServlet::CallBack &cb);
 
+    // ---- 中间件 ----
+    /// @brief 全局中间件，见 HttpServletDispatch::use
+    void use(HttpMiddleware::Ptr middleware) { _dispatch->use(std::move(middleware)); }
+    /// @brief 只对 pattern 以 routePrefix 开头的路由生效的中间件
+    void use(const std::string &routePrefix, HttpMiddleware::Ptr middleware) { _dispatch->use(routePrefix, std::move(middleware)); }
+    size_t removeMiddleware(const std::string &name) { return _dispatch->removeMiddleware(name); }
+
+    // ---- WebSocket ----
+    /**
+     * @brief 在 path 上接受 WebSocket 升级(精确匹配路径)
+     * @note 握手在IO线程中完成，不经过业务线程池与中间件；应在 start() 之前注册
+     */
+    void addWebSocket(const std::string &path, WebSocketHandler::Ptr handler, WebSocketCodec::Config config = {});
+
+    // ---- HTTP/2 ----
+    /**
+     * @brief 开启 h2c: 以连接前言开头的连接(先验知识)直接进入 HTTP/2，
+     *        带 "Upgrade: h2c" 与 HTTP2-Settings 且无Body的请求升级后以流1响应
+     * @note 每个流与 HTTP/1 请求一样经业务线程池与中间件分发；应在 start() 之前调用
+     */
+    void enableHttp2(Http2Session::Config config = {});
+
     // ---- 删 ----
     bool removeRoute(uint64_t route_id);
     size_t removeRoute(const std::string &pattern, MethodMask methods);
@@ -85,11 +130,30 @@ public:
 
 private:
     void onConnect(TcpConnectionPtr conn);
+    /// @brief 为连接创建新的请求上下文(挂接Body接收器选择)
+    HttpContextPtr newContext(const TcpConnectionPtr &conn);
     void onMessage(TcpConnectionPtr conn, Buffer *buf, TimeStamp receiveTime);
 
     // http服务器默认处理函数
     void handleRequest(TcpConnectionPtr conn, HttpContextPtr ctx);
 
+    /**
+     * @brief 请求为已注册路径上的升级请求时完成(或拒绝)握手
+     * @return false 表示不是 WebSocket 请求，按普通HTTP请求处理
+     */
+    bool upgradeWebSocket(const TcpConnectionPtr &conn, const HttpContextPtr &ctx, Buffer *buf);
+
+    /// @brief 连接转为 HTTP/2: 连接级上下文改为持有会话
+    Http2Session::Ptr startHttp2(const TcpConnectionPtr &conn);
+    /**
+     * @brief 请求为 h2c 升级请求时完成升级
+     * @return false 表示不升级，按普通HTTP请求处理
+     */
+    bool upgradeHttp2(const TcpConnectionPtr &conn, const HttpContextPtr &ctx, Buffer *buf);
+
+    /// @brief 异步采集IO线程快照，完成后渲染 JSON 并发送延迟响应
+    void replySnapshot(const TcpConnectionPtr &conn, const HttpContextPtr &ctx, bool withConnections);
+
 private:
     TcpServer _server;
     HttpCallBack _httpCallBack;
@@ -97,6 +161,21 @@ private:
     std::shared_ptr<HttpServletDispatch> _dispatch;
     bool _isPool;   // 是否使用线程池
     BusinessThreadPoolConfig _businessThreadPoolConfig;
+    /// @brief 响应压缩器，为空时不压缩
+    std::shared_ptr<HttpCompressor> _compressor;
+    /// @brief 每秒刷新 Date 头的定时器
+    std::shared_ptr<Timer> _dateTimer;
+
+    struct WebSocketRoute {
+        WebSocketHandler::Ptr handler;
+        WebSocketCodec::Config config;
+    };
+    /// @brief 路径 -> WebSocket 处理器，启动后只读
+    std::unordered_map<std::string, WebSocketRoute> _webSockets;
+
+    /// @brief 是否接受 h2c
+    bool _http2Enabled{false};
+    Http2Session::Config _http2Config;
 };
 
 
@@ -9,15 +9,22 @@
 #ifndef __KIT_HTTP_SERVLET_H__
 #define __KIT_HTTP_SERVLET_H__
 
+#include "base/noncopyable.h"
 #include "net/call_backs.h"
 #include "net/http/http_request.h"
 #include "net/http/http_router.h"
+#include "net/http/http_body_sink.h"
+#include "net/http/http_file_cache.h"
+#include "net/http/http_asset_cache.h"
+#include "net/http/http_compressor.h"
+#include "net/http/http_middleware.h"
 
 #include <string>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 #include <mutex>
+#include <atomic>
 #include <cstdint>
 
 namespace kit_muduo {
@@ -86,6 +93,22 @@ public:
 
     virtual void handle(TcpConnectionPtr conn, HttpContextPtr ctx) = 0;
 
+    /**
+     * @brief 请求头解析完成后(Body到达前)调用，返回非空时Body以流式交给接收器，
+     *        不再累积到 request()->body()；handle 中可通过 ctx->bodySink() 取回
+     * @note 运行在IO线程，此时路由参数已可用
+     */
+    virtual HttpBodySink::Ptr createBodySink(TcpConnectionPtr conn, HttpContextPtr ctx) { return nullptr; }
+
+    /**
+     * @brief 请求完整接收后、交给业务线程之前调用，同一连接上按请求到达顺序进行
+     * @note 运行在IO线程，只对 needsPrepare() 为真的servlet调用；
+     *       用于必须按连接内请求顺序登记的状态(如代理的流水线响应队列)
+     */
+    virtual void prepare(TcpConnectionPtr conn, HttpContextPtr ctx) {}
+    /// @brief 是否需要 prepare，路由表发布时读取
+    virtual bool needsPrepare() const { return false; }
+
     void setName(const std::string &name) { _name = name; }
     std::string name() const { return _name; }
 
@@ -200,16 +223,67 @@ public:
 
 /**
  * @brief 静态文件服务类（获取静态资源等文件）
+ * @note 描述符与元数据经 HttpFileCache 缓存，Body以sendfile零拷贝发送；
+ *       支持 ETag/Last-Modified 条件请求(304)与单/多区间 Range(206/416)。
+ *       小文件的完整响应另由 HttpAssetCache 缓存，命中时直接发送预序列化的头部与内容
  */
 class StaticFileServlet: public HttpServlet
 {
 public:
+    /// @brief 单个请求最多处理的Range区间数，超出时按完整内容返回
+    static constexpr size_t kMaxRanges = 16;
+
+    /// @brief 兼容旧目录布局: web/<后缀>/<文件名>
     StaticFileServlet();
 
+    /**
+     * @param[in] rootDir 根目录
+     * @param[in] urlPrefix 路由前缀(如 "/static")，请求路径去掉前缀后拼接在根目录后
+     * @param[in] cache 文件缓存，为空时内部创建，可在多个servlet间共享
+     */
+    explicit StaticFileServlet(const std::string &rootDir, const std::string &urlPrefix = "",
+                               std::shared_ptr<HttpFileCache> cache = nullptr);
+
     ~StaticFileServlet() = default;
 
     void handle(TcpConnectionPtr conn, HttpContextPtr ctx) override;
 
+    HttpFileCache& fileCache() { return *_cache; }
+
+    /// @brief 设置热点资源缓存，传空关闭
+    void setAssetCache(std::shared_ptr<HttpAssetCache> cache) { _asset_cache = std::move(cache); }
+    std::shared_ptr<HttpAssetCache> assetCache() const { return _asset_cache; }
+
+    /**
+     * @brief 设置压缩器，传空关闭(默认关闭)
+     * @note 可压缩类型的完整GET按 Accept-Encoding 协商: 存在同名 .gz 时直接 sendfile 发送，
+     *       否则读入压缩并按 ETag 缓存；Range 请求与超过缓存单项上限的文件仍发送原文
+     */
+    void setCompressor(std::shared_ptr<HttpCompressor> compressor) { _compressor = std::move(compressor); }
+    std::shared_ptr<HttpCompressor> compressor() const { return _compressor; }
+
+    /// @brief 根据文件后缀获取MIME类型，未知类型返回 application/octet-stream
+    static const char* MimeType(const std::string &suffix);
+
+    /// @brief 请求路径映射到磁盘路径，包含 ".." 等非法路径时返回空
+    std::string resolvePath(const std::string &path) const;
+
+private:
+    /**
+     * @brief 以 encoding 发送压缩表示(预压缩文件或缓存的压缩结果)
+     * @return 未生成响应(无预压缩文件且不宜现场压缩)时返回 false，由调用方发送原文
+     */
+    bool handleCompressed(const HttpContextPtr &ctx, HttpCompressor &compressor, HttpEncoding encoding,
+                          const std::string &targetPath, const HttpFileCache::Entry &entry, const std::string &mime);
+
+private:
+    std::string _root_dir;
+    std::string _url_prefix;
+    /// @brief 是否使用旧目录布局
+    bool _legacy_layout;
+    std::shared_ptr<HttpFileCache> _cache;
+    std::shared_ptr<HttpAssetCache> _asset_cache;
+    std::shared_ptr<HttpCompressor> _compressor;
 };
 
 
@@ -224,6 +298,16 @@ public:
 
     void handle(TcpConnectionPtr conn, HttpContextPtr ctx);
 
+    /**
+     * @brief 按路由找到servlet并询问其Body接收器，未命中或servlet不需要时返回空
+     */
+    HttpBodySink::Ptr createBodySink(TcpConnectionPtr conn, HttpContextPtr ctx);
+
+    /**
+     * @brief 按路由调用servlet的 prepare，没有servlet需要时只读一次快照
+     */
+    void prepare(TcpConnectionPtr conn, HttpContextPtr ctx);
+
     RouteResult addRoute(MethodMask methods, const std::string &pattern, HttpServlet::Ptr servlet);
     RouteResult addRoute(MethodMask methods, const std::string &pattern, const FunctionServlet::CallBack &cb);
 
@@ -252,6 +336,26 @@ public:
     /// 列出指定 pattern 下所有 method 的路由。
     std::vector<RouteInfo> listRoutes(const std::string &pattern) const;
 
+    // ---- 中间件 ----
+
+    /**
+     * @brief 注册全局中间件，对所有请求(含 404/405)生效
+     * @note 中间件与路由一起编译进路由表快照，分发时按下标遍历扁平数组，不做任何分配
+     */
+    void use(HttpMiddleware::Ptr middleware);
+
+    /**
+     * @brief 注册路由级中间件，只对 pattern 以 routePrefix 开头的路由生效
+     * @param[in] routePrefix 如 "/api/"，按路由注册时的 pattern 匹配而非请求路径
+     */
+    void use(const std::string &routePrefix, HttpMiddleware::Ptr middleware);
+
+    /// @brief 按名称删除中间件，返回删除的个数
+    size_t removeMiddleware(const std::string &name);
+
+    /// @brief 分发时未拿到读者槽位、退回 shared_ptr 持有快照的次数(槽位用尽或同线程重入)
+    uint64_t snapshotFallbacks() const { return _snapshotFallbacks.load(std::memory_order_relaxed); }
+
 private:
     struct RouteEntry {
         uint64_t id{0};
@@ -261,24 +365,115 @@ private:
         RouterMatcher::Ptr matcher;
         HttpServlet::Ptr servlet;
         int priority{0};
+        /// @brief 编译后的中间件链(全局 + 前缀匹配的路由级)
+        MiddlewareChain chain;
+    };
+
+    struct MiddlewareEntry {
+        /// @brief 为空表示全局中间件
+        std::string route_prefix;
+        HttpMiddleware::Ptr middleware;
     };
 
+    /// @brief 路由表快照，发布后只读；增删路由时整表拷贝再原子替换(RCU)
+    struct RouteTable {
+        std::unordered_map<std::string, std::vector<RouteEntry>> exact_routes;
+        std::vector<RouteEntry> dynamic_routes;
+        /// @brief 按注册顺序保存的中间件
+        std::vector<MiddlewareEntry> middlewares;
+        /// @brief 未命中路由时执行的中间件链(仅全局中间件)
+        MiddlewareChain default_chain;
+        /// @brief 是否有路由的servlet需要 prepare
+        bool has_prepare{false};
+    };
+    using RouteTablePtr = std::shared_ptr<const RouteTable>;
+
+    /// @brief 读侧 hazard 槽位数，同时存活的分发线程超出时退回 shared_ptr 持有快照
+    static constexpr size_t kReaderSlots = 128;
+
+    /// @brief 每个读线程独占一个槽位，记录正在使用的快照，写侧据此判断旧快照能否回收
+    struct alignas(64) ReaderSlot {
+        std::atomic<const RouteTable*> hazard{nullptr};
+    };
+
+    /**
+     * @brief 分发期间保护快照不被回收
+     * @note 常规路径只写本线程在本实例中的槽位，无锁、无引用计数操作；
+     *       槽位用尽或同线程重入分发时改为持有 shared_ptr
+     */
+    class SnapshotGuard: Noncopyable
+    {
+    public:
+        explicit SnapshotGuard(HttpServletDispatch &dispatch);
+        ~SnapshotGuard();
+
+        const RouteTable& table() const { return *_table; }
+
+    private:
+        HttpServletDispatch &_dispatch;
+        ReaderSlot *_slot{nullptr};
+        const RouteTable *_table{nullptr};
+        RouteTablePtr _hold;
+    };
+
+    /**
+     * @brief 写侧持有 route_mtx_，解锁后补做持锁期间读者未能完成的回收
+     */
+    class WriteLock: Noncopyable
+    {
+    public:
+        explicit WriteLock(HttpServletDispatch &dispatch);
+        ~WriteLock();
+
+    private:
+        HttpServletDispatch &_dispatch;
+        std::unique_lock<std::mutex> _lock;
+    };
+
+    /// @brief 只引用快照中的条目，快照由调用方的 SnapshotGuard 保护
     struct MatchResult {
         MatchStatus status{MatchStatus::NotFound};
-        HttpServlet::Ptr servlet;
+        HttpServlet *servlet{nullptr};
+        const MiddlewareChain *chain{nullptr};
         MethodMask allowed_methods{ExpectHttpMethods::None};
     };
 
     RouteKind routeKind(const std::string &pattern) const;
     RouterMatcher::Ptr createMatcher(RouteKind kind, const std::string &pattern) const;
-    MatchResult match(HttpContextPtr ctx);
+    MatchResult match(const RouteTable &table, HttpContextPtr ctx);
     bool hasMethodConflict(const std::vector<RouteEntry> &routes, MethodMask methods, MethodMask *conflict_methods) const;
 
+    /// @brief 命中路由或默认servlet的处理(不含中间件)
+    void dispatch(const TcpConnectionPtr &conn, const HttpContextPtr &ctx, const MatchResult &result);
+    /// @brief 按中间件注册表重新编译各路由的中间件链，发布前调用
+    static void compileChains(RouteTable &table);
+    /// @brief 写侧拷贝当前快照，调用方需持有 route_mtx_
+    std::shared_ptr<RouteTable> cloneTable() const;
+    /// @brief 写侧发布新快照并尝试回收旧快照，调用方需持有 route_mtx_
+    void publish(std::shared_ptr<RouteTable> table);
+    /// @brief 释放没有读者引用的旧快照，调用方需持有 route_mtx_
+    void reclaim();
+    /// @brief 读侧退出时顺带回收，拿不到锁时留下标记，由持锁者解锁后补做
+    void tryReclaim();
+    /// @brief 处理回收标记，调用方不能持有 route_mtx_
+    void drainReclaim();
+
     HttpServlet::Ptr _defaultSvl;
-    std::unordered_map<std::string, std::vector<RouteEntry>> exact_routes_;
-    std::vector<RouteEntry> dynamic_routes_;
+    /// @brief 当前快照的所有者，仅通过 std::atomic_load/atomic_store 访问
+    RouteTablePtr _table;
+    /// @brief 当前快照的裸指针，读侧据此登记 hazard
+    std::atomic<const RouteTable*> _current{nullptr};
+    /// @brief 本实例的读者槽位，下标为线程序号
+    std::unique_ptr<ReaderSlot[]> _readers;
+    /// @brief 已被替换但可能仍有读者的旧快照，受 route_mtx_ 保护
+    std::vector<RouteTablePtr> _retired;
+    std::atomic<bool> _hasRetired{false};
+    /// @brief 有读者因拿不到锁而未完成回收
+    std::atomic<bool> _reclaimPending{false};
+    std::atomic<uint64_t> _snapshotFallbacks{0};
     uint64_t next_route_id_{1};
     int next_priority_{0};
+    /// @brief 仅串行化写者，读路径不加锁
     mutable std::mutex route_mtx_;
 
 };
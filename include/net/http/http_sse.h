@@ -0,0 +1,197 @@
+/**
+ * @file http_sse.h
+ * @brief Server-Sent Events: 事件编码与按主题共享缓冲的扇出
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 00:12:44
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_SSE_H__
+#define __KIT_HTTP_SSE_H__
+
+#include "base/noncopyable.h"
+#include "net/call_backs.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace kit_muduo {
+
+class EventLoop;
+class Timer;
+
+namespace http {
+
+/**
+ * @brief 一条 SSE 事件
+ */
+struct SseEvent
+{
+    /// @brief 非空时客户端记为 Last-Event-ID，断线重连时带回
+    std::string id;
+    /// @brief 事件类型，空表示默认的 message
+    std::string event;
+    /// @brief 事件数据，含换行时拆为多行 data
+    std::string data;
+    /// @brief 大于等于0时下发客户端重连间隔
+    int64_t retryMs{-1};
+};
+
+/**
+ * @brief 按 text/event-stream 格式编码(以空行结束)
+ * @note id/event 中的 CR/LF 会被去掉，data 中的 CRLF、CR、LF 都视为换行
+ */
+std::string EncodeSseEvent(const SseEvent &event);
+
+/**
+ * @brief SSE 主题: 一次编码，所有订阅者共享同一份缓冲
+ *
+ * 用法(在servlet中):
+ *   topic->subscribe(conn, ctx);   // 发送响应头，连接保持打开
+ *   ...
+ *   topic->publish(SseEvent{"42", "viewers", "1024"});   // 任意线程
+ *
+ * 分帧: HTTP/1.1 用 chunked，chunk 头与事件体分别共享，订阅者的发送队列只引用这些缓冲；
+ *       HTTP/1.0 不带长度，以关闭连接结束。
+ *
+ * 慢订阅者: 待发送字节加上本条事件超过 maxPendingBytes 时按 dropPolicy 处理:
+ *   - kDropEvent:  跳过本条事件(客户端可从事件 id 的跳变发现丢失)，
+ *                  持续超限超过 stallTimeoutMs 后断开
+ *   - kDisconnect: 立即断开，客户端按 retry 重连后由 Last-Event-ID 补发
+ *
+ * 定时器: heartbeatMs > 0 时在 loop 上周期发送注释行保活(防代理空闲断开)并检查慢订阅者，
+ *         首个订阅者加入时启动，主题析构时取消。
+ */
+class SseTopic: public std::enable_shared_from_this<SseTopic>, Noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<SseTopic>;
+
+    enum class DropPolicy {
+        kDropEvent,
+        kDisconnect,
+    };
+
+    struct Config {
+        /// @brief 单个订阅者允许积压的字节数
+        size_t maxPendingBytes{1024 * 1024};
+        DropPolicy dropPolicy{DropPolicy::kDropEvent};
+        /// @brief kDropEvent 下持续超限多久后断开，0 表示不断开
+        int64_t stallTimeoutMs{30 * 1000};
+        /// @brief 心跳间隔，0 表示关闭
+        int64_t heartbeatMs{15 * 1000};
+        /// @brief 保留最近多少条带 id 的事件用于断线补发，0 表示不补发
+        size_t replayEvents{0};
+        /// @brief 大于等于0时订阅时下发 retry
+        int64_t retryMs{-1};
+    };
+
+    struct Stats {
+        size_t subscribers{0};
+        uint64_t published{0};
+        /// @brief 投递到订阅者发送队列的事件数
+        uint64_t delivered{0};
+        /// @brief 因积压被跳过的事件数
+        uint64_t dropped{0};
+        /// @brief 因积压被断开的订阅者数
+        uint64_t evicted{0};
+        /// @brief 订阅时补发的事件数
+        uint64_t replayed{0};
+    };
+
+    /**
+     * @param[in] loop 运行心跳定时器的事件循环
+     */
+    SseTopic(EventLoop *loop, const std::string &name, Config config);
+    ~SseTopic();
+
+    /**
+     * @brief 在servlet中调用: 发送 200 text/event-stream 响应头并订阅本主题
+     * @note 请求带 Last-Event-ID 且仍在补发窗口内时，先补发其后的事件；
+     *       响应标记为流式，HttpServer 不再另行发送
+     * @return 连接已断开时返回 false
+     */
+    bool subscribe(const TcpConnectionPtr &conn, const HttpContextPtr &ctx);
+
+    /**
+     * @brief 退订，连接断开时自动调用，线程安全
+     */
+    void unsubscribe(const TcpConnectionPtr &conn);
+
+    /**
+     * @brief 发布事件，线程安全
+     * @return 投递到的订阅者数
+     */
+    size_t publish(const SseEvent &event);
+    size_t publish(std::string_view data);
+
+    /**
+     * @brief 结束全部订阅者的响应并关闭连接
+     */
+    void close();
+
+    const std::string& name() const { return _name; }
+    const Config& config() const { return _config; }
+    size_t subscribers() const;
+    Stats stats() const;
+
+private:
+    struct Subscriber {
+        std::weak_ptr<TcpConnection> conn;
+        /// @brief HTTP/1.1 chunked 分帧
+        bool chunked{true};
+        /// @brief 开始持续超限的时间(ns)，0 表示未超限
+        int64_t stalledSinceNs{0};
+    };
+
+    /// @brief 一条已编码的事件: chunk 头 + 事件体 + CRLF 三块共享缓冲
+    struct Frame {
+        SharedBuffer chunkHead;
+        SharedBuffer body;
+    };
+
+    struct ReplayEntry {
+        std::string id;
+        Frame frame;
+    };
+
+    static Frame MakeFrame(std::string body);
+
+    /**
+     * @brief 向所有订阅者投递，顺带清理尚未退订的已断开订阅者；需持有 _mutex
+     * @param[in] droppable 心跳等可丢的帧不计入统计
+     */
+    size_t fanOutUnLocked(const Frame &frame, bool droppable);
+    /// @brief 按订阅者的分帧方式发送
+    static void SendFrame(const TcpConnectionPtr &conn, const Subscriber &sub, const Frame &frame);
+
+    void onHeartbeat();
+    void removeUnLocked(std::unordered_map<const TcpConnection*, Subscriber>::iterator it);
+
+private:
+    EventLoop *_loop;
+    const std::string _name;
+    const Config _config;
+
+    mutable std::mutex _mutex;
+    std::unordered_map<const TcpConnection*, Subscriber> _subscribers;
+    std::deque<ReplayEntry> _replay;
+    std::shared_ptr<Timer> _heartbeatTimer;
+    bool _closed{false};
+
+    std::atomic<uint64_t> _published{0};
+    std::atomic<uint64_t> _delivered{0};
+    std::atomic<uint64_t> _dropped{0};
+    std::atomic<uint64_t> _evicted{0};
+    std::atomic<uint64_t> _replayed{0};
+};
+
+}   // http
+}   // kit_muduo
+#endif
@@ -0,0 +1,106 @@
+/**
+ * @file http_stream_writer.h
+ * @brief HTTP流式响应写出器
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 14:05:21
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_STREAM_WRITER_H__
+#define __KIT_HTTP_STREAM_WRITER_H__
+
+#include "base/noncopyable.h"
+#include "net/call_backs.h"
+
+#include <memory>
+#include <string>
+#include <cstdint>
+
+namespace kit_muduo::http {
+
+/**
+ * @brief 流式响应：先发送头部，再分多次推送Body，不需要整体缓存响应
+ *
+ * 用法(在servlet中):
+ *   resp->setStateCode(StateCode::k200Ok);
+ *   resp->addHeader("Content-Type", "video/mp4");
+ *   HttpStreamWriter writer(conn, ctx);
+ *   while(...) { if(!writer.write(chunk)) break; }
+ *   writer.end();
+ *
+ * 分帧方式:
+ *   - 已设置 Content-Length：按原样写出，字节数需与之一致
+ *   - HTTP/1.1：Transfer-Encoding: chunked
+ *   - HTTP/1.0：不带长度，写完后关闭连接
+ *
+ * 背压: 连接待发送字节超过高水位时，write 在业务线程中阻塞到低水位以下；
+ * 在IO线程中调用不会阻塞，数据直接进入输出缓冲区。
+ */
+class HttpStreamWriter: Noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<HttpStreamWriter>;
+
+    enum class Mode {
+        kChunked,
+        kContentLength,
+        kCloseDelimited,
+    };
+
+    HttpStreamWriter(TcpConnectionPtr conn, HttpContextPtr ctx);
+
+    /// @brief 未调用 end() 时自动结束响应
+    ~HttpStreamWriter();
+
+    /**
+     * @brief 设置背压参数，需在 begin() 之前调用
+     * @param[in] highWaterMark 待发送字节超过该值时阻塞
+     * @param[in] lowWaterMark 阻塞直到待发送字节不高于该值
+     * @param[in] timeoutMs 单次等待超时，小于0表示一直等待
+     */
+    void setBackpressure(size_t highWaterMark, size_t lowWaterMark, int32_t timeoutMs);
+
+    /**
+     * @brief 发送状态行与头部，首次 write 时会自动调用
+     */
+    bool begin();
+
+    bool write(const char *data, size_t len);
+    bool write(const std::string &data) { return write(data.data(), data.size()); }
+
+    /**
+     * @brief 结束响应(发送 chunked 结束块)，必要时关闭连接
+     */
+    bool end();
+
+    bool ok() const { return !_failed; }
+    bool begun() const { return _begun; }
+    bool ended() const { return _ended; }
+    Mode mode() const { return _mode; }
+    /// @brief 已写出的Body字节数(不含分帧开销)
+    uint64_t bodyBytes() const { return _bodyBytes; }
+
+private:
+    bool waitWritable();
+    void fail(const char *reason);
+
+private:
+    TcpConnectionPtr _conn;
+    HttpContextPtr _ctx;
+    Mode _mode{Mode::kChunked};
+    bool _begun{false};
+    bool _ended{false};
+    bool _failed{false};
+    /// @brief HEAD 或 204/304 等不允许携带Body的响应
+    bool _noBody{false};
+    uint64_t _bodyBytes{0};
+    uint64_t _contentLength{0};
+
+    size_t _highWaterMark;
+    size_t _lowWaterMark;
+    int32_t _timeoutMs;
+};
+
+}   // kit_muduo::http
+
+#endif
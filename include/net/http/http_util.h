@@ -18,13 +18,15 @@
 #include <memory>
 #include <iostream>
 #include <vector>
+#include <ctime>
+#include <string_view>
 
 
 namespace kit_muduo::http {
 
 struct Version
 {
-    enum { kUnknow, kHttp10, kHttp11, kRtsp10};
+    enum { kUnknow, kHttp10, kHttp11, kRtsp10, kHttp20};
 
 
     explicit Version(int32_t version = kUnknow): m_version(version) { }
@@ -40,6 +42,7 @@ struct Version
             case kHttp10: return "HTTP/1.0";
             case kHttp11: return "HTTP/1.1";
             case kRtsp10: return "RTSP/1.0";
+            case kHttp20: return "HTTP/2";
             
             default:
                 return "";
@@ -125,6 +128,87 @@ private:
     int32_t m_content_type{kUnknowType};
 };
 
+/**
+ * @brief 已知状态码及原因短语，状态行与原因短语表都由它在编译期展开
+ */
+#define KIT_HTTP_STATUS_MAP(XX) \
+    XX(101, "Switching Protocols") \
+    XX(200, "OK") \
+    XX(204, "No Content") \
+    XX(206, "Partial Content") \
+    XX(301, "Moved Permanently") \
+    XX(302, "Move temporarily") \
+    XX(304, "Not Modified") \
+    XX(400, "Bad Request") \
+    XX(403, "Forbidden") \
+    XX(404, "Not Found") \
+    XX(405, "Method Not Allowed") \
+    XX(412, "Precondition Failed") \
+    XX(416, "Range Not Satisfiable") \
+    XX(426, "Upgrade Required") \
+    XX(431, "Request Header Fields Too Large") \
+    XX(454, "Session Not Found") \
+    XX(455, "Method Not Valid") \
+    XX(459, "Aggregate Operation Not Allowed") \
+    XX(461, "Unsupported Transport") \
+    XX(500, "Internal Server Error") \
+    XX(502, "Bad Gateway") \
+    XX(503, "Service Unavailable") \
+    XX(504, "Gateway Timeout")
+
+/// @brief 状态码对应的原因短语，未知状态码返回空
+constexpr std::string_view HttpReasonPhrase(int32_t code)
+{
+    switch(code)
+    {
+#define XX(code, reason) case code: return reason;
+        KIT_HTTP_STATUS_MAP(XX)
+#undef XX
+        default: return std::string_view();
+    }
+}
+
+/**
+ * @brief 预先拼好的状态行，如 "HTTP/1.1 200 OK\r\n"
+ * @return 未知版本或状态码返回空，由调用方自行拼接
+ */
+constexpr std::string_view HttpStatusLine(int32_t version, int32_t code)
+{
+    switch(version)
+    {
+        case Version::kHttp11:
+            switch(code)
+            {
+#define XX(code, reason) case code: return "HTTP/1.1 " #code " " reason "\r\n";
+                KIT_HTTP_STATUS_MAP(XX)
+#undef XX
+                default: break;
+            }
+            break;
+        case Version::kHttp10:
+            switch(code)
+            {
+#define XX(code, reason) case code: return "HTTP/1.0 " #code " " reason "\r\n";
+                KIT_HTTP_STATUS_MAP(XX)
+#undef XX
+                default: break;
+            }
+            break;
+        case Version::kRtsp10:
+            switch(code)
+            {
+#define XX(code, reason) case code: return "RTSP/1.0 " #code " " reason "\r\n";
+                KIT_HTTP_STATUS_MAP(XX)
+#undef XX
+                default: break;
+            }
+            break;
+        default:
+            break;
+    }
+    return std::string_view();
+}
+
 /**
  * @brief 响应状态码
  */
@@ -133,22 +217,34 @@ struct StateCode
     enum
     {
         kUnknow = 0,
+        //1XX
+        k101SwitchingProtocols = 101,
         //2XX
         k200Ok = 200,
         k204NoContent = 204, 
+        k206PartialContent = 206,
         //3XX
         k301MovedPermanently = 301,
         k302MoveTemporarily = 302,
+        k304NotModified = 304,
         //4XX
         k400BadRequest = 400,
         k403Forbidden = 403,
         k404NotFound = 404,
         k405MethodNotAllowed = 405,
+        k412PreconditionFailed = 412,
+        k416RangeNotSatisfiable = 416,
+        k426UpgradeRequired = 426,
+        k431RequestHeaderFieldsTooLarge = 431,
         k454SessionNotFound = 454,
         k455MethodNotValid = 455,
+        k459AggregateOperationNotAllowed = 459,
+        k461UnsupportedTransport = 461,
         //5XX
         k500InternalServerError = 500,
+        k502BadGateway = 502,
         k503ServiceUnavailable = 503,
+        k504GatewayTimeout = 504,
         kMax,
     };
 
@@ -172,21 +268,16 @@ struct StateCode
     static StateCode FromString(const std::string &str)
     {
         int32_t code = std::atoi(str.c_str());
-        auto it = s_m_codeMessageMap.find(code);
-
-        return it == s_m_codeMessageMap.end() ? StateCode() : StateCode(code);
+        return HttpReasonPhrase(code).empty() ? StateCode() : StateCode(code);
     }
 
-    std::string message() const
-    {
-        return s_m_codeMessageMap[m_code];
-    }
-private:
-    static std::unordered_map<int32_t, std::string> s_m_codeMessageMap;
+    std::string message() const { return std::string(HttpReasonPhrase(m_code)); }
+
+    /// @brief 原因短语视图，指向编译期常量
+    std::string_view reason() const { return HttpReasonPhrase(m_code); }
 
 private:
     int32_t m_code;
-    std::string m_message;
 };
 
 
@@ -243,9 +334,17 @@ public:
         _data.insert(_data.end(), data.begin(), data.end());
     }
 
+    /// @brief 供 JsonWriter 等流式写入器直接追加到Body
+    void append(const char *start, size_t len) { appendData(start, len); }
+    void push_back(char c) { _data.push_back(c); }
+    void reserve(size_t len) { _data.reserve(len); }
+
     void reset() { _data.clear(); }
 
     std::vector<char> data() const { return _data; }
+    /// @brief 原始数据视图，Body被修改前有效
+    std::string_view view() const { return std::string_view(_data.data(), _data.size()); }
+    size_t size() const { return _data.size(); }
     std::string toString() const
     {
         return std::string(_data.begin(), _data.end());
@@ -275,6 +374,17 @@ private:
     // std::shared_ptr<ContentParser> _contentParser;
 };
 
+/**
+ * @brief 格式化为 HTTP-date(RFC 7231 IMF-fixdate)，如 "Sun, 06 Nov 1994 08:49:37 GMT"
+ */
+std::string FormatHttpDate(time_t t);
+
+/**
+ * @brief 解析 IMF-fixdate 格式的 HTTP-date
+ * @return 格式不合法时返回 false
+ */
+bool ParseHttpDate(const std::string &str, time_t *out);
+
 }
 
 #endif
@@ -0,0 +1,131 @@
+/**
+ * @file http_video.h
+ * @brief 视频分发: HLS 播放列表生成、分片/MP4 按类型与区间发送、共享分片内存缓存
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 09:12:40
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_HTTP_VIDEO_H__
+#define __KIT_HTTP_VIDEO_H__
+
+#include "net/http/http_servlet.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace kit_muduo::http {
+
+/**
+ * @brief 视频分发 servlet
+ *
+ * 文件本身(.mp4/.ts/.m4s/.m3u8 等)交给内部的 StaticFileServlet 发送，沿用其
+ * ETag/304/Range/206 处理，默认直接从源文件 sendfile，由页缓存承担热点分片。
+ * 可选的分片缓存(segmentCacheBytes > 0)以 memfd 保存分片副本、所有 IO 线程共享，
+ * 用于页缓存可能挤出直播分片的场景；页缓存充足时它只会重复占用内存且吞吐略低。
+ *
+ * 请求的 .m3u8 不存在时按所在目录的分片生成播放列表:
+ *   - 分片为目录下的 .ts(优先)或 .m4s 文件，按文件名中的数字自然排序
+ *   - .ts 分片时长取相邻分片首个 PES 的 PTS 差，末个分片与 .m4s 使用 targetDuration
+ *   - .m4s 分片存在 init.mp4 时输出 EXT-X-MAP
+ *   - 最新分片修改时间在 liveThresholdMs 内视为直播: 只列出最近 liveWindow 个分片，
+ *     不带 ENDLIST；修改时间不足 settleMs 的分片视为仍在写入，不列出
+ *   - 否则视为点播，输出全部分片与 ENDLIST
+ * 生成结果按目录缓存 playlistTtlMs。
+ *
+ * 路由通配符不跨 '/'，视频目录有几层就按层数注册几条通配路由(前缀后跟 1 个、2 个 '*' 段...)。
+ */
+class VideoServlet: public HttpServlet
+{
+public:
+    using Ptr = std::shared_ptr<VideoServlet>;
+
+    struct Config {
+        /// @brief 无法从分片得到时长时使用的分片时长(秒)
+        double targetDuration{6.0};
+        /// @brief 直播播放列表保留的分片数
+        size_t liveWindow{6};
+        /// @brief 最新分片修改时间在此范围内视为直播
+        int64_t liveThresholdMs{30 * 1000};
+        /// @brief 修改时间距今不足此值的分片视为仍在写入
+        int64_t settleMs{500};
+        /// @brief 生成的播放列表缓存时长
+        int64_t playlistTtlMs{1000};
+        /// @brief 分片缓存总预算与单个分片上限，默认 0 不缓存分片
+        /// @note bench_video_viewers(页缓存充足)下开启缓存磁盘读取量不变、吞吐低 6%~12%，
+        ///       且与页缓存重复占用内存；首次填充在请求线程上同步拷贝整个分片(至多 maxSegmentBytes)。
+        ///       仅在页缓存紧张、需要直播分片常驻内存时开启
+        size_t segmentCacheBytes{0};
+        size_t maxSegmentBytes{8 * 1024 * 1024};
+    };
+
+    struct Stats {
+        /// @brief 实际扫描目录生成的次数
+        uint64_t playlistBuilds{0};
+        /// @brief 命中已生成播放列表的次数
+        uint64_t playlistHits{0};
+    };
+
+    /**
+     * @param[in] rootDir 视频根目录
+     * @param[in] urlPrefix 路由前缀(如 "/video")
+     */
+    VideoServlet(const std::string &rootDir, const std::string &urlPrefix);
+    VideoServlet(const std::string &rootDir, const std::string &urlPrefix, Config config);
+
+    void handle(TcpConnectionPtr conn, HttpContextPtr ctx) override;
+
+    StaticFileServlet& files() { return _files; }
+    /// @brief 分片缓存，segmentCacheBytes 为 0 时为空
+    std::shared_ptr<HttpAssetCache> segmentCache() const { return _files.assetCache(); }
+    const Config& config() const { return _config; }
+    Stats stats() const;
+
+    /**
+     * @brief 扫描目录生成播放列表
+     * @param[in] nowMs 当前墙钟时间(毫秒)，与文件修改时间比较
+     * @param[out] live 是否按直播生成
+     * @return 目录不存在或没有分片时返回 false
+     */
+    bool buildPlaylist(const std::string &dir, int64_t nowMs, std::string *playlist, bool *live);
+
+    /**
+     * @brief 读取 MPEG-TS 数据中第一个带 PTS 的 PES 的 PTS(90kHz)
+     * @return 找不到时返回 -1
+     */
+    static int64_t ProbeTsPts(const char *data, size_t len);
+
+private:
+    struct PlaylistEntry {
+        std::string text;
+        bool live{false};
+        int64_t builtMs{0};
+    };
+
+    /// @brief 分片首个 PTS，按 inode/大小/修改时间缓存
+    struct PtsEntry {
+        uint64_t inode{0};
+        uint64_t size{0};
+        int64_t mtimeNs{0};
+        int64_t pts{-1};
+    };
+
+    int64_t segmentPts(const std::string &path, uint64_t inode, uint64_t size, int64_t mtimeNs);
+
+private:
+    const Config _config;
+    StaticFileServlet _files;
+
+    std::mutex _mutex;
+    std::unordered_map<std::string, PlaylistEntry> _playlists;
+    std::unordered_map<std::string, PtsEntry> _pts;
+
+    std::atomic<uint64_t> _builds{0};
+    std::atomic<uint64_t> _hits{0};
+};
+
+}   // kit_muduo::http
+#endif
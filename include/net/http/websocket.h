@@ -0,0 +1,288 @@
+/**
+ * @file websocket.h
+ * @brief WebSocket(RFC 6455): 握手、帧编解码、连接会话与广播
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 22:52:30
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_WEBSOCKET_H__
+#define __KIT_WEBSOCKET_H__
+
+#include "base/noncopyable.h"
+#include "net/call_backs.h"
+#include "net/http/http_scanner.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace kit_muduo {
+
+class Buffer;
+
+namespace http {
+
+class HttpRequest;
+
+enum class WebSocketOpcode: uint8_t
+{
+    kContinuation = 0x0,
+    kText = 0x1,
+    kBinary = 0x2,
+    kClose = 0x8,
+    kPing = 0x9,
+    kPong = 0xA,
+};
+
+/// @brief 关闭状态码(RFC 6455 7.4.1)
+namespace WebSocketCloseCode {
+    constexpr uint16_t kNormal = 1000;
+    constexpr uint16_t kGoingAway = 1001;
+    constexpr uint16_t kProtocolError = 1002;
+    constexpr uint16_t kUnsupportedData = 1003;
+    /// @brief 关闭帧不带状态码，不会出现在线路上
+    constexpr uint16_t kNoStatus = 1005;
+    /// @brief 未收到关闭帧连接即断开，不会出现在线路上
+    constexpr uint16_t kAbnormal = 1006;
+    constexpr uint16_t kInvalidPayload = 1007;
+    constexpr uint16_t kPolicyViolation = 1008;
+    constexpr uint16_t kMessageTooBig = 1009;
+    constexpr uint16_t kInternalError = 1011;
+}
+
+/**
+ * @brief 由客户端的 Sec-WebSocket-Key 计算 Sec-WebSocket-Accept
+ */
+std::string WebSocketAcceptKey(std::string_view clientKey);
+
+/**
+ * @brief 检查请求是否为合法的 WebSocket 升级请求
+ * @param[out] status 不合法时应回复的状态码: 400，或版本不支持时 426
+ * @return 非升级请求或不合法时返回 false
+ */
+bool IsWebSocketUpgrade(const HttpRequest &req, int32_t *status = nullptr);
+
+/**
+ * @brief 以4字节掩码异或 [data, data+len)，掩码与解掩码是同一操作
+ * @param[in] offset 首字节在整个负载中的偏移，分段处理时保持掩码相位
+ * @note 按 HttpScanLevelInUse() 分派: AVX2 每次32字节，SSE4.2 级别使用 SSE2 每次16字节，标量按8字节字处理
+ */
+void WebSocketMask(char *data, size_t len, const uint8_t key[4], size_t offset = 0);
+
+/// @brief 指定实现级别的掩码，供测试与基准对比
+void WebSocketMaskWith(HttpScanLevel level, char *data, size_t len, const uint8_t key[4], size_t offset = 0);
+
+/**
+ * @brief 解码出的一条消息或控制帧
+ */
+struct WebSocketMessage
+{
+    /// @brief kText/kBinary 为重组后的完整消息，kPing/kPong/kClose 为控制帧
+    WebSocketOpcode opcode{WebSocketOpcode::kText};
+    std::string payload;
+    /// @brief 关闭帧的状态码与原因，不带状态码时为 kNoStatus
+    uint16_t close_code{WebSocketCloseCode::kNoStatus};
+    std::string close_reason;
+};
+
+/**
+ * @brief 帧编解码器
+ * @note 解码有状态(跨帧重组分片消息)，每个连接一个；编码无状态
+ */
+class WebSocketCodec
+{
+public:
+    struct Config {
+        /// @brief 单条(重组后)消息的上限，超过时以 1009 关闭
+        size_t maxMessageBytes{16 * 1024 * 1024};
+        /// @brief 服务端要求客户端帧带掩码，客户端要求服务端帧不带掩码
+        bool expectMasked{true};
+        /// @brief 校验文本消息与关闭原因为合法 UTF-8
+        bool validateUtf8{true};
+    };
+
+    enum class DecodeResult {
+        /// @brief 数据不足一帧，等待更多数据
+        kNeedMore,
+        /// @brief 得到一条消息或控制帧
+        kMessage,
+        /// @brief 协议错误，errorCode() 为应发送的关闭状态码
+        kError,
+    };
+
+    WebSocketCodec();
+    explicit WebSocketCodec(Config config);
+
+    /**
+     * @brief 从 buf 中解码，每次最多返回一条消息；完整的帧才会被消费
+     */
+    DecodeResult decode(Buffer &buf, WebSocketMessage *msg);
+
+    uint16_t errorCode() const { return _errorCode; }
+
+    /**
+     * @brief 编码一帧
+     * @param[in] maskKey 非空时按客户端方式加掩码
+     */
+    static std::string Encode(WebSocketOpcode opcode, const void *data, size_t len,
+                              bool fin = true, const uint8_t *maskKey = nullptr);
+
+    /// @brief 编码关闭帧，code 为 kNoStatus 时不带状态码
+    static std::string EncodeClose(uint16_t code, std::string_view reason = "");
+
+    /// @brief 校验 UTF-8(拒绝过长编码、代理区与超出 U+10FFFF 的码点)
+    static bool ValidUtf8(const char *data, size_t len);
+
+private:
+    DecodeResult fail(uint16_t code);
+
+private:
+    const Config _config;
+    /// @brief 分片消息的首帧类型，kContinuation 表示没有进行中的分片消息
+    WebSocketOpcode _fragmentOpcode{WebSocketOpcode::kContinuation};
+    std::string _fragments;
+    uint16_t _errorCode{0};
+};
+
+class WebSocketHandler;
+
+/**
+ * @brief 一条已升级的 WebSocket 连接
+ * @note 收包与回调都在连接所属的IO线程中；发送接口线程安全，
+ *       帧以共享缓冲提交给 TcpConnection，同一帧可被多个连接复用
+ */
+class WebSocketConnection: public std::enable_shared_from_this<WebSocketConnection>, Noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<WebSocketConnection>;
+
+    enum class State: uint8_t {
+        kOpen,
+        /// @brief 已发出关闭帧，等待对端回应
+        kClosing,
+        kClosed,
+    };
+
+    WebSocketConnection(const TcpConnectionPtr &conn, std::shared_ptr<WebSocketHandler> handler,
+                        const std::string &path, WebSocketCodec::Config config);
+    ~WebSocketConnection();
+
+    bool sendText(std::string_view text);
+    bool sendBinary(const void *data, size_t len);
+    bool ping(std::string_view payload = "");
+
+    /**
+     * @brief 发送已编码的帧(如广播时共享的帧)
+     * @return 连接未打开时返回 false
+     */
+    bool sendFrame(const SharedBuffer &frame);
+
+    /**
+     * @brief 发起关闭握手，对端回应或超时后断开TCP连接
+     */
+    void close(uint16_t code = WebSocketCloseCode::kNormal, std::string_view reason = "");
+
+    State state() const { return _state.load(std::memory_order_acquire); }
+    bool connected() const { return State::kOpen == state(); }
+
+    /// @brief 已提交但尚未写入内核的字节数，连接已断开时返回0
+    size_t pendingBytes() const;
+
+    const std::string& path() const { return _path; }
+    /// @brief 底层连接，已断开时返回空
+    TcpConnectionPtr connection() const { return _conn.lock(); }
+    const std::string& name() const { return _name; }
+
+    /// @brief 用户数据
+    void setContext(std::shared_ptr<void> context) { _context = std::move(context); }
+    std::shared_ptr<void> getContext() const { return _context; }
+
+    /******以下由 HttpServer 在IO线程中调用******/
+    void onOpen();
+    void onData(Buffer &buf);
+    void onDisconnected();
+
+private:
+    void handleMessage(WebSocketMessage &msg);
+    void fail(uint16_t code);
+    /// @brief 通知一次 onClose
+    void notifyClosed(uint16_t code, const std::string &reason);
+
+private:
+    std::weak_ptr<TcpConnection> _conn;
+    std::string _name;
+    std::shared_ptr<WebSocketHandler> _handler;
+    const std::string _path;
+    WebSocketCodec _codec;
+    std::atomic<State> _state{State::kOpen};
+    std::atomic<bool> _closeNotified{false};
+    std::shared_ptr<void> _context;
+};
+
+/**
+ * @brief 处理某个路径上的 WebSocket 连接，回调均在IO线程执行，耗时逻辑应转交业务线程
+ */
+class WebSocketHandler
+{
+public:
+    using Ptr = std::shared_ptr<WebSocketHandler>;
+
+    virtual ~WebSocketHandler() = default;
+
+    /**
+     * @brief 握手前校验(鉴权、Origin 等)，返回 false 时以 403 拒绝
+     */
+    virtual bool accept(const HttpRequest &req) { return true; }
+
+    virtual void onOpen(const WebSocketConnection::Ptr &ws) { }
+
+    /// @brief 完整的文本/二进制消息；ping 已自动回复 pong，pong 也会送到这里
+    virtual void onMessage(const WebSocketConnection::Ptr &ws, const WebSocketMessage &msg) { }
+
+    /// @brief 连接关闭(关闭握手完成或TCP断开)，每个连接恰好一次
+    virtual void onClose(const WebSocketConnection::Ptr &ws, uint16_t code, const std::string &reason) { }
+};
+
+/**
+ * @brief 广播组: 消息只编码一次，所有连接共享同一个帧缓冲
+ */
+class WebSocketHub: Noncopyable
+{
+public:
+    /**
+     * @param[in] maxPendingBytes 连接积压超过该值时本次广播跳过它(慢消费者)，0 表示不限
+     */
+    explicit WebSocketHub(size_t maxPendingBytes = 0);
+
+    void add(const WebSocketConnection::Ptr &ws);
+    void remove(const WebSocketConnection::Ptr &ws);
+    size_t size() const;
+
+    /**
+     * @brief 广播一条消息
+     * @return 实际发送的连接数
+     */
+    size_t broadcast(WebSocketOpcode opcode, const void *data, size_t len);
+    size_t broadcastText(std::string_view text) { return broadcast(WebSocketOpcode::kText, text.data(), text.size()); }
+
+    /// @brief 广播已编码的帧
+    size_t broadcastFrame(const SharedBuffer &frame);
+
+    /// @brief 因积压被跳过的累计次数
+    uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    const size_t _maxPendingBytes;
+    mutable std::mutex _mutex;
+    std::unordered_map<const WebSocketConnection*, std::weak_ptr<WebSocketConnection>> _members;
+    std::atomic<uint64_t> _dropped{0};
+};
+
+}   // http
+}   // kit_muduo
+#endif
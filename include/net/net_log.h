@@ -108,6 +108,20 @@ net  info  DEBUG
 #define TCP_F_FATAL(fmt, ...)     NET_F_FATAL("tcp_svr", fmt, ##__VA_ARGS__)
 /*******TcpServer模块*********/
 
+/*******TcpClient模块*********/
+#define CLI_DEBUG()     NET_DEBUG("tcp_cli")
+#define CLI_INFO()      NET_INFO("tcp_cli")
+#define CLI_WARN()      NET_WARN("tcp_cli")
+#define CLI_ERROR()     NET_ERROR("tcp_cli")
+#define CLI_FATAL()     NET_FATAL("tcp_cli")
+
+#define CLI_F_DEBUG(fmt, ...)     NET_F_DEBUG("tcp_cli", fmt, ##__VA_ARGS__)
+#define CLI_F_INFO(fmt, ...)      NET_F_INFO("tcp_cli", fmt, ##__VA_ARGS__)
+#define CLI_F_WARN(fmt, ...)      NET_F_WARN("tcp_cli", fmt, ##__VA_ARGS__)
+#define CLI_F_ERROR(fmt, ...)     NET_F_ERROR("tcp_cli", fmt, ##__VA_ARGS__)
+#define CLI_F_FATAL(fmt, ...)     NET_F_FATAL("tcp_cli", fmt, ##__VA_ARGS__)
+/*******TcpClient模块*********/
+
 /*******UDP模块*********/
 #define UDP_DEBUG()     NET_DEBUG("udp")
 #define UDP_INFO()      NET_INFO("udp")
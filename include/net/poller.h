@@ -11,6 +11,7 @@
 
 #include "base/noncopyable.h"
 
+#include <cstddef>
 #include <unordered_map>
 #include <vector>
 #include <stdint.h>
@@ -57,6 +58,9 @@ public:
      */
     virtual bool hasChannel(Channel *channel);
 
+    /// @brief 已注册的channel数量，需在所属loop线程调用
+    size_t channelCount() const { return _channels.size(); }
+
 public:
     static Poller* NewDefaultPoller(EventLoop *loop);
 
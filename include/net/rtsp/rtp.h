@@ -0,0 +1,169 @@
+/**
+ * @file rtp.h
+ * @brief RTP 打包: 包头编解码、复用的包缓冲池与 H.264(RFC 6184)分包
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 05:02:17
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_RTP_H__
+#define __KIT_RTP_H__
+
+#include "base/noncopyable.h"
+#include "net/call_backs.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kit_muduo::rtsp {
+
+/// @brief 固定 RTP 头长度(无 CSRC 与扩展)
+constexpr size_t kRtpHeaderSize = 12;
+/// @brief TCP interleaved 前缀 '$' + 通道号 + 16位长度
+constexpr size_t kInterleavedHeaderSize = 4;
+/// @brief 单包负载上限，1500 以太网 MTU 扣除 IP/UDP/RTP 头后留余量
+constexpr size_t kDefaultRtpMtu = 1400;
+
+struct RtpHeader
+{
+    uint8_t payloadType{96};
+    bool marker{false};
+    uint16_t seq{0};
+    uint32_t timestamp{0};
+    uint32_t ssrc{0};
+};
+
+/// @brief 写 12 字节 RTP 头(V=2, 无填充/扩展/CSRC)
+void WriteRtpHeader(char *out, const RtpHeader &header);
+
+/**
+ * @brief 解析 RTP 头
+ * @param[out] payloadOffset 负载起始偏移(跳过 CSRC 与扩展头)
+ * @return 版本不为2或长度不足时返回 false
+ */
+bool ParseRtpHeader(const char *data, size_t len, RtpHeader *header, size_t *payloadOffset);
+
+/**
+ * @brief RTP 包缓冲池
+ *
+ * 每个包是一块 std::string，由 shared_ptr 在所有观众之间共享；最后一个引用
+ * (通常是某个连接发送完成)释放时归还池中复用，稳态下扇出不再分配内存。
+ * 池先于缓冲析构时，缓冲直接释放。
+ */
+class RtpPacketPool: Noncopyable
+{
+public:
+    struct Stats {
+        /// @brief 取出的缓冲数
+        uint64_t acquired{0};
+        /// @brief 其中新分配的缓冲数
+        uint64_t allocated{0};
+        /// @brief 当前空闲缓冲数
+        size_t cached{0};
+    };
+
+    /**
+     * @param[in] maxCached 最多缓存的空闲缓冲数，超出的直接释放
+     */
+    explicit RtpPacketPool(size_t maxCached = 1024);
+
+    /// @brief 取一块已清空、容量不小于 capacity 的缓冲，线程安全
+    std::shared_ptr<std::string> acquire(size_t capacity);
+
+    Stats stats() const;
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::vector<std::string*> free;
+        size_t maxCached{0};
+        std::atomic<uint64_t> acquired{0};
+        std::atomic<uint64_t> allocated{0};
+
+        ~State();
+    };
+
+    static void Recycle(const std::weak_ptr<State> &weak, std::string *buf);
+
+private:
+    std::shared_ptr<State> _state;
+};
+
+/**
+ * @brief 把一帧切成 RTP 包
+ *
+ * 每个包的布局为 [interleaved 头 4B][RTP 头 12B][负载]，interleaved 头的通道号
+ * 为 defaultChannel：TCP 观众整包发送，UDP 观众从偏移4发送，两者共用一份缓冲。
+ *
+ * 编码:
+ *   - kH264: 输入为 Annex-B 字节流(00 00 01 / 00 00 00 01 起始码)，单 NAL 不超过 MTU
+ *            时单包发送，否则按 FU-A 分片；记录最近的 SPS/PPS 用于 SDP
+ *   - kGeneric: 负载按 MTU 直接切分(适用于 PCMA/PCMU/L16 等可任意切分的负载)
+ * 一帧的最后一个包置 marker 位。非线程安全，由所属媒体源加锁调用。
+ */
+class RtpPacketizer
+{
+public:
+    enum class Codec {
+        kGeneric,
+        kH264,
+    };
+
+    RtpPacketizer(Codec codec, uint8_t payloadType, uint32_t ssrc, uint8_t defaultChannel,
+                  size_t mtu = kDefaultRtpMtu, RtpPacketPool *pool = nullptr);
+
+    /**
+     * @brief 打包一帧，追加到 out
+     * @return 帧可作为解码起点(H.264 含 IDR，其它编码恒为 true)
+     */
+    bool packetize(const char *data, size_t len, uint32_t timestamp, std::vector<SharedBuffer> *out);
+
+    Codec codec() const { return _codec; }
+    uint32_t ssrc() const { return _ssrc; }
+    uint8_t defaultChannel() const { return _defaultChannel; }
+    /// @brief 下一个包的序号，PLAY 响应的 RTP-Info 使用
+    uint16_t nextSeq() const { return _seq; }
+    uint32_t lastTimestamp() const { return _lastTimestamp; }
+
+    /// @brief 最近一次见到的 SPS/PPS(不含起始码)，未见到时为空
+    const std::string& sps() const { return _sps; }
+    const std::string& pps() const { return _pps; }
+
+    /// @brief 按 SPS/PPS 生成 fmtp 中的 profile-level-id 与 sprop-parameter-sets，未见到 SPS 时只有 packetization-mode
+    std::string h264Fmtp() const;
+
+    /// @brief 按 Annex-B 起始码拆出 NAL 单元(不含起始码)，无起始码时整段视为一个 NAL
+    static std::vector<std::string_view> SplitAnnexB(const char *data, size_t len);
+
+private:
+    /// @brief 生成一个包: prefix 为负载前缀(FU 指示/头)，body 为其后的负载
+    SharedBuffer makePacket(std::string_view prefix, std::string_view body, bool marker, uint32_t timestamp);
+
+    void packetizeNal(std::string_view nal, bool lastNal, uint32_t timestamp, std::vector<SharedBuffer> *out);
+
+private:
+    const Codec _codec;
+    const uint8_t _payloadType;
+    const uint32_t _ssrc;
+    const uint8_t _defaultChannel;
+    const size_t _mtu;
+    RtpPacketPool *_pool;
+
+    uint16_t _seq;
+    uint32_t _lastTimestamp{0};
+    std::string _sps;
+    std::string _pps;
+};
+
+/**
+ * @brief 复制包并改写 interleaved 通道号，TCP 观众的通道号与默认值不同时使用
+ */
+SharedBuffer RewriteInterleavedChannel(const SharedBuffer &packet, uint8_t channel, RtpPacketPool *pool);
+
+}   // kit_muduo::rtsp
+#endif
@@ -0,0 +1,297 @@
+/**
+ * @file rtsp_server.h
+ * @brief RTSP 1.0(RFC 2326)服务端: 媒体源、会话与 RTP over TCP interleaved / UDP 扇出
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 05:40:52
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_RTSP_SERVER_H__
+#define __KIT_RTSP_SERVER_H__
+
+#include "base/noncopyable.h"
+#include "net/call_backs.h"
+#include "net/inet_address.h"
+#include "net/rtsp/rtp.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace kit_muduo {
+
+class EventLoop;
+class TcpServer;
+class Timer;
+
+namespace http {
+class HttpContext;
+class HttpRequest;
+}
+
+namespace rtsp {
+
+/**
+ * @brief SETUP 请求的 Transport 头中本服务端支持的部分
+ */
+struct RtspTransport
+{
+    enum Mode { kUnknown, kTcpInterleaved, kUdpUnicast };
+
+    Mode mode{kUnknown};
+    /// @brief kTcpInterleaved: RTP/RTCP 通道号
+    uint8_t rtpChannel{0};
+    uint8_t rtcpChannel{1};
+    /// @brief kUdpUnicast: 客户端 RTP/RTCP 端口
+    uint16_t clientRtpPort{0};
+    uint16_t clientRtcpPort{0};
+};
+
+/**
+ * @brief 解析 Transport 头，多个候选(逗号分隔)时取第一个支持的
+ * @note 组播与 RTP/AVP 以外的协议不支持
+ */
+bool ParseRtspTransport(std::string_view value, RtspTransport *transport);
+
+/**
+ * @brief 拆分请求 URL: 去掉 rtsp://host[:port]，末尾的 trackID=N 作为轨道号
+ * @param[out] path 媒体源路径，如 "/live/cam1"
+ * @param[out] track 轨道号，URL 不含 trackID 时为 -1(聚合操作)
+ */
+void SplitRtspUrl(std::string_view url, std::string *path, int *track);
+
+/**
+ * @brief 一路直播媒体源
+ *
+ * 推流方在任意线程调用 pushFrame()，每帧只打包一次，包缓冲在所有观众间共享:
+ *   - TCP interleaved 观众: conn->send(packets) 只把缓冲引用挂到发送队列；
+ *     客户端选的通道号与默认值不同时，每帧每个不同通道号复制一份
+ *   - UDP 观众: 从同一份缓冲的偏移4(跳过 interleaved 头)发送，不复制
+ *
+ * 慢观众: TCP 连接待发送字节超过 maxPendingBytes 时跳过该观众的本帧，
+ *         H.264 轨道随后等待下一个关键帧再恢复，避免花屏。
+ * 新观众的 H.264 轨道同样从关键帧开始。
+ */
+class RtspMediaSource: public std::enable_shared_from_this<RtspMediaSource>, Noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<RtspMediaSource>;
+
+    struct TrackConfig {
+        /// @brief SDP m= 行的媒体类型: video / audio
+        std::string media{"video"};
+        uint8_t payloadType{96};
+        uint32_t clockRate{90000};
+        /// @brief rtpmap 编码名，"H264" 启用 H.264 分包，其余按 MTU 直接切分
+        std::string encoding{"H264"};
+        /// @brief 音频声道数，0 表示 rtpmap 不带声道
+        uint16_t channels{0};
+        /// @brief 非空时作为 a=fmtp 原样下发，H.264 为空时按已见到的 SPS/PPS 生成
+        std::string fmtp;
+    };
+
+    /// @brief 观众在某个轨道上的投递目标
+    struct SinkTrack {
+        bool enabled{false};
+        /// @brief TCP interleaved 的 RTP 通道号
+        uint8_t channel{0};
+        /// @brief UDP 观众的 RTP 地址
+        InetAddress peer;
+        /// @brief 等待关键帧
+        bool waitKey{true};
+    };
+
+    /// @brief 一个观众(一个处于 PLAY 状态的会话)
+    struct Sink {
+        std::weak_ptr<TcpConnection> conn;
+        /// @brief 非空时 RTP 走 UDP，否则走 conn 上的 interleaved
+        AsyncUdpDatagramPtr udp;
+        std::vector<SinkTrack> tracks;
+        size_t maxPendingBytes{4 * 1024 * 1024};
+    };
+
+    struct Stats {
+        size_t viewers{0};
+        uint64_t frames{0};
+        uint64_t packets{0};
+        /// @brief 投递给观众的帧数(一帧发给 N 个观众计 N)
+        uint64_t delivered{0};
+        /// @brief 因积压或等待关键帧被跳过的帧数
+        uint64_t dropped{0};
+        /// @brief 为非默认通道号复制的包数
+        uint64_t copiedPackets{0};
+        RtpPacketPool::Stats pool;
+    };
+
+    /**
+     * @param[in] path 请求路径，如 "/live/cam1"
+     * @param[in] mtu  RTP 负载上限
+     */
+    explicit RtspMediaSource(const std::string &path, size_t mtu = kDefaultRtpMtu);
+
+    /// @brief 添加轨道，须在推流前完成
+    size_t addTrack(TrackConfig config);
+    size_t trackCount() const;
+
+    /**
+     * @brief 生成 DESCRIBE 的 SDP
+     * @param[in] localIp 写入 o= 行的本端地址
+     */
+    std::string sdp(const std::string &localIp) const;
+
+    /**
+     * @brief 推送一帧，线程安全
+     * @param[in] timestamp RTP 时间戳(按轨道 clockRate)
+     * @return 投递到的观众数
+     */
+    size_t pushFrame(size_t track, const char *data, size_t len, uint32_t timestamp);
+
+    const std::string& path() const { return _path; }
+    Stats stats() const;
+
+    /******以下供 RtspServer 调用******/
+    /**
+     * @brief 加入观众
+     * @param[in] preamble 非空时在加入前经控制连接发送(PLAY 响应)，保证先于第一个 RTP 包
+     */
+    void attach(const void *key, Sink sink, const std::string &preamble = std::string());
+    void detach(const void *key);
+    /// @brief PLAY 响应 RTP-Info 用的下一个序号与最近时间戳
+    void rtpInfo(size_t track, uint16_t *seq, uint32_t *rtptime) const;
+    uint32_t ssrc(size_t track) const;
+
+private:
+    struct Track {
+        TrackConfig config;
+        std::unique_ptr<RtpPacketizer> packetizer;
+    };
+
+private:
+    const std::string _path;
+    const size_t _mtu;
+    RtpPacketPool _pool;
+
+    mutable std::mutex _mutex;
+    std::vector<Track> _tracks;
+    std::unordered_map<const void*, Sink> _sinks;
+    /// @brief 复用的单帧缓冲，避免每帧分配 vector
+    std::vector<SharedBuffer> _packets;
+    std::map<uint8_t, std::vector<SharedBuffer>> _channelPackets;
+
+    uint64_t _frames{0};
+    uint64_t _packetCount{0};
+    uint64_t _delivered{0};
+    uint64_t _dropped{0};
+    uint64_t _copied{0};
+};
+
+/**
+ * @brief RTSP 1.0 服务端
+ *
+ * 支持 OPTIONS / DESCRIBE / SETUP / PLAY / PAUSE / TEARDOWN / GET_PARAMETER / SET_PARAMETER，
+ * RTP 经 TCP interleaved($ 帧)或 UDP 单播发送。
+ *
+ * 会话: SETUP 创建，Session 头带 timeout；控制连接上的任意请求或 interleaved RTCP、
+ *       UDP RTCP 端口收到的报文都会刷新活跃时间，超时未活跃的会话被回收。
+ *       控制连接断开时其上创建的会话一并销毁。
+ * 未实现 RTCP 发送端报告(SR)，客户端按 RTP 时间戳自行同步。
+ */
+class RtspServer: Noncopyable
+{
+public:
+    struct Config {
+        /// @brief UDP RTP 端口(RTCP 为其加1)，0 表示只支持 TCP interleaved
+        uint16_t rtpPort{0};
+        int64_t sessionTimeoutMs{60 * 1000};
+        /// @brief 单个 TCP 观众允许积压的字节数
+        size_t maxPendingBytes{4 * 1024 * 1024};
+    };
+
+    struct Stats {
+        size_t sessions{0};
+        size_t playing{0};
+        uint64_t requests{0};
+        /// @brief 超时回收的会话数
+        uint64_t expired{0};
+    };
+
+    RtspServer(EventLoop *loop, const InetAddress &addr, const std::string &name);
+    RtspServer(EventLoop *loop, const InetAddress &addr, const std::string &name, Config config);
+    ~RtspServer();
+
+    void setThreadNum(int32_t num);
+    void start();
+
+    /// @brief 注册媒体源，同路径覆盖，线程安全
+    void addSource(const RtspMediaSource::Ptr &source);
+    void removeSource(const std::string &path);
+
+    Stats stats() const;
+
+private:
+    struct Session {
+        std::string id;
+        std::string path;
+        std::weak_ptr<RtspMediaSource> source;
+        std::weak_ptr<TcpConnection> conn;
+        std::vector<RtspMediaSource::SinkTrack> tracks;
+        /// @brief UDP 观众的 RTCP 地址，用于按来源刷新活跃时间
+        std::vector<InetAddress> rtcpPeers;
+        bool udp{false};
+        bool playing{false};
+        int64_t lastActiveNs{0};
+    };
+    using SessionPtr = std::shared_ptr<Session>;
+
+    /// @brief 每个控制连接的上下文
+    struct ConnContext {
+        std::shared_ptr<http::HttpContext> http;
+        std::vector<std::string> sessions;
+    };
+
+    void onConnection(const TcpConnectionPtr &conn);
+    void onMessage(const TcpConnectionPtr &conn, Buffer *buf, TimeStamp receiveTime);
+    void onRtcp(const InetAddress &peer);
+
+    void handleRequest(const TcpConnectionPtr &conn, ConnContext &ctx, http::HttpRequest &request);
+    void handleDescribe(const TcpConnectionPtr &conn, http::HttpRequest &request, const std::string &cseq);
+    void handleSetup(const TcpConnectionPtr &conn, ConnContext &ctx, http::HttpRequest &request, const std::string &cseq);
+    void handlePlay(const TcpConnectionPtr &conn, const SessionPtr &session, http::HttpRequest &request, const std::string &cseq);
+
+    static std::string RenderReply(int32_t code, const std::string &cseq,
+                                   const std::string &headers = std::string(), const std::string &body = std::string());
+    static void SendReply(const TcpConnectionPtr &conn, int32_t code, const std::string &cseq,
+                          const std::string &headers = std::string(), const std::string &body = std::string());
+
+    RtspMediaSource::Ptr findSource(const std::string &path) const;
+    SessionPtr findSession(std::string_view id) const;
+    std::string newSessionId();
+    void destroySession(const std::string &id);
+    void stopPlaying(const SessionPtr &session);
+    void expireSessions();
+
+private:
+    EventLoop *_loop;
+    const Config _config;
+    std::unique_ptr<TcpServer> _server;
+    AsyncUdpDatagramPtr _rtpSocket;
+    AsyncUdpDatagramPtr _rtcpSocket;
+    std::shared_ptr<Timer> _expireTimer;
+
+    mutable std::mutex _mutex;
+    std::unordered_map<std::string, RtspMediaSource::Ptr> _sources;
+    std::unordered_map<std::string, SessionPtr> _sessions;
+    uint64_t _sessionSeed;
+
+    std::atomic<uint64_t> _requests{0};
+    std::atomic<uint64_t> _expired{0};
+};
+
+}   // rtsp
+}   // kit_muduo
+#endif
@@ -42,6 +42,9 @@ public:
 
     void cancel(std::shared_ptr<Timer> timer);
 
+    /// @brief 计时中的定时器数量，需在所属loop线程调用
+    size_t size() const { return _timers.size(); }
+
 private:
     using WillExpiredTimer = std::pair<int64_t, std::shared_ptr<Timer>>;
 
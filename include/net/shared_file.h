@@ -0,0 +1,69 @@
+/**
+ * @file shared_file.h
+ * @brief 可在多个连接间共享的只读文件描述符
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 10:12:40
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_SHARED_FILE_H__
+#define __KIT_SHARED_FILE_H__
+
+#include "base/noncopyable.h"
+
+#include <sys/types.h>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+namespace kit_muduo {
+
+/**
+ * @brief 只读打开的文件及打开时刻的元数据，析构时关闭描述符
+ * @note 发送队列持有 shared_ptr，文件被缓存淘汰后仍可安全发完
+ */
+class SharedFile: Noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<SharedFile>;
+
+    /**
+     * @brief 打开普通文件
+     * @param[in] path 文件路径
+     * @param[out] err 失败时的errno，可为空
+     * @return 失败或不是普通文件时返回空
+     */
+    static Ptr Open(const std::string &path, int32_t *err = nullptr);
+
+    /**
+     * @brief 把文件内容复制到封存(只读)的匿名内存文件(memfd)
+     * @note 元数据沿用源文件，sendfile 发送时与普通文件一样零拷贝，
+     *       内容常驻内存，不受源文件页缓存回收影响
+     * @return 失败时返回空
+     */
+    static Ptr Snapshot(const SharedFile &src, int32_t *err = nullptr);
+
+    ~SharedFile();
+
+    int32_t fd() const { return _fd; }
+    uint64_t size() const { return _size; }
+    /// @brief 修改时间(纳秒)
+    int64_t mtimeNs() const { return _mtimeNs; }
+    uint64_t inode() const { return _inode; }
+    uint64_t device() const { return _device; }
+
+private:
+    SharedFile(int32_t fd, uint64_t size, int64_t mtimeNs, uint64_t inode, uint64_t device);
+
+private:
+    int32_t _fd;
+    uint64_t _size;
+    int64_t _mtimeNs;
+    uint64_t _inode;
+    uint64_t _device;
+};
+
+using SharedFilePtr = SharedFile::Ptr;
+
+}   // kit_muduo
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @file tcp_client.h
+ * @brief TcpClient对外调用类: 主动连接并产出普通 TcpConnection，支持断线重连
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 19:32:08
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#ifndef __KIT_TCP_CLIENT_H__
+#define __KIT_TCP_CLIENT_H__
+
+#include "base/noncopyable.h"
+#include "net/call_backs.h"
+#include "net/connector.h"
+#include "net/tcp_connection.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+namespace kit_muduo {
+
+class EventLoop;
+class InetAddress;
+
+/**
+ * @brief 单条出站连接
+ *
+ * 连接失败时 Connector 按退避参数一直重试；enableRetry 后连接断开也会重新连接。
+ * 连接建立后与 TcpServer 一样交给 TcpConnection，回调语义完全一致。
+ * 回调都在 loop 线程中执行；建议在 loop 线程中析构，析构时仍存在的连接被强制关闭。
+ */
+class TcpClient: Noncopyable
+{
+public:
+    TcpClient(EventLoop *loop, const InetAddress &serverAddr, const std::string &name);
+
+    ~TcpClient();
+
+    void setConnectionCallback(const ConnectionCb &cb) { _connectionCallback = std::move(cb); }
+
+    void setMessageCallback(const MessageCb &cb) { _messageCallback = std::move(cb); }
+
+    void setWriteCompleteCallback(const WriteCompleteCb &cb) { _writeCompleteCallback = std::move(cb); }
+
+    /**
+     * @brief 设置连接失败重试的退避参数，需在 connect 前调用
+     */
+    void setBackoff(const Connector::Backoff &backoff) { _connector->setBackoff(backoff); }
+
+    /**
+     * @brief 连接断开后自动重连
+     */
+    void enableRetry() { _retry = true; }
+    bool retry() const { return _retry; }
+
+    /**
+     * @brief 发起连接，失败时按退避参数重试
+     */
+    void connect();
+
+    /**
+     * @brief 关闭当前连接的写端，不再重连
+     */
+    void disconnect();
+
+    /**
+     * @brief 停止正在进行的连接与重试
+     */
+    void stop();
+
+    /**
+     * @brief 当前连接，未连接时为空
+     */
+    TcpConnectionPtr connection() const;
+
+    EventLoop *getLoop() const { return _loop; }
+
+    const std::string& name() const { return _name; }
+
+private:
+    void newConnection(int32_t sockfd);
+    void removeConnection(const TcpConnectionPtr &conn);
+
+private:
+    EventLoop *_loop;
+    Connector::Ptr _connector;
+    const std::string _name;
+
+    ConnectionCb _connectionCallback;
+    MessageCb _messageCallback;
+    WriteCompleteCb _writeCompleteCallback;
+
+    std::atomic_bool _retry;
+    std::atomic_bool _connect;
+    int32_t _nextConnId;
+
+    mutable std::mutex _mutex;
+    TcpConnectionPtr _connection;
+};
+
+}   // kit_muduo
+#endif
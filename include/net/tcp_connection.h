@@ -15,11 +15,15 @@
 #include "net/buffer.h"
 #include "net/inet_address.h"
 #include "net/socket.h"
+#include "net/shared_file.h"
 
+#include <deque>
 #include <memory>
 #include <string>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <vector>
 
 namespace kit_muduo {
 
@@ -35,6 +39,24 @@ class Buffer;
 class TcpConnection: Noncopyable, public std::enable_shared_from_this<TcpConnection>
 {
 public:
+    /// @brief 连接状态快照
+    struct Stats {
+        std::string name;
+        int32_t fd{-1};
+        std::string peer;
+        const char *state{""};
+        uint64_t bytes_read{0};
+        uint64_t bytes_written{0};
+        /// @brief 输入/输出缓冲区的可读字节数与已分配容量
+        size_t input_bytes{0};
+        size_t input_capacity{0};
+        size_t output_bytes{0};
+        size_t output_capacity{0};
+        /// @brief 排队中的文件/共享缓冲分段数
+        size_t output_segments{0};
+        size_t pending_bytes{0};
+    };
+
     TcpConnection(EventLoop *loop, const std::string &name, int32_t sockfd, const InetAddress &peerAddr, const InetAddress &localAddr);
 
     ~TcpConnection();
@@ -52,19 +74,87 @@ public:
 
     void setCloseCallback(const CloseCb &cb) { _closeCallback = std::move(cb); }
 
+    /**
+     * @brief 追加一个连接断开通知，与 setCloseCallback(由 TcpServer/TcpClient 占用)互不影响
+     * @note 线程安全；断开时在IO线程按注册顺序各调用一次，连接已断开时在调用线程立即执行
+     */
+    void addCloseHook(CloseCb hook);
 
     void setHighWaterMarkCallback(const HighWaterMarkCb &cb) { _highWaterMarkCallback = std::move(cb); }
+    /**
+     * @brief 设置高水位回调，输出缓冲区由低于到超过 highWaterMark 时触发一次
+     */
+    void setHighWaterMarkCallback(const HighWaterMarkCb &cb, size_t highWaterMark)
+    {
+        _highWaterMarkCallback = cb;
+        _highWaterMark = highWaterMark;
+    }
 
     void send(const std::string& buf);
 
+    void send(std::string&& buf);
+
     void send(const std::vector<char>& buf);
 
+    /**
+     * @brief 发送一段外部内存，IO线程内调用时直接写套接字，只有写不完的部分拷入输出缓冲区；
+     *        其它线程调用时先拷贝再排队
+     */
+    void send(const void *data, size_t len);
+
+    /**
+     * @brief 发送一组共享缓冲(writev)，写不完的部分直接引用原缓冲排队，不拷贝
+     */
+    void send(const std::vector<SharedBuffer> &bufs);
+
+    /**
+     * @brief 零拷贝发送文件区间(sendfile)，与 send 提交的数据严格按调用顺序写出
+     * @param[in] file 已打开的文件，发送完成前由发送队列持有
+     * @param[in] offset 文件内起始偏移
+     * @param[in] len 发送字节数
+     */
+    void sendFile(const SharedFilePtr &file, off_t offset, size_t len);
+
+    /**
+     * @brief 已提交给 send 但尚未写入内核的字节数(包含跨线程排队中的数据)
+     */
+    size_t pendingBytes() const { return _pendingBytes.load(); }
+
+    /**
+     * @brief 阻塞等待待发送字节数降到 lowMark 及以下
+     * @note 仅供业务线程等非IO线程的生产者做背压使用，IO线程内调用不会阻塞
+     * @param[in] lowMark 低水位
+     * @param[in] timeoutMs 超时时间，小于0表示一直等待
+     * @return true 已降到低水位且连接仍然有效；false 超时或连接已断开
+     */
+    bool waitForDrain(size_t lowMark, int32_t timeoutMs);
+
     void shutdown();
 
+    /**
+     * @brief 恢复/暂停从套接字读取，暂停期间对端数据留在内核接收缓冲区，由 TCP 窗口向对端施加背压
+     * @note 线程安全，在所属IO线程中生效
+     */
+    void startRead();
+    void stopRead();
+    bool isReading() const { return _reading; }
+
+    /**
+     * @brief 立即关闭连接，丢弃尚未写出的数据(如长期不读的慢消费者)
+     * @note 线程安全，关闭在所属IO线程中执行
+     */
+    void forceClose();
+
     void connectEstablished();
     void connectDestroyed();
 
+    /**
+     * @brief 状态快照，需在所属IO线程调用(跨线程请通过 runInLoop 采集)
+     */
+    Stats stats() const;
+
     InetAddress peerAddr() const { return _peerAddr; }
+    InetAddress localAddr() const { return _localAddr; }
     int32_t fd() const { return _socket->fd(); }
 
     void setContext(std::shared_ptr<void> data) { _context = data; }
@@ -82,8 +172,32 @@ private:
     
     void sendInLoop(const std::vector<char> message);
 
+    void sendFileInLoop(const SharedFilePtr &file, off_t offset, size_t len);
+
+    void sendSharedInLoop(const std::vector<SharedBuffer> &bufs, size_t total);
+
+    /**
+     * @brief 按顺序写出分段队列，写满内核缓冲区时停下
+     * @return false 发生不可恢复的错误，队列已丢弃
+     */
+    bool writeSegments();
+
+    /// @brief 丢弃分段队列中未写出的数据
+    void dropSegments();
+
     void shutdownInLoop();
 
+    void startReadInLoop();
+    void stopReadInLoop();
+
+    void forceCloseInLoop();
+
+    /// @brief 待发送字节减少或连接状态变化时唤醒 waitForDrain
+    void notifyDrain();
+
+    /// @brief 执行并清空 addCloseHook 注册的通知，只生效一次
+    void runCloseHooks();
+
 
 
 private:
@@ -93,7 +207,7 @@ private:
     EventLoop *_subLoop;
     std::string _name;
     std::atomic_int _state;
-    bool _reading;
+    std::atomic_bool _reading;
 
     std::unique_ptr<Socket> _socket;
     std::unique_ptr<Channel> _channel;
@@ -105,16 +219,42 @@ private:
     MessageCb _messageCallback;
     WriteCompleteCb _writeCompleteCallback;
     CloseCb _closeCallback;
+    /// @brief addCloseHook 注册的通知，由 _mutex 保护
+    std::vector<CloseCb> _closeHooks;
+    bool _closeHooksDone{false};
 
     size_t _highWaterMark;
     HighWaterMarkCb _highWaterMarkCallback;
 
     Buffer _inputBuffer;
     Buffer _outputBuffer;
+
+    /// @brief 输出分段: 文件区间、共享缓冲或排在它们之后的普通数据
+    struct OutputSegment {
+        std::string data;
+        SharedBuffer shared;
+        SharedFilePtr file;
+        /// @brief 文件偏移，或内存数据中已写出的偏移
+        off_t offset{0};
+        size_t remain{0};
+
+        const char *bytes() const { return shared ? shared->data() : data.data(); }
+    };
+    /// @brief 非空时 _outputBuffer 中的数据总是先于这里的分段写出
+    std::deque<OutputSegment> _outputSegments;
     std::mutex _mutex;
+    /// @brief 已提交未写入内核的字节数
+    std::atomic<size_t> _pendingBytes{0};
+    /// @brief waitForDrain 等待者数量，无人等待时不加锁通知
+    std::atomic<int32_t> _drainWaiters{0};
+    std::condition_variable _drainCond;
 
     std::shared_ptr<void> _context;
 
+    /// @brief 累计收发字节数，仅在IO线程修改
+    uint64_t _bytesRead{0};
+    uint64_t _bytesWritten{0};
+
 };
 
 
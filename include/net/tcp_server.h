@@ -12,12 +12,14 @@
 #include "base/noncopyable.h"
 #include "net/call_backs.h"
 #include "net/tcp_connection.h"
+#include "net/event_loop.h"
 
 #include <functional>
 #include <memory>
 #include <atomic>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace kit_muduo {
 
@@ -30,6 +32,15 @@ class TcpServer: Noncopyable
 {
 public:
     using ThreadInitCb = std::function<void(EventLoop*)>;
+
+    /// @brief 单个事件循环及其上连接的快照
+    struct LoopSnapshot {
+        EventLoop::Stats loop;
+        /// @brief 该循环上本服务器的连接，未要求采集连接时为空
+        std::vector<TcpConnection::Stats> connections;
+    };
+    using SnapshotCb = std::function<void(std::vector<LoopSnapshot>)>;
+
     enum Option
     {
         kNoRusePort,
@@ -71,6 +82,14 @@ public:
 
     void delConnection(const std::string &name);
 
+    /**
+     * @brief 异步采集主循环与各子循环的状态快照
+     * @note 每个循环在自身线程中通过 runInLoop 采集，调用方不等待；
+     *       全部完成后在最后完成的IO线程中调用 done，done 中不应做耗时操作
+     * @param[in] withConnections 是否同时采集连接快照
+     */
+    void collectSnapshot(SnapshotCb done, bool withConnections);
+
 
 private:
     void newConnection(int32_t sockfd, const InetAddress& peerAddr);
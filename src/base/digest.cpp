@@ -0,0 +1,247 @@
+/**
+ * @file digest.cpp
+ * @brief SHA-1 摘要与 Base64 编解码
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 22:40:16
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "base/digest.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace kit_muduo {
+
+namespace {
+
+inline uint32_t Rotl(uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+constexpr char kBase64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/// @brief 字符到6位值的反查表，非法字符为 -1
+struct Base64Table
+{
+    int8_t values[256];
+
+    Base64Table()
+    {
+        std::memset(values, -1, sizeof(values));
+        for(int i = 0; i < 64; ++i)
+        {
+            values[static_cast<uint8_t>(kBase64Chars[i])] = static_cast<int8_t>(i);
+        }
+    }
+};
+
+}
+
+Sha1::Sha1()
+{
+    reset();
+}
+
+void Sha1::reset()
+{
+    _state[0] = 0x67452301;
+    _state[1] = 0xEFCDAB89;
+    _state[2] = 0x98BADCFE;
+    _state[3] = 0x10325476;
+    _state[4] = 0xC3D2E1F0;
+    _blockLen = 0;
+    _totalLen = 0;
+}
+
+void Sha1::compress(const uint8_t block[64])
+{
+    uint32_t w[80];
+    for(int i = 0; i < 16; ++i)
+    {
+        w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16)
+             | (uint32_t(block[4 * i + 2]) << 8) | uint32_t(block[4 * i + 3]);
+    }
+    for(int i = 16; i < 80; ++i)
+    {
+        w[i] = Rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = _state[0], b = _state[1], c = _state[2], d = _state[3], e = _state[4];
+    for(int i = 0; i < 80; ++i)
+    {
+        uint32_t f, k;
+        if(i < 20)
+        {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        }
+        else if(i < 40)
+        {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        }
+        else if(i < 60)
+        {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        }
+        else
+        {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        const uint32_t temp = Rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = Rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    _state[0] += a;
+    _state[1] += b;
+    _state[2] += c;
+    _state[3] += d;
+    _state[4] += e;
+}
+
+void Sha1::update(const void *data, size_t len)
+{
+    const uint8_t *p = static_cast<const uint8_t*>(data);
+    _totalLen += len;
+
+    if(_blockLen > 0)
+    {
+        const size_t n = std::min(len, sizeof(_block) - _blockLen);
+        std::memcpy(_block + _blockLen, p, n);
+        _blockLen += n;
+        p += n;
+        len -= n;
+        if(_blockLen < sizeof(_block))
+        {
+            return;
+        }
+        compress(_block);
+        _blockLen = 0;
+    }
+
+    for(; len >= sizeof(_block); p += sizeof(_block), len -= sizeof(_block))
+    {
+        compress(p);
+    }
+
+    std::memcpy(_block, p, len);
+    _blockLen = len;
+}
+
+Sha1Digest Sha1::finish()
+{
+    // 补 0x80，再补0到 56 字节，最后 8 字节为大端的比特长度
+    const uint64_t bit_len = _totalLen * 8;
+    _block[_blockLen++] = 0x80;
+    if(_blockLen > 56)
+    {
+        std::memset(_block + _blockLen, 0, sizeof(_block) - _blockLen);
+        compress(_block);
+        _blockLen = 0;
+    }
+    std::memset(_block + _blockLen, 0, 56 - _blockLen);
+    for(int i = 0; i < 8; ++i)
+    {
+        _block[56 + i] = static_cast<uint8_t>(bit_len >> (56 - 8 * i));
+    }
+    compress(_block);
+    _blockLen = 0;
+
+    Sha1Digest digest;
+    for(int i = 0; i < 5; ++i)
+    {
+        digest[4 * i] = static_cast<uint8_t>(_state[i] >> 24);
+        digest[4 * i + 1] = static_cast<uint8_t>(_state[i] >> 16);
+        digest[4 * i + 2] = static_cast<uint8_t>(_state[i] >> 8);
+        digest[4 * i + 3] = static_cast<uint8_t>(_state[i]);
+    }
+    return digest;
+}
+
+Sha1Digest Sha1Sum(const void *data, size_t len)
+{
+    Sha1 sha1;
+    sha1.update(data, len);
+    return sha1.finish();
+}
+
+std::string Base64Encode(const void *data, size_t len)
+{
+    const uint8_t *p = static_cast<const uint8_t*>(data);
+    std::string out;
+    out.reserve((len + 2) / 3 * 4);
+
+    size_t i = 0;
+    for(; i + 3 <= len; i += 3)
+    {
+        const uint32_t v = (uint32_t(p[i]) << 16) | (uint32_t(p[i + 1]) << 8) | p[i + 2];
+        out += kBase64Chars[(v >> 18) & 0x3F];
+        out += kBase64Chars[(v >> 12) & 0x3F];
+        out += kBase64Chars[(v >> 6) & 0x3F];
+        out += kBase64Chars[v & 0x3F];
+    }
+
+    const size_t rest = len - i;
+    if(rest > 0)
+    {
+        uint32_t v = uint32_t(p[i]) << 16;
+        if(2 == rest)
+        {
+            v |= uint32_t(p[i + 1]) << 8;
+        }
+        out += kBase64Chars[(v >> 18) & 0x3F];
+        out += kBase64Chars[(v >> 12) & 0x3F];
+        out += 2 == rest ? kBase64Chars[(v >> 6) & 0x3F] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+bool Base64Decode(std::string_view in, std::string *out)
+{
+    static const Base64Table s_table;
+    if(0 != in.size() % 4)
+    {
+        return false;
+    }
+
+    out->clear();
+    out->reserve(in.size() / 4 * 3);
+    for(size_t i = 0; i < in.size(); i += 4)
+    {
+        const bool last = i + 4 == in.size();
+        // 只有最后一组允许填充，且 "=" 只能出现在末尾
+        const int pad = last ? ('=' == in[i + 3]) + ('=' == in[i + 2] && '=' == in[i + 3]) : 0;
+        uint32_t v = 0;
+        for(int j = 0; j < 4; ++j)
+        {
+            int8_t c = j >= 4 - pad ? 0 : s_table.values[static_cast<uint8_t>(in[i + j])];
+            if(c < 0)
+            {
+                return false;
+            }
+            v = (v << 6) | static_cast<uint32_t>(c);
+        }
+
+        out->push_back(static_cast<char>(v >> 16));
+        if(pad < 2)
+        {
+            out->push_back(static_cast<char>(v >> 8));
+        }
+        if(pad < 1)
+        {
+            out->push_back(static_cast<char>(v));
+        }
+    }
+    return true;
+}
+
+}   // kit_muduo
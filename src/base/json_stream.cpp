@@ -0,0 +1,576 @@
+/**
+ * @file json_stream.cpp
+ * @brief 无 DOM 的 JSON 解析器
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 11:58:41
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "base/json_stream.h"
+
+#include <cstring>
+
+namespace kit_muduo {
+
+namespace {
+
+bool IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/// @brief 读取 4 位十六进制
+bool ReadHex4(const char *&cur, const char *end, uint32_t *val)
+{
+    if(end - cur < 4)
+    {
+        return false;
+    }
+    uint32_t v = 0;
+    for(int i = 0; i < 4; ++i)
+    {
+        const char c = *cur++;
+        v <<= 4;
+        if(IsDigit(c))
+        {
+            v |= static_cast<uint32_t>(c - '0');
+        }
+        else if(c >= 'a' && c <= 'f')
+        {
+            v |= static_cast<uint32_t>(c - 'a' + 10);
+        }
+        else if(c >= 'A' && c <= 'F')
+        {
+            v |= static_cast<uint32_t>(c - 'A' + 10);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    *val = v;
+    return true;
+}
+
+void AppendUtf8(std::string *out, uint32_t cp)
+{
+    if(cp < 0x80)
+    {
+        out->push_back(static_cast<char>(cp));
+    }
+    else if(cp < 0x800)
+    {
+        out->push_back(static_cast<char>(0xc0 | (cp >> 6)));
+        out->push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+    else if(cp < 0x10000)
+    {
+        out->push_back(static_cast<char>(0xe0 | (cp >> 12)));
+        out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+        out->push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+    else
+    {
+        out->push_back(static_cast<char>(0xf0 | (cp >> 18)));
+        out->push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+        out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+        out->push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+}
+
+}
+
+std::string JsonReader::errorMessage() const
+{
+    if(ok())
+    {
+        return std::string();
+    }
+    return std::string(_error) + " at offset " + std::to_string(offset());
+}
+
+bool JsonReader::fail(const char *msg)
+{
+    if(nullptr == _error)
+    {
+        _error = msg;
+    }
+    return false;
+}
+
+bool JsonReader::expect(char c)
+{
+    skipSpace();
+    if(_cur < _end && *_cur == c)
+    {
+        ++_cur;
+        return true;
+    }
+    switch(c)
+    {
+        case '{': return fail("expected object");
+        case '[': return fail("expected array");
+        case ':': return fail("expected ':'");
+        default: return fail("unexpected character");
+    }
+}
+
+bool JsonReader::consumeLiteral(const char *literal, size_t len)
+{
+    if(static_cast<size_t>(_end - _cur) >= len && 0 == std::memcmp(_cur, literal, len))
+    {
+        _cur += len;
+        return true;
+    }
+    return fail("invalid literal");
+}
+
+bool JsonReader::consumeNull()
+{
+    if(!ok())
+    {
+        return false;
+    }
+    skipSpace();
+    if(_end - _cur >= 4 && 0 == std::memcmp(_cur, "null", 4))
+    {
+        _cur += 4;
+        return true;
+    }
+    return false;
+}
+
+bool JsonReader::readBool(bool *val)
+{
+    if(!ok())
+    {
+        return false;
+    }
+    skipSpace();
+    if(_cur < _end && 't' == *_cur)
+    {
+        *val = true;
+        return consumeLiteral("true", 4);
+    }
+    if(_cur < _end && 'f' == *_cur)
+    {
+        *val = false;
+        return consumeLiteral("false", 5);
+    }
+    return fail("expected boolean");
+}
+
+bool JsonReader::scanNumber(const char **start, const char **stop, bool *integral)
+{
+    if(!ok())
+    {
+        return false;
+    }
+    skipSpace();
+    const char *p = _cur;
+    if(p < _end && '-' == *p)
+    {
+        ++p;
+    }
+    if(p >= _end || !IsDigit(*p))
+    {
+        return fail("expected number");
+    }
+    // 除 0 本身外不允许前导零
+    if('0' == *p)
+    {
+        ++p;
+    }
+    else
+    {
+        while(p < _end && IsDigit(*p))
+        {
+            ++p;
+        }
+    }
+    *integral = true;
+    if(p < _end && '.' == *p)
+    {
+        ++p;
+        if(p >= _end || !IsDigit(*p))
+        {
+            return fail("invalid number");
+        }
+        while(p < _end && IsDigit(*p))
+        {
+            ++p;
+        }
+        *integral = false;
+    }
+    if(p < _end && ('e' == *p || 'E' == *p))
+    {
+        ++p;
+        if(p < _end && ('+' == *p || '-' == *p))
+        {
+            ++p;
+        }
+        if(p >= _end || !IsDigit(*p))
+        {
+            return fail("invalid number");
+        }
+        while(p < _end && IsDigit(*p))
+        {
+            ++p;
+        }
+        *integral = false;
+    }
+    *start = _cur;
+    *stop = p;
+    _cur = p;
+    return true;
+}
+
+bool JsonReader::readInt(int64_t *val)
+{
+    const char *start = nullptr;
+    const char *stop = nullptr;
+    bool integral = false;
+    if(!scanNumber(&start, &stop, &integral))
+    {
+        return false;
+    }
+    if(integral)
+    {
+        const auto res = std::from_chars(start, stop, *val);
+        return res.ec == std::errc() ? true : fail("integer out of range");
+    }
+    double num = 0;
+    const auto res = std::from_chars(start, stop, num);
+    if(res.ec != std::errc() || num != std::trunc(num) || num < -9223372036854775808.0 || num >= 9223372036854775808.0)
+    {
+        return fail("expected integer");
+    }
+    *val = static_cast<int64_t>(num);
+    return true;
+}
+
+bool JsonReader::readUint(uint64_t *val)
+{
+    const char *start = nullptr;
+    const char *stop = nullptr;
+    bool integral = false;
+    if(!scanNumber(&start, &stop, &integral))
+    {
+        return false;
+    }
+    if('-' == *start)
+    {
+        return fail("expected unsigned integer");
+    }
+    if(integral)
+    {
+        const auto res = std::from_chars(start, stop, *val);
+        return res.ec == std::errc() ? true : fail("integer out of range");
+    }
+    double num = 0;
+    const auto res = std::from_chars(start, stop, num);
+    if(res.ec != std::errc() || num != std::trunc(num) || num >= 18446744073709551616.0)
+    {
+        return fail("expected unsigned integer");
+    }
+    *val = static_cast<uint64_t>(num);
+    return true;
+}
+
+bool JsonReader::readDouble(double *val)
+{
+    const char *start = nullptr;
+    const char *stop = nullptr;
+    bool integral = false;
+    if(!scanNumber(&start, &stop, &integral))
+    {
+        return false;
+    }
+    const auto res = std::from_chars(start, stop, *val);
+    return res.ec == std::errc() ? true : fail("number out of range");
+}
+
+bool JsonReader::scanString(std::string_view *view, std::string *out)
+{
+    if(!ok())
+    {
+        return false;
+    }
+    skipSpace();
+    if(_cur >= _end || '"' != *_cur)
+    {
+        return fail("expected string");
+    }
+    const char *start = ++_cur;
+
+    // 绝大多数字符串不含转义，直接返回输入中的视图
+    while(_cur < _end)
+    {
+        const unsigned char c = static_cast<unsigned char>(*_cur);
+        if('"' == c)
+        {
+            *view = std::string_view(start, static_cast<size_t>(_cur - start));
+            ++_cur;
+            return true;
+        }
+        if('\\' == c)
+        {
+            break;
+        }
+        if(c < 0x20)
+        {
+            return fail("control character in string");
+        }
+        ++_cur;
+    }
+
+    out->assign(start, static_cast<size_t>(_cur - start));
+    while(_cur < _end)
+    {
+        const unsigned char c = static_cast<unsigned char>(*_cur);
+        if('"' == c)
+        {
+            ++_cur;
+            *view = *out;
+            return true;
+        }
+        if(c < 0x20)
+        {
+            return fail("control character in string");
+        }
+        if('\\' != c)
+        {
+            const char *run = _cur;
+            while(_cur < _end && '"' != *_cur && '\\' != *_cur && static_cast<unsigned char>(*_cur) >= 0x20)
+            {
+                ++_cur;
+            }
+            out->append(run, static_cast<size_t>(_cur - run));
+            continue;
+        }
+
+        if(++_cur >= _end)
+        {
+            break;
+        }
+        switch(*_cur++)
+        {
+            case '"': out->push_back('"'); break;
+            case '\\': out->push_back('\\'); break;
+            case '/': out->push_back('/'); break;
+            case 'b': out->push_back('\b'); break;
+            case 'f': out->push_back('\f'); break;
+            case 'n': out->push_back('\n'); break;
+            case 'r': out->push_back('\r'); break;
+            case 't': out->push_back('\t'); break;
+            case 'u':
+            {
+                uint32_t cp = 0;
+                if(!ReadHex4(_cur, _end, &cp))
+                {
+                    return fail("invalid unicode escape");
+                }
+                // UTF-16 代理对合成一个码点，落单的代理项视为错误
+                if(cp >= 0xd800 && cp <= 0xdbff)
+                {
+                    uint32_t low = 0;
+                    if(_end - _cur < 6 || '\\' != _cur[0] || 'u' != _cur[1])
+                    {
+                        return fail("invalid surrogate pair");
+                    }
+                    _cur += 2;
+                    if(!ReadHex4(_cur, _end, &low) || low < 0xdc00 || low > 0xdfff)
+                    {
+                        return fail("invalid surrogate pair");
+                    }
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                }
+                else if(cp >= 0xdc00 && cp <= 0xdfff)
+                {
+                    return fail("invalid surrogate pair");
+                }
+                AppendUtf8(out, cp);
+                break;
+            }
+            default:
+                return fail("invalid escape");
+        }
+    }
+    return fail("unterminated string");
+}
+
+bool JsonReader::readString(std::string *val)
+{
+    std::string_view view;
+    if(!scanString(&view, val))
+    {
+        return false;
+    }
+    if(view.data() != val->data())
+    {
+        val->assign(view.data(), view.size());
+    }
+    return true;
+}
+
+bool JsonReader::beginObject()
+{
+    if(!ok() || !expect('{'))
+    {
+        return false;
+    }
+    if(++_depth > kMaxDepth)
+    {
+        return fail("nesting too deep");
+    }
+    _first = true;
+    return true;
+}
+
+bool JsonReader::nextKey(std::string_view *key)
+{
+    if(!ok())
+    {
+        return false;
+    }
+    skipSpace();
+    if(_cur >= _end)
+    {
+        return fail("unterminated object");
+    }
+    if('}' == *_cur)
+    {
+        ++_cur;
+        --_depth;
+        _first = false;
+        return false;
+    }
+    if(!_first)
+    {
+        if(',' != *_cur)
+        {
+            return fail("expected ',' or '}'");
+        }
+        ++_cur;
+    }
+    _first = false;
+    return scanString(key, &_scratch) && expect(':');
+}
+
+bool JsonReader::beginArray()
+{
+    if(!ok() || !expect('['))
+    {
+        return false;
+    }
+    if(++_depth > kMaxDepth)
+    {
+        return fail("nesting too deep");
+    }
+    _first = true;
+    return true;
+}
+
+bool JsonReader::nextElement()
+{
+    if(!ok())
+    {
+        return false;
+    }
+    skipSpace();
+    if(_cur >= _end)
+    {
+        return fail("unterminated array");
+    }
+    if(']' == *_cur)
+    {
+        ++_cur;
+        --_depth;
+        _first = false;
+        return false;
+    }
+    if(!_first)
+    {
+        if(',' != *_cur)
+        {
+            return fail("expected ',' or ']'");
+        }
+        ++_cur;
+    }
+    _first = false;
+    return true;
+}
+
+bool JsonReader::skipValue()
+{
+    if(!ok())
+    {
+        return false;
+    }
+    skipSpace();
+    if(_cur >= _end)
+    {
+        return fail("unexpected end of input");
+    }
+    switch(*_cur)
+    {
+        case '{':
+        {
+            std::string_view key;
+            if(!beginObject())
+            {
+                return false;
+            }
+            while(nextKey(&key))
+            {
+                if(!skipValue())
+                {
+                    return false;
+                }
+            }
+            return ok();
+        }
+        case '[':
+        {
+            if(!beginArray())
+            {
+                return false;
+            }
+            while(nextElement())
+            {
+                if(!skipValue())
+                {
+                    return false;
+                }
+            }
+            return ok();
+        }
+        case '"':
+        {
+            std::string_view str;
+            return scanString(&str, &_scratch);
+        }
+        case 't': return consumeLiteral("true", 4);
+        case 'f': return consumeLiteral("false", 5);
+        case 'n': return consumeLiteral("null", 4);
+        default:
+        {
+            const char *start = nullptr;
+            const char *stop = nullptr;
+            bool integral = false;
+            return scanNumber(&start, &stop, &integral);
+        }
+    }
+}
+
+bool JsonReader::finish()
+{
+    if(!ok())
+    {
+        return false;
+    }
+    skipSpace();
+    return _cur == _end ? true : fail("trailing characters");
+}
+
+}   // kit_muduo
@@ -0,0 +1,377 @@
+/**
+ * @file metrics.cpp
+ * @brief 进程内指标: 计数器/仪表/延迟直方图，按线程分片无锁记录，采集时汇总
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 19:05:12
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "base/metrics.h"
+#include "base/base_log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <time.h>
+
+namespace kit_muduo::metrics {
+
+namespace {
+
+std::atomic<size_t> s_nextShard{0};
+thread_local size_t t_shard = kMaxShards;
+
+/// @brief 导出直方图时使用的累计桶上界
+const std::vector<int64_t>& PrometheusBounds()
+{
+    static const std::vector<int64_t> s_bounds = [](){
+        std::vector<int64_t> bounds;
+        for(int64_t scale = 100; scale <= 1000000000; scale *= 10)
+        {
+            bounds.push_back(scale);
+            bounds.push_back(scale * 5 / 2);
+            bounds.push_back(scale * 5);
+        }
+        bounds.push_back(10000000000);
+        return bounds;
+    }();
+    return s_bounds;
+}
+
+/// @brief HELP 文本转义反斜杠与换行
+void AppendEscapedHelp(std::string &out, const std::string &help)
+{
+    for(char c : help)
+    {
+        if('\\' == c)
+        {
+            out += "\\\\";
+        }
+        else if('\n' == c)
+        {
+            out += "\\n";
+        }
+        else
+        {
+            out += c;
+        }
+    }
+}
+
+const char* TypeName(MetricType type)
+{
+    switch(type)
+    {
+        case MetricType::kCounter: return "counter";
+        case MetricType::kGauge: return "gauge";
+        default: return "histogram";
+    }
+}
+
+}
+
+int64_t NowNs()
+{
+    struct timespec spec;
+    clock_gettime(CLOCK_MONOTONIC, &spec);
+    return static_cast<int64_t>(spec.tv_sec) * 1000000000 + spec.tv_nsec;
+}
+
+size_t ThreadShard()
+{
+    if(__builtin_expect(t_shard >= kMaxShards, 0))
+    {
+        t_shard = s_nextShard.fetch_add(1, std::memory_order_relaxed) % kMaxShards;
+    }
+    return t_shard;
+}
+
+/****************** ShardedValue ******************/
+int64_t ShardedValue::value() const
+{
+    int64_t total = 0;
+    for(auto &cell : _cells)
+    {
+        total += cell.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+/****************** Histogram ******************/
+Histogram::Shard::Shard()
+{
+    for(auto &bucket : buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+Histogram::Histogram()
+{
+    for(auto &slot : _shards)
+    {
+        slot.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+Histogram::~Histogram()
+{
+    for(auto &slot : _shards)
+    {
+        delete slot.load(std::memory_order_relaxed);
+    }
+}
+
+size_t Histogram::BucketIndex(int64_t value)
+{
+    const uint64_t v = static_cast<uint64_t>(value);
+    if(v < kSubBucketCount)
+    {
+        return static_cast<size_t>(v);
+    }
+    // 最高位之后保留 kSubBucketBits 位作为桶内偏移
+    const int32_t msb = 63 - __builtin_clzll(v);
+    const int32_t shift = msb - kSubBucketBits;
+    return static_cast<size_t>(shift) * kSubBucketCount + static_cast<size_t>(v >> shift);
+}
+
+int64_t Histogram::BucketLowerBound(size_t index)
+{
+    if(index < kSubBucketCount)
+    {
+        return static_cast<int64_t>(index);
+    }
+    const size_t shift = index / kSubBucketCount - 1;
+    const uint64_t mantissa = index - shift * kSubBucketCount;
+    return static_cast<int64_t>(mantissa << shift);
+}
+
+int64_t Histogram::BucketUpperBound(size_t index)
+{
+    if(index < kSubBucketCount)
+    {
+        return static_cast<int64_t>(index);
+    }
+    const size_t shift = index / kSubBucketCount - 1;
+    const uint64_t mantissa = index - shift * kSubBucketCount;
+    return static_cast<int64_t>(((mantissa + 1) << shift) - 1);
+}
+
+Histogram::Shard& Histogram::shard()
+{
+    std::atomic<Shard*> &slot = _shards[ThreadShard()];
+    Shard *current = slot.load(std::memory_order_acquire);
+    if(__builtin_expect(nullptr == current, 0))
+    {
+        Shard *fresh = new Shard();
+        if(slot.compare_exchange_strong(current, fresh, std::memory_order_acq_rel))
+        {
+            current = fresh;
+        }
+        else
+        {
+            // 共用分片的另一个线程已先分配
+            delete fresh;
+        }
+    }
+    return *current;
+}
+
+void Histogram::record(int64_t value)
+{
+    if(value < 0)
+    {
+        value = 0;
+    }
+    else if(value > kMaxValue)
+    {
+        value = kMaxValue;
+    }
+
+    Shard &s = shard();
+    s.buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    s.sum.fetch_add(value, std::memory_order_relaxed);
+    int64_t current = s.max.load(std::memory_order_relaxed);
+    while(value > current && !s.max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+Histogram::Snapshot Histogram::snapshot() const
+{
+    Snapshot snap;
+    snap.buckets.assign(kBucketCount, 0);
+    for(auto &slot : _shards)
+    {
+        const Shard *s = slot.load(std::memory_order_acquire);
+        if(!s)
+        {
+            continue;
+        }
+        for(size_t i = 0; i < kBucketCount; ++i)
+        {
+            snap.buckets[i] += s->buckets[i].load(std::memory_order_relaxed);
+        }
+        snap.sum += s->sum.load(std::memory_order_relaxed);
+        snap.max = std::max(snap.max, s->max.load(std::memory_order_relaxed));
+    }
+    // 与记录并发时各字段可能相差几次记录，count 以桶为准保证分位计算自洽
+    for(auto n : snap.buckets)
+    {
+        snap.count += n;
+    }
+    return snap;
+}
+
+int64_t Histogram::Snapshot::percentile(double q) const
+{
+    if(0 == count)
+    {
+        return 0;
+    }
+    q = std::min(std::max(q, 0.0), 1.0);
+    const uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * count)));
+    uint64_t seen = 0;
+    for(size_t i = 0; i < buckets.size(); ++i)
+    {
+        seen += buckets[i];
+        if(seen >= target)
+        {
+            return std::min(BucketUpperBound(i), max);
+        }
+    }
+    return max;
+}
+
+/****************** MetricsRegistry ******************/
+MetricsRegistry& MetricsRegistry::Instance()
+{
+    // 指标可能在静态析构阶段仍被后台线程记录，注册表不析构
+    static MetricsRegistry *s_registry = new MetricsRegistry();
+    return *s_registry;
+}
+
+MetricsRegistry::Entry* MetricsRegistry::findOrCreateUnLocked(const std::string &name, const std::string &help, MetricType type)
+{
+    auto it = _entries.find(name);
+    if(it != _entries.end())
+    {
+        if(it->second.type != type)
+        {
+            BASE_F_ERROR("Metrics", "metric %s registered with another type\n", name.c_str());
+            return nullptr;
+        }
+        return &it->second;
+    }
+
+    Entry &entry = _entries[name];
+    entry.type = type;
+    entry.help = help;
+    return &entry;
+}
+
+Counter& MetricsRegistry::counter(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry *entry = findOrCreateUnLocked(name, help, MetricType::kCounter);
+    if(!entry)
+    {
+        _orphans.emplace_back();
+        entry = &_orphans.back();
+    }
+    if(!entry->counter)
+    {
+        entry->counter.reset(new Counter());
+    }
+    return *entry->counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry *entry = findOrCreateUnLocked(name, help, MetricType::kGauge);
+    if(!entry)
+    {
+        _orphans.emplace_back();
+        entry = &_orphans.back();
+    }
+    if(!entry->gauge)
+    {
+        entry->gauge.reset(new Gauge());
+    }
+    return *entry->gauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry *entry = findOrCreateUnLocked(name, help, MetricType::kHistogram);
+    if(!entry)
+    {
+        _orphans.emplace_back();
+        entry = &_orphans.back();
+    }
+    if(!entry->histogram)
+    {
+        entry->histogram.reset(new Histogram());
+    }
+    return *entry->histogram;
+}
+
+std::vector<MetricsRegistry::Sample> MetricsRegistry::snapshot() const
+{
+    std::vector<Sample> samples;
+    std::lock_guard<std::mutex> lock(_mutex);
+    samples.reserve(_entries.size());
+    for(auto &it : _entries)
+    {
+        Sample sample;
+        sample.name = it.first;
+        sample.help = it.second.help;
+        sample.type = it.second.type;
+        switch(it.second.type)
+        {
+            case MetricType::kCounter: sample.value = it.second.counter->value(); break;
+            case MetricType::kGauge: sample.value = it.second.gauge->value(); break;
+            case MetricType::kHistogram: sample.histogram = it.second.histogram->snapshot(); break;
+        }
+        samples.push_back(std::move(sample));
+    }
+    return samples;
+}
+
+std::string FormatPrometheus(const std::vector<MetricsRegistry::Sample> &samples)
+{
+    std::string out;
+    out.reserve(samples.size() * 128);
+    for(auto &sample : samples)
+    {
+        out.append("# HELP ").append(sample.name).append(1, ' ');
+        AppendEscapedHelp(out, sample.help);
+        out.append("\n# TYPE ").append(sample.name).append(1, ' ').append(TypeName(sample.type)).append(1, '\n');
+
+        if(MetricType::kHistogram != sample.type)
+        {
+            out.append(sample.name).append(1, ' ').append(std::to_string(sample.value)).append(1, '\n');
+            continue;
+        }
+
+        const Histogram::Snapshot &snap = sample.histogram;
+        uint64_t cumulative = 0;
+        size_t index = 0;
+        for(int64_t bound : PrometheusBounds())
+        {
+            while(index < snap.buckets.size() && Histogram::BucketUpperBound(index) <= bound)
+            {
+                cumulative += snap.buckets[index++];
+            }
+            out.append(sample.name).append("_bucket{le=\"").append(std::to_string(bound)).append("\"} ")
+               .append(std::to_string(cumulative)).append(1, '\n');
+        }
+        out.append(sample.name).append("_bucket{le=\"+Inf\"} ").append(std::to_string(snap.count)).append(1, '\n');
+        out.append(sample.name).append("_sum ").append(std::to_string(snap.sum)).append(1, '\n');
+        out.append(sample.name).append("_count ").append(std::to_string(snap.count)).append(1, '\n');
+    }
+    return out;
+}
+
+}   // kit_muduo::metrics
@@ -9,6 +9,7 @@
 
 #include "base/thread_pool.h"
 #include "base/base_log.h"
+#include "base/metrics.h"
 
 #include <cassert>
 #include <exception>
@@ -22,6 +23,25 @@
 
 namespace kit_muduo {
 
+namespace {
+
+struct ThreadPoolMetrics
+{
+    metrics::Gauge &queue_depth;
+    metrics::Histogram &wait_ns;
+};
+
+ThreadPoolMetrics& PoolMetrics()
+{
+    static ThreadPoolMetrics s_metrics{
+        metrics::MetricsRegistry::Instance().gauge("kit_thread_pool_queue_depth", "Tasks waiting in thread pool queues"),
+        metrics::MetricsRegistry::Instance().histogram("kit_thread_pool_wait_ns", "Time tasks spent queued before running (ns)"),
+    };
+    return s_metrics;
+}
+
+}
+
 ThreadPool::ThreadPool(int32_t initThreadCount)
     :init_thread_count_(initThreadCount)
     ,cur_thread_count_(0)
@@ -172,12 +192,16 @@ void ThreadPool::threadRunFunc(uint32_t generateId)
         
         TPOOL_F_INFO("wait task size=%d, isRun=%d \n", task_que_.size(), is_running_.load());
 
-        auto task = task_que_.front();
+        QueuedTask queued = std::move(task_que_.front());
         task_que_.pop();
         --cur_task_count_;
 
         lock.unlock();
 
+        PoolMetrics().queue_depth.dec();
+        PoolMetrics().wait_ns.record(metrics::NowNs() - queued.enqueue_ns);
+        Task &task = queued.task;
+
         notFull_.notify_one();
 
         if(task)
@@ -203,6 +227,13 @@ void ThreadPool::threadRunFunc(uint32_t generateId)
     waitExit_.notify_one();
 }
 
+void ThreadPool::pushTaskUnLocked(Task task)
+{
+    task_que_.push(QueuedTask{std::move(task), metrics::NowNs()});
+    ++cur_task_count_;
+    PoolMetrics().queue_depth.inc();
+}
+
 void ThreadPool::setTaskQueMaxThreshHold(int32_t threshhold)
 {
     if(checkState())
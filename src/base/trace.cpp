@@ -0,0 +1,321 @@
+/**
+ * @file trace.cpp
+ * @brief 轻量请求追踪: 按采样率记录耗时区间到线程本地环形缓冲，按需导出 Chrome trace-event JSON
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 20:30:18
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "base/trace.h"
+#include "base/metrics.h"
+#include "base/util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+namespace kit_muduo::trace {
+
+namespace detail {
+std::atomic<uint32_t> g_sampleThreshold{0};
+}
+
+namespace {
+
+constexpr size_t kDefaultRingCapacity = 4096;
+/// @brief 最多保留的已退出线程缓冲，线程池频繁伸缩时避免无限增长
+constexpr size_t kMaxRetiredRings = 64;
+
+struct Event
+{
+    uint64_t trace_id{0};
+    const char *name{nullptr};
+    int64_t begin_ns{0};
+    int64_t end_ns{0};
+    std::string detail;
+};
+
+/**
+ * @brief 单个线程的环形缓冲，写满后覆盖最旧的事件
+ * @note 只有所属线程写入，锁仅在导出/清空时才有竞争
+ */
+struct Ring
+{
+    std::mutex mutex;
+    std::vector<Event> events;
+    /// @brief 累计写入的事件数
+    size_t written{0};
+    pid_t tid{0};
+    std::string thread_name;
+    bool retired{false};
+};
+
+struct RingRegistry
+{
+    std::mutex mutex;
+    std::list<std::shared_ptr<Ring>> rings;
+    std::atomic<size_t> capacity{kDefaultRingCapacity};
+};
+
+RingRegistry& Registry()
+{
+    // 线程退出时仍会访问注册表，不析构
+    static RingRegistry *s_registry = new RingRegistry();
+    return *s_registry;
+}
+
+/// @brief 释放多余的已退出线程缓冲，调用方需持有注册表锁
+void PruneRetiredUnLocked(RingRegistry &registry)
+{
+    size_t retired = 0;
+    for(auto &ring : registry.rings)
+    {
+        retired += ring->retired ? 1 : 0;
+    }
+    for(auto it = registry.rings.begin(); it != registry.rings.end() && retired > kMaxRetiredRings; )
+    {
+        if((*it)->retired)
+        {
+            it = registry.rings.erase(it);
+            --retired;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+struct ThreadRing
+{
+    std::shared_ptr<Ring> ring;
+
+    ~ThreadRing()
+    {
+        if(!ring)
+        {
+            return;
+        }
+        // 已退出线程的事件保留到导出，超出上限时释放最早的
+        RingRegistry &registry = Registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        ring->retired = true;
+        PruneRetiredUnLocked(registry);
+    }
+};
+
+thread_local ThreadRing t_ring;
+thread_local uint64_t t_rngState = 0;
+std::atomic<uint64_t> s_nextTraceId{1};
+
+Ring& LocalRing()
+{
+    if(__builtin_expect(!t_ring.ring, 0))
+    {
+        RingRegistry &registry = Registry();
+        auto ring = std::make_shared<Ring>();
+        ring->events.resize(std::max<size_t>(1, registry.capacity.load(std::memory_order_relaxed)));
+        ring->tid = GetThreadPid();
+        ring->thread_name = GetThreadName();
+
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.rings.push_back(ring);
+        t_ring.ring = std::move(ring);
+    }
+    return *t_ring.ring;
+}
+
+/// @brief 线程本地 xorshift64，采样决策不需要密码学随机
+uint64_t NextRandom()
+{
+    if(__builtin_expect(0 == t_rngState, 0))
+    {
+        t_rngState = (static_cast<uint64_t>(GetThreadPid()) << 32) ^ static_cast<uint64_t>(metrics::NowNs()) ^ 0x9E3779B97F4A7C15ull;
+    }
+    uint64_t x = t_rngState;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    t_rngState = x;
+    return x;
+}
+
+void AppendJsonString(std::string &out, const std::string &str)
+{
+    out += '"';
+    for(unsigned char c : str)
+    {
+        switch(c)
+        {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if(c < 0x20)
+                {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                }
+                else
+                {
+                    out += static_cast<char>(c);
+                }
+                break;
+        }
+    }
+    out += '"';
+}
+
+}
+
+void SetSampleRate(double rate)
+{
+    uint32_t threshold = 0;
+    if(rate >= 1.0)
+    {
+        threshold = std::numeric_limits<uint32_t>::max();
+    }
+    else if(rate > 0.0)
+    {
+        threshold = std::max<uint32_t>(1, static_cast<uint32_t>(rate * 4294967296.0));
+    }
+    detail::g_sampleThreshold.store(threshold, std::memory_order_relaxed);
+}
+
+double SampleRate()
+{
+    const uint32_t threshold = detail::g_sampleThreshold.load(std::memory_order_relaxed);
+    if(std::numeric_limits<uint32_t>::max() == threshold)
+    {
+        return 1.0;
+    }
+    return threshold / 4294967296.0;
+}
+
+uint64_t Sample()
+{
+    const uint32_t threshold = detail::g_sampleThreshold.load(std::memory_order_relaxed);
+    if(0 == threshold)
+    {
+        return 0;
+    }
+    if(std::numeric_limits<uint32_t>::max() != threshold
+        && static_cast<uint32_t>(NextRandom() >> 32) >= threshold)
+    {
+        return 0;
+    }
+    return s_nextTraceId.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SetRingCapacity(size_t capacity)
+{
+    Registry().capacity.store(capacity, std::memory_order_relaxed);
+}
+
+void Record(uint64_t traceId, const char *name, int64_t beginNs, int64_t endNs, const std::string &detail)
+{
+    if(0 == traceId)
+    {
+        return;
+    }
+    Ring &ring = LocalRing();
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    Event &event = ring.events[ring.written % ring.events.size()];
+    event.trace_id = traceId;
+    event.name = name;
+    event.begin_ns = beginNs;
+    event.end_ns = std::max(beginNs, endNs);
+    event.detail = detail;
+    ++ring.written;
+}
+
+std::string DumpChromeTrace()
+{
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+    RingRegistry &registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    rings.assign(registry.rings.begin(), registry.rings.end());
+    }
+
+    const int32_t pid = static_cast<int32_t>(::getpid());
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    char buf[256];
+    auto separator = [&out, &first]() {
+        if(!first)
+        {
+            out += ',';
+        }
+        first = false;
+    };
+
+    for(auto &ring : rings)
+    {
+        std::lock_guard<std::mutex> lock(ring->mutex);
+        if(0 == ring->written)
+        {
+            continue;
+        }
+
+        // 线程名元数据
+        separator();
+        std::snprintf(buf, sizeof(buf), "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+                      pid, static_cast<int32_t>(ring->tid));
+        out += buf;
+        AppendJsonString(out, ring->thread_name);
+        out += "}}";
+
+        const size_t capacity = ring->events.size();
+        const size_t count = std::min(ring->written, capacity);
+        for(size_t i = ring->written - count; i < ring->written; ++i)
+        {
+            const Event &event = ring->events[i % capacity];
+            separator();
+            // ts/dur 以微秒为单位，保留纳秒精度
+            std::snprintf(buf, sizeof(buf),
+                          "{\"ph\":\"X\",\"cat\":\"kit\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                          "\"args\":{\"trace_id\":%llu",
+                          event.name, pid, static_cast<int32_t>(ring->tid),
+                          event.begin_ns / 1000.0, (event.end_ns - event.begin_ns) / 1000.0,
+                          static_cast<unsigned long long>(event.trace_id));
+            out += buf;
+            if(!event.detail.empty())
+            {
+                out += ",\"detail\":";
+                AppendJsonString(out, event.detail);
+            }
+            out += "}}";
+        }
+    }
+    out += "]}";
+    return out;
+}
+
+void Clear()
+{
+    RingRegistry &registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for(auto it = registry.rings.begin(); it != registry.rings.end(); )
+    {
+        // retired 只在持有注册表锁时修改
+        if((*it)->retired)
+        {
+            it = registry.rings.erase(it);
+            continue;
+        }
+        std::lock_guard<std::mutex> ring_lock((*it)->mutex);
+        (*it)->written = 0;
+        ++it;
+    }
+}
+
+}   // kit_muduo::trace
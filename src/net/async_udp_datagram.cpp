@@ -159,27 +159,50 @@ void AsyncUdpDatagram::send(const void* buf, size_t len, const InetAddress &peer
 }
 
 void AsyncUdpDatagram::send(const std::vector<uint8_t> &message, const InetAddress &peer_addr)
+{
+    queueSend(PendingDatagram{message, peer_addr});
+}
+
+void AsyncUdpDatagram::send(const SharedBuffer &message, size_t offset, const InetAddress &peer_addr)
+{
+    if(!message || offset > message->size())
+    {
+        UDP_F_ERROR("AsyncUdpDatagram::send invalid shared buffer: name[%s], fd[%d], offset[%zu]\n",
+            name().c_str(),
+            fd(),
+            offset);
+        return;
+    }
+
+    PendingDatagram datagram;
+    datagram.peer_addr = peer_addr;
+    datagram.shared = message;
+    datagram.offset = offset;
+    queueSend(std::move(datagram));
+}
+
+void AsyncUdpDatagram::queueSend(PendingDatagram datagram)
 {
     if(kActive != state_)
     {
         UDP_F_INFO("fd[%d][%s] not active, drop udp datagram to [%s], state[%d]\n",
             fd(),
             name().c_str(),
-            peer_addr.toIpPort().c_str(),
+            datagram.peer_addr.toIpPort().c_str(),
             state_.load());
         return;
     }
 
     if(base_loop_->isInLoopThread())
     {
-        sendInLoop(message, peer_addr);
+        sendInLoop(std::move(datagram));
     }
     else
     {
-        UDP_F_DEBUG("AsyncUdpDatagram::send queue fd[%d][%s] \n", fd(), peer_addr.toIpPort().c_str());
+        UDP_F_DEBUG("AsyncUdpDatagram::send queue fd[%d][%s] \n", fd(), datagram.peer_addr.toIpPort().c_str());
 
-        base_loop_->queueInLoop([self = shared_from_this(), message, peer_addr]() {
-            self->sendInLoop(message, peer_addr);
+        base_loop_->queueInLoop([self = shared_from_this(), datagram = std::move(datagram)]() mutable {
+            self->sendInLoop(std::move(datagram));
         });
     }
 }
@@ -318,7 +341,7 @@ void AsyncUdpDatagram::handleWrite()
     while(!pending_datagrams_.empty())
     {
         const PendingDatagram &datagram = pending_datagrams_.front();
-        ssize_t n = sendDatagramInLoop(datagram.payload, datagram.peer_addr);
+        ssize_t n = sendDatagramInLoop(datagram);
         if(n < 0)
         {
             if(EAGAIN == errno || EWOULDBLOCK == errno)
@@ -336,11 +359,11 @@ void AsyncUdpDatagram::handleWrite()
             continue;
         }
 
-        if(static_cast<size_t>(n) != datagram.payload.size())
+        if(static_cast<size_t>(n) != datagram.size())
         {
             UDP_F_ERROR("fd[%d] udp short write! expect[%zu], actual[%zd], peer[%s]\n",
                 cur_fd,
-                datagram.payload.size(),
+                datagram.size(),
                 n,
                 datagram.peer_addr.toIpPort().c_str());
             notifyError(EIO, datagram.peer_addr);
@@ -397,18 +420,19 @@ void AsyncUdpDatagram::notifyError(int32_t err, const InetAddress &peer_addr)
     }
 }
 
-ssize_t AsyncUdpDatagram::sendDatagramInLoop(const std::vector<uint8_t>& message, const InetAddress &peer_addr)
+ssize_t AsyncUdpDatagram::sendDatagramInLoop(const PendingDatagram &datagram)
 {
     return ::sendto(fd(),
-        message.data(),
-        message.size(),
+        datagram.data(),
+        datagram.size(),
         0,
-        reinterpret_cast<const sockaddr*>(peer_addr.getSockAddr()),
+        reinterpret_cast<const sockaddr*>(datagram.peer_addr.getSockAddr()),
         static_cast<socklen_t>(sizeof(sockaddr_in)));
 }
 
-void AsyncUdpDatagram::sendInLoop(const std::vector<uint8_t>& message, const InetAddress &peer_addr)
+void AsyncUdpDatagram::sendInLoop(PendingDatagram datagram)
 {
+    const InetAddress &peer_addr = datagram.peer_addr;
     int32_t cur_fd = fd();
 
     if(kActive != state_)
@@ -424,7 +448,7 @@ void AsyncUdpDatagram::sendInLoop(const std::vector<uint8_t>& message, const Ine
     {
         UDP_F_DEBUG("AsyncUdpDatagram::sendInLoop write fd[%d][%s]\n", cur_fd, name().c_str());
 
-        ssize_t n = sendDatagramInLoop(message, peer_addr);
+        ssize_t n = sendDatagramInLoop(datagram);
         if(n < 0)
         {
             if(EAGAIN != errno && EWOULDBLOCK != errno)
@@ -441,12 +465,12 @@ void AsyncUdpDatagram::sendInLoop(const std::vector<uint8_t>& message, const Ine
         }
         else
         {
-            if(static_cast<size_t>(n) != message.size())
+            if(static_cast<size_t>(n) != datagram.size())
             {
                 UDP_F_ERROR("sendInLoop udp short write! name[%s], fd[%d], expect[%zu], actual[%zd], peer[%s]\n",
                     name().c_str(),
                     cur_fd,
-                    message.size(),
+                    datagram.size(),
                     n,
                     peer_addr.toIpPort().c_str());
                 notifyError(EIO, peer_addr);
@@ -458,7 +482,7 @@ void AsyncUdpDatagram::sendInLoop(const std::vector<uint8_t>& message, const Ine
         }
     }
 
-    pending_datagrams_.push_back(PendingDatagram{message, peer_addr});
+    pending_datagrams_.push_back(std::move(datagram));
 
     UDP_F_INFO("AsyncUdpDatagram::sendInLoop queue datagram fd[%d][%s], pending[%zu]\n",
         cur_fd, name().c_str(), pending_datagrams_.size());
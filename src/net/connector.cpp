@@ -0,0 +1,258 @@
+/**
+ * @file connector.cpp
+ * @brief 客户端主动连接器: 非阻塞 connect、失败退避重试、自连接检测
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 16:34:02
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/connector.h"
+#include "net/channel.h"
+#include "net/event_loop.h"
+#include "net/socket.h"
+#include "net/net_log.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <random>
+
+namespace kit_muduo {
+
+namespace {
+
+int32_t SocketError(int32_t sockfd)
+{
+    int32_t opt = 0;
+    socklen_t len = sizeof(opt);
+    if(::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &opt, &len) < 0)
+    {
+        return errno;
+    }
+    return opt;
+}
+
+/// @brief 本端地址与对端地址相同: 连到了自己
+bool IsSelfConnect(int32_t sockfd)
+{
+    const InetAddress local = InetAddress::GetLocalAddr(sockfd);
+    const InetAddress peer = InetAddress::GetPeerAddr(sockfd);
+    return local.getSockAddr()->sin_port == peer.getSockAddr()->sin_port
+        && local.getSockAddr()->sin_addr.s_addr == peer.getSockAddr()->sin_addr.s_addr;
+}
+
+/// @brief 参数/权限类错误，重试也不会成功
+bool IsFatalConnectError(int32_t err)
+{
+    switch(err)
+    {
+        case EACCES:
+        case EPERM:
+        case EAFNOSUPPORT:
+        case EALREADY:
+        case EBADF:
+        case EFAULT:
+        case ENOTSOCK:
+            return true;
+        default:
+            return false;
+    }
+}
+
+double RandomUnit()
+{
+    static thread_local std::mt19937 s_rng(std::random_device{}());
+    return std::uniform_real_distribution<double>(0.0, 1.0)(s_rng);
+}
+
+}
+
+int64_t Connector::JitterDelay(int64_t delayMs, double jitter)
+{
+    jitter = std::clamp(jitter, 0.0, 1.0);
+    const double factor = 1.0 - jitter + 2.0 * jitter * RandomUnit();
+    return std::max<int64_t>(1, static_cast<int64_t>(delayMs * factor));
+}
+
+Connector::Connector(EventLoop *loop, const InetAddress &serverAddr)
+    :_loop(loop)
+    ,_serverAddr(serverAddr)
+{
+    CLI_F_DEBUG("Connector create: %s\n", _serverAddr.toIpPort().c_str());
+}
+
+Connector::~Connector()
+{
+    CLI_F_DEBUG("~Connector: %s, state[%d]\n", _serverAddr.toIpPort().c_str(), _state);
+    if(_channel)
+    {
+        // 析构时仍在连接中只会发生在循环已退出之后
+        const int32_t sockfd = _channel->fd();
+        _channel->disableAll();
+        _channel->remove();
+        ::close(sockfd);
+    }
+}
+
+void Connector::start()
+{
+    _connect = true;
+    _loop->runInLoop(std::bind(&Connector::startInLoop, shared_from_this()));
+}
+
+void Connector::stop()
+{
+    _connect = false;
+    _loop->runInLoop(std::bind(&Connector::stopInLoop, shared_from_this()));
+}
+
+void Connector::startInLoop()
+{
+    if(_connect && kDisconnected == _state)
+    {
+        connect();
+    }
+}
+
+void Connector::restart()
+{
+    _state = kDisconnected;
+    _retryDelayMs = _backoff.initialDelayMs;
+    _connect = true;
+    startInLoop();
+}
+
+void Connector::stopInLoop()
+{
+    if(_retryTimer)
+    {
+        _loop->cancel(_retryTimer);
+        _retryTimer.reset();
+    }
+    if(kConnecting == _state)
+    {
+        _state = kDisconnected;
+        ::close(removeAndResetChannel());
+    }
+}
+
+void Connector::connect()
+{
+    const int32_t sockfd = Socket::CreateTcpIpv4(true);
+    const sockaddr_in *addr = _serverAddr.getSockAddr();
+    const int32_t ret = ::connect(sockfd, reinterpret_cast<const sockaddr*>(addr), sizeof(*addr));
+    const int32_t err = (0 == ret) ? 0 : errno;
+    switch(err)
+    {
+        case 0:
+        case EINPROGRESS:
+        case EINTR:
+        case EISCONN:
+            connecting(sockfd);
+            break;
+        default:
+            fail(sockfd, err);
+            break;
+    }
+}
+
+void Connector::connecting(int32_t sockfd)
+{
+    _state = kConnecting;
+    _channel.reset(new Channel(_loop, sockfd));
+    _channel->setWriteCallback(std::bind(&Connector::handleWrite, this));
+    _channel->setErrorCallback(std::bind(&Connector::handleError, this));
+    _channel->tie(shared_from_this());
+    // 连接完成(成功或失败)时 fd 变为可写
+    _channel->enableWriting();
+}
+
+int32_t Connector::removeAndResetChannel()
+{
+    const int32_t sockfd = _channel->fd();
+    _channel->disableAll();
+    _channel->remove();
+    // 可能正处于该 channel 的事件回调中，不能立即释放
+    _loop->queueInLoop([channel = std::shared_ptr<Channel>(_channel.release())]() {});
+    return sockfd;
+}
+
+void Connector::handleWrite()
+{
+    if(kConnecting != _state)
+    {
+        return;
+    }
+    const int32_t sockfd = removeAndResetChannel();
+    const int32_t err = SocketError(sockfd);
+    if(0 != err)
+    {
+        fail(sockfd, err);
+        return;
+    }
+    if(IsSelfConnect(sockfd))
+    {
+        CLI_F_WARN("self connect %s!\n", _serverAddr.toIpPort().c_str());
+        fail(sockfd, ECONNREFUSED);
+        return;
+    }
+
+    _state = kConnected;
+    if(_connect && _newConnectionCallback)
+    {
+        _newConnectionCallback(sockfd);
+    }
+    else
+    {
+        ::close(sockfd);
+    }
+}
+
+void Connector::handleError()
+{
+    if(kConnecting != _state)
+    {
+        return;
+    }
+    const int32_t sockfd = removeAndResetChannel();
+    fail(sockfd, SocketError(sockfd));
+}
+
+void Connector::fail(int32_t sockfd, int32_t err)
+{
+    CLI_F_WARN("connect %s failed! %d:%s\n", _serverAddr.toIpPort().c_str(), err, strerror(err));
+    ::close(sockfd);
+    _state = kDisconnected;
+    if(!_connect)
+    {
+        return;
+    }
+    if(_retry && !IsFatalConnectError(err))
+    {
+        retry();
+        return;
+    }
+    if(_errorCallback)
+    {
+        _errorCallback(err);
+    }
+}
+
+void Connector::retry()
+{
+    const int64_t delay = JitterDelay(_retryDelayMs, _backoff.jitter);
+    CLI_F_INFO("retry connecting %s in %ld ms\n", _serverAddr.toIpPort().c_str(), static_cast<long>(delay));
+    _retryTimer = _loop->runAfter(delay, [weak = std::weak_ptr<Connector>(shared_from_this())]() {
+        if(auto self = weak.lock())
+        {
+            self->_retryTimer.reset();
+            self->startInLoop();
+        }
+    });
+    _retryDelayMs = std::min(_retryDelayMs * 2, _backoff.maxDelayMs);
+}
+
+}   // kit_muduo
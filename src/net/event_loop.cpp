@@ -14,6 +14,7 @@
 #include "base/util.h"
 #include "net/timer.h"
 #include "net/sample_timer_queue.h"
+#include "base/metrics.h"
 
 #include <sys/eventfd.h>
 #include <assert.h>
@@ -27,6 +28,28 @@ thread_local EventLoop* t_loopInThread = nullptr;
 /// @brief 事件循环默认超时10s
 static const int32_t kPollTimeOutMs = 10000;
 
+namespace {
+
+struct EventLoopMetrics
+{
+    /// @brief 一轮循环中处理就绪事件与待执行回调的耗时(不含 poll 等待)
+    metrics::Histogram &iteration_ns;
+    metrics::Gauge &pending_funcs;
+    metrics::Counter &funcs;
+};
+
+EventLoopMetrics& LoopMetrics()
+{
+    static EventLoopMetrics s_metrics{
+        metrics::MetricsRegistry::Instance().histogram("kit_event_loop_iteration_ns", "Event loop busy time per iteration (ns)"),
+        metrics::MetricsRegistry::Instance().gauge("kit_event_loop_pending_funcs", "Functors queued to event loops and not yet run"),
+        metrics::MetricsRegistry::Instance().counter("kit_event_loop_funcs_total", "Functors run by event loops"),
+    };
+    return s_metrics;
+}
+
+}
+
 EventLoop::EventLoop()
     :_looping(false)
     ,_quit(true)
@@ -73,6 +96,12 @@ EventLoop::~EventLoop()
         _wakeupFd = -1;
     }
 
+    // 未执行的回调随循环一起丢弃
+    if(!_pendingFuncs.empty())
+    {
+        LoopMetrics().pending_funcs.dec(static_cast<int64_t>(_pendingFuncs.size()));
+    }
+
     t_loopInThread = nullptr;
     LOOP_F_DEBUG("EventLoop::~EventLoop()\n", _wakeupFd);
 }
@@ -84,10 +113,12 @@ void EventLoop::loop()
 
     LOOP_INFO() << "EventLoop start! t=" << t_loopInThread << ", pid="  << _threadId << std::endl;
 
+    EventLoopMetrics &loop_metrics = LoopMetrics();
     while(!_quit)
     {
         _activeChannels.clear();
         _pollReturnTime = _poller->poll(kPollTimeOutMs, &_activeChannels);
+        const int64_t busy_begin = metrics::NowNs();
         for(auto &c : _activeChannels)
         {
             c->handleEvent(_pollReturnTime);
@@ -95,6 +126,7 @@ void EventLoop::loop()
 
         // 特别注意：这里执行的是提前缓存的回调队列中的函数，而不是Channel中的读写回调函数
         doPendingFuncs();
+        loop_metrics.iteration_ns.record(metrics::NowNs() - busy_begin);
     }
 
     LOOP_INFO() << "EventLoop exit! " << t_loopInThread << "pid= "  << _threadId << std::endl;
@@ -133,15 +165,16 @@ void EventLoop::runInLoop(Func cb)
     }
     else   //事件循环运行在其他线程则入队
     {
-        queueInLoop(cb);
+        queueInLoop(std::move(cb));
     }
 }
 
 void EventLoop::queueInLoop(Func cb)
 {
     std::unique_lock<std::mutex> lock(_mutex);
-    _pendingFuncs.emplace_back(cb);
+    _pendingFuncs.emplace_back(std::move(cb));
     lock.unlock();
+    LoopMetrics().pending_funcs.inc();
 
     // 难点：为什么要判断_callingPendingFunc
     // 答：poller会阻塞，触发一次唤醒事件，在下一轮的doPendingFuncs才能够被唤醒继续执行，否则将永远阻塞
@@ -184,6 +217,20 @@ bool EventLoop::hasChannel(Channel *channel)
     return _poller->hasChannel(channel);
 }
 
+EventLoop::Stats EventLoop::stats() const
+{
+    Stats stats;
+    stats.thread_id = _threadId;
+    stats.looping = _looping;
+    stats.channels = _poller->channelCount();
+    stats.timers = _timerQueue->size();
+    {
+    std::lock_guard<std::mutex> lock(_mutex);
+    stats.pending_funcs = _pendingFuncs.size();
+    }
+    return stats;
+}
+
 void EventLoop::handleRead()
 {
     uint64_t one = 1;
@@ -207,6 +254,12 @@ void EventLoop::doPendingFuncs()
     tmp_func.swap(_pendingFuncs);
     lock.unlock();
 
+    if(!tmp_func.empty())
+    {
+        LoopMetrics().pending_funcs.dec(static_cast<int64_t>(tmp_func.size()));
+        LoopMetrics().funcs.inc(static_cast<int64_t>(tmp_func.size()));
+    }
+
 
     for(auto &f : tmp_func)
         if(f) f();
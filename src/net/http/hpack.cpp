@@ -0,0 +1,683 @@
+/**
+ * @file hpack.cpp
+ * @brief HPACK(RFC 7541): HTTP/2 头部压缩，静态表/动态表与 Huffman 编解码
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 01:05:18
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/hpack.h"
+
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+
+namespace kit_muduo::http {
+
+namespace {
+
+struct HuffmanCode
+{
+    uint32_t code;
+    uint8_t bits;
+};
+
+/// @brief RFC 7541 附录 B，最后一项为 EOS(256)
+constexpr HuffmanCode kHuffmanCodes[257] = {
+    {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28},
+    {0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+    {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+    {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+    {0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28},
+    {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+    {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28},
+    {0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+    {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+    {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11},
+    {0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11},
+    {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+    {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6},
+    {0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6},
+    {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+    {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+    {0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7},
+    {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+    {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7},
+    {0x67, 7}, {0x68, 7}, {0x69, 7}, {0x6a, 7},
+    {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+    {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7},
+    {0xfc, 8}, {0x73, 7}, {0xfd, 8}, {0x1ffb, 13},
+    {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+    {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5},
+    {0x24, 6}, {0x5, 5}, {0x25, 6}, {0x26, 6},
+    {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+    {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5},
+    {0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5},
+    {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+    {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15},
+    {0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+    {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+    {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23},
+    {0x3fffd6, 22}, {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23},
+    {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+    {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23},
+    {0xffffee, 24}, {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23},
+    {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+    {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24},
+    {0x3fffda, 22}, {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22},
+    {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+    {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24},
+    {0x1fffdf, 21}, {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23},
+    {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+    {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23},
+    {0xfffea, 20}, {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22},
+    {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+    {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19},
+    {0x3fffe7, 22}, {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25},
+    {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+    {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25},
+    {0x7fff2, 19}, {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27},
+    {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+    {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26},
+    {0xffffffd, 28}, {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27},
+    {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+    {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23},
+    {0x3fffea, 22}, {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25},
+    {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+    {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26},
+    {0x7ffffe7, 27}, {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27},
+    {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+    {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+    {0x3fffffff, 30},
+};
+
+constexpr uint16_t kHuffmanEos = 256;
+
+/**
+ * @brief 按4位一组解码的状态机: 状态为码树内部节点，码长至少5位，每步最多输出一个符号
+ */
+struct HuffmanDecodeTable
+{
+    enum Flags: uint8_t {
+        kEmit = 1,
+        kFail = 2,
+    };
+
+    struct Transition {
+        uint8_t next{0};
+        uint8_t flags{0};
+        uint8_t symbol{0};
+    };
+
+    std::array<std::array<Transition, 16>, 256> transitions;
+    /// @brief 停在该状态结束时是否合法(从根起全为1且不足8位的填充)
+    std::array<bool, 256> accept{};
+
+    HuffmanDecodeTable()
+    {
+        // 先建码树，节点 0 为根
+        struct Node { int child[2]{-1, -1}; int symbol{-1}; };
+        std::vector<Node> nodes(1);
+        for(int sym = 0; sym <= kHuffmanEos; ++sym)
+        {
+            int cur = 0;
+            for(int bit = kHuffmanCodes[sym].bits - 1; bit >= 0; --bit)
+            {
+                const int b = (kHuffmanCodes[sym].code >> bit) & 1;
+                if(nodes[cur].child[b] < 0)
+                {
+                    nodes[cur].child[b] = static_cast<int>(nodes.size());
+                    nodes.emplace_back();
+                }
+                cur = nodes[cur].child[b];
+            }
+            nodes[cur].symbol = sym;
+        }
+
+        // 内部节点编号为状态
+        std::vector<int> state_of(nodes.size(), -1);
+        std::vector<int> node_of;
+        for(size_t i = 0; i < nodes.size(); ++i)
+        {
+            if(nodes[i].symbol < 0)
+            {
+                state_of[i] = static_cast<int>(node_of.size());
+                node_of.push_back(static_cast<int>(i));
+            }
+        }
+
+        for(int cur = 0, depth = 0; depth < 8 && cur >= 0 && nodes[cur].symbol < 0; ++depth)
+        {
+            accept[state_of[cur]] = true;
+            cur = nodes[cur].child[1];
+        }
+
+        for(size_t s = 0; s < node_of.size(); ++s)
+        {
+            for(int nibble = 0; nibble < 16; ++nibble)
+            {
+                Transition &t = transitions[s][nibble];
+                int cur = node_of[s];
+                for(int bit = 3; bit >= 0; --bit)
+                {
+                    cur = nodes[cur].child[(nibble >> bit) & 1];
+                    if(nodes[cur].symbol >= 0)
+                    {
+                        if(kHuffmanEos == nodes[cur].symbol)
+                        {
+                            t.flags |= kFail;
+                            break;
+                        }
+                        t.flags |= kEmit;
+                        t.symbol = static_cast<uint8_t>(nodes[cur].symbol);
+                        cur = 0;
+                    }
+                }
+                t.next = static_cast<uint8_t>(t.flags & kFail ? 0 : state_of[cur]);
+            }
+        }
+    }
+};
+
+const HuffmanDecodeTable& DecodeTable()
+{
+    static const HuffmanDecodeTable s_table;
+    return s_table;
+}
+
+struct StaticEntry
+{
+    const char *name;
+    const char *value;
+};
+
+constexpr StaticEntry kStaticTable[kHpackStaticTableSize] = {
+    {":authority", ""}, {":method", "GET"}, {":method", "POST"}, {":path", "/"},
+    {":path", "/index.html"}, {":scheme", "http"}, {":scheme", "https"}, {":status", "200"},
+    {":status", "204"}, {":status", "206"}, {":status", "304"}, {":status", "400"},
+    {":status", "404"}, {":status", "500"}, {"accept-charset", ""}, {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""}, {"accept-ranges", ""}, {"accept", ""}, {"access-control-allow-origin", ""},
+    {"age", ""}, {"allow", ""}, {"authorization", ""}, {"cache-control", ""},
+    {"content-disposition", ""}, {"content-encoding", ""}, {"content-language", ""}, {"content-length", ""},
+    {"content-location", ""}, {"content-range", ""}, {"content-type", ""}, {"cookie", ""},
+    {"date", ""}, {"etag", ""}, {"expect", ""}, {"expires", ""},
+    {"from", ""}, {"host", ""}, {"if-match", ""}, {"if-modified-since", ""},
+    {"if-none-match", ""}, {"if-range", ""}, {"if-unmodified-since", ""}, {"last-modified", ""},
+    {"link", ""}, {"location", ""}, {"max-forwards", ""}, {"proxy-authenticate", ""},
+    {"proxy-authorization", ""}, {"range", ""}, {"referer", ""}, {"refresh", ""},
+    {"retry-after", ""}, {"server", ""}, {"set-cookie", ""}, {"strict-transport-security", ""},
+    {"transfer-encoding", ""}, {"user-agent", ""}, {"vary", ""}, {"via", ""},
+    {"www-authenticate", ""},
+};
+
+/**
+ * @brief 静态表查找索引: 名称 -> 最小索引，名称+值 -> 索引
+ */
+struct StaticIndex
+{
+    std::vector<HpackHeader> entries;
+    std::unordered_map<std::string, size_t> byName;
+    std::unordered_map<std::string, size_t> byPair;
+
+    StaticIndex()
+    {
+        entries.reserve(kHpackStaticTableSize);
+        for(size_t i = 0; i < kHpackStaticTableSize; ++i)
+        {
+            entries.push_back(HpackHeader{kStaticTable[i].name, kStaticTable[i].value});
+            byName.emplace(kStaticTable[i].name, i + 1);
+            if(kStaticTable[i].value[0])
+            {
+                byPair.emplace(PairKey(kStaticTable[i].name, kStaticTable[i].value), i + 1);
+            }
+        }
+    }
+
+    static std::string PairKey(std::string_view name, std::string_view value)
+    {
+        std::string key(name);
+        key.push_back('\0');
+        key.append(value);
+        return key;
+    }
+};
+
+const StaticIndex& Statics()
+{
+    static const StaticIndex s_index;
+    return s_index;
+}
+
+/// @brief 取值每次都不同、插入动态表只会冲掉有用条目的头部
+bool NeverWorthIndexing(std::string_view name)
+{
+    static const char *const kNames[] = {":path", "content-length", "etag", "last-modified", "if-modified-since",
+                                          "if-none-match", "location", "age", "content-range", "range"};
+    for(const char *n : kNames)
+    {
+        if(name == n)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief 默认按 never-indexed 编码的凭据类头部(RFC 7541 7.1.3)
+bool Sensitive(std::string_view name, std::string_view value)
+{
+    return name == "authorization" || name == "proxy-authorization"
+        || (name == "cookie" && value.size() < 20);
+}
+
+}
+
+/****************** Huffman ******************/
+size_t HuffmanEncodedLength(std::string_view in)
+{
+    uint64_t bits = 0;
+    for(unsigned char c : in)
+    {
+        bits += kHuffmanCodes[c].bits;
+    }
+    return static_cast<size_t>((bits + 7) / 8);
+}
+
+void HuffmanEncode(std::string_view in, std::string *out)
+{
+    uint64_t acc = 0;
+    int acc_bits = 0;
+    for(unsigned char c : in)
+    {
+        const HuffmanCode &code = kHuffmanCodes[c];
+        acc = (acc << code.bits) | code.code;
+        acc_bits += code.bits;
+        while(acc_bits >= 8)
+        {
+            acc_bits -= 8;
+            out->push_back(static_cast<char>(acc >> acc_bits));
+        }
+    }
+    if(acc_bits > 0)
+    {
+        // 以 EOS 的高位(全1)补齐
+        acc = (acc << (8 - acc_bits)) | (0xFFu >> acc_bits);
+        out->push_back(static_cast<char>(acc));
+    }
+}
+
+bool HuffmanDecode(std::string_view in, std::string *out)
+{
+    const HuffmanDecodeTable &table = DecodeTable();
+    uint8_t state = 0;
+    for(unsigned char c : in)
+    {
+        for(int shift = 4; shift >= 0; shift -= 4)
+        {
+            const auto &t = table.transitions[state][(c >> shift) & 0xF];
+            if(t.flags & HuffmanDecodeTable::kFail)
+            {
+                return false;
+            }
+            if(t.flags & HuffmanDecodeTable::kEmit)
+            {
+                out->push_back(static_cast<char>(t.symbol));
+            }
+            state = t.next;
+        }
+    }
+    return table.accept[state];
+}
+
+/****************** 整数 ******************/
+void HpackEncodeInteger(uint64_t value, int prefixBits, uint8_t firstByteFlags, std::string *out)
+{
+    const uint64_t max_prefix = (1u << prefixBits) - 1;
+    if(value < max_prefix)
+    {
+        out->push_back(static_cast<char>(firstByteFlags | value));
+        return;
+    }
+    out->push_back(static_cast<char>(firstByteFlags | max_prefix));
+    value -= max_prefix;
+    while(value >= 128)
+    {
+        out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out->push_back(static_cast<char>(value));
+}
+
+bool HpackDecodeInteger(const uint8_t *data, size_t len, size_t *pos, int prefixBits, uint64_t *value)
+{
+    size_t p = *pos;
+    if(p >= len)
+    {
+        return false;
+    }
+    const uint64_t max_prefix = (1u << prefixBits) - 1;
+    uint64_t v = data[p++] & max_prefix;
+    if(v == max_prefix)
+    {
+        int shift = 0;
+        while(true)
+        {
+            // 超过 2^35 左右的值对本实现都没有意义，防止溢出
+            if(p >= len || shift > 28)
+            {
+                return false;
+            }
+            const uint8_t b = data[p++];
+            v += static_cast<uint64_t>(b & 0x7F) << shift;
+            shift += 7;
+            if(0 == (b & 0x80))
+            {
+                break;
+            }
+        }
+    }
+    *value = v;
+    *pos = p;
+    return true;
+}
+
+const HpackHeader* HpackStaticEntry(size_t index)
+{
+    if(0 == index || index > kHpackStaticTableSize)
+    {
+        return nullptr;
+    }
+    return &Statics().entries[index - 1];
+}
+
+/****************** 动态表 ******************/
+void HpackDynamicTable::evict(size_t limit)
+{
+    while(_size > limit && !_entries.empty())
+    {
+        const HpackHeader &back = _entries.back();
+        _size -= EntrySize(back.name.size(), back.value.size());
+        _entries.pop_back();
+    }
+}
+
+void HpackDynamicTable::add(std::string name, std::string value)
+{
+    const size_t entry_size = EntrySize(name.size(), value.size());
+    if(entry_size > _maxSize)
+    {
+        evict(0);
+        return;
+    }
+    evict(_maxSize - entry_size);
+    _size += entry_size;
+    _entries.push_front(HpackHeader{std::move(name), std::move(value)});
+}
+
+const HpackHeader* HpackDynamicTable::get(size_t index) const
+{
+    return index >= 1 && index <= _entries.size() ? &_entries[index - 1] : nullptr;
+}
+
+void HpackDynamicTable::setMaxSize(size_t maxSize)
+{
+    _maxSize = maxSize;
+    evict(_maxSize);
+}
+
+size_t HpackDynamicTable::find(std::string_view name, std::string_view value, size_t *nameOnly) const
+{
+    for(size_t i = 0; i < _entries.size(); ++i)
+    {
+        if(_entries[i].name != name)
+        {
+            continue;
+        }
+        if(_entries[i].value == value)
+        {
+            return i + 1;
+        }
+        if(0 == *nameOnly)
+        {
+            *nameOnly = i + 1;
+        }
+    }
+    return 0;
+}
+
+/****************** 解码器 ******************/
+HpackDecoder::HpackDecoder(size_t maxTableSize, size_t maxHeaderListSize)
+    :_maxTableSize(maxTableSize)
+    ,_maxHeaderListSize(maxHeaderListSize)
+    ,_table(maxTableSize)
+{
+}
+
+const HpackHeader* HpackDecoder::lookup(size_t index) const
+{
+    return index <= kHpackStaticTableSize ? HpackStaticEntry(index) : _table.get(index - kHpackStaticTableSize);
+}
+
+namespace {
+
+bool DecodeString(const uint8_t *data, size_t len, size_t *pos, std::string *out)
+{
+    if(*pos >= len)
+    {
+        return false;
+    }
+    const bool huffman = data[*pos] & 0x80;
+    uint64_t str_len = 0;
+    if(!HpackDecodeInteger(data, len, pos, 7, &str_len) || str_len > len - *pos)
+    {
+        return false;
+    }
+    const char *str = reinterpret_cast<const char*>(data + *pos);
+    *pos += str_len;
+    out->clear();
+    if(huffman)
+    {
+        return HuffmanDecode(std::string_view(str, str_len), out);
+    }
+    out->assign(str, str_len);
+    return true;
+}
+
+}
+
+HpackDecoder::Result HpackDecoder::decode(const uint8_t *data, size_t len, HpackHeaderList *headers)
+{
+    size_t pos = 0;
+    size_t list_size = 0;
+    bool too_large = false;
+    bool field_seen = false;
+    while(pos < len)
+    {
+        const uint8_t b = data[pos];
+        uint64_t index = 0;
+        HpackHeader header;
+        bool add_to_table = false;
+
+        if(b & 0x80)
+        {
+            // 索引
+            if(!HpackDecodeInteger(data, len, &pos, 7, &index) || 0 == index)
+            {
+                return Result::kError;
+            }
+            const HpackHeader *entry = lookup(index);
+            if(!entry)
+            {
+                return Result::kError;
+            }
+            header.name = entry->name;
+            header.value = entry->value;
+        }
+        else if(0x20 == (b & 0xE0))
+        {
+            // 表大小更新只能出现在头部块开头
+            uint64_t size = 0;
+            if(field_seen || !HpackDecodeInteger(data, len, &pos, 5, &size) || size > _maxTableSize)
+            {
+                return Result::kError;
+            }
+            _table.setMaxSize(size);
+            continue;
+        }
+        else
+        {
+            // 字面量: 01 增量索引(6位前缀)，0000 不索引、0001 永不索引(4位前缀)
+            add_to_table = 0x40 == (b & 0xC0);
+            header.sensitive = 0x10 == (b & 0xF0);
+            if(!HpackDecodeInteger(data, len, &pos, add_to_table ? 6 : 4, &index))
+            {
+                return Result::kError;
+            }
+            if(index)
+            {
+                const HpackHeader *entry = lookup(index);
+                if(!entry)
+                {
+                    return Result::kError;
+                }
+                header.name = entry->name;
+            }
+            else if(!DecodeString(data, len, &pos, &header.name))
+            {
+                return Result::kError;
+            }
+            if(!DecodeString(data, len, &pos, &header.value))
+            {
+                return Result::kError;
+            }
+            if(add_to_table)
+            {
+                _table.add(header.name, header.value);
+            }
+        }
+
+        field_seen = true;
+        list_size += HpackDynamicTable::EntrySize(header.name.size(), header.value.size());
+        if(list_size > _maxHeaderListSize)
+        {
+            // 继续解码以保持动态表同步，头部丢弃
+            too_large = true;
+        }
+        if(!too_large)
+        {
+            headers->push_back(std::move(header));
+        }
+    }
+    return too_large ? Result::kTooLarge : Result::kOk;
+}
+
+/****************** 编码器 ******************/
+HpackEncoder::HpackEncoder(size_t maxTableSize)
+    :_table(maxTableSize)
+{
+}
+
+void HpackEncoder::setMaxTableSize(size_t maxSize)
+{
+    if(!_sizeUpdatePending)
+    {
+        _sizeUpdatePending = true;
+        _minPendingSize = maxSize;
+    }
+    _minPendingSize = std::min(_minPendingSize, maxSize);
+    _table.setMaxSize(maxSize);
+}
+
+void HpackEncoder::flushTableSizeUpdate(std::string *out)
+{
+    if(!_sizeUpdatePending)
+    {
+        return;
+    }
+    _sizeUpdatePending = false;
+    if(_minPendingSize < _table.maxSize())
+    {
+        HpackEncodeInteger(_minPendingSize, 5, 0x20, out);
+    }
+    HpackEncodeInteger(_table.maxSize(), 5, 0x20, out);
+}
+
+void HpackEncoder::appendString(std::string_view str, std::string *out) const
+{
+    if(_huffman)
+    {
+        const size_t huff_len = HuffmanEncodedLength(str);
+        if(huff_len < str.size())
+        {
+            HpackEncodeInteger(huff_len, 7, 0x80, out);
+            HuffmanEncode(str, out);
+            return;
+        }
+    }
+    HpackEncodeInteger(str.size(), 7, 0, out);
+    out->append(str);
+}
+
+void HpackEncoder::encode(std::string_view name, std::string_view value, bool sensitive, std::string *out)
+{
+    flushTableSizeUpdate(out);
+    const StaticIndex &statics = Statics();
+    sensitive = sensitive || Sensitive(name, value);
+
+    size_t name_index = 0;
+    if(!sensitive)
+    {
+        auto it = statics.byPair.find(StaticIndex::PairKey(name, value));
+        if(it != statics.byPair.end())
+        {
+            HpackEncodeInteger(it->second, 7, 0x80, out);
+            return;
+        }
+        size_t dynamic_name = 0;
+        if(const size_t index = _table.find(name, value, &dynamic_name))
+        {
+            HpackEncodeInteger(index + kHpackStaticTableSize, 7, 0x80, out);
+            return;
+        }
+        if(dynamic_name)
+        {
+            name_index = dynamic_name + kHpackStaticTableSize;
+        }
+    }
+    auto name_it = statics.byName.find(std::string(name));
+    if(name_it != statics.byName.end())
+    {
+        name_index = name_it->second;
+    }
+
+    if(sensitive)
+    {
+        HpackEncodeInteger(name_index, 4, 0x10, out);
+    }
+    else if(NeverWorthIndexing(name)
+            || HpackDynamicTable::EntrySize(name.size(), value.size()) > _table.maxSize() / 2)
+    {
+        HpackEncodeInteger(name_index, 4, 0x00, out);
+    }
+    else
+    {
+        HpackEncodeInteger(name_index, 6, 0x40, out);
+        _table.add(std::string(name), std::string(value));
+    }
+    if(0 == name_index)
+    {
+        appendString(name, out);
+    }
+    appendString(value, out);
+}
+
+void HpackEncoder::encode(const HpackHeaderList &headers, std::string *out)
+{
+    flushTableSizeUpdate(out);
+    for(const auto &header : headers)
+    {
+        encode(header.name, header.value, header.sensitive, out);
+    }
+}
+
+}   // kit_muduo::http
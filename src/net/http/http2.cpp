@@ -0,0 +1,1274 @@
+/**
+ * @file http2.cpp
+ * @brief HTTP/2 明文(h2c): 帧编解码、流多路复用与流量控制
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 01:48:36
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http2.h"
+#include "net/http/http_context.h"
+#include "net/http/http_headers.h"
+#include "net/http/http_parser.h"
+#include "net/http/http_request.h"
+#include "net/http/http_response.h"
+#include "net/http/http_servlet.h"
+#include "net/http/http_util.h"
+#include "net/buffer.h"
+#include "net/event_loop.h"
+#include "net/net_log.h"
+#include "net/tcp_connection.h"
+#include "base/metrics.h"
+#include "base/trace.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace kit_muduo::http {
+
+namespace {
+
+struct Http2Metrics
+{
+    metrics::Gauge &sessions;
+    metrics::Gauge &streams;
+    metrics::Counter &streamsTotal;
+    metrics::Counter &refused;
+};
+
+Http2Metrics& Metrics()
+{
+    static Http2Metrics s_metrics{
+        metrics::MetricsRegistry::Instance().gauge("kit_http2_sessions", "Open HTTP/2 connections"),
+        metrics::MetricsRegistry::Instance().gauge("kit_http2_active_streams", "Open HTTP/2 streams"),
+        metrics::MetricsRegistry::Instance().counter("kit_http2_streams_total", "HTTP/2 streams accepted"),
+        metrics::MetricsRegistry::Instance().counter("kit_http2_refused_streams_total", "HTTP/2 streams refused over the concurrency limit"),
+    };
+    return s_metrics;
+}
+
+uint32_t ReadU32(const char *p)
+{
+    const uint8_t *b = reinterpret_cast<const uint8_t*>(p);
+    return (static_cast<uint32_t>(b[0]) << 24) | (static_cast<uint32_t>(b[1]) << 16)
+         | (static_cast<uint32_t>(b[2]) << 8) | b[3];
+}
+
+uint16_t ReadU16(const char *p)
+{
+    const uint8_t *b = reinterpret_cast<const uint8_t*>(p);
+    return static_cast<uint16_t>((b[0] << 8) | b[1]);
+}
+
+void AppendU32(std::string *out, uint32_t v)
+{
+    out->push_back(static_cast<char>(v >> 24));
+    out->push_back(static_cast<char>(v >> 16));
+    out->push_back(static_cast<char>(v >> 8));
+    out->push_back(static_cast<char>(v));
+}
+
+void AppendFrameHeader(std::string *out, uint32_t length, Http2FrameType type, uint8_t flags, uint32_t streamId)
+{
+    out->push_back(static_cast<char>(length >> 16));
+    out->push_back(static_cast<char>(length >> 8));
+    out->push_back(static_cast<char>(length));
+    out->push_back(static_cast<char>(type));
+    out->push_back(static_cast<char>(flags));
+    AppendU32(out, streamId & 0x7fffffff);
+}
+
+/// @brief 去掉 PADDED 填充，填充长度不小于帧负载时返回 false
+bool StripPadding(const Http2FrameHeader &header, const char *&payload, size_t &len)
+{
+    len = header.length;
+    if(0 == (header.flags & Http2Flags::kPadded))
+    {
+        return true;
+    }
+    if(len < 1)
+    {
+        return false;
+    }
+    const size_t pad = static_cast<uint8_t>(payload[0]);
+    ++payload;
+    --len;
+    if(pad > len)
+    {
+        return false;
+    }
+    len -= pad;
+    return true;
+}
+
+/// @brief HTTP/2 中禁止出现的连接级头部(RFC 9113 8.2.2)
+bool ConnectionSpecific(std::string_view name)
+{
+    return HeaderNameEquals(name, "connection") || HeaderNameEquals(name, "keep-alive")
+        || HeaderNameEquals(name, "proxy-connection") || HeaderNameEquals(name, "transfer-encoding")
+        || HeaderNameEquals(name, "upgrade");
+}
+
+/**
+ * @brief 解析 HTTP/1 形式的头部块(状态行 + "名称: 值" 行)，名称转小写并去掉连接级头部
+ * @return 状态行中的状态码，无法解析返回0
+ */
+int32_t ParseHeaderBlock(std::string_view block, HpackHeaderList *headers)
+{
+    int32_t status = 0;
+    bool first = true;
+    while(!block.empty())
+    {
+        size_t eol = block.find("\r\n");
+        std::string_view line = block.substr(0, eol);
+        block = std::string_view::npos == eol ? std::string_view() : block.substr(eol + 2);
+        if(first)
+        {
+            first = false;
+            const size_t sp = line.find(' ');
+            if(std::string_view::npos != sp)
+            {
+                status = std::atoi(std::string(line.substr(sp + 1, 3)).c_str());
+            }
+            continue;
+        }
+        const size_t colon = line.find(':');
+        if(line.empty() || std::string_view::npos == colon)
+        {
+            continue;
+        }
+        const std::string_view name = line.substr(0, colon);
+        if(ConnectionSpecific(name))
+        {
+            continue;
+        }
+        HpackHeader header;
+        header.name.resize(name.size());
+        std::transform(name.begin(), name.end(), header.name.begin(), [](char c) {
+            return ('A' <= c && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+        });
+        header.value = std::string(TrimHttpSpace(line.substr(colon + 1)));
+        headers->push_back(std::move(header));
+    }
+    return status;
+}
+
+}
+
+const char* Http2ErrorCodeName(Http2ErrorCode code)
+{
+    switch(code)
+    {
+        case Http2ErrorCode::kNoError: return "NO_ERROR";
+        case Http2ErrorCode::kProtocolError: return "PROTOCOL_ERROR";
+        case Http2ErrorCode::kInternalError: return "INTERNAL_ERROR";
+        case Http2ErrorCode::kFlowControlError: return "FLOW_CONTROL_ERROR";
+        case Http2ErrorCode::kSettingsTimeout: return "SETTINGS_TIMEOUT";
+        case Http2ErrorCode::kStreamClosed: return "STREAM_CLOSED";
+        case Http2ErrorCode::kFrameSizeError: return "FRAME_SIZE_ERROR";
+        case Http2ErrorCode::kRefusedStream: return "REFUSED_STREAM";
+        case Http2ErrorCode::kCancel: return "CANCEL";
+        case Http2ErrorCode::kCompressionError: return "COMPRESSION_ERROR";
+        case Http2ErrorCode::kConnectError: return "CONNECT_ERROR";
+        case Http2ErrorCode::kEnhanceYourCalm: return "ENHANCE_YOUR_CALM";
+        case Http2ErrorCode::kInadequateSecurity: return "INADEQUATE_SECURITY";
+        case Http2ErrorCode::kHttp11Required: return "HTTP_1_1_REQUIRED";
+    }
+    return "UNKNOWN";
+}
+
+/****************** 帧编解码 ******************/
+Http2FrameHeader ParseHttp2FrameHeader(const char *data)
+{
+    const uint8_t *b = reinterpret_cast<const uint8_t*>(data);
+    Http2FrameHeader header;
+    header.length = (static_cast<uint32_t>(b[0]) << 16) | (static_cast<uint32_t>(b[1]) << 8) | b[2];
+    header.type = static_cast<Http2FrameType>(b[3]);
+    header.flags = b[4];
+    header.streamId = ReadU32(data + 5) & 0x7fffffff;
+    return header;
+}
+
+void AppendHttp2Frame(std::string *out, Http2FrameType type, uint8_t flags, uint32_t streamId, std::string_view payload)
+{
+    AppendFrameHeader(out, static_cast<uint32_t>(payload.size()), type, flags, streamId);
+    out->append(payload);
+}
+
+void AppendHttp2Settings(std::string *out, const std::vector<std::pair<Http2Setting, uint32_t>> &settings)
+{
+    AppendFrameHeader(out, static_cast<uint32_t>(settings.size() * 6), Http2FrameType::kSettings, 0, 0);
+    for(auto &setting : settings)
+    {
+        const uint16_t id = static_cast<uint16_t>(setting.first);
+        out->push_back(static_cast<char>(id >> 8));
+        out->push_back(static_cast<char>(id));
+        AppendU32(out, setting.second);
+    }
+}
+
+void AppendHttp2SettingsAck(std::string *out)
+{
+    AppendFrameHeader(out, 0, Http2FrameType::kSettings, Http2Flags::kAck, 0);
+}
+
+void AppendHttp2WindowUpdate(std::string *out, uint32_t streamId, uint32_t increment)
+{
+    AppendFrameHeader(out, 4, Http2FrameType::kWindowUpdate, 0, streamId);
+    AppendU32(out, increment & 0x7fffffff);
+}
+
+void AppendHttp2RstStream(std::string *out, uint32_t streamId, Http2ErrorCode code)
+{
+    AppendFrameHeader(out, 4, Http2FrameType::kRstStream, 0, streamId);
+    AppendU32(out, static_cast<uint32_t>(code));
+}
+
+void AppendHttp2GoAway(std::string *out, uint32_t lastStreamId, Http2ErrorCode code, std::string_view debug)
+{
+    AppendFrameHeader(out, static_cast<uint32_t>(8 + debug.size()), Http2FrameType::kGoAway, 0, 0);
+    AppendU32(out, lastStreamId & 0x7fffffff);
+    AppendU32(out, static_cast<uint32_t>(code));
+    out->append(debug);
+}
+
+void AppendHttp2Headers(std::string *out, uint32_t streamId, std::string_view block, bool endStream, uint32_t maxFrameSize)
+{
+    std::string_view fragment = block.substr(0, maxFrameSize);
+    block.remove_prefix(fragment.size());
+    uint8_t flags = endStream ? Http2Flags::kEndStream : 0;
+    if(block.empty())
+    {
+        flags |= Http2Flags::kEndHeaders;
+    }
+    AppendHttp2Frame(out, Http2FrameType::kHeaders, flags, streamId, fragment);
+    while(!block.empty())
+    {
+        fragment = block.substr(0, maxFrameSize);
+        block.remove_prefix(fragment.size());
+        AppendHttp2Frame(out, Http2FrameType::kContinuation, block.empty() ? Http2Flags::kEndHeaders : 0, streamId, fragment);
+    }
+}
+
+/****************** 会话 ******************/
+Http2Session::Http2Session(const TcpConnectionPtr &conn, Config config, ContextFactory factory, RequestCallback cb)
+    :_loop(conn->getLoop())
+    ,_conn(conn)
+    ,_config(std::move(config))
+    ,_factory(std::move(factory))
+    ,_callback(std::move(cb))
+    ,_decoder(_config.headerTableSize, _config.maxHeaderListSize)
+    ,_encoder(4096)
+    // 对端确认前可能仍按默认窗口发送，取两者的较大值
+    ,_streamRecvInitial(std::max(_config.initialWindowSize, kHttp2DefaultWindowSize))
+{
+    Metrics().sessions.inc();
+}
+
+Http2Session::~Http2Session()
+{
+    Metrics().sessions.dec();
+    Metrics().streams.dec(static_cast<int64_t>(_streams.size()));
+}
+
+void Http2Session::sendPreface()
+{
+    std::vector<std::pair<Http2Setting, uint32_t>> settings{
+        {Http2Setting::kMaxConcurrentStreams, _config.maxConcurrentStreams},
+        {Http2Setting::kInitialWindowSize, _config.initialWindowSize},
+        {Http2Setting::kMaxFrameSize, _config.maxFrameSize},
+        {Http2Setting::kMaxHeaderListSize, _config.maxHeaderListSize},
+    };
+    if(4096 != _config.headerTableSize)
+    {
+        settings.emplace_back(Http2Setting::kHeaderTableSize, _config.headerTableSize);
+    }
+    AppendHttp2Settings(&_out, settings);
+
+    // 连接级窗口不受 SETTINGS 控制，只能以 WINDOW_UPDATE 放大
+    if(_config.connectionWindowSize > kHttp2DefaultWindowSize)
+    {
+        AppendHttp2WindowUpdate(&_out, 0, _config.connectionWindowSize - kHttp2DefaultWindowSize);
+        _recvWindow = _config.connectionWindowSize;
+    }
+}
+
+void Http2Session::start()
+{
+    sendPreface();
+    flushOutput();
+}
+
+bool Http2Session::startUpgrade(std::string_view settingsPayload, const HttpContextPtr &ctx)
+{
+    sendPreface();
+    // HTTP2-Settings 等同于收到一个 SETTINGS 帧，101 即为确认
+    if(!applySettings(settingsPayload.data(), settingsPayload.size()))
+    {
+        return false;
+    }
+
+    _lastStreamId = 1;
+    Stream &stream = _streams[1];
+    stream.ctx = ctx;
+    stream.remoteClosed = true;
+    stream.sendWindow = _peerInitialWindow;
+    ctx->request()->setVersion(Version::kHttp20);
+    ctx->setHttp2Stream(weak_from_this(), 1);
+    _streamsTotal.fetch_add(1, std::memory_order_relaxed);
+    Metrics().streams.inc();
+    Metrics().streamsTotal.inc();
+    flushOutput();
+
+    if(TcpConnectionPtr conn = _conn.lock())
+    {
+        _callback(conn, ctx);
+    }
+    return true;
+}
+
+void Http2Session::onData(Buffer &buf)
+{
+    if(_closed)
+    {
+        buf.resetAll();
+        return;
+    }
+
+    if(!_prefaceReceived)
+    {
+        const size_t n = std::min(buf.readableBytes(), kHttp2ClientPreface.size());
+        if(0 != std::memcmp(buf.peek(), kHttp2ClientPreface.data(), n))
+        {
+            connectionError(Http2ErrorCode::kProtocolError, "invalid connection preface");
+            buf.resetAll();
+            return;
+        }
+        if(n < kHttp2ClientPreface.size())
+        {
+            return;
+        }
+        buf.reset(kHttp2ClientPreface.size());
+        _prefaceReceived = true;
+    }
+
+    while(!_closed && buf.readableBytes() >= kHttp2FrameHeaderSize)
+    {
+        const Http2FrameHeader header = ParseHttp2FrameHeader(buf.peek());
+        if(header.length > _config.maxFrameSize)
+        {
+            connectionError(Http2ErrorCode::kFrameSizeError, "frame exceeds SETTINGS_MAX_FRAME_SIZE");
+            break;
+        }
+        if(buf.readableBytes() < kHttp2FrameHeaderSize + header.length)
+        {
+            break;
+        }
+        // 前言之后的第一个帧必须是 SETTINGS
+        if(!_settingsReceived && (Http2FrameType::kSettings != header.type || (header.flags & Http2Flags::kAck)))
+        {
+            connectionError(Http2ErrorCode::kProtocolError, "first frame is not SETTINGS");
+            break;
+        }
+        const bool ok = handleFrame(header, buf.peek() + kHttp2FrameHeaderSize);
+        buf.reset(kHttp2FrameHeaderSize + header.length);
+        if(!ok)
+        {
+            break;
+        }
+    }
+
+    if(_closed)
+    {
+        buf.resetAll();
+    }
+    flushOutput();
+}
+
+bool Http2Session::handleFrame(const Http2FrameHeader &header, const char *payload)
+{
+    // 头部块未结束时只能收到同一个流的 CONTINUATION
+    if(0 != _headerStreamId && Http2FrameType::kContinuation != header.type)
+    {
+        return connectionError(Http2ErrorCode::kProtocolError, "expected CONTINUATION");
+    }
+
+    switch(header.type)
+    {
+        case Http2FrameType::kData:
+            return onDataFrame(header, payload);
+        case Http2FrameType::kHeaders:
+            return onHeadersFrame(header, payload);
+        case Http2FrameType::kContinuation:
+            return onContinuationFrame(header, payload);
+        case Http2FrameType::kSettings:
+            return onSettingsFrame(header, payload);
+        case Http2FrameType::kWindowUpdate:
+            return onWindowUpdateFrame(header, payload);
+        case Http2FrameType::kPriority:
+            if(0 == header.streamId)
+            {
+                return connectionError(Http2ErrorCode::kProtocolError, "PRIORITY on stream 0");
+            }
+            if(5 != header.length)
+            {
+                resetStream(header.streamId, Http2ErrorCode::kFrameSizeError);
+            }
+            else if((ReadU32(payload) & 0x7fffffff) == header.streamId)
+            {
+                resetStream(header.streamId, Http2ErrorCode::kProtocolError);
+            }
+            return true;
+        case Http2FrameType::kRstStream:
+            if(4 != header.length)
+            {
+                return connectionError(Http2ErrorCode::kFrameSizeError, "bad RST_STREAM length");
+            }
+            if(0 == header.streamId || header.streamId > _lastStreamId)
+            {
+                return connectionError(Http2ErrorCode::kProtocolError, "RST_STREAM on idle stream");
+            }
+            HTTP_F_DEBUG("http2 stream[%u] reset by peer: %s\n", header.streamId, Http2ErrorCodeName(static_cast<Http2ErrorCode>(ReadU32(payload))));
+            // 已被重置的流不再回复，迟到的响应在 sendReply 中丢弃
+            if(_streams.erase(header.streamId))
+            {
+                Metrics().streams.dec();
+            }
+            return true;
+        case Http2FrameType::kPushPromise:
+            return connectionError(Http2ErrorCode::kProtocolError, "PUSH_PROMISE from client");
+        case Http2FrameType::kPing:
+            if(0 != header.streamId)
+            {
+                return connectionError(Http2ErrorCode::kProtocolError, "PING on stream");
+            }
+            if(8 != header.length)
+            {
+                return connectionError(Http2ErrorCode::kFrameSizeError, "bad PING length");
+            }
+            if(0 == (header.flags & Http2Flags::kAck))
+            {
+                AppendHttp2Frame(&_out, Http2FrameType::kPing, Http2Flags::kAck, 0, std::string_view(payload, 8));
+            }
+            return true;
+        case Http2FrameType::kGoAway:
+            if(0 != header.streamId)
+            {
+                return connectionError(Http2ErrorCode::kProtocolError, "GOAWAY on stream");
+            }
+            if(header.length < 8)
+            {
+                return connectionError(Http2ErrorCode::kFrameSizeError, "bad GOAWAY length");
+            }
+            _goAwayReceived = true;
+            HTTP_F_DEBUG("http2 GOAWAY from peer: %s, active streams[%lu]\n", Http2ErrorCodeName(static_cast<Http2ErrorCode>(ReadU32(payload + 4))), _streams.size());
+            if(_streams.empty())
+            {
+                flushOutput();
+                if(TcpConnectionPtr conn = _conn.lock())
+                {
+                    conn->shutdown();
+                }
+            }
+            return true;
+        default:
+            // 未知类型的帧必须忽略
+            return true;
+    }
+}
+
+bool Http2Session::onDataFrame(const Http2FrameHeader &header, const char *payload)
+{
+    const uint32_t id = header.streamId;
+    if(0 == id)
+    {
+        return connectionError(Http2ErrorCode::kProtocolError, "DATA on stream 0");
+    }
+
+    // 整帧(含填充)计入流量控制
+    if(header.length > _recvWindow)
+    {
+        return connectionError(Http2ErrorCode::kFlowControlError, "connection receive window exceeded");
+    }
+    _recvWindow -= header.length;
+    _recvConsumed += header.length;
+    const uint32_t connection_window = std::max(_config.connectionWindowSize, kHttp2DefaultWindowSize);
+    if(_recvConsumed >= connection_window / 2)
+    {
+        AppendHttp2WindowUpdate(&_out, 0, _recvConsumed);
+        _recvWindow += _recvConsumed;
+        _recvConsumed = 0;
+    }
+
+    const char *data = payload;
+    size_t len = 0;
+    if(!StripPadding(header, data, len))
+    {
+        return connectionError(Http2ErrorCode::kProtocolError, "invalid DATA padding");
+    }
+
+    auto it = _streams.find(id);
+    if(it == _streams.end())
+    {
+        if(id > _lastStreamId)
+        {
+            return connectionError(Http2ErrorCode::kProtocolError, "DATA on idle stream");
+        }
+        resetStream(id, Http2ErrorCode::kStreamClosed);
+        return true;
+    }
+
+    Stream &stream = it->second;
+    if(stream.remoteClosed)
+    {
+        resetStream(id, Http2ErrorCode::kStreamClosed);
+        return true;
+    }
+    if(header.length > stream.recvWindow)
+    {
+        resetStream(id, Http2ErrorCode::kFlowControlError);
+        return true;
+    }
+    stream.recvWindow -= header.length;
+    stream.receivedBytes += len;
+    if(stream.contentLength >= 0 && stream.receivedBytes > static_cast<uint64_t>(stream.contentLength))
+    {
+        resetStream(id, Http2ErrorCode::kProtocolError);
+        return true;
+    }
+
+    if(len > 0)
+    {
+        if(stream.receivedBytes == len)
+        {
+            auto req = stream.ctx->request();
+            const std::string content_type(req->header(HttpHeaderId::kContentType));
+            req->body().setContentType(content_type.empty() ? ContentType(ContentType::kOctetStream) : ContentType::FromString(content_type));
+        }
+        if(!stream.ctx->onBodyData(data, len))
+        {
+            resetStream(id, Http2ErrorCode::kCancel);
+            return true;
+        }
+    }
+
+    if(header.flags & Http2Flags::kEndStream)
+    {
+        stream.remoteClosed = true;
+        finishRequest(id);
+        return true;
+    }
+
+    // 数据已交给请求或接收器，消费量过半窗口时回补
+    stream.recvConsumed += header.length;
+    if(stream.recvConsumed > 0 && stream.recvConsumed >= _streamRecvInitial / 2)
+    {
+        AppendHttp2WindowUpdate(&_out, id, stream.recvConsumed);
+        stream.recvWindow += stream.recvConsumed;
+        stream.recvConsumed = 0;
+    }
+    return true;
+}
+
+bool Http2Session::onHeadersFrame(const Http2FrameHeader &header, const char *payload)
+{
+    const uint32_t id = header.streamId;
+    // 客户端发起的流id为奇数
+    if(0 == id || 0 == (id & 1))
+    {
+        return connectionError(Http2ErrorCode::kProtocolError, "invalid stream id for HEADERS");
+    }
+
+    const char *block = payload;
+    size_t len = 0;
+    if(!StripPadding(header, block, len))
+    {
+        return connectionError(Http2ErrorCode::kProtocolError, "invalid HEADERS padding");
+    }
+
+    Http2ErrorCode error = Http2ErrorCode::kNoError;
+    if(header.flags & Http2Flags::kPriority)
+    {
+        if(len < 5)
+        {
+            return connectionError(Http2ErrorCode::kFrameSizeError, "HEADERS too short for priority");
+        }
+        if((ReadU32(block) & 0x7fffffff) == id)
+        {
+            error = Http2ErrorCode::kProtocolError;
+        }
+        block += 5;
+        len -= 5;
+    }
+
+    auto it = _streams.find(id);
+    if(it == _streams.end())
+    {
+        if(id <= _lastStreamId)
+        {
+            return connectionError(Http2ErrorCode::kStreamClosed, "HEADERS on closed stream");
+        }
+        // 被拒绝的流也占用流id
+        _lastStreamId = id;
+    }
+    else if(it->second.remoteClosed)
+    {
+        error = Http2ErrorCode::kStreamClosed;
+    }
+    else if(0 == (header.flags & Http2Flags::kEndStream))
+    {
+        // 尾部头部必须结束流
+        error = Http2ErrorCode::kProtocolError;
+    }
+
+    _headerStreamId = id;
+    _headerEndStream = header.flags & Http2Flags::kEndStream;
+    _headerError = error;
+    _headerBlock.assign(block, len);
+    if(header.flags & Http2Flags::kEndHeaders)
+    {
+        return onHeaderBlock();
+    }
+    return true;
+}
+
+bool Http2Session::onContinuationFrame(const Http2FrameHeader &header, const char *payload)
+{
+    if(0 == _headerStreamId || header.streamId != _headerStreamId)
+    {
+        return connectionError(Http2ErrorCode::kProtocolError, "unexpected CONTINUATION");
+    }
+    // 无法解码的头部块会让 HPACK 状态失步，只能关闭连接
+    if(_headerBlock.size() + header.length > static_cast<size_t>(_config.maxHeaderListSize) + _config.maxFrameSize)
+    {
+        return connectionError(Http2ErrorCode::kEnhanceYourCalm, "header block too large");
+    }
+    _headerBlock.append(payload, header.length);
+    if(header.flags & Http2Flags::kEndHeaders)
+    {
+        return onHeaderBlock();
+    }
+    return true;
+}
+
+bool Http2Session::onHeaderBlock()
+{
+    const uint32_t id = _headerStreamId;
+    const bool end_stream = _headerEndStream;
+    const Http2ErrorCode error = _headerError;
+    _headerStreamId = 0;
+
+    // 无论流是否被拒绝都要解码，保持动态表同步
+    HpackHeaderList headers;
+    const HpackDecoder::Result result = _decoder.decode(_headerBlock, &headers);
+    _headerBlock.clear();
+    if(HpackDecoder::Result::kError == result)
+    {
+        return connectionError(Http2ErrorCode::kCompressionError, "hpack decode failed");
+    }
+    if(Http2ErrorCode::kNoError != error)
+    {
+        resetStream(id, error);
+        return true;
+    }
+
+    auto it = _streams.find(id);
+    if(it != _streams.end())
+    {
+        // 尾部头部，内容不使用
+        it->second.remoteClosed = true;
+        finishRequest(id);
+        return true;
+    }
+
+    if(_goAwaySent)
+    {
+        resetStream(id, Http2ErrorCode::kRefusedStream);
+        return true;
+    }
+    if(_streams.size() >= _config.maxConcurrentStreams)
+    {
+        HTTP_F_DEBUG("http2 stream[%u] refused, active streams[%lu]\n", id, _streams.size());
+        _refused.fetch_add(1, std::memory_order_relaxed);
+        Metrics().refused.inc();
+        resetStream(id, Http2ErrorCode::kRefusedStream);
+        return true;
+    }
+
+    TcpConnectionPtr conn = _conn.lock();
+    if(!conn)
+    {
+        return false;
+    }
+    Stream stream;
+    stream.ctx = _factory(conn);
+    stream.sendWindow = _peerInitialWindow;
+    stream.recvWindow = _streamRecvInitial;
+    stream.remoteClosed = end_stream;
+    if(trace::Enabled())
+    {
+        stream.ctx->startTrace(trace::Sample(), metrics::NowNs());
+    }
+
+    const bool too_large = HpackDecoder::Result::kTooLarge == result;
+    if(!too_large && !buildRequest(headers, stream))
+    {
+        resetStream(id, Http2ErrorCode::kProtocolError);
+        return true;
+    }
+    stream.ctx->setHttp2Stream(weak_from_this(), id);
+
+    HttpContextPtr ctx = stream.ctx;
+    _streams.emplace(id, std::move(stream));
+    _streamsTotal.fetch_add(1, std::memory_order_relaxed);
+    Metrics().streams.inc();
+    Metrics().streamsTotal.inc();
+
+    if(too_large)
+    {
+        Reply reply;
+        reply.status = StateCode::k431RequestHeaderFieldsTooLarge;
+        sendReply(id, std::move(reply));
+        return true;
+    }
+
+    ctx->onHeadersComplete(!end_stream);
+    if(end_stream)
+    {
+        finishRequest(id);
+    }
+    return true;
+}
+
+bool Http2Session::buildRequest(HpackHeaderList &headers, Stream &stream)
+{
+    auto req = stream.ctx->request();
+    std::string method;
+    std::string scheme;
+    std::string path;
+    std::string authority;
+    bool regular_seen = false;
+
+    for(auto &header : headers)
+    {
+        if(!header.name.empty() && ':' == header.name[0])
+        {
+            // 伪头部必须在普通头部之前，且不能重复或未知
+            std::string *target = nullptr;
+            if(":method" == header.name) target = &method;
+            else if(":scheme" == header.name) target = &scheme;
+            else if(":path" == header.name) target = &path;
+            else if(":authority" == header.name) target = &authority;
+            if(regular_seen || !target || !target->empty())
+            {
+                return false;
+            }
+            *target = std::move(header.value);
+            continue;
+        }
+
+        regular_seen = true;
+        for(char c : header.name)
+        {
+            if('A' <= c && c <= 'Z')
+            {
+                return false;
+            }
+        }
+        if(ConnectionSpecific(header.name) || ("te" == header.name && "trailers" != header.value))
+        {
+            return false;
+        }
+        if("content-length" == header.name)
+        {
+            char *end = nullptr;
+            const long long length = std::strtoll(header.value.c_str(), &end, 10);
+            if(header.value.empty() || *end || length < 0)
+            {
+                return false;
+            }
+            stream.contentLength = length;
+        }
+
+        if("cookie" == header.name && req->headers().has(HttpHeaderId::kCookie))
+        {
+            // HTTP/2 允许把 cookie 拆成多个字段，合并时用 "; " (RFC 9113 8.2.3)
+            std::string cookie(req->header(HttpHeaderId::kCookie));
+            cookie.append("; ").append(header.value);
+            req->headers().set(HttpHeaderId::kCookie, cookie);
+        }
+        else
+        {
+            req->headers().combine(header.name, header.value);
+        }
+    }
+
+    if(method.empty() || scheme.empty() || path.empty() || ('/' != path[0] && "*" != path))
+    {
+        return false;
+    }
+    req->setMethod(HttpRequest::Method::FromString(method));
+    req->setVersion(Version::kHttp20);
+    HttpParser::parseUrl(path, req);
+    if(!authority.empty() && !req->headers().has(HttpHeaderId::kHost))
+    {
+        req->headers().set(HttpHeaderId::kHost, authority);
+    }
+    return true;
+}
+
+void Http2Session::finishRequest(uint32_t streamId)
+{
+    Stream &stream = _streams.at(streamId);
+    if(stream.contentLength >= 0 && stream.receivedBytes != static_cast<uint64_t>(stream.contentLength))
+    {
+        resetStream(streamId, Http2ErrorCode::kProtocolError);
+        return;
+    }
+
+    TcpConnectionPtr conn = _conn.lock();
+    if(!conn)
+    {
+        return;
+    }
+    HttpContextPtr ctx = stream.ctx;
+    if(!ctx->onBodyComplete())
+    {
+        BadRequest400Servlet::Handle(conn, ctx);
+        sendReply(streamId, BuildReply(*ctx->response(), false));
+        return;
+    }
+    ctx->setState(HttpContext::kGotAll);
+    trace::Record(ctx->traceId(), "http.parse", ctx->traceBeginNs(), metrics::NowNs());
+    // 回调可能同步提交响应，之后不能再引用 stream
+    _callback(conn, ctx);
+}
+
+bool Http2Session::onSettingsFrame(const Http2FrameHeader &header, const char *payload)
+{
+    if(0 != header.streamId)
+    {
+        return connectionError(Http2ErrorCode::kProtocolError, "SETTINGS on stream");
+    }
+
+    if(header.flags & Http2Flags::kAck)
+    {
+        if(0 != header.length)
+        {
+            return connectionError(Http2ErrorCode::kFrameSizeError, "SETTINGS ack with payload");
+        }
+        if(!_settingsAcked)
+        {
+            // 对端已按本端设置的窗口发送，已打开的流一并调整
+            _settingsAcked = true;
+            const int64_t delta = static_cast<int64_t>(_config.initialWindowSize) - _streamRecvInitial;
+            for(auto &item : _streams)
+            {
+                item.second.recvWindow += delta;
+            }
+            _streamRecvInitial = _config.initialWindowSize;
+        }
+        return true;
+    }
+
+    if(!applySettings(payload, header.length))
+    {
+        return false;
+    }
+    _settingsReceived = true;
+    AppendHttp2SettingsAck(&_out);
+    // 初始窗口可能变大
+    flushPending();
+    return true;
+}
+
+bool Http2Session::applySettings(const char *payload, size_t len)
+{
+    if(0 != len % 6)
+    {
+        return connectionError(Http2ErrorCode::kFrameSizeError, "bad SETTINGS length");
+    }
+    for(size_t pos = 0; pos < len; pos += 6)
+    {
+        const uint16_t id = ReadU16(payload + pos);
+        const uint32_t value = ReadU32(payload + pos + 2);
+        switch(static_cast<Http2Setting>(id))
+        {
+            case Http2Setting::kHeaderTableSize:
+            {
+                // 编码端最多使用 4KB
+                const size_t size = std::min<size_t>(value, 4096);
+                if(size != _encoder.table().maxSize())
+                {
+                    _encoder.setMaxTableSize(size);
+                }
+                break;
+            }
+            case Http2Setting::kEnablePush:
+                if(value > 1)
+                {
+                    return connectionError(Http2ErrorCode::kProtocolError, "invalid SETTINGS_ENABLE_PUSH");
+                }
+                break;
+            case Http2Setting::kInitialWindowSize:
+            {
+                if(value > kHttp2MaxWindowSize)
+                {
+                    return connectionError(Http2ErrorCode::kFlowControlError, "invalid SETTINGS_INITIAL_WINDOW_SIZE");
+                }
+                const int64_t delta = static_cast<int64_t>(value) - _peerInitialWindow;
+                for(auto &item : _streams)
+                {
+                    item.second.sendWindow += delta;
+                    if(item.second.sendWindow > kHttp2MaxWindowSize)
+                    {
+                        return connectionError(Http2ErrorCode::kFlowControlError, "stream window overflow");
+                    }
+                }
+                _peerInitialWindow = value;
+                break;
+            }
+            case Http2Setting::kMaxFrameSize:
+                if(value < kHttp2DefaultMaxFrameSize || value > 0xffffff)
+                {
+                    return connectionError(Http2ErrorCode::kProtocolError, "invalid SETTINGS_MAX_FRAME_SIZE");
+                }
+                _peerMaxFrameSize = value;
+                break;
+            default:
+                // MAX_CONCURRENT_STREAMS(限制的是本端推送)、MAX_HEADER_LIST_SIZE(建议值)与未知设置忽略
+                break;
+        }
+    }
+    return true;
+}
+
+bool Http2Session::onWindowUpdateFrame(const Http2FrameHeader &header, const char *payload)
+{
+    if(4 != header.length)
+    {
+        return connectionError(Http2ErrorCode::kFrameSizeError, "bad WINDOW_UPDATE length");
+    }
+    const uint32_t increment = ReadU32(payload) & 0x7fffffff;
+    const uint32_t id = header.streamId;
+    if(0 == id)
+    {
+        if(0 == increment)
+        {
+            return connectionError(Http2ErrorCode::kProtocolError, "zero WINDOW_UPDATE increment");
+        }
+        _sendWindow += increment;
+        if(_sendWindow > kHttp2MaxWindowSize)
+        {
+            return connectionError(Http2ErrorCode::kFlowControlError, "connection window overflow");
+        }
+    }
+    else
+    {
+        if(id > _lastStreamId)
+        {
+            return connectionError(Http2ErrorCode::kProtocolError, "WINDOW_UPDATE on idle stream");
+        }
+        auto it = _streams.find(id);
+        if(it == _streams.end())
+        {
+            // 已关闭的流上迟到的更新
+            return true;
+        }
+        if(0 == increment)
+        {
+            resetStream(id, Http2ErrorCode::kProtocolError);
+            return true;
+        }
+        it->second.sendWindow += increment;
+        if(it->second.sendWindow > kHttp2MaxWindowSize)
+        {
+            resetStream(id, Http2ErrorCode::kFlowControlError);
+            return true;
+        }
+    }
+    flushPending();
+    return true;
+}
+
+Http2Session::Reply Http2Session::BuildReply(HttpResponse &resp, bool headOnly)
+{
+    Reply reply;
+    if(!resp.serialized().empty())
+    {
+        // 预序列化的 HTTP/1 响应(如响应缓存)拆回状态码、头部与Body
+        std::string all;
+        for(auto &buf : resp.serialized())
+        {
+            all.append(*buf);
+        }
+        const size_t end = all.find("\r\n\r\n");
+        const std::string_view head = std::string_view(all).substr(0, end);
+        reply.status = ParseHeaderBlock(head, &reply.headers);
+        if(!headOnly && std::string::npos != end)
+        {
+            reply.body = all.substr(end + 4);
+        }
+        if(headOnly || resp.segments().empty())
+        {
+            return reply;
+        }
+    }
+    else
+    {
+        reply.status = ParseHeaderBlock(resp.headerString(), &reply.headers);
+        if(resp.stateCode().toInt() > 0)
+        {
+            reply.status = resp.stateCode().toInt();
+        }
+        if(headOnly)
+        {
+            return reply;
+        }
+        if(resp.segments().empty())
+        {
+            const std::string_view body = resp.body().view();
+            reply.body.assign(body.data(), body.size());
+            return reply;
+        }
+    }
+
+    // h2 需要分帧，文件区间在调用线程中读出，不走 sendfile
+    reply.body.reserve(reply.body.size() + resp.segmentBytes());
+    for(auto &seg : resp.segments())
+    {
+        if(!seg.file)
+        {
+            reply.body.append(seg.data);
+            continue;
+        }
+        const size_t old_size = reply.body.size();
+        reply.body.resize(old_size + seg.length);
+        const ssize_t n = ::pread(seg.file->fd(), &reply.body[old_size], seg.length, seg.offset);
+        if(n != static_cast<ssize_t>(seg.length))
+        {
+            HTTP_F_ERROR("http2 read file segment failed: fd[%d], offset[%lld], length[%lu]\n", seg.file->fd(), static_cast<long long>(seg.offset), seg.length);
+            reply.body.resize(old_size + (n > 0 ? n : 0));
+        }
+    }
+    return reply;
+}
+
+void Http2Session::submitResponse(uint32_t streamId, HttpResponse &resp, bool headOnly)
+{
+    Reply reply = BuildReply(resp, headOnly);
+    bool first = false;
+    {
+        std::lock_guard<std::mutex> lock(_replyMutex);
+        first = _replyQueue.empty();
+        _replyQueue.emplace_back(streamId, std::move(reply));
+    }
+    if(!first)
+    {
+        return;
+    }
+    std::weak_ptr<Http2Session> weak_session = shared_from_this();
+    // IO线程内也排队执行: 请求回调可能同步提交响应，此时仍在处理帧
+    _loop->queueInLoop([weak_session]() {
+        if(auto session = weak_session.lock())
+        {
+            session->drainReplies();
+        }
+    });
+}
+
+void Http2Session::drainReplies()
+{
+    std::vector<std::pair<uint32_t, Reply>> replies;
+    {
+        std::lock_guard<std::mutex> lock(_replyMutex);
+        replies.swap(_replyQueue);
+    }
+    for(auto &item : replies)
+    {
+        sendReply(item.first, std::move(item.second));
+    }
+    flushOutput();
+}
+
+void Http2Session::sendReply(uint32_t streamId, Reply reply)
+{
+    auto it = _streams.find(streamId);
+    if(_closed || it == _streams.end() || it->second.responded)
+    {
+        return;
+    }
+    Stream &stream = it->second;
+    stream.responded = true;
+
+    HpackHeaderList headers;
+    headers.reserve(reply.headers.size() + 1);
+    headers.push_back(HpackHeader{":status", std::to_string(reply.status)});
+    for(auto &header : reply.headers)
+    {
+        headers.push_back(std::move(header));
+    }
+    std::string block;
+    _encoder.encode(headers, &block);
+
+    const bool end_stream = reply.body.empty();
+    AppendHttp2Headers(&_out, streamId, block, end_stream, _peerMaxFrameSize);
+    if(end_stream)
+    {
+        closeStream(streamId);
+        return;
+    }
+    stream.pending = std::move(reply.body);
+    stream.pendingOffset = 0;
+    flushPending();
+}
+
+void Http2Session::flushPending()
+{
+    // 按流id轮转，每轮每个流最多一帧，避免大响应独占连接窗口
+    bool progress = true;
+    while(progress && _sendWindow > 0)
+    {
+        progress = false;
+        for(auto it = _streams.begin(); it != _streams.end() && _sendWindow > 0; )
+        {
+            Stream &stream = it->second;
+            const size_t remain = stream.pending.size() - stream.pendingOffset;
+            if(!stream.responded || 0 == remain || stream.sendWindow <= 0)
+            {
+                ++it;
+                continue;
+            }
+            const size_t n = std::min({remain, static_cast<size_t>(stream.sendWindow),
+                                       static_cast<size_t>(_sendWindow), static_cast<size_t>(_peerMaxFrameSize)});
+            const bool last = n == remain;
+            const uint32_t id = it->first;
+            AppendHttp2Frame(&_out, Http2FrameType::kData, last ? Http2Flags::kEndStream : 0, id,
+                             std::string_view(stream.pending).substr(stream.pendingOffset, n));
+            stream.pendingOffset += n;
+            stream.sendWindow -= n;
+            _sendWindow -= n;
+            progress = true;
+            ++it;
+            if(last)
+            {
+                closeStream(id);
+            }
+        }
+    }
+}
+
+void Http2Session::closeStream(uint32_t streamId)
+{
+    auto it = _streams.find(streamId);
+    if(it == _streams.end())
+    {
+        return;
+    }
+    // 响应先于请求结束(如 431)，通知对端不必再发
+    if(!it->second.remoteClosed)
+    {
+        AppendHttp2RstStream(&_out, streamId, Http2ErrorCode::kNoError);
+    }
+    _streams.erase(it);
+    Metrics().streams.dec();
+
+    if((_goAwayReceived || _goAwaySent) && _streams.empty())
+    {
+        flushOutput();
+        if(TcpConnectionPtr conn = _conn.lock())
+        {
+            conn->shutdown();
+        }
+    }
+}
+
+void Http2Session::resetStream(uint32_t streamId, Http2ErrorCode code)
+{
+    HTTP_F_DEBUG("http2 reset stream[%u]: %s\n", streamId, Http2ErrorCodeName(code));
+    AppendHttp2RstStream(&_out, streamId, code);
+    _resets.fetch_add(1, std::memory_order_relaxed);
+    if(_streams.erase(streamId))
+    {
+        Metrics().streams.dec();
+    }
+}
+
+bool Http2Session::connectionError(Http2ErrorCode code, const char *reason)
+{
+    if(_closed)
+    {
+        return false;
+    }
+    TcpConnectionPtr conn = _conn.lock();
+    HTTP_F_WARN("http2 conn[%s] connection error %s: %s\n", conn ? conn->name().c_str() : "", Http2ErrorCodeName(code), reason);
+    AppendHttp2GoAway(&_out, _lastStreamId, code, reason);
+    _goAwaySent = true;
+    flushOutput();
+    _closed = true;
+    Metrics().streams.dec(static_cast<int64_t>(_streams.size()));
+    _streams.clear();
+    if(conn)
+    {
+        conn->shutdown();
+    }
+    return false;
+}
+
+void Http2Session::shutdown()
+{
+    if(_closed || _goAwaySent)
+    {
+        return;
+    }
+    AppendHttp2GoAway(&_out, _lastStreamId, Http2ErrorCode::kNoError);
+    _goAwaySent = true;
+    flushOutput();
+    if(_streams.empty())
+    {
+        if(TcpConnectionPtr conn = _conn.lock())
+        {
+            conn->shutdown();
+        }
+    }
+}
+
+void Http2Session::onDisconnected()
+{
+    _closed = true;
+    Metrics().streams.dec(static_cast<int64_t>(_streams.size()));
+    _streams.clear();
+    _out.clear();
+}
+
+void Http2Session::flushOutput()
+{
+    if(_out.empty())
+    {
+        return;
+    }
+    if(TcpConnectionPtr conn = _conn.lock())
+    {
+        conn->send(std::move(_out));
+    }
+    _out.clear();
+}
+
+Http2Session::Stats Http2Session::stats() const
+{
+    Stats stats;
+    stats.activeStreams = _streams.size();
+    stats.streams = _streamsTotal.load(std::memory_order_relaxed);
+    stats.refused = _refused.load(std::memory_order_relaxed);
+    stats.resets = _resets.load(std::memory_order_relaxed);
+    for(auto &item : _streams)
+    {
+        stats.blockedBytes += item.second.pending.size() - item.second.pendingOffset;
+    }
+    return stats;
+}
+
+}   // kit_muduo::http
@@ -0,0 +1,234 @@
+/**
+ * @file http_asset_cache.cpp
+ * @brief 小文件热点资源内存缓存
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 13:05:37
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_asset_cache.h"
+#include "net/net_log.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+
+namespace kit_muduo::http {
+
+namespace {
+
+int64_t NowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SharedBuffer BuildHeader(const HttpFileCache::Entry &entry, const std::string &contentType,
+                         const std::string &extraHeaders, bool keepAlive)
+{
+    std::string header = "HTTP/1.1 200 OK\r\n";
+    header += "Content-Type: " + contentType + "\r\n";
+    header += "Content-Length: " + std::to_string(entry.file->size()) + "\r\n";
+    header += "ETag: " + entry.etag + "\r\n";
+    header += "Last-Modified: " + entry.last_modified + "\r\n";
+    header += "Accept-Ranges: bytes\r\n";
+    header += extraHeaders;
+    if(keepAlive)
+    {
+        header += "Connection: keep-alive\r\n";
+        header += "Keep-Alive: timeout=5, max=100\r\n";
+    }
+    else
+    {
+        header += "Connection: close\r\n";
+    }
+    // 结尾的 Date 与空行在发送时由 HttpDateCache::DateBlock() 补上
+    return std::make_shared<const std::string>(std::move(header));
+}
+
+HttpAssetCache::AssetPtr LoadAsset(const std::string &path, const HttpFileCache::Entry &entry, HttpAssetCache::Storage storage,
+                                   const std::string &contentType, const std::string &extraHeaders)
+{
+    const SharedFile &file = *entry.file;
+    auto asset = std::make_shared<HttpAssetCache::Asset>();
+    if(HttpAssetCache::Storage::kMemFile == storage)
+    {
+        asset->body_file = SharedFile::Snapshot(file);
+        if(!asset->body_file)
+        {
+            HTTP_F_WARN("asset cache snapshot %s failed\n", path.c_str());
+            return nullptr;
+        }
+    }
+    else
+    {
+        std::string body(file.size(), '\0');
+        size_t done = 0;
+        while(done < body.size())
+        {
+            ssize_t n = ::pread(file.fd(), &body[done], body.size() - done, static_cast<off_t>(done));
+            if(n <= 0)
+            {
+                HTTP_F_WARN("asset cache read %s failed, %zu/%zu\n", path.c_str(), done, body.size());
+                return nullptr;
+            }
+            done += static_cast<size_t>(n);
+        }
+        asset->body = std::make_shared<const std::string>(std::move(body));
+    }
+
+    asset->header_keep_alive = BuildHeader(entry, contentType, extraHeaders, true);
+    asset->header_close = BuildHeader(entry, contentType, extraHeaders, false);
+    asset->etag = entry.etag;
+    asset->inode = file.inode();
+    asset->device = file.device();
+    asset->size = file.size();
+    asset->mtime_ns = file.mtimeNs();
+    asset->checked_ms.store(NowMs(), std::memory_order_relaxed);
+    return asset;
+}
+
+}
+
+HttpAssetCache::HttpAssetCache(size_t budgetBytes, size_t maxAssetBytes, int32_t revalidateMs, Storage storage)
+    :_budgetBytes(budgetBytes)
+    ,_maxAssetBytes(maxAssetBytes)
+    ,_revalidateMs(revalidateMs)
+    ,_storage(storage)
+{
+}
+
+HttpAssetCache::AssetPtr HttpAssetCache::get(const std::string &path)
+{
+    AssetPtr asset;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _map.find(path);
+        if(it == _map.end())
+        {
+            ++_misses;
+            return nullptr;
+        }
+        _list.splice(_list.begin(), _list, it->second);
+        asset = it->second->second;
+    }
+
+    int64_t now_ms = NowMs();
+    if(now_ms - asset->checked_ms.load(std::memory_order_relaxed) >= _revalidateMs)
+    {
+        // stat 放在锁外，校验失败再回来删除
+        struct stat st;
+        bool same = ::stat(path.c_str(), &st) == 0
+            && static_cast<uint64_t>(st.st_ino) == asset->inode
+            && static_cast<uint64_t>(st.st_dev) == asset->device
+            && static_cast<uint64_t>(st.st_size) == asset->size
+            && static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec == asset->mtime_ns;
+        if(!same)
+        {
+            HTTP_F_DEBUG("asset cache invalidate: %s\n", path.c_str());
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _map.find(path);
+            if(it != _map.end() && it->second->second == asset)
+            {
+                eraseUnLocked(it);
+                ++_invalidations;
+            }
+            ++_misses;
+            return nullptr;
+        }
+        asset->checked_ms.store(now_ms, std::memory_order_relaxed);
+    }
+
+    ++_hits;
+    return asset;
+}
+
+HttpAssetCache::AssetPtr HttpAssetCache::put(const std::string &path, const HttpFileCache::Entry &entry, const std::string &contentType,
+                                             const std::string &extraHeaders)
+{
+    if(entry.file->size() > _maxAssetBytes)
+    {
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(!_filling.insert(path).second)
+        {
+            ++_fill_bypasses;
+            return nullptr;
+        }
+    }
+
+    AssetPtr asset = LoadAsset(path, entry, _storage, contentType, extraHeaders);
+    if(!asset)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _filling.erase(path);
+        return nullptr;
+    }
+
+    const size_t bytes = asset->bytes();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _filling.erase(path);
+    if(bytes > _budgetBytes)
+    {
+        return asset;
+    }
+    auto it = _map.find(path);
+    if(it != _map.end())
+    {
+        eraseUnLocked(it);
+    }
+    _list.emplace_front(path, asset);
+    _map[path] = _list.begin();
+    _bytes += bytes;
+
+    // 超出预算从尾部淘汰
+    while(_bytes > _budgetBytes && !_list.empty())
+    {
+        eraseUnLocked(_map.find(_list.back().first));
+        ++_evictions;
+    }
+    return asset;
+}
+
+void HttpAssetCache::invalidate(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _map.find(path);
+    if(it != _map.end())
+    {
+        eraseUnLocked(it);
+    }
+}
+
+void HttpAssetCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _list.clear();
+    _map.clear();
+    _bytes = 0;
+}
+
+HttpAssetCache::Stats HttpAssetCache::stats() const
+{
+    Stats stats;
+    stats.hits = _hits.load(std::memory_order_relaxed);
+    stats.misses = _misses.load(std::memory_order_relaxed);
+    stats.evictions = _evictions.load(std::memory_order_relaxed);
+    stats.invalidations = _invalidations.load(std::memory_order_relaxed);
+    stats.fill_bypasses = _fill_bypasses.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(_mutex);
+    stats.bytes = _bytes;
+    stats.entries = _map.size();
+    return stats;
+}
+
+void HttpAssetCache::eraseUnLocked(std::unordered_map<std::string, LruList::iterator>::iterator it)
+{
+    _bytes -= it->second->second->bytes();
+    _list.erase(it->second);
+    _map.erase(it);
+}
+
+}   // kit_muduo::http
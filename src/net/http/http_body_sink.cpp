@@ -0,0 +1,167 @@
+/**
+ * @file http_body_sink.cpp
+ * @brief HTTP请求Body流式接收
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 17:02:45
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_body_sink.h"
+#include "net/net_log.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace kit_muduo::http {
+
+/***********FunctionBodySink************ */
+
+FunctionBodySink::FunctionBodySink(DataCallBack onData, CompleteCallBack onComplete)
+    :_dataCallback(std::move(onData))
+    ,_completeCallback(std::move(onComplete))
+{
+}
+
+bool FunctionBodySink::onData(const char *data, size_t len)
+{
+    _receivedBytes += len;
+    return _dataCallback ? _dataCallback(data, len) : true;
+}
+
+bool FunctionBodySink::onComplete()
+{
+    return _completeCallback ? _completeCallback() : true;
+}
+
+/***********FileBodySink************ */
+
+FileBodySink::FileBodySink(const std::string &path, uint64_t maxBytes)
+    :_path(path)
+    ,_maxBytes(maxBytes)
+    ,_fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644))
+{
+    if(_fd < 0)
+    {
+        HTTP_F_ERROR("FileBodySink open failed! path[%s], %d:%s\n", path.c_str(), errno, strerror(errno));
+    }
+}
+
+FileBodySink::~FileBodySink()
+{
+    closeFile();
+}
+
+bool FileBodySink::onData(const char *data, size_t len)
+{
+    if(_fd < 0)
+    {
+        return false;
+    }
+    if(_maxBytes > 0 && _receivedBytes + len > _maxBytes)
+    {
+        HTTP_F_WARN("FileBodySink body too large! path[%s], limit[%llu]\n", _path.c_str(), static_cast<unsigned long long>(_maxBytes));
+        return false;
+    }
+
+    size_t left = len;
+    while(left > 0)
+    {
+        ssize_t n = ::write(_fd, data, left);
+        if(n < 0)
+        {
+            if(EINTR == errno)
+            {
+                continue;
+            }
+            HTTP_F_ERROR("FileBodySink write failed! path[%s], %d:%s\n", _path.c_str(), errno, strerror(errno));
+            return false;
+        }
+        data += n;
+        left -= static_cast<size_t>(n);
+    }
+
+    _receivedBytes += len;
+    return true;
+}
+
+bool FileBodySink::onComplete()
+{
+    if(_fd < 0)
+    {
+        return false;
+    }
+    closeFile();
+    _completed = true;
+    return true;
+}
+
+void FileBodySink::onAbort()
+{
+    closeFile();
+    if(!_completed)
+    {
+        ::unlink(_path.c_str());
+    }
+}
+
+void FileBodySink::closeFile()
+{
+    if(_fd >= 0)
+    {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
+
+/***********MultipartBodySink************ */
+
+MultipartBodySink::MultipartBodySink(std::string_view contentType, uint64_t maxBytes)
+    :MultipartBodySink(contentType, maxBytes, MultipartForm::Config())
+{
+}
+
+MultipartBodySink::MultipartBodySink(std::string_view contentType, uint64_t maxBytes, MultipartForm::Config config)
+    :_maxBytes(maxBytes)
+    ,_form(std::move(config))
+    ,_started(_form.begin(contentType))
+{
+    if(!_started)
+    {
+        HTTP_F_WARN("MultipartBodySink invalid content type[%.*s]\n", static_cast<int>(contentType.size()), contentType.data());
+    }
+}
+
+bool MultipartBodySink::onData(const char *data, size_t len)
+{
+    if(!_started)
+    {
+        return false;
+    }
+    if(_maxBytes > 0 && _receivedBytes + len > _maxBytes)
+    {
+        HTTP_F_WARN("MultipartBodySink body too large! limit[%llu]\n", static_cast<unsigned long long>(_maxBytes));
+        return false;
+    }
+    _receivedBytes += len;
+    if(!_form.feed(data, len))
+    {
+        HTTP_F_WARN("MultipartBodySink parse failed! %s\n", _form.error());
+        return false;
+    }
+    return true;
+}
+
+bool MultipartBodySink::onComplete()
+{
+    if(!_started || !_form.finish())
+    {
+        HTTP_F_WARN("MultipartBodySink incomplete form! %s\n", _form.error() ? _form.error() : "");
+        return false;
+    }
+    _completed = true;
+    return true;
+}
+
+}   // kit_muduo::http
@@ -0,0 +1,627 @@
+/**
+ * @file http_client.cpp
+ * @brief 非阻塞 HTTP/1.1 客户端: 按主机的 keep-alive 连接池、流水线请求队列、定时器驱动的超时
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 17:26:50
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_client.h"
+#include "net/http/http_context.h"
+#include "net/http/http_response.h"
+#include "net/http/http_headers.h"
+#include "net/event_loop.h"
+#include "net/tcp_connection.h"
+#include "net/buffer.h"
+#include "net/net_log.h"
+#include "base/util.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace kit_muduo {
+namespace http {
+
+namespace {
+
+/// @brief 响应之后连接是否可以继续使用
+bool KeepAlive(const HttpResponse &resp)
+{
+    const std::string_view connection = resp.header(HttpHeaderId::kConnection);
+    if(Version::kHttp11 == resp.version()())
+    {
+        return !HeaderHasToken(connection, "close");
+    }
+    return HeaderHasToken(connection, "keep-alive");
+}
+
+}
+
+const char* HttpClient::ErrorString(Error err)
+{
+    switch(err)
+    {
+        case kOk: return "ok";
+        case kConnectFailed: return "connect failed";
+        case kTimeout: return "timeout";
+        case kConnectionClosed: return "connection closed";
+        case kBadResponse: return "bad response";
+        case kQueueFull: return "queue full";
+        case kCancelled: return "cancelled";
+    }
+    return "unknown";
+}
+
+HttpClient::HttpClient(EventLoop *loop)
+    :HttpClient(loop, Config())
+{
+}
+
+HttpClient::HttpClient(EventLoop *loop, Config config)
+    :_loop(loop)
+    ,_config(std::move(config))
+{
+}
+
+HttpClient::~HttpClient()
+{
+    // 内部回调只持有弱引用，走到这里时不会再有回调进入，可以直接清理
+    if(_timer)
+    {
+        _loop->cancel(_timer);
+    }
+    for(auto &item : _hosts)
+    {
+        Host &host = item.second;
+        for(auto &connecting : host.connecting)
+        {
+            connecting.first->stop();
+        }
+        for(auto &c : host.conns)
+        {
+            c->closing = true;
+            for(auto &pending : c->inflight)
+            {
+                finish(pending, kCancelled, nullptr);
+            }
+            c->conn->forceClose();
+        }
+        failQueue(host, kCancelled);
+    }
+}
+
+std::string HttpClient::Serialize(const HttpRequest &req, const std::string &host, const std::string &userAgent)
+{
+    const int32_t method = HttpRequest::Method::kInvaild == req.method()() ? HttpRequest::Method::kGet : req.method()();
+    const std::string path = req.path().empty() ? std::string("/") : req.path();
+    const HttpHeaders &headers = req.headers();
+    const std::string_view body = req.body().view();
+
+    std::string out;
+    out.reserve(96 + path.size() + headers.size() * 32 + body.size());
+    out.append(HttpRequest::Method(method).toString()).append(" ").append(path).append(" HTTP/1.1\r\n");
+    if(!headers.has(HttpHeaderId::kHost))
+    {
+        out.append("Host: ").append(host).append("\r\n");
+    }
+    if(!userAgent.empty() && !headers.has(HttpHeaderId::kUserAgent))
+    {
+        out.append("User-Agent: ").append(userAgent).append("\r\n");
+    }
+    for(const auto &header : headers)
+    {
+        out.append(header.first).append(": ").append(header.second).append("\r\n");
+    }
+    if(!body.empty() && !headers.has(HttpHeaderId::kContentType)
+       && ContentType::kUnknowType != req.body().contentType()())
+    {
+        out.append("Content-Type: ").append(req.body().contentType().toString()).append("\r\n");
+    }
+    // POST/PUT 即使没有Body也要带长度，否则部分服务器会等待Body
+    const bool needs_length = !body.empty() || HttpRequest::Method::kPost == method || HttpRequest::Method::kPut == method;
+    if(needs_length && !headers.has(HttpHeaderId::kContentLength) && !headers.has(HttpHeaderId::kTransferEncoding))
+    {
+        out.append("Content-Length: ").append(std::to_string(body.size())).append("\r\n");
+    }
+    out.append("\r\n");
+    out.append(body.data(), body.size());
+    return out;
+}
+
+void HttpClient::request(const InetAddress &server, HttpRequest req, ResponseCallBack cb)
+{
+    const int32_t method = req.method()();
+    Pending pending;
+    pending.head = HttpRequest::Method::kHead == method;
+    pending.idempotent = HttpRequest::Method::kPost != method;
+    pending.cb = std::move(cb);
+    // 序列化在调用线程完成，循环线程只负责收发
+    pending.wire = Serialize(req, server.toIpPort(), _config.userAgent);
+    pending.deadlineMs = GetMonotonicMS() + _config.requestTimeoutMs;
+
+    _loop->runInLoop([weak = weak_from_this(), server, pending = std::move(pending)]() mutable {
+        if(auto self = weak.lock())
+        {
+            self->submit(server, std::move(pending));
+        }
+        else if(pending.cb)
+        {
+            pending.cb(Result{kCancelled, nullptr});
+        }
+    });
+}
+
+std::future<HttpClient::Result> HttpClient::request(const InetAddress &server, HttpRequest req)
+{
+    auto promise = std::make_shared<std::promise<Result>>();
+    std::future<Result> future = promise->get_future();
+    request(server, std::move(req), [promise](Result result) {
+        promise->set_value(std::move(result));
+    });
+    return future;
+}
+
+void HttpClient::get(const InetAddress &server, const std::string &path, ResponseCallBack cb)
+{
+    HttpRequest req;
+    req.setMethod(HttpRequest::Method::kGet);
+    req.setPath(path);
+    request(server, std::move(req), std::move(cb));
+}
+
+std::future<HttpClient::Result> HttpClient::get(const InetAddress &server, const std::string &path)
+{
+    HttpRequest req;
+    req.setMethod(HttpRequest::Method::kGet);
+    req.setPath(path);
+    return request(server, std::move(req));
+}
+
+HttpClient::Stats HttpClient::stats() const
+{
+    Stats stats = _stats;
+    for(const auto &item : _hosts)
+    {
+        const Host &host = item.second;
+        stats.queued += host.queue.size();
+        stats.connections += host.conns.size();
+        for(const auto &c : host.conns)
+        {
+            stats.inflight += c->inflight.size();
+            stats.idleConnections += c->inflight.empty() ? 1 : 0;
+        }
+    }
+    return stats;
+}
+
+HttpClient::Host& HttpClient::hostOf(const InetAddress &server)
+{
+    std::string key = server.toIpPort();
+    auto it = _hosts.find(key);
+    if(it == _hosts.end())
+    {
+        it = _hosts.emplace(key, Host()).first;
+        it->second.addr = server;
+        it->second.key = std::move(key);
+    }
+    return it->second;
+}
+
+void HttpClient::submit(const InetAddress &server, Pending pending)
+{
+    Host &host = hostOf(server);
+    ++_stats.requests;
+    if(host.queue.size() >= _config.maxQueuedPerHost)
+    {
+        HTTP_F_WARN("HttpClient queue of %s full! [%zu]\n", host.key.c_str(), host.queue.size());
+        finish(pending, kQueueFull, nullptr);
+        return;
+    }
+    host.queue.push_back(std::move(pending));
+    ensureTimer();
+    dispatch(host);
+}
+
+void HttpClient::dispatch(Host &host)
+{
+    while(!host.queue.empty())
+    {
+        // 选在途请求最少的连接，非幂等请求之后不再追加
+        Conn *best = nullptr;
+        for(auto &c : host.conns)
+        {
+            if(c->closing || c->inflight.size() >= _config.pipelineDepth
+               || (!c->inflight.empty() && !c->inflight.back().idempotent))
+            {
+                continue;
+            }
+            if(nullptr == best || c->inflight.size() < best->inflight.size())
+            {
+                best = c.get();
+                if(c->inflight.empty())
+                {
+                    break;
+                }
+            }
+        }
+        if(nullptr == best)
+        {
+            break;
+        }
+
+        Pending pending = std::move(host.queue.front());
+        host.queue.pop_front();
+        if(best->served > 0)
+        {
+            ++_stats.reusedRequests;
+        }
+        best->conn->send(std::string(pending.wire));
+        best->inflight.push_back(std::move(pending));
+    }
+
+    // 剩余请求按每条连接可承载的在途数估算还需要的连接
+    while(!host.queue.empty()
+          && host.conns.size() + host.connecting.size() < _config.maxConnectionsPerHost
+          && host.connecting.size() * _config.pipelineDepth < host.queue.size())
+    {
+        startConnect(host);
+    }
+}
+
+void HttpClient::startConnect(Host &host)
+{
+    auto connector = std::make_shared<Connector>(_loop, host.addr);
+    Host *h = &host;
+    Connector *raw = connector.get();
+    // 连接器持有回调，回调里不能再持有连接器本身
+    connector->setNewConnectionCallback([weak = weak_from_this(), h, raw](int32_t sockfd) {
+        if(auto self = weak.lock())
+        {
+            self->onConnected(h, raw, sockfd);
+        }
+        else
+        {
+            ::close(sockfd);
+        }
+    });
+    connector->setErrorCallback([weak = weak_from_this(), h, raw](int32_t err) {
+        if(auto self = weak.lock())
+        {
+            self->onConnectFailed(h, raw, err);
+        }
+    });
+    host.connecting.emplace_back(connector, GetMonotonicMS());
+    connector->start();
+}
+
+void HttpClient::removeConnector(Host &host, Connector *connector)
+{
+    auto it = std::find_if(host.connecting.begin(), host.connecting.end(),
+                           [connector](const auto &item) { return item.first.get() == connector; });
+    if(it != host.connecting.end())
+    {
+        host.connecting.erase(it);
+    }
+}
+
+void HttpClient::onConnected(Host *host, Connector *connector, int32_t sockfd)
+{
+    removeConnector(*host, connector);
+    ++_stats.connects;
+
+    int32_t on = 1;
+    ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    std::string name = "http-client-" + host->key + "#" + std::to_string(++_nextConnId);
+    auto conn = std::make_shared<TcpConnection>(_loop, name, sockfd, InetAddress::GetPeerAddr(sockfd), InetAddress::GetLocalAddr(sockfd));
+    auto c = std::make_shared<Conn>();
+    c->conn = conn;
+    c->host = host;
+    c->ctx = std::make_shared<HttpContext>();
+    c->idleSinceMs = GetMonotonicMS();
+    conn->setContext(c);
+
+    std::weak_ptr<HttpClient> weak = weak_from_this();
+    conn->setConnectionCallback([](const TcpConnectionPtr&) {});
+    conn->setMessageCallback([weak](const TcpConnectionPtr &conn, Buffer *buf, TimeStamp receiveTime) {
+        if(auto self = weak.lock())
+        {
+            self->onMessage(conn, buf, receiveTime);
+        }
+        else
+        {
+            buf->resetAll();
+        }
+    });
+    conn->setCloseCallback([weak](const TcpConnectionPtr &conn) {
+        if(auto self = weak.lock())
+        {
+            self->onClose(conn);
+        }
+        // Conn 与 TcpConnection 互相持有，关闭时解开
+        conn->setContext(nullptr);
+        conn->getLoop()->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+    });
+
+    host->conns.push_back(c);
+    conn->connectEstablished();
+    HTTP_F_DEBUG("HttpClient connected %s\n", name.c_str());
+    dispatch(*host);
+}
+
+void HttpClient::onConnectFailed(Host *host, Connector *connector, int32_t err)
+{
+    removeConnector(*host, connector);
+    ++_stats.connectFailures;
+    HTTP_F_WARN("HttpClient connect %s failed! %d:%s\n", host->key.c_str(), err, strerror(err));
+    // 还有可用连接时请求由它们接着处理，否则没有机会再发出
+    if(host->conns.empty() && host->connecting.empty())
+    {
+        failQueue(*host, kConnectFailed);
+    }
+}
+
+void HttpClient::onMessage(const TcpConnectionPtr &conn, Buffer *buf, TimeStamp receiveTime)
+{
+    ConnPtr c = std::static_pointer_cast<Conn>(conn->getContext());
+    if(!c || c->closing)
+    {
+        buf->resetAll();
+        return;
+    }
+
+    while(buf->readableBytes() > 0)
+    {
+        if(c->inflight.empty())
+        {
+            HTTP_F_WARN("HttpClient unexpected data from %s, %zu bytes\n", c->host->key.c_str(), buf->readableBytes());
+            retire(c, kBadResponse);
+            return;
+        }
+
+        c->ctx->setResponseToHead(c->inflight.front().head);
+        if(!c->ctx->parseResponse(*buf, receiveTime))
+        {
+            HTTP_F_WARN("HttpClient bad response from %s\n", c->host->key.c_str());
+            retire(c, kBadResponse);
+            return;
+        }
+        if(!c->ctx->gotAll())
+        {
+            break;
+        }
+
+        HttpResponsePtr resp = c->ctx->response();
+        c->ctx = std::make_shared<HttpContext>();
+        const int32_t code = resp->stateCode()();
+        // 1xx 临时响应之后还有最终响应
+        if(code >= 100 && code < 200 && 101 != code)
+        {
+            continue;
+        }
+
+        Pending pending = std::move(c->inflight.front());
+        c->inflight.pop_front();
+        ++c->served;
+        const bool keep_alive = KeepAlive(*resp);
+        if(!keep_alive)
+        {
+            c->closing = true;
+        }
+        finish(pending, kOk, std::move(resp));
+        if(!keep_alive)
+        {
+            retire(c, kConnectionClosed);
+            return;
+        }
+    }
+
+    if(c->inflight.empty())
+    {
+        c->idleSinceMs = GetMonotonicMS();
+    }
+    dispatch(*c->host);
+}
+
+void HttpClient::onClose(const TcpConnectionPtr &conn)
+{
+    ConnPtr c = std::static_pointer_cast<Conn>(conn->getContext());
+    if(!c || c->closing)
+    {
+        return;
+    }
+    // 没有长度信息的响应以连接关闭为结束
+    if(!c->inflight.empty() && HttpContext::kExpectBody == c->ctx->state()
+       && c->ctx->finishResponse() && c->ctx->gotAll())
+    {
+        Pending pending = std::move(c->inflight.front());
+        c->inflight.pop_front();
+        HttpResponsePtr resp = c->ctx->response();
+        c->ctx = std::make_shared<HttpContext>();
+        finish(pending, kOk, std::move(resp));
+    }
+    retire(c, kConnectionClosed);
+}
+
+void HttpClient::retire(const ConnPtr &c, Error err)
+{
+    Host &host = *c->host;
+    c->closing = true;
+    auto it = std::find(host.conns.begin(), host.conns.end(), c);
+    if(it != host.conns.end())
+    {
+        host.conns.erase(it);
+    }
+
+    std::deque<Pending> inflight;
+    inflight.swap(c->inflight);
+    // 已收到部分响应的请求不能重发
+    if(!inflight.empty() && HttpContext::kExpectRequestLine != c->ctx->state())
+    {
+        Pending pending = std::move(inflight.front());
+        inflight.pop_front();
+        finish(pending, err, nullptr);
+    }
+    requeueOrFail(host, inflight, err);
+
+    if(c->conn->connected())
+    {
+        c->conn->forceClose();
+    }
+    dispatch(host);
+}
+
+void HttpClient::requeueOrFail(Host &host, std::deque<Pending> &pendings, Error err)
+{
+    const int64_t now = GetMonotonicMS();
+    std::deque<Pending> retry;
+    std::vector<std::pair<Pending, Error>> failed;
+    for(auto &pending : pendings)
+    {
+        if(pending.deadlineMs <= now)
+        {
+            failed.emplace_back(std::move(pending), kTimeout);
+        }
+        else if(pending.idempotent && !pending.retried)
+        {
+            pending.retried = true;
+            ++_stats.retries;
+            retry.push_back(std::move(pending));
+        }
+        else
+        {
+            failed.emplace_back(std::move(pending), err);
+        }
+    }
+    pendings.clear();
+    // 重发的请求排在队首，保持原有顺序
+    host.queue.insert(host.queue.begin(), std::make_move_iterator(retry.begin()), std::make_move_iterator(retry.end()));
+    for(auto &item : failed)
+    {
+        finish(item.first, item.second, nullptr);
+    }
+}
+
+void HttpClient::failQueue(Host &host, Error err)
+{
+    std::deque<Pending> queue;
+    queue.swap(host.queue);
+    for(auto &pending : queue)
+    {
+        finish(pending, err, nullptr);
+    }
+}
+
+void HttpClient::finish(Pending &pending, Error err, HttpResponsePtr response)
+{
+    if(kOk == err)
+    {
+        ++_stats.responses;
+    }
+    else
+    {
+        ++_stats.failures;
+    }
+    ResponseCallBack cb = std::move(pending.cb);
+    if(cb)
+    {
+        cb(Result{err, std::move(response)});
+    }
+}
+
+void HttpClient::ensureTimer()
+{
+    if(_timer)
+    {
+        return;
+    }
+    _timer = _loop->runEvery(_config.timerIntervalMs, [weak = weak_from_this()]() {
+        if(auto self = weak.lock())
+        {
+            self->onTimer();
+        }
+    });
+}
+
+void HttpClient::onTimer()
+{
+    const int64_t now = GetMonotonicMS();
+    // 回调中可能新增主机，先取出节点指针
+    std::vector<Host*> hosts;
+    hosts.reserve(_hosts.size());
+    for(auto &item : _hosts)
+    {
+        hosts.push_back(&item.second);
+    }
+
+    for(Host *host : hosts)
+    {
+        bool connect_timeout = false;
+        for(size_t i = 0; i < host->connecting.size();)
+        {
+            if(now - host->connecting[i].second < _config.connectTimeoutMs)
+            {
+                ++i;
+                continue;
+            }
+            HTTP_F_WARN("HttpClient connect %s timeout!\n", host->key.c_str());
+            host->connecting[i].first->stop();
+            host->connecting.erase(host->connecting.begin() + static_cast<ptrdiff_t>(i));
+            ++_stats.connectFailures;
+            connect_timeout = true;
+        }
+        if(connect_timeout && host->conns.empty() && host->connecting.empty())
+        {
+            failQueue(*host, kConnectFailed);
+        }
+
+        std::deque<Pending> expired;
+        for(auto it = host->queue.begin(); it != host->queue.end();)
+        {
+            if(it->deadlineMs <= now)
+            {
+                expired.push_back(std::move(*it));
+                it = host->queue.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        for(auto &pending : expired)
+        {
+            finish(pending, kTimeout, nullptr);
+        }
+
+        std::vector<ConnPtr> timeout;
+        std::vector<ConnPtr> idle;
+        for(auto &c : host->conns)
+        {
+            if(!c->inflight.empty() && c->inflight.front().deadlineMs <= now)
+            {
+                timeout.push_back(c);
+            }
+            else if(c->inflight.empty() && now - c->idleSinceMs >= _config.idleTimeoutMs)
+            {
+                idle.push_back(c);
+            }
+        }
+        // 响应迟迟不到的连接无法再对上后续响应，只能关闭
+        for(auto &c : timeout)
+        {
+            retire(c, kTimeout);
+        }
+        for(auto &c : idle)
+        {
+            retire(c, kConnectionClosed);
+        }
+    }
+}
+
+}   // http
+}   // kit_muduo
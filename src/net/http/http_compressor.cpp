@@ -0,0 +1,404 @@
+/**
+ * @file http_compressor.cpp
+ * @brief 响应压缩(gzip/deflate)及压缩结果缓存
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 18:20:41
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_compressor.h"
+#include "net/http/http_request.h"
+#include "net/http/http_response.h"
+#include "net/http/http_headers.h"
+#include "net/net_log.h"
+
+#include <zlib.h>
+
+namespace kit_muduo::http {
+
+namespace {
+
+/// @brief q值以千分之一为单位，-1 表示未出现
+constexpr int32_t kQAbsent = -1;
+constexpr int32_t kQMax = 1000;
+
+/**
+ * @brief 解析 "q=0.8" 这样的权重参数，非法时按 1 处理
+ */
+int32_t ParseQValue(std::string_view params)
+{
+    while(!params.empty())
+    {
+        size_t semi = params.find(';');
+        std::string_view param = TrimHttpSpace(params.substr(0, semi));
+        params = std::string_view::npos == semi ? std::string_view() : params.substr(semi + 1);
+        if(param.size() < 2 || ('q' != param[0] && 'Q' != param[0]) || '=' != param[1])
+        {
+            continue;
+        }
+
+        std::string_view value = TrimHttpSpace(param.substr(2));
+        if(value.empty() || ('0' != value[0] && '1' != value[0]))
+        {
+            return kQMax;
+        }
+        int32_t q = ('1' == value[0]) ? kQMax : 0;
+        if('0' == value[0] && value.size() > 2 && '.' == value[1])
+        {
+            int32_t scale = 100;
+            for(size_t i = 2; i < value.size() && i < 5 && value[i] >= '0' && value[i] <= '9'; ++i)
+            {
+                q += (value[i] - '0') * scale;
+                scale /= 10;
+            }
+        }
+        return q;
+    }
+    return kQMax;
+}
+
+std::string EncodedKey(const std::string &key, HttpEncoding encoding)
+{
+    std::string cache_key;
+    cache_key.reserve(key.size() + 8);
+    cache_key.append(HttpEncodingName(encoding)).append(1, ':').append(key);
+    return cache_key;
+}
+
+}
+
+std::string_view HttpEncodingName(HttpEncoding encoding)
+{
+    switch(encoding)
+    {
+        case HttpEncoding::kGzip: return "gzip";
+        case HttpEncoding::kDeflate: return "deflate";
+        default: return std::string_view();
+    }
+}
+
+HttpEncoding NegotiateEncoding(std::string_view acceptEncoding, uint32_t allowed)
+{
+    int32_t gzip_q = kQAbsent;
+    int32_t deflate_q = kQAbsent;
+    int32_t star_q = kQAbsent;
+
+    while(!acceptEncoding.empty())
+    {
+        size_t comma = acceptEncoding.find(',');
+        std::string_view item = acceptEncoding.substr(0, comma);
+        acceptEncoding = std::string_view::npos == comma ? std::string_view() : acceptEncoding.substr(comma + 1);
+
+        size_t semi = item.find(';');
+        std::string_view coding = TrimHttpSpace(item.substr(0, semi));
+        int32_t q = std::string_view::npos == semi ? kQMax : ParseQValue(item.substr(semi + 1));
+
+        if(HeaderNameEquals(coding, "gzip") || HeaderNameEquals(coding, "x-gzip"))
+        {
+            gzip_q = q;
+        }
+        else if(HeaderNameEquals(coding, "deflate"))
+        {
+            deflate_q = q;
+        }
+        else if("*" == coding)
+        {
+            star_q = q;
+        }
+    }
+
+    // 未单独列出的编码取 "*" 的权重
+    if(kQAbsent == gzip_q) gzip_q = star_q;
+    if(kQAbsent == deflate_q) deflate_q = star_q;
+    if(!(allowed & HttpEncodingMask::Gzip)) gzip_q = 0;
+    if(!(allowed & HttpEncodingMask::Deflate)) deflate_q = 0;
+
+    if(gzip_q > 0 && gzip_q >= deflate_q)
+    {
+        return HttpEncoding::kGzip;
+    }
+    if(deflate_q > 0)
+    {
+        return HttpEncoding::kDeflate;
+    }
+    return HttpEncoding::kIdentity;
+}
+
+bool HttpCompress(const char *data, size_t len, HttpEncoding encoding, int32_t level, std::string *out)
+{
+    if(HttpEncoding::kIdentity == encoding)
+    {
+        out->assign(data, len);
+        return true;
+    }
+
+    z_stream stream{};
+    // gzip 封装 windowBits+16；HTTP 的 deflate 指 zlib 格式(RFC 1950)
+    const int window_bits = HttpEncoding::kGzip == encoding ? MAX_WBITS + 16 : MAX_WBITS;
+    if(Z_OK != deflateInit2(&stream, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY))
+    {
+        return false;
+    }
+
+    // deflateBound 未计入 gzip 头尾，额外留 18 字节
+    out->resize(deflateBound(&stream, static_cast<uLong>(len)) + 18);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(len);
+    stream.next_out = reinterpret_cast<Bytef*>(&(*out)[0]);
+    stream.avail_out = static_cast<uInt>(out->size());
+
+    const int ret = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if(Z_STREAM_END != ret)
+    {
+        out->clear();
+        return false;
+    }
+    out->resize(stream.total_out);
+    return true;
+}
+
+std::string VariantETag(std::string_view etag, HttpEncoding encoding)
+{
+    std::string variant(etag);
+    if(variant.size() >= 2 && '"' == variant.back())
+    {
+        variant.insert(variant.size() - 1, std::string("-").append(HttpEncodingName(encoding)));
+    }
+    return variant;
+}
+
+std::string CompressCacheKey(const HttpRequest &req, std::string_view etag, std::string_view vary)
+{
+    if(etag.size() < 2 || '"' != etag.front() || "*" == TrimHttpSpace(vary))
+    {
+        return std::string();
+    }
+
+    // 方法 路径?查询串\n头部: 值\n...\nETag，路径中不会出现换行
+    std::string key = req.method().toString();
+    key.append(1, ' ').append(req.path());
+    if(!req.query().empty())
+    {
+        key.append(1, '?').append(req.query());
+    }
+    while(!vary.empty())
+    {
+        const size_t comma = vary.find(',');
+        const std::string_view name = TrimHttpSpace(vary.substr(0, comma));
+        vary = std::string_view::npos == comma ? std::string_view() : vary.substr(comma + 1);
+        if(!name.empty() && !HeaderNameEquals(name, "Accept-Encoding"))
+        {
+            key.append(1, '\n').append(name).append(": ").append(req.header(name));
+        }
+    }
+    key.append(1, '\n').append(etag);
+    return key;
+}
+
+HttpCompressor::HttpCompressor()
+    :HttpCompressor(Config())
+{
+}
+
+HttpCompressor::HttpCompressor(Config config)
+    :_config(std::move(config))
+{
+}
+
+HttpEncoding HttpCompressor::negotiate(const HttpRequest &req) const
+{
+    const std::string_view accept = req.header(HttpHeaderId::kAcceptEncoding);
+    if(accept.empty() || 0 == _config.encodings)
+    {
+        return HttpEncoding::kIdentity;
+    }
+    return NegotiateEncoding(accept, _config.encodings);
+}
+
+bool HttpCompressor::compressible(std::string_view contentType) const
+{
+    contentType = TrimHttpSpace(contentType.substr(0, contentType.find(';')));
+    for(auto &prefix : _config.mimeTypes)
+    {
+        if(contentType.size() >= prefix.size() && HeaderNameEquals(contentType.substr(0, prefix.size()), prefix))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HttpCompressor::apply(const HttpRequest &req, HttpResponse &resp)
+{
+    if(StateCode::k200Ok != resp.stateCode()()
+        || HttpRequest::Method::kHead == req.method()()
+        || resp.streaming() || !resp.segments().empty() || !resp.serialized().empty()
+        || resp.body().size() < _config.minBytes
+        || resp.headers().has(HttpHeaderId::kContentEncoding))
+    {
+        return false;
+    }
+
+    std::string_view content_type = resp.header(HttpHeaderId::kContentType);
+    if(content_type.empty() && ContentType::kUnknowType != resp.body().contentType()())
+    {
+        content_type = resp.body().contentType().toString();
+    }
+    if(!compressible(content_type))
+    {
+        return false;
+    }
+
+    const std::string_view cache_control = resp.header(HttpHeaderId::kCacheControl);
+    if(std::string_view::npos != cache_control.find("no-transform"))
+    {
+        return false;
+    }
+
+    // 可压缩的表示都随 Accept-Encoding 变化，不压缩时也要告知中间缓存
+    const std::string_view vary = resp.header(HttpHeaderId::kVary);
+    if(std::string_view::npos == vary.find("Accept-Encoding") && "*" != vary)
+    {
+        resp.headers().combine("Vary", "Accept-Encoding");
+    }
+
+    const HttpEncoding encoding = negotiate(req);
+    if(HttpEncoding::kIdentity == encoding)
+    {
+        return false;
+    }
+
+    const std::string etag(resp.header(HttpHeaderId::kETag));
+    const std::string key = CompressCacheKey(req, etag, resp.header(HttpHeaderId::kVary));
+    const std::string_view body = resp.body().view();
+    SharedBuffer compressed = lookup(key, encoding);
+    if(!compressed)
+    {
+        compressed = store(key, encoding, body.data(), body.size());
+    }
+    if(!compressed)
+    {
+        HTTP_F_WARN("compress response failed: %s\n", req.path().c_str());
+        return false;
+    }
+    record(body.size(), compressed->size());
+    if(compressed->size() >= body.size())
+    {
+        return false;
+    }
+
+    if(!etag.empty())
+    {
+        resp.headers().set(HttpHeaderId::kETag, VariantETag(etag, encoding));
+    }
+    resp.headers().set(HttpHeaderId::kContentEncoding, HttpEncodingName(encoding));
+    resp.headers().erase("Content-Length");
+    resp.body().reset();
+    resp.body().appendData(compressed->data(), compressed->size());
+    return true;
+}
+
+SharedBuffer HttpCompressor::lookup(const std::string &key, HttpEncoding encoding)
+{
+    if(key.empty() || 0 == _config.cacheBytes)
+    {
+        return nullptr;
+    }
+
+    const std::string cache_key = EncodedKey(key, encoding);
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _map.find(cache_key);
+    if(it == _map.end())
+    {
+        _misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    _hits.fetch_add(1, std::memory_order_relaxed);
+    _list.splice(_list.begin(), _list, it->second);
+    return it->second->second;
+}
+
+SharedBuffer HttpCompressor::store(const std::string &key, HttpEncoding encoding, const char *data, size_t len)
+{
+    std::string out;
+    if(!HttpCompress(data, len, encoding, _config.level, &out))
+    {
+        return nullptr;
+    }
+    auto result = std::make_shared<const std::string>(std::move(out));
+    // 压不小的结果也缓存，下次直接判定放弃
+    if(!key.empty() && _config.cacheBytes > 0 && result->size() <= _config.maxCacheEntryBytes)
+    {
+        insert(EncodedKey(key, encoding), result);
+    }
+    return result;
+}
+
+void HttpCompressor::record(size_t bytesIn, size_t bytesOut)
+{
+    if(bytesOut >= bytesIn)
+    {
+        _incompressible.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    _compressed.fetch_add(1, std::memory_order_relaxed);
+    _bytesIn.fetch_add(bytesIn, std::memory_order_relaxed);
+    _bytesOut.fetch_add(bytesOut, std::memory_order_relaxed);
+}
+
+void HttpCompressor::insert(const std::string &key, SharedBuffer value)
+{
+    const size_t bytes = key.size() + value->size();
+    if(bytes > _config.cacheBytes)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _map.find(key);
+    if(it != _map.end())
+    {
+        // 并发压缩同一内容时保留先到的结果
+        return;
+    }
+    _list.emplace_front(key, std::move(value));
+    _map.emplace(key, _list.begin());
+    _bytes += bytes;
+
+    while(_bytes > _config.cacheBytes && !_list.empty())
+    {
+        auto &victim = _list.back();
+        _bytes -= victim.first.size() + victim.second->size();
+        _map.erase(victim.first);
+        _list.pop_back();
+        _evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void HttpCompressor::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _list.clear();
+    _map.clear();
+    _bytes = 0;
+}
+
+HttpCompressor::Stats HttpCompressor::stats() const
+{
+    Stats stats;
+    stats.compressed = _compressed.load(std::memory_order_relaxed);
+    stats.incompressible = _incompressible.load(std::memory_order_relaxed);
+    stats.cache_hits = _hits.load(std::memory_order_relaxed);
+    stats.cache_misses = _misses.load(std::memory_order_relaxed);
+    stats.evictions = _evictions.load(std::memory_order_relaxed);
+    stats.bytes_in = _bytesIn.load(std::memory_order_relaxed);
+    stats.bytes_out = _bytesOut.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    stats.cache_bytes = _bytes;
+    stats.cache_entries = _map.size();
+    return stats;
+}
+
+}   // kit_muduo::http
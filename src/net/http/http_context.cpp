@@ -20,17 +20,80 @@
 namespace kit_muduo {
 namespace http {
 
-HttpContext::HttpContext()
+HttpContext::HttpContext(ParserType parserType)
     :_state(kExpectRequestLine)
     ,_request(std::make_shared<HttpRequest>())
     ,_response(std::make_shared<HttpResponse>())
-    ,_parser(std::make_shared<LLhttpParser>(this)) 
 {
+    if(kCustomParser == parserType)
+    {
+        _parser = std::make_shared<CustomHttpParser>(this);
+    }
+    else
+    {
+        _parser = std::make_shared<LLhttpParser>(this);
+    }
     HTTP_DEBUG() << "HttpContext constructor " << this << std::endl;
 }
 HttpContext::~HttpContext()
 {
     HTTP_DEBUG()  << "~HttpContext " << this << std::endl;
+    if(_bodySink && !_bodyCompleted)
+    {
+        _bodySink->onAbort();
+    }
+}
+
+void HttpContext::onHeadersComplete(bool hasBody)
+{
+    if(hasBody && !_bodySink && _bodySinkResolver)
+    {
+        _bodySink = _bodySinkResolver(shared_from_this());
+    }
+}
+
+bool HttpContext::onBodyData(const char *data, size_t len)
+{
+    if(_bodySink)
+    {
+        return _bodySink->onData(data, len);
+    }
+
+    _request->body().appendData(data, len);
+    return true;
+}
+
+bool HttpContext::onBodyComplete()
+{
+    if(!_bodySink || _bodyCompleted)
+    {
+        return true;
+    }
+
+    _bodyCompleted = true;
+    if(!_bodySink->onComplete())
+    {
+        HTTP_F_WARN("body sink complete failed! path[%s], received[%llu]\n",
+                    _request->path().c_str(), static_cast<unsigned long long>(_bodySink->receivedBytes()));
+        return false;
+    }
+    return true;
+}
+
+bool HttpContext::onResponseBodyData(const char *data, size_t len)
+{
+    if(_responseBodySink)
+    {
+        return _responseBodySink->onData(data, len);
+    }
+
+    _response->body().appendData(data, len);
+    return true;
+}
+
+bool HttpContext::onResponseBodyComplete()
+{
+    return !_responseBodySink || _responseBodySink->onComplete();
 }
 
 // 有限状态机 解析
@@ -70,6 +133,12 @@ bool HttpContext::parseResponse(Buffer &buf, TimeStamp receiveTime)
     return ok;
 }
 
+bool HttpContext::finishResponse()
+{
+    _parser->setType(HttpParser::RespType);
+    return _parser->finish();
+}
+
 bool HttpContext::parseResponse(const std::string &data, TimeStamp receiveTime)
 {
     _parser->setType(HttpParser::RespType);
@@ -10,15 +10,16 @@
 #include "net/http/http_context.h"
 #include "net/http/http_request.h"
 #include "net/http/http_response.h"
+#include "net/http/http_scanner.h"
 #include "net/buffer.h"
 #include "net/net_log.h"
 #include "net/call_backs.h"
 
+#include <cstdlib>
+
 namespace kit_muduo {
 namespace http {
 
-static const char kCRLF[] = "\r\n";
-
 bool CustomHttpParser::parse(const std::string &data)
 {
     Buffer buf;
@@ -42,7 +43,7 @@ bool CustomHttpParser::parse(Buffer &buf)
     {
         if(HttpContext::kExpectRequestLine == _context->state())
         {
-            const char* crlf_pos = findCRLF(buf);
+            const char* crlf_pos = HttpFindCRLF(buf.peek(), buf.beginWrite());
             if(!crlf_pos)
             {
                 HTTP_DEBUG() << "not findCRLF" << "\n";
@@ -60,19 +61,29 @@ bool CustomHttpParser::parse(Buffer &buf)
         }
         else if(HttpContext::kExpectHeaders == _context->state())
         {
-            const char* crlf_pos = findCRLF(buf);
+            // 一次扫描同时定位 ':' 与 '\r'，'\r' 在前说明本行没有冒号
+            const char *start = buf.peek();
+            const char *end = buf.beginWrite();
+            const char *delim = HttpFindEither(start, end, ':', '\r');
+            const char *crlf_pos = nullptr;
+            if(delim && ':' == *delim)
+            {
+                crlf_pos = HttpFindCRLF(delim + 1, end);
+            }
+            else if(delim && delim + 1 < end)
+            {
+                crlf_pos = '\n' == delim[1] ? delim : HttpFindCRLF(delim + 1, end);
+            }
             if(!crlf_pos)
             {
                 HTTP_DEBUG() << "not findCRLF" << "\n";
                 has_more = false;
                 continue;
             }
-            const char *start = buf.peek();
-            const char *colon = std::find(start, crlf_pos, ':');
-            if(colon == crlf_pos)
+            if(':' != *delim)
             {
                 // 是否是空行
-                if(strncmp(buf.peek(), kCRLF, 2) == 0)
+                if(crlf_pos == start)
                 {
                     HTTP_INFO() << "http header parse ok" << "\n";
                     buf.reset(2);
@@ -80,14 +91,14 @@ bool CustomHttpParser::parse(Buffer &buf)
                     std::string content_len_str;
                     if(ReqType == _type)
                     {
-                        content_len_str = request->getHeader("Content-Length");
+                        content_len_str = request->header(HttpHeaderId::kContentLength);
                     }
                     else if(RespType == _type)
                     {
-                        content_len_str = response->getHeader("Content-Length");
+                        content_len_str = response->header(HttpHeaderId::kContentLength);
                     }
 
-                    read_len_ = expected_body_len_ = atoi(content_len_str.c_str());
+                    read_len_ = expected_body_len_ = std::strtoull(content_len_str.c_str(), nullptr, 10);
 
                     if(expected_body_len_ <= 0 || content_len_str.empty())
                     {
@@ -99,16 +110,20 @@ bool CustomHttpParser::parse(Buffer &buf)
 
                     if(ReqType == _type)
                     {
-                        const std::string& content_type_str = request->getHeader("Content-Type");
+                        const std::string content_type_str(request->header(HttpHeaderId::kContentType));
                         request->body().setContentType(http::ContentType::FromString(content_type_str));
                     }
                     else if(RespType == _type)
                     {
-                        const std::string& content_type_str = response->getHeader("Content-Type");
+                        const std::string content_type_str(response->header(HttpHeaderId::kContentType));
                         response->body().setContentType(http::ContentType::FromString(content_type_str));
                     }
 
                     _context->setState(HttpContext::kExpectBody);
+                    if(ReqType == _type)
+                    {
+                        _context->onHeadersComplete(true);
+                    }
                 }
                 else
                 {
@@ -120,26 +135,44 @@ bool CustomHttpParser::parse(Buffer &buf)
             }
             if(ReqType == _type)
             {
-                request->addHeader(buf.peek(), colon, crlf_pos);
+                request->addHeader(start, delim, crlf_pos);
             }
             else if(RespType == _type)
             {
-                response->addHeader(buf.peek(), colon, crlf_pos);
+                response->addHeader(start, delim, crlf_pos);
             }
             buf.reset(crlf_pos + 2 - buf.peek());
         }
         else if(HttpContext::kExpectBody == _context->state())
         {
+            if(0 == buf.readableBytes())
+            {
+                // Body 尚未到达，等待下次数据
+                has_more = false;
+                continue;
+            }
             size_t min_len = std::min(read_len_, buf.readableBytes());
             read_len_ -= min_len;
 
             if(ReqType == _type)
             {
-                request->body().appendData(buf.peek(), min_len);
+                if(!_context->onBodyData(buf.peek(), min_len))
+                {
+                    HTTP_ERROR() << "body sink rejected data" << "\n";
+                    ok = false;
+                    has_more = false;
+                    continue;
+                }
             }
             else if(RespType == _type)
             {
-                response->body().appendData(buf.peek(), min_len);
+                if(!_context->onResponseBodyData(buf.peek(), min_len))
+                {
+                    HTTP_ERROR() << "response body sink rejected data" << "\n";
+                    ok = false;
+                    has_more = false;
+                    continue;
+                }
             }
 
             buf.reset(min_len);
@@ -150,6 +183,14 @@ bool CustomHttpParser::parse(Buffer &buf)
                 expected_body_len_ = read_len_ = 0;
                 has_more = false;
                 _context->setState(HttpContext::kGotAll);
+                if(ReqType == _type && !_context->onBodyComplete())
+                {
+                    ok = false;
+                }
+                else if(RespType == _type && !_context->onResponseBodyComplete())
+                {
+                    ok = false;
+                }
             }
         }
     }
@@ -164,8 +205,8 @@ bool CustomHttpParser::processRequestLine(const char *start, const char *end)
     HttpResponsePtr response = _context->response();
 
     // 第一个字段: method（请求） / version（响应）
-    const char *space_pos = std::find(start, end, ' ');
-    if(space_pos == end)
+    const char *space_pos = HttpFindByte(start, end, ' ');
+    if(!space_pos)
     {
         HTTP_F_ERROR("http parse first line error! %s \n", start);
         return false;
@@ -200,7 +241,11 @@ bool CustomHttpParser::processRequestLine(const char *start, const char *end)
 
     // 第二个字段: path（请求） / status code（响应）
     start = space_pos + 1;
-    space_pos = std::find(start, end, ' ');
+    space_pos = HttpFindByte(start, end, ' ');
+    if(!space_pos)
+    {
+        space_pos = end;
+    }
 
     std::string tmp_str{start, space_pos};
     DelSpaceHelper(tmp_str);
@@ -212,7 +257,7 @@ bool CustomHttpParser::processRequestLine(const char *start, const char *end)
             HTTP_F_ERROR("http request parse 'path' error! %s \n", start);
             return false;
         }
-        request->setPath(tmp_str);
+        parseUrl(tmp_str, request);
         HTTP_DEBUG() << "Path:|" << tmp_str << "|" << "\n";
 
         // 第三个字段: version（请求）
@@ -234,18 +279,6 @@ bool CustomHttpParser::processRequestLine(const char *start, const char *end)
     return true;
 }
 
-const char* CustomHttpParser::findCRLF(Buffer &buf) const
-{
-    return findCRLF(buf.peek(), buf.beginWrite());
-}
-
-const char* CustomHttpParser::findCRLF(const char *start, const char *end) const
-{
-    std::string crlf{"\r\n"};
-    auto pos = std::search(start, end, crlf.begin(), crlf.end());
-    return pos == end ? nullptr : pos;
-}
-
 
 }
 }   //kit_muduo
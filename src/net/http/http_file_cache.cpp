@@ -0,0 +1,125 @@
+/**
+ * @file http_file_cache.cpp
+ * @brief 静态文件描述符缓存
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 10:40:21
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_file_cache.h"
+#include "net/http/http_util.h"
+#include "net/net_log.h"
+
+#include <sys/stat.h>
+#include <chrono>
+#include <cstdio>
+#include <cerrno>
+
+namespace kit_muduo::http {
+
+namespace {
+
+int64_t NowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+HttpFileCache::HttpFileCache(size_t capacity, int32_t revalidateMs)
+    :_cache(capacity)
+    ,_revalidateMs(revalidateMs)
+{
+}
+
+std::string HttpFileCache::MakeETag(const SharedFile &file)
+{
+    char buf[64] = {0};
+    int n = ::snprintf(buf, sizeof(buf), "\"%lx-%lx-%lx\"",
+                       static_cast<unsigned long>(file.inode()),
+                       static_cast<unsigned long>(file.size()),
+                       static_cast<unsigned long>(file.mtimeNs()));
+    return std::string(buf, n);
+}
+
+HttpFileCache::EntryPtr HttpFileCache::get(const std::string &path, int32_t *err)
+{
+    int64_t now_ms = NowMs();
+    EntryPtr entry;
+    if(_cache.tryGet(path, entry))
+    {
+        if(now_ms - entry->checked_ms.load(std::memory_order_relaxed) < _revalidateMs)
+        {
+            ++_hits;
+            if(!entry->file)
+            {
+                if(err)
+                {
+                    *err = entry->err;
+                }
+                return nullptr;
+            }
+            return entry;
+        }
+
+        // 过期后校验元数据，未变化则继续复用描述符；负缓存条目直接重新打开
+        struct stat st;
+        if(entry->file && ::stat(path.c_str(), &st) == 0
+            && S_ISREG(st.st_mode)
+            && static_cast<uint64_t>(st.st_ino) == entry->file->inode()
+            && static_cast<uint64_t>(st.st_dev) == entry->file->device()
+            && static_cast<uint64_t>(st.st_size) == entry->file->size()
+            && static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec == entry->file->mtimeNs())
+        {
+            entry->checked_ms.store(now_ms, std::memory_order_relaxed);
+            ++_hits;
+            return entry;
+        }
+
+        HTTP_F_DEBUG("file cache stale: %s\n", path.c_str());
+        _cache.erase(path);
+    }
+
+    ++_misses;
+    return open(path, now_ms, err);
+}
+
+void HttpFileCache::invalidate(const std::string &path)
+{
+    _cache.erase(path);
+}
+
+HttpFileCache::EntryPtr HttpFileCache::open(const std::string &path, int64_t nowMs, int32_t *err)
+{
+    int32_t open_err = 0;
+    SharedFilePtr file = SharedFile::Open(path, &open_err);
+    if(!file)
+    {
+        if(err)
+        {
+            *err = open_err;
+        }
+        // 只缓存"不存在"，权限、描述符耗尽等错误可能很快恢复
+        if(ENOENT == open_err || ENOTDIR == open_err)
+        {
+            auto missing = std::make_shared<Entry>();
+            missing->err = open_err;
+            missing->checked_ms.store(nowMs, std::memory_order_relaxed);
+            _cache.put(path, missing);
+        }
+        return nullptr;
+    }
+
+    auto entry = std::make_shared<Entry>();
+    entry->file = file;
+    entry->etag = MakeETag(*file);
+    entry->mtime = static_cast<time_t>(file->mtimeNs() / 1000000000LL);
+    entry->last_modified = FormatHttpDate(entry->mtime);
+    entry->checked_ms.store(nowMs, std::memory_order_relaxed);
+
+    _cache.put(path, entry);
+    return entry;
+}
+
+}   // kit_muduo::http
@@ -0,0 +1,141 @@
+/**
+ * @file http_header_cache.cpp
+ * @brief 响应头预渲染片段与 Date 头缓存
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 17:35:10
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_header_cache.h"
+#include "net/http/http_util.h"
+
+#include <array>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <string>
+
+namespace kit_muduo::http {
+
+namespace {
+
+constexpr std::string_view kKeepAliveFragment = "Connection: keep-alive\r\nKeep-Alive: timeout=5, max=100\r\n";
+constexpr std::string_view kCloseFragment = "Connection: close\r\n";
+
+struct ContentTypeFragments
+{
+    std::array<std::string, ContentType::kMax> lines;
+
+    ContentTypeFragments()
+    {
+        for(int32_t type = ContentType::kUnknowType + 1; type < ContentType::kMax; ++type)
+        {
+            std::string &line = lines[type];
+            line = "Content-Type: ";
+            line += ContentType(type).toString();
+            // 默认字符集 utf-8
+            line += "; charset=utf-8";
+            if(ContentType::kMultiForm == type)
+            {
+                line += "; boundary=----WebKitFormBoundaryNQJ0YrO2NeaUfM7n";
+            }
+            line += "\r\n";
+        }
+    }
+};
+
+/// @brief 已发布的 Date 块，写入受 s_mutex 保护，读者按 s_generation 判断是否需要重取
+std::mutex s_mutex;
+SharedBuffer s_block;
+std::atomic<uint64_t> s_generation{0};
+std::atomic<int64_t> s_second{0};
+std::atomic<int32_t> s_drivers{0};
+
+struct ThreadDateCache
+{
+    uint64_t generation{std::numeric_limits<uint64_t>::max()};
+    SharedBuffer block;
+};
+thread_local ThreadDateCache t_cache;
+
+}
+
+std::string_view HttpConnectionFragment(bool keepAlive)
+{
+    return keepAlive ? kKeepAliveFragment : kCloseFragment;
+}
+
+std::string_view HttpContentTypeFragment(int32_t contentType)
+{
+    static const ContentTypeFragments s_fragments;
+    if(contentType <= ContentType::kUnknowType || contentType >= ContentType::kMax)
+    {
+        return std::string_view();
+    }
+    return s_fragments.lines[contentType];
+}
+
+void HttpDateCache::Refresh(time_t now)
+{
+    if(static_cast<int64_t>(now) <= s_second.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    std::string block = "Date: ";
+    block += FormatHttpDate(now);
+    block += "\r\n\r\n";
+    auto shared = std::make_shared<const std::string>(std::move(block));
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    // 多个线程同时刷新时后拿到锁的可能是较早的秒，不能让 Date 倒退
+    if(static_cast<int64_t>(now) <= s_second.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    s_block = std::move(shared);
+    s_second.store(static_cast<int64_t>(now), std::memory_order_relaxed);
+    s_generation.fetch_add(1, std::memory_order_release);
+}
+
+void HttpDateCache::Retain()
+{
+    Refresh(::time(nullptr));
+    s_drivers.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HttpDateCache::Release()
+{
+    s_drivers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+const SharedBuffer& HttpDateCache::Current()
+{
+    // 没有定时器驱动(如单独使用 HttpResponse)时自行按秒刷新
+    if(0 == s_drivers.load(std::memory_order_relaxed) || 0 == s_second.load(std::memory_order_relaxed))
+    {
+        Refresh(::time(nullptr));
+    }
+
+    const uint64_t generation = s_generation.load(std::memory_order_acquire);
+    if(generation != t_cache.generation)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        t_cache.block = s_block;
+        t_cache.generation = s_generation.load(std::memory_order_relaxed);
+    }
+    return t_cache.block;
+}
+
+std::string_view HttpDateCache::DateLine()
+{
+    const SharedBuffer &block = Current();
+    // 去掉结尾的空行
+    return std::string_view(block->data(), block->size() - 2);
+}
+
+SharedBuffer HttpDateCache::DateBlock()
+{
+    return Current();
+}
+
+}   // kit_muduo::http
@@ -0,0 +1,451 @@
+/**
+ * @file http_headers.cpp
+ * @brief HTTP头部容器(大小写不敏感、小容量内联存储)
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 14:20:45
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_headers.h"
+
+#include <array>
+#include <vector>
+
+namespace kit_muduo::http {
+
+namespace {
+
+constexpr size_t kHeaderIdCount = static_cast<size_t>(HttpHeaderId::kMax);
+/// @brief 驻留名称的最大长度(Transfer-Encoding/If-Modified-Since 为17)
+constexpr size_t kMaxInternedLength = 32;
+/// @brief 下标超出 uint8_t 表示范围时的哨兵，查找退化为线性扫描
+constexpr uint8_t kIndexOverflow = 0xFF;
+
+constexpr std::array<std::string_view, kHeaderIdCount> kHeaderNames = {
+    "",
+    "Accept",
+    "Accept-Encoding",
+    "Accept-Language",
+    "Accept-Ranges",
+    "Allow",
+    "Authorization",
+    "Cache-Control",
+    "Connection",
+    "Content-Encoding",
+    "Content-Length",
+    "Content-Range",
+    "Content-Type",
+    "Cookie",
+    "Date",
+    "ETag",
+    "Expect",
+    "Host",
+    "If-Modified-Since",
+    "If-None-Match",
+    "If-Range",
+    "Keep-Alive",
+    "Last-Modified",
+    "Location",
+    "Range",
+    "Server",
+    "Set-Cookie",
+    "Transfer-Encoding",
+    "Upgrade",
+    "User-Agent",
+    "Vary",
+};
+
+inline char ToLower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+}
+
+/// @brief 按名称长度分桶，查找时只比较同长度的候选
+struct HeaderIdTable
+{
+    std::array<std::vector<HttpHeaderId>, kMaxInternedLength + 1> buckets;
+
+    HeaderIdTable()
+    {
+        for(size_t i = 1; i < kHeaderIdCount; ++i)
+        {
+            buckets[kHeaderNames[i].size()].push_back(static_cast<HttpHeaderId>(i));
+        }
+    }
+};
+
+const HeaderIdTable& IdTable()
+{
+    static const HeaderIdTable s_table;
+    return s_table;
+}
+
+}
+
+std::string_view HttpHeaderName(HttpHeaderId id)
+{
+    size_t idx = static_cast<size_t>(id);
+    return idx < kHeaderIdCount ? kHeaderNames[idx] : std::string_view();
+}
+
+bool HeaderNameEquals(std::string_view a, std::string_view b)
+{
+    if(a.size() != b.size())
+    {
+        return false;
+    }
+    for(size_t i = 0; i < a.size(); ++i)
+    {
+        if(ToLower(a[i]) != ToLower(b[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string_view TrimHttpSpace(std::string_view str)
+{
+    size_t begin = 0;
+    size_t end = str.size();
+    while(begin < end && (' ' == str[begin] || '\t' == str[begin]))
+    {
+        ++begin;
+    }
+    while(end > begin && (' ' == str[end - 1] || '\t' == str[end - 1]))
+    {
+        --end;
+    }
+    return str.substr(begin, end - begin);
+}
+
+bool HeaderHasToken(std::string_view value, std::string_view token)
+{
+    while(!value.empty())
+    {
+        const size_t comma = value.find(',');
+        if(HeaderNameEquals(TrimHttpSpace(value.substr(0, comma)), token))
+        {
+            return true;
+        }
+        if(std::string_view::npos == comma)
+        {
+            break;
+        }
+        value.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+HttpHeaderId LookupHttpHeaderId(std::string_view name)
+{
+    if(name.size() > kMaxInternedLength)
+    {
+        return HttpHeaderId::kUnknown;
+    }
+    for(HttpHeaderId id : IdTable().buckets[name.size()])
+    {
+        if(HeaderNameEquals(kHeaderNames[static_cast<size_t>(id)], name))
+        {
+            return id;
+        }
+    }
+    return HttpHeaderId::kUnknown;
+}
+
+HttpHeaders::HttpHeaders()
+    :_data(inlineData())
+    ,_size(0)
+    ,_capacity(kInlineCapacity)
+{
+    std::memset(_index, 0, sizeof(_index));
+}
+
+HttpHeaders::~HttpHeaders()
+{
+    destroyAll();
+}
+
+HttpHeaders::HttpHeaders(const HttpHeaders &other)
+    :HttpHeaders()
+{
+    copyFrom(other);
+}
+
+HttpHeaders::HttpHeaders(HttpHeaders &&other) noexcept
+    :HttpHeaders()
+{
+    moveFrom(other);
+}
+
+HttpHeaders& HttpHeaders::operator=(const HttpHeaders &other)
+{
+    if(this != &other)
+    {
+        clear();
+        copyFrom(other);
+    }
+    return *this;
+}
+
+HttpHeaders& HttpHeaders::operator=(HttpHeaders &&other) noexcept
+{
+    if(this != &other)
+    {
+        destroyAll();
+        _data = inlineData();
+        _size = 0;
+        _capacity = kInlineCapacity;
+        moveFrom(other);
+    }
+    return *this;
+}
+
+void HttpHeaders::clear()
+{
+    for(size_t i = 0; i < _size; ++i)
+    {
+        _data[i].~Entry();
+    }
+    _size = 0;
+    std::memset(_index, 0, sizeof(_index));
+}
+
+HttpHeaders::const_iterator HttpHeaders::find(HttpHeaderId id) const
+{
+    if(HttpHeaderId::kUnknown == id)
+    {
+        return end();
+    }
+    uint8_t pos = _index[static_cast<size_t>(id)];
+    if(0 == pos)
+    {
+        return end();
+    }
+    if(kIndexOverflow != pos)
+    {
+        return _data + pos - 1;
+    }
+    for(const Entry &entry : *this)
+    {
+        if(entry.id == id)
+        {
+            return &entry;
+        }
+    }
+    return end();
+}
+
+HttpHeaders::const_iterator HttpHeaders::find(std::string_view name) const
+{
+    HttpHeaderId id = LookupHttpHeaderId(name);
+    if(HttpHeaderId::kUnknown != id)
+    {
+        return find(id);
+    }
+    Entry *entry = findUnknown(name);
+    return entry ? entry : end();
+}
+
+std::string_view HttpHeaders::get(std::string_view name) const
+{
+    auto it = find(name);
+    return it == end() ? std::string_view() : std::string_view(it->second);
+}
+
+std::string_view HttpHeaders::get(HttpHeaderId id) const
+{
+    auto it = find(id);
+    return it == end() ? std::string_view() : std::string_view(it->second);
+}
+
+void HttpHeaders::set(std::string_view name, std::string_view value)
+{
+    HttpHeaderId id = LookupHttpHeaderId(name);
+    Entry *entry = HttpHeaderId::kUnknown == id
+        ? findUnknown(name)
+        : const_cast<Entry*>(find(id));
+    if(entry && entry != end())
+    {
+        entry->second.assign(value.data(), value.size());
+        return;
+    }
+    append(name, value, id);
+}
+
+void HttpHeaders::set(HttpHeaderId id, std::string_view value)
+{
+    auto it = find(id);
+    if(it != end())
+    {
+        const_cast<Entry*>(it)->second.assign(value.data(), value.size());
+        return;
+    }
+    append(HttpHeaderName(id), value, id);
+}
+
+void HttpHeaders::add(std::string_view name, std::string_view value)
+{
+    append(name, value, LookupHttpHeaderId(name));
+}
+
+void HttpHeaders::combine(std::string_view name, std::string_view value)
+{
+    HttpHeaderId id = LookupHttpHeaderId(name);
+    Entry *entry = HttpHeaderId::kUnknown == id
+        ? findUnknown(name)
+        : const_cast<Entry*>(find(id));
+    if(entry && entry != end())
+    {
+        entry->second.append(", ");
+        entry->second.append(value.data(), value.size());
+        return;
+    }
+    append(name, value, id);
+}
+
+size_t HttpHeaders::erase(std::string_view name)
+{
+    size_t removed = 0;
+    size_t write = 0;
+    for(size_t read = 0; read < _size; ++read)
+    {
+        if(HeaderNameEquals(_data[read].first, name))
+        {
+            ++removed;
+            continue;
+        }
+        if(write != read)
+        {
+            _data[write] = std::move(_data[read]);
+        }
+        ++write;
+    }
+    for(size_t i = write; i < _size; ++i)
+    {
+        _data[i].~Entry();
+    }
+    _size = write;
+    if(removed > 0)
+    {
+        rebuildIndex();
+    }
+    return removed;
+}
+
+HttpHeaders::Entry& HttpHeaders::append(std::string_view name, std::string_view value, HttpHeaderId id)
+{
+    if(_size == _capacity)
+    {
+        grow();
+    }
+    Entry *entry = new (_data + _size) Entry();
+    entry->first.assign(name.data(), name.size());
+    entry->second.assign(value.data(), value.size());
+    entry->id = id;
+    ++_size;
+
+    if(HttpHeaderId::kUnknown != id)
+    {
+        uint8_t &pos = _index[static_cast<size_t>(id)];
+        if(0 == pos)
+        {
+            pos = _size < kIndexOverflow ? static_cast<uint8_t>(_size) : kIndexOverflow;
+        }
+    }
+    return *entry;
+}
+
+void HttpHeaders::grow()
+{
+    size_t new_capacity = _capacity * 2;
+    Entry *new_data = static_cast<Entry*>(::operator new(sizeof(Entry) * new_capacity));
+    for(size_t i = 0; i < _size; ++i)
+    {
+        new (new_data + i) Entry(std::move(_data[i]));
+        _data[i].~Entry();
+    }
+    if(!isInline())
+    {
+        ::operator delete(_data);
+    }
+    _data = new_data;
+    _capacity = new_capacity;
+}
+
+void HttpHeaders::destroyAll()
+{
+    for(size_t i = 0; i < _size; ++i)
+    {
+        _data[i].~Entry();
+    }
+    if(!isInline())
+    {
+        ::operator delete(_data);
+    }
+    _size = 0;
+}
+
+void HttpHeaders::rebuildIndex()
+{
+    std::memset(_index, 0, sizeof(_index));
+    for(size_t i = 0; i < _size; ++i)
+    {
+        if(HttpHeaderId::kUnknown == _data[i].id)
+        {
+            continue;
+        }
+        uint8_t &pos = _index[static_cast<size_t>(_data[i].id)];
+        if(0 == pos)
+        {
+            pos = i + 1 < kIndexOverflow ? static_cast<uint8_t>(i + 1) : kIndexOverflow;
+        }
+    }
+}
+
+void HttpHeaders::copyFrom(const HttpHeaders &other)
+{
+    for(const Entry &entry : other)
+    {
+        append(entry.first, entry.second, entry.id);
+    }
+}
+
+void HttpHeaders::moveFrom(HttpHeaders &other)
+{
+    if(other.isInline())
+    {
+        // 内联存储只能逐个搬移
+        for(size_t i = 0; i < other._size; ++i)
+        {
+            new (_data + i) Entry(std::move(other._data[i]));
+        }
+        _size = other._size;
+        std::memcpy(_index, other._index, sizeof(_index));
+        other.clear();
+        return;
+    }
+
+    _data = other._data;
+    _size = other._size;
+    _capacity = other._capacity;
+    std::memcpy(_index, other._index, sizeof(_index));
+    other._data = other.inlineData();
+    other._size = 0;
+    other._capacity = kInlineCapacity;
+    std::memset(other._index, 0, sizeof(other._index));
+}
+
+HttpHeaders::Entry* HttpHeaders::findUnknown(std::string_view name) const
+{
+    for(size_t i = 0; i < _size; ++i)
+    {
+        if(HttpHeaderId::kUnknown == _data[i].id && HeaderNameEquals(_data[i].first, name))
+        {
+            return _data + i;
+        }
+    }
+    return nullptr;
+}
+
+}   // kit_muduo::http
@@ -74,11 +74,14 @@ LLhttpParser::LLhttpParser(HttpContext *context)
 {
     llhttp_settings_init(&_settings);
     _settings.on_method = &LLhttpParser::onMethod;
+    _settings.on_method_complete = &LLhttpParser::onMethodComplete;
     _settings.on_status = &LLhttpParser::onStatus;
     _settings.on_status_complete = &LLhttpParser::onStatusComplete;
     _settings.on_url = &LLhttpParser::onUrl;
     _settings.on_url_complete = &LLhttpParser::onUrlComplete;
+    _settings.on_protocol = &LLhttpParser::onProtocol;
     _settings.on_version = &LLhttpParser::onVersion;
+    _settings.on_version_complete = &LLhttpParser::onVersionComplete;
     _settings.on_header_field = &LLhttpParser::onHeaderField;
     _settings.on_header_value = &LLhttpParser::onHeaderValue;
     _settings.on_headers_complete = &LLhttpParser::onHeadersComplete;
@@ -142,15 +145,29 @@ bool LLhttpParser::parse(Buffer &buf)
     return false;
 }
 
+bool LLhttpParser::finish()
+{
+    // 已解析完整的报文处于暂停状态，llhttp_finish 直接返回 HPE_OK
+    const llhttp_errno err = llhttp_finish(&_parser);
+    return HPE_OK == err || HPE_PAUSED == err;
+}
+
 int LLhttpParser::onMethod(llhttp_t* parser, const char *data, size_t len)
+{
+    LLhttpParser* parser_ptr = static_cast<LLhttpParser*>(parser->data);
+    // 方法名可能跨越多次 parse 分段到达，完整后再设置
+    parser_ptr->_headerCtx.method.append(data, len);
+    return 0;
+}
+
+int LLhttpParser::onMethodComplete(llhttp_t* parser)
 {
     LLhttpParser* parser_ptr = static_cast<LLhttpParser*>(parser->data);
     HttpRequestPtr request = parser_ptr->_context->request();
+    const std::string &method = parser_ptr->_headerCtx.method;
+    HTTP_DEBUG() << "method: " << method << std::endl;
 
-    const std::string &s = std::string(data, len);
-    HTTP_DEBUG() << "method: " << s << std::endl;
-    
-    request->setMethod(HttpRequest::Method::FromString(s));
+    request->setMethod(HttpRequest::Method::FromString(method));
     return 0;
 }
 
@@ -193,7 +210,7 @@ int LLhttpParser::onUrl(llhttp_t* parser, const char *data, size_t len)
     return 0;
 }
 
-void LLhttpParser::parseQueryParams(const std::string &query, const HttpRequestPtr &request)
+void HttpParser::parseQueryParams(const std::string &query, const HttpRequestPtr &request)
 {
     size_t start = 0;
     while(start <= query.size())
@@ -233,13 +250,14 @@ void LLhttpParser::parseQueryParams(const std::string &query, const HttpRequestP
     }
 }
 
-void LLhttpParser::parseUrl(const std::string &url, const HttpRequestPtr &request)
+void HttpParser::parseUrl(const std::string &url, const HttpRequestPtr &request)
 {
     const size_t query_pos = url.find('?');
     if(query_pos != std::string::npos)
     {
         request->setPath(url.substr(0, query_pos));
-        parseQueryParams(url.substr(query_pos + 1), request);
+        request->setQuery(url.substr(query_pos + 1));
+        parseQueryParams(request->query(), request);
     }
     else
     {
@@ -257,20 +275,17 @@ int LLhttpParser::onUrlComplete(llhttp_t* parser)
     return 0;
 }
 
-int LLhttpParser::onVersion(llhttp_t* parser, const char *data, size_t len)
+int LLhttpParser::onProtocol(llhttp_t* parser, const char *data, size_t len)
 {
     LLhttpParser* parser_ptr = static_cast<LLhttpParser*>(parser->data);
-    HttpRequestPtr request = parser_ptr->_context->request();
-    HttpResponsePtr response = parser_ptr->_context->response();
-
-    std::string s = "HTTP/";
-    s += std::string(data, len);
-    HTTP_DEBUG() << "version: " << s << std::endl;
+    parser_ptr->_headerCtx.protocol.append(data, len);
+    return 0;
+}
 
-    if(ReqType == parser_ptr->_type)
-        request->setVersion(Version::FromString(s));
-    else
-        response->setVersion(Version::FromString(s));
+int LLhttpParser::onVersion(llhttp_t* parser, const char *data, size_t len)
+{
+    LLhttpParser* parser_ptr = static_cast<LLhttpParser*>(parser->data);
+    parser_ptr->_headerCtx.version.append(data, len);
     return 0;
 }
 
@@ -278,6 +293,17 @@ int LLhttpParser::onVersion(llhttp_t* parser, const char *data, size_t len)
 int LLhttpParser::onVersionComplete(llhttp_t* parser)
 {
     LLhttpParser* parser_ptr = static_cast<LLhttpParser*>(parser->data);
+    HttpRequestPtr request = parser_ptr->_context->request();
+    HttpResponsePtr response = parser_ptr->_context->response();
+
+    // llhttp 的 RTSP 请求/响应同样走这里，协议名单独回调
+    const std::string &protocol = parser_ptr->_headerCtx.protocol;
+    const Version version = Version::FromString((protocol.empty() ? std::string("HTTP") : protocol) + "/" + parser_ptr->_headerCtx.version);
+    HTTP_DEBUG() << "version: " << version.toString() << std::endl;
+    if(ReqType == parser_ptr->_type)
+        request->setVersion(version);
+    else
+        response->setVersion(version);
 
     HTTP_DEBUG() << "request line parse ok" << std::endl;
 
@@ -292,7 +318,14 @@ int LLhttpParser::onHeaderField(llhttp_t* parser, const char *data, size_t len)
 {
     LLhttpParser* parser_ptr = static_cast<LLhttpParser*>(parser->data);
     HeaderContext &ctx = parser_ptr->_headerCtx;
-    ctx.cur_header = std::string(data, len);
+    if(ctx.in_value)
+    {
+        // 新的头部开始
+        parser_ptr->finishHeaderValue();
+        ctx.cur_header.clear();
+    }
+    // 字段名可能跨越多次 parse 分段到达
+    ctx.cur_header.append(data, len);
     return 0;
 }
 
@@ -301,13 +334,44 @@ int LLhttpParser::onHeaderValue(llhttp_t* parser, const char *data, size_t len)
     LLhttpParser* parser_ptr = static_cast<LLhttpParser*>(parser->data);
     HeaderContext &ctx = parser_ptr->_headerCtx;
 
-    if(!ctx.cur_header.empty())
+    if(ctx.cur_header.empty())
+    {
+        return 0;
+    }
+
+    if(ctx.in_value)
+    {
+        // 同一个值被分段送达，接到正在写入的头部后
+        ctx.headers.begin()[ctx.value_index].second.append(data, len);
+    }
+    else
     {
-        ctx.headers[ctx.cur_header] += std::string(data, len);
+        // 重复出现的同名头部按 ", " 合并
+        ctx.headers.combine(ctx.cur_header, std::string_view(data, len));
+        ctx.value_index = ctx.headers.find(ctx.cur_header) - ctx.headers.begin();
+        ctx.in_value = true;
     }
     return 0;
 }
 
+void LLhttpParser::finishHeaderValue()
+{
+    HeaderContext &ctx = _headerCtx;
+    if(!ctx.in_value)
+    {
+        return;
+    }
+    // llhttp 只去掉值前面的空白，尾部的 OWS 在这里去掉
+    std::string &value = ctx.headers.begin()[ctx.value_index].second;
+    size_t len = value.size();
+    while(len > 0 && (' ' == value[len - 1] || '\t' == value[len - 1]))
+    {
+        --len;
+    }
+    value.resize(len);
+    ctx.in_value = false;
+}
+
 int LLhttpParser::onHeadersComplete(llhttp_t* parser)
 {
     LLhttpParser* parser_ptr = static_cast<LLhttpParser*>(parser->data);
@@ -315,23 +379,30 @@ int LLhttpParser::onHeadersComplete(llhttp_t* parser)
     HttpRequestPtr request = parser_ptr->_context->request();
     HttpResponsePtr response = parser_ptr->_context->response();
 
-    for(auto &it : ctx.headers)
-    {
-        HTTP_DEBUG() << it.first << " : " << it.second << std::endl;
-    }
-
+    parser_ptr->finishHeaderValue();
     // headers字段赋值
     if(ReqType == parser_ptr->_type)
     {
-        request->setHeaders(ctx.headers);
+        request->setHeaders(std::move(ctx.headers));
     }
     else
     {
-        response->setHeaders(ctx.headers);
+        response->setHeaders(std::move(ctx.headers));
     }
     
     // 状态转换
     parser_ptr->_context->setState(HttpContext::kExpectBody);
+
+    if(ReqType == parser_ptr->_type)
+    {
+        const bool has_body = (parser->flags & F_CHUNKED) || parser->content_length > 0;
+        parser_ptr->_context->onHeadersComplete(has_body);
+    }
+    else if(parser_ptr->_context->responseToHead())
+    {
+        // 返回 1 告知 llhttp 该响应没有Body
+        return 1;
+    }
     return 0;
 }
 
@@ -345,7 +416,9 @@ int LLhttpParser::onBody(llhttp_t* parser, const char *data, size_t len)
     int64_t content_len = atoi(parser_ptr->_type == ReqType ?request->getHeader("Content-Length").c_str() : response->getHeader("Content-Length").c_str());
 #endif
 
-    const std::string &content_type_str = parser_ptr->_type == ReqType ? request->getHeader("Content-Type") : response->getHeader("Content-Type");
+    const std::string content_type_str(parser_ptr->_type == ReqType
+        ? request->header(HttpHeaderId::kContentType)
+        : response->header(HttpHeaderId::kContentType));
 
 
     const ContentType content_type = content_type_str.empty()
@@ -364,12 +437,20 @@ int LLhttpParser::onBody(llhttp_t* parser, const char *data, size_t len)
     if(ReqType == parser_ptr->_type)
     {
         request->body().setContentType(content_type);
-        request->body().appendData(data, len);
+        if(!parser_ptr->_context->onBodyData(data, len))
+        {
+            llhttp_set_error_reason(parser, "body sink rejected data");
+            return HPE_USER;
+        }
     }
     else 
     {
         response->body().setContentType(content_type);
-        response->body().appendData(data, len);
+        if(!parser_ptr->_context->onResponseBodyData(data, len))
+        {
+            llhttp_set_error_reason(parser, "response body sink rejected data");
+            return HPE_USER;
+        }
     }
 
     return 0;
@@ -381,9 +462,20 @@ int LLhttpParser::onMessageComplete(llhttp_t* parser)
     HttpRequestPtr request = parser_ptr->_context->request();
     HttpResponsePtr response = parser_ptr->_context->response();
  
-    HTTP_F_INFO("http request/response parse finish! body data size: [%lld/%lld]\n", (ReqType == parser_ptr->_type ? 
-        request->body().data().size() : response->body().data().size()), 
-        parser->content_length);
+    HTTP_F_INFO("http request/response parse finish! body data size: [%zu/%llu]\n", (ReqType == parser_ptr->_type ? 
+        request->body().size() : response->body().size()), 
+        static_cast<unsigned long long>(parser->content_length));
+
+    if(ReqType == parser_ptr->_type && !parser_ptr->_context->onBodyComplete())
+    {
+        llhttp_set_error_reason(parser, "body sink complete failed");
+        return HPE_USER;
+    }
+    if(RespType == parser_ptr->_type && !parser_ptr->_context->onResponseBodyComplete())
+    {
+        llhttp_set_error_reason(parser, "response body sink complete failed");
+        return HPE_USER;
+    }
     
     // 头部上下文清除一下
     parser_ptr->_headerCtx = HeaderContext();
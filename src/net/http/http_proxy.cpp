@@ -0,0 +1,1673 @@
+/**
+ * @file http_proxy.cpp
+ * @brief 反向代理: 上游负载均衡、健康检查、keep-alive 连接复用、Body 流式转发与背压
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 21:18:36
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_proxy.h"
+#include "net/http/http_client.h"
+#include "net/http/http_context.h"
+#include "net/http/http_response.h"
+#include "net/http/http_headers.h"
+#include "net/connector.h"
+#include "net/event_loop.h"
+#include "net/tcp_connection.h"
+#include "net/buffer.h"
+#include "net/net_log.h"
+#include "base/util.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+namespace kit_muduo {
+namespace http {
+
+namespace {
+
+constexpr size_t kNoUpstream = std::numeric_limits<size_t>::max();
+
+/// @brief 不超过该长度的分块与分块头合并为一次发送
+constexpr size_t kCoalesceChunkBytes = 4096;
+
+/**
+ * @brief 逐跳头部只对单条连接有意义，转发时去掉(RFC 7230 6.1)
+ * @note 除固定的逐跳头部外，headers 中任一 Connection 头部列出的名称(如 "close, X-Secret")同样是逐跳的
+ */
+bool IsHopByHop(const HttpHeaders &headers, const HttpHeaders::Entry &header)
+{
+    switch(header.id)
+    {
+        case HttpHeaderId::kConnection:
+        case HttpHeaderId::kKeepAlive:
+        case HttpHeaderId::kTransferEncoding:
+        case HttpHeaderId::kUpgrade:
+            return true;
+        default:
+            break;
+    }
+    if(HeaderNameEquals(header.first, "TE") || HeaderNameEquals(header.first, "Trailer")
+        || HeaderNameEquals(header.first, "Proxy-Connection") || HeaderNameEquals(header.first, "Proxy-Authorization")
+        || HeaderNameEquals(header.first, "Proxy-Authenticate"))
+    {
+        return true;
+    }
+    for(const auto &connection : headers)
+    {
+        if(HttpHeaderId::kConnection == connection.id && HeaderHasToken(connection.second, header.first))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief 请求之后下游连接是否保持，与 HttpServer 的判断一致
+bool RequestKeepAlive(const HttpRequest &req)
+{
+    const std::string_view connection = req.header(HttpHeaderId::kConnection);
+    return !(HeaderNameEquals(connection, "close")
+             || (Version::kHttp10 == req.version()() && !HeaderNameEquals(connection, "keep-alive")));
+}
+
+/// @brief 响应之后上游连接是否可以继续使用
+bool ResponseKeepAlive(const HttpResponse &resp)
+{
+    const std::string_view connection = resp.header(HttpHeaderId::kConnection);
+    if(Version::kHttp11 == resp.version()())
+    {
+        return !HeaderHasToken(connection, "close");
+    }
+    return HeaderHasToken(connection, "keep-alive");
+}
+
+int32_t FormatChunkHeader(char *buf, size_t size, size_t len)
+{
+    return std::snprintf(buf, size, "%zx\r\n", len);
+}
+
+/// @brief 以 chunked 分块写出一段数据，大块直接从来源内存写套接字
+void SendChunk(TcpConnection &conn, const char *data, size_t len)
+{
+    char head[24];
+    const int32_t n = FormatChunkHeader(head, sizeof(head), len);
+    if(len > kCoalesceChunkBytes)
+    {
+        conn.send(head, n);
+        conn.send(data, len);
+        conn.send("\r\n", 2);
+        return;
+    }
+    std::string chunk;
+    chunk.reserve(n + len + 2);
+    chunk.append(head, n).append(data, len).append("\r\n");
+    conn.send(std::move(chunk));
+}
+
+}
+
+struct ProxyServlet::Upstream {
+    explicit Upstream(const InetAddress &address)
+        :addr(address)
+        ,key(address.toIpPort())
+    {}
+
+    const InetAddress addr;
+    const std::string key;
+    std::atomic_bool healthy{true};
+    /// @brief 在途请求数，所有 IO 线程共享
+    std::atomic<int32_t> active{0};
+    std::atomic<int32_t> consecutiveFailures{0};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> failures{0};
+};
+
+/**
+ * @brief 到上游的一条连接，只在所属 IO 线程中访问
+ */
+struct ProxyServlet::UpConn {
+    TcpConnectionPtr conn;
+    size_t upstream{0};
+    /// @brief 当前响应的解析上下文
+    HttpContextPtr ctx;
+    /// @brief 正在使用该连接的转发，空闲时为空
+    std::weak_ptr<Exchange> exchange;
+    int64_t idleSinceMs{0};
+};
+
+/**
+ * @brief 单个 IO 线程内的代理状态，只在该线程中访问
+ *
+ * 由本线程的清理定时器持有: servlet 可能在 IO 线程退出之后才析构(路由表缓存在线程局部变量中)，
+ * 析构时不能再碰这些循环；Core 销毁后由定时器在下一个周期关闭空闲连接并取消自己。
+ */
+struct ProxyServlet::LoopState {
+    LoopState(EventLoop *l, size_t upstreams)
+        :loop(l)
+        ,idle(upstreams)
+    {}
+
+    EventLoop *loop;
+    /// @brief 每个上游的空闲 keep-alive 连接，下标与上游一致
+    std::vector<std::vector<std::shared_ptr<UpConn>>> idle;
+    /// @brief 每条下游连接上按到达顺序排队的转发，队首为正在进行的一个
+    std::unordered_map<TcpConnection*, std::deque<std::shared_ptr<Exchange>>> queues;
+    /// @brief 定时器回调持有本对象，这里只能弱引用
+    std::weak_ptr<Timer> timer;
+    uint64_t nextConnId{0};
+};
+
+struct ProxyServlet::Core: public std::enable_shared_from_this<Core> {
+    Core(const std::vector<InetAddress> &addrs, Config cfg);
+
+    std::shared_ptr<LoopState> loopState(EventLoop *loop);
+    std::shared_ptr<Exchange> create(const TcpConnectionPtr &conn, const HttpRequest &req, bool hasBody);
+
+    /// @brief 在未尝试过的上游中选一个，没有可选时返回 kNoUpstream
+    size_t pick(const std::vector<bool> &tried);
+    void markSuccess(size_t idx);
+    void markFailure(size_t idx, const char *why);
+
+    std::shared_ptr<UpConn> newUpConn(const std::shared_ptr<LoopState> &state, size_t idx, int32_t sockfd);
+
+    /// @brief 转发进入下游连接的队列，前面没有转发时立即开始
+    void enqueue(const std::shared_ptr<Exchange> &ex);
+    /// @brief 队首转发结束，开始下一个
+    void next(LoopState &state, TcpConnection *key, const Exchange *done);
+    /// @brief 下游连接已断开，丢弃其上排队的所有转发
+    void dropQueue(LoopState &state, TcpConnection *key);
+    void onTimer(LoopState &state);
+
+    Config config;
+    std::vector<std::unique_ptr<Upstream>> upstreams;
+    std::atomic<uint64_t> nextPick{0};
+
+    mutable std::mutex mutex;
+    std::unordered_map<EventLoop*, std::weak_ptr<LoopState>> loops;
+    EventLoop *healthLoop{nullptr};
+    TimerPtr healthTimer;
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> responses{0};
+    std::atomic<uint64_t> badGateway{0};
+    std::atomic<uint64_t> gatewayTimeout{0};
+    std::atomic<uint64_t> connects{0};
+    std::atomic<uint64_t> reused{0};
+    std::atomic<uint64_t> retries{0};
+};
+
+/**
+ * @brief 一次请求的转发，只在下游连接所属 IO 线程中访问
+ */
+class ProxyServlet::Exchange: public std::enable_shared_from_this<Exchange>
+{
+public:
+    Exchange(std::shared_ptr<Core> core, std::shared_ptr<LoopState> state,
+             const TcpConnectionPtr &down, const HttpRequest &req, bool hasBody);
+
+    TcpConnection* downKey() const { return _downKey; }
+    LoopState& state() const { return *_state; }
+    bool finished() const { return _finished; }
+    bool downGone() const
+    {
+        TcpConnectionPtr down = _down.lock();
+        return !down || !down->connected();
+    }
+
+    void start();
+    /// @brief 按分发时的请求重新生成转发的请求头，只对尚未开始、没有Body的转发有效
+    void setRequest(const HttpRequest &req);
+    /// @brief servlet 已被分发(中间件放行)，之后才向下游写出响应
+    void onDispatched();
+    /// @brief 结束转发，不再向下游写任何数据
+    void abort() { close(false); }
+    void checkTimeout(int64_t now);
+
+    bool onRequestBody(const char *data, size_t len);
+    bool onRequestComplete();
+    void onRequestAborted();
+    bool onResponseBody(const char *data, size_t len);
+
+    void onUpstreamMessage(Buffer *buf, TimeStamp receiveTime);
+    void onUpstreamClosed();
+    void onUpstreamDrained();
+    void onDownstreamDrained();
+
+private:
+    enum Framing
+    {
+        /// @brief 响应没有Body(HEAD/204/304)
+        kNone,
+        /// @brief 沿用上游的 Content-Length，Body 原样转发
+        kLength,
+        kChunked,
+        /// @brief HTTP/1.0 下游，以关闭连接界定
+        kClose,
+    };
+
+    void forward();
+    void acquire(size_t idx);
+    void connect();
+    void onConnected(int32_t sockfd);
+    void onConnectFailed(int32_t err);
+    void attach(std::shared_ptr<UpConn> c, bool reused);
+    void newResponseContext();
+    void parseUpstream(Buffer &buf, TimeStamp receiveTime);
+    void onUpstreamEof();
+    void sendHead(TcpConnection &down);
+    void completeResponse();
+    void writeUp(const char *data, size_t len);
+    void writeUpChunk(const char *data, size_t len);
+    void checkRequestBacklog();
+    void fail(int32_t code, const char *why);
+    void finish();
+    void close(bool reuse);
+    void releaseUpstream(bool reuse);
+
+private:
+    std::shared_ptr<Core> _core;
+    std::shared_ptr<LoopState> _state;
+    std::weak_ptr<TcpConnection> _down;
+    TcpConnection *_downKey;
+    std::string _target;
+
+    /// @brief 改写后发给上游的请求头
+    std::string _head;
+    bool _isHead{false};
+    bool _hasBody;
+    /// @brief 下游请求为 chunked，转发时重新分块
+    bool _chunkedBody;
+    bool _downHttp11{false};
+    bool _downKeepAlive{false};
+    bool _requestDone;
+
+    /// @brief 上游连接就绪前收到的请求Body(已按上游编码)
+    Buffer _pending;
+    /// @brief 分发前收到的上游响应
+    Buffer _held;
+
+    std::vector<bool> _tried;
+    size_t _upstream{kNoUpstream};
+    bool _counted{false};
+    Connector::Ptr _connector;
+    int64_t _connectStartMs{0};
+    std::shared_ptr<UpConn> _up;
+    std::shared_ptr<ResponseSink> _responseSink;
+    bool _reused{false};
+    bool _retried{false};
+
+    bool _started{false};
+    /// @brief 轮到本转发时还未分发，分发后再开始
+    bool _startPending{false};
+    bool _dispatched{false};
+    bool _finished{false};
+    bool _gotResponseBytes{false};
+    bool _upEof{false};
+    bool _headSent{false};
+    bool _upKeepAlive{true};
+    Framing _framing{kNone};
+    /// @brief 未分发时发生的失败，分发后再回复
+    int32_t _failCode{0};
+    const char *_failReason{""};
+
+    bool _ownsDrainCallback{false};
+    bool _downPaused{false};
+    bool _upPaused{false};
+    int64_t _lastActiveMs;
+};
+
+/**
+ * @brief 请求Body接收器: 每段Body直接写给上游
+ */
+class ProxyServlet::RequestSink: public HttpBodySink
+{
+public:
+    explicit RequestSink(std::shared_ptr<Exchange> exchange)
+        :_exchange(std::move(exchange))
+    {}
+
+    bool onData(const char *data, size_t len) override
+    {
+        _receivedBytes += len;
+        return _exchange->onRequestBody(data, len);
+    }
+
+    bool onComplete() override { return _exchange->onRequestComplete(); }
+
+    void onAbort() override
+    {
+        // 上下文可能在业务线程中析构
+        std::shared_ptr<Exchange> ex = _exchange;
+        ex->state().loop->runInLoop([ex]() { ex->onRequestAborted(); });
+    }
+
+    const std::shared_ptr<Exchange>& exchange() const { return _exchange; }
+
+private:
+    std::shared_ptr<Exchange> _exchange;
+};
+
+/**
+ * @brief 响应Body接收器: 每段Body直接写给下游
+ */
+class ProxyServlet::ResponseSink: public HttpBodySink
+{
+public:
+    explicit ResponseSink(std::weak_ptr<Exchange> exchange)
+        :_exchange(std::move(exchange))
+    {}
+
+    bool onData(const char *data, size_t len) override
+    {
+        _receivedBytes += len;
+        std::shared_ptr<Exchange> ex = _exchange.lock();
+        return ex && ex->onResponseBody(data, len);
+    }
+
+private:
+    std::weak_ptr<Exchange> _exchange;
+};
+
+/**
+ * @brief 主动健康检查，由检查循环的定时器持有，在该循环中运行
+ */
+struct ProxyServlet::HealthChecker: public std::enable_shared_from_this<HealthChecker> {
+    ~HealthChecker()
+    {
+        for(auto &probe : probes)
+        {
+            probe.first->stop();
+        }
+    }
+
+    void run();
+    void probeDone(Connector *connector, bool ok, int32_t err);
+
+    std::weak_ptr<Core> core;
+    EventLoop *loop{nullptr};
+    /// @brief 配置了检查路径时发 HTTP 请求
+    HttpClient::Ptr client;
+    /// @brief 只检查 TCP 时进行中的探测，到下一轮仍未完成视为失败
+    std::vector<std::pair<Connector::Ptr, size_t>> probes;
+};
+
+/******************************** Core ********************************/
+
+ProxyServlet::Core::Core(const std::vector<InetAddress> &addrs, Config cfg)
+    :config(std::move(cfg))
+{
+    upstreams.reserve(addrs.size());
+    for(const auto &addr : addrs)
+    {
+        upstreams.push_back(std::make_unique<Upstream>(addr));
+    }
+}
+
+std::shared_ptr<ProxyServlet::LoopState> ProxyServlet::Core::loopState(EventLoop *loop)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<LoopState> &slot = loops[loop];
+    // 循环已退出时定时器连同状态一起释放，地址可能被新的循环复用
+    std::shared_ptr<LoopState> state = slot.lock();
+    if(state)
+    {
+        return state;
+    }
+    state = std::make_shared<LoopState>(loop, upstreams.size());
+    slot = state;
+    std::weak_ptr<Core> weak = shared_from_this();
+    state->timer = loop->runEvery(config.timerIntervalMs, [weak, state]() {
+        if(std::shared_ptr<Core> core = weak.lock())
+        {
+            core->onTimer(*state);
+            return;
+        }
+        // 在途转发都持有 Core，走到这里时只剩空闲连接
+        for(auto &idle : state->idle)
+        {
+            for(auto &c : idle)
+            {
+                c->conn->forceClose();
+            }
+            idle.clear();
+        }
+        if(TimerPtr timer = state->timer.lock())
+        {
+            state->loop->cancel(timer);
+        }
+    });
+    return state;
+}
+
+std::shared_ptr<ProxyServlet::Exchange> ProxyServlet::Core::create(const TcpConnectionPtr &conn, const HttpRequest &req, bool hasBody)
+{
+    return std::make_shared<Exchange>(shared_from_this(), loopState(conn->getLoop()), conn, req, hasBody);
+}
+
+size_t ProxyServlet::Core::pick(const std::vector<bool> &tried)
+{
+    const size_t n = upstreams.size();
+    const uint64_t start = nextPick.fetch_add(1, std::memory_order_relaxed);
+    // 先在健康的上游中选，全部不健康时退而尝试其余上游
+    for(int32_t pass = 0; pass < 2; ++pass)
+    {
+        size_t best = kNoUpstream;
+        int32_t best_active = std::numeric_limits<int32_t>::max();
+        for(size_t i = 0; i < n; ++i)
+        {
+            const size_t idx = (start + i) % n;
+            const Upstream &upstream = *upstreams[idx];
+            if(tried[idx] || (0 == pass && !upstream.healthy.load()))
+            {
+                continue;
+            }
+            if(Balance::kRoundRobin == config.balance)
+            {
+                return idx;
+            }
+            // 在途数相同时从轮转起点开始选，避免总压在同一个上游
+            const int32_t active = upstream.active.load();
+            if(active < best_active)
+            {
+                best = idx;
+                best_active = active;
+            }
+        }
+        if(kNoUpstream != best)
+        {
+            return best;
+        }
+    }
+    return kNoUpstream;
+}
+
+void ProxyServlet::Core::markSuccess(size_t idx)
+{
+    Upstream &upstream = *upstreams[idx];
+    upstream.consecutiveFailures = 0;
+    if(!upstream.healthy.exchange(true))
+    {
+        HTTP_F_INFO("proxy upstream %s is healthy again\n", upstream.key.c_str());
+    }
+}
+
+void ProxyServlet::Core::markFailure(size_t idx, const char *why)
+{
+    Upstream &upstream = *upstreams[idx];
+    ++upstream.failures;
+    const int32_t count = ++upstream.consecutiveFailures;
+    if(count >= config.unhealthyThreshold && upstream.healthy.exchange(false))
+    {
+        HTTP_F_WARN("proxy upstream %s marked unhealthy after %d failures, last: %s\n", upstream.key.c_str(), count, why);
+    }
+}
+
+std::shared_ptr<ProxyServlet::UpConn> ProxyServlet::Core::newUpConn(const std::shared_ptr<LoopState> &state, size_t idx, int32_t sockfd)
+{
+    int32_t on = 1;
+    ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    std::string name = "proxy-" + upstreams[idx]->key + "#" + std::to_string(++state->nextConnId);
+    auto conn = std::make_shared<TcpConnection>(state->loop, name, sockfd, InetAddress::GetPeerAddr(sockfd), InetAddress::GetLocalAddr(sockfd));
+    auto c = std::make_shared<UpConn>();
+    c->conn = conn;
+    c->upstream = idx;
+
+    // UpConn 持有连接，连接的回调只能弱引用 UpConn
+    std::weak_ptr<UpConn> weak = c;
+    std::weak_ptr<LoopState> weak_state = state;
+    conn->setConnectionCallback([](const TcpConnectionPtr&) {});
+    conn->setMessageCallback([weak](const TcpConnectionPtr &conn, Buffer *buf, TimeStamp receiveTime) {
+        std::shared_ptr<UpConn> c = weak.lock();
+        std::shared_ptr<Exchange> ex = c ? c->exchange.lock() : nullptr;
+        if(!ex)
+        {
+            // 空闲连接上不应收到数据
+            buf->resetAll();
+            conn->forceClose();
+            return;
+        }
+        ex->onUpstreamMessage(buf, receiveTime);
+    });
+    conn->setWriteCompleteCallback([weak](const TcpConnectionPtr&) {
+        std::shared_ptr<UpConn> c = weak.lock();
+        if(std::shared_ptr<Exchange> ex = c ? c->exchange.lock() : nullptr)
+        {
+            ex->onUpstreamDrained();
+        }
+    });
+    conn->setCloseCallback([weak, weak_state](const TcpConnectionPtr &conn) {
+        if(std::shared_ptr<UpConn> c = weak.lock())
+        {
+            if(std::shared_ptr<Exchange> ex = c->exchange.lock())
+            {
+                ex->onUpstreamClosed();
+            }
+            else if(std::shared_ptr<LoopState> state = weak_state.lock())
+            {
+                auto &idle = state->idle[c->upstream];
+                idle.erase(std::remove(idle.begin(), idle.end(), c), idle.end());
+            }
+        }
+        conn->getLoop()->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+    });
+    conn->connectEstablished();
+    return c;
+}
+
+void ProxyServlet::Core::enqueue(const std::shared_ptr<Exchange> &ex)
+{
+    LoopState &state = ex->state();
+    auto it = state.queues.find(ex->downKey());
+    // 已销毁的下游连接残留的队列，地址被新连接复用了
+    if(it != state.queues.end() && !it->second.empty() && it->second.front()->downGone())
+    {
+        dropQueue(state, ex->downKey());
+    }
+
+    std::deque<std::shared_ptr<Exchange>> &queue = state.queues[ex->downKey()];
+    queue.push_back(ex);
+    if(1 == queue.size())
+    {
+        ex->start();
+    }
+}
+
+void ProxyServlet::Core::next(LoopState &state, TcpConnection *key, const Exchange *done)
+{
+    auto it = state.queues.find(key);
+    if(it == state.queues.end())
+    {
+        return;
+    }
+    std::deque<std::shared_ptr<Exchange>> &queue = it->second;
+    if(queue.empty() || queue.front().get() != done)
+    {
+        return;
+    }
+    queue.pop_front();
+    // 排在后面、未分发就被放弃的转发已经结束，直接跳过
+    while(!queue.empty() && queue.front()->finished())
+    {
+        queue.pop_front();
+    }
+    if(queue.empty())
+    {
+        state.queues.erase(it);
+        return;
+    }
+    // 当前调用栈可能还在上一个转发的解析回调里，下一个放到本轮循环末尾开始
+    std::shared_ptr<Exchange> ex = queue.front();
+    state.loop->queueInLoop([ex]() { ex->start(); });
+}
+
+void ProxyServlet::Core::dropQueue(LoopState &state, TcpConnection *key)
+{
+    auto it = state.queues.find(key);
+    if(it == state.queues.end())
+    {
+        return;
+    }
+    std::deque<std::shared_ptr<Exchange>> queue = std::move(it->second);
+    state.queues.erase(it);
+    for(auto &ex : queue)
+    {
+        ex->abort();
+    }
+}
+
+void ProxyServlet::Core::onTimer(LoopState &state)
+{
+    const int64_t now = GetMonotonicMS();
+
+    std::vector<TcpConnection*> gone;
+    std::vector<std::shared_ptr<Exchange>> active;
+    for(auto &item : state.queues)
+    {
+        if(item.second.empty())
+        {
+            continue;
+        }
+        if(item.second.front()->downGone())
+        {
+            gone.push_back(item.first);
+        }
+        else
+        {
+            active.push_back(item.second.front());
+        }
+    }
+    for(TcpConnection *key : gone)
+    {
+        dropQueue(state, key);
+    }
+    for(auto &ex : active)
+    {
+        ex->checkTimeout(now);
+    }
+
+    for(auto &idle : state.idle)
+    {
+        for(auto it = idle.begin(); it != idle.end();)
+        {
+            if(now - (*it)->idleSinceMs < config.idleTimeoutMs && (*it)->conn->connected())
+            {
+                ++it;
+                continue;
+            }
+            (*it)->conn->forceClose();
+            it = idle.erase(it);
+        }
+    }
+}
+
+/******************************** Exchange ********************************/
+
+ProxyServlet::Exchange::Exchange(std::shared_ptr<Core> core, std::shared_ptr<LoopState> state,
+                                 const TcpConnectionPtr &down, const HttpRequest &req, bool hasBody)
+    :_core(std::move(core))
+    ,_state(std::move(state))
+    ,_down(down)
+    ,_downKey(down.get())
+    ,_hasBody(hasBody)
+    ,_chunkedBody(hasBody && HeaderHasToken(req.header(HttpHeaderId::kTransferEncoding), "chunked"))
+    ,_requestDone(!hasBody)
+    ,_tried(_core->upstreams.size(), false)
+    ,_lastActiveMs(GetMonotonicMS())
+{
+    setRequest(req);
+}
+
+void ProxyServlet::Exchange::setRequest(const HttpRequest &req)
+{
+    TcpConnectionPtr down = _down.lock();
+    // 有Body的请求头部一到就开始转发，只在构造时生成一次
+    if(!down || _started || (_hasBody && !_head.empty()))
+    {
+        return;
+    }
+    _isHead = HttpRequest::Method::kHead == req.method()();
+    _downHttp11 = Version::kHttp11 == req.version()();
+    _downKeepAlive = RequestKeepAlive(req);
+
+    std::string path = req.path();
+    const std::string &prefix = _core->config.stripPrefix;
+    if(!prefix.empty() && 0 == path.compare(0, prefix.size(), prefix)
+       && (path.size() == prefix.size() || '/' == path[prefix.size()]))
+    {
+        path.erase(0, prefix.size());
+        if(path.empty())
+        {
+            path = "/";
+        }
+    }
+    _target = path;
+    if(!req.query().empty())
+    {
+        _target.append("?").append(req.query());
+    }
+
+    const HttpHeaders &headers = req.headers();
+    _head.clear();
+    _head.reserve(128 + _target.size() + headers.size() * 48);
+    _head.append(req.method().toString()).append(" ").append(_target).append(" HTTP/1.1\r\n");
+    std::string_view forwarded;
+    for(const auto &header : headers)
+    {
+        if(IsHopByHop(headers, header))
+        {
+            continue;
+        }
+        if(HeaderNameEquals(header.first, "X-Forwarded-For"))
+        {
+            forwarded = header.second;
+            continue;
+        }
+        _head.append(header.first).append(": ").append(header.second).append("\r\n");
+    }
+    // HTTP/1.0 请求可以不带 Host，转发的 HTTP/1.1 请求必须带
+    if(!headers.has(HttpHeaderId::kHost))
+    {
+        _head.append("Host: ").append(down->localAddr().toIpPort()).append("\r\n");
+    }
+    _head.append("X-Forwarded-For: ");
+    if(!forwarded.empty())
+    {
+        _head.append(forwarded).append(", ");
+    }
+    _head.append(down->peerAddr().toIp()).append("\r\n");
+    if(_chunkedBody)
+    {
+        _head.append("Transfer-Encoding: chunked\r\n");
+    }
+    _head.append("\r\n");
+}
+
+void ProxyServlet::Exchange::start()
+{
+    if(_started || _finished)
+    {
+        return;
+    }
+    if(!_hasBody && !_dispatched)
+    {
+        // 没有Body的请求等中间件放行后再转发，被拒绝的请求不会到达上游
+        _startPending = true;
+        return;
+    }
+    _started = true;
+    _lastActiveMs = GetMonotonicMS();
+    ++_core->requests;
+
+    TcpConnectionPtr down = _down.lock();
+    if(!down || !down->connected())
+    {
+        _core->dropQueue(*_state, _downKey);
+        return;
+    }
+    // 下游积压写完时恢复读取上游，只在本转发期间使用该回调
+    std::weak_ptr<Exchange> weak = weak_from_this();
+    down->setWriteCompleteCallback([weak](const TcpConnectionPtr&) {
+        if(std::shared_ptr<Exchange> ex = weak.lock())
+        {
+            ex->onDownstreamDrained();
+        }
+    });
+    _ownsDrainCallback = true;
+    forward();
+}
+
+void ProxyServlet::Exchange::forward()
+{
+    const size_t idx = _core->pick(_tried);
+    if(kNoUpstream == idx)
+    {
+        fail(StateCode::k502BadGateway, "no upstream available");
+        return;
+    }
+    _tried[idx] = true;
+    acquire(idx);
+
+    std::vector<std::shared_ptr<UpConn>> &idle = _state->idle[idx];
+    while(!idle.empty())
+    {
+        std::shared_ptr<UpConn> c = std::move(idle.back());
+        idle.pop_back();
+        if(c->conn->connected())
+        {
+            ++_core->reused;
+            attach(std::move(c), true);
+            return;
+        }
+    }
+    connect();
+}
+
+void ProxyServlet::Exchange::acquire(size_t idx)
+{
+    _upstream = idx;
+    _counted = true;
+    Upstream &upstream = *_core->upstreams[idx];
+    ++upstream.active;
+    ++upstream.requests;
+}
+
+void ProxyServlet::Exchange::connect()
+{
+    _connector = std::make_shared<Connector>(_state->loop, _core->upstreams[_upstream]->addr);
+    Connector *raw = _connector.get();
+    std::weak_ptr<Exchange> weak = weak_from_this();
+    // 连接器持有回调，回调里不能再持有连接器或转发本身
+    _connector->setNewConnectionCallback([weak, raw](int32_t sockfd) {
+        std::shared_ptr<Exchange> ex = weak.lock();
+        if(!ex || ex->_connector.get() != raw)
+        {
+            ::close(sockfd);
+            return;
+        }
+        ex->onConnected(sockfd);
+    });
+    _connector->setErrorCallback([weak, raw](int32_t err) {
+        std::shared_ptr<Exchange> ex = weak.lock();
+        if(ex && ex->_connector.get() == raw)
+        {
+            ex->onConnectFailed(err);
+        }
+    });
+    _connectStartMs = GetMonotonicMS();
+    _connector->start();
+}
+
+void ProxyServlet::Exchange::onConnected(int32_t sockfd)
+{
+    // 还在连接器的回调中，延后释放
+    _state->loop->queueInLoop([connector = std::move(_connector)]() {});
+    ++_core->connects;
+    _core->markSuccess(_upstream);
+    attach(_core->newUpConn(_state, _upstream, sockfd), false);
+}
+
+void ProxyServlet::Exchange::onConnectFailed(int32_t err)
+{
+    _state->loop->queueInLoop([connector = std::move(_connector)]() {});
+    HTTP_F_WARN("proxy connect %s failed! %d:%s\n", _core->upstreams[_upstream]->key.c_str(), err, strerror(err));
+    _core->markFailure(_upstream, strerror(err));
+    releaseUpstream(false);
+    forward();
+}
+
+void ProxyServlet::Exchange::attach(std::shared_ptr<UpConn> c, bool reused)
+{
+    _up = std::move(c);
+    _reused = reused;
+    _gotResponseBytes = false;
+    _upEof = false;
+    _up->exchange = weak_from_this();
+    newResponseContext();
+    _lastActiveMs = GetMonotonicMS();
+
+    TcpConnection &conn = *_up->conn;
+    conn.send(_head.data(), _head.size());
+    if(_pending.readableBytes() > 0)
+    {
+        conn.send(_pending.peek(), _pending.readableBytes());
+        _pending.resetAll();
+    }
+    checkRequestBacklog();
+}
+
+void ProxyServlet::Exchange::newResponseContext()
+{
+    if(!_responseSink)
+    {
+        _responseSink = std::make_shared<ResponseSink>(weak_from_this());
+    }
+    auto ctx = std::make_shared<HttpContext>();
+    ctx->setResponseToHead(_isHead);
+    ctx->setResponseBodySink(_responseSink);
+    _up->ctx = std::move(ctx);
+}
+
+void ProxyServlet::Exchange::onDispatched()
+{
+    _dispatched = true;
+    if(_failCode)
+    {
+        const int32_t code = _failCode;
+        _failCode = 0;
+        fail(code, _failReason);
+        return;
+    }
+    if(_startPending)
+    {
+        _startPending = false;
+        start();
+        return;
+    }
+    if(!_up || _finished)
+    {
+        return;
+    }
+    if(_held.readableBytes() > 0)
+    {
+        parseUpstream(_held, TimeStamp::Now());
+    }
+    if(_finished || !_up)
+    {
+        return;
+    }
+    if(_upEof)
+    {
+        onUpstreamEof();
+        return;
+    }
+    TcpConnectionPtr down = _down.lock();
+    if(_upPaused && down && down->pendingBytes() <= _core->config.highWaterMark)
+    {
+        _up->conn->startRead();
+        _upPaused = false;
+    }
+}
+
+void ProxyServlet::Exchange::checkTimeout(int64_t now)
+{
+    if(!_started || _finished)
+    {
+        return;
+    }
+    const Config &config = _core->config;
+    if(_failCode)
+    {
+        // 失败后一直没有被分发(中间件拒绝了请求)，不再等待
+        if(now - _lastActiveMs >= config.ioTimeoutMs)
+        {
+            close(false);
+            _core->next(*_state, _downKey, this);
+        }
+        return;
+    }
+    if(_connector && now - _connectStartMs >= config.connectTimeoutMs)
+    {
+        _connector->stop();
+        onConnectFailed(ETIMEDOUT);
+        return;
+    }
+    if(now - _lastActiveMs >= config.ioTimeoutMs)
+    {
+        fail(StateCode::k504GatewayTimeout, "upstream timeout");
+    }
+}
+
+void ProxyServlet::Exchange::writeUp(const char *data, size_t len)
+{
+    if(_up)
+    {
+        _up->conn->send(data, len);
+    }
+    else
+    {
+        _pending.append(data, len);
+    }
+}
+
+void ProxyServlet::Exchange::writeUpChunk(const char *data, size_t len)
+{
+    if(_up)
+    {
+        SendChunk(*_up->conn, data, len);
+        return;
+    }
+    char head[24];
+    const int32_t n = FormatChunkHeader(head, sizeof(head), len);
+    _pending.append(head, n);
+    _pending.append(data, len);
+    _pending.append("\r\n", 2);
+}
+
+void ProxyServlet::Exchange::checkRequestBacklog()
+{
+    const size_t backlog = _up ? _up->conn->pendingBytes() : _pending.readableBytes();
+    const bool over = backlog > _core->config.highWaterMark;
+    if(over == _downPaused)
+    {
+        return;
+    }
+    if(TcpConnectionPtr down = _down.lock())
+    {
+        // 暂停后下游的数据留在内核接收缓冲区，由 TCP 窗口限制客户端上传速度
+        over ? down->stopRead() : down->startRead();
+        _downPaused = over;
+    }
+}
+
+bool ProxyServlet::Exchange::onRequestBody(const char *data, size_t len)
+{
+    // 已结束或已失败的转发丢弃剩余Body，连接上后续请求照常解析
+    if(_finished || _failCode)
+    {
+        return true;
+    }
+    _lastActiveMs = GetMonotonicMS();
+    if(_chunkedBody)
+    {
+        writeUpChunk(data, len);
+    }
+    else
+    {
+        writeUp(data, len);
+    }
+    checkRequestBacklog();
+    return true;
+}
+
+bool ProxyServlet::Exchange::onRequestComplete()
+{
+    _requestDone = true;
+    if(!_finished && !_failCode && _chunkedBody)
+    {
+        writeUp("0\r\n\r\n", 5);
+    }
+    return true;
+}
+
+void ProxyServlet::Exchange::onRequestAborted()
+{
+    // 没有Body的请求在上下文析构时才到这里，已分发的照常转发
+    if(_finished || (_requestDone && _dispatched))
+    {
+        return;
+    }
+    close(false);
+    _core->next(*_state, _downKey, this);
+}
+
+void ProxyServlet::Exchange::onUpstreamMessage(Buffer *buf, TimeStamp receiveTime)
+{
+    if(_finished)
+    {
+        buf->resetAll();
+        return;
+    }
+    _lastActiveMs = GetMonotonicMS();
+    if(!_dispatched)
+    {
+        _held.append(buf->peek(), buf->readableBytes());
+        buf->resetAll();
+        if(!_upPaused && _held.readableBytes() > _core->config.highWaterMark)
+        {
+            _up->conn->stopRead();
+            _upPaused = true;
+        }
+        return;
+    }
+    parseUpstream(*buf, receiveTime);
+}
+
+void ProxyServlet::Exchange::parseUpstream(Buffer &buf, TimeStamp receiveTime)
+{
+    // 接收器回调中可能结束本转发，解析期间保持连接与上下文存活
+    std::shared_ptr<Exchange> self = shared_from_this();
+    std::shared_ptr<UpConn> c = _up;
+    while(!_finished && buf.readableBytes() > 0)
+    {
+        HttpContextPtr ctx = c->ctx;
+        _gotResponseBytes = true;
+        if(!ctx->parseResponse(buf, receiveTime))
+        {
+            if(!_finished)
+            {
+                _core->markFailure(c->upstream, "bad response");
+                fail(StateCode::k502BadGateway, "bad upstream response");
+            }
+            return;
+        }
+        if(_finished)
+        {
+            return;
+        }
+
+        const int32_t code = ctx->response()->stateCode()();
+        const bool interim = code >= 100 && code < 200;
+        if(!interim && !_headSent && ctx->state() >= HttpContext::kExpectBody)
+        {
+            TcpConnectionPtr down = _down.lock();
+            if(!down || !down->connected())
+            {
+                _core->dropQueue(*_state, _downKey);
+                return;
+            }
+            sendHead(*down);
+        }
+        if(!ctx->gotAll())
+        {
+            return;
+        }
+        if(interim)
+        {
+            // 请求头中的 Upgrade 已去掉，上游不应切换协议
+            if(StateCode::k101SwitchingProtocols == code)
+            {
+                fail(StateCode::k502BadGateway, "upstream switched protocols");
+                return;
+            }
+            newResponseContext();
+            continue;
+        }
+        // 上游在响应之后多发了数据，连接不能再复用
+        if(buf.readableBytes() > 0)
+        {
+            _upKeepAlive = false;
+            buf.resetAll();
+        }
+        completeResponse();
+        return;
+    }
+}
+
+bool ProxyServlet::Exchange::onResponseBody(const char *data, size_t len)
+{
+    if(_finished)
+    {
+        return false;
+    }
+    TcpConnectionPtr down = _down.lock();
+    if(!down || !down->connected())
+    {
+        _core->dropQueue(*_state, _downKey);
+        return false;
+    }
+    if(!_headSent)
+    {
+        sendHead(*down);
+    }
+    switch(_framing)
+    {
+        case kNone:
+            break;
+        case kChunked:
+            SendChunk(*down, data, len);
+            break;
+        default:
+            down->send(data, len);
+            break;
+    }
+    // 下游写不动时暂停读取上游，积压写完后由 onDownstreamDrained 恢复
+    if(!_upPaused && down->pendingBytes() > _core->config.highWaterMark)
+    {
+        _up->conn->stopRead();
+        _upPaused = true;
+    }
+    return true;
+}
+
+void ProxyServlet::Exchange::sendHead(TcpConnection &down)
+{
+    _headSent = true;
+    const HttpResponse &resp = *_up->ctx->response();
+    const int32_t code = resp.stateCode()();
+    const bool chunked = HeaderHasToken(resp.header(HttpHeaderId::kTransferEncoding), "chunked");
+    if(_isHead || StateCode::k204NoContent == code || StateCode::k304NotModified == code)
+    {
+        _framing = kNone;
+    }
+    else if(!chunked && resp.headers().has(HttpHeaderId::kContentLength))
+    {
+        _framing = kLength;
+    }
+    else if(_downHttp11)
+    {
+        _framing = kChunked;
+    }
+    else
+    {
+        _framing = kClose;
+        _downKeepAlive = false;
+    }
+
+    std::string out;
+    out.reserve(128 + resp.headers().size() * 48);
+    const std::string_view status_line = HttpStatusLine(Version::kHttp11, code);
+    if(status_line.empty())
+    {
+        // 原因短语可以为空(RFC 7230 3.1.2)
+        out.append("HTTP/1.1 ").append(std::to_string(code)).append(" \r\n");
+    }
+    else
+    {
+        out.append(status_line);
+    }
+    for(const auto &header : resp.headers())
+    {
+        if(!IsHopByHop(resp.headers(), header))
+        {
+            out.append(header.first).append(": ").append(header.second).append("\r\n");
+        }
+    }
+    if(kChunked == _framing)
+    {
+        out.append("Transfer-Encoding: chunked\r\n");
+    }
+    out.append(_downKeepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n");
+    down.send(std::move(out));
+}
+
+void ProxyServlet::Exchange::completeResponse()
+{
+    TcpConnectionPtr down = _down.lock();
+    if(!down || !down->connected())
+    {
+        _core->dropQueue(*_state, _downKey);
+        return;
+    }
+    if(!_headSent)
+    {
+        sendHead(*down);
+    }
+    if(kChunked == _framing)
+    {
+        down->send("0\r\n\r\n", 5);
+    }
+    _upKeepAlive = _upKeepAlive && _requestDone && ResponseKeepAlive(*_up->ctx->response());
+    ++_core->responses;
+    finish();
+}
+
+void ProxyServlet::Exchange::onUpstreamClosed()
+{
+    if(_finished)
+    {
+        return;
+    }
+    _upEof = true;
+    // 分发前收到的响应还没有解析，等分发后一并处理
+    if(_dispatched)
+    {
+        onUpstreamEof();
+    }
+}
+
+void ProxyServlet::Exchange::onUpstreamEof()
+{
+    std::shared_ptr<Exchange> self = shared_from_this();
+    if(!_gotResponseBytes)
+    {
+        // 复用的空闲连接恰好被上游关闭(keep-alive 竞态)，没有Body的请求可以安全重发一次
+        if(_reused && !_hasBody && !_retried)
+        {
+            _retried = true;
+            ++_core->retries;
+            const size_t idx = _upstream;
+            releaseUpstream(false);
+            acquire(idx);
+            connect();
+            return;
+        }
+        _core->markFailure(_upstream, "closed before response");
+        fail(StateCode::k502BadGateway, "upstream closed before response");
+        return;
+    }
+
+    // 以关闭界定长度的响应在此完成
+    HttpContextPtr ctx = _up->ctx;
+    if(ctx->finishResponse() && ctx->gotAll())
+    {
+        _upKeepAlive = false;
+        completeResponse();
+        return;
+    }
+    fail(StateCode::k502BadGateway, "upstream closed mid-response");
+}
+
+void ProxyServlet::Exchange::onUpstreamDrained()
+{
+    _lastActiveMs = GetMonotonicMS();
+    if(!_finished && _downPaused)
+    {
+        checkRequestBacklog();
+    }
+}
+
+void ProxyServlet::Exchange::onDownstreamDrained()
+{
+    _lastActiveMs = GetMonotonicMS();
+    if(!_finished && _dispatched && _upPaused && _up)
+    {
+        _up->conn->startRead();
+        _upPaused = false;
+    }
+}
+
+void ProxyServlet::Exchange::fail(int32_t code, const char *why)
+{
+    if(_finished)
+    {
+        return;
+    }
+    HTTP_F_WARN("proxy %s -> %s failed: %s\n", _target.c_str(),
+                kNoUpstream == _upstream ? "-" : _core->upstreams[_upstream]->key.c_str(), why);
+    if(!_dispatched)
+    {
+        // 还没有分发(中间件可能拒绝)，先不回复
+        _failCode = code;
+        _failReason = why;
+        _lastActiveMs = GetMonotonicMS();
+        releaseUpstream(false);
+        return;
+    }
+
+    if(StateCode::k504GatewayTimeout == code)
+    {
+        ++_core->gatewayTimeout;
+    }
+    else
+    {
+        ++_core->badGateway;
+    }
+    TcpConnectionPtr down = _down.lock();
+    close(false);
+    if(down && down->connected())
+    {
+        if(_headSent)
+        {
+            // 响应已经开始，只能断开让客户端感知
+            down->forceClose();
+        }
+        else
+        {
+            const bool keep_alive = _downKeepAlive && _requestDone;
+            const std::string_view reason = HttpReasonPhrase(code);
+            std::string out(HttpStatusLine(Version::kHttp11, code));
+            out.append("Content-Type: text/plain\r\nContent-Length: ").append(std::to_string(reason.size()))
+               .append(keep_alive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n")
+               .append(reason);
+            down->send(std::move(out));
+            if(!keep_alive)
+            {
+                down->shutdown();
+            }
+        }
+    }
+    _core->next(*_state, _downKey, this);
+}
+
+void ProxyServlet::Exchange::finish()
+{
+    TcpConnectionPtr down = _down.lock();
+    close(_upKeepAlive);
+    if(down && !_downKeepAlive && down->connected())
+    {
+        down->shutdown();
+    }
+    _core->next(*_state, _downKey, this);
+}
+
+void ProxyServlet::Exchange::close(bool reuse)
+{
+    if(_finished)
+    {
+        return;
+    }
+    _finished = true;
+    releaseUpstream(reuse);
+    _held.resetAll();
+    _pending.resetAll();
+    if(TcpConnectionPtr down = _down.lock())
+    {
+        if(_ownsDrainCallback)
+        {
+            down->setWriteCompleteCallback(nullptr);
+            _ownsDrainCallback = false;
+        }
+        if(_downPaused)
+        {
+            down->startRead();
+            _downPaused = false;
+        }
+    }
+}
+
+void ProxyServlet::Exchange::releaseUpstream(bool reuse)
+{
+    if(_counted)
+    {
+        --_core->upstreams[_upstream]->active;
+        _counted = false;
+    }
+    if(_connector)
+    {
+        _connector->stop();
+        _state->loop->queueInLoop([connector = std::move(_connector)]() {});
+    }
+
+    std::shared_ptr<UpConn> c = std::move(_up);
+    _up.reset();
+    if(!c)
+    {
+        return;
+    }
+    c->exchange.reset();
+    if(_upPaused)
+    {
+        c->conn->startRead();
+        _upPaused = false;
+    }
+    if(reuse && c->conn->connected())
+    {
+        std::vector<std::shared_ptr<UpConn>> &idle = _state->idle[c->upstream];
+        if(idle.size() < _core->config.maxIdlePerUpstream)
+        {
+            c->ctx.reset();
+            c->idleSinceMs = GetMonotonicMS();
+            idle.push_back(std::move(c));
+            return;
+        }
+    }
+    c->conn->forceClose();
+}
+
+/******************************** HealthChecker ********************************/
+
+void ProxyServlet::HealthChecker::run()
+{
+    std::shared_ptr<Core> c = core.lock();
+    if(!c)
+    {
+        return;
+    }
+    for(auto &probe : probes)
+    {
+        probe.first->stop();
+        c->markFailure(probe.second, "health check timeout");
+    }
+    loop->queueInLoop([stale = std::move(probes)]() {});
+    probes.clear();
+
+    std::weak_ptr<Core> weak_core = core;
+    std::weak_ptr<HealthChecker> weak = weak_from_this();
+    for(size_t idx = 0; idx < c->upstreams.size(); ++idx)
+    {
+        const InetAddress &addr = c->upstreams[idx]->addr;
+        if(client)
+        {
+            client->get(addr, c->config.healthCheckPath, [weak_core, idx](HttpClient::Result result) {
+                std::shared_ptr<Core> c = weak_core.lock();
+                if(!c)
+                {
+                    return;
+                }
+                const int32_t code = result.ok() ? result.response->stateCode()() : 0;
+                if(code >= 200 && code < 400)
+                {
+                    c->markSuccess(idx);
+                }
+                else
+                {
+                    c->markFailure(idx, result.ok() ? "health check status" : HttpClient::ErrorString(result.error));
+                }
+            });
+            continue;
+        }
+
+        auto connector = std::make_shared<Connector>(loop, addr);
+        Connector *raw = connector.get();
+        connector->setNewConnectionCallback([weak, raw](int32_t sockfd) {
+            ::close(sockfd);
+            if(std::shared_ptr<HealthChecker> self = weak.lock())
+            {
+                self->probeDone(raw, true, 0);
+            }
+        });
+        connector->setErrorCallback([weak, raw](int32_t err) {
+            if(std::shared_ptr<HealthChecker> self = weak.lock())
+            {
+                self->probeDone(raw, false, err);
+            }
+        });
+        probes.emplace_back(connector, idx);
+        connector->start();
+    }
+}
+
+void ProxyServlet::HealthChecker::probeDone(Connector *connector, bool ok, int32_t err)
+{
+    auto it = std::find_if(probes.begin(), probes.end(), [connector](const auto &probe) { return probe.first.get() == connector; });
+    if(it == probes.end())
+    {
+        return;
+    }
+    const size_t idx = it->second;
+    // 还在连接器的回调中，延后释放
+    loop->queueInLoop([probe = std::move(it->first)]() {});
+    probes.erase(it);
+
+    if(std::shared_ptr<Core> c = core.lock())
+    {
+        ok ? c->markSuccess(idx) : c->markFailure(idx, strerror(err));
+    }
+}
+
+/******************************** ProxyServlet ********************************/
+
+ProxyServlet::ProxyServlet(const std::vector<InetAddress> &upstreams)
+    :ProxyServlet(upstreams, Config())
+{
+}
+
+ProxyServlet::ProxyServlet(const std::vector<InetAddress> &upstreams, Config config)
+    :HttpServlet("ProxyServlet")
+    ,_core(std::make_shared<Core>(upstreams, std::move(config)))
+{
+}
+
+ProxyServlet::~ProxyServlet()
+{
+    stopHealthCheck();
+}
+
+void ProxyServlet::handle(TcpConnectionPtr conn, HttpContextPtr ctx)
+{
+    auto resp = ctx->response();
+    if(ctx->isHttp2())
+    {
+        // 代理的响应直接写在下游连接上，HTTP/2 流暂不支持
+        resp->setVersion(Version::kHttp11);
+        resp->setStateCode(StateCode::k502BadGateway);
+        resp->body().appendData("http/2 downstream is not supported by proxy");
+        return;
+    }
+
+    // 响应由转发在下游连接的IO线程中写出
+    resp->setDeferred(true);
+    std::shared_ptr<RequestSink> sink = std::dynamic_pointer_cast<RequestSink>(ctx->bodySink());
+    if(!sink)
+    {
+        // 没有经过 prepare(如直接调用 handle)，只能在此时排队
+        std::shared_ptr<Core> core = _core;
+        conn->getLoop()->runInLoop([core, conn, ctx]() {
+            std::shared_ptr<Exchange> ex = core->create(conn, *ctx->request(), false);
+            ex->onDispatched();
+            core->enqueue(ex);
+        });
+        return;
+    }
+    conn->getLoop()->runInLoop([ctx, sink]() {
+        // 中间件可能改写了请求，按分发时的内容转发
+        sink->exchange()->setRequest(*ctx->request());
+        sink->exchange()->onDispatched();
+    });
+}
+
+void ProxyServlet::prepare(TcpConnectionPtr conn, HttpContextPtr ctx)
+{
+    // 有Body的请求在头部解析完成时已经排队
+    if(ctx->isHttp2() || ctx->bodySink())
+    {
+        return;
+    }
+    // 在IO线程按到达顺序排队，业务线程的完成先后不影响响应顺序；
+    // 借用Body接收器的位置让 handle 取回，上下文未分发就析构时让出队列位置
+    std::shared_ptr<Exchange> ex = _core->create(conn, *ctx->request(), false);
+    ctx->setBodySink(std::make_shared<RequestSink>(ex));
+    _core->enqueue(ex);
+}
+
+HttpBodySink::Ptr ProxyServlet::createBodySink(TcpConnectionPtr conn, HttpContextPtr ctx)
+{
+    if(ctx->isHttp2())
+    {
+        return nullptr;
+    }
+    // 头部一到就开始转发，Body 边收边写给上游
+    std::shared_ptr<Exchange> ex = _core->create(conn, *ctx->request(), true);
+    auto sink = std::make_shared<RequestSink>(ex);
+    _core->enqueue(ex);
+    return sink;
+}
+
+void ProxyServlet::startHealthCheck(EventLoop *loop)
+{
+    stopHealthCheck();
+
+    auto checker = std::make_shared<HealthChecker>();
+    checker->core = _core;
+    checker->loop = loop;
+    const Config &config = _core->config;
+    if(!config.healthCheckPath.empty())
+    {
+        HttpClient::Config client_config;
+        client_config.maxConnectionsPerHost = 1;
+        client_config.connectTimeoutMs = config.connectTimeoutMs;
+        client_config.requestTimeoutMs = config.healthCheckIntervalMs;
+        client_config.userAgent = "kit_muduo-proxy-health";
+        checker->client = std::make_shared<HttpClient>(loop, client_config);
+    }
+
+    loop->runInLoop([checker]() { checker->run(); });
+    // 检查器只由定时器持有，取消定时器即在循环线程中销毁
+    TimerPtr timer = loop->runEvery(config.healthCheckIntervalMs, [checker]() { checker->run(); });
+    std::lock_guard<std::mutex> lock(_core->mutex);
+    _core->healthLoop = loop;
+    _core->healthTimer = timer;
+}
+
+void ProxyServlet::stopHealthCheck()
+{
+    std::lock_guard<std::mutex> lock(_core->mutex);
+    if(_core->healthTimer)
+    {
+        _core->healthLoop->cancel(_core->healthTimer);
+        _core->healthTimer.reset();
+        _core->healthLoop = nullptr;
+    }
+}
+
+std::vector<ProxyServlet::UpstreamStats> ProxyServlet::upstreamStats() const
+{
+    std::vector<UpstreamStats> result;
+    result.reserve(_core->upstreams.size());
+    for(const auto &upstream : _core->upstreams)
+    {
+        UpstreamStats stats;
+        stats.addr = upstream->key;
+        stats.healthy = upstream->healthy.load();
+        stats.active = upstream->active.load();
+        stats.requests = upstream->requests.load();
+        stats.failures = upstream->failures.load();
+        result.push_back(std::move(stats));
+    }
+    return result;
+}
+
+ProxyServlet::Stats ProxyServlet::stats() const
+{
+    Stats stats;
+    stats.requests = _core->requests.load();
+    stats.responses = _core->responses.load();
+    stats.badGateway = _core->badGateway.load();
+    stats.gatewayTimeout = _core->gatewayTimeout.load();
+    stats.connects = _core->connects.load();
+    stats.reused = _core->reused.load();
+    stats.retries = _core->retries.load();
+    return stats;
+}
+
+const ProxyServlet::Config& ProxyServlet::config() const
+{
+    return _core->config;
+}
+
+}   // http
+}   // kit_muduo
@@ -31,38 +31,32 @@ HttpRequest::~HttpRequest()
 
 void HttpRequest::addHeader(const std::string& head, const std::string &val)
 {
-    headers_[head] = val;
+    headers_.set(head, val);
 }
 
 bool HttpRequest::addHeader(const char *start, const char *colon, const char *end)
 {
     assert(start != end);
-    std::string head(start, colon);
-    DelSpaceHelper(head);
-    // assert(head.size() != 0);
-    if(head.size() <= 0)
+    // 直接在原始报文上裁剪，只在写入容器时拷贝一次
+    std::string_view head = TrimHttpSpace(std::string_view(start, colon - start));
+    if(head.empty())
     {
         return false;
     }
     ++colon;
-    std::string val(colon, end);
-    DelSpaceHelper(val);
-    // assert(val.size() != 0);
-    HTTP_F_DEBUG("Header: |%s|-|%s|\n", head.c_str(), val.c_str());
-    if(val.size() <= 0)
+    std::string_view val = TrimHttpSpace(std::string_view(colon, end - colon));
+    HTTP_F_DEBUG("Header: |%.*s|-|%.*s|\n", static_cast<int>(head.size()), head.data(), static_cast<int>(val.size()), val.data());
+    if(val.empty())
     {
         return false;
     }
-    headers_[head] = val;
+    headers_.set(head, val);
     return true;
 }
 
 std::string HttpRequest::getHeader(const std::string &key) const
 {
-    if(headers_.empty())
-        return "";
-    auto it = headers_.find(key);
-    return it == headers_.end() ? "" : it->second;
+    return std::string(headers_.get(key));
 }
 
 std::string HttpRequest::toString()
@@ -76,14 +70,14 @@ std::string HttpRequest::toString()
     ss << version_.toString();
     ss << kCRLF;
 
-    if(body_.data().size())
+    if(body_.size())
     {
-        headers_["Content-Length"] = std::to_string(body_.data().size());
+        headers_.set(HttpHeaderId::kContentLength, std::to_string(body_.size()));
     }
 
     if(ContentType::kUnknowType != body_.contentType().toInt())
     {
-        headers_["Content-Type"] = body_.contentType().toString();
+        headers_.set(HttpHeaderId::kContentType, body_.contentType().toString());
     }
 
     // Headers
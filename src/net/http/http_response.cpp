@@ -9,8 +9,11 @@
 #include "net/http/http_response.h"
 #include "base/util.h"
 #include "net/http/http_util.h"
+#include "net/http/http_header_cache.h"
 #include "net/net_log.h"
 
+#include <cstdio>
+#include <cstring>
 #include <sstream>
 #include <iostream>
 
@@ -38,91 +41,148 @@ HttpResponse::~HttpResponse()
 
 void HttpResponse::addHeader(const std::string& head, const std::string &val)
 {
-    headers_[head] = val;
+    headers_.set(head, val);
 }
 
 bool HttpResponse::addHeader(const char *start, const char *colon, const char *end)
 {
     assert(start != end);
-    std::string head(start, colon);
-    DelSpaceHelper(head);
-    // assert(head.size() != 0);
-    if(head.size() <= 0)
+    // 直接在原始报文上裁剪，只在写入容器时拷贝一次
+    std::string_view head = TrimHttpSpace(std::string_view(start, colon - start));
+    if(head.empty())
     {
         return false;
     }
     ++colon;
-    std::string val(colon, end);
-    DelSpaceHelper(val);
-    // assert(val.size() != 0);
-    HTTP_F_DEBUG("Header: |%s|-|%s|\n", head.c_str(), val.c_str());
-    if(val.size() <= 0)
+    std::string_view val = TrimHttpSpace(std::string_view(colon, end - colon));
+    HTTP_F_DEBUG("Header: |%.*s|-|%.*s|\n", static_cast<int>(head.size()), head.data(), static_cast<int>(val.size()), val.data());
+    if(val.empty())
     {
         return false;
     }
-    headers_[head] = val;
+    headers_.set(head, val);
     return true;
 }
 
 std::string HttpResponse::getHeader(const std::string &key) const
 {
-    auto it = headers_.find(key);
-    return it == headers_.end() ? "" : it->second;
+    return std::string(headers_.get(key));
+}
+
+void HttpResponse::addDataSegment(std::string data)
+{
+    segment_bytes_ += data.size();
+    BodySegment seg;
+    seg.length = data.size();
+    seg.data = std::move(data);
+    segments_.push_back(std::move(seg));
+}
+
+void HttpResponse::addFileSegment(const SharedFilePtr &file, off_t offset, size_t length)
+{
+    segment_bytes_ += length;
+    BodySegment seg;
+    seg.file = file;
+    seg.offset = offset;
+    seg.length = length;
+    segments_.push_back(std::move(seg));
 }
 
 std::string HttpResponse::toString()
 {
-    std::stringstream ss{""};
-    ss << version_.toString();
-    ss << kSpace;
-    ss << state_code_.toString();
-    ss << kSpace;
-    ss << state_code_.message();
-    ss << kCRLF;
-
-    if(Version::kHttp11 == version_() && !connection_closed_)
+    std::string str = headerString();
+    str += body_.toString(); // TODO 这里是有问题的 不能认为Body一直是string类型
+    return str;
+}
+
+std::string HttpResponse::headerString()
+{
+    const bool keep_alive = Version::kHttp11 == version_() && !connection_closed_;
+    return renderHeader(keep_alive, true);
+}
+
+std::string HttpResponse::headerPrefix(bool keepAlive)
+{
+    return renderHeader(keepAlive && Version::kHttp11 == version_(), false);
+}
+
+std::string HttpResponse::renderHeader(bool keep_alive, bool complete)
+{
+    // 调用方写了 Connection(如 "upgrade")时原样输出，不用预拼片段；其中含 close 时发送后断开
+    const bool custom_connection = headers_.has(HttpHeaderId::kConnection);
+    if(custom_connection && HeaderHasToken(headers_.get(HttpHeaderId::kConnection), "close"))
     {
-        headers_["Connection"] = "keep-alive";
-        //对keep-alive模式参数配置
-        headers_["Keep-Alive"] = "timeout=5, max=100";  // 连接保持5秒，最多100次请求
+        connection_closed_ = true;
+    }
 
+    // 状态行、Connection、Content-Type 都是预先拼好的片段，这里只做拷贝
+    const std::string_view connection = custom_connection ? std::string_view() : HttpConnectionFragment(keep_alive);
+    const std::string_view content_type = HttpContentTypeFragment(body_.contentType().toInt());
+    const std::string_view date = !complete || headers_.has(HttpHeaderId::kDate) ? std::string_view() : HttpDateCache::DateLine();
+
+    char length_buf[48];
+    int length_len = 0;
+    if(!segments_.empty())
+    {
+        length_len = std::snprintf(length_buf, sizeof(length_buf), "Content-Length: %zu\r\n", segment_bytes_);
     }
-    else
+    else if(body_.size())
     {
-        headers_["Connection"] = "close";
+        length_len = std::snprintf(length_buf, sizeof(length_buf), "Content-Length: %zu\r\n", body_.size());
     }
 
-    ContentType content_type = body_.contentType();
-    if(ContentType::kUnknowType != content_type.toInt())
+    std::string status_fallback;
+    std::string_view status_line = HttpStatusLine(version_(), state_code_());
+    if(status_line.empty())
     {
-        // 默认字符集 utf-8
-        std::string content_type_str = content_type.toString();
-        content_type_str += "; ";
-        content_type_str += "charset=utf-8";
-        if(ContentType::kMultiForm == content_type.toInt())
-        {
-            content_type_str += "; ";
-            content_type_str += "boundary=----WebKitFormBoundaryNQJ0YrO2NeaUfM7n";
-        }
-        headers_["Content-Type"] = content_type_str;
+        // 表外的状态码/版本
+        status_fallback.append(version_.toString()).append(kSpace);
+        status_fallback.append(state_code_.toString()).append(kSpace);
+        status_fallback.append(state_code_.reason()).append(kCRLF);
+        status_line = status_fallback;
     }
 
+    // 由片段生成的头部不再输出容器里的同名项
+    auto rendered = [&](const HttpHeaders::Entry &entry) {
+        switch(entry.id)
+        {
+            case HttpHeaderId::kKeepAlive: return keep_alive && !custom_connection;
+            case HttpHeaderId::kContentType: return !content_type.empty();
+            case HttpHeaderId::kContentLength: return length_len > 0;
+            default: return false;
+        }
+    };
 
-    if(body_.data().size())
+    // 先算总长度，一次分配
+    size_t total = status_line.size() + date.size() + connection.size() + content_type.size() + length_len + 2;
+    for(auto &it : headers_)
     {
-        headers_["Content-Length"] = std::to_string(body_.data().size());
+        total += it.first.size() + it.second.size() + 4;
     }
 
+    std::string str;
+    str.reserve(total);
+    str.append(status_line);
+    str.append(date);
     for(auto &it : headers_)
     {
-        ss << it.first;
-        ss << kColon << kSpace;
-        ss << it.second;
-        ss << kCRLF;
+        if(rendered(it))
+        {
+            continue;
+        }
+        str.append(it.first);
+        str.append(kColon).append(kSpace);
+        str.append(it.second);
+        str.append(kCRLF);
+    }
+    str.append(connection);
+    str.append(content_type);
+    str.append(length_buf, length_len);
+    if(complete)
+    {
+        str.append(kCRLF);
     }
-    ss << kCRLF;
-    ss << body_.toString(); // TODO 这里是有问题的 不能认为Body一直是string类型
-    return ss.str();
+    return str;
 }
 
 }
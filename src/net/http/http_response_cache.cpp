@@ -0,0 +1,357 @@
+/**
+ * @file http_response_cache.cpp
+ * @brief 响应缓存中间件: 按方法/路径/查询参数/Vary 头缓存预序列化响应
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 22:05:37
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_response_cache.h"
+#include "net/http/http_context.h"
+#include "net/http/http_header_cache.h"
+#include "net/http/http_headers.h"
+#include "net/http/http_request.h"
+#include "net/http/http_response.h"
+#include "net/event_loop.h"
+#include "net/net_log.h"
+#include "net/tcp_connection.h"
+#include "base/metrics.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+
+namespace kit_muduo::http {
+
+namespace {
+
+/**
+ * @brief 依次回调逗号分隔列表中去掉空白后的每一项
+ */
+template<typename Fn>
+void ForEachToken(std::string_view list, Fn &&fn)
+{
+    while(!list.empty())
+    {
+        const size_t comma = list.find(',');
+        std::string_view token = TrimHttpSpace(list.substr(0, comma));
+        if(!token.empty())
+        {
+            fn(token);
+        }
+        if(std::string_view::npos == comma)
+        {
+            break;
+        }
+        list.remove_prefix(comma + 1);
+    }
+}
+
+bool HasDirective(std::string_view cacheControl, std::string_view directive)
+{
+    bool found = false;
+    ForEachToken(cacheControl, [&](std::string_view token) {
+        found = found || HeaderNameEquals(token.substr(0, token.find('=')), directive);
+    });
+    return found;
+}
+
+/**
+ * @brief 读取 s-maxage(优先)或 max-age，单位秒
+ * @return 都没有时返回 -1
+ */
+int64_t MaxAgeSeconds(std::string_view cacheControl)
+{
+    int64_t max_age = -1;
+    int64_t s_maxage = -1;
+    ForEachToken(cacheControl, [&](std::string_view token) {
+        const size_t eq = token.find('=');
+        if(std::string_view::npos == eq)
+        {
+            return;
+        }
+        const std::string_view name = TrimHttpSpace(token.substr(0, eq));
+        std::string value(TrimHttpSpace(token.substr(eq + 1)));
+        if(value.empty() || !std::all_of(value.begin(), value.end(), ::isdigit))
+        {
+            return;
+        }
+        if(HeaderNameEquals(name, "s-maxage"))
+        {
+            s_maxage = std::strtoll(value.c_str(), nullptr, 10);
+        }
+        else if(HeaderNameEquals(name, "max-age"))
+        {
+            max_age = std::strtoll(value.c_str(), nullptr, 10);
+        }
+    });
+    return s_maxage >= 0 ? s_maxage : max_age;
+}
+
+}
+
+HttpResponseCache::HttpResponseCache()
+    :HttpResponseCache(Config())
+{
+}
+
+HttpResponseCache::HttpResponseCache(Config config, const std::string &name)
+    :HttpMiddleware(name)
+    ,_config(std::move(config))
+    ,_cache(_config.maxBytes)
+{
+}
+
+bool HttpResponseCache::bypass(const HttpRequest &req) const
+{
+    if(req.headers().has(HttpHeaderId::kAuthorization))
+    {
+        return true;
+    }
+    const std::string_view cache_control = req.header(HttpHeaderId::kCacheControl);
+    return !cache_control.empty()
+        && (HasDirective(cache_control, "no-cache") || HasDirective(cache_control, "no-store"));
+}
+
+std::string HttpResponseCache::makeKey(const HttpRequest &req) const
+{
+    // 方法 路径?参数=值&...\n头部: 值\n...，路径中不会出现换行
+    std::string key = req.method().toString();
+    key.append(1, ' ').append(req.path());
+    char sep = '?';
+    for(const auto &param : _config.queryParams)
+    {
+        key.append(1, sep).append(param).append(1, '=').append(req.getQureyParam(param));
+        sep = '&';
+    }
+    for(const auto &header : _config.varyHeaders)
+    {
+        key.append(1, '\n').append(header).append(": ").append(req.header(header));
+    }
+    return key;
+}
+
+HttpResponseCache::EntryPtr HttpResponseCache::lookup(const std::string &key)
+{
+    EntryPtr entry;
+    if(!_cache.tryGet(key, entry))
+    {
+        return nullptr;
+    }
+    if(entry->expire_ns <= metrics::NowNs())
+    {
+        _cache.erase(key);
+        _expired.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return entry;
+}
+
+void HttpResponseCache::Serve(HttpResponse &resp, const Entry &entry)
+{
+    resp.setVersion(Version::kHttp11);
+    resp.setStateCode(entry.status);
+    std::vector<SharedBuffer> buffers{resp.connectionClosed() ? entry.header_close : entry.header_keep_alive,
+                                      HttpDateCache::DateBlock()};
+    if(!entry.body->empty())
+    {
+        buffers.push_back(entry.body);
+    }
+    resp.setSerialized(std::move(buffers));
+}
+
+HttpMiddleware::Action HttpResponseCache::before(const TcpConnectionPtr &conn, const HttpContextPtr &ctx)
+{
+    const HttpRequest &req = *ctx->request();
+    if(!MethodAllowed(_config.methods, req.method()))
+    {
+        return Action::kContinue;
+    }
+    if(bypass(req))
+    {
+        _bypassed.fetch_add(1, std::memory_order_relaxed);
+        return Action::kContinue;
+    }
+
+    const std::string key = makeKey(req);
+    if(EntryPtr entry = lookup(key))
+    {
+        _hits.fetch_add(1, std::memory_order_relaxed);
+        Serve(*ctx->response(), *entry);
+        return Action::kRespond;
+    }
+
+    // 未命中: 没有进行中(或已超时)的填充时成为 leader，否则等待 leader 的结果
+    _misses.fetch_add(1, std::memory_order_relaxed);
+    const int64_t now = metrics::NowNs();
+    const int64_t timeout_ns = _config.coalesceTimeoutMs * 1000000;
+    std::unique_lock<std::mutex> lock(_flightMutex);
+    FlightPtr &slot = _flights[key];
+    if(!slot || now - slot->start_ns >= timeout_ns)
+    {
+        slot = std::make_shared<Flight>();
+        slot->leader = ctx.get();
+        slot->start_ns = now;
+        return Action::kContinue;
+    }
+
+    // IO线程(未启用业务线程池)不能阻塞等待，否则整个事件循环停住，自行执行servlet
+    if(conn->getLoop()->isInLoopThread())
+    {
+        HTTP_F_DEBUG("conn[%s] response cache miss in loop thread, not waiting for leader, key[%s]\n", conn->name().c_str(), key.c_str());
+        return Action::kContinue;
+    }
+    FlightPtr flight = slot;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(flight->start_ns + timeout_ns - now);
+    flight->cond.wait_until(lock, deadline, [&flight]() { return flight->done; });
+    lock.unlock();
+
+    if(flight->entry)
+    {
+        _coalesced.fetch_add(1, std::memory_order_relaxed);
+        Serve(*ctx->response(), *flight->entry);
+        return Action::kRespond;
+    }
+    // leader 的响应不可缓存或等待超时，自行执行servlet
+    HTTP_F_DEBUG("conn[%s] response cache wait for leader gave up, key[%s]\n", conn->name().c_str(), key.c_str());
+    return Action::kContinue;
+}
+
+HttpResponseCache::EntryPtr HttpResponseCache::build(const HttpRequest &req, HttpResponse &resp) const
+{
+    const int32_t status = resp.stateCode().toInt();
+    if(_config.statusCodes.end() == std::find(_config.statusCodes.begin(), _config.statusCodes.end(), status)
+        || resp.streaming() || resp.deferred() || !resp.segments().empty() || !resp.serialized().empty()
+        || resp.headers().has(HttpHeaderId::kSetCookie))
+    {
+        return nullptr;
+    }
+
+    const std::string_view cache_control = resp.header(HttpHeaderId::kCacheControl);
+    if(HasDirective(cache_control, "no-store") || HasDirective(cache_control, "no-cache")
+        || HasDirective(cache_control, "private"))
+    {
+        return nullptr;
+    }
+
+    // 响应按未参与键的请求头变化时无法正确命中
+    bool vary_ok = true;
+    ForEachToken(resp.header(HttpHeaderId::kVary), [&](std::string_view name) {
+        vary_ok = vary_ok && _config.varyHeaders.end() != std::find_if(_config.varyHeaders.begin(), _config.varyHeaders.end(),
+                                                                       [name](const std::string &h) { return HeaderNameEquals(h, name); });
+    });
+    if(!vary_ok)
+    {
+        return nullptr;
+    }
+
+    int64_t ttl_ms = _config.ttlMs;
+    const int64_t max_age = MaxAgeSeconds(cache_control);
+    if(max_age >= 0)
+    {
+        ttl_ms = max_age * 1000;
+    }
+    if(ttl_ms <= 0)
+    {
+        return nullptr;
+    }
+
+    auto entry = std::make_shared<Entry>();
+    entry->path = req.path();
+    entry->status = status;
+    entry->header_keep_alive = std::make_shared<const std::string>(resp.headerPrefix(true));
+    entry->header_close = std::make_shared<const std::string>(resp.headerPrefix(false));
+    entry->body = std::make_shared<const std::string>(resp.body().view());
+    entry->expire_ns = metrics::NowNs() + ttl_ms * 1000000;
+    if(entry->bytes() > _config.maxEntryBytes)
+    {
+        return nullptr;
+    }
+    return entry;
+}
+
+void HttpResponseCache::finish(const std::string &key, const HttpContext *leader, EntryPtr entry)
+{
+    FlightPtr flight;
+    {
+    std::lock_guard<std::mutex> lock(_flightMutex);
+    auto it = _flights.find(key);
+    if(it == _flights.end() || it->second->leader != leader)
+    {
+        return;
+    }
+    flight = std::move(it->second);
+    _flights.erase(it);
+    // 先入缓存再移除填充记录，之后的请求要么命中要么成为新的 leader
+    if(entry)
+    {
+        _cache.put(key, entry);
+        _stores.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        _uncacheable.fetch_add(1, std::memory_order_relaxed);
+    }
+    flight->entry = std::move(entry);
+    flight->done = true;
+    }
+    flight->cond.notify_all();
+}
+
+void HttpResponseCache::after(const TcpConnectionPtr &conn, const HttpContextPtr &ctx)
+{
+    const HttpRequest &req = *ctx->request();
+    if(!MethodAllowed(_config.methods, req.method()))
+    {
+        return;
+    }
+
+    const std::string key = makeKey(req);
+    {
+    // 命中、等待者与绕过的请求都不是 leader
+    std::lock_guard<std::mutex> lock(_flightMutex);
+    auto it = _flights.find(key);
+    if(it == _flights.end() || it->second->leader != ctx.get())
+    {
+        return;
+    }
+    }
+
+    EntryPtr entry = build(req, *ctx->response());
+    if(!entry)
+    {
+        HTTP_F_DEBUG("conn[%s] response not cacheable, key[%s]\n", conn->name().c_str(), key.c_str());
+    }
+    finish(key, ctx.get(), std::move(entry));
+}
+
+size_t HttpResponseCache::invalidate(const std::string &path)
+{
+    return _cache.eraseIf([&path](const std::string&, const EntryPtr &entry) {
+        return entry->path == path;
+    });
+}
+
+void HttpResponseCache::clear()
+{
+    _cache.clear();
+}
+
+HttpResponseCache::Stats HttpResponseCache::stats() const
+{
+    Stats stats;
+    stats.hits = _hits.load(std::memory_order_relaxed);
+    stats.misses = _misses.load(std::memory_order_relaxed);
+    stats.coalesced = _coalesced.load(std::memory_order_relaxed);
+    stats.expired = _expired.load(std::memory_order_relaxed);
+    stats.stores = _stores.load(std::memory_order_relaxed);
+    stats.uncacheable = _uncacheable.load(std::memory_order_relaxed);
+    stats.bypassed = _bypassed.load(std::memory_order_relaxed);
+    stats.evictions = _cache.evictions();
+    stats.bytes = _cache.weight();
+    stats.entries = _cache.size();
+    return stats;
+}
+
+}   // kit_muduo::http
@@ -0,0 +1,262 @@
+/**
+ * @file http_scanner.cpp
+ * @brief HTTP报文分隔符扫描(SSE4.2/AVX2 加速，运行时按CPU分派)
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 16:10:22
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_scanner.h"
+
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KIT_HTTP_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace kit_muduo::http {
+
+namespace {
+
+struct ScanOps {
+    HttpScanLevel level;
+    const char* (*findByte)(const char*, const char*, char);
+    const char* (*findEither)(const char*, const char*, char, char);
+    const char* (*findCRLF)(const char*, const char*);
+};
+
+/****************** 标量实现 ******************/
+const char* ScalarFindByte(const char *begin, const char *end, char c)
+{
+    return static_cast<const char*>(std::memchr(begin, c, end - begin));
+}
+
+const char* ScalarFindEither(const char *begin, const char *end, char a, char b)
+{
+    for(const char *p = begin; p < end; ++p)
+    {
+        if(*p == a || *p == b)
+        {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+const char* ScalarFindCRLF(const char *begin, const char *end)
+{
+    const char *p = begin;
+    while(p + 1 < end)
+    {
+        p = static_cast<const char*>(std::memchr(p, '\r', end - 1 - p));
+        if(!p)
+        {
+            return nullptr;
+        }
+        if('\n' == p[1])
+        {
+            return p;
+        }
+        ++p;
+    }
+    return nullptr;
+}
+
+const ScanOps kScalarOps = {HttpScanLevel::kScalar, ScalarFindByte, ScalarFindEither, ScalarFindCRLF};
+
+#ifdef KIT_HTTP_SCAN_X86
+/****************** SSE4.2 ******************/
+__attribute__((target("sse4.2")))
+const char* SSE42FindByte(const char *begin, const char *end, char c)
+{
+    const __m128i needle = _mm_set1_epi8(c);
+    const char *p = begin;
+    for(; p + 16 <= end; p += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        if(mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return ScalarFindByte(p, end, c);
+}
+
+__attribute__((target("sse4.2")))
+const char* SSE42FindEither(const char *begin, const char *end, char a, char b)
+{
+    // pcmpestri 的 "任一相等" 模式，一条指令完成16字节对两个候选字符的匹配
+    const __m128i needles = _mm_setr_epi8(a, b, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const char *p = begin;
+    for(; p + 16 <= end; p += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int idx = _mm_cmpestri(needles, 2, chunk, 16,
+                               _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+        if(idx < 16)
+        {
+            return p + idx;
+        }
+    }
+    return ScalarFindEither(p, end, a, b);
+}
+
+__attribute__((target("sse4.2")))
+const char* SSE42FindCRLF(const char *begin, const char *end)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const char *p = begin;
+    // 同时比较 p 处的 '\r' 与 p+1 处的 '\n'，跨块的 CRLF 也不会漏掉
+    for(; p + 17 <= end; p += 16)
+    {
+        __m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(c0, cr)) & _mm_movemask_epi8(_mm_cmpeq_epi8(c1, lf));
+        if(mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return ScalarFindCRLF(p, end);
+}
+
+const ScanOps kSSE42Ops = {HttpScanLevel::kSSE42, SSE42FindByte, SSE42FindEither, SSE42FindCRLF};
+
+/****************** AVX2 ******************/
+__attribute__((target("avx2")))
+const char* AVX2FindByte(const char *begin, const char *end, char c)
+{
+    const __m256i needle = _mm256_set1_epi8(c);
+    const char *p = begin;
+    for(; p + 32 <= end; p += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+        if(mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return SSE42FindByte(p, end, c);
+}
+
+__attribute__((target("avx2")))
+const char* AVX2FindEither(const char *begin, const char *end, char a, char b)
+{
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    const char *p = begin;
+    for(; p + 32 <= end; p += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, va), _mm256_cmpeq_epi8(chunk, vb));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if(mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return SSE42FindEither(p, end, a, b);
+}
+
+__attribute__((target("avx2")))
+const char* AVX2FindCRLF(const char *begin, const char *end)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const char *p = begin;
+    for(; p + 33 <= end; p += 32)
+    {
+        __m256i c0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i c1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        __m256i hit = _mm256_and_si256(_mm256_cmpeq_epi8(c0, cr), _mm256_cmpeq_epi8(c1, lf));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if(mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return SSE42FindCRLF(p, end);
+}
+
+const ScanOps kAVX2Ops = {HttpScanLevel::kAVX2, AVX2FindByte, AVX2FindEither, AVX2FindCRLF};
+#endif
+
+const ScanOps* OpsFor(HttpScanLevel level)
+{
+#ifdef KIT_HTTP_SCAN_X86
+    switch(level)
+    {
+    case HttpScanLevel::kAVX2: return &kAVX2Ops;
+    case HttpScanLevel::kSSE42: return &kSSE42Ops;
+    default: break;
+    }
+#endif
+    return &kScalarOps;
+}
+
+std::atomic<const ScanOps*> g_ops{OpsFor(DetectHttpScanLevel())};
+
+}
+
+const char* HttpScanLevelName(HttpScanLevel level)
+{
+    switch(level)
+    {
+    case HttpScanLevel::kAVX2: return "avx2";
+    case HttpScanLevel::kSSE42: return "sse4.2";
+    default: return "scalar";
+    }
+}
+
+HttpScanLevel DetectHttpScanLevel()
+{
+#ifdef KIT_HTTP_SCAN_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+    {
+        return HttpScanLevel::kAVX2;
+    }
+    if(__builtin_cpu_supports("sse4.2"))
+    {
+        return HttpScanLevel::kSSE42;
+    }
+#endif
+    return HttpScanLevel::kScalar;
+}
+
+HttpScanLevel HttpScanLevelInUse()
+{
+    return g_ops.load(std::memory_order_relaxed)->level;
+}
+
+bool SetHttpScanLevel(HttpScanLevel level)
+{
+    if(static_cast<uint8_t>(level) > static_cast<uint8_t>(DetectHttpScanLevel()))
+    {
+        return false;
+    }
+    g_ops.store(OpsFor(level), std::memory_order_relaxed);
+    return true;
+}
+
+const char* HttpFindByte(const char *begin, const char *end, char c)
+{
+    return begin < end ? g_ops.load(std::memory_order_relaxed)->findByte(begin, end, c) : nullptr;
+}
+
+const char* HttpFindEither(const char *begin, const char *end, char a, char b)
+{
+    return begin < end ? g_ops.load(std::memory_order_relaxed)->findEither(begin, end, a, b) : nullptr;
+}
+
+const char* HttpFindCRLF(const char *begin, const char *end)
+{
+    return begin < end ? g_ops.load(std::memory_order_relaxed)->findCRLF(begin, end) : nullptr;
+}
+
+}   // kit_muduo::http
@@ -10,14 +10,242 @@
 #include "net/http/http_context.h"
 #include "net/http/http_servlet.h"
 #include "net/http/http_util.h"
+#include "net/http/http_header_cache.h"
+#include "net/event_loop.h"
 #include "net/net_log.h"
 #include "net/http/http_request.h"
 #include "net/http/http_response.h"
-#include "base/content_parser.h"
+#include "net/http/websocket.h"
+#include "net/http/http2.h"
+#include "base/digest.h"
+#include "base/json_stream.h"
+#include "base/metrics.h"
+#include "base/trace.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
 
 namespace kit_muduo {
 namespace http {
 
+namespace {
+
+/// @brief 小于该长度的文件区间直接 pread 后与头部合并发送，sendfile 省下的拷贝抵不过多一次系统调用
+constexpr size_t kSendFileMinBytes = 16 * 1024;
+
+/**
+ * @brief 发送带分段Body的响应：相邻的头部、内存数据与小文件区间合并为一次 send，
+ *        大文件区间走 sendfile
+ */
+void SendSegments(const TcpConnectionPtr &conn, HttpResponse &resp)
+{
+    std::string pending = resp.headerString();
+    for(auto &seg : resp.segments())
+    {
+        if(!seg.file)
+        {
+            pending += seg.data;
+            continue;
+        }
+
+        if(seg.length < kSendFileMinBytes)
+        {
+            size_t old_size = pending.size();
+            pending.resize(old_size + seg.length);
+            ssize_t n = ::pread(seg.file->fd(), &pending[old_size], seg.length, seg.offset);
+            if(n == static_cast<ssize_t>(seg.length))
+            {
+                continue;
+            }
+            // 读取失败时退回 sendfile，由发送路径处理截断
+            pending.resize(old_size);
+        }
+
+        if(!pending.empty())
+        {
+            conn->send(std::move(pending));
+            pending.clear();
+        }
+        conn->sendFile(seg.file, seg.offset, seg.length);
+    }
+
+    if(!pending.empty())
+    {
+        conn->send(std::move(pending));
+    }
+}
+
+/**
+ * @brief 按响应形态(预序列化/内存/分段)发送完整响应，必要时关闭连接；
+ *        HTTP/2 流上的请求交给所属会话按流发送
+ */
+void SendResponse(const TcpConnectionPtr &conn, const HttpContextPtr &ctx, HttpResponse &resp)
+{
+    if(ctx->isHttp2())
+    {
+        if(auto session = ctx->http2StreamSession())
+        {
+            session->submitResponse(ctx->http2StreamId(), resp, HttpRequest::Method::kHead == ctx->request()->method()());
+        }
+        return;
+    }
+
+    if(!resp.serialized().empty())
+    {
+        // 预序列化响应(如热点资源缓存)直接引用共享缓冲发送，文件内容随后 sendfile
+        conn->send(resp.serialized());
+        for(auto &seg : resp.segments())
+        {
+            if(seg.file)
+            {
+                conn->sendFile(seg.file, seg.offset, seg.length);
+            }
+            else
+            {
+                conn->send(seg.data);
+            }
+        }
+    }
+    else if(resp.segments().empty())
+    {
+        // TODO 这里都要改 send 接口不应该是string
+        conn->send(resp.toString());
+    }
+    else
+    {
+        SendSegments(conn, resp);
+    }
+    if(resp.connectionClosed())
+    {
+        conn->shutdown();
+    }
+}
+
+/**
+ * @brief 发送响应并记录 loop.hop / socket.write / http.request 追踪区间
+ * @note 业务线程中的发送经 queueInLoop 按序在IO线程执行，前后各插入一个标记回调，
+ *       分别量出跨线程切换与写socket的耗时；IO线程内发送是同步的，直接计时
+ */
+void SendTraced(const TcpConnectionPtr &conn, HttpResponse &resp, const HttpContextPtr &ctx)
+{
+    const uint64_t trace_id = ctx->traceId();
+    if(0 == trace_id)
+    {
+        SendResponse(conn, ctx, resp);
+        return;
+    }
+
+    const int64_t request_begin = ctx->traceBeginNs();
+    std::string detail = ctx->request()->method().toString();
+    detail.append(1, ' ').append(ctx->request()->path());
+
+    EventLoop *loop = conn->getLoop();
+    if(loop->isInLoopThread())
+    {
+        {
+        trace::Span span(trace_id, "socket.write");
+        SendResponse(conn, ctx, resp);
+        }
+        trace::Record(trace_id, "http.request", request_begin, metrics::NowNs(), detail);
+        return;
+    }
+
+    auto hop_end = std::make_shared<int64_t>(0);
+    const int64_t posted = metrics::NowNs();
+    loop->queueInLoop([trace_id, posted, hop_end]() {
+        *hop_end = metrics::NowNs();
+        trace::Record(trace_id, "loop.hop", posted, *hop_end);
+    });
+    SendResponse(conn, ctx, resp);
+    loop->queueInLoop([trace_id, request_begin, hop_end, detail = std::move(detail)]() {
+        const int64_t now = metrics::NowNs();
+        trace::Record(trace_id, "socket.write", *hop_end, now);
+        trace::Record(trace_id, "http.request", request_begin, now, detail);
+    });
+}
+
+/// @brief 事件循环快照直接以 JSON 写入响应Body
+void RenderLoops(const std::vector<TcpServer::LoopSnapshot> &loops, Body *out)
+{
+    JsonWriter<Body> writer(out);
+    writer.beginObject();
+    writer.key("loops");
+    writer.beginArray();
+    for(auto &snap : loops)
+    {
+        writer.beginObject();
+        writer.key("thread_id");
+        writer.intValue(snap.loop.thread_id);
+        writer.key("looping");
+        writer.boolValue(snap.loop.looping);
+        writer.key("channels");
+        writer.uintValue(snap.loop.channels);
+        writer.key("timers");
+        writer.uintValue(snap.loop.timers);
+        writer.key("pending_funcs");
+        writer.uintValue(snap.loop.pending_funcs);
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.endObject();
+}
+
+void RenderConnections(const std::vector<TcpServer::LoopSnapshot> &loops, Body *out)
+{
+    size_t count = 0;
+    for(auto &snap : loops)
+    {
+        count += snap.connections.size();
+    }
+
+    JsonWriter<Body> writer(out);
+    writer.beginObject();
+    writer.key("count");
+    writer.uintValue(count);
+    writer.key("connections");
+    writer.beginArray();
+    for(auto &snap : loops)
+    {
+        for(auto &conn : snap.connections)
+        {
+            writer.beginObject();
+            writer.key("name");
+            writer.stringValue(conn.name);
+            writer.key("fd");
+            writer.intValue(conn.fd);
+            writer.key("peer");
+            writer.stringValue(conn.peer);
+            writer.key("state");
+            writer.stringValue(conn.state);
+            writer.key("loop_thread_id");
+            writer.intValue(snap.loop.thread_id);
+            writer.key("bytes_read");
+            writer.uintValue(conn.bytes_read);
+            writer.key("bytes_written");
+            writer.uintValue(conn.bytes_written);
+            writer.key("input_bytes");
+            writer.uintValue(conn.input_bytes);
+            writer.key("input_capacity");
+            writer.uintValue(conn.input_capacity);
+            writer.key("output_bytes");
+            writer.uintValue(conn.output_bytes);
+            writer.key("output_capacity");
+            writer.uintValue(conn.output_capacity);
+            writer.key("output_segments");
+            writer.uintValue(conn.output_segments);
+            writer.key("pending_bytes");
+            writer.uintValue(conn.pending_bytes);
+            writer.endObject();
+        }
+    }
+    writer.endArray();
+    writer.endObject();
+}
+
+}
+
 
 HttpServer::HttpServer(EventLoop *loop, const InetAddress &addr, const std::string &name, bool isPool, TcpServer::Option option)
     :_server(loop, addr, name, option)
@@ -38,8 +266,25 @@ HttpServer::HttpServer(EventLoop *loop, const InetAddress &addr, const std::stri
     setHttpCallback(std::bind(&HttpServer::handleRequest, this, std::placeholders::_1, std::placeholders::_2));
 }
 
+HttpServer::~HttpServer()
+{
+    if(_dateTimer)
+    {
+        _server.getLoop()->cancel(_dateTimer);
+        HttpDateCache::Release();
+    }
+}
+
 void HttpServer::start()
 {
+    if(!_dateTimer)
+    {
+        HttpDateCache::Retain();
+        _dateTimer = _server.getLoop()->runEvery(HttpDateCache::kRefreshIntervalMs, [](){
+            HttpDateCache::Refresh(::time(nullptr));
+        });
+    }
+
     if(_isPool)
     {
         _businessThreadPool.setMode(ThreadPool::CACHE_MOD);
@@ -196,20 +441,113 @@ std::vector<RouteInfo> HttpServer::listRoutes(const std::string &pattern) const
     return _dispatch->listRoutes(pattern);
 }
 
+bool HttpServer::enableIntrospection(const std::string &prefix)
+{
+    bool ok = Get(prefix + "/metrics", [](TcpConnectionPtr conn, HttpContextPtr ctx) {
+        auto resp = ctx->response();
+        const std::string text = metrics::FormatPrometheus(metrics::MetricsRegistry::Instance().snapshot());
+        resp->setVersion(Version::kHttp11);
+        resp->setStateCode(StateCode::k200Ok);
+        resp->body().setContentType(ContentType::kUnknowType);
+        resp->addHeader("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+        resp->addHeader("Cache-Control", "no-store");
+        resp->body().appendData(text);
+    });
+
+    ok = Get(prefix + "/debug/connections", [this](TcpConnectionPtr conn, HttpContextPtr ctx) {
+        replySnapshot(conn, ctx, true);
+    }) && ok;
+
+    ok = Get(prefix + "/debug/loops", [this](TcpConnectionPtr conn, HttpContextPtr ctx) {
+        replySnapshot(conn, ctx, false);
+    }) && ok;
+
+    // ?clear=1 导出后清空
+    ok = Get(prefix + "/debug/trace", [](TcpConnectionPtr conn, HttpContextPtr ctx) {
+        auto resp = ctx->response();
+        resp->setVersion(Version::kHttp11);
+        resp->setStateCode(StateCode::k200Ok);
+        resp->body().setContentType(ContentType::kJsonType);
+        resp->addHeader("Cache-Control", "no-store");
+        resp->body().appendData(trace::DumpChromeTrace());
+        if("1" == ctx->request()->getQureyParam("clear"))
+        {
+            trace::Clear();
+        }
+    }) && ok;
+
+    return ok;
+}
+
+void HttpServer::replySnapshot(const TcpConnectionPtr &conn, const HttpContextPtr &ctx, bool withConnections)
+{
+    ctx->response()->setDeferred(true);
+    _server.collectSnapshot([this, conn, ctx, withConnections](std::vector<TcpServer::LoopSnapshot> loops) {
+        auto snapshot = std::make_shared<std::vector<TcpServer::LoopSnapshot>>(std::move(loops));
+        auto render = [conn, ctx, snapshot, withConnections]() {
+            auto resp = ctx->response();
+            resp->setVersion(Version::kHttp11);
+            resp->setStateCode(StateCode::k200Ok);
+            resp->body().setContentType(ContentType::kJsonType);
+            resp->addHeader("Cache-Control", "no-store");
+            if(withConnections)
+            {
+                RenderConnections(*snapshot, &resp->body());
+            }
+            else
+            {
+                RenderLoops(*snapshot, &resp->body());
+            }
+            SendResponse(conn, ctx, *resp);
+        };
+
+        // 这里运行在最后完成采集的IO线程，渲染交给业务线程池；池满或未启用时就地渲染
+        if(!_isPool || !_businessThreadPool.trySubmitTask(0, render).ok())
+        {
+            render();
+        }
+    }, withConnections);
+}
+
 void HttpServer::onConnect(TcpConnectionPtr conn)
 {
     if(conn->connected())
     {
         HTTP_F_INFO("==> new connection fd[%d][%s] \n", conn->fd(), conn->peerAddr().toIpPort().c_str());
 
-        conn->setContext(std::make_shared<HttpContext>());
+        conn->setContext(newContext(conn));
     }
     else
     {
         HTTP_F_INFO("==> disconnected connection  fd[%d][%s] \n", conn->fd(), conn->peerAddr().toIpPort().c_str());
+        auto context = std::static_pointer_cast<HttpContext>(conn->getContext());
+        if(context && context->webSocket())
+        {
+            context->webSocket()->onDisconnected();
+        }
+        if(context && context->http2Session())
+        {
+            context->http2Session()->onDisconnected();
+        }
     }
 }
 
+HttpContextPtr HttpServer::newContext(const TcpConnectionPtr &conn)
+{
+    auto context = std::make_shared<HttpContext>();
+    // 上下文由连接持有，这里只能弱引用连接
+    std::weak_ptr<TcpConnection> weak_conn = conn;
+    context->setBodySinkResolver([dispatch = _dispatch, weak_conn](const HttpContextPtr &ctx) -> HttpBodySink::Ptr {
+        TcpConnectionPtr conn = weak_conn.lock();
+        if(!conn)
+        {
+            return nullptr;
+        }
+        return dispatch->createBodySink(conn, ctx);
+    });
+    return context;
+}
+
 void HttpServer::onMessage(TcpConnectionPtr conn, Buffer *buf, TimeStamp receiveTime)
 {
     std::shared_ptr<HttpContext> context = std::static_pointer_cast<HttpContext>(conn->getContext());
@@ -219,10 +557,45 @@ void HttpServer::onMessage(TcpConnectionPtr conn, Buffer *buf, TimeStamp receive
         return;
     }
 
+    // 已升级的连接不再按HTTP解析
+    if(auto ws = context->webSocket())
+    {
+        ws->onData(*buf);
+        return;
+    }
+    if(auto session = context->http2Session())
+    {
+        session->onData(*buf);
+        return;
+    }
+
     while(buf->readableBytes() > 0)
     {
         size_t before_len = buf->readableBytes();
 
+        // 先验知识方式的 h2c: 新请求以连接前言开头
+        if(_http2Enabled && HttpContext::kExpectRequestLine == context->state())
+        {
+            const size_t n = std::min(buf->readableBytes(), kHttp2ClientPreface.size());
+            if(0 == std::memcmp(buf->peek(), kHttp2ClientPreface.data(), n))
+            {
+                if(n < kHttp2ClientPreface.size())
+                {
+                    break;
+                }
+                Http2Session::Ptr session = startHttp2(conn);
+                session->start();
+                session->onData(*buf);
+                return;
+            }
+        }
+
+        // 关闭追踪时只有一次原子读
+        if(trace::Enabled() && !context->traceStarted())
+        {
+            context->startTrace(trace::Sample(), metrics::NowNs());
+        }
+
         if(!context->parseRequest(*buf, receiveTime))
         {
             HTTP_ERROR() << "http request parse error! " << std::endl;
@@ -241,67 +614,195 @@ void HttpServer::onMessage(TcpConnectionPtr conn, Buffer *buf, TimeStamp receive
             break;
         }
 
+        trace::Record(context->traceId(), "http.parse", context->traceBeginNs(), metrics::NowNs());
+
+        if(_http2Enabled && upgradeHttp2(conn, context, buf))
+        {
+            return;
+        }
+
+        if(!_webSockets.empty() && upgradeWebSocket(conn, context, buf))
+        {
+            return;
+        }
+
         _httpCallBack(conn, context);
         // 重置conn中的上下文
-        context = std::make_shared<HttpContext>();
+        context = newContext(conn);
         conn->setContext(context);
     }
 
 
 }
 
+bool HttpServer::upgradeWebSocket(const TcpConnectionPtr &conn, const HttpContextPtr &ctx, Buffer *buf)
+{
+    const HttpRequest &req = *ctx->request();
+    auto it = _webSockets.find(req.path());
+    int32_t status = 0;
+    if(it == _webSockets.end() || (!IsWebSocketUpgrade(req, &status) && 0 == status))
+    {
+        return false;
+    }
+    if(0 == status && !it->second.handler->accept(req))
+    {
+        status = StateCode::k403Forbidden;
+    }
+
+    if(0 != status)
+    {
+        HTTP_F_WARN("conn[%s] websocket upgrade on [%s] rejected with %d\n", conn->name().c_str(), req.path().c_str(), status);
+        auto resp = ctx->response();
+        resp->setVersion(Version::kHttp11);
+        resp->setStateCode(status);
+        resp->setConnectionClosed(true);
+        if(StateCode::k426UpgradeRequired == status)
+        {
+            resp->headers().set("Sec-WebSocket-Version", "13");
+        }
+        conn->send(resp->toString());
+        conn->shutdown();
+        return true;
+    }
+
+    std::string handshake = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: ";
+    handshake.append(WebSocketAcceptKey(TrimHttpSpace(req.header("Sec-WebSocket-Key")))).append("\r\n\r\n");
+    conn->send(std::move(handshake));
+
+    auto ws = std::make_shared<WebSocketConnection>(conn, it->second.handler, req.path(), it->second.config);
+    ctx->setWebSocket(ws);
+    ws->onOpen();
+    // 客户端可能紧跟握手发送了帧
+    if(buf->readableBytes() > 0)
+    {
+        ws->onData(*buf);
+    }
+    return true;
+}
+
+Http2Session::Ptr HttpServer::startHttp2(const TcpConnectionPtr &conn)
+{
+    auto session = std::make_shared<Http2Session>(conn, _http2Config,
+        std::bind(&HttpServer::newContext, this, std::placeholders::_1), _httpCallBack);
+    // 连接级上下文持有会话，各流的上下文由会话创建与持有
+    auto context = newContext(conn);
+    context->setHttp2Session(session);
+    conn->setContext(context);
+    HTTP_F_DEBUG("conn[%s] switch to http/2\n", conn->name().c_str());
+    return session;
+}
+
+bool HttpServer::upgradeHttp2(const TcpConnectionPtr &conn, const HttpContextPtr &ctx, Buffer *buf)
+{
+    const HttpRequest &req = *ctx->request();
+    if(Version::kHttp11 != req.version()() || !HeaderHasToken(req.header(HttpHeaderId::kUpgrade), "h2c")
+       || !HeaderHasToken(req.header(HttpHeaderId::kConnection), "HTTP2-Settings"))
+    {
+        return false;
+    }
+
+    // HTTP2-Settings 为 base64url(无填充)编码的 SETTINGS 负载
+    std::string encoded(TrimHttpSpace(req.header("HTTP2-Settings")));
+    std::replace(encoded.begin(), encoded.end(), '-', '+');
+    std::replace(encoded.begin(), encoded.end(), '_', '/');
+    encoded.append((4 - encoded.size() % 4) % 4, '=');
+    std::string settings;
+    if(!Base64Decode(encoded, &settings))
+    {
+        // 升级是可选的，头部无效时按 HTTP/1.1 处理
+        HTTP_F_WARN("conn[%s] invalid HTTP2-Settings, ignore h2c upgrade\n", conn->name().c_str());
+        return false;
+    }
+
+    conn->send(std::string("HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n"));
+    Http2Session::Ptr session = startHttp2(conn);
+    if(!session->startUpgrade(settings, ctx))
+    {
+        return true;
+    }
+    // 客户端紧跟着发送连接前言
+    if(buf->readableBytes() > 0)
+    {
+        session->onData(*buf);
+    }
+    return true;
+}
+
+void HttpServer::enableHttp2(Http2Session::Config config)
+{
+    _http2Enabled = true;
+    _http2Config = std::move(config);
+}
+
+void HttpServer::addWebSocket(const std::string &path, WebSocketHandler::Ptr handler, WebSocketCodec::Config config)
+{
+    _webSockets[path] = WebSocketRoute{std::move(handler), std::move(config)};
+}
 
 #if 1
 void HttpServer::handleRequest(TcpConnectionPtr conn, HttpContextPtr ctx)
 {
-    auto work_func = [](TcpConnectionPtr conn, HttpContextPtr ctx, std::shared_ptr<HttpServletDispatch> dispatch) {
+    auto work_func = [](TcpConnectionPtr conn, HttpContextPtr ctx, std::shared_ptr<HttpServletDispatch> dispatch,
+                        std::shared_ptr<HttpCompressor> compressor, int64_t submitNs) {
 
         auto req_ptr = ctx->request();
         auto resp_ptr = ctx->response();
+        const uint64_t trace_id = ctx->traceId();
+        if(submitNs > 0)
+        {
+            trace::Record(trace_id, "pool.wait", submitNs, metrics::NowNs());
+        }
 
         HTTP_F_INFO("woker thread [%d]][%s] ===> %s \n", conn->fd(), conn->name().c_str(), req_ptr->path().c_str());
 
-        const std::string &connection = req_ptr->getHeader("Connection");
-        bool closed = (connection == "close")
-                || (Version::kHttp10 == req_ptr->version()() && connection != "keep-alive");
+        const std::string_view connection = req_ptr->header(HttpHeaderId::kConnection);
+        bool closed = HeaderNameEquals(connection, "close")
+                || (Version::kHttp10 == req_ptr->version()() && !HeaderNameEquals(connection, "keep-alive"));
         resp_ptr->setConnectionClosed(closed);
 
-        // TODO 中间层检验
-        // 1. 身份鉴权
-        // if(身份鉴权 == 1)
-        // {
-            // 实际业务分发
-            dispatch->handle(conn, ctx);
+        // 中间件(鉴权、CORS、限流等)与业务分发，见 HttpServletDispatch::use
+        {
+        trace::Span span(trace_id, "servlet");
+        dispatch->handle(conn, ctx);
+        }
 
-        // }
+        // 流式响应已由 HttpStreamWriter 自行写出并结束，延迟响应由异步回调发送
+        if(resp_ptr->streaming() || resp_ptr->deferred())
+        {
+            return;
+        }
 
-        // TODO 这里都要改 send 接口不应该是string
-        conn->send(resp_ptr->toString());
-        if(resp_ptr->connectionClosed())
+        if(compressor)
         {
-            conn->shutdown();
+            trace::Span span(trace_id, "compress");
+            compressor->apply(*req_ptr, *resp_ptr);
         }
 
+        SendTraced(conn, *resp_ptr, ctx);
+
     };
 
+    // 业务线程池中的处理顺序不确定，需要按请求顺序登记的servlet在IO线程先登记
+    _dispatch->prepare(conn, ctx);
+
     if(_isPool)
     {
-        auto submit_result = _businessThreadPool.trySubmitTask(_businessThreadPoolConfig.submitTimeoutMs, work_func, conn, ctx, _dispatch);
+        const int64_t submit_ns = ctx->traceId() ? metrics::NowNs() : 0;
+        auto submit_result = _businessThreadPool.trySubmitTask(_businessThreadPoolConfig.submitTimeoutMs, work_func, conn, ctx, _dispatch, _compressor, submit_ns);
 
         if(!submit_result.ok())
         {
             HTTP_F_WARN("submit task error! fd[%d][%s], path[%s] \n", conn->fd(), conn->name().c_str(), ctx->request()->path().c_str());
 
             ServiceUnavailable503Servlet::Handle(conn, ctx);
-            conn->send(ctx->response()->toString());
-            conn->shutdown();
+            SendResponse(conn, ctx, *ctx->response());
             return;
         }
 
     }
     else
     {
-        work_func(conn, ctx, _dispatch);
+        work_func(conn, ctx, _dispatch, _compressor, 0);
     }
 
 }
@@ -311,9 +812,9 @@ void HttpServer::handleRequest(TcpConnectionPtr conn, HttpContextPtr ctx)
 {
     auto req = ctx->request();
     auto resp = ctx->response();
-    const std::string &connection = req->getHeader("Connection");
-    bool closed = (connection == "close")
-            || (Version::kHttp10 == req->version()() && connection != "keep-alive");
+    const std::string_view connection = req->header(HttpHeaderId::kConnection);
+    bool closed = HeaderNameEquals(connection, "close")
+            || (Version::kHttp10 == req->version()() && !HeaderNameEquals(connection, "keep-alive"));
 
     HelloServlet svl;
 
@@ -14,10 +14,14 @@
 #include "net/net_log.h"
 #include "net/tcp_connection.h"
 #include "net/http/http_router.h"
+#include "net/http/http_header_cache.h"
 
 #include <algorithm>
-#include <fstream>
+#include <limits>
 #include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
 
 namespace kit_muduo::http {
 
@@ -320,21 +324,305 @@ void ServiceUnavailable503Servlet::Handle(TcpConnectionPtr conn, HttpContextPtr
     resp->body().appendData(body);
 }
 
+namespace {
+
+struct ByteRange {
+    uint64_t first{0};
+    uint64_t last{0};
+};
+
+enum class RangeParse {
+    /// @brief 无Range或Range非法，按完整内容返回
+    Ignore,
+    Ok,
+    Unsatisfiable,
+};
+
+void TrimSpace(std::string &str)
+{
+    size_t begin = str.find_first_not_of(" \t");
+    size_t end = str.find_last_not_of(" \t");
+    str = (std::string::npos == begin) ? std::string() : str.substr(begin, end - begin + 1);
+}
+
+bool ParseUint(const std::string &str, uint64_t *out)
+{
+    if(str.empty() || str.size() > 19)
+    {
+        return false;
+    }
+    uint64_t val = 0;
+    for(char c : str)
+    {
+        if(c < '0' || c > '9')
+        {
+            return false;
+        }
+        val = val * 10 + (c - '0');
+    }
+    *out = val;
+    return true;
+}
+
+/**
+ * @brief 解析 "bytes=a-b, c-, -n"，区间按文件大小裁剪，不可满足的区间被丢弃
+ */
+RangeParse ParseRange(const std::string &header, uint64_t size, std::vector<ByteRange> &ranges)
+{
+    static const std::string kPrefix = "bytes=";
+    if(header.compare(0, kPrefix.size(), kPrefix) != 0)
+    {
+        return RangeParse::Ignore;
+    }
+
+    std::stringstream ss(header.substr(kPrefix.size()));
+    std::string item;
+    size_t count = 0;
+    while(std::getline(ss, item, ','))
+    {
+        TrimSpace(item);
+        if(item.empty())
+        {
+            continue;
+        }
+        if(++count > StaticFileServlet::kMaxRanges)
+        {
+            return RangeParse::Ignore;
+        }
+
+        auto dash = item.find('-');
+        if(std::string::npos == dash)
+        {
+            return RangeParse::Ignore;
+        }
+        std::string first_str = item.substr(0, dash);
+        std::string last_str = item.substr(dash + 1);
+        TrimSpace(first_str);
+        TrimSpace(last_str);
+
+        ByteRange range;
+        if(first_str.empty())
+        {
+            // 后缀区间: 最后n个字节
+            uint64_t suffix = 0;
+            if(!ParseUint(last_str, &suffix))
+            {
+                return RangeParse::Ignore;
+            }
+            if(0 == suffix || 0 == size)
+            {
+                continue;
+            }
+            range.first = suffix >= size ? 0 : size - suffix;
+            range.last = size - 1;
+        }
+        else
+        {
+            if(!ParseUint(first_str, &range.first))
+            {
+                return RangeParse::Ignore;
+            }
+            range.last = size > 0 ? size - 1 : 0;
+            if(!last_str.empty())
+            {
+                uint64_t last = 0;
+                if(!ParseUint(last_str, &last) || last < range.first)
+                {
+                    return RangeParse::Ignore;
+                }
+                range.last = std::min(last, range.last);
+            }
+            if(range.first >= size)
+            {
+                continue;
+            }
+        }
+        ranges.push_back(range);
+    }
+
+    if(0 == count)
+    {
+        return RangeParse::Ignore;
+    }
+    return ranges.empty() ? RangeParse::Unsatisfiable : RangeParse::Ok;
+}
+
+/// @brief If-None-Match 使用弱比较，"*" 匹配任意实体
+bool ETagListMatch(const std::string &header, const std::string &etag)
+{
+    std::stringstream ss(header);
+    std::string item;
+    while(std::getline(ss, item, ','))
+    {
+        TrimSpace(item);
+        if("*" == item)
+        {
+            return true;
+        }
+        if(item.compare(0, 2, "W/") == 0)
+        {
+            item = item.substr(2);
+        }
+        if(item == etag)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief 条件请求判定: If-None-Match 优先于 If-Modified-Since
+bool NotModified(const std::string &ifNoneMatch, const std::string &ifModifiedSince, const std::string &etag, time_t mtime)
+{
+    if(!ifNoneMatch.empty())
+    {
+        return ETagListMatch(ifNoneMatch, etag);
+    }
+    time_t since = 0;
+    return !ifModifiedSince.empty() && ParseHttpDate(ifModifiedSince, &since) && mtime <= since;
+}
+
+std::string ContentRange(uint64_t first, uint64_t last, uint64_t size)
+{
+    return "bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(size);
+}
+
+std::string NextByteRangesBoundary()
+{
+    static std::atomic<uint64_t> s_boundarySeq{0};
+    char buf[48] = {0};
+    int n = ::snprintf(buf, sizeof(buf), "kit_byteranges_%016lx",
+                       static_cast<unsigned long>(s_boundarySeq.fetch_add(1, std::memory_order_relaxed)));
+    return std::string(buf, n);
+}
+
+/// @brief 发送热点资源: 预序列化头部，内容为共享缓冲或 memfd(走 sendfile)
+void SendAsset(HttpResponse &resp, const HttpAssetCache::Asset &asset)
+{
+    resp.setVersion(Version::kHttp11);
+    resp.setStateCode(StateCode::k200Ok);
+    const SharedBuffer &header = resp.connectionClosed() ? asset.header_close : asset.header_keep_alive;
+    if(asset.body_file)
+    {
+        resp.setSerialized({header, HttpDateCache::DateBlock()});
+        resp.addFileSegment(asset.body_file, 0, asset.body_file->size());
+        return;
+    }
+    resp.setSerialized({header, HttpDateCache::DateBlock(), asset.body});
+}
+
+}
+
 StaticFileServlet::StaticFileServlet()
     :HttpServlet("FileServlet", "kit_server")
+    ,_root_dir("web")
+    ,_legacy_layout(true)
+    ,_cache(std::make_shared<HttpFileCache>())
+    ,_asset_cache(std::make_shared<HttpAssetCache>())
 {}
 
-static int32_t GetStaticType(const std::string &suffix_type)
+StaticFileServlet::StaticFileServlet(const std::string &rootDir, const std::string &urlPrefix, std::shared_ptr<HttpFileCache> cache)
+    :HttpServlet("FileServlet", "kit_server")
+    ,_root_dir(rootDir)
+    ,_url_prefix(urlPrefix)
+    ,_legacy_layout(false)
+    ,_cache(cache ? std::move(cache) : std::make_shared<HttpFileCache>())
+    ,_asset_cache(std::make_shared<HttpAssetCache>())
+{
+    while(_root_dir.size() > 1 && '/' == _root_dir.back())
+    {
+        _root_dir.pop_back();
+    }
+}
+
+const char* StaticFileServlet::MimeType(const std::string &suffix)
 {
-    if(suffix_type == "html")
-        return ContentType::kHtml;
-    else if(suffix_type == "jpg" || suffix_type == "jpeg")
-        return ContentType::kImageJpgType;
-    else if(suffix_type == "css")
-        return ContentType::kCss;
-    else if(suffix_type == "js")
-        return ContentType::kJavaScript;
-    return ContentType::kJsonType;
+    static const std::unordered_map<std::string, const char*> kMimeTypes = {
+        {"html",  "text/html; charset=utf-8"},
+        {"htm",   "text/html; charset=utf-8"},
+        {"css",   "text/css; charset=utf-8"},
+        {"js",    "text/javascript; charset=utf-8"},
+        {"json",  "application/json; charset=utf-8"},
+        {"txt",   "text/plain; charset=utf-8"},
+        {"xml",   "application/xml; charset=utf-8"},
+        {"jpg",   "image/jpeg"},
+        {"jpeg",  "image/jpeg"},
+        {"png",   "image/png"},
+        {"gif",   "image/gif"},
+        {"svg",   "image/svg+xml"},
+        {"ico",   "image/x-icon"},
+        {"webp",  "image/webp"},
+        {"woff",  "font/woff"},
+        {"woff2", "font/woff2"},
+        {"wasm",  "application/wasm"},
+        {"pdf",   "application/pdf"},
+        {"mp4",   "video/mp4"},
+        {"m4v",   "video/mp4"},
+        {"m4a",   "audio/mp4"},
+        {"m4s",   "video/iso.segment"},
+        {"ts",    "video/mp2t"},
+        {"m3u8",  "application/vnd.apple.mpegurl"},
+        {"mpd",   "application/dash+xml"},
+        {"webm",  "video/webm"},
+    };
+    std::string lower = suffix;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    auto it = kMimeTypes.find(lower);
+    return it == kMimeTypes.end() ? "application/octet-stream" : it->second;
+}
+
+std::string StaticFileServlet::resolvePath(const std::string &path) const
+{
+    if(_legacy_layout)
+    {
+        // 文件名全称
+        auto pos = path.find_last_of("/");
+        std::string file_name = path.substr(pos + 1);
+        // 文件类型
+        pos = file_name.find_last_of(".");
+        const std::string suffix_type = std::string::npos == pos ? "" : file_name.substr(pos + 1);
+        if(file_name.empty() || ".." == file_name)
+        {
+            return "";
+        }
+        return _root_dir + "/" + suffix_type + "/" + file_name;
+    }
+
+    std::string rel = path;
+    if(!_url_prefix.empty() && rel.compare(0, _url_prefix.size(), _url_prefix) == 0)
+    {
+        rel = rel.substr(_url_prefix.size());
+    }
+    if(rel.empty() || '/' != rel[0])
+    {
+        rel = "/" + rel;
+    }
+
+    // 拒绝跳出根目录的路径
+    size_t begin = 0;
+    while(begin < rel.size())
+    {
+        size_t end = rel.find('/', begin);
+        if(std::string::npos == end)
+        {
+            end = rel.size();
+        }
+        if(rel.compare(begin, end - begin, "..") == 0 && end - begin == 2)
+        {
+            return "";
+        }
+        begin = end + 1;
+    }
+    if(rel.find('\0') != std::string::npos)
+    {
+        return "";
+    }
+
+    if('/' == rel.back())
+    {
+        rel += "index.html";
+    }
+    return _root_dir + rel;
 }
 
 void StaticFileServlet::handle(TcpConnectionPtr conn, HttpContextPtr ctx)
@@ -342,55 +630,594 @@ void StaticFileServlet::handle(TcpConnectionPtr conn, HttpContextPtr ctx)
     auto resp = ctx->response();
     auto req = ctx->request();
 
+    const std::string target_path = resolvePath(req->path());
+    if(target_path.empty())
+    {
+        HTTP_F_WARN("static file path rejected: %s\n", req->path().c_str());
+        NotFound404Servlet::Handle(conn, ctx);
+        return;
+    }
+
+    const bool head_only = HttpRequest::Method::kHead == req->method()();
+    const std::string range_header = req->getHeader("Range");
+    const std::string if_none_match = req->getHeader("If-None-Match");
+    const std::string if_modified_since = req->getHeader("If-Modified-Since");
+
+    const std::string file_name = target_path.substr(target_path.find_last_of('/') + 1);
+    const auto dot = file_name.find_last_of('.');
+    const std::string mime = MimeType(std::string::npos == dot ? "" : file_name.substr(dot + 1));
+
+    // 压缩协商只针对可压缩类型的完整请求，Range 始终按原文处理
+    std::shared_ptr<HttpCompressor> compressor = _compressor;
+    const bool vary_encoding = compressor && compressor->compressible(mime);
+    const HttpEncoding encoding = vary_encoding && range_header.empty() ? compressor->negotiate(*req) : HttpEncoding::kIdentity;
+
+    // 热点资源: 无条件、无区间、不压缩的完整GET直接发送预序列化响应
+    std::shared_ptr<HttpAssetCache> asset_cache = _asset_cache;
+    const bool plain_get = !head_only && range_header.empty() && if_none_match.empty() && if_modified_since.empty()
+                           && HttpEncoding::kIdentity == encoding;
+    if(asset_cache && plain_get)
+    {
+        HttpAssetCache::AssetPtr asset = asset_cache->get(target_path);
+        if(asset)
+        {
+            SendAsset(*resp, *asset);
+            return;
+        }
+    }
+
+    int32_t err = 0;
+    HttpFileCache::EntryPtr entry = _cache->get(target_path, &err);
+    if(!entry)
+    {
+        if(ENOENT == err || ENOTDIR == err || EISDIR == err || EINVAL == err)
+        {
+            NotFound404Servlet::Handle(conn, ctx);
+        }
+        else
+        {
+            HTTP_F_ERROR("file %s open error! %d:%s \n", target_path.c_str(), err, strerror(err));
+            resp->setVersion(Version::kHttp11);
+            resp->setStateCode(err == EACCES ? StateCode::k403Forbidden : StateCode::k500InternalServerError);
+        }
+        return;
+    }
+
+    const SharedFilePtr &file = entry->file;
+    const uint64_t size = file->size();
+
     resp->setVersion(Version::kHttp11);
-    resp->setStateCode(StateCode::k200Ok);
+    // Content-Type 由下面直接给出，不走 Body 的默认类型
+    resp->body().setContentType(ContentType::kUnknowType);
+
+    if(HttpEncoding::kIdentity != encoding
+        && handleCompressed(ctx, *compressor, encoding, target_path, *entry, mime))
+    {
+        return;
+    }
+
+    resp->addHeader("ETag", entry->etag);
+    resp->addHeader("Last-Modified", entry->last_modified);
+    resp->addHeader("Accept-Ranges", "bytes");
+    if(vary_encoding)
+    {
+        resp->addHeader("Vary", "Accept-Encoding");
+    }
+
+    if(NotModified(if_none_match, if_modified_since, entry->etag, entry->mtime))
+    {
+        resp->setStateCode(StateCode::k304NotModified);
+        return;
+    }
 
-    const std::string &path = req->path();
-    // 文件名全称
-    auto pos = path.find_last_of("/");
-    std::string file_name = path.substr(pos + 1);
-    // 文件类型
-    pos = file_name.find_last_of(".");
-    const std::string& suffix_type = file_name.substr(pos + 1);
+    std::vector<ByteRange> ranges;
+    RangeParse range_state = RangeParse::Ignore;
+    if(!range_header.empty())
+    {
+        // If-Range 不匹配时忽略Range，返回完整的新内容
+        const std::string if_range = req->getHeader("If-Range");
+        bool range_valid = if_range.empty()
+            || ('"' == if_range[0] ? if_range == entry->etag : if_range == entry->last_modified);
+        if(range_valid)
+        {
+            range_state = ParseRange(range_header, size, ranges);
+        }
+    }
 
-    resp->body().setContentType(GetStaticType(suffix_type));
+    std::vector<HttpResponse::BodySegment> segments;
+    size_t body_bytes = 0;
+    auto add_file = [&](uint64_t offset, uint64_t length) {
+        HttpResponse::BodySegment seg;
+        seg.file = file;
+        seg.offset = static_cast<off_t>(offset);
+        seg.length = length;
+        body_bytes += length;
+        segments.push_back(std::move(seg));
+    };
+    auto add_data = [&](std::string data) {
+        HttpResponse::BodySegment seg;
+        seg.length = data.size();
+        seg.data = std::move(data);
+        body_bytes += seg.length;
+        segments.push_back(std::move(seg));
+    };
 
-    const std::string target_path = "web/" + suffix_type + "/" + file_name;
+    if(RangeParse::Unsatisfiable == range_state)
+    {
+        resp->setStateCode(StateCode::k416RangeNotSatisfiable);
+        resp->addHeader("Content-Range", "bytes */" + std::to_string(size));
+        resp->addHeader("Content-Length", "0");
+        return;
+    }
+    else if(RangeParse::Ok == range_state && 1 == ranges.size())
+    {
+        resp->setStateCode(StateCode::k206PartialContent);
+        resp->addHeader("Content-Type", mime);
+        resp->addHeader("Content-Range", ContentRange(ranges[0].first, ranges[0].last, size));
+        add_file(ranges[0].first, ranges[0].last - ranges[0].first + 1);
+    }
+    else if(RangeParse::Ok == range_state)
+    {
+        const std::string boundary = NextByteRangesBoundary();
+        resp->setStateCode(StateCode::k206PartialContent);
+        resp->addHeader("Content-Type", "multipart/byteranges; boundary=" + boundary);
+        for(auto &range : ranges)
+        {
+            add_data("\r\n--" + boundary + "\r\n"
+                     "Content-Type: " + mime + "\r\n"
+                     "Content-Range: " + ContentRange(range.first, range.last, size) + "\r\n\r\n");
+            add_file(range.first, range.last - range.first + 1);
+        }
+        add_data("\r\n--" + boundary + "--\r\n");
+    }
+    else
+    {
+        resp->setStateCode(StateCode::k200Ok);
+        if(asset_cache && plain_get && size <= asset_cache->maxAssetBytes())
+        {
+            HttpAssetCache::AssetPtr asset = asset_cache->put(target_path, *entry, mime,
+                                                              vary_encoding ? "Vary: Accept-Encoding\r\n" : "");
+            if(asset)
+            {
+                SendAsset(*resp, *asset);
+                return;
+            }
+        }
+        resp->addHeader("Content-Type", mime);
+        add_file(0, size);
+    }
 
-    /// TODO: 可使用sendfile优化 减少拷贝
-    std::fstream tmp_f(target_path, std::ios::in | std::ios::binary);
-    if(!tmp_f.is_open())
+    if(head_only || 0 == body_bytes)
     {
-        HTTP_F_ERROR("file %s open error! %d:%s \n", target_path.c_str(), errno, strerror(errno));
-        resp->setStateCode(StateCode::k500InternalServerError);
+        resp->addHeader("Content-Length", std::to_string(body_bytes));
         return;
     }
-    std::string data;
-    uint64_t file_size = 0;
-    tmp_f.seekg(0, std::ios::end);
-    file_size = tmp_f.tellg();
-    tmp_f.seekg(0, std::ios::beg);
-    data.resize(file_size);
 
-    tmp_f.read((char*)data.data(), file_size);
-    resp->body().appendData(data);
+    for(auto &seg : segments)
+    {
+        if(seg.file)
+        {
+            resp->addFileSegment(seg.file, seg.offset, seg.length);
+        }
+        else
+        {
+            resp->addDataSegment(std::move(seg.data));
+        }
+    }
+}
+
+bool StaticFileServlet::handleCompressed(const HttpContextPtr &ctx, HttpCompressor &compressor, HttpEncoding encoding,
+                                         const std::string &targetPath, const HttpFileCache::Entry &entry, const std::string &mime)
+{
+    auto resp = ctx->response();
+    auto req = ctx->request();
+    const uint64_t size = entry.file->size();
+
+    // 预压缩文件: 比原文旧的 .gz 视为过期
+    HttpFileCache::EntryPtr gz;
+    if(HttpEncoding::kGzip == encoding && compressor.config().precompressed)
+    {
+        gz = _cache->get(targetPath + ".gz");
+        if(gz && gz->mtime < entry.mtime)
+        {
+            gz.reset();
+        }
+    }
+
+    std::string etag;
+    SharedBuffer compressed;
+    if(gz)
+    {
+        etag = gz->etag;
+    }
+    else
+    {
+        // 现场压缩需要整块读入，过大的文件仍走 sendfile 原文
+        if(size < compressor.config().minBytes || size > compressor.config().maxCacheEntryBytes)
+        {
+            return false;
+        }
+
+        const std::string key = CompressCacheKey(*req, entry.etag);
+        compressed = compressor.lookup(key, encoding);
+        if(!compressed)
+        {
+            std::string raw(size, '\0');
+            size_t done = 0;
+            while(done < raw.size())
+            {
+                ssize_t n = ::pread(entry.file->fd(), &raw[done], raw.size() - done, static_cast<off_t>(done));
+                if(n <= 0)
+                {
+                    HTTP_F_WARN("compress read %s failed, %zu/%zu\n", targetPath.c_str(), done, raw.size());
+                    return false;
+                }
+                done += static_cast<size_t>(n);
+            }
+            compressed = compressor.store(key, encoding, raw.data(), raw.size());
+            if(!compressed)
+            {
+                return false;
+            }
+        }
+        compressor.record(size, compressed->size());
+        if(compressed->size() >= size)
+        {
+            return false;
+        }
+        etag = VariantETag(entry.etag, encoding);
+    }
+
+    resp->addHeader("ETag", etag);
+    resp->addHeader("Last-Modified", entry.last_modified);
+    resp->addHeader("Vary", "Accept-Encoding");
+    if(NotModified(req->getHeader("If-None-Match"), req->getHeader("If-Modified-Since"), etag, entry.mtime))
+    {
+        resp->setStateCode(StateCode::k304NotModified);
+        return true;
+    }
+
+    resp->setStateCode(StateCode::k200Ok);
+    resp->addHeader("Content-Type", mime);
+    resp->addHeader("Content-Encoding", std::string(HttpEncodingName(encoding)));
+
+    const uint64_t body_bytes = gz ? gz->file->size() : compressed->size();
+    if(HttpRequest::Method::kHead == req->method()())
+    {
+        resp->addHeader("Content-Length", std::to_string(body_bytes));
+        return true;
+    }
+    if(gz)
+    {
+        resp->addFileSegment(gz->file, 0, body_bytes);
+        return true;
+    }
 
+    // 压缩结果由缓存共享，头部与之拼成一次 writev
+    resp->addHeader("Content-Length", std::to_string(body_bytes));
+    resp->setSerialized({std::make_shared<const std::string>(resp->headerString()), std::move(compressed)});
+    return true;
 }
 
 /***********ServletDispatch************ */
 
+namespace {
+
+/**
+ * @brief 进程内读线程序号分配器，序号即各 dispatch 实例中的槽位下标
+ * @note 业务线程池(CACHE_MOD)会不断创建、回收线程，序号在线程退出时归还复用，
+ *       否则累计起满槽位数的线程后所有分发都会退回加锁的 shared_ptr 路径
+ */
+class ReaderIndexPool
+{
+public:
+    static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+    explicit ReaderIndexPool(size_t capacity)
+    {
+        // 小序号先分配
+        for(size_t i = capacity; i > 0; --i)
+        {
+            _free.push_back(i - 1);
+        }
+        _available.store(capacity, std::memory_order_relaxed);
+    }
+
+    size_t acquire()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(_free.empty())
+        {
+            return kNone;
+        }
+        const size_t index = _free.back();
+        _free.pop_back();
+        _available.store(_free.size(), std::memory_order_relaxed);
+        return index;
+    }
+
+    void release(size_t index)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _free.push_back(index);
+        _available.store(_free.size(), std::memory_order_relaxed);
+    }
+
+    bool available() const { return _available.load(std::memory_order_relaxed) > 0; }
+
+private:
+    std::mutex _mutex;
+    std::vector<size_t> _free;
+    std::atomic<size_t> _available{0};
+};
+
+ReaderIndexPool& ReaderIndices(size_t capacity)
+{
+    // 不析构: 其它线程的 thread_local 可能在静态对象析构之后才归还序号
+    static ReaderIndexPool *s_pool = new ReaderIndexPool(capacity);
+    return *s_pool;
+}
+
+/// @brief 线程首次分发时领取序号，线程退出时归还；分发都在作用域内结束，归还时各实例中的槽位已清空
+struct ThreadReaderIndex
+{
+    size_t index{ReaderIndexPool::kNone};
+    ReaderIndexPool *pool{nullptr};
+
+    ~ThreadReaderIndex()
+    {
+        if(pool && ReaderIndexPool::kNone != index)
+        {
+            pool->release(index);
+        }
+    }
+};
+thread_local ThreadReaderIndex t_readerIndex;
+
+/// @brief 本线程的读者序号，序号用尽时返回 kNone，有线程归还后再领取
+size_t ReaderIndex(size_t capacity)
+{
+    if(ReaderIndexPool::kNone == t_readerIndex.index)
+    {
+        ReaderIndexPool &pool = ReaderIndices(capacity);
+        if(pool.available())
+        {
+            t_readerIndex.pool = &pool;
+            t_readerIndex.index = pool.acquire();
+        }
+    }
+    return t_readerIndex.index;
+}
+
+RouteInfo ToRouteInfo(uint64_t id, RouteKind kind, const std::string &pattern, MethodMask methods)
+{
+    RouteInfo info;
+    info.id = id;
+    info.kind = kind;
+    info.pattern = pattern;
+    info.methods = methods;
+    info.methods_str = BuildAllowHeader(methods);
+    return info;
+}
+
+}
+
 HttpServletDispatch::HttpServletDispatch()
     :_defaultSvl(std::make_shared<NotFound404Servlet>())
+    ,_readers(new ReaderSlot[kReaderSlots])
+{
+    WriteLock lock(*this);
+    publish(std::make_shared<RouteTable>());
+}
+
+HttpServletDispatch::SnapshotGuard::SnapshotGuard(HttpServletDispatch &dispatch)
+    :_dispatch(dispatch)
 {
+    const size_t index = ReaderIndex(kReaderSlots);
+    ReaderSlot *slot = index < kReaderSlots ? &dispatch._readers[index] : nullptr;
+    if(slot && nullptr == slot->hazard.load(std::memory_order_relaxed))
+    {
+        // 先登记再确认仍是当前快照: 写侧在替换之后才扫描槽位，确认通过即不会被回收
+        const RouteTable *table = dispatch._current.load(std::memory_order_seq_cst);
+        while(true)
+        {
+            slot->hazard.store(table, std::memory_order_seq_cst);
+            const RouteTable *current = dispatch._current.load(std::memory_order_seq_cst);
+            if(current == table)
+            {
+                break;
+            }
+            table = current;
+        }
+        _slot = slot;
+        _table = table;
+        return;
+    }
 
+    dispatch._snapshotFallbacks.fetch_add(1, std::memory_order_relaxed);
+    _hold = std::atomic_load(&dispatch._table);
+    _table = _hold.get();
+}
+
+HttpServletDispatch::SnapshotGuard::~SnapshotGuard()
+{
+    if(!_slot)
+    {
+        return;
+    }
+    _slot->hazard.store(nullptr, std::memory_order_seq_cst);
+    // 写侧回收时本线程仍在使用旧快照，由最后离开的读者补做回收
+    if(_dispatch._hasRetired.load(std::memory_order_seq_cst))
+    {
+        _dispatch.tryReclaim();
+    }
+}
+
+HttpServletDispatch::WriteLock::WriteLock(HttpServletDispatch &dispatch)
+    :_dispatch(dispatch)
+    ,_lock(dispatch.route_mtx_)
+{
+}
+
+HttpServletDispatch::WriteLock::~WriteLock()
+{
+    _lock.unlock();
+    _dispatch.drainReclaim();
+}
+
+std::shared_ptr<HttpServletDispatch::RouteTable> HttpServletDispatch::cloneTable() const
+{
+    RouteTablePtr cur = std::atomic_load(&_table);
+    return cur ? std::make_shared<RouteTable>(*cur) : std::make_shared<RouteTable>();
+}
+
+void HttpServletDispatch::compileChains(RouteTable &table)
+{
+    auto compile = [&table](const std::string *pattern, MiddlewareChain *chain) {
+        chain->clear();
+        for(const auto &entry : table.middlewares)
+        {
+            if(entry.route_prefix.empty()
+                || (pattern && 0 == pattern->compare(0, entry.route_prefix.size(), entry.route_prefix)))
+            {
+                chain->push_back(entry.middleware.get());
+            }
+        }
+        chain->shrink_to_fit();
+    };
+
+    compile(nullptr, &table.default_chain);
+    for(auto &it : table.exact_routes)
+    {
+        for(auto &route : it.second)
+        {
+            compile(&route.pattern, &route.chain);
+        }
+    }
+    for(auto &route : table.dynamic_routes)
+    {
+        compile(&route.pattern, &route.chain);
+    }
+}
+
+void HttpServletDispatch::publish(std::shared_ptr<RouteTable> table)
+{
+    // 路由或中间件变化时整表重新编译，分发时只按下标遍历
+    compileChains(*table);
+    table->has_prepare = false;
+    for(const auto &it : table->exact_routes)
+    {
+        for(const auto &route : it.second)
+        {
+            table->has_prepare = table->has_prepare || (route.servlet && route.servlet->needsPrepare());
+        }
+    }
+    for(const auto &route : table->dynamic_routes)
+    {
+        table->has_prepare = table->has_prepare || (route.servlet && route.servlet->needsPrepare());
+    }
+    RouteTablePtr old = std::atomic_load(&_table);
+    const RouteTable *current = table.get();
+    std::atomic_store(&_table, RouteTablePtr(std::move(table)));
+    _current.store(current, std::memory_order_seq_cst);
+    if(old)
+    {
+        _retired.push_back(std::move(old));
+        _hasRetired.store(true, std::memory_order_seq_cst);
+        reclaim();
+    }
+}
+
+void HttpServletDispatch::reclaim()
+{
+    auto in_use = [this](const RouteTable *table) {
+        for(size_t i = 0; i < kReaderSlots; ++i)
+        {
+            if(_readers[i].hazard.load(std::memory_order_seq_cst) == table)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // 槽位用尽的线程持有 shared_ptr，移出列表不影响它们
+    _retired.erase(std::remove_if(_retired.begin(), _retired.end(),
+                                  [&](const RouteTablePtr &table) { return !in_use(table.get()); }),
+                   _retired.end());
+    _hasRetired.store(!_retired.empty(), std::memory_order_seq_cst);
+}
+
+void HttpServletDispatch::tryReclaim()
+{
+    _reclaimPending.store(true, std::memory_order_seq_cst);
+    drainReclaim();
+}
+
+void HttpServletDispatch::drainReclaim()
+{
+    // 先置标记再试锁: 试锁失败说明持锁者尚未解锁，它解锁后调用这里时一定能看到标记
+    while(_reclaimPending.load(std::memory_order_seq_cst))
+    {
+        std::unique_lock<std::mutex> lock(route_mtx_, std::try_to_lock);
+        if(!lock.owns_lock())
+        {
+            return;
+        }
+        _reclaimPending.store(false, std::memory_order_seq_cst);
+        reclaim();
+    }
 }
 
 
 void HttpServletDispatch::handle(TcpConnectionPtr conn, HttpContextPtr ctx)
 {
-    auto req = ctx->request();
-    MatchResult result = match(ctx);
+    SnapshotGuard guard(*this);
+    MatchResult result = match(guard.table(), ctx);
+    const MiddlewareChain &chain = result.chain ? *result.chain : guard.table().default_chain;
+
+    // 记录已执行 before 的中间件个数，短路时只对它们逆序调用 after
+    size_t entered = 0;
+    bool responded = false;
+    while(entered < chain.size())
+    {
+        HttpMiddleware *middleware = chain[entered++];
+        if(HttpMiddleware::Action::kRespond == middleware->before(conn, ctx))
+        {
+            HTTP_F_DEBUG("conn[%s], path[%s] short-circuited by middleware[%s]\n",
+                         conn->name().c_str(), ctx->request()->path().c_str(), middleware->name().c_str());
+            responded = true;
+            break;
+        }
+    }
+
+    if(!responded)
+    {
+        try
+        {
+            dispatch(conn, ctx, result);
+        }
+        catch(...)
+        {
+            // servlet 抛出异常时响应按 500 处理，已执行 before 的中间件照常收到 after 再继续上抛
+            ctx->response()->setStateCode(StateCode::k500InternalServerError);
+            while(entered > 0)
+            {
+                chain[--entered]->after(conn, ctx);
+            }
+            throw;
+        }
+    }
 
+    while(entered > 0)
+    {
+        chain[--entered]->after(conn, ctx);
+    }
+}
+
+void HttpServletDispatch::dispatch(const TcpConnectionPtr &conn, const HttpContextPtr &ctx, const MatchResult &result)
+{
+    auto req = ctx->request();
     if(result.status == MatchStatus::Found && result.servlet)
     {
         HTTP_F_DEBUG("conn[%s], path[%s] HttpServlet[%s] handling...... \n", conn->name().c_str(), req->path().c_str(), result.servlet->name().c_str());
@@ -418,6 +1245,31 @@ void HttpServletDispatch::handle(TcpConnectionPtr conn, HttpContextPtr ctx)
     _defaultSvl->handle(conn, ctx);
 }
 
+HttpBodySink::Ptr HttpServletDispatch::createBodySink(TcpConnectionPtr conn, HttpContextPtr ctx)
+{
+    SnapshotGuard guard(*this);
+    MatchResult result = match(guard.table(), ctx);
+    if(result.status != MatchStatus::Found || !result.servlet)
+    {
+        return nullptr;
+    }
+    return result.servlet->createBodySink(conn, ctx);
+}
+
+void HttpServletDispatch::prepare(TcpConnectionPtr conn, HttpContextPtr ctx)
+{
+    SnapshotGuard guard(*this);
+    if(!guard.table().has_prepare)
+    {
+        return;
+    }
+    MatchResult result = match(guard.table(), ctx);
+    if(result.status == MatchStatus::Found && result.servlet && result.servlet->needsPrepare())
+    {
+        result.servlet->prepare(conn, ctx);
+    }
+}
+
 RouteResult HttpServletDispatch::addRoute(MethodMask methods, const std::string &pattern, HttpServlet::Ptr servlet)
 {
     RouteResult result;
@@ -453,12 +1305,13 @@ RouteResult HttpServletDispatch::addRoute(MethodMask methods, const std::string
         return result;
     }
 
-    std::unique_lock<std::mutex> lock(route_mtx_);
+    WriteLock lock(*this);
     MethodMask conflict_methods = ExpectHttpMethods::None;
+    auto table = cloneTable();
 
     if(kind == RouteKind::Exact)
     {
-        auto &routes = exact_routes_[pattern];
+        auto &routes = table->exact_routes[pattern];
         if(hasMethodConflict(routes, methods, &conflict_methods))
         {
             result.status = RouteStatus::Conflict;
@@ -481,7 +1334,7 @@ RouteResult HttpServletDispatch::addRoute(MethodMask methods, const std::string
     else
     {
         std::vector<RouteEntry> same_pattern_routes;
-        for(const auto &route : dynamic_routes_)
+        for(const auto &route : table->dynamic_routes)
         {
             if(route.pattern == pattern)
             {
@@ -505,10 +1358,12 @@ RouteResult HttpServletDispatch::addRoute(MethodMask methods, const std::string
         entry.matcher = std::move(matcher);
         entry.servlet = std::move(servlet);
         entry.priority = next_priority_++;
-        dynamic_routes_.emplace_back(std::move(entry));
-        result.route_id = dynamic_routes_.back().id;
+        table->dynamic_routes.emplace_back(std::move(entry));
+        result.route_id = table->dynamic_routes.back().id;
     }
 
+    publish(std::move(table));
+
     HTTP_F_INFO("addRoute success: id[%llu], kind[%s], pattern[%s], methods[%s]\n",
                 static_cast<unsigned long long>(result.route_id),
                 RouteKindName(kind).c_str(),
@@ -558,16 +1413,14 @@ RouterMatcher::Ptr HttpServletDispatch::createMatcher(RouteKind kind, const std:
     }
 }
 
-HttpServletDispatch::MatchResult HttpServletDispatch::match(HttpContextPtr ctx)
+HttpServletDispatch::MatchResult HttpServletDispatch::match(const RouteTable &table, HttpContextPtr ctx)
 {
     MatchResult result;
     auto req = ctx->request();
     const std::string url = req->path();
 
-    std::unique_lock<std::mutex> lock(route_mtx_);
-
-    auto exact_it = exact_routes_.find(url);
-    if(exact_it != exact_routes_.end())
+    auto exact_it = table.exact_routes.find(url);
+    if(exact_it != table.exact_routes.end())
     {
         for(const auto &route : exact_it->second)
         {
@@ -575,7 +1428,8 @@ HttpServletDispatch::MatchResult HttpServletDispatch::match(HttpContextPtr ctx)
             if(MethodAllowed(route.methods, req->method()))
             {
                 result.status = MatchStatus::Found;
-                result.servlet = route.servlet;
+                result.servlet = route.servlet.get();
+                result.chain = &route.chain;
                 result.allowed_methods = route.methods;
                 return result;
             }
@@ -585,7 +1439,7 @@ HttpServletDispatch::MatchResult HttpServletDispatch::match(HttpContextPtr ctx)
         return result;
     }
 
-    for(auto &route : dynamic_routes_)
+    for(const auto &route : table.dynamic_routes)
     {
         if(!route.matcher || !route.servlet)
         {
@@ -602,7 +1456,8 @@ HttpServletDispatch::MatchResult HttpServletDispatch::match(HttpContextPtr ctx)
         {
             route.matcher->Match(ctx);
             result.status = MatchStatus::Found;
-            result.servlet = route.servlet;
+            result.servlet = route.servlet.get();
+            result.chain = &route.chain;
             result.allowed_methods = route.methods;
             return result;
         }
@@ -634,10 +1489,11 @@ bool HttpServletDispatch::hasMethodConflict(const std::vector<RouteEntry> &route
 
 bool HttpServletDispatch::removeRoute(uint64_t route_id)
 {
-    std::unique_lock<std::mutex> lock(route_mtx_);
+    WriteLock lock(*this);
+    auto table = cloneTable();
 
-    // exact_routes_
-    for (auto it = exact_routes_.begin(); it != exact_routes_.end(); )
+    // exact_routes
+    for (auto it = table->exact_routes.begin(); it != table->exact_routes.end(); ++it)
     {
         auto &vec = it->second;
         for (auto vit = vec.begin(); vit != vec.end(); ++vit)
@@ -647,24 +1503,21 @@ bool HttpServletDispatch::removeRoute(uint64_t route_id)
                 vec.erase(vit);
                 if (vec.empty())
                 {
-                    it = exact_routes_.erase(it);
-                }
-                else
-                {
-                    ++it;
+                    table->exact_routes.erase(it);
                 }
+                publish(std::move(table));
                 return true;
             }
         }
-        ++it;
     }
 
-    // dynamic_routes_
-    for (auto it = dynamic_routes_.begin(); it != dynamic_routes_.end(); ++it)
+    // dynamic_routes
+    for (auto it = table->dynamic_routes.begin(); it != table->dynamic_routes.end(); ++it)
     {
         if (it->id == route_id)
         {
-            dynamic_routes_.erase(it);
+            table->dynamic_routes.erase(it);
+            publish(std::move(table));
             return true;
         }
     }
@@ -674,12 +1527,13 @@ bool HttpServletDispatch::removeRoute(uint64_t route_id)
 
 size_t HttpServletDispatch::removeRoute(const std::string &pattern, MethodMask methods)
 {
-    std::unique_lock<std::mutex> lock(route_mtx_);
+    WriteLock lock(*this);
+    auto table = cloneTable();
     size_t removed = 0;
 
-    // exact_routes_
-    auto exact_it = exact_routes_.find(pattern);
-    if (exact_it != exact_routes_.end())
+    // exact_routes
+    auto exact_it = table->exact_routes.find(pattern);
+    if (exact_it != table->exact_routes.end())
     {
         auto &vec = exact_it->second;
         for (auto vit = vec.begin(); vit != vec.end(); )
@@ -696,16 +1550,16 @@ size_t HttpServletDispatch::removeRoute(const std::string &pattern, MethodMask m
         }
         if (vec.empty())
         {
-            exact_routes_.erase(exact_it);
+            table->exact_routes.erase(exact_it);
         }
     }
 
-    // dynamic_routes_
-    for (auto it = dynamic_routes_.begin(); it != dynamic_routes_.end(); )
+    // dynamic_routes
+    for (auto it = table->dynamic_routes.begin(); it != table->dynamic_routes.end(); )
     {
         if (it->pattern == pattern && it->methods == methods)
         {
-            it = dynamic_routes_.erase(it);
+            it = table->dynamic_routes.erase(it);
             ++removed;
         }
         else
@@ -714,28 +1568,33 @@ size_t HttpServletDispatch::removeRoute(const std::string &pattern, MethodMask m
         }
     }
 
+    if (removed > 0)
+    {
+        publish(std::move(table));
+    }
     return removed;
 }
 
 size_t HttpServletDispatch::removeRoute(const std::string &pattern)
 {
-    std::unique_lock<std::mutex> lock(route_mtx_);
+    WriteLock lock(*this);
+    auto table = cloneTable();
     size_t removed = 0;
 
-    // exact_routes_
-    auto exact_it = exact_routes_.find(pattern);
-    if (exact_it != exact_routes_.end())
+    // exact_routes
+    auto exact_it = table->exact_routes.find(pattern);
+    if (exact_it != table->exact_routes.end())
     {
         removed += exact_it->second.size();
-        exact_routes_.erase(exact_it);
+        table->exact_routes.erase(exact_it);
     }
 
-    // dynamic_routes_
-    for (auto it = dynamic_routes_.begin(); it != dynamic_routes_.end(); )
+    // dynamic_routes
+    for (auto it = table->dynamic_routes.begin(); it != table->dynamic_routes.end(); )
     {
         if (it->pattern == pattern)
         {
-            it = dynamic_routes_.erase(it);
+            it = table->dynamic_routes.erase(it);
             ++removed;
         }
         else
@@ -744,41 +1603,71 @@ size_t HttpServletDispatch::removeRoute(const std::string &pattern)
         }
     }
 
+    if (removed > 0)
+    {
+        publish(std::move(table));
+    }
+    return removed;
+}
+
+void HttpServletDispatch::use(HttpMiddleware::Ptr middleware)
+{
+    use("", std::move(middleware));
+}
+
+void HttpServletDispatch::use(const std::string &routePrefix, HttpMiddleware::Ptr middleware)
+{
+    if(!middleware)
+    {
+        HTTP_F_ERROR("use middleware failed: middleware is null, prefix[%s]\n", routePrefix.c_str());
+        return;
+    }
+
+    WriteLock lock(*this);
+    auto table = cloneTable();
+    HTTP_F_INFO("use middleware[%s], prefix[%s]\n", middleware->name().c_str(), routePrefix.c_str());
+    table->middlewares.push_back(MiddlewareEntry{routePrefix, std::move(middleware)});
+    publish(std::move(table));
+}
+
+size_t HttpServletDispatch::removeMiddleware(const std::string &name)
+{
+    WriteLock lock(*this);
+    auto table = cloneTable();
+    auto &middlewares = table->middlewares;
+    const size_t before = middlewares.size();
+    middlewares.erase(std::remove_if(middlewares.begin(), middlewares.end(), [&name](const MiddlewareEntry &entry) {
+        return entry.middleware->name() == name;
+    }), middlewares.end());
+
+    const size_t removed = before - middlewares.size();
+    if(removed > 0)
+    {
+        publish(std::move(table));
+    }
     return removed;
 }
 
 RouteInfo HttpServletDispatch::getRoute(uint64_t route_id) const
 {
-    std::unique_lock<std::mutex> lock(route_mtx_);
+    RouteTablePtr table = std::atomic_load(&_table);
 
-    for (const auto &pair : exact_routes_)
+    for (const auto &pair : table->exact_routes)
     {
         for (const auto &route : pair.second)
         {
             if (route.id == route_id)
             {
-                RouteInfo info;
-                info.id = route.id;
-                info.kind = route.kind;
-                info.pattern = route.pattern;
-                info.methods = route.methods;
-                info.methods_str = BuildAllowHeader(route.methods);
-                return info;
+                return ToRouteInfo(route.id, route.kind, route.pattern, route.methods);
             }
         }
     }
 
-    for (const auto &route : dynamic_routes_)
+    for (const auto &route : table->dynamic_routes)
     {
         if (route.id == route_id)
         {
-            RouteInfo info;
-            info.id = route.id;
-            info.kind = route.kind;
-            info.pattern = route.pattern;
-            info.methods = route.methods;
-            info.methods_str = BuildAllowHeader(route.methods);
-            return info;
+            return ToRouteInfo(route.id, route.kind, route.pattern, route.methods);
         }
     }
 
@@ -787,32 +1676,20 @@ RouteInfo HttpServletDispatch::getRoute(uint64_t route_id) const
 
 std::vector<RouteInfo> HttpServletDispatch::listRoutes() const
 {
-    std::unique_lock<std::mutex> lock(route_mtx_);
+    RouteTablePtr table = std::atomic_load(&_table);
     std::vector<RouteInfo> result;
 
-    for (const auto &pair : exact_routes_)
+    for (const auto &pair : table->exact_routes)
     {
         for (const auto &route : pair.second)
         {
-            RouteInfo info;
-            info.id = route.id;
-            info.kind = route.kind;
-            info.pattern = route.pattern;
-            info.methods = route.methods;
-            info.methods_str = BuildAllowHeader(route.methods);
-            result.push_back(std::move(info));
+            result.push_back(ToRouteInfo(route.id, route.kind, route.pattern, route.methods));
         }
     }
 
-    for (const auto &route : dynamic_routes_)
+    for (const auto &route : table->dynamic_routes)
     {
-        RouteInfo info;
-        info.id = route.id;
-        info.kind = route.kind;
-        info.pattern = route.pattern;
-        info.methods = route.methods;
-        info.methods_str = BuildAllowHeader(route.methods);
-        result.push_back(std::move(info));
+        result.push_back(ToRouteInfo(route.id, route.kind, route.pattern, route.methods));
     }
 
     return result;
@@ -820,35 +1697,23 @@ std::vector<RouteInfo> HttpServletDispatch::listRoutes() const
 
 std::vector<RouteInfo> HttpServletDispatch::listRoutes(const std::string &pattern) const
 {
-    std::unique_lock<std::mutex> lock(route_mtx_);
+    RouteTablePtr table = std::atomic_load(&_table);
     std::vector<RouteInfo> result;
 
-    auto exact_it = exact_routes_.find(pattern);
-    if (exact_it != exact_routes_.end())
+    auto exact_it = table->exact_routes.find(pattern);
+    if (exact_it != table->exact_routes.end())
     {
         for (const auto &route : exact_it->second)
         {
-            RouteInfo info;
-            info.id = route.id;
-            info.kind = route.kind;
-            info.pattern = route.pattern;
-            info.methods = route.methods;
-            info.methods_str = BuildAllowHeader(route.methods);
-            result.push_back(std::move(info));
+            result.push_back(ToRouteInfo(route.id, route.kind, route.pattern, route.methods));
         }
     }
 
-    for (const auto &route : dynamic_routes_)
+    for (const auto &route : table->dynamic_routes)
     {
         if (route.pattern == pattern)
         {
-            RouteInfo info;
-            info.id = route.id;
-            info.kind = route.kind;
-            info.pattern = route.pattern;
-            info.methods = route.methods;
-            info.methods_str = BuildAllowHeader(route.methods);
-            result.push_back(std::move(info));
+            result.push_back(ToRouteInfo(route.id, route.kind, route.pattern, route.methods));
         }
     }
 
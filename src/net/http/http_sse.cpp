@@ -0,0 +1,407 @@
+/**
+ * @file http_sse.cpp
+ * @brief Server-Sent Events: 事件编码与按主题共享缓冲的扇出
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 00:12:44
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_sse.h"
+#include "net/http/http_context.h"
+#include "net/http/http_headers.h"
+#include "net/http/http_request.h"
+#include "net/http/http_response.h"
+#include "net/http/http_servlet.h"
+#include "net/http/http_util.h"
+#include "net/event_loop.h"
+#include "net/net_log.h"
+#include "net/tcp_connection.h"
+#include "base/metrics.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace kit_muduo::http {
+
+namespace {
+
+struct SseMetrics
+{
+    metrics::Gauge &subscribers;
+    metrics::Counter &dropped;
+    metrics::Counter &evicted;
+};
+
+SseMetrics& Metrics()
+{
+    static SseMetrics s_metrics{
+        metrics::MetricsRegistry::Instance().gauge("kit_sse_subscribers", "Open SSE subscriptions"),
+        metrics::MetricsRegistry::Instance().counter("kit_sse_dropped_events_total", "SSE events skipped for slow subscribers"),
+        metrics::MetricsRegistry::Instance().counter("kit_sse_evicted_total", "SSE subscribers disconnected for backpressure"),
+    };
+    return s_metrics;
+}
+
+const SharedBuffer& ChunkTail()
+{
+    static const SharedBuffer s_tail = std::make_shared<const std::string>("\r\n");
+    return s_tail;
+}
+
+const SharedBuffer& ChunkEnd()
+{
+    static const SharedBuffer s_end = std::make_shared<const std::string>("0\r\n\r\n");
+    return s_end;
+}
+
+/// @brief 追加 "name: value\n"，value 中的换行被去掉
+void AppendField(std::string &out, std::string_view name, std::string_view value)
+{
+    out.append(name).append(": ");
+    for(char c : value)
+    {
+        if('\r' != c && '\n' != c)
+        {
+            out.push_back(c);
+        }
+    }
+    out.push_back('\n');
+}
+
+}
+
+std::string EncodeSseEvent(const SseEvent &event)
+{
+    std::string out;
+    out.reserve(event.data.size() + event.id.size() + event.event.size() + 32);
+    if(!event.id.empty())
+    {
+        AppendField(out, "id", event.id);
+    }
+    if(!event.event.empty())
+    {
+        AppendField(out, "event", event.event);
+    }
+    if(event.retryMs >= 0)
+    {
+        out.append("retry: ").append(std::to_string(event.retryMs)).push_back('\n');
+    }
+
+    // 每行一个 data 字段，CRLF/CR/LF 都是行结束
+    std::string_view data = event.data;
+    while(true)
+    {
+        const size_t eol = data.find_first_of("\r\n");
+        out.append("data: ").append(data.substr(0, eol)).push_back('\n');
+        if(std::string_view::npos == eol)
+        {
+            break;
+        }
+        const size_t skip = ('\r' == data[eol] && eol + 1 < data.size() && '\n' == data[eol + 1]) ? 2 : 1;
+        data.remove_prefix(eol + skip);
+    }
+    out.push_back('\n');
+    return out;
+}
+
+SseTopic::SseTopic(EventLoop *loop, const std::string &name, Config config)
+    :_loop(loop)
+    ,_name(name)
+    ,_config(std::move(config))
+{
+}
+
+SseTopic::~SseTopic()
+{
+    if(_heartbeatTimer)
+    {
+        _loop->cancel(_heartbeatTimer);
+    }
+    Metrics().subscribers.dec(static_cast<int64_t>(_subscribers.size()));
+}
+
+SseTopic::Frame SseTopic::MakeFrame(std::string body)
+{
+    char head[24];
+    const int n = std::snprintf(head, sizeof(head), "%zx\r\n", body.size());
+    Frame frame;
+    frame.chunkHead = std::make_shared<const std::string>(head, static_cast<size_t>(n));
+    frame.body = std::make_shared<const std::string>(std::move(body));
+    return frame;
+}
+
+void SseTopic::SendFrame(const TcpConnectionPtr &conn, const Subscriber &sub, const Frame &frame)
+{
+    if(sub.chunked)
+    {
+        conn->send(std::vector<SharedBuffer>{frame.chunkHead, frame.body, ChunkTail()});
+    }
+    else
+    {
+        conn->send(std::vector<SharedBuffer>{frame.body});
+    }
+}
+
+bool SseTopic::subscribe(const TcpConnectionPtr &conn, const HttpContextPtr &ctx)
+{
+    auto req = ctx->request();
+    auto resp = ctx->response();
+    const bool chunked = Version::kHttp10 != req->version()();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    // HTTP/2 流不支持长连接推送
+    if(_closed || !conn->connected() || ctx->isHttp2())
+    {
+        ServiceUnavailable503Servlet::Handle(conn, ctx);
+        return false;
+    }
+
+    resp->setVersion(chunked ? Version::kHttp11 : Version::kHttp10);
+    resp->setStateCode(StateCode::k200Ok);
+    resp->body().reset();
+    resp->body().setContentType(ContentType::kUnknowType);
+    resp->headers().set(HttpHeaderId::kContentType, "text/event-stream; charset=utf-8");
+    resp->headers().set(HttpHeaderId::kCacheControl, "no-cache");
+    // 关闭反向代理(nginx)的响应缓冲
+    resp->headers().set("X-Accel-Buffering", "no");
+    if(chunked)
+    {
+        resp->headers().set(HttpHeaderId::kTransferEncoding, "chunked");
+    }
+    else
+    {
+        resp->setConnectionClosed(true);
+    }
+    resp->setStreaming(true);
+
+    Subscriber sub;
+    sub.conn = conn;
+    sub.chunked = chunked;
+
+    // 头部、retry 与补发的事件合并为一次发送
+    std::vector<SharedBuffer> bufs{std::make_shared<const std::string>(resp->headerString())};
+    auto append_frame = [&bufs, chunked](const Frame &frame) {
+        if(chunked)
+        {
+            bufs.push_back(frame.chunkHead);
+            bufs.push_back(frame.body);
+            bufs.push_back(ChunkTail());
+        }
+        else
+        {
+            bufs.push_back(frame.body);
+        }
+    };
+    if(_config.retryMs >= 0)
+    {
+        append_frame(MakeFrame("retry: " + std::to_string(_config.retryMs) + "\n\n"));
+    }
+    const std::string_view last_id = TrimHttpSpace(req->header("Last-Event-ID"));
+    if(!last_id.empty())
+    {
+        auto it = _replay.begin();
+        while(it != _replay.end() && it->id != last_id)
+        {
+            ++it;
+        }
+        // 不在窗口内时无法判断丢了哪些，不补发
+        if(it != _replay.end())
+        {
+            for(++it; it != _replay.end(); ++it)
+            {
+                append_frame(it->frame);
+                _replayed.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    conn->send(bufs);
+
+    // 地址可能被已断开但尚未清理的旧连接占用，直接覆盖
+    if(_subscribers.insert_or_assign(conn.get(), sub).second)
+    {
+        Metrics().subscribers.inc();
+    }
+    std::weak_ptr<SseTopic> weak_topic = shared_from_this();
+    if(_config.heartbeatMs > 0 && !_heartbeatTimer)
+    {
+        _heartbeatTimer = _loop->runEvery(_config.heartbeatMs, [weak_topic]() {
+            if(auto topic = weak_topic.lock())
+            {
+                topic->onHeartbeat();
+            }
+        });
+    }
+    HTTP_F_DEBUG("sse topic[%s] subscribe conn[%s], subscribers[%lu]\n", _name.c_str(), conn->name().c_str(), _subscribers.size());
+    lock.unlock();
+
+    // 连接断开时立即退订，不必等下一次发布或心跳才发现；已断开时在这里同步执行，故需先解锁
+    conn->addCloseHook([weak_topic](const TcpConnectionPtr &closed) {
+        if(auto topic = weak_topic.lock())
+        {
+            topic->unsubscribe(closed);
+        }
+    });
+    return true;
+}
+
+void SseTopic::unsubscribe(const TcpConnectionPtr &conn)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _subscribers.find(conn.get());
+    if(it != _subscribers.end() && it->second.conn.lock() == conn)
+    {
+        removeUnLocked(it);
+        HTTP_F_DEBUG("sse topic[%s] unsubscribe conn[%s], subscribers[%lu]\n", _name.c_str(), conn->name().c_str(), _subscribers.size());
+    }
+}
+
+void SseTopic::removeUnLocked(std::unordered_map<const TcpConnection*, Subscriber>::iterator it)
+{
+    _subscribers.erase(it);
+    Metrics().subscribers.dec();
+}
+
+size_t SseTopic::fanOutUnLocked(const Frame &frame, bool droppable)
+{
+    // chunk 头与结尾 CRLF 只有 chunked 订阅者才发送
+    const size_t chunked_bytes = frame.chunkHead->size() + frame.body->size() + ChunkTail()->size();
+    const int64_t now = metrics::NowNs();
+    const int64_t stall_ns = _config.stallTimeoutMs * 1000000;
+    size_t sent = 0;
+    for(auto it = _subscribers.begin(); it != _subscribers.end(); )
+    {
+        TcpConnectionPtr conn = it->second.conn.lock();
+        if(!conn || !conn->connected())
+        {
+            auto dead = it++;
+            removeUnLocked(dead);
+            continue;
+        }
+
+        Subscriber &sub = it->second;
+        const size_t frame_bytes = sub.chunked ? chunked_bytes : frame.body->size();
+        if(conn->pendingBytes() + frame_bytes <= _config.maxPendingBytes)
+        {
+            sub.stalledSinceNs = 0;
+            SendFrame(conn, sub, frame);
+            ++sent;
+            ++it;
+            continue;
+        }
+
+        // 慢订阅者
+        if(0 == sub.stalledSinceNs)
+        {
+            sub.stalledSinceNs = now;
+        }
+        const bool evict = DropPolicy::kDisconnect == _config.dropPolicy
+                        || (stall_ns > 0 && now - sub.stalledSinceNs >= stall_ns);
+        if(evict)
+        {
+            HTTP_F_WARN("sse topic[%s] evict slow subscriber conn[%s], pending[%lu]\n", _name.c_str(), conn->name().c_str(), conn->pendingBytes());
+            conn->forceClose();
+            _evicted.fetch_add(1, std::memory_order_relaxed);
+            Metrics().evicted.inc();
+            auto dead = it++;
+            removeUnLocked(dead);
+            continue;
+        }
+        if(!droppable)
+        {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            Metrics().dropped.inc();
+        }
+        ++it;
+    }
+    return sent;
+}
+
+size_t SseTopic::publish(const SseEvent &event)
+{
+    Frame frame = MakeFrame(EncodeSseEvent(event));
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_closed)
+    {
+        return 0;
+    }
+    _published.fetch_add(1, std::memory_order_relaxed);
+    if(_config.replayEvents > 0 && !event.id.empty())
+    {
+        _replay.push_back(ReplayEntry{event.id, frame});
+        if(_replay.size() > _config.replayEvents)
+        {
+            _replay.pop_front();
+        }
+    }
+    const size_t sent = fanOutUnLocked(frame, false);
+    _delivered.fetch_add(sent, std::memory_order_relaxed);
+    return sent;
+}
+
+size_t SseTopic::publish(std::string_view data)
+{
+    SseEvent event;
+    event.data.assign(data.data(), data.size());
+    return publish(event);
+}
+
+void SseTopic::onHeartbeat()
+{
+    // 注释行，客户端忽略；同时驱动慢订阅者的超时检查
+    static const Frame s_heartbeat = MakeFrame(":\n\n");
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(!_closed)
+    {
+        fanOutUnLocked(s_heartbeat, true);
+    }
+}
+
+void SseTopic::close()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_closed)
+    {
+        return;
+    }
+    _closed = true;
+    for(auto &item : _subscribers)
+    {
+        if(TcpConnectionPtr conn = item.second.conn.lock())
+        {
+            if(item.second.chunked)
+            {
+                conn->send(std::vector<SharedBuffer>{ChunkEnd()});
+            }
+            conn->shutdown();
+        }
+    }
+    Metrics().subscribers.dec(static_cast<int64_t>(_subscribers.size()));
+    _subscribers.clear();
+    _replay.clear();
+    if(_heartbeatTimer)
+    {
+        _loop->cancel(_heartbeatTimer);
+        _heartbeatTimer.reset();
+    }
+}
+
+size_t SseTopic::subscribers() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _subscribers.size();
+}
+
+SseTopic::Stats SseTopic::stats() const
+{
+    Stats stats;
+    stats.subscribers = subscribers();
+    stats.published = _published.load(std::memory_order_relaxed);
+    stats.delivered = _delivered.load(std::memory_order_relaxed);
+    stats.dropped = _dropped.load(std::memory_order_relaxed);
+    stats.evicted = _evicted.load(std::memory_order_relaxed);
+    stats.replayed = _replayed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}   // kit_muduo::http
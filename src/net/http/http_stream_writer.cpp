@@ -0,0 +1,226 @@
+/**
+ * @file http_stream_writer.cpp
+ * @brief HTTP流式响应写出器
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 14:05:21
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_stream_writer.h"
+#include "net/http/http_context.h"
+#include "net/http/http_request.h"
+#include "net/http/http_response.h"
+#include "net/http/http_servlet.h"
+#include "net/http/http_util.h"
+#include "net/tcp_connection.h"
+#include "net/event_loop.h"
+#include "net/net_log.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace kit_muduo::http {
+
+static constexpr size_t kDefaultHighWaterMark = 4 * 1024 * 1024;
+static constexpr size_t kDefaultLowWaterMark = 1 * 1024 * 1024;
+static constexpr int32_t kDefaultDrainTimeoutMs = 30 * 1000;
+
+HttpStreamWriter::HttpStreamWriter(TcpConnectionPtr conn, HttpContextPtr ctx)
+    :_conn(std::move(conn))
+    ,_ctx(std::move(ctx))
+    ,_highWaterMark(kDefaultHighWaterMark)
+    ,_lowWaterMark(kDefaultLowWaterMark)
+    ,_timeoutMs(kDefaultDrainTimeoutMs)
+{
+}
+
+HttpStreamWriter::~HttpStreamWriter()
+{
+    if(_begun && !_ended)
+    {
+        end();
+    }
+}
+
+void HttpStreamWriter::setBackpressure(size_t highWaterMark, size_t lowWaterMark, int32_t timeoutMs)
+{
+    _highWaterMark = highWaterMark;
+    _lowWaterMark = lowWaterMark < highWaterMark ? lowWaterMark : highWaterMark;
+    _timeoutMs = timeoutMs;
+}
+
+bool HttpStreamWriter::begin()
+{
+    if(_begun)
+    {
+        return !_failed;
+    }
+    _begun = true;
+
+    // HTTP/2 流由 Http2Session 分帧，不支持逐块写出，回复 503 由服务器整体发送
+    if(_ctx->isHttp2())
+    {
+        ServiceUnavailable503Servlet::Handle(_conn, _ctx);
+        fail("streaming over http/2");
+        return false;
+    }
+
+    auto req = _ctx->request();
+    auto resp = _ctx->response();
+    resp->setStreaming(true);
+
+    if(Version::kUnknow == resp->version()())
+    {
+        resp->setVersion(Version::kHttp10 == req->version()() ? Version::kHttp10 : Version::kHttp11);
+    }
+    if(StateCode::kUnknow == resp->stateCode().toInt())
+    {
+        resp->setStateCode(StateCode::k200Ok);
+    }
+
+    const int32_t code = resp->stateCode().toInt();
+    _noBody = HttpRequest::Method::kHead == req->method()()
+            || StateCode::k204NoContent == code
+            || 304 == code
+            || (code >= 100 && code < 200);
+
+    const std::string content_length(resp->header(HttpHeaderId::kContentLength));
+    if(!content_length.empty())
+    {
+        _mode = Mode::kContentLength;
+        _contentLength = std::strtoull(content_length.c_str(), nullptr, 10);
+    }
+    else if(Version::kHttp11 == resp->version()())
+    {
+        _mode = Mode::kChunked;
+        if(!_noBody)
+        {
+            resp->addHeader("Transfer-Encoding", "chunked");
+        }
+    }
+    else
+    {
+        // HTTP/1.0 没有 chunked，只能以关闭连接标识结束
+        _mode = Mode::kCloseDelimited;
+        resp->setConnectionClosed(true);
+    }
+
+    if(!_conn->connected())
+    {
+        fail("connection closed before headers");
+        return false;
+    }
+
+    _conn->send(resp->headerString());
+    HTTP_F_DEBUG("stream begin: conn[%s], path[%s], mode[%d]\n", _conn->name().c_str(), req->path().c_str(), static_cast<int>(_mode));
+    return true;
+}
+
+bool HttpStreamWriter::write(const char *data, size_t len)
+{
+    if(!begin() || _ended)
+    {
+        return false;
+    }
+    if(_noBody || 0 == len)
+    {
+        return true;
+    }
+    if(!_conn->connected())
+    {
+        fail("connection closed");
+        return false;
+    }
+
+    if(Mode::kContentLength == _mode && _bodyBytes + len > _contentLength)
+    {
+        fail("body exceeds Content-Length");
+        return false;
+    }
+
+    std::string frame;
+    if(Mode::kChunked == _mode)
+    {
+        char size_line[24];
+        int n = std::snprintf(size_line, sizeof(size_line), "%zx\r\n", len);
+        frame.reserve(n + len + 2);
+        frame.append(size_line, n);
+        frame.append(data, len);
+        frame.append("\r\n", 2);
+    }
+    else
+    {
+        frame.assign(data, len);
+    }
+
+    _conn->send(std::move(frame));
+    _bodyBytes += len;
+
+    return waitWritable();
+}
+
+bool HttpStreamWriter::end()
+{
+    if(!begin() || _ended)
+    {
+        return false;
+    }
+    _ended = true;
+
+    auto resp = _ctx->response();
+    if(!_noBody && Mode::kChunked == _mode && _conn->connected())
+    {
+        _conn->send(std::string("0\r\n\r\n"));
+    }
+
+    if(Mode::kContentLength == _mode && !_noBody && _bodyBytes != _contentLength)
+    {
+        // 长度不一致时对端无法判定边界，只能关闭连接
+        HTTP_F_WARN("stream end with short body: conn[%s], %llu/%llu\n", _conn->name().c_str(),
+                    static_cast<unsigned long long>(_bodyBytes), static_cast<unsigned long long>(_contentLength));
+        resp->setConnectionClosed(true);
+        _failed = true;
+    }
+
+    if(resp->connectionClosed() && _conn->connected())
+    {
+        _conn->shutdown();
+    }
+
+    return !_failed;
+}
+
+bool HttpStreamWriter::waitWritable()
+{
+    if(_conn->pendingBytes() <= _highWaterMark)
+    {
+        return true;
+    }
+    if(_conn->getLoop()->isInLoopThread())
+    {
+        // IO线程内无法等待，数据留在输出缓冲区
+        return true;
+    }
+    if(!_conn->waitForDrain(_lowWaterMark, _timeoutMs))
+    {
+        fail(_conn->connected() ? "drain timeout" : "connection closed");
+        if(_conn->connected())
+        {
+            _conn->shutdown();
+        }
+        return false;
+    }
+    return true;
+}
+
+void HttpStreamWriter::fail(const char *reason)
+{
+    if(!_failed)
+    {
+        HTTP_F_WARN("stream writer failed: conn[%s], reason[%s], written[%llu]\n",
+                    _conn->name().c_str(), reason, static_cast<unsigned long long>(_bodyBytes));
+    }
+    _failed = true;
+}
+
+}   // kit_muduo::http
@@ -10,21 +10,25 @@
 
 namespace kit_muduo::http {
 
-std::unordered_map<int32_t, std::string> StateCode::s_m_codeMessageMap{
-    {kUnknow, ""},
-    {k200Ok,                         "OK"},
-    {k204NoContent,                  "No Content"},
-    {k301MovedPermanently,           "Moved Permanently"},
-    {k302MoveTemporarily,            "Move temporarily"},
-    {k400BadRequest,                 "Bad Request"},
-    {k403Forbidden,                  "Forbidden"},
-    {k404NotFound,                   "Not Found"},
-    {k405MethodNotAllowed,           "Method Not Allowed"},
-    {k454SessionNotFound, "Session Not Found"},
-    {k455MethodNotValid,             "Method Not Valid"},
-    {k500InternalServerError,        "Internal Server Error"},
-    {k503ServiceUnavailable, "Service Unavailable"}
-};
+std::string FormatHttpDate(time_t t)
+{
+    struct tm tm_val;
+    ::gmtime_r(&t, &tm_val);
+    char buf[32] = {0};
+    size_t n = ::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm_val);
+    return std::string(buf, n);
+}
 
+bool ParseHttpDate(const std::string &str, time_t *out)
+{
+    struct tm tm_val = {};
+    const char *end = ::strptime(str.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm_val);
+    if(nullptr == end || *end != '\0')
+    {
+        return false;
+    }
+    *out = ::timegm(&tm_val);
+    return true;
+}
 
 }
@@ -0,0 +1,462 @@
+/**
+ * @file http_video.cpp
+ * @brief 视频分发: HLS 播放列表生成、分片/MP4 按类型与区间发送、共享分片内存缓存
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 09:12:40
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_video.h"
+#include "net/http/http_asset_cache.h"
+#include "net/http/http_context.h"
+#include "net/http/http_request.h"
+#include "net/http/http_response.h"
+#include "net/net_log.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace kit_muduo::http {
+
+namespace {
+
+constexpr size_t kTsPacketSize = 188;
+/// @brief 探测 PTS 时读取的分片头部字节数
+constexpr size_t kTsProbeBytes = 64 * 1024;
+/// @brief PTS 缓存条目上限，超出时整体清空(直播目录的旧分片会不断滚动淘汰)
+constexpr size_t kMaxPtsEntries = 4096;
+constexpr int64_t kPtsWrap = 1LL << 33;
+
+int64_t SteadyMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t WallMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool EndsWith(const std::string &s, const char *suffix)
+{
+    const size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+/// @brief 文件名自然排序: 数字串按数值比较，seg9.ts 排在 seg10.ts 之前
+bool NaturalLess(const std::string &a, const std::string &b)
+{
+    size_t i = 0, j = 0;
+    while(i < a.size() && j < b.size())
+    {
+        if(IsDigit(a[i]) && IsDigit(b[j]))
+        {
+            size_t ie = i, je = j;
+            while(ie < a.size() && IsDigit(a[ie])) ++ie;
+            while(je < b.size() && IsDigit(b[je])) ++je;
+            // 去掉前导零后先比位数再逐位比较
+            size_t is = i, js = j;
+            while(is + 1 < ie && '0' == a[is]) ++is;
+            while(js + 1 < je && '0' == b[js]) ++js;
+            if(ie - is != je - js)
+            {
+                return ie - is < je - js;
+            }
+            const int cmp = a.compare(is, ie - is, b, js, je - js);
+            if(cmp != 0)
+            {
+                return cmp < 0;
+            }
+            i = ie;
+            j = je;
+            continue;
+        }
+        if(a[i] != b[j])
+        {
+            return a[i] < b[j];
+        }
+        ++i;
+        ++j;
+    }
+    return a.size() - i < b.size() - j;
+}
+
+/// @brief 文件名(不含后缀)末尾的数字，没有时返回 -1
+int64_t TrailingNumber(const std::string &name)
+{
+    size_t end = name.find_last_of('.');
+    if(std::string::npos == end)
+    {
+        end = name.size();
+    }
+    size_t begin = end;
+    while(begin > 0 && IsDigit(name[begin - 1]))
+    {
+        --begin;
+    }
+    if(begin == end || end - begin > 18)
+    {
+        return -1;
+    }
+    return std::strtoll(name.c_str() + begin, nullptr, 10);
+}
+
+struct Segment {
+    std::string name;
+    uint64_t inode{0};
+    uint64_t size{0};
+    int64_t mtimeNs{0};
+};
+
+}
+
+VideoServlet::VideoServlet(const std::string &rootDir, const std::string &urlPrefix)
+    :VideoServlet(rootDir, urlPrefix, Config())
+{
+}
+
+VideoServlet::VideoServlet(const std::string &rootDir, const std::string &urlPrefix, Config config)
+    :HttpServlet("VideoServlet", "kit_server")
+    ,_config(config)
+    ,_files(rootDir, urlPrefix)
+{
+    // 分片存入封存的 memfd: 常驻内存且仍走 sendfile，避免大分片逐观众拷贝
+    _files.setAssetCache(_config.segmentCacheBytes > 0
+        ? std::make_shared<HttpAssetCache>(_config.segmentCacheBytes, _config.maxSegmentBytes, 1000,
+                                           HttpAssetCache::Storage::kMemFile)
+        : nullptr);
+}
+
+VideoServlet::Stats VideoServlet::stats() const
+{
+    Stats stats;
+    stats.playlistBuilds = _builds.load(std::memory_order_relaxed);
+    stats.playlistHits = _hits.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void VideoServlet::handle(TcpConnectionPtr conn, HttpContextPtr ctx)
+{
+    auto req = ctx->request();
+    const std::string &path = req->path();
+    if(!EndsWith(path, ".m3u8"))
+    {
+        _files.handle(conn, ctx);
+        return;
+    }
+
+    // 磁盘上存在的播放列表(如编码器写出的)原样发送
+    const std::string target_path = _files.resolvePath(path);
+    struct stat st;
+    if(target_path.empty() || ::stat(target_path.c_str(), &st) == 0 || ENOENT != errno)
+    {
+        _files.handle(conn, ctx);
+        return;
+    }
+
+    const std::string dir = target_path.substr(0, target_path.find_last_of('/'));
+    std::string text;
+    bool live = false;
+    bool cached = false;
+    const int64_t now_ms = SteadyMs();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _playlists.find(dir);
+        if(it != _playlists.end() && now_ms - it->second.builtMs < _config.playlistTtlMs)
+        {
+            text = it->second.text;
+            live = it->second.live;
+            cached = true;
+        }
+    }
+
+    if(cached)
+    {
+        ++_hits;
+    }
+    else
+    {
+        // 并发未命中时可能重复扫描，结果一致，只保留后写入的
+        if(!buildPlaylist(dir, WallMs(), &text, &live))
+        {
+            NotFound404Servlet::Handle(conn, ctx);
+            return;
+        }
+        ++_builds;
+        std::lock_guard<std::mutex> lock(_mutex);
+        PlaylistEntry &entry = _playlists[dir];
+        entry.text = text;
+        entry.live = live;
+        entry.builtMs = now_ms;
+    }
+
+    auto resp = ctx->response();
+    resp->setVersion(Version::kHttp11);
+    resp->setStateCode(StateCode::k200Ok);
+    resp->body().setContentType(ContentType::kUnknowType);
+    resp->addHeader("Content-Type", StaticFileServlet::MimeType("m3u8"));
+    // 直播列表随分片滚动，点播列表在目录不变时稳定
+    resp->addHeader("Cache-Control", live ? "no-cache" : "max-age=60");
+    if(HttpRequest::Method::kHead == req->method()())
+    {
+        resp->addHeader("Content-Length", std::to_string(text.size()));
+        return;
+    }
+    resp->body().appendData(text);
+}
+
+bool VideoServlet::buildPlaylist(const std::string &dir, int64_t nowMs, std::string *playlist, bool *live)
+{
+    DIR *d = ::opendir(dir.c_str());
+    if(nullptr == d)
+    {
+        return false;
+    }
+
+    std::vector<Segment> ts_segments;
+    std::vector<Segment> m4s_segments;
+    bool has_init = false;
+    const int dir_fd = ::dirfd(d);
+    while(struct dirent *ent = ::readdir(d))
+    {
+        const std::string name = ent->d_name;
+        if(name.empty() || '.' == name[0])
+        {
+            continue;
+        }
+        const bool is_ts = EndsWith(name, ".ts");
+        const bool is_m4s = EndsWith(name, ".m4s");
+        if(!is_ts && !is_m4s && name != "init.mp4")
+        {
+            continue;
+        }
+        struct stat st;
+        if(::fstatat(dir_fd, name.c_str(), &st, 0) != 0 || !S_ISREG(st.st_mode))
+        {
+            continue;
+        }
+        if(!is_ts && !is_m4s)
+        {
+            has_init = true;
+            continue;
+        }
+        Segment seg;
+        seg.name = name;
+        seg.inode = static_cast<uint64_t>(st.st_ino);
+        seg.size = static_cast<uint64_t>(st.st_size);
+        seg.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+        (is_ts ? ts_segments : m4s_segments).push_back(std::move(seg));
+    }
+    ::closedir(d);
+
+    const bool fmp4 = ts_segments.empty();
+    std::vector<Segment> &segments = fmp4 ? m4s_segments : ts_segments;
+    if(segments.empty())
+    {
+        return false;
+    }
+    std::sort(segments.begin(), segments.end(),
+              [](const Segment &a, const Segment &b) { return NaturalLess(a.name, b.name); });
+
+    int64_t newest_ms = 0;
+    for(const Segment &seg : segments)
+    {
+        newest_ms = std::max(newest_ms, seg.mtimeNs / 1000000);
+    }
+    *live = nowMs - newest_ms < _config.liveThresholdMs;
+
+    size_t first_index = 0;
+    if(*live)
+    {
+        // 仍在写入的分片不列出，播放器拿到的分片都是完整的
+        const int64_t settled_ms = nowMs - _config.settleMs;
+        segments.erase(std::remove_if(segments.begin(), segments.end(),
+                                      [settled_ms](const Segment &seg) { return seg.mtimeNs / 1000000 > settled_ms; }),
+                       segments.end());
+        if(segments.empty())
+        {
+            return false;
+        }
+        const size_t window = std::max<size_t>(1, _config.liveWindow);
+        if(segments.size() > window)
+        {
+            first_index = segments.size() - window;
+            segments.erase(segments.begin(), segments.begin() + static_cast<std::ptrdiff_t>(first_index));
+        }
+    }
+
+    // 分片时长: 相邻 .ts 首个 PTS 之差，其余使用配置值
+    std::vector<double> durations(segments.size(), _config.targetDuration);
+    if(!fmp4)
+    {
+        std::vector<int64_t> pts(segments.size());
+        for(size_t i = 0; i < segments.size(); ++i)
+        {
+            pts[i] = segmentPts(dir + "/" + segments[i].name, segments[i].inode, segments[i].size, segments[i].mtimeNs);
+        }
+        for(size_t i = 0; i + 1 < segments.size(); ++i)
+        {
+            if(pts[i] < 0 || pts[i + 1] < 0)
+            {
+                continue;
+            }
+            const double seconds = static_cast<double>((pts[i + 1] - pts[i] + kPtsWrap) % kPtsWrap) / 90000.0;
+            // 不连续(重新开播、剪辑)的分片回落到配置值
+            if(seconds > 0.0 && seconds <= _config.targetDuration * 4)
+            {
+                durations[i] = seconds;
+            }
+        }
+    }
+
+    double max_duration = 0.0;
+    for(double duration : durations)
+    {
+        max_duration = std::max(max_duration, duration);
+    }
+    // EXTINF 四舍五入后不得超过 TARGETDURATION
+    const long target = std::max(1L, static_cast<long>(std::ceil(max_duration - 0.0005)));
+
+    // 媒体序号优先取文件名中的编号，分片滚动删除后仍保持连续
+    int64_t sequence = TrailingNumber(segments.front().name);
+    if(sequence < 0)
+    {
+        sequence = static_cast<int64_t>(first_index);
+    }
+
+    std::string &out = *playlist;
+    out.clear();
+    out.reserve(64 + segments.size() * 48);
+    char line[64];
+    out += "#EXTM3U\n";
+    out += fmp4 ? "#EXT-X-VERSION:7\n" : "#EXT-X-VERSION:3\n";
+    std::snprintf(line, sizeof(line), "#EXT-X-TARGETDURATION:%ld\n", target);
+    out += line;
+    std::snprintf(line, sizeof(line), "#EXT-X-MEDIA-SEQUENCE:%lld\n", static_cast<long long>(sequence));
+    out += line;
+    if(!*live)
+    {
+        out += "#EXT-X-PLAYLIST-TYPE:VOD\n";
+    }
+    if(fmp4 && has_init)
+    {
+        out += "#EXT-X-MAP:URI=\"init.mp4\"\n";
+    }
+    for(size_t i = 0; i < segments.size(); ++i)
+    {
+        std::snprintf(line, sizeof(line), "#EXTINF:%.3f,\n", durations[i]);
+        out += line;
+        out += segments[i].name;
+        out += '\n';
+    }
+    if(!*live)
+    {
+        out += "#EXT-X-ENDLIST\n";
+    }
+    return true;
+}
+
+int64_t VideoServlet::segmentPts(const std::string &path, uint64_t inode, uint64_t size, int64_t mtimeNs)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _pts.find(path);
+        if(it != _pts.end() && it->second.inode == inode && it->second.size == size && it->second.mtimeNs == mtimeNs)
+        {
+            return it->second.pts;
+        }
+    }
+
+    int64_t pts = -1;
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd >= 0)
+    {
+        std::string head(std::min<uint64_t>(size, kTsProbeBytes), '\0');
+        const ssize_t n = head.empty() ? 0 : ::pread(fd, &head[0], head.size(), 0);
+        ::close(fd);
+        if(n > 0)
+        {
+            pts = ProbeTsPts(head.data(), static_cast<size_t>(n));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_pts.size() >= kMaxPtsEntries)
+    {
+        _pts.clear();
+    }
+    PtsEntry &entry = _pts[path];
+    entry.inode = inode;
+    entry.size = size;
+    entry.mtimeNs = mtimeNs;
+    entry.pts = pts;
+    return pts;
+}
+
+int64_t VideoServlet::ProbeTsPts(const char *data, size_t len)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char*>(data);
+
+    // 同步字节 0x47 按 188 字节周期出现
+    size_t offset = 0;
+    while(offset < kTsPacketSize && offset < len
+          && !(0x47 == p[offset] && (offset + kTsPacketSize >= len || 0x47 == p[offset + kTsPacketSize])))
+    {
+        ++offset;
+    }
+
+    for(; offset + kTsPacketSize <= len; offset += kTsPacketSize)
+    {
+        const unsigned char *pkt = p + offset;
+        if(0x47 != pkt[0])
+        {
+            return -1;
+        }
+        const bool unit_start = 0 != (pkt[1] & 0x40);
+        const uint8_t adaptation = (pkt[3] >> 4) & 0x03;
+        if(!unit_start || 0 == (adaptation & 0x01))
+        {
+            continue;
+        }
+        size_t pos = 4;
+        if(adaptation & 0x02)
+        {
+            pos += 1 + pkt[4];
+        }
+        // PES 头: 起始码(3) stream_id(1) 长度(2) 标志(2) 头长(1) PTS(5)
+        if(pos + 14 > kTsPacketSize)
+        {
+            continue;
+        }
+        const unsigned char *pes = pkt + pos;
+        if(0 != pes[0] || 0 != pes[1] || 1 != pes[2])
+        {
+            continue;
+        }
+        // 只看音视频流(0xC0-0xEF)
+        if(pes[3] < 0xC0 || pes[3] > 0xEF || 0 == (pes[7] & 0x80))
+        {
+            continue;
+        }
+        return (static_cast<int64_t>((pes[9] >> 1) & 0x07) << 30)
+            | (static_cast<int64_t>(pes[10]) << 22)
+            | (static_cast<int64_t>(pes[11] >> 1) << 15)
+            | (static_cast<int64_t>(pes[12]) << 7)
+            | static_cast<int64_t>(pes[13] >> 1);
+    }
+    return -1;
+}
+
+}   // kit_muduo::http
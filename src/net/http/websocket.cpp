@@ -0,0 +1,726 @@
+/**
+ * @file websocket.cpp
+ * @brief WebSocket(RFC 6455): 握手、帧编解码、连接会话与广播
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 22:52:30
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/websocket.h"
+#include "net/http/http_headers.h"
+#include "net/http/http_request.h"
+#include "net/buffer.h"
+#include "net/event_loop.h"
+#include "net/net_log.h"
+#include "net/tcp_connection.h"
+#include "base/digest.h"
+#include "base/metrics.h"
+
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KIT_WS_MASK_X86 1
+#include <immintrin.h>
+#endif
+
+namespace kit_muduo::http {
+
+namespace {
+
+constexpr char kWebSocketGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+/// @brief 控制帧负载上限
+constexpr size_t kMaxControlPayload = 125;
+/// @brief 发出关闭帧后等待对端回应的时间
+constexpr int64_t kCloseTimeoutMs = 3000;
+
+metrics::Gauge& ActiveGauge()
+{
+    static metrics::Gauge &s_active = metrics::MetricsRegistry::Instance().gauge(
+        "kit_websocket_active_connections", "Open WebSocket connections");
+    return s_active;
+}
+
+/// @brief 从 offset 相位开始重复掩码得到的 8 字节
+uint64_t RepeatKey(const uint8_t key[4], size_t offset)
+{
+    uint8_t bytes[8];
+    for(size_t i = 0; i < 8; ++i)
+    {
+        bytes[i] = key[(offset + i) & 3];
+    }
+    uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+}
+
+/****************** 标量实现 ******************/
+void ScalarMask(char *data, size_t len, const uint8_t key[4], size_t offset)
+{
+    const uint64_t word_key = RepeatKey(key, offset);
+    size_t i = 0;
+    for(; i + 8 <= len; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        word ^= word_key;
+        std::memcpy(data + i, &word, sizeof(word));
+    }
+    for(; i < len; ++i)
+    {
+        data[i] ^= key[(offset + i) & 3];
+    }
+}
+
+#ifdef KIT_WS_MASK_X86
+/****************** SSE2 ******************/
+__attribute__((target("sse2")))
+void SSE2Mask(char *data, size_t len, const uint8_t key[4], size_t offset)
+{
+    // 16、32 都是 4 的倍数，向量部分结束后掩码相位不变
+    const __m128i vkey = _mm_set1_epi64x(static_cast<long long>(RepeatKey(key, offset)));
+    size_t i = 0;
+    for(; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_xor_si128(v, vkey));
+    }
+    ScalarMask(data + i, len - i, key, offset + i);
+}
+
+/****************** AVX2 ******************/
+__attribute__((target("avx2")))
+void AVX2Mask(char *data, size_t len, const uint8_t key[4], size_t offset)
+{
+    const __m256i vkey = _mm256_set1_epi64x(static_cast<long long>(RepeatKey(key, offset)));
+    size_t i = 0;
+    for(; i + 64 <= len; i += 64)
+    {
+        __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_xor_si256(v0, vkey));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i + 32), _mm256_xor_si256(v1, vkey));
+    }
+    for(; i + 32 <= len; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_xor_si256(v, vkey));
+    }
+    ScalarMask(data + i, len - i, key, offset + i);
+}
+#endif
+
+uint16_t ReadBE16(const uint8_t *p)
+{
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint64_t ReadBE64(const uint8_t *p)
+{
+    uint64_t v = 0;
+    for(int i = 0; i < 8; ++i)
+    {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+/// @brief 可出现在关闭帧中的状态码
+bool ValidCloseCode(uint16_t code)
+{
+    return (code >= 1000 && code <= 1003) || (code >= 1007 && code <= 1014) || (code >= 3000 && code <= 4999);
+}
+
+}
+
+std::string WebSocketAcceptKey(std::string_view clientKey)
+{
+    Sha1 sha1;
+    sha1.update(clientKey.data(), clientKey.size());
+    sha1.update(kWebSocketGuid, sizeof(kWebSocketGuid) - 1);
+    const Sha1Digest digest = sha1.finish();
+    return Base64Encode(digest.data(), digest.size());
+}
+
+bool IsWebSocketUpgrade(const HttpRequest &req, int32_t *status)
+{
+    int32_t dummy = 0;
+    int32_t &code = status ? *status : dummy;
+    code = 0;
+    if(!HeaderHasToken(req.header(HttpHeaderId::kUpgrade), "websocket"))
+    {
+        return false;
+    }
+
+    code = StateCode::k400BadRequest;
+    if(HttpRequest::Method::kGet != req.method()() || Version::kHttp11 != req.version()()
+        || !HeaderHasToken(req.header(HttpHeaderId::kConnection), "upgrade"))
+    {
+        return false;
+    }
+    if("13" != TrimHttpSpace(req.header("Sec-WebSocket-Version")))
+    {
+        code = StateCode::k426UpgradeRequired;
+        return false;
+    }
+    // 客户端 key 为 16 字节随机数的 Base64
+    std::string nonce;
+    if(!Base64Decode(TrimHttpSpace(req.header("Sec-WebSocket-Key")), &nonce) || 16 != nonce.size())
+    {
+        return false;
+    }
+    code = 0;
+    return true;
+}
+
+void WebSocketMaskWith(HttpScanLevel level, char *data, size_t len, const uint8_t key[4], size_t offset)
+{
+#ifdef KIT_WS_MASK_X86
+    switch(level)
+    {
+    case HttpScanLevel::kAVX2: AVX2Mask(data, len, key, offset); return;
+    case HttpScanLevel::kSSE42: SSE2Mask(data, len, key, offset); return;
+    default: break;
+    }
+#endif
+    ScalarMask(data, len, key, offset);
+}
+
+void WebSocketMask(char *data, size_t len, const uint8_t key[4], size_t offset)
+{
+    WebSocketMaskWith(HttpScanLevelInUse(), data, len, key, offset);
+}
+
+/****************** WebSocketCodec ******************/
+WebSocketCodec::WebSocketCodec()
+    :WebSocketCodec(Config())
+{
+}
+
+WebSocketCodec::WebSocketCodec(Config config)
+    :_config(std::move(config))
+{
+}
+
+WebSocketCodec::DecodeResult WebSocketCodec::fail(uint16_t code)
+{
+    _errorCode = code;
+    return DecodeResult::kError;
+}
+
+WebSocketCodec::DecodeResult WebSocketCodec::decode(Buffer &buf, WebSocketMessage *msg)
+{
+    while(true)
+    {
+        const size_t avail = buf.readableBytes();
+        if(avail < 2)
+        {
+            return DecodeResult::kNeedMore;
+        }
+
+        const uint8_t *p = reinterpret_cast<const uint8_t*>(buf.peek());
+        const bool fin = p[0] & 0x80;
+        const auto opcode = static_cast<WebSocketOpcode>(p[0] & 0x0F);
+        const bool masked = p[1] & 0x80;
+        uint64_t len = p[1] & 0x7F;
+        size_t header = 2;
+
+        // 未协商扩展，RSV 位必须为0
+        if(p[0] & 0x70)
+        {
+            return fail(WebSocketCloseCode::kProtocolError);
+        }
+        if(126 == len)
+        {
+            if(avail < 4)
+            {
+                return DecodeResult::kNeedMore;
+            }
+            len = ReadBE16(p + 2);
+            header = 4;
+        }
+        else if(127 == len)
+        {
+            if(avail < 10)
+            {
+                return DecodeResult::kNeedMore;
+            }
+            len = ReadBE64(p + 2);
+            header = 10;
+            if(len >> 63)
+            {
+                return fail(WebSocketCloseCode::kProtocolError);
+            }
+        }
+        if(masked != _config.expectMasked)
+        {
+            return fail(WebSocketCloseCode::kProtocolError);
+        }
+
+        const bool control = static_cast<uint8_t>(opcode) & 0x8;
+        if(control)
+        {
+            if((WebSocketOpcode::kClose != opcode && WebSocketOpcode::kPing != opcode && WebSocketOpcode::kPong != opcode)
+                || !fin || len > kMaxControlPayload)
+            {
+                return fail(WebSocketCloseCode::kProtocolError);
+            }
+        }
+        else
+        {
+            if(WebSocketOpcode::kText != opcode && WebSocketOpcode::kBinary != opcode && WebSocketOpcode::kContinuation != opcode)
+            {
+                return fail(WebSocketCloseCode::kProtocolError);
+            }
+            // 续帧必须接在未结束的分片消息之后，新消息不能打断分片消息
+            const bool fragmenting = WebSocketOpcode::kContinuation != _fragmentOpcode;
+            if((WebSocketOpcode::kContinuation == opcode) != fragmenting)
+            {
+                return fail(WebSocketCloseCode::kProtocolError);
+            }
+            if(len > _config.maxMessageBytes - std::min(_fragments.size(), _config.maxMessageBytes))
+            {
+                return fail(WebSocketCloseCode::kMessageTooBig);
+            }
+        }
+
+        const size_t mask_offset = header;
+        header += masked ? 4 : 0;
+        if(avail < header || avail - header < len)
+        {
+            return DecodeResult::kNeedMore;
+        }
+
+        char *payload = buf.peek() + header;
+        if(masked)
+        {
+            uint8_t key[4];
+            std::memcpy(key, p + mask_offset, sizeof(key));
+            WebSocketMask(payload, len, key);
+        }
+
+        if(control)
+        {
+            msg->opcode = opcode;
+            msg->payload.assign(payload, len);
+            msg->close_code = WebSocketCloseCode::kNoStatus;
+            msg->close_reason.clear();
+            buf.reset(header + len);
+            if(WebSocketOpcode::kClose == opcode && !msg->payload.empty())
+            {
+                const uint8_t *body = reinterpret_cast<const uint8_t*>(msg->payload.data());
+                if(1 == len || !ValidCloseCode(ReadBE16(body)))
+                {
+                    return fail(WebSocketCloseCode::kProtocolError);
+                }
+                msg->close_code = ReadBE16(body);
+                msg->close_reason.assign(msg->payload, 2, std::string::npos);
+                if(_config.validateUtf8 && !ValidUtf8(msg->close_reason.data(), msg->close_reason.size()))
+                {
+                    return fail(WebSocketCloseCode::kInvalidPayload);
+                }
+            }
+            return DecodeResult::kMessage;
+        }
+
+        if(fin && WebSocketOpcode::kContinuation != opcode)
+        {
+            // 未分片的消息直接拷出
+            msg->opcode = opcode;
+            msg->payload.assign(payload, len);
+            buf.reset(header + len);
+        }
+        else
+        {
+            _fragments.append(payload, len);
+            buf.reset(header + len);
+            if(WebSocketOpcode::kContinuation != opcode)
+            {
+                _fragmentOpcode = opcode;
+            }
+            if(!fin)
+            {
+                continue;
+            }
+            msg->opcode = _fragmentOpcode;
+            msg->payload.swap(_fragments);
+            _fragments.clear();
+            _fragmentOpcode = WebSocketOpcode::kContinuation;
+        }
+
+        if(WebSocketOpcode::kText == msg->opcode && _config.validateUtf8
+            && !ValidUtf8(msg->payload.data(), msg->payload.size()))
+        {
+            return fail(WebSocketCloseCode::kInvalidPayload);
+        }
+        return DecodeResult::kMessage;
+    }
+}
+
+std::string WebSocketCodec::Encode(WebSocketOpcode opcode, const void *data, size_t len, bool fin, const uint8_t *maskKey)
+{
+    uint8_t header[14];
+    size_t header_len = 2;
+    header[0] = static_cast<uint8_t>((fin ? 0x80 : 0) | static_cast<uint8_t>(opcode));
+    const uint8_t mask_bit = maskKey ? 0x80 : 0;
+    if(len < 126)
+    {
+        header[1] = static_cast<uint8_t>(mask_bit | len);
+    }
+    else if(len <= 0xFFFF)
+    {
+        header[1] = mask_bit | 126;
+        header[2] = static_cast<uint8_t>(len >> 8);
+        header[3] = static_cast<uint8_t>(len);
+        header_len = 4;
+    }
+    else
+    {
+        header[1] = mask_bit | 127;
+        for(int i = 0; i < 8; ++i)
+        {
+            header[2 + i] = static_cast<uint8_t>(static_cast<uint64_t>(len) >> (56 - 8 * i));
+        }
+        header_len = 10;
+    }
+    if(maskKey)
+    {
+        std::memcpy(header + header_len, maskKey, 4);
+        header_len += 4;
+    }
+
+    std::string frame;
+    frame.reserve(header_len + len);
+    frame.append(reinterpret_cast<const char*>(header), header_len);
+    frame.append(static_cast<const char*>(data), len);
+    if(maskKey)
+    {
+        WebSocketMask(&frame[header_len], len, maskKey);
+    }
+    return frame;
+}
+
+std::string WebSocketCodec::EncodeClose(uint16_t code, std::string_view reason)
+{
+    if(WebSocketCloseCode::kNoStatus == code)
+    {
+        return Encode(WebSocketOpcode::kClose, nullptr, 0);
+    }
+    std::string payload;
+    payload.push_back(static_cast<char>(code >> 8));
+    payload.push_back(static_cast<char>(code));
+    payload.append(reason.substr(0, kMaxControlPayload - 2));
+    return Encode(WebSocketOpcode::kClose, payload.data(), payload.size());
+}
+
+bool WebSocketCodec::ValidUtf8(const char *data, size_t len)
+{
+    const uint8_t *p = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t *end = p + len;
+    while(p < end)
+    {
+        // ASCII 快速路径，一次检查8字节
+        if(end - p >= 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            if(0 == (word & 0x8080808080808080ull))
+            {
+                p += 8;
+                continue;
+            }
+        }
+
+        const uint8_t c = *p;
+        if(c < 0x80)
+        {
+            ++p;
+            continue;
+        }
+
+        size_t n;
+        uint32_t cp;
+        if(c >= 0xC2 && c <= 0xDF)
+        {
+            n = 1;
+            cp = c & 0x1F;
+        }
+        else if(c >= 0xE0 && c <= 0xEF)
+        {
+            n = 2;
+            cp = c & 0x0F;
+        }
+        else if(c >= 0xF0 && c <= 0xF4)
+        {
+            n = 3;
+            cp = c & 0x07;
+        }
+        else
+        {
+            return false;
+        }
+        if(static_cast<size_t>(end - p) <= n)
+        {
+            return false;
+        }
+        for(size_t i = 1; i <= n; ++i)
+        {
+            if(0x80 != (p[i] & 0xC0))
+            {
+                return false;
+            }
+            cp = (cp << 6) | (p[i] & 0x3F);
+        }
+        // 过长编码、代理区、超出 Unicode 范围
+        if((2 == n && cp < 0x800) || (3 == n && cp < 0x10000) || (cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+        {
+            return false;
+        }
+        p += n + 1;
+    }
+    return true;
+}
+
+/****************** WebSocketConnection ******************/
+WebSocketConnection::WebSocketConnection(const TcpConnectionPtr &conn, std::shared_ptr<WebSocketHandler> handler,
+                                         const std::string &path, WebSocketCodec::Config config)
+    :_conn(conn)
+    ,_name(conn->name())
+    ,_handler(std::move(handler))
+    ,_path(path)
+    ,_codec(std::move(config))
+{
+}
+
+WebSocketConnection::~WebSocketConnection() = default;
+
+bool WebSocketConnection::sendFrame(const SharedBuffer &frame)
+{
+    if(State::kOpen != state())
+    {
+        return false;
+    }
+    TcpConnectionPtr conn = _conn.lock();
+    if(!conn)
+    {
+        return false;
+    }
+    conn->send(std::vector<SharedBuffer>{frame});
+    return true;
+}
+
+bool WebSocketConnection::sendText(std::string_view text)
+{
+    return sendFrame(std::make_shared<const std::string>(WebSocketCodec::Encode(WebSocketOpcode::kText, text.data(), text.size())));
+}
+
+bool WebSocketConnection::sendBinary(const void *data, size_t len)
+{
+    return sendFrame(std::make_shared<const std::string>(WebSocketCodec::Encode(WebSocketOpcode::kBinary, data, len)));
+}
+
+bool WebSocketConnection::ping(std::string_view payload)
+{
+    if(payload.size() > kMaxControlPayload)
+    {
+        return false;
+    }
+    return sendFrame(std::make_shared<const std::string>(WebSocketCodec::Encode(WebSocketOpcode::kPing, payload.data(), payload.size())));
+}
+
+size_t WebSocketConnection::pendingBytes() const
+{
+    TcpConnectionPtr conn = _conn.lock();
+    return conn ? conn->pendingBytes() : 0;
+}
+
+void WebSocketConnection::close(uint16_t code, std::string_view reason)
+{
+    State expected = State::kOpen;
+    if(!_state.compare_exchange_strong(expected, State::kClosing))
+    {
+        return;
+    }
+    TcpConnectionPtr conn = _conn.lock();
+    if(!conn)
+    {
+        return;
+    }
+    conn->send(WebSocketCodec::EncodeClose(code, reason));
+
+    // 对端迟迟不回应关闭帧时直接断开；shutdown 要等输出缓冲发完且只关写端，
+    // 对端不读或不回应时连接会一直挂着
+    std::weak_ptr<TcpConnection> weak_conn = conn;
+    conn->getLoop()->runAfter(kCloseTimeoutMs, [weak_conn]() {
+        if(TcpConnectionPtr c = weak_conn.lock())
+        {
+            c->forceClose();
+        }
+    });
+}
+
+void WebSocketConnection::onOpen()
+{
+    ActiveGauge().inc();
+    HTTP_F_INFO("websocket open conn[%s] path[%s]\n", _name.c_str(), _path.c_str());
+    if(_handler)
+    {
+        _handler->onOpen(shared_from_this());
+    }
+}
+
+void WebSocketConnection::onData(Buffer &buf)
+{
+    WebSocketMessage msg;
+    while(State::kClosed != state())
+    {
+        switch(_codec.decode(buf, &msg))
+        {
+        case WebSocketCodec::DecodeResult::kNeedMore:
+            return;
+        case WebSocketCodec::DecodeResult::kError:
+            fail(_codec.errorCode());
+            break;
+        case WebSocketCodec::DecodeResult::kMessage:
+            handleMessage(msg);
+            break;
+        }
+    }
+    // 关闭后到达的数据直接丢弃
+    buf.resetAll();
+}
+
+void WebSocketConnection::handleMessage(WebSocketMessage &msg)
+{
+    switch(msg.opcode)
+    {
+    case WebSocketOpcode::kPing:
+        if(connected())
+        {
+            sendFrame(std::make_shared<const std::string>(WebSocketCodec::Encode(WebSocketOpcode::kPong, msg.payload.data(), msg.payload.size())));
+        }
+        return;
+    case WebSocketOpcode::kClose:
+    {
+        // 对端发起时回应同样的状态码；本端发起时这就是回应。之后由服务端先断开TCP
+        const State prev = _state.exchange(State::kClosed);
+        TcpConnectionPtr conn = _conn.lock();
+        if(conn)
+        {
+            if(State::kOpen == prev)
+            {
+                conn->send(WebSocketCodec::EncodeClose(msg.close_code));
+            }
+            conn->shutdown();
+        }
+        notifyClosed(msg.close_code, msg.close_reason);
+        return;
+    }
+    default:
+        if(connected() && _handler)
+        {
+            _handler->onMessage(shared_from_this(), msg);
+        }
+        return;
+    }
+}
+
+void WebSocketConnection::fail(uint16_t code)
+{
+    HTTP_F_WARN("websocket conn[%s] protocol error, close with %u\n", _name.c_str(), code);
+    const State prev = _state.exchange(State::kClosed);
+    TcpConnectionPtr conn = _conn.lock();
+    if(conn)
+    {
+        if(State::kOpen == prev)
+        {
+            conn->send(WebSocketCodec::EncodeClose(code));
+        }
+        conn->shutdown();
+    }
+    notifyClosed(code, "");
+}
+
+void WebSocketConnection::onDisconnected()
+{
+    _state.store(State::kClosed, std::memory_order_release);
+    notifyClosed(WebSocketCloseCode::kAbnormal, "");
+}
+
+void WebSocketConnection::notifyClosed(uint16_t code, const std::string &reason)
+{
+    if(_closeNotified.exchange(true))
+    {
+        return;
+    }
+    ActiveGauge().dec();
+    HTTP_F_INFO("websocket closed conn[%s] path[%s] code[%u]\n", _name.c_str(), _path.c_str(), code);
+    if(_handler)
+    {
+        _handler->onClose(shared_from_this(), code, reason);
+    }
+}
+
+/****************** WebSocketHub ******************/
+WebSocketHub::WebSocketHub(size_t maxPendingBytes)
+    :_maxPendingBytes(maxPendingBytes)
+{
+}
+
+void WebSocketHub::add(const WebSocketConnection::Ptr &ws)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _members[ws.get()] = ws;
+}
+
+void WebSocketHub::remove(const WebSocketConnection::Ptr &ws)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _members.erase(ws.get());
+}
+
+size_t WebSocketHub::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _members.size();
+}
+
+size_t WebSocketHub::broadcast(WebSocketOpcode opcode, const void *data, size_t len)
+{
+    return broadcastFrame(std::make_shared<const std::string>(WebSocketCodec::Encode(opcode, data, len)));
+}
+
+size_t WebSocketHub::broadcastFrame(const SharedBuffer &frame)
+{
+    std::vector<WebSocketConnection::Ptr> members;
+    {
+    std::lock_guard<std::mutex> lock(_mutex);
+    members.reserve(_members.size());
+    for(auto it = _members.begin(); it != _members.end(); )
+    {
+        WebSocketConnection::Ptr ws = it->second.lock();
+        // 顺带清理已关闭的连接
+        if(!ws || WebSocketConnection::State::kClosed == ws->state())
+        {
+            it = _members.erase(it);
+            continue;
+        }
+        members.push_back(std::move(ws));
+        ++it;
+    }
+    }
+
+    size_t sent = 0;
+    for(auto &ws : members)
+    {
+        if(_maxPendingBytes > 0 && ws->pendingBytes() > _maxPendingBytes)
+        {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        sent += ws->sendFrame(frame) ? 1 : 0;
+    }
+    return sent;
+}
+
+}   // kit_muduo::http
@@ -0,0 +1,331 @@
+/**
+ * @file rtp.cpp
+ * @brief RTP 打包: 包头编解码、复用的包缓冲池与 H.264(RFC 6184)分包
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 05:02:17
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/rtsp/rtp.h"
+#include "base/digest.h"
+
+#include <cstdio>
+
+namespace kit_muduo::rtsp {
+
+namespace {
+
+/// @brief H.264 NAL 类型
+constexpr uint8_t kNalIdr = 5;
+constexpr uint8_t kNalSps = 7;
+constexpr uint8_t kNalPps = 8;
+constexpr uint8_t kNalFuA = 28;
+
+inline void PutBe16(char *out, uint16_t v)
+{
+    out[0] = static_cast<char>(v >> 8);
+    out[1] = static_cast<char>(v);
+}
+
+inline void PutBe32(char *out, uint32_t v)
+{
+    out[0] = static_cast<char>(v >> 24);
+    out[1] = static_cast<char>(v >> 16);
+    out[2] = static_cast<char>(v >> 8);
+    out[3] = static_cast<char>(v);
+}
+
+inline uint32_t GetBe32(const unsigned char *p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+        | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+/// @brief 返回 [pos, len) 中下一个起始码的位置与长度(3或4)，找不到时位置为 len
+size_t FindStartCode(const unsigned char *p, size_t len, size_t pos, size_t *codeLen)
+{
+    for(size_t i = pos; i + 3 <= len; ++i)
+    {
+        if(0 == p[i] && 0 == p[i + 1])
+        {
+            if(1 == p[i + 2])
+            {
+                *codeLen = 3;
+                return i;
+            }
+            if(i + 4 <= len && 0 == p[i + 2] && 1 == p[i + 3])
+            {
+                *codeLen = 4;
+                return i;
+            }
+        }
+    }
+    *codeLen = 0;
+    return len;
+}
+
+}
+
+void WriteRtpHeader(char *out, const RtpHeader &header)
+{
+    out[0] = static_cast<char>(0x80);
+    out[1] = static_cast<char>((header.marker ? 0x80 : 0x00) | (header.payloadType & 0x7F));
+    PutBe16(out + 2, header.seq);
+    PutBe32(out + 4, header.timestamp);
+    PutBe32(out + 8, header.ssrc);
+}
+
+bool ParseRtpHeader(const char *data, size_t len, RtpHeader *header, size_t *payloadOffset)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char*>(data);
+    if(len < kRtpHeaderSize || 2 != (p[0] >> 6))
+    {
+        return false;
+    }
+    header->marker = 0 != (p[1] & 0x80);
+    header->payloadType = p[1] & 0x7F;
+    header->seq = static_cast<uint16_t>((p[2] << 8) | p[3]);
+    header->timestamp = GetBe32(p + 4);
+    header->ssrc = GetBe32(p + 8);
+
+    size_t offset = kRtpHeaderSize + 4 * (p[0] & 0x0F);
+    if(p[0] & 0x10)
+    {
+        if(len < offset + 4)
+        {
+            return false;
+        }
+        offset += 4 + 4 * static_cast<size_t>((p[offset + 2] << 8) | p[offset + 3]);
+    }
+    if(offset > len)
+    {
+        return false;
+    }
+    *payloadOffset = offset;
+    return true;
+}
+
+RtpPacketPool::State::~State()
+{
+    for(std::string *buf : free)
+    {
+        delete buf;
+    }
+}
+
+RtpPacketPool::RtpPacketPool(size_t maxCached)
+    :_state(std::make_shared<State>())
+{
+    _state->maxCached = maxCached;
+}
+
+std::shared_ptr<std::string> RtpPacketPool::acquire(size_t capacity)
+{
+    std::string *buf = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        if(!_state->free.empty())
+        {
+            buf = _state->free.back();
+            _state->free.pop_back();
+        }
+    }
+    ++_state->acquired;
+    if(nullptr == buf)
+    {
+        ++_state->allocated;
+        buf = new std::string();
+    }
+    buf->reserve(capacity);
+
+    std::weak_ptr<State> weak = _state;
+    return std::shared_ptr<std::string>(buf, [weak](std::string *p) { Recycle(weak, p); });
+}
+
+void RtpPacketPool::Recycle(const std::weak_ptr<State> &weak, std::string *buf)
+{
+    if(auto state = weak.lock())
+    {
+        buf->clear();
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if(state->free.size() < state->maxCached)
+        {
+            state->free.push_back(buf);
+            return;
+        }
+    }
+    delete buf;
+}
+
+RtpPacketPool::Stats RtpPacketPool::stats() const
+{
+    Stats stats;
+    stats.acquired = _state->acquired.load();
+    stats.allocated = _state->allocated.load();
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    stats.cached = _state->free.size();
+    return stats;
+}
+
+RtpPacketizer::RtpPacketizer(Codec codec, uint8_t payloadType, uint32_t ssrc, uint8_t defaultChannel,
+                             size_t mtu, RtpPacketPool *pool)
+    :_codec(codec)
+    ,_payloadType(payloadType)
+    ,_ssrc(ssrc)
+    ,_defaultChannel(defaultChannel)
+    ,_mtu(mtu < 16 ? 16 : mtu)
+    ,_pool(pool)
+    ,_seq(static_cast<uint16_t>(ssrc ^ (ssrc >> 16)))
+{
+}
+
+std::vector<std::string_view> RtpPacketizer::SplitAnnexB(const char *data, size_t len)
+{
+    std::vector<std::string_view> nals;
+    const unsigned char *p = reinterpret_cast<const unsigned char*>(data);
+    size_t code_len = 0;
+    size_t pos = FindStartCode(p, len, 0, &code_len);
+    if(pos == len)
+    {
+        if(len > 0)
+        {
+            nals.emplace_back(data, len);
+        }
+        return nals;
+    }
+
+    while(pos < len)
+    {
+        const size_t begin = pos + code_len;
+        pos = FindStartCode(p, len, begin, &code_len);
+        size_t end = pos;
+        // 4 字节起始码前可能还有 trailing_zero
+        while(end > begin && 0 == p[end - 1] && end < len)
+        {
+            --end;
+        }
+        if(end > begin)
+        {
+            nals.emplace_back(data + begin, end - begin);
+        }
+    }
+    return nals;
+}
+
+bool RtpPacketizer::packetize(const char *data, size_t len, uint32_t timestamp, std::vector<SharedBuffer> *out)
+{
+    _lastTimestamp = timestamp;
+    if(Codec::kGeneric == _codec)
+    {
+        size_t offset = 0;
+        do
+        {
+            const size_t n = std::min(_mtu, len - offset);
+            offset += n;
+            out->push_back(makePacket(std::string_view(), std::string_view(data + offset - n, n), offset == len, timestamp));
+        } while(offset < len);
+        return true;
+    }
+
+    bool keyframe = false;
+    std::vector<std::string_view> nals = SplitAnnexB(data, len);
+    for(size_t i = 0; i < nals.size(); ++i)
+    {
+        const uint8_t type = static_cast<uint8_t>(nals[i][0]) & 0x1F;
+        if(kNalSps == type)
+        {
+            _sps.assign(nals[i].data(), nals[i].size());
+        }
+        else if(kNalPps == type)
+        {
+            _pps.assign(nals[i].data(), nals[i].size());
+        }
+        else if(kNalIdr == type)
+        {
+            keyframe = true;
+        }
+        packetizeNal(nals[i], i + 1 == nals.size(), timestamp, out);
+    }
+    return keyframe;
+}
+
+void RtpPacketizer::packetizeNal(std::string_view nal, bool lastNal, uint32_t timestamp, std::vector<SharedBuffer> *out)
+{
+    if(nal.size() <= _mtu)
+    {
+        out->push_back(makePacket(std::string_view(), nal, lastNal, timestamp));
+        return;
+    }
+
+    // FU-A: 指示字节保留 F/NRI，类型为28；FU 头携带原 NAL 类型与 S/E 位，原 NAL 头不再发送
+    const uint8_t nal_header = static_cast<uint8_t>(nal[0]);
+    char prefix[2];
+    prefix[0] = static_cast<char>((nal_header & 0xE0) | kNalFuA);
+    std::string_view rest = nal.substr(1);
+    const size_t chunk = _mtu - sizeof(prefix);
+    bool first = true;
+    while(!rest.empty())
+    {
+        const size_t n = std::min(chunk, rest.size());
+        const bool last = n == rest.size();
+        prefix[1] = static_cast<char>((first ? 0x80 : 0x00) | (last ? 0x40 : 0x00) | (nal_header & 0x1F));
+        out->push_back(makePacket(std::string_view(prefix, sizeof(prefix)), rest.substr(0, n), last && lastNal, timestamp));
+        rest.remove_prefix(n);
+        first = false;
+    }
+}
+
+SharedBuffer RtpPacketizer::makePacket(std::string_view prefix, std::string_view body, bool marker, uint32_t timestamp)
+{
+    const size_t rtp_len = kRtpHeaderSize + prefix.size() + body.size();
+    const size_t total = kInterleavedHeaderSize + rtp_len;
+    std::shared_ptr<std::string> packet = _pool ? _pool->acquire(total) : std::make_shared<std::string>();
+    packet->resize(kInterleavedHeaderSize + kRtpHeaderSize);
+
+    char *p = &(*packet)[0];
+    p[0] = '$';
+    p[1] = static_cast<char>(_defaultChannel);
+    PutBe16(p + 2, static_cast<uint16_t>(rtp_len));
+
+    RtpHeader header;
+    header.payloadType = _payloadType;
+    header.marker = marker;
+    header.seq = _seq++;
+    header.timestamp = timestamp;
+    header.ssrc = _ssrc;
+    WriteRtpHeader(p + kInterleavedHeaderSize, header);
+
+    packet->append(prefix.data(), prefix.size());
+    packet->append(body.data(), body.size());
+    return packet;
+}
+
+std::string RtpPacketizer::h264Fmtp() const
+{
+    std::string fmtp = "packetization-mode=1";
+    if(_sps.size() >= 4)
+    {
+        char profile[32];
+        std::snprintf(profile, sizeof(profile), ";profile-level-id=%02X%02X%02X",
+                      static_cast<uint8_t>(_sps[1]), static_cast<uint8_t>(_sps[2]), static_cast<uint8_t>(_sps[3]));
+        fmtp += profile;
+        fmtp += ";sprop-parameter-sets=";
+        fmtp += Base64Encode(_sps.data(), _sps.size());
+        if(!_pps.empty())
+        {
+            fmtp += ',';
+            fmtp += Base64Encode(_pps.data(), _pps.size());
+        }
+    }
+    return fmtp;
+}
+
+SharedBuffer RewriteInterleavedChannel(const SharedBuffer &packet, uint8_t channel, RtpPacketPool *pool)
+{
+    std::shared_ptr<std::string> copy = pool ? pool->acquire(packet->size()) : std::make_shared<std::string>();
+    copy->assign(*packet);
+    (*copy)[1] = static_cast<char>(channel);
+    return copy;
+}
+
+}   // kit_muduo::rtsp
@@ -0,0 +1,953 @@
+/**
+ * @file rtsp_server.cpp
+ * @brief RTSP 1.0(RFC 2326)服务端: 媒体源、会话与 RTP over TCP interleaved / UDP 扇出
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 05:40:52
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/rtsp/rtsp_server.h"
+#include "net/async_udp_datagram.h"
+#include "net/buffer.h"
+#include "net/event_loop.h"
+#include "net/net_log.h"
+#include "net/socket.h"
+#include "net/tcp_connection.h"
+#include "net/tcp_server.h"
+#include "net/http/http_context.h"
+#include "net/http/http_headers.h"
+#include "net/http/http_request.h"
+#include "net/http/http_util.h"
+#include "base/metrics.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace kit_muduo::rtsp {
+
+using http::HttpContext;
+using http::HttpRequest;
+using http::StateCode;
+using http::Version;
+using Method = HttpRequest::Method;
+
+namespace {
+
+constexpr std::string_view kPublicMethods =
+    "OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, TEARDOWN, GET_PARAMETER, SET_PARAMETER";
+
+uint32_t RandomU32()
+{
+    static thread_local std::mt19937 s_rng(std::random_device{}());
+    return s_rng();
+}
+
+bool ParsePortPair(std::string_view value, uint16_t *first, uint16_t *second)
+{
+    const std::string str(value);
+    char *end = nullptr;
+    const unsigned long a = std::strtoul(str.c_str(), &end, 10);
+    if(end == str.c_str() || a > 65535)
+    {
+        return false;
+    }
+    unsigned long b = a + 1;
+    if('-' == *end)
+    {
+        const char *begin = end + 1;
+        b = std::strtoul(begin, &end, 10);
+        if(end == begin || b > 65535)
+        {
+            return false;
+        }
+    }
+    *first = static_cast<uint16_t>(a);
+    *second = static_cast<uint16_t>(b);
+    return true;
+}
+
+/// @brief 解析单个 Transport 候选
+bool ParseTransportSpec(std::string_view spec, RtspTransport *transport)
+{
+    RtspTransport result;
+    bool first = true;
+    bool tcp = false;
+    bool has_channel = false;
+    bool has_port = false;
+    while(!spec.empty())
+    {
+        const size_t semi = spec.find(';');
+        const std::string_view item = http::TrimHttpSpace(spec.substr(0, semi));
+        spec = std::string_view::npos == semi ? std::string_view() : spec.substr(semi + 1);
+        if(first)
+        {
+            first = false;
+            if(http::HeaderNameEquals(item, "RTP/AVP/TCP"))
+            {
+                tcp = true;
+            }
+            else if(!http::HeaderNameEquals(item, "RTP/AVP") && !http::HeaderNameEquals(item, "RTP/AVP/UDP"))
+            {
+                return false;
+            }
+            continue;
+        }
+
+        const size_t eq = item.find('=');
+        const std::string_view key = item.substr(0, eq);
+        const std::string_view value = std::string_view::npos == eq ? std::string_view() : item.substr(eq + 1);
+        if(http::HeaderNameEquals(key, "multicast"))
+        {
+            return false;
+        }
+        if(http::HeaderNameEquals(key, "interleaved"))
+        {
+            uint16_t rtp = 0;
+            uint16_t rtcp = 0;
+            if(!ParsePortPair(value, &rtp, &rtcp) || rtp > 255 || rtcp > 255)
+            {
+                return false;
+            }
+            result.rtpChannel = static_cast<uint8_t>(rtp);
+            result.rtcpChannel = static_cast<uint8_t>(rtcp);
+            has_channel = true;
+        }
+        else if(http::HeaderNameEquals(key, "client_port"))
+        {
+            if(!ParsePortPair(value, &result.clientRtpPort, &result.clientRtcpPort))
+            {
+                return false;
+            }
+            has_port = true;
+        }
+    }
+
+    if(tcp)
+    {
+        // 未指定通道号时按 RFC 2326 由服务端选择，这里沿用 0-1
+        result.mode = RtspTransport::kTcpInterleaved;
+        if(!has_channel)
+        {
+            result.rtpChannel = 0;
+            result.rtcpChannel = 1;
+        }
+    }
+    else if(has_port)
+    {
+        result.mode = RtspTransport::kUdpUnicast;
+    }
+    else
+    {
+        return false;
+    }
+    *transport = result;
+    return true;
+}
+
+std::string FormatRtpInfoUrl(std::string_view url, size_t track)
+{
+    std::string base(url);
+    if(!base.empty() && '/' != base.back())
+    {
+        base += '/';
+    }
+    base += "trackID=" + std::to_string(track);
+    return base;
+}
+
+}
+
+bool ParseRtspTransport(std::string_view value, RtspTransport *transport)
+{
+    while(!value.empty())
+    {
+        const size_t comma = value.find(',');
+        if(ParseTransportSpec(http::TrimHttpSpace(value.substr(0, comma)), transport))
+        {
+            return true;
+        }
+        if(std::string_view::npos == comma)
+        {
+            break;
+        }
+        value.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+void SplitRtspUrl(std::string_view url, std::string *path, int *track)
+{
+    constexpr std::string_view kScheme = "rtsp://";
+    if(url.size() >= kScheme.size() && http::HeaderNameEquals(url.substr(0, kScheme.size()), kScheme))
+    {
+        url.remove_prefix(kScheme.size());
+        const size_t slash = url.find('/');
+        url = std::string_view::npos == slash ? std::string_view() : url.substr(slash);
+    }
+
+    *track = -1;
+    const size_t pos = url.rfind("trackID=");
+    if(std::string_view::npos != pos)
+    {
+        *track = std::atoi(std::string(url.substr(pos + 8)).c_str());
+        url = url.substr(0, pos);
+    }
+    while(url.size() > 1 && '/' == url.back())
+    {
+        url.remove_suffix(1);
+    }
+    path->assign(url.empty() ? std::string_view("/") : url);
+}
+
+/********************************** RtspMediaSource **********************************/
+
+RtspMediaSource::RtspMediaSource(const std::string &path, size_t mtu)
+    :_path(path)
+    ,_mtu(mtu)
+{
+}
+
+size_t RtspMediaSource::addTrack(TrackConfig config)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const size_t index = _tracks.size();
+    const RtpPacketizer::Codec codec = http::HeaderNameEquals(config.encoding, "H264")
+        ? RtpPacketizer::Codec::kH264 : RtpPacketizer::Codec::kGeneric;
+    Track track;
+    track.packetizer = std::make_unique<RtpPacketizer>(codec, config.payloadType, RandomU32(),
+                                                       static_cast<uint8_t>(index * 2), _mtu, &_pool);
+    track.config = std::move(config);
+    _tracks.push_back(std::move(track));
+    return index;
+}
+
+size_t RtspMediaSource::trackCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _tracks.size();
+}
+
+std::string RtspMediaSource::sdp(const std::string &localIp) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::string sdp;
+    sdp.reserve(512);
+    sdp += "v=0\r\n";
+    sdp += "o=- " + std::to_string(reinterpret_cast<uintptr_t>(this) & 0xFFFFFFFF) + " 1 IN IP4 " + localIp + "\r\n";
+    sdp += "s=" + _path + "\r\n";
+    sdp += "c=IN IP4 0.0.0.0\r\n";
+    sdp += "t=0 0\r\n";
+    sdp += "a=range:npt=0-\r\n";
+    sdp += "a=control:*\r\n";
+    for(size_t i = 0; i < _tracks.size(); ++i)
+    {
+        const TrackConfig &config = _tracks[i].config;
+        const std::string pt = std::to_string(config.payloadType);
+        sdp += "m=" + config.media + " 0 RTP/AVP " + pt + "\r\n";
+        sdp += "a=rtpmap:" + pt + " " + config.encoding + "/" + std::to_string(config.clockRate);
+        if(config.channels > 0)
+        {
+            sdp += "/" + std::to_string(config.channels);
+        }
+        sdp += "\r\n";
+        std::string fmtp = config.fmtp;
+        if(fmtp.empty() && RtpPacketizer::Codec::kH264 == _tracks[i].packetizer->codec())
+        {
+            fmtp = _tracks[i].packetizer->h264Fmtp();
+        }
+        if(!fmtp.empty())
+        {
+            sdp += "a=fmtp:" + pt + " " + fmtp + "\r\n";
+        }
+        sdp += "a=control:trackID=" + std::to_string(i) + "\r\n";
+    }
+    return sdp;
+}
+
+size_t RtspMediaSource::pushFrame(size_t track, const char *data, size_t len, uint32_t timestamp)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(track >= _tracks.size() || 0 == len)
+    {
+        return 0;
+    }
+
+    RtpPacketizer &packetizer = *_tracks[track].packetizer;
+    _packets.clear();
+    const bool keyframe = packetizer.packetize(data, len, timestamp, &_packets);
+    const bool video = RtpPacketizer::Codec::kH264 == packetizer.codec();
+    ++_frames;
+    _packetCount += _packets.size();
+    for(auto &entry : _channelPackets)
+    {
+        entry.second.clear();
+    }
+
+    size_t delivered = 0;
+    for(auto it = _sinks.begin(); it != _sinks.end();)
+    {
+        Sink &sink = it->second;
+        TcpConnectionPtr conn = sink.conn.lock();
+        if(!conn || !conn->connected())
+        {
+            it = _sinks.erase(it);
+            continue;
+        }
+        ++it;
+
+        if(track >= sink.tracks.size() || !sink.tracks[track].enabled)
+        {
+            continue;
+        }
+        SinkTrack &sink_track = sink.tracks[track];
+        if(video && sink_track.waitKey && !keyframe)
+        {
+            ++_dropped;
+            continue;
+        }
+        sink_track.waitKey = false;
+
+        if(sink.udp)
+        {
+            for(const SharedBuffer &packet : _packets)
+            {
+                sink.udp->send(packet, kInterleavedHeaderSize, sink_track.peer);
+            }
+        }
+        else
+        {
+            if(conn->pendingBytes() > sink.maxPendingBytes)
+            {
+                ++_dropped;
+                sink_track.waitKey = video;
+                RTSP_F_DEBUG("viewer [%s] backlog %zu bytes, drop frame of track %zu\n",
+                             conn->name().c_str(), conn->pendingBytes(), track);
+                continue;
+            }
+            if(sink_track.channel == packetizer.defaultChannel())
+            {
+                conn->send(_packets);
+            }
+            else
+            {
+                std::vector<SharedBuffer> &variant = _channelPackets[sink_track.channel];
+                if(variant.empty())
+                {
+                    variant.reserve(_packets.size());
+                    for(const SharedBuffer &packet : _packets)
+                    {
+                        variant.push_back(RewriteInterleavedChannel(packet, sink_track.channel, &_pool));
+                    }
+                    _copied += variant.size();
+                }
+                conn->send(variant);
+            }
+        }
+        ++delivered;
+    }
+    _delivered += delivered;
+
+    // 释放本帧的引用，缓冲在各连接发送完后回到池中
+    _packets.clear();
+    for(auto &entry : _channelPackets)
+    {
+        entry.second.clear();
+    }
+    return delivered;
+}
+
+RtspMediaSource::Stats RtspMediaSource::stats() const
+{
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        stats.viewers = _sinks.size();
+        stats.frames = _frames;
+        stats.packets = _packetCount;
+        stats.delivered = _delivered;
+        stats.dropped = _dropped;
+        stats.copiedPackets = _copied;
+    }
+    stats.pool = _pool.stats();
+    return stats;
+}
+
+void RtspMediaSource::attach(const void *key, Sink sink, const std::string &preamble)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    TcpConnectionPtr conn = sink.conn.lock();
+    if(!preamble.empty() && conn)
+    {
+        conn->send(preamble);
+    }
+    _sinks[key] = std::move(sink);
+}
+
+void RtspMediaSource::detach(const void *key)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _sinks.erase(key);
+}
+
+void RtspMediaSource::rtpInfo(size_t track, uint16_t *seq, uint32_t *rtptime) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(track < _tracks.size())
+    {
+        *seq = _tracks[track].packetizer->nextSeq();
+        *rtptime = _tracks[track].packetizer->lastTimestamp();
+    }
+}
+
+uint32_t RtspMediaSource::ssrc(size_t track) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return track < _tracks.size() ? _tracks[track].packetizer->ssrc() : 0;
+}
+
+/********************************** RtspServer **********************************/
+
+RtspServer::RtspServer(EventLoop *loop, const InetAddress &addr, const std::string &name)
+    :RtspServer(loop, addr, name, Config())
+{
+}
+
+RtspServer::RtspServer(EventLoop *loop, const InetAddress &addr, const std::string &name, Config config)
+    :_loop(loop)
+    ,_config(config)
+    ,_server(std::make_unique<TcpServer>(loop, addr, name, TcpServer::KReusePort))
+    ,_sessionSeed((static_cast<uint64_t>(RandomU32()) << 32) | RandomU32())
+{
+    _server->setConnectionCallback(std::bind(&RtspServer::onConnection, this, std::placeholders::_1));
+    _server->setMessageCallback(std::bind(&RtspServer::onMessage, this, std::placeholders::_1,
+                                          std::placeholders::_2, std::placeholders::_3));
+}
+
+RtspServer::~RtspServer()
+{
+    if(_expireTimer)
+    {
+        _loop->cancel(_expireTimer);
+    }
+    if(_rtpSocket)
+    {
+        _rtpSocket->forceClose();
+    }
+    if(_rtcpSocket)
+    {
+        _rtcpSocket->forceClose();
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for(auto &entry : _sessions)
+    {
+        if(auto source = entry.second->source.lock())
+        {
+            source->detach(entry.second.get());
+        }
+    }
+}
+
+void RtspServer::setThreadNum(int32_t num)
+{
+    _server->setThreadNum(num);
+}
+
+void RtspServer::start()
+{
+    if(_config.rtpPort > 0 && !_rtpSocket)
+    {
+        _rtpSocket = AsyncUdpDatagram::Create(_loop, "rtsp-rtp", Socket::CreateUdpIpv4());
+        _rtcpSocket = AsyncUdpDatagram::Create(_loop, "rtsp-rtcp", Socket::CreateUdpIpv4());
+        _rtcpSocket->setMessageCallback([this](const std::vector<uint8_t>&, const InetAddress &peer, TimeStamp) {
+            onRtcp(peer);
+        });
+        AsyncUdpDatagramPtr rtp = _rtpSocket;
+        AsyncUdpDatagramPtr rtcp = _rtcpSocket;
+        const uint16_t port = _config.rtpPort;
+        _loop->runInLoop([rtp, rtcp, port]() {
+            if(!rtp->bind(InetAddress(port)) || !rtcp->bind(InetAddress(static_cast<uint16_t>(port + 1))))
+            {
+                RTSP_F_ERROR("bind rtp/rtcp port %u-%u failed\n", port, port + 1);
+                return;
+            }
+            rtp->start();
+            rtcp->start();
+        });
+    }
+
+    if(!_expireTimer && _config.sessionTimeoutMs > 0)
+    {
+        const int64_t interval = std::max<int64_t>(_config.sessionTimeoutMs / 4, 100);
+        _expireTimer = _loop->runEvery(interval, std::bind(&RtspServer::expireSessions, this));
+    }
+    _server->start();
+}
+
+void RtspServer::addSource(const RtspMediaSource::Ptr &source)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _sources[source->path()] = source;
+}
+
+void RtspServer::removeSource(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _sources.erase(path);
+}
+
+RtspServer::Stats RtspServer::stats() const
+{
+    Stats stats;
+    stats.requests = _requests.load();
+    stats.expired = _expired.load();
+    std::lock_guard<std::mutex> lock(_mutex);
+    stats.sessions = _sessions.size();
+    for(const auto &entry : _sessions)
+    {
+        stats.playing += entry.second->playing ? 1 : 0;
+    }
+    return stats;
+}
+
+void RtspServer::onConnection(const TcpConnectionPtr &conn)
+{
+    if(conn->connected())
+    {
+        auto ctx = std::make_shared<ConnContext>();
+        ctx->http = std::make_shared<HttpContext>();
+        conn->setContext(ctx);
+        return;
+    }
+
+    auto ctx = std::static_pointer_cast<ConnContext>(conn->getContext());
+    if(ctx)
+    {
+        for(const std::string &id : ctx->sessions)
+        {
+            destroySession(id);
+        }
+        ctx->sessions.clear();
+    }
+}
+
+void RtspServer::onMessage(const TcpConnectionPtr &conn, Buffer *buf, TimeStamp receiveTime)
+{
+    auto ctx = std::static_pointer_cast<ConnContext>(conn->getContext());
+    if(!ctx)
+    {
+        return;
+    }
+
+    // 控制连接上有数据即视为其会话仍然活跃
+    if(!ctx->sessions.empty())
+    {
+        const int64_t now = metrics::NowNs();
+        std::lock_guard<std::mutex> lock(_mutex);
+        for(const std::string &id : ctx->sessions)
+        {
+            auto it = _sessions.find(id);
+            if(it != _sessions.end())
+            {
+                it->second->lastActiveNs = now;
+            }
+        }
+    }
+
+    while(buf->readableBytes() > 0)
+    {
+        // 请求之间可能夹着客户端的 interleaved RTCP
+        if(HttpContext::kExpectRequestLine == ctx->http->state() && '$' == buf->peek()[0])
+        {
+            if(buf->readableBytes() < kInterleavedHeaderSize)
+            {
+                break;
+            }
+            const unsigned char *p = reinterpret_cast<const unsigned char*>(buf->peek());
+            const size_t frame_len = kInterleavedHeaderSize + ((static_cast<size_t>(p[2]) << 8) | p[3]);
+            if(buf->readableBytes() < frame_len)
+            {
+                break;
+            }
+            buf->reset(frame_len);
+            continue;
+        }
+
+        if(!ctx->http->parseRequest(*buf, receiveTime))
+        {
+            RTSP_F_WARN("rtsp request parse error from [%s]\n", conn->peerAddr().toIpPort().c_str());
+            SendReply(conn, StateCode::k400BadRequest, "0");
+            conn->shutdown();
+            return;
+        }
+        if(!ctx->http->gotAll())
+        {
+            break;
+        }
+
+        HttpRequest &request = *ctx->http->request();
+        ++_requests;
+        handleRequest(conn, *ctx, request);
+        ctx->http = std::make_shared<HttpContext>();
+    }
+}
+
+void RtspServer::onRtcp(const InetAddress &peer)
+{
+    const int64_t now = metrics::NowNs();
+    std::lock_guard<std::mutex> lock(_mutex);
+    for(auto &entry : _sessions)
+    {
+        for(const InetAddress &rtcp : entry.second->rtcpPeers)
+        {
+            if(rtcp.toIpPort() == peer.toIpPort())
+            {
+                entry.second->lastActiveNs = now;
+            }
+        }
+    }
+}
+
+void RtspServer::handleRequest(const TcpConnectionPtr &conn, ConnContext &ctx, HttpRequest &request)
+{
+    const std::string cseq(request.header("CSeq"));
+    const int32_t method = request.method()();
+    RTSP_F_DEBUG("[%s] %s %s CSeq %s\n", conn->peerAddr().toIpPort().c_str(),
+                 request.method().toString(), request.path().c_str(), cseq.c_str());
+
+    if(Version::kRtsp10 != request.version()())
+    {
+        SendReply(conn, StateCode::k400BadRequest, cseq);
+        return;
+    }
+
+    switch(method)
+    {
+        case Method::kOptions:
+            SendReply(conn, StateCode::k200Ok, cseq, "Public: " + std::string(kPublicMethods) + "\r\n");
+            return;
+        case Method::kDescribe:
+            handleDescribe(conn, request, cseq);
+            return;
+        case Method::kSetup:
+            handleSetup(conn, ctx, request, cseq);
+            return;
+        case Method::kPlay:
+        case Method::kPause:
+        case Method::kTeardown:
+        case Method::kGetParameter:
+        case Method::kSetParameter:
+            break;
+        default:
+            SendReply(conn, StateCode::k405MethodNotAllowed, cseq, "Allow: " + std::string(kPublicMethods) + "\r\n");
+            return;
+    }
+
+    // 以下方法都要求已有会话，GET_PARAMETER 不带会话时作为连接级保活
+    const std::string_view session_header = request.header("Session");
+    const std::string_view session_id = session_header.substr(0, session_header.find(';'));
+    if(session_id.empty() && (Method::kGetParameter == method || Method::kSetParameter == method))
+    {
+        SendReply(conn, StateCode::k200Ok, cseq);
+        return;
+    }
+    SessionPtr session = findSession(http::TrimHttpSpace(session_id));
+    if(!session)
+    {
+        SendReply(conn, StateCode::k454SessionNotFound, cseq);
+        return;
+    }
+    const std::string session_line = "Session: " + session->id + "\r\n";
+
+    switch(method)
+    {
+        case Method::kPlay:
+            handlePlay(conn, session, request, cseq);
+            break;
+        case Method::kPause:
+            stopPlaying(session);
+            SendReply(conn, StateCode::k200Ok, cseq, session_line);
+            break;
+        case Method::kTeardown:
+            destroySession(session->id);
+            SendReply(conn, StateCode::k200Ok, cseq, session_line);
+            break;
+        default:
+            SendReply(conn, StateCode::k200Ok, cseq, session_line);
+            break;
+    }
+}
+
+void RtspServer::handleDescribe(const TcpConnectionPtr &conn, HttpRequest &request, const std::string &cseq)
+{
+    std::string path;
+    int track = -1;
+    SplitRtspUrl(request.path(), &path, &track);
+    RtspMediaSource::Ptr source = findSource(path);
+    if(!source)
+    {
+        SendReply(conn, StateCode::k404NotFound, cseq);
+        return;
+    }
+
+    std::string base = request.path();
+    if(base.empty() || '/' != base.back())
+    {
+        base += '/';
+    }
+    SendReply(conn, StateCode::k200Ok, cseq,
+              "Content-Base: " + base + "\r\nContent-Type: application/sdp\r\n",
+              source->sdp(conn->localAddr().toIp()));
+}
+
+void RtspServer::handleSetup(const TcpConnectionPtr &conn, ConnContext &ctx, HttpRequest &request, const std::string &cseq)
+{
+    std::string path;
+    int track = -1;
+    SplitRtspUrl(request.path(), &path, &track);
+    RtspMediaSource::Ptr source = findSource(path);
+    if(!source)
+    {
+        SendReply(conn, StateCode::k404NotFound, cseq);
+        return;
+    }
+    // 单轨道源允许不带 trackID
+    if(track < 0 && 1 == source->trackCount())
+    {
+        track = 0;
+    }
+    if(track < 0 || static_cast<size_t>(track) >= source->trackCount())
+    {
+        SendReply(conn, StateCode::k404NotFound, cseq);
+        return;
+    }
+
+    RtspTransport transport;
+    if(!ParseRtspTransport(request.header("Transport"), &transport)
+        || (RtspTransport::kUdpUnicast == transport.mode && !_rtpSocket))
+    {
+        SendReply(conn, StateCode::k461UnsupportedTransport, cseq);
+        return;
+    }
+
+    const std::string_view session_header = request.header("Session");
+    const std::string_view session_id = http::TrimHttpSpace(session_header.substr(0, session_header.find(';')));
+    SessionPtr session;
+    if(!session_id.empty())
+    {
+        session = findSession(session_id);
+        if(!session)
+        {
+            SendReply(conn, StateCode::k454SessionNotFound, cseq);
+            return;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(session)
+        {
+            // 同一会话的轨道必须属于同一媒体源，传输方式也不能混用
+            if(session->path != path || session->udp != (RtspTransport::kUdpUnicast == transport.mode))
+            {
+                SendReply(conn, StateCode::k459AggregateOperationNotAllowed, cseq);
+                return;
+            }
+            if(session->playing)
+            {
+                SendReply(conn, StateCode::k455MethodNotValid, cseq);
+                return;
+            }
+        }
+        else
+        {
+            session = std::make_shared<Session>();
+            session->id = newSessionId();
+            session->path = path;
+            session->source = source;
+            session->conn = conn;
+            session->udp = RtspTransport::kUdpUnicast == transport.mode;
+            _sessions[session->id] = session;
+            ctx.sessions.push_back(session->id);
+        }
+        session->lastActiveNs = metrics::NowNs();
+        if(session->tracks.size() < source->trackCount())
+        {
+            session->tracks.resize(source->trackCount());
+        }
+
+        RtspMediaSource::SinkTrack &sink_track = session->tracks[track];
+        sink_track.enabled = true;
+        sink_track.waitKey = true;
+        sink_track.channel = transport.rtpChannel;
+        if(session->udp)
+        {
+            const std::string ip = conn->peerAddr().toIp();
+            sink_track.peer = InetAddress(transport.clientRtpPort, ip);
+            session->rtcpPeers.push_back(InetAddress(transport.clientRtcpPort, ip));
+        }
+    }
+
+    char ssrc[16];
+    std::snprintf(ssrc, sizeof(ssrc), "%08X", source->ssrc(track));
+    std::string headers = "Transport: ";
+    if(RtspTransport::kTcpInterleaved == transport.mode)
+    {
+        headers += "RTP/AVP/TCP;unicast;interleaved=" + std::to_string(transport.rtpChannel) + "-"
+            + std::to_string(transport.rtcpChannel);
+    }
+    else
+    {
+        headers += "RTP/AVP;unicast;client_port=" + std::to_string(transport.clientRtpPort) + "-"
+            + std::to_string(transport.clientRtcpPort) + ";server_port=" + std::to_string(_config.rtpPort)
+            + "-" + std::to_string(_config.rtpPort + 1);
+    }
+    headers += ";ssrc=" + std::string(ssrc) + "\r\n";
+    headers += "Session: " + session->id + ";timeout="
+        + std::to_string(std::max<int64_t>(1, (_config.sessionTimeoutMs + 999) / 1000)) + "\r\n";
+    SendReply(conn, StateCode::k200Ok, cseq, headers);
+}
+
+void RtspServer::handlePlay(const TcpConnectionPtr &conn, const SessionPtr &session, HttpRequest &request, const std::string &cseq)
+{
+    RtspMediaSource::Ptr source = session->source.lock();
+    if(!source)
+    {
+        SendReply(conn, StateCode::k404NotFound, cseq);
+        return;
+    }
+
+    RtspMediaSource::Sink sink;
+    std::string rtp_info;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        sink.conn = session->conn;
+        sink.udp = session->udp ? _rtpSocket : nullptr;
+        sink.tracks = session->tracks;
+        sink.maxPendingBytes = _config.maxPendingBytes;
+        session->playing = true;
+    }
+
+    const std::string base = request.path().substr(0, request.path().rfind("trackID="));
+    for(size_t i = 0; i < sink.tracks.size(); ++i)
+    {
+        if(!sink.tracks[i].enabled)
+        {
+            continue;
+        }
+        uint16_t seq = 0;
+        uint32_t rtptime = 0;
+        source->rtpInfo(i, &seq, &rtptime);
+        rtp_info += rtp_info.empty() ? "RTP-Info: " : ",";
+        rtp_info += "url=" + FormatRtpInfoUrl(base, i) + ";seq=" + std::to_string(seq)
+            + ";rtptime=" + std::to_string(rtptime);
+    }
+
+    // 响应在媒体源锁内发出，保证先于第一个 RTP 包
+    source->attach(session.get(), std::move(sink), RenderReply(StateCode::k200Ok, cseq,
+        "Session: " + session->id + "\r\nRange: npt=0.000-\r\n" + (rtp_info.empty() ? "" : rtp_info + "\r\n")));
+}
+
+std::string RtspServer::RenderReply(int32_t code, const std::string &cseq,
+                                    const std::string &headers, const std::string &body)
+{
+    std::string out;
+    out.reserve(128 + headers.size() + body.size());
+    out += http::HttpStatusLine(Version::kRtsp10, code);
+    out += "CSeq: " + (cseq.empty() ? std::string("0") : cseq) + "\r\n";
+    out += "Server: kit_muduo\r\n";
+    out += headers;
+    if(!body.empty())
+    {
+        out += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    out += "\r\n";
+    out += body;
+    return out;
+}
+
+void RtspServer::SendReply(const TcpConnectionPtr &conn, int32_t code, const std::string &cseq,
+                           const std::string &headers, const std::string &body)
+{
+    conn->send(RenderReply(code, cseq, headers, body));
+}
+
+RtspMediaSource::Ptr RtspServer::findSource(const std::string &path) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _sources.find(path);
+    return it == _sources.end() ? nullptr : it->second;
+}
+
+RtspServer::SessionPtr RtspServer::findSession(std::string_view id) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _sessions.find(std::string(id));
+    return it == _sessions.end() ? nullptr : it->second;
+}
+
+std::string RtspServer::newSessionId()
+{
+    // splitmix64，种子随机，结果不可由相邻会话推出
+    uint64_t z = (_sessionSeed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    char id[20];
+    std::snprintf(id, sizeof(id), "%016llX", static_cast<unsigned long long>(z));
+    return id;
+}
+
+void RtspServer::destroySession(const std::string &id)
+{
+    SessionPtr session;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _sessions.find(id);
+        if(it == _sessions.end())
+        {
+            return;
+        }
+        session = it->second;
+        _sessions.erase(it);
+    }
+    stopPlaying(session);
+    RTSP_F_DEBUG("session [%s] destroyed\n", id.c_str());
+}
+
+void RtspServer::stopPlaying(const SessionPtr &session)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        session->playing = false;
+    }
+    if(auto source = session->source.lock())
+    {
+        source->detach(session.get());
+    }
+}
+
+void RtspServer::expireSessions()
+{
+    const int64_t deadline = metrics::NowNs() - _config.sessionTimeoutMs * 1000000;
+    std::vector<std::string> expired;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for(const auto &entry : _sessions)
+        {
+            if(entry.second->lastActiveNs < deadline)
+            {
+                expired.push_back(entry.first);
+            }
+        }
+    }
+    for(const std::string &id : expired)
+    {
+        RTSP_F_INFO("session [%s] timeout\n", id.c_str());
+        destroySession(id);
+        ++_expired;
+    }
+}
+
+}   // kit_muduo::rtsp
@@ -0,0 +1,101 @@
+/**
+ * @file shared_file.cpp
+ * @brief 可在多个连接间共享的只读文件描述符
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 10:12:40
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/shared_file.h"
+#include "net/net_log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace kit_muduo {
+
+SharedFile::Ptr SharedFile::Open(const std::string &path, int32_t *err)
+{
+    int32_t fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        if(err) *err = errno;
+        TCP_F_DEBUG("SharedFile open %s error! %d:%s\n", path.c_str(), errno, strerror(errno));
+        return nullptr;
+    }
+
+    // 以打开后的fstat为准，避免stat与open之间文件被替换
+    struct stat st;
+    if(::fstat(fd, &st) < 0)
+    {
+        if(err) *err = errno;
+        ::close(fd);
+        return nullptr;
+    }
+    if(!S_ISREG(st.st_mode))
+    {
+        if(err) *err = S_ISDIR(st.st_mode) ? EISDIR : EINVAL;
+        ::close(fd);
+        return nullptr;
+    }
+
+    int64_t mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return Ptr(new SharedFile(fd, static_cast<uint64_t>(st.st_size), mtime_ns,
+                              static_cast<uint64_t>(st.st_ino), static_cast<uint64_t>(st.st_dev)));
+}
+
+SharedFile::Ptr SharedFile::Snapshot(const SharedFile &src, int32_t *err)
+{
+    int32_t fd = ::memfd_create("kit_shared_file", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if(fd < 0)
+    {
+        if(err) *err = errno;
+        TCP_F_WARN("SharedFile memfd_create error! %d:%s\n", errno, strerror(errno));
+        return nullptr;
+    }
+
+    // 内核内复制，不经过用户态缓冲
+    off_t offset = 0;
+    while(static_cast<uint64_t>(offset) < src._size)
+    {
+        ssize_t n = ::sendfile(fd, src._fd, &offset, src._size - static_cast<uint64_t>(offset));
+        if(n <= 0)
+        {
+            if(n < 0 && EINTR == errno)
+            {
+                continue;
+            }
+            if(err) *err = n < 0 ? errno : EIO;
+            TCP_F_WARN("SharedFile snapshot copy failed at %lld/%lu\n", static_cast<long long>(offset), src._size);
+            ::close(fd);
+            return nullptr;
+        }
+    }
+    // 封存后大小与内容都不能再改，发送中不会遇到截断
+    ::fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+    return Ptr(new SharedFile(fd, src._size, src._mtimeNs, src._inode, src._device));
+}
+
+SharedFile::SharedFile(int32_t fd, uint64_t size, int64_t mtimeNs, uint64_t inode, uint64_t device)
+    :_fd(fd)
+    ,_size(size)
+    ,_mtimeNs(mtimeNs)
+    ,_inode(inode)
+    ,_device(device)
+{
+}
+
+SharedFile::~SharedFile()
+{
+    if(_fd >= 0)
+    {
+        ::close(_fd);
+    }
+}
+
+}   // kit_muduo
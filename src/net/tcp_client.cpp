@@ -0,0 +1,146 @@
+/**
+ * @file tcp_client.cpp
+ * @brief TcpClient对外调用类: 主动连接并产出普通 TcpConnection，支持断线重连
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 19:48:51
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/tcp_client.h"
+#include "net/event_loop.h"
+#include "net/inet_address.h"
+#include "net/net_log.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+namespace kit_muduo {
+
+namespace {
+
+void DefaultConnectionCallback(const TcpConnectionPtr &conn)
+{
+    CLI_F_DEBUG("%s -> %s is %s\n", conn->localAddr().toIpPort().c_str(), conn->peerAddr().toIpPort().c_str(),
+                conn->connected() ? "UP" : "DOWN");
+}
+
+/// @brief TcpClient 已销毁时连接的关闭回调
+void DetachedCloseCallback(const TcpConnectionPtr &conn)
+{
+    conn->getLoop()->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+}
+
+}
+
+TcpClient::TcpClient(EventLoop *loop, const InetAddress &serverAddr, const std::string &name)
+    :_loop(loop)
+    ,_connector(std::make_shared<Connector>(loop, serverAddr))
+    ,_name(name)
+    ,_connectionCallback(DefaultConnectionCallback)
+    ,_messageCallback(nullptr)
+    ,_writeCompleteCallback(nullptr)
+    ,_retry(false)
+    ,_connect(false)
+    ,_nextConnId(1)
+{
+    // 连接器只在 stop 之前回调，析构时先 stop，这里捕获 this 是安全的
+    _connector->setRetry(true);
+    _connector->setNewConnectionCallback(std::bind(&TcpClient::newConnection, this, std::placeholders::_1));
+    CLI_F_DEBUG("TcpClient[%s] create, connector %p\n", _name.c_str(), _connector.get());
+}
+
+TcpClient::~TcpClient()
+{
+    CLI_F_DEBUG("TcpClient[%s] destroy\n", _name.c_str());
+    TcpConnectionPtr conn;
+    {
+    std::lock_guard<std::mutex> lock(_mutex);
+    conn = _connection;
+    }
+
+    _connector->stop();
+    if(conn)
+    {
+        // 连接可能比 TcpClient 活得久，关闭回调不能再回到 this
+        _loop->runInLoop([conn]() {
+            conn->setCloseCallback(DetachedCloseCallback);
+        });
+        conn->forceClose();
+    }
+}
+
+void TcpClient::connect()
+{
+    CLI_F_INFO("TcpClient[%s] connecting to %s\n", _name.c_str(), _connector->serverAddr().toIpPort().c_str());
+    _connect = true;
+    _connector->start();
+}
+
+void TcpClient::disconnect()
+{
+    _connect = false;
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_connection)
+    {
+        _connection->shutdown();
+    }
+}
+
+void TcpClient::stop()
+{
+    _connect = false;
+    _connector->stop();
+}
+
+TcpConnectionPtr TcpClient::connection() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _connection;
+}
+
+void TcpClient::newConnection(int32_t sockfd)
+{
+    const InetAddress peer_addr = InetAddress::GetPeerAddr(sockfd);
+    std::string conn_name = _name;
+    conn_name += "-";
+    conn_name += peer_addr.toIpPort();
+    conn_name += "#";
+    conn_name += std::to_string(_nextConnId);
+    ++_nextConnId;
+
+    int32_t on = 1;
+    ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    auto conn = std::make_shared<TcpConnection>(_loop, conn_name, sockfd, peer_addr, InetAddress::GetLocalAddr(sockfd));
+    conn->setConnectionCallback(_connectionCallback);
+    conn->setMessageCallback(_messageCallback);
+    conn->setWriteCompleteCallback(_writeCompleteCallback);
+    conn->setCloseCallback(std::bind(&TcpClient::removeConnection, this, std::placeholders::_1));
+    {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _connection = conn;
+    }
+    CLI_F_INFO("==> new conn: fd[%d], name[%s]\n", sockfd, conn_name.c_str());
+    conn->connectEstablished();
+}
+
+void TcpClient::removeConnection(const TcpConnectionPtr &conn)
+{
+    {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_connection == conn)
+    {
+        _connection.reset();
+    }
+    }
+    _loop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+
+    if(_retry && _connect)
+    {
+        CLI_F_INFO("TcpClient[%s] reconnecting to %s\n", _name.c_str(), _connector->serverAddr().toIpPort().c_str());
+        _connector->restart();
+    }
+}
+
+}   // kit_muduo
@@ -11,13 +11,39 @@
 #include "net/channel.h"
 #include "net/net_log.h"
 #include "net/event_loop.h"
+#include "base/metrics.h"
 #include <unistd.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <algorithm>
 
 
 namespace kit_muduo {
 
 #define HIGH_WATER_MARK_MAX     (64*1024*1024) // 64M
 
+/// @brief 单次 writev 合并的最多分段数
+static constexpr int32_t kMaxIovecs = 16;
+
+namespace {
+
+struct TcpConnectionMetrics
+{
+    metrics::Counter &bytes_read;
+    metrics::Counter &bytes_written;
+};
+
+TcpConnectionMetrics& ConnMetrics()
+{
+    static TcpConnectionMetrics s_metrics{
+        metrics::MetricsRegistry::Instance().counter("kit_tcp_read_bytes_total", "Bytes read from TCP connections"),
+        metrics::MetricsRegistry::Instance().counter("kit_tcp_written_bytes_total", "Bytes written to TCP connections"),
+    };
+    return s_metrics;
+}
+
+}
+
 TcpConnection::TcpConnection(EventLoop *loop, const std::string &name, int32_t sockfd, const InetAddress &peerAddr, const InetAddress &localAddr)
     :_subLoop(loop)
     ,_name(name)
@@ -44,6 +70,30 @@ TcpConnection::TcpConnection(EventLoop *loop, const std::string &name, int32_t s
 }
 
 
+TcpConnection::Stats TcpConnection::stats() const
+{
+    Stats stats;
+    stats.name = _name;
+    stats.fd = _socket->fd();
+    stats.peer = _peerAddr.toIpPort();
+    switch(_state)
+    {
+        case kConnecting: stats.state = "connecting"; break;
+        case kConnected: stats.state = "connected"; break;
+        case kDisconnecting: stats.state = "disconnecting"; break;
+        default: stats.state = "disconnected"; break;
+    }
+    stats.bytes_read = _bytesRead;
+    stats.bytes_written = _bytesWritten;
+    stats.input_bytes = _inputBuffer.readableBytes();
+    stats.input_capacity = _inputBuffer.prependBytes() + _inputBuffer.readableBytes() + _inputBuffer.writableBytes();
+    stats.output_bytes = _outputBuffer.readableBytes();
+    stats.output_capacity = _outputBuffer.prependBytes() + _outputBuffer.readableBytes() + _outputBuffer.writableBytes();
+    stats.output_segments = _outputSegments.size();
+    stats.pending_bytes = _pendingBytes.load();
+    return stats;
+}
+
 TcpConnection::~TcpConnection()
 {
     CONN_F_DEBUG("~TcpConnection: name[%s], fd[%d][%s], state[%d]\n", _name.c_str(), _socket->fd(), _peerAddr.toIpPort().c_str(), _state.load());
@@ -54,10 +104,59 @@ void TcpConnection::send(const std::string& buf)
     send(std::move(std::vector<char>(buf.begin(), buf.end())));
 }
 
+void TcpConnection::send(std::string&& buf)
+{
+    // 空数据不入队，否则排在文件/共享分段后会留下 remain 为0的分段
+    if(buf.empty())
+    {
+        return;
+    }
+    if(kConnected == _state)
+    {
+        _pendingBytes += buf.size();
+        if(_subLoop->isInLoopThread())
+        {
+            sendInLoop(buf.data(), buf.size());
+        }
+        else
+        {
+            TCP_F_DEBUG("TcpConnection::send queue fd[%d][%s] \n", fd(), _peerAddr.toIpPort().c_str());
+
+            _subLoop->queueInLoop([buf = std::move(buf), this_ptr = shared_from_this()](){
+                this_ptr->sendInLoop(buf.data(), buf.size());
+            });
+        }
+    }
+    else
+    {
+        TCP_F_INFO("fd[%d][%s] has closed! \n", fd(), _peerAddr.toIpPort().c_str());
+    }
+}
+
+void TcpConnection::send(const void *data, size_t len)
+{
+    if(0 == len)
+    {
+        return;
+    }
+    if(kConnected == _state && _subLoop->isInLoopThread())
+    {
+        _pendingBytes += len;
+        sendInLoop(data, len);
+        return;
+    }
+    send(std::string(static_cast<const char*>(data), len));
+}
+
 void TcpConnection::send(const std::vector<char>& buf)
 {
+    if(buf.empty())
+    {
+        return;
+    }
     if(kConnected == _state)
     {
+        _pendingBytes += buf.size();
         if(_subLoop->isInLoopThread())
         {
             sendInLoop(buf.data(), buf.size());
@@ -79,6 +178,101 @@ void TcpConnection::send(const std::vector<char>& buf)
     }
 }
 
+void TcpConnection::send(const std::vector<SharedBuffer> &bufs)
+{
+    if(kConnected == _state)
+    {
+        size_t total = 0;
+        for(auto &buf : bufs)
+        {
+            total += buf ? buf->size() : 0;
+        }
+        if(0 == total)
+        {
+            return;
+        }
+        _pendingBytes += total;
+        if(_subLoop->isInLoopThread())
+        {
+            sendSharedInLoop(bufs, total);
+        }
+        else
+        {
+            TCP_F_DEBUG("TcpConnection::send shared queue fd[%d][%s] \n", fd(), _peerAddr.toIpPort().c_str());
+
+            _subLoop->queueInLoop([bufs, total, this_ptr = shared_from_this()](){
+                this_ptr->sendSharedInLoop(bufs, total);
+            });
+        }
+    }
+    else
+    {
+        TCP_F_INFO("fd[%d][%s] has closed! \n", fd(), _peerAddr.toIpPort().c_str());
+    }
+}
+
+void TcpConnection::sendFile(const SharedFilePtr &file, off_t offset, size_t len)
+{
+    if(kConnected == _state)
+    {
+        _pendingBytes += len;
+        if(_subLoop->isInLoopThread())
+        {
+            sendFileInLoop(file, offset, len);
+        }
+        else
+        {
+            TCP_F_DEBUG("TcpConnection::sendFile queue fd[%d][%s] \n", fd(), _peerAddr.toIpPort().c_str());
+
+            _subLoop->queueInLoop([file, offset, len, this_ptr = shared_from_this()](){
+                this_ptr->sendFileInLoop(file, offset, len);
+            });
+        }
+    }
+    else
+    {
+        TCP_F_INFO("fd[%d][%s] has closed! \n", fd(), _peerAddr.toIpPort().c_str());
+    }
+}
+
+bool TcpConnection::waitForDrain(size_t lowMark, int32_t timeoutMs)
+{
+    if(_subLoop->isInLoopThread())
+    {
+        // IO线程阻塞会导致永远无法写出，直接返回当前状态
+        CONN_F_WARN("waitForDrain called in loop thread! fd[%d][%s]\n", fd(), _name.c_str());
+        return kConnected == _state && pendingBytes() <= lowMark;
+    }
+
+    auto pred = [this, lowMark]() {
+        return kConnected != _state || _pendingBytes.load() <= lowMark;
+    };
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    ++_drainWaiters;
+    bool drained = true;
+    if(timeoutMs < 0)
+    {
+        _drainCond.wait(lock, pred);
+    }
+    else
+    {
+        drained = _drainCond.wait_for(lock, std::chrono::milliseconds(timeoutMs), pred);
+    }
+    --_drainWaiters;
+
+    return drained && kConnected == _state;
+}
+
+void TcpConnection::notifyDrain()
+{
+    if(_drainWaiters.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _drainCond.notify_all();
+    }
+}
+
 void TcpConnection::shutdown()
 {
     if(kConnected == _state)
@@ -101,6 +295,53 @@ void TcpConnection::shutdown()
     }
 }
 
+void TcpConnection::startRead()
+{
+    _subLoop->runInLoop(std::bind(&TcpConnection::startReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::stopRead()
+{
+    _subLoop->runInLoop(std::bind(&TcpConnection::stopReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::startReadInLoop()
+{
+    if(kConnected == _state && !_channel->isReading())
+    {
+        _channel->enableReading();
+        _reading = true;
+    }
+}
+
+void TcpConnection::stopReadInLoop()
+{
+    // 连接关闭后 Channel 已移出 Poller，不能再 update
+    if((kConnected == _state || kDisconnecting == _state) && _channel->isReading())
+    {
+        _channel->disableReading();
+        _reading = false;
+    }
+}
+
+void TcpConnection::forceClose()
+{
+    if(kConnected == _state || kDisconnecting == _state)
+    {
+        _state = kDisconnecting;
+        _subLoop->queueInLoop(std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+    }
+}
+
+void TcpConnection::forceCloseInLoop()
+{
+    if(kConnected == _state || kDisconnecting == _state)
+    {
+        TCP_F_DEBUG("TcpConnection::forceCloseInLoop fd[%d][%s] \n", fd(), _peerAddr.toIpPort().c_str());
+        handleClose();
+    }
+}
+
 void TcpConnection::connectEstablished()
 {
     _state = kConnected;
@@ -120,6 +361,7 @@ void TcpConnection::connectDestroyed()
         _channel->disableAll();
         _connectionCallback(shared_from_this());
     }
+    runCloseHooks();
     // 注意 TcpConnection析构时不能销毁Channel
     // 得在这里手动销毁
     _channel->remove();
@@ -143,6 +385,9 @@ void TcpConnection::handleRead(TimeStamp receiveTime)
         return;
     }
 
+    ConnMetrics().bytes_read.inc(n);
+    _bytesRead += n;
+
     // 用户传入的Message处理
     // 存在改进点：业务处理异步出Loop线程
     _messageCallback(shared_from_this(), &_inputBuffer, receiveTime);
@@ -153,17 +398,31 @@ void TcpConnection::handleWrite()
     int fd = _socket->fd();
     if(_channel->isWriting())
     {
-        int32_t saved_errno;
-        ssize_t n = _outputBuffer.writeFd(fd, &saved_errno);
-        if(n < 0)
+        if(_outputBuffer.readableBytes() > 0)
+        {
+            int32_t saved_errno;
+            ssize_t n = _outputBuffer.writeFd(fd, &saved_errno);
+            if(n < 0)
+            {
+                errno = saved_errno;
+                CONN_F_ERROR("fd[%d] handleRead error! %d:%s \n", fd, errno, strerror(errno));
+                return;
+            }
+
+            _outputBuffer.reset(n);
+            _pendingBytes -= n;
+            ConnMetrics().bytes_written.inc(n);
+            _bytesWritten += n;
+            notifyDrain();
+        }
+
+        // 缓冲区写完后再按顺序写分段
+        if(_outputBuffer.readableBytes() > 0 || !writeSegments())
         {
-            errno = saved_errno;
-            CONN_F_ERROR("fd[%d] handleRead error! %d:%s \n", fd, errno, strerror(errno));
             return;
         }
 
-        _outputBuffer.reset(n);
-        if(0 == _outputBuffer.readableBytes())
+        if(_outputSegments.empty())
         {
             // 写完了 停止写入
             _channel->disableWriting();
@@ -188,6 +447,113 @@ void TcpConnection::handleWrite()
     }
 }
 
+bool TcpConnection::writeSegments()
+{
+    int32_t fd = _socket->fd();
+    while(!_outputSegments.empty())
+    {
+        OutputSegment &seg = _outputSegments.front();
+        if(0 == seg.remain)
+        {
+            // 空分段不会产生进度，留在队首会让循环空转
+            _outputSegments.pop_front();
+            continue;
+        }
+        ssize_t n = 0;
+        if(seg.file)
+        {
+            n = ::sendfile(fd, seg.file->fd(), &seg.offset, seg.remain);
+        }
+        else
+        {
+            // 相邻的内存分段合并为一次 writev
+            struct iovec iov[kMaxIovecs];
+            int32_t count = 0;
+            for(auto it = _outputSegments.begin();
+                it != _outputSegments.end() && !it->file && count < kMaxIovecs; ++it)
+            {
+                iov[count].iov_base = const_cast<char*>(it->bytes()) + it->offset;
+                iov[count].iov_len = it->remain;
+                ++count;
+            }
+            n = ::writev(fd, iov, count);
+        }
+
+        if(n < 0)
+        {
+            if(EAGAIN == errno || EWOULDBLOCK == errno)
+            {
+                return true;
+            }
+            if(EINTR == errno)
+            {
+                continue;
+            }
+            CONN_F_ERROR("writeSegments error! name[%s], fd[%d], %d:%s\n", _name.c_str(), fd, errno, strerror(errno));
+            dropSegments();
+            return false;
+        }
+        else if(0 == n && seg.file)
+        {
+            // 文件在发送期间被截断，响应长度已无法兑现，只能关闭写端
+            CONN_F_ERROR("sendfile got EOF, file truncated? name[%s], fd[%d], remain[%lu]\n", _name.c_str(), fd, seg.remain);
+            dropSegments();
+            _socket->shutdownWrite();
+            return false;
+        }
+        else if(0 == n)
+        {
+            // writev 没有进度，等下一次可写事件
+            return true;
+        }
+
+        _pendingBytes -= n;
+        ConnMetrics().bytes_written.inc(n);
+        _bytesWritten += n;
+        notifyDrain();
+        if(seg.file)
+        {
+            seg.remain -= n;
+            if(0 == seg.remain)
+            {
+                _outputSegments.pop_front();
+            }
+            continue;
+        }
+
+        size_t left = static_cast<size_t>(n);
+        while(left > 0)
+        {
+            OutputSegment &front = _outputSegments.front();
+            size_t take = std::min(left, front.remain);
+            front.offset += take;
+            front.remain -= take;
+            left -= take;
+            if(0 == front.remain)
+            {
+                _outputSegments.pop_front();
+            }
+        }
+    }
+    return true;
+}
+
+void TcpConnection::dropSegments()
+{
+    size_t dropped = 0;
+    for(auto &seg : _outputSegments)
+    {
+        dropped += seg.remain;
+    }
+    _outputSegments.clear();
+    _pendingBytes -= dropped;
+    if(_channel->isWriting() && 0 == _outputBuffer.readableBytes())
+    {
+        _channel->disableWriting();
+    }
+    notifyDrain();
+}
+
 void TcpConnection::handleError()
 {
     int32_t opt;
@@ -215,8 +581,43 @@ void TcpConnection::handleClose()
     if(_connectionCallback)
         _connectionCallback(shared_from_this());
 
+    runCloseHooks();
+
     if(_closeCallback)
         _closeCallback(shared_from_this());
+
+    notifyDrain();
+}
+
+void TcpConnection::addCloseHook(CloseCb hook)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(!_closeHooksDone)
+        {
+            _closeHooks.push_back(std::move(hook));
+            return;
+        }
+    }
+    hook(shared_from_this());
+}
+
+void TcpConnection::runCloseHooks()
+{
+    std::vector<CloseCb> hooks;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(_closeHooksDone)
+        {
+            return;
+        }
+        _closeHooksDone = true;
+        hooks.swap(_closeHooks);
+    }
+    for(auto &hook : hooks)
+    {
+        hook(shared_from_this());
+    }
 }
 
 /*注意这里是用户调用send, 而非EventLoop事件触发进行send*/
@@ -229,10 +630,26 @@ void TcpConnection::sendInLoop(const void* message, size_t len)
 
     if(kConnected != _state)
     {
-        CONN_F_ERROR("sendInLoop state error! fd[%d][%s], fd[%d], state[%d]\n", fd, _name.c_str(), _state.load());
+        CONN_F_ERROR("sendInLoop state error! fd[%d][%s], state[%d]\n", fd, _name.c_str(), _state.load());
+        _pendingBytes -= len;
+        return;
+    }
+    if(0 == len)
+    {
         return;
     }
 
+    // 前面还有文件区间未发完，数据排到分段队列末尾以保证顺序
+    if(!_outputSegments.empty())
+    {
+        if(_outputSegments.back().file || _outputSegments.back().shared)
+        {
+            _outputSegments.emplace_back();
+        }
+        _outputSegments.back().data.append(static_cast<const char*>(message), len);
+        _outputSegments.back().remain += len;
+        return;
+    }
 
     // TODO: 一旦这里涉及多线程就是需要加锁
     // 最外层用户调的send 此时不应该在监听写事件，否则说明上一次都没发送完成
@@ -250,12 +667,17 @@ void TcpConnection::sendInLoop(const void* message, size_t len)
             if(EAGAIN != errno
                 && EWOULDBLOCK != errno)
             {
+                _pendingBytes -= len;
                 return;
             }
 
         }
         else
         {
+            _pendingBytes -= n;
+            ConnMetrics().bytes_written.inc(n);
+            _bytesWritten += n;
+            notifyDrain();
             remain = len - n;
             // 一次性全部写完的情况
             if(0 == remain && _writeCompleteCallback)
@@ -273,6 +695,14 @@ void TcpConnection::sendInLoop(const void* message, size_t len)
     {
         CONN_F_INFO("TcpConnection::sendInLoop remain[%d] fd[%d][%s], state[%d]\n", remain, fd, _name.c_str() ,_state.load());
 
+        size_t old_len = _outputBuffer.readableBytes();
+        if(old_len + remain >= _highWaterMark
+            && old_len < _highWaterMark
+            && _highWaterMarkCallback)
+        {
+            _subLoop->queueInLoop(std::bind(_highWaterMarkCallback, shared_from_this(), old_len + remain));
+        }
+
         _outputBuffer.ensureWritableBytes(remain);
         _outputBuffer.append((char*)message + n, remain);
         if(!_channel->isWriting())
@@ -290,6 +720,129 @@ void TcpConnection::sendInLoop(const std::vector<char> message)
     sendInLoop(message.data(), message.size());
 }
 
+void TcpConnection::sendFileInLoop(const SharedFilePtr &file, off_t offset, size_t len)
+{
+    if(kConnected != _state)
+    {
+        CONN_F_ERROR("sendFileInLoop state error! fd[%d][%s], state[%d]\n", fd(), _name.c_str(), _state.load());
+        _pendingBytes -= len;
+        return;
+    }
+    if(0 == len)
+    {
+        return;
+    }
+
+    OutputSegment seg;
+    seg.file = file;
+    seg.offset = offset;
+    seg.remain = len;
+    _outputSegments.push_back(std::move(seg));
+
+    if(!_channel->isWriting() && 0 == _outputBuffer.readableBytes())
+    {
+        // 没有积压，直接尝试写出
+        if(!writeSegments())
+        {
+            return;
+        }
+        if(_outputSegments.empty())
+        {
+            if(_writeCompleteCallback)
+            {
+                _subLoop->queueInLoop(std::bind(_writeCompleteCallback, shared_from_this()));
+            }
+            return;
+        }
+    }
+
+    if(!_channel->isWriting())
+    {
+        _channel->enableWriting();
+    }
+}
+
+void TcpConnection::sendSharedInLoop(const std::vector<SharedBuffer> &bufs, size_t total)
+{
+    int32_t fd = _socket->fd();
+    if(kConnected != _state)
+    {
+        CONN_F_ERROR("sendSharedInLoop state error! fd[%d][%s], state[%d]\n", fd, _name.c_str(), _state.load());
+        _pendingBytes -= total;
+        return;
+    }
+
+    size_t written = 0;
+    if(!_channel->isWriting() && 0 == _outputBuffer.readableBytes() && _outputSegments.empty())
+    {
+        struct iovec iov[kMaxIovecs];
+        int32_t count = 0;
+        for(auto &buf : bufs)
+        {
+            if(!buf || buf->empty())
+            {
+                continue;
+            }
+            if(count == kMaxIovecs)
+            {
+                break;
+            }
+            iov[count].iov_base = const_cast<char*>(buf->data());
+            iov[count].iov_len = buf->size();
+            ++count;
+        }
+
+        ssize_t n = count > 0 ? ::writev(fd, iov, count) : 0;
+        if(n < 0)
+        {
+            if(EAGAIN != errno && EWOULDBLOCK != errno)
+            {
+                CONN_F_ERROR("sendSharedInLoop writev error! name[%s], fd[%d], %d:%s\n", _name.c_str(), fd, errno, strerror(errno));
+                _pendingBytes -= total;
+                return;
+            }
+            n = 0;
+        }
+        written = static_cast<size_t>(n);
+        _pendingBytes -= written;
+        ConnMetrics().bytes_written.inc(n);
+        _bytesWritten += n;
+        notifyDrain();
+    }
+
+    // 未写完的部分引用原缓冲排队
+    size_t skip = written;
+    for(auto &buf : bufs)
+    {
+        size_t size = buf ? buf->size() : 0;
+        if(skip >= size)
+        {
+            skip -= size;
+            continue;
+        }
+        OutputSegment seg;
+        seg.shared = buf;
+        seg.offset = static_cast<off_t>(skip);
+        seg.remain = size - skip;
+        _outputSegments.push_back(std::move(seg));
+        skip = 0;
+    }
+
+    if(_outputSegments.empty() && 0 == _outputBuffer.readableBytes())
+    {
+        if(_writeCompleteCallback)
+        {
+            _subLoop->queueInLoop(std::bind(_writeCompleteCallback, shared_from_this()));
+        }
+        return;
+    }
+
+    if(!_channel->isWriting())
+    {
+        _channel->enableWriting();
+    }
+}
+
 void TcpConnection::shutdownInLoop()
 {
     _state = kDisconnecting;
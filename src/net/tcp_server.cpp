@@ -12,10 +12,32 @@
 #include "net/acceptor.h"
 #include "base/event_loop_thread.h"
 #include "base/event_loop_thread_pool.h"
+#include "base/metrics.h"
+
+#include <algorithm>
 
 
 namespace kit_muduo {
 
+namespace {
+
+struct TcpServerMetrics
+{
+    metrics::Counter &accepted;
+    metrics::Gauge &active;
+};
+
+TcpServerMetrics& ServerMetrics()
+{
+    static TcpServerMetrics s_metrics{
+        metrics::MetricsRegistry::Instance().counter("kit_tcp_accepted_total", "Accepted TCP connections"),
+        metrics::MetricsRegistry::Instance().gauge("kit_tcp_active_connections", "TCP connections owned by servers"),
+    };
+    return s_metrics;
+}
+
+}
+
 static inline EventLoop* CheckNullLoop(EventLoop *p)
 {
     if(!p)
@@ -62,6 +84,7 @@ TcpServer::~TcpServer()
         it.second.reset();
         TCP_F_DEBUG("~TcpServer::connectDestroyed fd[%d][%s] \n", conn->fd(), conn->peerAddr().toIpPort().c_str());
         // 析构时再关闭一下 防止套接字泄漏
+        ServerMetrics().active.dec();
         conn->getLoop()->runInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
     }
 
@@ -112,10 +135,66 @@ void TcpServer::delConnection(const std::string &name)
     std::lock_guard<std::mutex> lock(_connectMapMtx);
     auto it = _connections.find(name);
     if(it != _connections.end())
+    {
         _connections.erase(it);
+        ServerMetrics().active.dec();
+    }
 }
 
 
+void TcpServer::collectSnapshot(SnapshotCb done, bool withConnections)
+{
+    std::vector<EventLoop*> loops = _threadPool->getAllLoops();
+    if(std::find(loops.begin(), loops.end(), _baseLoop) == loops.end())
+    {
+        loops.insert(loops.begin(), _baseLoop);
+    }
+
+    // 连接按所属循环分组，只在表锁内复制指针
+    std::vector<std::vector<TcpConnectionPtr>> groups(loops.size());
+    if(withConnections)
+    {
+        std::lock_guard<std::mutex> lock(_connectMapMtx);
+        for(auto &it : _connections)
+        {
+            auto pos = std::find(loops.begin(), loops.end(), it.second->getLoop());
+            if(pos != loops.end())
+            {
+                groups[pos - loops.begin()].push_back(it.second);
+            }
+        }
+    }
+
+    struct Gather {
+        std::vector<LoopSnapshot> results;
+        std::atomic<size_t> remaining{0};
+        SnapshotCb done;
+    };
+    auto gather = std::make_shared<Gather>();
+    gather->results.resize(loops.size());
+    gather->remaining = loops.size();
+    gather->done = std::move(done);
+
+    for(size_t i = 0; i < loops.size(); ++i)
+    {
+        EventLoop *loop = loops[i];
+        loop->runInLoop([gather, i, loop, conns = std::move(groups[i])]() {
+            LoopSnapshot &slot = gather->results[i];
+            slot.loop = loop->stats();
+            slot.connections.reserve(conns.size());
+            for(auto &conn : conns)
+            {
+                slot.connections.push_back(conn->stats());
+            }
+            // 各循环只写自己的槽位，最后一个完成者负责回调
+            if(1 == gather->remaining.fetch_sub(1, std::memory_order_acq_rel))
+            {
+                gather->done(std::move(gather->results));
+            }
+        });
+    }
+}
+
 void TcpServer::newConnection(int32_t sockfd, const InetAddress& peerAddr)
 {
     std::string conn_name = _name;
@@ -140,6 +219,8 @@ void TcpServer::newConnection(int32_t sockfd, const InetAddress& peerAddr)
     // 此时TcpConnection ==> state=1 Connecting
 
     addConnection(conn_name, connPtr);
+    ServerMetrics().accepted.inc();
+    ServerMetrics().active.inc();
 
     // 设置当前连接状态+触发用户回调
     // 1. 这样写避免 TcpConnection::getChannel这种接口出现，借助std::bind绑定器也能实现执行成员函数效果
@@ -16,20 +16,39 @@
 #include "net/event_loop.h"
 #include "net/http/http_util.h"
 #include "base/event_loop_thread.h"
+#include "net/http/http_stream_writer.h"
+#include "net/http/http_body_sink.h"
+#include "net/http/http_servlet.h"
+#include "net/http/http_asset_cache.h"
+#include "net/http/http_scanner.h"
+#include "net/http/http_header_cache.h"
+#include "net/http/http_compressor.h"
+#include "net/http/http_sse.h"
+#include "net/tcp_connection.h"
+#include "base/metrics.h"
+#include "base/trace.h"
 
 #include <gtest/gtest.h>
+#include "nlohmann/json.hpp"
 
 #include <arpa/inet.h>
+#include <atomic>
 #include <chrono>
 #include <cerrno>
 #include <cstring>
+#include <functional>
 #include <future>
+#include <mutex>
 #include <netinet/in.h>
+#include <set>
 #include <string>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <thread>
 #include <unistd.h>
+#include <vector>
+#include <zlib.h>
 
 using namespace kit_muduo;
 using namespace kit_muduo::http;
@@ -183,6 +202,31 @@ std::string ReadAll(int32_t fd)
     return data;
 }
 
+/// @brief 解压 gzip/zlib 数据，失败返回空
+std::string Inflate(const std::string &data)
+{
+    z_stream stream{};
+    // +32 自动识别 gzip 与 zlib 头
+    if(Z_OK != inflateInit2(&stream, MAX_WBITS + 32))
+    {
+        return "";
+    }
+    std::string out;
+    char chunk[4096];
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    int ret = Z_OK;
+    while(Z_OK == ret)
+    {
+        stream.next_out = reinterpret_cast<Bytef*>(chunk);
+        stream.avail_out = sizeof(chunk);
+        ret = inflate(&stream, Z_NO_FLUSH);
+        out.append(chunk, sizeof(chunk) - stream.avail_out);
+    }
+    inflateEnd(&stream);
+    return Z_STREAM_END == ret ? out : "";
+}
+
 class HttpServerTestGuard
 {
 public:
@@ -439,6 +483,394 @@ TEST(TestHttpReq, create_data)
 }
 
 
+TEST(TestHttpHeaders, case_insensitive_inline_and_heap)
+{
+    EXPECT_EQ(LookupHttpHeaderId("content-LENGTH"), HttpHeaderId::kContentLength);
+    EXPECT_EQ(LookupHttpHeaderId("X-Trace"), HttpHeaderId::kUnknown);
+    EXPECT_EQ(HttpHeaderName(HttpHeaderId::kETag), "ETag");
+
+    HttpHeaders headers;
+    headers.set("content-type", "text/plain");
+    headers.set("Content-Type", "application/json");
+    headers.set("X-Trace", "1");
+    headers.set("x-trace", "2");
+    EXPECT_EQ(headers.size(), 2u);
+    EXPECT_EQ(headers.get(HttpHeaderId::kContentType), "application/json");
+    EXPECT_EQ(headers.get("CONTENT-TYPE"), "application/json");
+    EXPECT_EQ(headers.get("X-TRACE"), "2");
+    // 保留首次写入的大小写
+    EXPECT_EQ(headers.find("Content-Type")->first, "content-type");
+
+    headers.combine("Accept", "text/html");
+    headers.combine("accept", "*/*");
+    EXPECT_EQ(headers.get(HttpHeaderId::kAccept), "text/html, */*");
+
+    headers.add("Set-Cookie", "a=1");
+    headers.add("Set-Cookie", "b=2");
+    EXPECT_EQ(headers.get("set-cookie"), "a=1");
+
+    // 超出内联容量后转为堆存储，索引仍然有效
+    for(int i = 0; i < 40; ++i)
+    {
+        headers.add("X-Extra-" + std::to_string(i), std::to_string(i));
+    }
+    headers.set(HttpHeaderId::kHost, "kit.com");
+    EXPECT_EQ(headers.size(), 46u);
+    EXPECT_EQ(headers.get("x-extra-39"), "39");
+    EXPECT_EQ(headers.get(HttpHeaderId::kHost), "kit.com");
+    EXPECT_EQ(headers.get(HttpHeaderId::kContentType), "application/json");
+
+    EXPECT_EQ(headers.erase("SET-COOKIE"), 2u);
+    EXPECT_FALSE(headers.has("Set-Cookie"));
+    EXPECT_EQ(headers.get(HttpHeaderId::kHost), "kit.com");
+
+    HttpHeaders copied(headers);
+    HttpHeaders moved(std::move(headers));
+    EXPECT_TRUE(headers.empty());
+    EXPECT_EQ(copied.size(), moved.size());
+    EXPECT_EQ(moved.get(HttpHeaderId::kAccept), "text/html, */*");
+
+    HttpHeaders small;
+    small.set(HttpHeaderId::kConnection, "close");
+    HttpHeaders small_moved(std::move(small));
+    EXPECT_EQ(small_moved.get("connection"), "close");
+    EXPECT_FALSE(small.has(HttpHeaderId::kConnection));
+    copied = small_moved;
+    EXPECT_EQ(copied.size(), 1u);
+    EXPECT_EQ(copied.get(HttpHeaderId::kConnection), "close");
+}
+
+
+TEST(TestHttpReq, duplicate_and_split_headers_are_combined)
+{
+    const std::string raw =
+        "GET /a HTTP/1.1\r\n"
+        "Host: kit.com\r\n"
+        "accept: text/html\r\n"
+        "Accept: */*\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n";
+
+    // 按字节喂入，字段名/值都会被拆分到多次回调
+    HttpContext context;
+    Buffer buf;
+    bool ok = true;
+    for(char c : raw)
+    {
+        buf.append(&c, 1);
+        ok = context.parseRequest(buf, TimeStamp::Now()) && ok;
+    }
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(context.gotAll());
+    auto req = context.request();
+    EXPECT_EQ(req->header(HttpHeaderId::kHost), "kit.com");
+    EXPECT_EQ(req->header("ACCEPT"), "text/html, */*");
+    EXPECT_EQ(req->getHeader("content-length"), "0");
+    EXPECT_EQ(req->headers().size(), 3u);
+}
+
+
+TEST(TestHttpScanner, simd_levels_match_scalar)
+{
+    const HttpScanLevel best = DetectHttpScanLevel();
+    for(uint8_t l = 0; l <= static_cast<uint8_t>(best); ++l)
+    {
+        const HttpScanLevel level = static_cast<HttpScanLevel>(l);
+        ASSERT_TRUE(SetHttpScanLevel(level));
+        SCOPED_TRACE(HttpScanLevelName(level));
+
+        // 分隔符落在各个块内偏移及块边界上
+        for(size_t len = 0; len < 100; ++len)
+        {
+            for(size_t pos = 0; pos + 1 < len; ++pos)
+            {
+                std::string data(len, 'a');
+                data[pos] = '\r';
+                data[pos + 1] = '\n';
+                const char *b = data.data();
+                const char *e = b + data.size();
+                EXPECT_EQ(HttpFindCRLF(b, e), b + pos);
+                EXPECT_EQ(HttpFindByte(b, e, '\n'), b + pos + 1);
+                EXPECT_EQ(HttpFindEither(b, e, ':', '\n'), b + pos + 1);
+                EXPECT_EQ(HttpFindEither(b, e, '\r', ':'), b + pos);
+
+                // 单独的 '\r' 不算 CRLF
+                data[pos + 1] = 'x';
+                EXPECT_EQ(HttpFindCRLF(b, e), nullptr);
+            }
+            std::string data(len, 'a');
+            EXPECT_EQ(HttpFindByte(data.data(), data.data() + len, ' '), nullptr);
+            EXPECT_EQ(HttpFindEither(data.data(), data.data() + len, ' ', ':'), nullptr);
+        }
+    }
+    SetHttpScanLevel(best);
+    EXPECT_FALSE(SetHttpScanLevel(static_cast<HttpScanLevel>(static_cast<uint8_t>(HttpScanLevel::kAVX2) + 1)));
+}
+
+
+TEST(TestHttpReq, custom_parser_matches_llhttp)
+{
+    const std::string raw =
+        "POST /api/v1/items?id=7 HTTP/1.1\r\n"
+        "Host: kit.com\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+        "Accept:\t*/* \r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: 11\r\n"
+        "\r\n"
+        "hello world"
+        "GET /next HTTP/1.1\r\n"
+        "\r\n";
+
+    const HttpScanLevel best = DetectHttpScanLevel();
+    for(uint8_t l = 0; l <= static_cast<uint8_t>(best); ++l)
+    {
+        SetHttpScanLevel(static_cast<HttpScanLevel>(l));
+        SCOPED_TRACE(HttpScanLevelName(static_cast<HttpScanLevel>(l)));
+        for(size_t step : {raw.size(), size_t(1), size_t(7)})
+        {
+            HttpContext llhttp(HttpContext::kLLhttpParser);
+            HttpContext custom(HttpContext::kCustomParser);
+            Buffer llbuf;
+            Buffer cbuf;
+            for(size_t off = 0; off < raw.size() && !(llhttp.gotAll() && custom.gotAll()); off += step)
+            {
+                const size_t n = std::min(step, raw.size() - off);
+                if(!llhttp.gotAll())
+                {
+                    llbuf.append(raw.data() + off, n);
+                    ASSERT_TRUE(llhttp.parseRequest(llbuf, TimeStamp::Now()));
+                }
+                if(!custom.gotAll())
+                {
+                    cbuf.append(raw.data() + off, n);
+                    ASSERT_TRUE(custom.parseRequest(cbuf, TimeStamp::Now()));
+                }
+            }
+            ASSERT_TRUE(llhttp.gotAll());
+            ASSERT_TRUE(custom.gotAll());
+
+            auto a = llhttp.request();
+            auto b = custom.request();
+            EXPECT_EQ(a->method()(), b->method()());
+            EXPECT_EQ(a->path(), b->path());
+            EXPECT_EQ(a->version()(), b->version()());
+            EXPECT_EQ(a->headers().size(), b->headers().size());
+            for(const auto &entry : a->headers())
+            {
+                EXPECT_EQ(entry.second, b->header(entry.first)) << entry.first;
+            }
+            EXPECT_EQ(b->header(HttpHeaderId::kAccept), "*/*");
+            EXPECT_EQ(a->body().toString(), b->body().toString());
+            EXPECT_EQ(b->body().toString(), "hello world");
+        }
+    }
+    SetHttpScanLevel(best);
+}
+
+
+TEST(TestHttpReq, body_sink_receives_streamed_body)
+{
+    static const char header[] =
+    "POST /upload HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "Content-Length: 10\r\n"
+    "\r\n";
+
+    std::string received;
+    bool completed = false;
+    auto context = std::make_shared<HttpContext>();
+    context->setBodySinkResolver([&](const HttpContextPtr &ctx) -> HttpBodySink::Ptr {
+        EXPECT_EQ(ctx->request()->path(), "/upload");
+        return std::make_shared<FunctionBodySink>(
+            [&](const char *data, size_t len) { received.append(data, len); return true; },
+            [&]() { completed = true; return true; });
+    });
+
+    auto now = TimeStamp::Now();
+    EXPECT_TRUE(context->parseRequest(std::string(header) + "0123", now));
+    EXPECT_FALSE(context->gotAll());
+    EXPECT_EQ(received, "0123");
+    EXPECT_TRUE(context->parseRequest("456789", now));
+    EXPECT_TRUE(context->gotAll());
+
+    EXPECT_EQ(received, "0123456789");
+    EXPECT_TRUE(completed);
+    ASSERT_NE(context->bodySink(), nullptr);
+    EXPECT_EQ(context->bodySink()->receivedBytes(), 10u);
+    EXPECT_EQ(context->request()->body().size(), 0u);
+}
+
+TEST(TestHttpReq, body_sink_receives_chunked_body)
+{
+    static const char req[] =
+    "POST /upload HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n"
+    "5\r\nhello\r\n"
+    "6\r\n world\r\n"
+    "0\r\n\r\n";
+
+    std::string received;
+    auto context = std::make_shared<HttpContext>();
+    context->setBodySinkResolver([&](const HttpContextPtr &) -> HttpBodySink::Ptr {
+        return std::make_shared<FunctionBodySink>([&](const char *data, size_t len) {
+            received.append(data, len);
+            return true;
+        });
+    });
+
+    EXPECT_TRUE(context->parseRequest(req, TimeStamp::Now()));
+    EXPECT_TRUE(context->gotAll());
+    EXPECT_EQ(received, "hello world");
+    EXPECT_EQ(context->request()->body().size(), 0u);
+}
+
+TEST(TestHttpReq, body_sink_rejection_fails_parse)
+{
+    static const char req[] =
+    "POST /upload HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "Content-Length: 8\r\n"
+    "\r\n"
+    "12345678";
+
+    auto context = std::make_shared<HttpContext>();
+    context->setBodySinkResolver([](const HttpContextPtr &) -> HttpBodySink::Ptr {
+        return std::make_shared<FunctionBodySink>([](const char *, size_t) { return false; });
+    });
+
+    EXPECT_FALSE(context->parseRequest(req, TimeStamp::Now()));
+}
+
+TEST(TestHttpReq, file_body_sink_removes_partial_file_on_abort)
+{
+    const std::string path = "/tmp/kit_body_sink_abort_" + std::to_string(::getpid());
+    {
+        auto context = std::make_shared<HttpContext>();
+        context->setBodySinkResolver([&](const HttpContextPtr &) -> HttpBodySink::Ptr {
+            return std::make_shared<FileBodySink>(path);
+        });
+
+        EXPECT_TRUE(context->parseRequest("POST /upload HTTP/1.1\r\n"
+                                          "Content-Length: 100\r\n"
+                                          "\r\n"
+                                          "partial", TimeStamp::Now()));
+        struct stat st;
+        EXPECT_EQ(::stat(path.c_str(), &st), 0);
+    }
+
+    // 上下文析构时Body未完整，残留文件应被删除
+    struct stat st;
+    EXPECT_NE(::stat(path.c_str(), &st), 0);
+}
+
+TEST(TestHttpReq, multipart_body_sink_parses_streamed_form)
+{
+    const std::string body =
+    "--XyZ\r\n"
+    "Content-Disposition: form-data; name=\"title\"\r\n\r\n"
+    "hello\r\n"
+    "--XyZ\r\n"
+    "Content-Disposition: form-data; name=\"file\"; filename=\"a.txt\"\r\n"
+    "Content-Type: text/plain\r\n\r\n"
+    "0123456789abcdef\r\n"
+    "--XyZ--\r\n";
+    const std::string header =
+    "POST /upload HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "Content-Type: multipart/form-data; boundary=XyZ\r\n"
+    "Content-Length: " + std::to_string(body.size()) + "\r\n"
+    "\r\n";
+
+    std::shared_ptr<MultipartBodySink> sink;
+    auto context = std::make_shared<HttpContext>();
+    context->setBodySinkResolver([&](const HttpContextPtr &ctx) -> HttpBodySink::Ptr {
+        MultipartForm::Config config;
+        config.spillBytes = 8;
+        sink = std::make_shared<MultipartBodySink>(ctx->request()->header("Content-Type"), 0, config);
+        return sink;
+    });
+
+    // 分隔符跨两次读取
+    const size_t split = body.find("--XyZ--") + 3;
+    auto now = TimeStamp::Now();
+    EXPECT_TRUE(context->parseRequest(header + body.substr(0, split), now));
+    EXPECT_FALSE(context->gotAll());
+    EXPECT_TRUE(context->parseRequest(body.substr(split), now));
+    EXPECT_TRUE(context->gotAll());
+
+    ASSERT_NE(sink, nullptr);
+    EXPECT_TRUE(sink->completed());
+    const MultipartForm &form = sink->form();
+    ASSERT_EQ(form.parts().size(), 2u);
+    EXPECT_EQ(form.find("title")->data(), "hello");
+    const auto *file = form.find("file");
+    ASSERT_NE(file, nullptr);
+    EXPECT_EQ(file->filename, "a.txt");
+    EXPECT_TRUE(file->spilled());
+    EXPECT_EQ(file->size, 16u);
+}
+
+TEST(TestHttpReq, multipart_body_sink_rejects_truncated_form)
+{
+    const std::string body = "--XyZ\r\nContent-Disposition: form-data; name=\"a\"\r\n\r\nvalue\r\n";
+    auto context = std::make_shared<HttpContext>();
+    context->setBodySinkResolver([](const HttpContextPtr &ctx) -> HttpBodySink::Ptr {
+        return std::make_shared<MultipartBodySink>(ctx->request()->header("Content-Type"));
+    });
+
+    EXPECT_FALSE(context->parseRequest("POST /upload HTTP/1.1\r\n"
+                                       "Content-Type: multipart/form-data; boundary=XyZ\r\n"
+                                       "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                                       "\r\n" + body, TimeStamp::Now()));
+}
+
+namespace {
+
+struct BindOrder {
+    int64_t id{0};
+    std::string sku;
+    std::vector<int32_t> qty;
+};
+KIT_JSON_FIELDS(BindOrder, id, sku, qty)
+
+}
+
+TEST(TestHttpReq, bind_json_reflected_type_parses_body_directly)
+{
+    const std::string body = R"({"sku":"A-1","id":42,"qty":[1,2],"note":"ignored"})";
+    auto context = std::make_shared<HttpContext>();
+    ASSERT_TRUE(context->parseRequest("POST /orders HTTP/1.1\r\n"
+                                      "Content-Type: application/json\r\n"
+                                      "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                                      "\r\n" + body, TimeStamp::Now()));
+    ASSERT_TRUE(context->gotAll());
+
+    BindOrder order;
+    ASSERT_TRUE(context->Bind(&order));
+    EXPECT_EQ(order.id, 42);
+    EXPECT_EQ(order.sku, "A-1");
+    EXPECT_EQ(order.qty, (std::vector<int32_t>{1, 2}));
+
+    // 响应直接写入Body，与 nlohmann 解析结果一致
+    HttpResponse resp;
+    resp.setJsonBody(order);
+    EXPECT_EQ(resp.body().contentType()(), ContentType::kJsonType);
+    const auto doc = nlohmann::json::parse(resp.body().toString());
+    EXPECT_EQ(doc["id"].get<int64_t>(), 42);
+    EXPECT_EQ(doc["qty"].size(), 2u);
+
+    auto bad = std::make_shared<HttpContext>();
+    ASSERT_TRUE(bad->parseRequest("POST /orders HTTP/1.1\r\n"
+                                  "Content-Type: application/json\r\n"
+                                  "Content-Length: 9\r\n"
+                                  "\r\n"
+                                  "{\"id\":\"x\"}", TimeStamp::Now()));
+    EXPECT_FALSE(bad->Bind(&order));
+}
+
 void testHttpCb(TcpConnectionPtr conn, HttpContextPtr ctx)
 {
     auto req = ctx->request();
@@ -486,6 +918,88 @@ TEST(TestHttpResp, create_data)
 
 }
 
+TEST(TestHttpResp, pre_rendered_status_line_and_fragments)
+{
+    static_assert(HttpReasonPhrase(404) == "Not Found");
+    static_assert(HttpStatusLine(Version::kHttp11, 200) == "HTTP/1.1 200 OK\r\n");
+    EXPECT_TRUE(HttpStatusLine(Version::kHttp11, 299).empty());
+
+    HttpResponse resp;
+    resp.setVersion(Version::kHttp11);
+    resp.setStateCode(StateCode::k200Ok);
+    // 片段负责的头部即使调用方写过也只输出一次
+    resp.addHeader("Keep-Alive", "timeout=1");
+    resp.addHeader("Content-Length", "999");
+    resp.addHeader("X-Trace", "1");
+    resp.body().setContentType(ContentType::kJsonType);
+    resp.body().appendData(std::string("{}"));
+
+    const std::string str = resp.toString();
+    const std::string date_line(HttpDateCache::DateLine());
+    EXPECT_EQ(str.compare(0, 17, "HTTP/1.1 200 OK\r\n"), 0);
+    EXPECT_EQ(date_line.compare(0, 6, "Date: "), 0);
+    EXPECT_EQ(date_line.size(), 37u);
+    EXPECT_NE(str.find("\r\nDate: "), std::string::npos);
+    EXPECT_NE(str.find("Connection: keep-alive\r\nKeep-Alive: timeout=5, max=100\r\n"), std::string::npos);
+    EXPECT_EQ(str.find("timeout=1"), std::string::npos);
+    EXPECT_NE(str.find("Content-Type: application/json; charset=utf-8\r\n"), std::string::npos);
+    EXPECT_NE(str.find("Content-Length: 2\r\n"), std::string::npos);
+    EXPECT_EQ(str.find("999"), std::string::npos);
+    EXPECT_NE(str.find("X-Trace: 1\r\n"), std::string::npos);
+    EXPECT_EQ(str.substr(str.size() - 6), "\r\n\r\n{}");
+
+    // 调用方写的 Connection 原样保留，不再输出预拼片段
+    HttpResponse upgrade;
+    upgrade.setVersion(Version::kHttp11);
+    upgrade.setStateCode(StateCode::k101SwitchingProtocols);
+    upgrade.addHeader("Connection", "Upgrade");
+    upgrade.addHeader("Upgrade", "h2c");
+    const std::string upgrade_head = upgrade.headerString();
+    EXPECT_NE(upgrade_head.find("Connection: Upgrade\r\n"), std::string::npos) << upgrade_head;
+    EXPECT_EQ(upgrade_head.find("Connection: "), upgrade_head.rfind("Connection: "));
+    EXPECT_EQ(upgrade_head.find("keep-alive"), std::string::npos);
+    EXPECT_FALSE(upgrade.connectionClosed());
+
+    // 调用方要求关闭时按其值输出，并在发送后断开
+    HttpResponse closing;
+    closing.setVersion(Version::kHttp11);
+    closing.setStateCode(StateCode::k200Ok);
+    closing.addHeader("Connection", "close");
+    const std::string closing_head = closing.headerString();
+    EXPECT_NE(closing_head.find("Connection: close\r\n"), std::string::npos);
+    EXPECT_EQ(closing_head.find("Connection: "), closing_head.rfind("Connection: "));
+    EXPECT_EQ(closing_head.find("Keep-Alive"), std::string::npos);
+    EXPECT_TRUE(closing.connectionClosed());
+
+    // 表外状态码走拼接
+    HttpResponse other;
+    other.setVersion(Version::kHttp10);
+    other.setStateCode(299);
+    other.addHeader("Date", "Sun, 06 Nov 1994 08:49:37 GMT");
+    const std::string head = other.headerString();
+    EXPECT_EQ(head.compare(0, 15, "HTTP/1.0 299 \r\n"), 0);
+    EXPECT_NE(head.find("Connection: close\r\n"), std::string::npos);
+    EXPECT_EQ(head.find("Date: "), head.rfind("Date: "));
+
+    // 有定时器驱动时，刷新后各线程看到同一个新值
+    HttpDateCache::Retain();
+    const time_t next = ::time(nullptr) + 1;
+    const std::string next_line = "Date: " + FormatHttpDate(next) + "\r\n";
+    HttpDateCache::Refresh(next);
+    EXPECT_EQ(HttpDateCache::DateLine(), next_line);
+    std::string other_thread;
+    std::thread([&](){ other_thread = std::string(HttpDateCache::DateLine()); }).join();
+    EXPECT_EQ(other_thread, next_line);
+    EXPECT_EQ(*HttpDateCache::DateBlock(), next_line + "\r\n");
+    // 较早的秒晚到时不会让 Date 倒退
+    HttpDateCache::Refresh(784111777);
+    EXPECT_EQ(HttpDateCache::DateLine(), next_line);
+    HttpDateCache::Release();
+    // 没有驱动方时读取会自行按当前时间刷新，同样只前进
+    EXPECT_NE(HttpDateCache::DateLine(), "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n");
+}
+
+
 TEST(TestHttpResp, body_without_content_type_defaults_to_octet_stream)
 {
     static const char test_resp[] =
@@ -534,6 +1048,267 @@ TEST(TestHttpResp, binary_body_without_content_type_preserves_bytes)
     EXPECT_EQ(resp->body().contentType()(), ContentType::kOctetStream);
 }
 
+TEST(TestHttpAssetCache, budget_eviction_and_mtime_invalidation)
+{
+    char dir_tmpl[] = "/tmp/kit_asset_test_XXXXXX";
+    ASSERT_NE(::mkdtemp(dir_tmpl), nullptr);
+    const std::string root = dir_tmpl;
+    auto write_file = [](const std::string &path, const std::string &content) {
+        FILE *f = ::fopen(path.c_str(), "wb");
+        ASSERT_NE(f, nullptr);
+        ::fwrite(content.data(), 1, content.size(), f);
+        ::fclose(f);
+    };
+    const std::string a_path = root + "/a.css";
+    const std::string b_path = root + "/b.css";
+    const std::string big_path = root + "/big.js";
+    write_file(a_path, std::string(1000, 'a'));
+    write_file(b_path, std::string(1000, 'b'));
+    write_file(big_path, std::string(5000, 'c'));
+
+    HttpFileCache files(16, 0);
+    // 预算只够容纳一个条目(内容+两份头部)
+    HttpAssetCache cache(1800, 4096, 0);
+
+    ASSERT_EQ(cache.get(a_path), nullptr);
+    auto a_entry = files.get(a_path);
+    ASSERT_NE(a_entry, nullptr);
+    auto a = cache.put(a_path, *a_entry, "text/css; charset=utf-8");
+    ASSERT_NE(a, nullptr);
+    ASSERT_EQ(*a->body, std::string(1000, 'a'));
+    ASSERT_NE(a->header_keep_alive->find("Content-Length: 1000\r\n"), std::string::npos);
+    ASSERT_NE(a->header_keep_alive->find("ETag: " + a_entry->etag + "\r\n"), std::string::npos);
+    ASSERT_NE(a->header_close->find("Connection: close\r\n"), std::string::npos);
+    ASSERT_EQ(cache.get(a_path), a);
+
+    // 超过单个上限的文件不缓存
+    ASSERT_EQ(cache.put(big_path, *files.get(big_path), "text/javascript"), nullptr);
+
+    // 放入b超出预算，淘汰最久未用的a
+    ASSERT_NE(cache.put(b_path, *files.get(b_path), "text/css; charset=utf-8"), nullptr);
+    ASSERT_EQ(cache.get(a_path), nullptr);
+    ASSERT_NE(cache.get(b_path), nullptr);
+
+    auto stats = cache.stats();
+    ASSERT_EQ(stats.hits, 2u);
+    ASSERT_EQ(stats.misses, 2u);
+    ASSERT_EQ(stats.evictions, 1u);
+    ASSERT_EQ(stats.entries, 1u);
+    ASSERT_LE(stats.bytes, cache.budgetBytes());
+
+    // 文件变化后条目失效
+    write_file(b_path, std::string(1200, 'B'));
+    ASSERT_EQ(cache.get(b_path), nullptr);
+    stats = cache.stats();
+    ASSERT_EQ(stats.invalidations, 1u);
+    ASSERT_EQ(stats.entries, 0u);
+    ASSERT_EQ(stats.bytes, 0u);
+
+    ::unlink(a_path.c_str());
+    ::unlink(b_path.c_str());
+    ::unlink(big_path.c_str());
+    ::rmdir(root.c_str());
+}
+
+TEST(TestHttpFileCache, missing_paths_are_cached_until_revalidate)
+{
+    char dir_tmpl[] = "/tmp/kit_file_cache_test_XXXXXX";
+    ASSERT_NE(::mkdtemp(dir_tmpl), nullptr);
+    const std::string path = std::string(dir_tmpl) + "/app.js.gz";
+    auto create = [&path]() {
+        FILE *f = ::fopen(path.c_str(), "wb");
+        ASSERT_NE(f, nullptr);
+        ::fputs("gz", f);
+        ::fclose(f);
+    };
+
+    // 不存在的路径在校验间隔内直接命中负缓存，不再 open
+    HttpFileCache files(16, 60 * 1000);
+    int32_t err = 0;
+    ASSERT_EQ(files.get(path, &err), nullptr);
+    EXPECT_EQ(err, ENOENT);
+    err = 0;
+    ASSERT_EQ(files.get(path, &err), nullptr);
+    EXPECT_EQ(err, ENOENT);
+    EXPECT_EQ(files.misses(), 1u);
+    EXPECT_EQ(files.hits(), 1u);
+
+    // 新建的文件在失效或过期后可见
+    create();
+    ASSERT_EQ(files.get(path), nullptr);
+    files.invalidate(path);
+    ASSERT_NE(files.get(path), nullptr);
+
+    HttpFileCache uncached(16, 0);
+    ::unlink(path.c_str());
+    ASSERT_EQ(uncached.get(path), nullptr);
+    create();
+    ASSERT_NE(uncached.get(path), nullptr);
+
+    ::unlink(path.c_str());
+    ::rmdir(dir_tmpl);
+}
+
+TEST(TestHttpCompressor, negotiate_threshold_and_etag_cache)
+{
+    ASSERT_EQ(NegotiateEncoding("gzip, deflate, br"), HttpEncoding::kGzip);
+    ASSERT_EQ(NegotiateEncoding("deflate;q=1.0, gzip;q=0.5"), HttpEncoding::kDeflate);
+    ASSERT_EQ(NegotiateEncoding("gzip;q=0, deflate;q=0.1"), HttpEncoding::kDeflate);
+    ASSERT_EQ(NegotiateEncoding("*;q=0.3, gzip;q=0"), HttpEncoding::kDeflate);
+    ASSERT_EQ(NegotiateEncoding("*"), HttpEncoding::kGzip);
+    ASSERT_EQ(NegotiateEncoding("identity, br"), HttpEncoding::kIdentity);
+    ASSERT_EQ(NegotiateEncoding("gzip", HttpEncodingMask::Deflate), HttpEncoding::kIdentity);
+    ASSERT_EQ(VariantETag("\"abc\"", HttpEncoding::kGzip), "\"abc-gzip\"");
+    ASSERT_EQ(VariantETag("W/\"abc\"", HttpEncoding::kDeflate), "W/\"abc-deflate\"");
+
+    HttpCompressor::Config config;
+    config.minBytes = 256;
+    HttpCompressor compressor(config);
+    ASSERT_TRUE(compressor.compressible("application/json; charset=utf-8"));
+    ASSERT_TRUE(compressor.compressible("TEXT/HTML"));
+    ASSERT_FALSE(compressor.compressible("image/jpeg"));
+
+    std::string json = "[";
+    for(int i = 0; i < 200; ++i)
+    {
+        json += "{\"id\":" + std::to_string(i) + ",\"name\":\"kit\"},";
+    }
+    json += "{}]";
+
+    HttpRequest req;
+    req.setMethod(HttpRequest::Method::kGet);
+    req.addHeader("Accept-Encoding", "gzip, deflate");
+    auto make_resp = [&](const std::string &body, int32_t type) {
+        auto resp = std::make_shared<HttpResponse>();
+        resp->setVersion(Version::kHttp11);
+        resp->setStateCode(StateCode::k200Ok);
+        resp->body().setContentType(type);
+        resp->body().appendData(body);
+        return resp;
+    };
+
+    // 带 ETag 的响应: 压缩、改写 ETag、第二次命中缓存
+    for(int round = 0; round < 2; ++round)
+    {
+        auto resp = make_resp(json, ContentType::kJsonType);
+        resp->addHeader("ETag", "\"v1\"");
+        ASSERT_TRUE(compressor.apply(req, *resp));
+        ASSERT_EQ(resp->header("Content-Encoding"), "gzip");
+        ASSERT_EQ(resp->header("Vary"), "Accept-Encoding");
+        ASSERT_EQ(resp->header("ETag"), "\"v1-gzip\"");
+        ASSERT_LT(resp->body().size(), json.size());
+        ASSERT_EQ(Inflate(resp->body().toString()), json);
+    }
+    auto stats = compressor.stats();
+    ASSERT_EQ(stats.compressed, 2u);
+    ASSERT_EQ(stats.cache_misses, 1u);
+    ASSERT_EQ(stats.cache_hits, 1u);
+    ASSERT_EQ(stats.cache_entries, 1u);
+
+    // 低于阈值、不可压缩类型、no-transform、已编码、HEAD 均不处理
+    auto small = make_resp("{\"ok\":true}", ContentType::kJsonType);
+    ASSERT_FALSE(compressor.apply(req, *small));
+    ASSERT_TRUE(small->header("Content-Encoding").empty());
+    auto image = make_resp(json, ContentType::kImageJpgType);
+    ASSERT_FALSE(compressor.apply(req, *image));
+    auto no_transform = make_resp(json, ContentType::kJsonType);
+    no_transform->addHeader("Cache-Control", "no-transform");
+    ASSERT_FALSE(compressor.apply(req, *no_transform));
+    auto encoded = make_resp(json, ContentType::kJsonType);
+    encoded->addHeader("Content-Encoding", "br");
+    ASSERT_FALSE(compressor.apply(req, *encoded));
+    HttpRequest head = req;
+    head.setMethod(HttpRequest::Method::kHead);
+    ASSERT_FALSE(compressor.apply(head, *make_resp(json, ContentType::kJsonType)));
+
+    // 客户端不接受压缩时原样返回，但仍声明 Vary
+    HttpRequest plain;
+    plain.setMethod(HttpRequest::Method::kGet);
+    auto identity = make_resp(json, ContentType::kJsonType);
+    ASSERT_FALSE(compressor.apply(plain, *identity));
+    ASSERT_EQ(identity->body().toString(), json);
+    ASSERT_EQ(identity->header("Vary"), "Accept-Encoding");
+
+    // deflate 为 zlib 格式
+    HttpRequest deflate_req;
+    deflate_req.setMethod(HttpRequest::Method::kGet);
+    deflate_req.addHeader("Accept-Encoding", "deflate");
+    auto deflated = make_resp(json, ContentType::kPlainType);
+    ASSERT_TRUE(compressor.apply(deflate_req, *deflated));
+    ASSERT_EQ(deflated->header("Content-Encoding"), "deflate");
+    ASSERT_EQ(Inflate(deflated->body().toString()), json);
+    ASSERT_NE(deflated->toString().find("Content-Length: " + std::to_string(deflated->body().size()) + "\r\n"), std::string::npos);
+}
+
+TEST(TestHttpCompressor, cache_key_includes_request_identity)
+{
+    HttpCompressor::Config config;
+    config.minBytes = 64;
+    HttpCompressor compressor(config);
+
+    const std::string body_a(2048, 'a');
+    const std::string body_b(2048, 'b');
+    auto make_req = [](const std::string &path) {
+        HttpRequest req;
+        req.setMethod(HttpRequest::Method::kGet);
+        req.setPath(path);
+        req.addHeader("Accept-Encoding", "gzip");
+        req.addHeader("Accept-Language", "en");
+        return req;
+    };
+    auto make_resp = [](const std::string &body, const std::string &etag) {
+        auto resp = std::make_shared<HttpResponse>();
+        resp->setVersion(Version::kHttp11);
+        resp->setStateCode(StateCode::k200Ok);
+        resp->body().setContentType(ContentType::kPlainType);
+        resp->body().appendData(body);
+        resp->addHeader("ETag", etag);
+        return resp;
+    };
+
+    // 两个路径共用同一 ETag，不得互相命中
+    HttpRequest req_a = make_req("/a");
+    HttpRequest req_b = make_req("/b");
+    auto resp_a = make_resp(body_a, "\"same\"");
+    auto resp_b = make_resp(body_b, "\"same\"");
+    ASSERT_TRUE(compressor.apply(req_a, *resp_a));
+    ASSERT_TRUE(compressor.apply(req_b, *resp_b));
+    ASSERT_EQ(Inflate(resp_a->body().toString()), body_a);
+    ASSERT_EQ(Inflate(resp_b->body().toString()), body_b);
+    ASSERT_EQ(compressor.stats().cache_entries, 2u);
+    ASSERT_EQ(compressor.stats().cache_hits, 0u);
+
+    // Vary 所列请求头参与键
+    HttpRequest req_zh = make_req("/a");
+    req_zh.headers().set("Accept-Language", "zh");
+    auto resp_zh = make_resp(body_b, "\"same\"");
+    resp_zh->addHeader("Vary", "Accept-Language");
+    ASSERT_TRUE(compressor.apply(req_zh, *resp_zh));
+    ASSERT_EQ(Inflate(resp_zh->body().toString()), body_b);
+    ASSERT_EQ(compressor.stats().cache_hits, 0u);
+
+    // 同一资源再次请求命中
+    auto again = make_resp(body_a, "\"same\"");
+    ASSERT_TRUE(compressor.apply(req_a, *again));
+    ASSERT_EQ(Inflate(again->body().toString()), body_a);
+    ASSERT_EQ(compressor.stats().cache_hits, 1u);
+
+    // 弱 ETag 仍压缩，但既不写入也不读取缓存
+    const size_t entries = compressor.stats().cache_entries;
+    for(const auto &body : {body_a, body_b})
+    {
+        auto weak = make_resp(body, "W/\"weak\"");
+        ASSERT_TRUE(compressor.apply(make_req("/weak"), *weak));
+        ASSERT_EQ(Inflate(weak->body().toString()), body);
+        ASSERT_EQ(weak->header("ETag"), "W/\"weak-gzip\"");
+    }
+    ASSERT_EQ(compressor.stats().cache_entries, entries);
+
+    ASSERT_TRUE(CompressCacheKey(req_a, "W/\"weak\"").empty());
+    ASSERT_TRUE(CompressCacheKey(req_a, "\"v1\"", "*").empty());
+    ASSERT_NE(CompressCacheKey(req_a, "\"v1\""), CompressCacheKey(req_b, "\"v1\""));
+}
+
 TEST(TestHttpServer, pipelined_requests_are_dispatched_separately)
 {
     auto port_result = PickUnusedLoopbackPort();
@@ -668,6 +1443,1095 @@ TEST(TestHttpServer, BusinessThreadPoolSubmitFailureReturns503)
     guard.cleanup();
 }
 
+TEST(TestHttpServer, StreamingResponseUsesChunkedFraming)
+{
+    auto port_result = PickUnusedLoopbackPort();
+    if(!port_result.ok)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable: " << port_result.error;
+    }
+    const uint16_t port = port_result.port;
+
+    EventLoopThread loop_thread(nullptr, "http_stream_chunked_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    std::shared_ptr<HttpServer> server;
+    HttpServerTestGuard guard(loop, &server);
+    std::promise<void> started;
+    auto started_future = started.get_future();
+
+    loop->runInLoop([&](){
+        InetAddress addr(port, "127.0.0.1");
+        server = std::make_shared<HttpServer>(loop, addr, "http-stream-chunked-test", true, TcpServer::KReusePort);
+        server->setThreadNum(0);
+        server->Get("/stream", [](TcpConnectionPtr conn, HttpContextPtr ctx) {
+            auto resp = ctx->response();
+            resp->setStateCode(StateCode::k200Ok);
+            HttpStreamWriter writer(conn, ctx);
+            writer.write("hello");
+            writer.write(std::string(20, 'x'));
+            writer.end();
+        });
+        server->start();
+        started.set_value();
+    });
+
+    ASSERT_EQ(started_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    FdGuard client_fd(ConnectLoopback(port));
+    ASSERT_GE(client_fd.fd, 0);
+
+    const std::string request =
+        "GET /stream HTTP/1.1\r\n"
+        "Host: 127.0.0.1\r\n"
+        "Connection: close\r\n"
+        "\r\n";
+    ASSERT_TRUE(SendAll(client_fd.fd, request));
+
+    const std::string response = ReadAll(client_fd.fd);
+    ASSERT_NE(response.find("HTTP/1.1 200 OK\r\n"), std::string::npos) << response;
+    ASSERT_NE(response.find("Transfer-Encoding: chunked\r\n"), std::string::npos) << response;
+    ASSERT_EQ(response.find("Content-Length"), std::string::npos) << response;
+
+    const size_t body = response.find("\r\n\r\n");
+    ASSERT_NE(body, std::string::npos) << response;
+    ASSERT_EQ(response.substr(body + 4), "5\r\nhello\r\n14\r\n" + std::string(20, 'x') + "\r\n0\r\n\r\n");
+
+    guard.cleanup();
+}
+
+TEST(TestHttpServer, StreamingResponseRespectsBackpressure)
+{
+    auto port_result = PickUnusedLoopbackPort();
+    if(!port_result.ok)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable: " << port_result.error;
+    }
+    const uint16_t port = port_result.port;
+
+    EventLoopThread loop_thread(nullptr, "http_stream_backpressure_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    constexpr size_t kChunk = 64 * 1024;
+    constexpr size_t kChunks = 256;     // 16MB
+    constexpr size_t kHighWaterMark = 512 * 1024;
+    std::atomic<size_t> max_pending{0};
+
+    std::shared_ptr<HttpServer> server;
+    HttpServerTestGuard guard(loop, &server);
+    std::promise<void> started;
+    auto started_future = started.get_future();
+
+    loop->runInLoop([&](){
+        InetAddress addr(port, "127.0.0.1");
+        server = std::make_shared<HttpServer>(loop, addr, "http-stream-backpressure-test", true, TcpServer::KReusePort);
+        server->setThreadNum(0);
+        server->Get("/big", [&max_pending](TcpConnectionPtr conn, HttpContextPtr ctx) {
+            auto resp = ctx->response();
+            resp->setStateCode(StateCode::k200Ok);
+            resp->addHeader("Content-Length", std::to_string(kChunk * kChunks));
+            HttpStreamWriter writer(conn, ctx);
+            writer.setBackpressure(kHighWaterMark, kHighWaterMark / 2, 5000);
+
+            const std::string chunk(kChunk, 'v');
+            for(size_t i = 0; i < kChunks; ++i)
+            {
+                if(!writer.write(chunk))
+                {
+                    break;
+                }
+                size_t pending = conn->pendingBytes();
+                if(pending > max_pending.load())
+                {
+                    max_pending.store(pending);
+                }
+            }
+            writer.end();
+        });
+        server->start();
+        started.set_value();
+    });
+
+    ASSERT_EQ(started_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    FdGuard client_fd(ConnectLoopback(port));
+    ASSERT_GE(client_fd.fd, 0);
+
+    const std::string request =
+        "GET /big HTTP/1.1\r\n"
+        "Host: 127.0.0.1\r\n"
+        "Connection: close\r\n"
+        "\r\n";
+    ASSERT_TRUE(SendAll(client_fd.fd, request));
+
+    // 慢消费者：先停一会，让服务端触发背压
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    const std::string response = ReadAll(client_fd.fd);
+    const size_t body = response.find("\r\n\r\n");
+    ASSERT_NE(body, std::string::npos);
+    ASSERT_EQ(response.size() - body - 4, kChunk * kChunks);
+    ASSERT_LE(max_pending.load(), kHighWaterMark + kChunk);
+
+    guard.cleanup();
+}
+
+namespace {
+
+class UploadServlet : public HttpServlet
+{
+public:
+    explicit UploadServlet(std::string path)
+        :HttpServlet("UploadServlet")
+        ,path_(std::move(path))
+    {}
+
+    HttpBodySink::Ptr createBodySink(TcpConnectionPtr conn, HttpContextPtr ctx) override
+    {
+        return std::make_shared<FileBodySink>(path_);
+    }
+
+    void handle(TcpConnectionPtr conn, HttpContextPtr ctx) override
+    {
+        auto sink = std::dynamic_pointer_cast<FileBodySink>(ctx->bodySink());
+        auto resp = ctx->response();
+        resp->setVersion(Version::kHttp11);
+        resp->setStateCode(StateCode::k200Ok);
+        resp->body().appendData(sink && sink->completed() ? std::to_string(sink->receivedBytes()) : "no-sink");
+        resp->body().appendData(":" + std::to_string(ctx->request()->body().size()));
+    }
+
+private:
+    std::string path_;
+};
+
+} // namespace
+
+TEST(TestHttpServer, UploadBodyStreamsIntoServletSink)
+{
+    auto port_result = PickUnusedLoopbackPort();
+    if(!port_result.ok)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable: " << port_result.error;
+    }
+    const uint16_t port = port_result.port;
+    const std::string path = "/tmp/kit_upload_sink_" + std::to_string(::getpid());
+
+    EventLoopThread loop_thread(nullptr, "http_upload_sink_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    std::shared_ptr<HttpServer> server;
+    HttpServerTestGuard guard(loop, &server);
+    std::promise<void> started;
+    auto started_future = started.get_future();
+
+    loop->runInLoop([&](){
+        InetAddress addr(port, "127.0.0.1");
+        server = std::make_shared<HttpServer>(loop, addr, "http-upload-sink-test", true, TcpServer::KReusePort);
+        server->setThreadNum(0);
+        server->Post("/upload", std::make_shared<UploadServlet>(path));
+        server->start();
+        started.set_value();
+    });
+
+    ASSERT_EQ(started_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    FdGuard client_fd(ConnectLoopback(port));
+    ASSERT_GE(client_fd.fd, 0);
+
+    const std::string body(3 * 1024 * 1024 + 17, 'u');
+    const std::string request =
+        "POST /upload HTTP/1.1\r\n"
+        "Host: 127.0.0.1\r\n"
+        "Connection: close\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "\r\n";
+    ASSERT_TRUE(SendAll(client_fd.fd, request));
+    ASSERT_TRUE(SendAll(client_fd.fd, body));
+
+    const std::string response = ReadAll(client_fd.fd);
+    ASSERT_NE(response.find("HTTP/1.1 200 OK\r\n"), std::string::npos) << response;
+    ASSERT_NE(response.find("\r\n\r\n" + std::to_string(body.size()) + ":0"), std::string::npos) << response;
+
+    struct stat st;
+    ASSERT_EQ(::stat(path.c_str(), &st), 0);
+    ASSERT_EQ(static_cast<size_t>(st.st_size), body.size());
+    ::unlink(path.c_str());
+
+    guard.cleanup();
+}
+
+TEST(TestHttpServer, StaticFileServletServesConditionalAndRangeRequests)
+{
+    auto port_result = PickUnusedLoopbackPort();
+    if(!port_result.ok)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable: " << port_result.error;
+    }
+    const uint16_t port = port_result.port;
+
+    char dir_tmpl[] = "/tmp/kit_static_test_XXXXXX";
+    ASSERT_NE(::mkdtemp(dir_tmpl), nullptr);
+    const std::string root = dir_tmpl;
+    const std::string small_path = root + "/hello.txt";
+    const std::string big_path = root + "/big.bin";
+    const std::string small_content = "0123456789abcdefghij";
+    std::string big_content(3 * 1024 * 1024, '\0');
+    for(size_t i = 0; i < big_content.size(); ++i)
+    {
+        big_content[i] = static_cast<char>('a' + i % 26);
+    }
+    {
+        FILE *f = ::fopen(small_path.c_str(), "wb");
+        ASSERT_NE(f, nullptr);
+        ::fwrite(small_content.data(), 1, small_content.size(), f);
+        ::fclose(f);
+        f = ::fopen(big_path.c_str(), "wb");
+        ASSERT_NE(f, nullptr);
+        ::fwrite(big_content.data(), 1, big_content.size(), f);
+        ::fclose(f);
+    }
+
+    EventLoopThread loop_thread(nullptr, "http_static_file_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    std::shared_ptr<HttpServer> server;
+    HttpServerTestGuard guard(loop, &server);
+    std::promise<void> started;
+    auto started_future = started.get_future();
+
+    loop->runInLoop([&](){
+        InetAddress addr(port, "127.0.0.1");
+        server = std::make_shared<HttpServer>(loop, addr, "http-static-file-test", true, TcpServer::KReusePort);
+        server->setThreadNum(0);
+        server->Get("/static/*", std::make_shared<StaticFileServlet>(root, "/static"));
+        server->start();
+        started.set_value();
+    });
+
+    ASSERT_EQ(started_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    auto request = [port](const std::string &path, const std::string &extra_headers) {
+        FdGuard client_fd(ConnectLoopback(port));
+        if(client_fd.fd < 0)
+        {
+            return std::string();
+        }
+        const std::string req =
+            "GET " + path + " HTTP/1.1\r\n"
+            "Host: 127.0.0.1\r\n"
+            + extra_headers +
+            "Connection: close\r\n"
+            "\r\n";
+        if(!SendAll(client_fd.fd, req))
+        {
+            return std::string();
+        }
+        return ReadAll(client_fd.fd);
+    };
+    auto header_value = [](const std::string &response, const std::string &name) {
+        auto pos = response.find(name + ": ");
+        if(std::string::npos == pos)
+        {
+            return std::string();
+        }
+        pos += name.size() + 2;
+        return response.substr(pos, response.find("\r\n", pos) - pos);
+    };
+    auto body_of = [](const std::string &response) {
+        auto pos = response.find("\r\n\r\n");
+        return std::string::npos == pos ? std::string() : response.substr(pos + 4);
+    };
+
+    std::string response = request("/static/hello.txt", "");
+    ASSERT_NE(response.find("HTTP/1.1 200 OK\r\n"), std::string::npos) << response;
+    ASSERT_EQ(header_value(response, "Content-Type"), "text/plain; charset=utf-8");
+    ASSERT_EQ(header_value(response, "Accept-Ranges"), "bytes");
+    ASSERT_EQ(body_of(response), small_content);
+    const std::string etag = header_value(response, "ETag");
+    const std::string last_modified = header_value(response, "Last-Modified");
+    ASSERT_FALSE(etag.empty());
+    ASSERT_EQ(etag.front(), '"');
+    ASSERT_FALSE(last_modified.empty());
+
+    // 条件请求
+    response = request("/static/hello.txt", "If-None-Match: W/\"other\", " + etag + "\r\n");
+    ASSERT_NE(response.find("HTTP/1.1 304 Not Modified\r\n"), std::string::npos) << response;
+    ASSERT_TRUE(body_of(response).empty());
+    response = request("/static/hello.txt", "If-Modified-Since: " + last_modified + "\r\n");
+    ASSERT_NE(response.find("HTTP/1.1 304 Not Modified\r\n"), std::string::npos) << response;
+    response = request("/static/hello.txt", "If-None-Match: \"stale\"\r\n");
+    ASSERT_NE(response.find("HTTP/1.1 200 OK\r\n"), std::string::npos) << response;
+
+    // 单区间与后缀区间
+    response = request("/static/hello.txt", "Range: bytes=2-5\r\n");
+    ASSERT_NE(response.find("HTTP/1.1 206 Partial Content\r\n"), std::string::npos) << response;
+    ASSERT_EQ(header_value(response, "Content-Range"), "bytes 2-5/20");
+    ASSERT_EQ(body_of(response), "2345");
+    response = request("/static/hello.txt", "Range: bytes=-3\r\n");
+    ASSERT_EQ(body_of(response), "hij");
+
+    // If-Range 不匹配时返回完整内容
+    response = request("/static/hello.txt", "Range: bytes=2-5\r\nIf-Range: \"stale\"\r\n");
+    ASSERT_NE(response.find("HTTP/1.1 200 OK\r\n"), std::string::npos) << response;
+    ASSERT_EQ(body_of(response), small_content);
+
+    // 多区间
+    response = request("/static/hello.txt", "Range: bytes=0-1, 10-\r\n");
+    ASSERT_NE(response.find("HTTP/1.1 206 Partial Content\r\n"), std::string::npos) << response;
+    const std::string content_type = header_value(response, "Content-Type");
+    ASSERT_EQ(content_type.find("multipart/byteranges; boundary="), 0u) << content_type;
+    const std::string boundary = content_type.substr(content_type.find('=') + 1);
+    const std::string expect_body =
+        "\r\n--" + boundary + "\r\nContent-Type: text/plain; charset=utf-8\r\nContent-Range: bytes 0-1/20\r\n\r\n01"
+        "\r\n--" + boundary + "\r\nContent-Type: text/plain; charset=utf-8\r\nContent-Range: bytes 10-19/20\r\n\r\nabcdefghij"
+        "\r\n--" + boundary + "--\r\n";
+    ASSERT_EQ(body_of(response), expect_body);
+    ASSERT_EQ(header_value(response, "Content-Length"), std::to_string(expect_body.size()));
+
+    // 不可满足的区间
+    response = request("/static/hello.txt", "Range: bytes=100-200\r\n");
+    ASSERT_NE(response.find("HTTP/1.1 416 Range Not Satisfiable\r\n"), std::string::npos) << response;
+    ASSERT_EQ(header_value(response, "Content-Range"), "bytes */20");
+
+    // 大文件经 sendfile 分多次写出
+    response = request("/static/big.bin", "");
+    ASSERT_NE(response.find("HTTP/1.1 200 OK\r\n"), std::string::npos);
+    ASSERT_EQ(header_value(response, "Content-Type"), "application/octet-stream");
+    ASSERT_TRUE(body_of(response) == big_content);
+
+    // 大区间走 sendfile，分隔数据需排在文件区间之后按序写出
+    response = request("/static/big.bin", "Range: bytes=0-99999, 2000000-2099999\r\n");
+    ASSERT_NE(response.find("HTTP/1.1 206 Partial Content\r\n"), std::string::npos);
+    const std::string big_type = header_value(response, "Content-Type");
+    const std::string big_boundary = big_type.substr(big_type.find('=') + 1);
+    const std::string big_expect =
+        "\r\n--" + big_boundary + "\r\nContent-Type: application/octet-stream\r\nContent-Range: bytes 0-99999/3145728\r\n\r\n"
+        + big_content.substr(0, 100000) +
+        "\r\n--" + big_boundary + "\r\nContent-Type: application/octet-stream\r\nContent-Range: bytes 2000000-2099999/3145728\r\n\r\n"
+        + big_content.substr(2000000, 100000) +
+        "\r\n--" + big_boundary + "--\r\n";
+    ASSERT_TRUE(body_of(response) == big_expect);
+
+    response = request("/static/missing.txt", "");
+    ASSERT_NE(response.find("HTTP/1.1 404 Not Found\r\n"), std::string::npos) << response;
+    response = request("/static/../etc/passwd", "");
+    ASSERT_NE(response.find("HTTP/1.1 404 Not Found\r\n"), std::string::npos) << response;
+
+    guard.cleanup();
+    ::unlink(small_path.c_str());
+    ::unlink(big_path.c_str());
+    ::rmdir(root.c_str());
+}
+
+TEST(TestHttpServer, StaticFileServletServesHotAssetsFromMemory)
+{
+    auto port_result = PickUnusedLoopbackPort();
+    if(!port_result.ok)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable: " << port_result.error;
+    }
+    const uint16_t port = port_result.port;
+
+    char dir_tmpl[] = "/tmp/kit_hot_asset_test_XXXXXX";
+    ASSERT_NE(::mkdtemp(dir_tmpl), nullptr);
+    const std::string root = dir_tmpl;
+    const std::string path = root + "/app.js";
+    const std::string content = "console.log('kit');\n";
+    {
+        FILE *f = ::fopen(path.c_str(), "wb");
+        ASSERT_NE(f, nullptr);
+        ::fwrite(content.data(), 1, content.size(), f);
+        ::fclose(f);
+    }
+
+    EventLoopThread loop_thread(nullptr, "http_hot_asset_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    auto servlet = std::make_shared<StaticFileServlet>(root, "/assets");
+    std::shared_ptr<HttpServer> server;
+    HttpServerTestGuard guard(loop, &server);
+    std::promise<void> started;
+    auto started_future = started.get_future();
+
+    loop->runInLoop([&](){
+        InetAddress addr(port, "127.0.0.1");
+        // 不使用业务线程池，保证流水线请求按序处理
+        server = std::make_shared<HttpServer>(loop, addr, "http-hot-asset-test", false, TcpServer::KReusePort);
+        server->setThreadNum(0);
+        server->Get("/assets/*", servlet);
+        server->start();
+        started.set_value();
+    });
+
+    ASSERT_EQ(started_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    // keep-alive 连接上连续请求两次，第二次命中内存缓存
+    FdGuard client_fd(ConnectLoopback(port));
+    ASSERT_GE(client_fd.fd, 0);
+    const std::string request =
+        "GET /assets/app.js HTTP/1.1\r\n"
+        "Host: 127.0.0.1\r\n"
+        "\r\n";
+    ASSERT_TRUE(SendAll(client_fd.fd, request + request));
+    ASSERT_TRUE(SendAll(client_fd.fd,
+        "GET /assets/app.js HTTP/1.1\r\n"
+        "Host: 127.0.0.1\r\n"
+        "Connection: close\r\n"
+        "\r\n"));
+    const std::string response = ReadAll(client_fd.fd);
+
+    size_t count = 0;
+    for(size_t pos = response.find("HTTP/1.1 200 OK\r\n"); pos != std::string::npos;
+        pos = response.find("HTTP/1.1 200 OK\r\n", pos + 1))
+    {
+        ++count;
+    }
+    ASSERT_EQ(count, 3u) << response;
+    ASSERT_NE(response.find("Content-Type: text/javascript; charset=utf-8\r\n"), std::string::npos) << response;
+    ASSERT_NE(response.find("Content-Length: " + std::to_string(content.size()) + "\r\n"), std::string::npos) << response;
+    ASSERT_NE(response.find("Connection: close\r\n"), std::string::npos) << response;
+    ASSERT_EQ(response.substr(response.size() - content.size()), content);
+
+    auto stats = servlet->assetCache()->stats();
+    ASSERT_EQ(stats.hits, 2u);
+    ASSERT_EQ(stats.misses, 1u);
+    ASSERT_EQ(stats.entries, 1u);
+
+    guard.cleanup();
+    ::unlink(path.c_str());
+    ::rmdir(root.c_str());
+}
+
+TEST(TestHttpServer, CompressesDynamicAndStaticResponses)
+{
+    auto port_result = PickUnusedLoopbackPort();
+    if(!port_result.ok)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable: " << port_result.error;
+    }
+    const uint16_t port = port_result.port;
+
+    char dir_tmpl[] = "/tmp/kit_compress_test_XXXXXX";
+    ASSERT_NE(::mkdtemp(dir_tmpl), nullptr);
+    const std::string root = dir_tmpl;
+    auto write_file = [](const std::string &path, const std::string &content) {
+        FILE *f = ::fopen(path.c_str(), "wb");
+        ASSERT_NE(f, nullptr);
+        ::fwrite(content.data(), 1, content.size(), f);
+        ::fclose(f);
+    };
+    std::string script;
+    for(int i = 0; i < 300; ++i)
+    {
+        script += "console.log('kit " + std::to_string(i) + "');\n";
+    }
+    const std::string css(4096, 'a');
+    std::string css_gz;
+    ASSERT_TRUE(HttpCompress(css.data(), css.size(), HttpEncoding::kGzip, 9, &css_gz));
+    write_file(root + "/app.js", script);
+    write_file(root + "/style.css", css);
+    write_file(root + "/style.css.gz", css_gz);
+
+    EventLoopThread loop_thread(nullptr, "http_compress_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    auto compressor = std::make_shared<HttpCompressor>();
+    auto servlet = std::make_shared<StaticFileServlet>(root, "/assets");
+    servlet->setCompressor(compressor);
+    const std::string json = "{\"items\":[" + std::string(2000, '1') + "]}";
+    std::shared_ptr<HttpServer> server;
+    HttpServerTestGuard guard(loop, &server);
+    std::promise<void> started;
+    auto started_future = started.get_future();
+
+    loop->runInLoop([&](){
+        InetAddress addr(port, "127.0.0.1");
+        server = std::make_shared<HttpServer>(loop, addr, "http-compress-test", true, TcpServer::KReusePort);
+        server->setThreadNum(0);
+        server->setCompressor(compressor);
+        server->Get("/assets/*", servlet);
+        server->Get("/api", [&json](TcpConnectionPtr, HttpContextPtr ctx) {
+            auto resp = ctx->response();
+            resp->setVersion(Version::kHttp11);
+            resp->setStateCode(StateCode::k200Ok);
+            resp->body().setContentType(ContentType::kJsonType);
+            resp->body().appendData(json);
+        });
+        server->start();
+        started.set_value();
+    });
+    ASSERT_EQ(started_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    // 每次请求一个连接，返回 (头部, Body)
+    auto fetch = [port](const std::string &path, const std::string &accept) {
+        FdGuard fd(ConnectLoopback(port));
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n";
+        if(!accept.empty())
+        {
+            request += "Accept-Encoding: " + accept + "\r\n";
+        }
+        request += "\r\n";
+        if(fd.fd < 0 || !SendAll(fd.fd, request))
+        {
+            return std::make_pair(std::string(), std::string());
+        }
+        const std::string response = ReadAll(fd.fd);
+        const size_t split = response.find("\r\n\r\n");
+        if(std::string::npos == split)
+        {
+            return std::make_pair(response, std::string());
+        }
+        return std::make_pair(response.substr(0, split + 2), response.substr(split + 4));
+    };
+
+    // 动态响应在业务线程中压缩
+    auto api = fetch("/api", "gzip");
+    ASSERT_NE(api.first.find("Content-Encoding: gzip\r\n"), std::string::npos) << api.first;
+    ASSERT_NE(api.first.find("Vary: Accept-Encoding\r\n"), std::string::npos) << api.first;
+    ASSERT_EQ(Inflate(api.second), json);
+
+    // 静态文件现场压缩，第二次命中压缩缓存
+    for(int round = 0; round < 2; ++round)
+    {
+        auto js = fetch("/assets/app.js", "gzip, deflate");
+        ASSERT_NE(js.first.find("HTTP/1.1 200 OK\r\n"), std::string::npos) << js.first;
+        ASSERT_NE(js.first.find("Content-Encoding: gzip\r\n"), std::string::npos) << js.first;
+        ASSERT_NE(js.first.find("-gzip\"\r\n"), std::string::npos) << js.first;
+        ASSERT_NE(js.first.find("Content-Length: " + std::to_string(js.second.size()) + "\r\n"), std::string::npos) << js.first;
+        ASSERT_EQ(Inflate(js.second), script);
+    }
+    auto stats = compressor->stats();
+    ASSERT_EQ(stats.cache_misses, 1u);
+    ASSERT_EQ(stats.cache_hits, 1u);
+
+    // 不接受压缩的客户端拿到原文，并带 Vary
+    auto plain = fetch("/assets/app.js", "");
+    ASSERT_TRUE(plain.first.find("Content-Encoding") == std::string::npos) << plain.first;
+    ASSERT_NE(plain.first.find("Vary: Accept-Encoding\r\n"), std::string::npos) << plain.first;
+    ASSERT_EQ(plain.second, script);
+
+    // 存在预压缩文件时直接发送 .gz
+    auto style = fetch("/assets/style.css", "gzip");
+    ASSERT_NE(style.first.find("Content-Encoding: gzip\r\n"), std::string::npos) << style.first;
+    ASSERT_NE(style.first.find("Content-Type: text/css; charset=utf-8\r\n"), std::string::npos) << style.first;
+    ASSERT_EQ(style.second, css_gz);
+    ASSERT_EQ(compressor->stats().cache_misses, 1u);
+
+    guard.cleanup();
+    ::unlink((root + "/app.js").c_str());
+    ::unlink((root + "/style.css").c_str());
+    ::unlink((root + "/style.css.gz").c_str());
+    ::rmdir(root.c_str());
+}
+
+TEST(TestHttpServer, IntrospectionEndpoints)
+{
+    auto port_result = PickUnusedLoopbackPort();
+    if(!port_result.ok)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable: " << port_result.error;
+    }
+    const uint16_t port = port_result.port;
+
+    EventLoopThread loop_thread(nullptr, "http_introspect_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    std::shared_ptr<HttpServer> server;
+    HttpServerTestGuard guard(loop, &server);
+    std::promise<bool> started;
+    auto started_future = started.get_future();
+
+    loop->runInLoop([&](){
+        InetAddress addr(port, "127.0.0.1");
+        server = std::make_shared<HttpServer>(loop, addr, "http-introspect-test", true, TcpServer::KReusePort);
+        server->setThreadNum(2);
+        bool ok = server->enableIntrospection("/admin");
+        server->start();
+        started.set_value(ok);
+    });
+    ASSERT_EQ(started_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    ASSERT_TRUE(started_future.get());
+
+    auto fetch = [port](const std::string &path) {
+        FdGuard fd(ConnectLoopback(port));
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+        if(fd.fd < 0 || !SendAll(fd.fd, request))
+        {
+            return std::make_pair(std::string(), std::string());
+        }
+        const std::string response = ReadAll(fd.fd);
+        const size_t split = response.find("\r\n\r\n");
+        if(std::string::npos == split)
+        {
+            return std::make_pair(response, std::string());
+        }
+        return std::make_pair(response.substr(0, split + 2), response.substr(split + 4));
+    };
+
+    auto metrics_resp = fetch("/admin/metrics");
+    ASSERT_NE(metrics_resp.first.find("HTTP/1.1 200 OK\r\n"), std::string::npos) << metrics_resp.first;
+    ASSERT_NE(metrics_resp.first.find("Content-Type: text/plain; version=0.0.4"), std::string::npos) << metrics_resp.first;
+    ASSERT_NE(metrics_resp.second.find("# TYPE kit_tcp_accepted_total counter\n"), std::string::npos);
+    ASSERT_NE(metrics_resp.second.find("# TYPE kit_event_loop_iteration_ns histogram\n"), std::string::npos);
+    ASSERT_NE(metrics_resp.second.find("kit_event_loop_iteration_ns_bucket{le=\"+Inf\"} "), std::string::npos);
+
+    auto loops_resp = fetch("/admin/debug/loops");
+    ASSERT_NE(loops_resp.first.find("Content-Type: application/json"), std::string::npos) << loops_resp.first;
+    auto loops = nlohmann::json::parse(loops_resp.second, nullptr, false);
+    ASSERT_FALSE(loops.is_discarded()) << loops_resp.second;
+    // 主循环 + 2 个子循环，主循环至少有 wakeup、定时器与监听 channel
+    ASSERT_EQ(loops["loops"].size(), 3u);
+    ASSERT_GE(loops["loops"][0]["channels"].get<int>(), 3);
+    ASSERT_GE(loops["loops"][0]["timers"].get<int>(), 1);
+
+    // 保持一个已发送过数据的空闲连接，应出现在连接列表中
+    FdGuard idle(ConnectLoopback(port));
+    ASSERT_GE(idle.fd, 0);
+    const std::string partial = "GET /admin/metrics HTTP/1.1\r\n";
+    ASSERT_TRUE(SendAll(idle.fd, partial));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    auto conns_resp = fetch("/admin/debug/connections");
+    auto conns = nlohmann::json::parse(conns_resp.second, nullptr, false);
+    ASSERT_FALSE(conns.is_discarded()) << conns_resp.second;
+    ASSERT_GE(conns["count"].get<int>(), 2);
+    bool found_idle = false;
+    for(auto &conn : conns["connections"])
+    {
+        if(conn["bytes_read"].get<size_t>() == partial.size())
+        {
+            found_idle = true;
+            ASSERT_EQ(conn["state"].get<std::string>(), "connected");
+            ASSERT_GE(conn["input_capacity"].get<size_t>(), partial.size());
+        }
+    }
+    ASSERT_TRUE(found_idle) << conns_resp.second;
+
+    guard.cleanup();
+}
+
+TEST(TestHttpServer, TracesRequestLifecycle)
+{
+    auto port_result = PickUnusedLoopbackPort();
+    if(!port_result.ok)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable: " << port_result.error;
+    }
+    const uint16_t port = port_result.port;
+
+    EventLoopThread loop_thread(nullptr, "http_trace_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    std::shared_ptr<HttpServer> server;
+    HttpServerTestGuard guard(loop, &server);
+    std::promise<void> started;
+    auto started_future = started.get_future();
+
+    loop->runInLoop([&](){
+        InetAddress addr(port, "127.0.0.1");
+        server = std::make_shared<HttpServer>(loop, addr, "http-trace-test", true, TcpServer::KReusePort);
+        server->setThreadNum(1);
+        server->enableIntrospection();
+        server->Get("/work", [](TcpConnectionPtr, HttpContextPtr ctx) {
+            auto resp = ctx->response();
+            resp->setVersion(Version::kHttp11);
+            resp->setStateCode(StateCode::k200Ok);
+            resp->body().appendData("done");
+        });
+        server->start();
+        started.set_value();
+    });
+    ASSERT_EQ(started_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    trace::Clear();
+    trace::SetSampleRate(1);
+    {
+        FdGuard fd(ConnectLoopback(port));
+        ASSERT_TRUE(SendAll(fd.fd, "GET /work HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n"));
+        ASSERT_NE(ReadAll(fd.fd).find("done"), std::string::npos);
+    }
+    trace::SetSampleRate(0);
+
+    // 写socket之后的标记回调与客户端读取并发，稍等片刻
+    std::set<std::string> names;
+    nlohmann::json request_span;
+    for(int i = 0; i < 100 && request_span.is_null(); ++i)
+    {
+        names.clear();
+        auto doc = nlohmann::json::parse(trace::DumpChromeTrace());
+        for(auto &event : doc["traceEvents"])
+        {
+            if("X" != event["ph"])
+            {
+                continue;
+            }
+            names.insert(event["name"].get<std::string>());
+            if("http.request" == event["name"])
+            {
+                request_span = event;
+            }
+        }
+        if(request_span.is_null())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    ASSERT_FALSE(request_span.is_null());
+    EXPECT_EQ(request_span["args"]["detail"].get<std::string>(), "GET /work");
+    for(const char *name : {"http.parse", "pool.wait", "servlet", "loop.hop", "socket.write"})
+    {
+        EXPECT_TRUE(names.count(name)) << name;
+    }
+
+    // 追踪导出端点
+    FdGuard fd(ConnectLoopback(port));
+    ASSERT_TRUE(SendAll(fd.fd, "GET /debug/trace?clear=1 HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n"));
+    const std::string response = ReadAll(fd.fd);
+    ASSERT_NE(response.find("\"traceEvents\""), std::string::npos) << response;
+    ASSERT_NE(response.find("\"servlet\""), std::string::npos);
+
+    guard.cleanup();
+    trace::Clear();
+}
+
+namespace {
+
+/// @brief 读到 data 中出现 needle 为止，超时或断开返回 false
+bool ReadUntil(int32_t fd, std::string &data, const std::string &needle)
+{
+    char buf[4096];
+    while(std::string::npos == data.find(needle))
+    {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if(n <= 0)
+        {
+            return false;
+        }
+        data.append(buf, static_cast<size_t>(n));
+    }
+    return true;
+}
+
+bool WaitFor(const std::function<bool()> &pred)
+{
+    for(int i = 0; i < 200; ++i)
+    {
+        if(pred())
+        {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return pred();
+}
+
+} // namespace
+
+TEST(TestHttpSse, encode_event)
+{
+    SseEvent event;
+    event.id = "7\n";
+    event.event = "viewers";
+    event.data = "a\r\nb\rc\n";
+    event.retryMs = 500;
+    EXPECT_EQ(EncodeSseEvent(event), "id: 7\nevent: viewers\nretry: 500\ndata: a\ndata: b\ndata: c\ndata: \n\n");
+
+    SseEvent plain;
+    plain.data = "hello";
+    EXPECT_EQ(EncodeSseEvent(plain), "data: hello\n\n");
+}
+
+TEST(TestHttpServer, SseTopicFansOutSharedEvents)
+{
+    auto port_result = PickUnusedLoopbackPort();
+    if(!port_result.ok)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable: " << port_result.error;
+    }
+    const uint16_t port = port_result.port;
+
+    EventLoopThread loop_thread(nullptr, "http_sse_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    SseTopic::Config config;
+    config.heartbeatMs = 50;
+    config.replayEvents = 8;
+    config.retryMs = 1000;
+    auto topic = std::make_shared<SseTopic>(loop, "live", config);
+
+    std::shared_ptr<HttpServer> server;
+    HttpServerTestGuard guard(loop, &server);
+    std::promise<void> started;
+    auto started_future = started.get_future();
+
+    loop->runInLoop([&](){
+        InetAddress addr(port, "127.0.0.1");
+        server = std::make_shared<HttpServer>(loop, addr, "http-sse-test", true, TcpServer::KReusePort);
+        server->setThreadNum(0);
+        server->Get("/events", [topic](TcpConnectionPtr conn, HttpContextPtr ctx) {
+            topic->subscribe(conn, ctx);
+        });
+        server->start();
+        started.set_value();
+    });
+    ASSERT_EQ(started_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    const std::string request = "GET /events HTTP/1.1\r\nHost: 127.0.0.1\r\nAccept: text/event-stream\r\n\r\n";
+    FdGuard a(ConnectLoopback(port));
+    FdGuard b(ConnectLoopback(port));
+    ASSERT_GE(a.fd, 0);
+    ASSERT_GE(b.fd, 0);
+    std::string data_a;
+    std::string data_b;
+    ASSERT_TRUE(SendAll(a.fd, request));
+    ASSERT_TRUE(SendAll(b.fd, request));
+    ASSERT_TRUE(ReadUntil(a.fd, data_a, "retry: 1000\n\n\r\n"));
+    ASSERT_TRUE(ReadUntil(b.fd, data_b, "retry: 1000\n\n\r\n"));
+    EXPECT_NE(data_a.find("HTTP/1.1 200 OK\r\n"), std::string::npos) << data_a;
+    EXPECT_NE(data_a.find("Content-Type: text/event-stream; charset=utf-8\r\n"), std::string::npos) << data_a;
+    EXPECT_NE(data_a.find("Transfer-Encoding: chunked\r\n"), std::string::npos) << data_a;
+    EXPECT_EQ(data_a.find("Content-Length"), std::string::npos) << data_a;
+    ASSERT_TRUE(WaitFor([&]() { return 2 == topic->subscribers(); }));
+
+    SseEvent first;
+    first.id = "1";
+    first.event = "viewers";
+    first.data = "10";
+    EXPECT_EQ(topic->publish(first), 2u);
+    SseEvent second;
+    second.id = "2";
+    second.data = "a\nb";
+    EXPECT_EQ(topic->publish(second), 2u);
+
+    // 每条事件一个 chunk
+    for(std::string *data : {&data_a, &data_b})
+    {
+        const int32_t fd = data == &data_a ? a.fd : b.fd;
+        ASSERT_TRUE(ReadUntil(fd, *data, "id: 2\ndata: a\ndata: b\n\n\r\n"));
+        EXPECT_NE(data->find("1f\r\nid: 1\nevent: viewers\ndata: 10\n\n\r\n"), std::string::npos) << *data;
+    }
+    // 心跳注释
+    ASSERT_TRUE(ReadUntil(a.fd, data_a, "3\r\n:\n\n\r\n"));
+
+    // 断线重连，从 Last-Event-ID 之后补发
+    FdGuard c(ConnectLoopback(port));
+    ASSERT_GE(c.fd, 0);
+    std::string data_c;
+    ASSERT_TRUE(SendAll(c.fd, "GET /events HTTP/1.1\r\nHost: 127.0.0.1\r\nLast-Event-ID: 1\r\n\r\n"));
+    ASSERT_TRUE(ReadUntil(c.fd, data_c, "id: 2\ndata: a\ndata: b\n\n"));
+    EXPECT_EQ(data_c.find("id: 1\n"), std::string::npos) << data_c;
+
+    // HTTP/1.0 不分块，以关闭连接结束
+    FdGuard d(ConnectLoopback(port));
+    ASSERT_GE(d.fd, 0);
+    std::string data_d;
+    ASSERT_TRUE(SendAll(d.fd, "GET /events HTTP/1.0\r\n\r\n"));
+    ASSERT_TRUE(ReadUntil(d.fd, data_d, "retry: 1000\n\n"));
+    EXPECT_NE(data_d.find("HTTP/1.0 200 OK\r\n"), std::string::npos) << data_d;
+    EXPECT_EQ(data_d.find("Transfer-Encoding"), std::string::npos) << data_d;
+    ASSERT_TRUE(WaitFor([&]() { return 4 == topic->subscribers(); }));
+    EXPECT_EQ(topic->publish("x"), 4u);
+    ASSERT_TRUE(ReadUntil(d.fd, data_d, "\r\n\r\nretry: 1000\n\ndata: x\n\n"));
+
+    SseTopic::Stats stats = topic->stats();
+    EXPECT_EQ(stats.published, 3u);
+    EXPECT_EQ(stats.delivered, 8u);
+    EXPECT_EQ(stats.replayed, 1u);
+    EXPECT_EQ(stats.dropped, 0u);
+
+    // 关闭主题: chunked 订阅者收到结束块后断开
+    topic->close();
+    EXPECT_EQ(topic->subscribers(), 0u);
+    data_a.clear();
+    ReadUntil(a.fd, data_a, "\xff");
+    EXPECT_NE(data_a.find("0\r\n\r\n"), std::string::npos) << data_a;
+    data_d.clear();
+    EXPECT_FALSE(ReadUntil(d.fd, data_d, "\xff"));
+
+    guard.cleanup();
+}
+
+TEST(TestHttpServer, SseTopicHandlesSlowSubscribers)
+{
+    auto port_result = PickUnusedLoopbackPort();
+    if(!port_result.ok)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable: " << port_result.error;
+    }
+    const uint16_t port = port_result.port;
+
+    EventLoopThread loop_thread(nullptr, "http_sse_slow_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    SseTopic::Config config;
+    config.heartbeatMs = 0;
+    config.maxPendingBytes = 256 * 1024;
+    config.stallTimeoutMs = 0;
+    auto dropping = std::make_shared<SseTopic>(loop, "dropping", config);
+    config.dropPolicy = SseTopic::DropPolicy::kDisconnect;
+    auto evicting = std::make_shared<SseTopic>(loop, "evicting", config);
+
+    std::shared_ptr<HttpServer> server;
+    HttpServerTestGuard guard(loop, &server);
+    std::promise<void> started;
+    auto started_future = started.get_future();
+
+    loop->runInLoop([&](){
+        InetAddress addr(port, "127.0.0.1");
+        server = std::make_shared<HttpServer>(loop, addr, "http-sse-slow-test", true, TcpServer::KReusePort);
+        server->setThreadNum(0);
+        server->Get("/drop", [dropping](TcpConnectionPtr conn, HttpContextPtr ctx) { dropping->subscribe(conn, ctx); });
+        server->Get("/evict", [evicting](TcpConnectionPtr conn, HttpContextPtr ctx) { evicting->subscribe(conn, ctx); });
+        server->start();
+        started.set_value();
+    });
+    ASSERT_EQ(started_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    // 客户端读完响应头后不再读取
+    FdGuard slow_drop(ConnectLoopback(port));
+    FdGuard slow_evict(ConnectLoopback(port));
+    ASSERT_GE(slow_drop.fd, 0);
+    ASSERT_GE(slow_evict.fd, 0);
+    std::string head;
+    ASSERT_TRUE(SendAll(slow_drop.fd, "GET /drop HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n"));
+    ASSERT_TRUE(ReadUntil(slow_drop.fd, head, "\r\n\r\n"));
+    head.clear();
+    ASSERT_TRUE(SendAll(slow_evict.fd, "GET /evict HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n"));
+    ASSERT_TRUE(ReadUntil(slow_evict.fd, head, "\r\n\r\n"));
+    ASSERT_TRUE(WaitFor([&]() { return 1 == dropping->subscribers() && 1 == evicting->subscribers(); }));
+
+    const std::string payload(64 * 1024, 'e');
+    for(int i = 0; i < 4000 && (0 == evicting->stats().evicted || 0 == dropping->stats().dropped); ++i)
+    {
+        dropping->publish(payload);
+        evicting->publish(payload);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    SseTopic::Stats drop_stats = dropping->stats();
+    EXPECT_GT(drop_stats.dropped, 0u);
+    EXPECT_EQ(drop_stats.evicted, 0u);
+    EXPECT_EQ(dropping->subscribers(), 1u);
+
+    SseTopic::Stats evict_stats = evicting->stats();
+    EXPECT_EQ(evict_stats.evicted, 1u);
+    EXPECT_EQ(evicting->subscribers(), 0u);
+    EXPECT_EQ(evicting->publish(payload), 0u);
+
+    // 被断开的订阅者读完已写入内核的数据后看到连接关闭
+    char buf[65536];
+    ssize_t n;
+    while((n = ::recv(slow_evict.fd, buf, sizeof(buf), 0)) > 0)
+    {
+    }
+    EXPECT_TRUE(0 == n || ECONNRESET == errno);
+
+    guard.cleanup();
+}
+
+TEST(TestHttpServer, SseTopicUnsubscribesOnDisconnect)
+{
+    auto port_result = PickUnusedLoopbackPort();
+    if(!port_result.ok)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable: " << port_result.error;
+    }
+    const uint16_t port = port_result.port;
+
+    EventLoopThread loop_thread(nullptr, "http_sse_close_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    // 无心跳: 只能靠连接断开通知退订
+    const std::string event_bytes = EncodeSseEvent(SseEvent{"", "", "x", -1});
+    SseTopic::Config config;
+    config.heartbeatMs = 0;
+    config.stallTimeoutMs = 0;
+    // 恰好容纳一条事件体，chunked 订阅者还需 chunk 头与结尾，放不下
+    config.maxPendingBytes = event_bytes.size();
+    auto topic = std::make_shared<SseTopic>(loop, "close", config);
+    metrics::Gauge &gauge = metrics::MetricsRegistry::Instance().gauge("kit_sse_subscribers", "Open SSE subscriptions");
+    const int64_t base = gauge.value();
+    std::mutex conns_mutex;
+    std::vector<std::weak_ptr<TcpConnection>> conns;
+
+    std::shared_ptr<HttpServer> server;
+    HttpServerTestGuard guard(loop, &server);
+    std::promise<void> started;
+    auto started_future = started.get_future();
+
+    loop->runInLoop([&](){
+        InetAddress addr(port, "127.0.0.1");
+        server = std::make_shared<HttpServer>(loop, addr, "http-sse-close-test", true, TcpServer::KReusePort);
+        server->setThreadNum(0);
+        server->Get("/events", [topic, &conns, &conns_mutex](TcpConnectionPtr conn, HttpContextPtr ctx) {
+            if(topic->subscribe(conn, ctx))
+            {
+                std::lock_guard<std::mutex> lock(conns_mutex);
+                conns.push_back(conn);
+            }
+        });
+        server->start();
+        started.set_value();
+    });
+    ASSERT_EQ(started_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    FdGuard chunked(ConnectLoopback(port));
+    FdGuard plain(ConnectLoopback(port));
+    ASSERT_GE(chunked.fd, 0);
+    ASSERT_GE(plain.fd, 0);
+    std::string data_chunked;
+    std::string data_plain;
+    ASSERT_TRUE(SendAll(chunked.fd, "GET /events HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n"));
+    ASSERT_TRUE(SendAll(plain.fd, "GET /events HTTP/1.0\r\n\r\n"));
+    ASSERT_TRUE(ReadUntil(chunked.fd, data_chunked, "\r\n\r\n"));
+    ASSERT_TRUE(ReadUntil(plain.fd, data_plain, "\r\n\r\n"));
+    ASSERT_TRUE(WaitFor([&]() { return 2 == topic->subscribers(); }));
+    EXPECT_EQ(gauge.value(), base + 2);
+    // 客户端读到响应头时IO线程可能还没扣减待发送字节
+    ASSERT_TRUE(WaitFor([&]() {
+        std::lock_guard<std::mutex> lock(conns_mutex);
+        for(auto &weak_conn : conns)
+        {
+            TcpConnectionPtr conn = weak_conn.lock();
+            if(!conn || conn->pendingBytes() > 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }));
+
+    // 积压按各自的分帧计算: 不分块的订阅者只发事件体
+    EXPECT_EQ(topic->publish("x"), 1u);
+    EXPECT_EQ(topic->stats().dropped, 1u);
+    ASSERT_TRUE(ReadUntil(plain.fd, data_plain, event_bytes));
+
+    // 客户端断开后不发布也不心跳，订阅者与仪表都应回落
+    ::close(chunked.fd);
+    chunked.fd = -1;
+    ASSERT_TRUE(WaitFor([&]() { return 1 == topic->subscribers(); }));
+    EXPECT_EQ(gauge.value(), base + 1);
+    ::close(plain.fd);
+    plain.fd = -1;
+    ASSERT_TRUE(WaitFor([&]() { return 0 == topic->subscribers(); }));
+    EXPECT_EQ(gauge.value(), base);
+    EXPECT_EQ(topic->stats().published, 1u);
+
+    guard.cleanup();
+}
+
 TEST(TestHttpServer, DISABLED_listen)
 {
     EventLoop loop;
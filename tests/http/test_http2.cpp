@@ -0,0 +1,876 @@
+/**
+ * @file test_http2.cpp
+ * @brief HPACK、HTTP/2 帧编解码与 h2c 多路复用/流量控制测试
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 02:36:12
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/hpack.h"
+#include "net/http/http2.h"
+#include "net/http/http_context.h"
+#include "net/http/http_request.h"
+#include "net/http/http_response.h"
+#include "net/http/http_server.h"
+#include "net/event_loop.h"
+#include "net/net_log.h"
+#include "base/event_loop_thread.h"
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <map>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+std::string Unhex(const std::string &hex)
+{
+    std::string out;
+    for(size_t i = 0; i + 1 < hex.size(); i += 2)
+    {
+        out.push_back(static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+    }
+    return out;
+}
+
+std::string Hex(const std::string &data)
+{
+    static const char kHex[] = "0123456789abcdef";
+    std::string out;
+    for(unsigned char c : data)
+    {
+        out.push_back(kHex[c >> 4]);
+        out.push_back(kHex[c & 0xF]);
+    }
+    return out;
+}
+
+std::string Find(const HpackHeaderList &headers, const std::string &name)
+{
+    for(auto &h : headers)
+    {
+        if(h.name == name)
+        {
+            return h.value;
+        }
+    }
+    return "<none>";
+}
+
+struct FdGuard
+{
+    explicit FdGuard(int32_t input_fd = -1) :fd(input_fd) {}
+    ~FdGuard()
+    {
+        if(fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+    int32_t fd;
+};
+
+uint16_t PickUnusedLoopbackPort()
+{
+    FdGuard listen_fd(::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if(listen_fd.fd < 0)
+    {
+        return 0;
+    }
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if(::bind(listen_fd.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+        || ::getsockname(listen_fd.fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) < 0)
+    {
+        return 0;
+    }
+    return ::ntohs(addr.sin_port);
+}
+
+int32_t ConnectLoopback(uint16_t port)
+{
+    for(int32_t i = 0; i < 50; ++i)
+    {
+        int32_t fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        timeval timeout{2, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = ::htons(port);
+        addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+        if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+        {
+            return fd;
+        }
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return -1;
+}
+
+/**
+ * @brief 测试用的最小 h2 客户端(阻塞 socket)
+ */
+class H2Client
+{
+public:
+    struct Response {
+        int32_t status{0};
+        HpackHeaderList headers;
+        std::string body;
+        bool ended{false};
+        int64_t rst{-1};
+        size_t dataFrames{0};
+    };
+
+    explicit H2Client(int32_t fd) :_fd(fd) {}
+
+    bool send(const std::string &data)
+    {
+        return ::send(_fd, data.data(), data.size(), 0) == static_cast<ssize_t>(data.size());
+    }
+
+    bool preface(const std::vector<std::pair<Http2Setting, uint32_t>> &settings = {})
+    {
+        std::string out(kHttp2ClientPreface);
+        AppendHttp2Settings(&out, settings);
+        return send(out);
+    }
+
+    /// @brief 组出一个请求的帧，不发送
+    uint32_t build(std::string *out, const std::string &method, const std::string &path,
+                   const std::string &body = "", const HpackHeaderList &extra = {})
+    {
+        const uint32_t id = _nextStreamId;
+        _nextStreamId += 2;
+        HpackHeaderList headers{{":method", method}, {":scheme", "http"}, {":path", path}, {":authority", "h2.test"}};
+        headers.insert(headers.end(), extra.begin(), extra.end());
+        std::string block;
+        _encoder.encode(headers, &block);
+        AppendHttp2Headers(out, id, block, body.empty(), kHttp2DefaultMaxFrameSize);
+        for(size_t pos = 0; pos < body.size(); pos += kHttp2DefaultMaxFrameSize)
+        {
+            const size_t len = std::min<size_t>(kHttp2DefaultMaxFrameSize, body.size() - pos);
+            AppendHttp2Frame(out, Http2FrameType::kData, pos + len == body.size() ? Http2Flags::kEndStream : 0,
+                             id, std::string_view(body).substr(pos, len));
+        }
+        return id;
+    }
+
+    uint32_t request(const std::string &method, const std::string &path, const std::string &body = "",
+                     const HpackHeaderList &extra = {})
+    {
+        std::string out;
+        const uint32_t id = build(&out, method, path, body, extra);
+        send(out);
+        return id;
+    }
+
+    /// @brief 读取并处理帧，直到 done 成立；连接关闭或超时返回 false
+    bool pump(const std::function<bool()> &done)
+    {
+        while(!done())
+        {
+            while(_in.size() < kHttp2FrameHeaderSize
+                  || _in.size() < kHttp2FrameHeaderSize + ParseHttp2FrameHeader(_in.data()).length)
+            {
+                char buf[16384];
+                const ssize_t n = ::recv(_fd, buf, sizeof(buf), 0);
+                if(n <= 0)
+                {
+                    return false;
+                }
+                _in.append(buf, static_cast<size_t>(n));
+            }
+            const Http2FrameHeader header = ParseHttp2FrameHeader(_in.data());
+            const std::string payload = _in.substr(kHttp2FrameHeaderSize, header.length);
+            _in.erase(0, kHttp2FrameHeaderSize + header.length);
+            handle(header, payload);
+        }
+        return true;
+    }
+
+    bool waitEnded(uint32_t id)
+    {
+        return pump([this, id]() { return streams[id].ended || streams[id].rst >= 0; });
+    }
+
+    std::map<uint32_t, Response> streams;
+    std::map<uint16_t, uint32_t> peerSettings;
+    int64_t goAway{-1};
+    bool settingsAcked{false};
+    /// @brief 收到 DATA 后是否立即回补窗口
+    bool autoWindow{true};
+
+private:
+    void handle(const Http2FrameHeader &header, const std::string &payload)
+    {
+        switch(header.type)
+        {
+            case Http2FrameType::kSettings:
+                if(header.flags & Http2Flags::kAck)
+                {
+                    settingsAcked = true;
+                    break;
+                }
+                for(size_t i = 0; i + 6 <= payload.size(); i += 6)
+                {
+                    const uint16_t id = static_cast<uint16_t>((static_cast<uint8_t>(payload[i]) << 8) | static_cast<uint8_t>(payload[i + 1]));
+                    uint32_t value = 0;
+                    for(size_t k = 2; k < 6; ++k)
+                    {
+                        value = (value << 8) | static_cast<uint8_t>(payload[i + k]);
+                    }
+                    peerSettings[id] = value;
+                }
+                {
+                    std::string ack;
+                    AppendHttp2SettingsAck(&ack);
+                    send(ack);
+                }
+                break;
+            case Http2FrameType::kHeaders:
+            case Http2FrameType::kContinuation:
+                _block.append(payload);
+                if(Http2FrameType::kHeaders == header.type)
+                {
+                    _blockEndStream = header.flags & Http2Flags::kEndStream;
+                }
+                if(header.flags & Http2Flags::kEndHeaders)
+                {
+                    Response &resp = streams[header.streamId];
+                    EXPECT_EQ(_decoder.decode(_block, &resp.headers), HpackDecoder::Result::kOk);
+                    resp.status = std::atoi(Find(resp.headers, ":status").c_str());
+                    resp.ended = _blockEndStream;
+                    _block.clear();
+                }
+                break;
+            case Http2FrameType::kData:
+            {
+                Response &resp = streams[header.streamId];
+                resp.body.append(payload);
+                ++resp.dataFrames;
+                resp.ended = header.flags & Http2Flags::kEndStream;
+                if(autoWindow && !payload.empty())
+                {
+                    std::string update;
+                    AppendHttp2WindowUpdate(&update, 0, static_cast<uint32_t>(payload.size()));
+                    if(!resp.ended)
+                    {
+                        AppendHttp2WindowUpdate(&update, header.streamId, static_cast<uint32_t>(payload.size()));
+                    }
+                    send(update);
+                }
+                break;
+            }
+            case Http2FrameType::kRstStream:
+                streams[header.streamId].rst = static_cast<uint8_t>(payload[3]);
+                break;
+            case Http2FrameType::kGoAway:
+                goAway = static_cast<uint8_t>(payload[7]);
+                break;
+            default:
+                break;
+        }
+    }
+
+private:
+    int32_t _fd;
+    std::string _in;
+    uint32_t _nextStreamId{1};
+    HpackEncoder _encoder;
+    HpackDecoder _decoder;
+    std::string _block;
+    bool _blockEndStream{false};
+};
+
+/**
+ * @brief 在独立事件循环中启动开启 h2c 的服务器
+ */
+class H2ServerFixture
+{
+public:
+    H2ServerFixture(bool isPool, Http2Session::Config config)
+        :_loopThread(nullptr, "http2_test")
+    {
+        port = PickUnusedLoopbackPort();
+        if(0 == port)
+        {
+            return;
+        }
+        _loop = _loopThread.startLoop();
+        std::promise<void> started;
+        _loop->runInLoop([&]() {
+            _server = std::make_shared<HttpServer>(_loop, InetAddress(port, "127.0.0.1"), "http2-test", isPool, TcpServer::KReusePort);
+            _server->enableHttp2(config);
+            _server->Get("/hello", [](TcpConnectionPtr, HttpContextPtr ctx) {
+                auto resp = ctx->response();
+                resp->setVersion(Version::kHttp11);
+                resp->setStateCode(StateCode::k200Ok);
+                resp->body().setContentType(ContentType::kPlainType);
+                resp->addHeader("X-Version", ctx->request()->version().toString());
+                resp->addHeader("X-Host", std::string(ctx->request()->header(HttpHeaderId::kHost)));
+                resp->body().appendData("hello h2");
+            });
+            _server->Get("/big", [](TcpConnectionPtr, HttpContextPtr ctx) {
+                auto resp = ctx->response();
+                resp->setVersion(Version::kHttp11);
+                resp->setStateCode(StateCode::k200Ok);
+                std::string body(200000, '\0');
+                for(size_t i = 0; i < body.size(); ++i)
+                {
+                    body[i] = static_cast<char>('a' + i % 26);
+                }
+                resp->body().appendData(body);
+            });
+            _server->Post("/echo", [](TcpConnectionPtr, HttpContextPtr ctx) {
+                auto req = ctx->request();
+                auto resp = ctx->response();
+                resp->setVersion(Version::kHttp11);
+                resp->setStateCode(StateCode::k200Ok);
+                resp->addHeader("X-Query", req->getQureyParam("q"));
+                resp->addHeader("X-Cookie", std::string(req->header(HttpHeaderId::kCookie)));
+                resp->body().appendData(req->body().toString());
+            });
+            _server->start();
+            started.set_value();
+        });
+        started.get_future().wait_for(std::chrono::seconds(2));
+    }
+
+    ~H2ServerFixture()
+    {
+        if(!_loop)
+        {
+            return;
+        }
+        std::promise<void> stopped;
+        _loop->runInLoop([&]() {
+            _server.reset();
+            _loop->quit();
+            stopped.set_value();
+        });
+        stopped.get_future().wait_for(std::chrono::seconds(2));
+    }
+
+    uint16_t port{0};
+
+private:
+    EventLoopThread _loopThread;
+    EventLoop *_loop{nullptr};
+    std::shared_ptr<HttpServer> _server;
+};
+
+}
+
+TEST(TestHpack, IntegerAndHuffmanExamples)
+{
+    // RFC 7541 C.1
+    std::string out;
+    HpackEncodeInteger(10, 5, 0, &out);
+    HpackEncodeInteger(1337, 5, 0, &out);
+    HpackEncodeInteger(42, 8, 0, &out);
+    EXPECT_EQ(Hex(out), "0a1f9a0a2a");
+    size_t pos = 0;
+    uint64_t value = 0;
+    const uint8_t *data = reinterpret_cast<const uint8_t*>(out.data());
+    ASSERT_TRUE(HpackDecodeInteger(data, out.size(), &pos, 5, &value));
+    EXPECT_EQ(value, 10u);
+    ASSERT_TRUE(HpackDecodeInteger(data, out.size(), &pos, 5, &value));
+    EXPECT_EQ(value, 1337u);
+    ASSERT_TRUE(HpackDecodeInteger(data, out.size(), &pos, 8, &value));
+    EXPECT_EQ(value, 42u);
+    // 截断的多字节整数
+    pos = 0;
+    EXPECT_FALSE(HpackDecodeInteger(data + 1, 2, &pos, 5, &value));
+
+    // RFC 7541 C.4.1 / C.6.1
+    std::string huff;
+    HuffmanEncode("www.example.com", &huff);
+    EXPECT_EQ(Hex(huff), "f1e3c2e5f23a6ba0ab90f4ff");
+    EXPECT_EQ(HuffmanEncodedLength("www.example.com"), huff.size());
+    huff.clear();
+    HuffmanEncode("Mon, 21 Oct 2013 20:13:21 GMT", &huff);
+    EXPECT_EQ(Hex(huff), "d07abe941054d444a8200595040b8166e082a62d1bff");
+
+    // 全部字节值往返
+    std::string all;
+    for(int i = 0; i < 256; ++i)
+    {
+        all.push_back(static_cast<char>(i));
+    }
+    all += all;
+    std::string encoded;
+    std::string decoded;
+    HuffmanEncode(all, &encoded);
+    ASSERT_TRUE(HuffmanDecode(encoded, &decoded));
+    EXPECT_EQ(decoded, all);
+
+    // 填充超过7位、填充不全为1
+    decoded.clear();
+    EXPECT_FALSE(HuffmanDecode(Unhex("ffffffff"), &decoded));
+    decoded.clear();
+    EXPECT_FALSE(HuffmanDecode(Unhex("f1e3c2e5f23a6ba0ab90f4fe"), &decoded));
+}
+
+TEST(TestHpack, DecodesRfcRequestAndResponseSequences)
+{
+    // RFC 7541 C.4: 同一连接上的三个请求，动态表跨请求复用
+    HpackDecoder decoder;
+    HpackHeaderList headers;
+    ASSERT_EQ(decoder.decode(Unhex("828684418cf1e3c2e5f23a6ba0ab90f4ff"), &headers), HpackDecoder::Result::kOk);
+    ASSERT_EQ(headers.size(), 4u);
+    EXPECT_EQ(Find(headers, ":authority"), "www.example.com");
+    EXPECT_EQ(decoder.table().size(), 57u);
+
+    headers.clear();
+    ASSERT_EQ(decoder.decode(Unhex("828684be5886a8eb10649cbf"), &headers), HpackDecoder::Result::kOk);
+    EXPECT_EQ(Find(headers, ":authority"), "www.example.com");
+    EXPECT_EQ(Find(headers, "cache-control"), "no-cache");
+    EXPECT_EQ(decoder.table().size(), 110u);
+
+    headers.clear();
+    ASSERT_EQ(decoder.decode(Unhex("828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"), &headers), HpackDecoder::Result::kOk);
+    EXPECT_EQ(Find(headers, ":scheme"), "https");
+    EXPECT_EQ(Find(headers, "custom-key"), "custom-value");
+    EXPECT_EQ(decoder.table().size(), 164u);
+
+    // RFC 7541 C.6: 动态表上限 256，第二、三个响应触发淘汰
+    HpackEncoder limit_encoder;
+    std::string update;
+    limit_encoder.setMaxTableSize(256);
+    limit_encoder.encode(HpackHeaderList{}, &update);
+    HpackDecoder resp_decoder;
+    headers.clear();
+    ASSERT_EQ(resp_decoder.decode(update + Unhex(
+        "488264025885aec3771a4b6196d07abe941054d444a8200595040b8166e082a62d1bff6e919d29ad171863c78f0b97c8e9ae82ae43d3"),
+        &headers), HpackDecoder::Result::kOk);
+    EXPECT_EQ(Find(headers, "location"), "https://www.example.com");
+    EXPECT_EQ(resp_decoder.table().size(), 222u);
+
+    headers.clear();
+    ASSERT_EQ(resp_decoder.decode(Unhex("4883640effc1c0bf"), &headers), HpackDecoder::Result::kOk);
+    EXPECT_EQ(Find(headers, ":status"), "307");
+    EXPECT_EQ(resp_decoder.table().size(), 222u);
+
+    headers.clear();
+    ASSERT_EQ(resp_decoder.decode(Unhex(
+        "88c16196d07abe941054d444a8200595040b8166e084a62d1bffc05a839bd9ab77ad94e7821dd7f2e6c7b335dfdfcd5b3960d5af27087f3672c1ab270fb5291f9587316065c003ed4ee5b1063d5007"),
+        &headers), HpackDecoder::Result::kOk);
+    EXPECT_EQ(Find(headers, "content-encoding"), "gzip");
+    EXPECT_EQ(Find(headers, "set-cookie"), "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1");
+    EXPECT_EQ(resp_decoder.table().size(), 215u);
+    EXPECT_EQ(resp_decoder.table().count(), 3u);
+}
+
+TEST(TestHpack, EncoderRoundTripAndDecoderLimits)
+{
+    // 编码结果与 RFC 7541 C.4.1 一致
+    HpackEncoder encoder;
+    std::string block;
+    encoder.encode(HpackHeaderList{{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", "www.example.com"}}, &block);
+    EXPECT_EQ(Hex(block), "828684418cf1e3c2e5f23a6ba0ab90f4ff");
+
+    // 多个头部块往返，动态表两端一致；凭据不进入动态表
+    HpackDecoder decoder;
+    HpackHeaderList headers;
+    ASSERT_EQ(decoder.decode(block, &headers), HpackDecoder::Result::kOk);
+    for(int i = 0; i < 50; ++i)
+    {
+        const HpackHeaderList sent{
+            {":status", "200"},
+            {"content-type", "application/json"},
+            {"x-request-id", std::to_string(i)},
+            {"authorization", "Bearer secret"},
+            {"content-length", std::to_string(i * 10)},
+        };
+        if(i == 25)
+        {
+            // 中途缩小对端动态表
+            encoder.setMaxTableSize(64);
+        }
+        block.clear();
+        encoder.encode(sent, &block);
+        headers.clear();
+        ASSERT_EQ(decoder.decode(block, &headers), HpackDecoder::Result::kOk);
+        ASSERT_EQ(headers.size(), sent.size());
+        for(size_t k = 0; k < sent.size(); ++k)
+        {
+            EXPECT_EQ(headers[k].name, sent[k].name);
+            EXPECT_EQ(headers[k].value, sent[k].value);
+        }
+        EXPECT_TRUE(headers[3].sensitive);
+        EXPECT_EQ(decoder.table().size(), encoder.table().size());
+    }
+    EXPECT_LE(decoder.table().maxSize(), 64u);
+
+    // 重复的头部直接命中动态表索引，只占一个字节
+    HpackEncoder repeat;
+    std::string first;
+    std::string second;
+    repeat.encode("user-agent", "kit-test/1.0", false, &first);
+    repeat.encode("user-agent", "kit-test/1.0", false, &second);
+    EXPECT_GT(first.size(), 1u);
+    EXPECT_EQ(second.size(), 1u);
+
+    // 非法输入
+    HpackDecoder bad;
+    headers.clear();
+    EXPECT_EQ(bad.decode(Unhex("80"), &headers), HpackDecoder::Result::kError);      // 索引0
+    EXPECT_EQ(bad.decode(Unhex("be"), &headers), HpackDecoder::Result::kError);      // 超出表
+    EXPECT_EQ(bad.decode(Unhex("3fe21f"), &headers), HpackDecoder::Result::kError);  // 表大小超过设置
+    EXPECT_EQ(bad.decode(Unhex("8220"), &headers), HpackDecoder::Result::kError);    // 表大小更新不在开头
+    EXPECT_EQ(bad.decode(Unhex("4185"), &headers), HpackDecoder::Result::kError);    // 字符串截断
+
+    // 头部列表超限: 返回 kTooLarge，但动态表仍被更新
+    HpackDecoder small(4096, 100);
+    HpackEncoder big_encoder;
+    block.clear();
+    big_encoder.encode(HpackHeaderList{{"x-a", std::string(40, 'a')}, {"x-b", std::string(40, 'b')}}, &block);
+    headers.clear();
+    EXPECT_EQ(small.decode(block, &headers), HpackDecoder::Result::kTooLarge);
+    EXPECT_EQ(small.table().count(), 2u);
+    block.clear();
+    big_encoder.encode(HpackHeaderList{{"x-b", std::string(40, 'b')}}, &block);
+    headers.clear();
+    ASSERT_EQ(small.decode(block, &headers), HpackDecoder::Result::kOk);
+    EXPECT_EQ(Find(headers, "x-b"), std::string(40, 'b'));
+}
+
+TEST(TestHttp2, FrameCodec)
+{
+    std::string out;
+    AppendHttp2Frame(&out, Http2FrameType::kData, Http2Flags::kEndStream, 0x80000003u, "abc");
+    ASSERT_EQ(out.size(), kHttp2FrameHeaderSize + 3);
+    Http2FrameHeader header = ParseHttp2FrameHeader(out.data());
+    EXPECT_EQ(header.length, 3u);
+    EXPECT_EQ(header.type, Http2FrameType::kData);
+    EXPECT_EQ(header.flags, Http2Flags::kEndStream);
+    // 保留位被忽略
+    EXPECT_EQ(header.streamId, 3u);
+
+    // 超过帧长上限的头部块拆为 HEADERS + CONTINUATION，只有最后一帧带 END_HEADERS
+    out.clear();
+    const std::string block(40000, 'h');
+    AppendHttp2Headers(&out, 5, block, true, kHttp2DefaultMaxFrameSize);
+    size_t pos = 0;
+    std::vector<Http2FrameHeader> frames;
+    std::string joined;
+    while(pos < out.size())
+    {
+        frames.push_back(ParseHttp2FrameHeader(out.data() + pos));
+        joined.append(out, pos + kHttp2FrameHeaderSize, frames.back().length);
+        pos += kHttp2FrameHeaderSize + frames.back().length;
+    }
+    ASSERT_EQ(frames.size(), 3u);
+    EXPECT_EQ(frames[0].type, Http2FrameType::kHeaders);
+    EXPECT_EQ(frames[0].flags, Http2Flags::kEndStream);
+    EXPECT_EQ(frames[1].type, Http2FrameType::kContinuation);
+    EXPECT_EQ(frames[1].flags, 0);
+    EXPECT_EQ(frames[2].flags, Http2Flags::kEndHeaders);
+    EXPECT_EQ(joined, block);
+
+    out.clear();
+    AppendHttp2GoAway(&out, 7, Http2ErrorCode::kProtocolError, "bad");
+    header = ParseHttp2FrameHeader(out.data());
+    EXPECT_EQ(header.type, Http2FrameType::kGoAway);
+    EXPECT_EQ(header.length, 11u);
+    EXPECT_STREQ(Http2ErrorCodeName(Http2ErrorCode::kFlowControlError), "FLOW_CONTROL_ERROR");
+}
+
+TEST(TestHttp2, PriorKnowledgeMultiplexesStreams)
+{
+    H2ServerFixture fixture(true, Http2Session::Config{});
+    if(0 == fixture.port)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable";
+    }
+    FdGuard fd(ConnectLoopback(fixture.port));
+    ASSERT_GE(fd.fd, 0);
+    H2Client client(fd.fd);
+    ASSERT_TRUE(client.preface());
+
+    // 一次写出多个流的请求，响应在同一连接上交错返回
+    std::string out;
+    std::vector<uint32_t> ids;
+    for(int i = 0; i < 20; ++i)
+    {
+        ids.push_back(client.build(&out, "GET", "/hello"));
+    }
+    const uint32_t big = client.build(&out, "GET", "/big");
+    const uint32_t echo = client.build(&out, "POST", "/echo?q=%E4%BD%A0%E5%A5%BD", std::string(60000, 'p'),
+                                      HpackHeaderList{{"cookie", "a=1"}, {"cookie", "b=2"}, {"content-length", "60000"}});
+    // 两个请求 Body 合计超过连接窗口，服务器需及时回补才不会判为流控错误
+    const uint32_t echo2 = client.build(&out, "POST", "/echo", std::string(60000, 'q'));
+    const uint32_t missing = client.build(&out, "GET", "/missing");
+    ASSERT_TRUE(client.send(out));
+
+    ASSERT_TRUE(client.pump([&]() {
+        for(uint32_t id : ids)
+        {
+            if(!client.streams[id].ended) return false;
+        }
+        return client.streams[big].ended && client.streams[echo].ended && client.streams[echo2].ended
+            && client.streams[missing].ended;
+    }));
+    EXPECT_TRUE(client.settingsAcked);
+    EXPECT_EQ(client.peerSettings[static_cast<uint16_t>(Http2Setting::kMaxConcurrentStreams)], 128u);
+
+    for(uint32_t id : ids)
+    {
+        const auto &resp = client.streams[id];
+        EXPECT_EQ(resp.status, 200);
+        EXPECT_EQ(resp.body, "hello h2");
+        EXPECT_EQ(Find(resp.headers, "x-version"), "HTTP/2");
+        EXPECT_EQ(Find(resp.headers, "x-host"), "h2.test");
+        EXPECT_EQ(Find(resp.headers, "content-length"), "8");
+        EXPECT_EQ(Find(resp.headers, "connection"), "<none>");
+    }
+    // 大响应按对端帧长拆成多个 DATA
+    EXPECT_EQ(client.streams[big].body.size(), 200000u);
+    EXPECT_GE(client.streams[big].dataFrames, 200000u / kHttp2DefaultMaxFrameSize);
+    EXPECT_EQ(client.streams[big].body.substr(26, 3), "abc");
+    EXPECT_EQ(client.streams[echo].body, std::string(60000, 'p'));
+    EXPECT_EQ(client.streams[echo2].body, std::string(60000, 'q'));
+    EXPECT_EQ(Find(client.streams[echo].headers, "x-query"), "你好");
+    EXPECT_EQ(Find(client.streams[echo].headers, "x-cookie"), "a=1; b=2");
+    EXPECT_EQ(client.streams[missing].status, 404);
+
+    // HEAD 只有头部(/hello 只注册了 GET，错误响应同样不带 Body)
+    const uint32_t head = client.request("HEAD", "/hello");
+    ASSERT_TRUE(client.waitEnded(head));
+    EXPECT_EQ(client.streams[head].status, 405);
+    EXPECT_TRUE(client.streams[head].body.empty());
+    EXPECT_EQ(client.streams[head].dataFrames, 0u);
+
+    // PING 原样回复
+    out.clear();
+    AppendHttp2Frame(&out, Http2FrameType::kPing, 0, 0, "12345678");
+    const uint32_t after_ping = client.build(&out, "GET", "/hello");
+    ASSERT_TRUE(client.send(out));
+    ASSERT_TRUE(client.waitEnded(after_ping));
+    EXPECT_EQ(client.goAway, -1);
+}
+
+TEST(TestHttp2, FlowControlAndConcurrencyLimit)
+{
+    Http2Session::Config config;
+    config.maxConcurrentStreams = 2;
+    // 业务在IO线程中同步处理，响应在本轮帧处理完后才发出，便于确定地触发并发上限
+    H2ServerFixture fixture(false, config);
+    if(0 == fixture.port)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable";
+    }
+    FdGuard fd(ConnectLoopback(fixture.port));
+    ASSERT_GE(fd.fd, 0);
+    H2Client client(fd.fd);
+    client.autoWindow = false;
+    ASSERT_TRUE(client.preface({{Http2Setting::kInitialWindowSize, 1000}}));
+
+    std::string out;
+    const uint32_t a = client.build(&out, "GET", "/big");
+    const uint32_t b = client.build(&out, "GET", "/hello");
+    const uint32_t refused = client.build(&out, "GET", "/hello");
+    ASSERT_TRUE(client.send(out));
+
+    // 流窗口只有 1000 字节
+    ASSERT_TRUE(client.pump([&]() {
+        return client.streams[refused].rst >= 0 && client.streams[b].ended && client.streams[a].body.size() >= 1000;
+    }));
+    EXPECT_EQ(client.streams[refused].rst, static_cast<int64_t>(Http2ErrorCode::kRefusedStream));
+    EXPECT_EQ(client.streams[b].body, "hello h2");
+    EXPECT_EQ(client.streams[a].status, 200);
+    EXPECT_EQ(client.streams[a].body.size(), 1000u);
+    EXPECT_FALSE(client.streams[a].ended);
+
+    // 放大流窗口后剩余数据受连接窗口(65535)限制
+    out.clear();
+    AppendHttp2WindowUpdate(&out, a, 500000);
+    ASSERT_TRUE(client.send(out));
+    ASSERT_TRUE(client.pump([&]() { return client.streams[a].body.size() >= 65535 - 8; }));
+    EXPECT_EQ(client.streams[a].body.size(), 65535u - 8);
+
+    out.clear();
+    AppendHttp2WindowUpdate(&out, 0, 500000);
+    ASSERT_TRUE(client.send(out));
+    ASSERT_TRUE(client.waitEnded(a));
+    EXPECT_EQ(client.streams[a].body.size(), 200000u);
+
+    // 流窗口溢出是流错误
+    out.clear();
+    const uint32_t c = client.build(&out, "GET", "/big");
+    AppendHttp2WindowUpdate(&out, c, 0x7fffffff);
+    ASSERT_TRUE(client.send(out));
+    ASSERT_TRUE(client.waitEnded(c));
+    EXPECT_EQ(client.streams[c].rst, static_cast<int64_t>(Http2ErrorCode::kFlowControlError));
+
+    // 连接窗口溢出是连接错误
+    out.clear();
+    AppendHttp2WindowUpdate(&out, 0, 0x7fffffff);
+    ASSERT_TRUE(client.send(out));
+    client.pump([&]() { return client.goAway >= 0; });
+    EXPECT_EQ(client.goAway, static_cast<int64_t>(Http2ErrorCode::kFlowControlError));
+}
+
+TEST(TestHttp2, UpgradeFromHttp11)
+{
+    H2ServerFixture fixture(true, Http2Session::Config{});
+    if(0 == fixture.port)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable";
+    }
+    FdGuard fd(ConnectLoopback(fixture.port));
+    ASSERT_GE(fd.fd, 0);
+
+    // HTTP2-Settings: MAX_CONCURRENT_STREAMS=100, INITIAL_WINDOW_SIZE=65535 (base64url)
+    const std::string upgrade = "GET /hello HTTP/1.1\r\nHost: up.test\r\nConnection: Upgrade, HTTP2-Settings\r\n"
+                                "Upgrade: h2c\r\nHTTP2-Settings: AAMAAABkAAQAAP__\r\n\r\n";
+    ASSERT_EQ(::send(fd.fd, upgrade.data(), upgrade.size(), 0), static_cast<ssize_t>(upgrade.size()));
+    std::string head;
+    char c;
+    while(head.find("\r\n\r\n") == std::string::npos && ::recv(fd.fd, &c, 1, 0) == 1)
+    {
+        head.push_back(c);
+    }
+    EXPECT_EQ(head.rfind("HTTP/1.1 101 Switching Protocols\r\n", 0), 0u) << head;
+    EXPECT_NE(head.find("Upgrade: h2c\r\n"), std::string::npos);
+
+    H2Client client(fd.fd);
+    ASSERT_TRUE(client.preface());
+    // 升级的请求以流1响应，客户端的新流从3开始
+    ASSERT_TRUE(client.waitEnded(1));
+    EXPECT_EQ(client.streams[1].status, 200);
+    EXPECT_EQ(client.streams[1].body, "hello h2");
+    EXPECT_EQ(Find(client.streams[1].headers, "x-host"), "up.test");
+
+    std::string out;
+    HpackEncoder encoder;
+    std::string block;
+    encoder.encode(HpackHeaderList{{":method", "GET"}, {":scheme", "http"}, {":path", "/hello"}, {":authority", "up.test"}}, &block);
+    AppendHttp2Headers(&out, 3, block, true, kHttp2DefaultMaxFrameSize);
+    ASSERT_TRUE(client.send(out));
+    ASSERT_TRUE(client.waitEnded(3));
+    EXPECT_EQ(client.streams[3].body, "hello h2");
+
+    // 没有 HTTP2-Settings 的 h2c 升级被忽略，按 HTTP/1.1 响应
+    FdGuard plain(ConnectLoopback(fixture.port));
+    ASSERT_GE(plain.fd, 0);
+    const std::string no_settings = "GET /hello HTTP/1.1\r\nHost: up.test\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n";
+    ASSERT_GT(::send(plain.fd, no_settings.data(), no_settings.size(), 0), 0);
+    head.clear();
+    while(head.find("\r\n\r\n") == std::string::npos && ::recv(plain.fd, &c, 1, 0) == 1)
+    {
+        head.push_back(c);
+    }
+    EXPECT_EQ(head.rfind("HTTP/1.1 200 OK\r\n", 0), 0u) << head;
+}
+
+TEST(TestHttp2, ProtocolErrorsCloseOrResetStreams)
+{
+    H2ServerFixture fixture(false, Http2Session::Config{});
+    if(0 == fixture.port)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable";
+    }
+
+    // 前言之后的首帧不是 SETTINGS
+    {
+        FdGuard fd(ConnectLoopback(fixture.port));
+        ASSERT_GE(fd.fd, 0);
+        H2Client client(fd.fd);
+        std::string out(kHttp2ClientPreface);
+        AppendHttp2Frame(&out, Http2FrameType::kPing, 0, 0, "12345678");
+        ASSERT_TRUE(client.send(out));
+        client.pump([&]() { return client.goAway >= 0; });
+        EXPECT_EQ(client.goAway, static_cast<int64_t>(Http2ErrorCode::kProtocolError));
+    }
+
+    // 偶数流id
+    {
+        FdGuard fd(ConnectLoopback(fixture.port));
+        ASSERT_GE(fd.fd, 0);
+        H2Client client(fd.fd);
+        ASSERT_TRUE(client.preface());
+        std::string out;
+        AppendHttp2Headers(&out, 2, Unhex("828684"), true, kHttp2DefaultMaxFrameSize);
+        ASSERT_TRUE(client.send(out));
+        client.pump([&]() { return client.goAway >= 0; });
+        EXPECT_EQ(client.goAway, static_cast<int64_t>(Http2ErrorCode::kProtocolError));
+    }
+
+    // HPACK 解码失败是连接错误
+    {
+        FdGuard fd(ConnectLoopback(fixture.port));
+        ASSERT_GE(fd.fd, 0);
+        H2Client client(fd.fd);
+        ASSERT_TRUE(client.preface());
+        std::string out;
+        AppendHttp2Headers(&out, 1, Unhex("80"), true, kHttp2DefaultMaxFrameSize);
+        ASSERT_TRUE(client.send(out));
+        client.pump([&]() { return client.goAway >= 0; });
+        EXPECT_EQ(client.goAway, static_cast<int64_t>(Http2ErrorCode::kCompressionError));
+    }
+
+    // 缺少伪头部、含连接级头部、大写名称都是流错误，连接继续可用
+    {
+        FdGuard fd(ConnectLoopback(fixture.port));
+        ASSERT_GE(fd.fd, 0);
+        H2Client client(fd.fd);
+        ASSERT_TRUE(client.preface());
+        HpackEncoder encoder;
+        std::string out;
+        std::string block;
+        encoder.encode(HpackHeaderList{{":method", "GET"}, {":scheme", "http"}}, &block);
+        AppendHttp2Headers(&out, 1, block, true, kHttp2DefaultMaxFrameSize);
+        block.clear();
+        encoder.encode(HpackHeaderList{{":method", "GET"}, {":scheme", "http"}, {":path", "/hello"}, {"connection", "close"}}, &block);
+        AppendHttp2Headers(&out, 3, block, true, kHttp2DefaultMaxFrameSize);
+        block.clear();
+        encoder.encode(HpackHeaderList{{":method", "GET"}, {":scheme", "http"}, {":path", "/hello"}, {"X-Upper", "1"}}, &block);
+        AppendHttp2Headers(&out, 5, block, true, kHttp2DefaultMaxFrameSize);
+        // Content-Length 与实际 Body 不符
+        block.clear();
+        encoder.encode(HpackHeaderList{{":method", "POST"}, {":scheme", "http"}, {":path", "/echo"}, {"content-length", "10"}}, &block);
+        AppendHttp2Headers(&out, 7, block, false, kHttp2DefaultMaxFrameSize);
+        AppendHttp2Frame(&out, Http2FrameType::kData, Http2Flags::kEndStream, 7, "abc");
+        block.clear();
+        encoder.encode(HpackHeaderList{{":method", "GET"}, {":scheme", "http"}, {":path", "/hello"}}, &block);
+        AppendHttp2Headers(&out, 9, block, true, kHttp2DefaultMaxFrameSize);
+        ASSERT_TRUE(client.send(out));
+        ASSERT_TRUE(client.waitEnded(9));
+        for(uint32_t id : {1u, 3u, 5u, 7u})
+        {
+            EXPECT_EQ(client.streams[id].rst, static_cast<int64_t>(Http2ErrorCode::kProtocolError)) << id;
+        }
+        EXPECT_EQ(client.streams[9].body, "hello h2");
+        EXPECT_EQ(client.goAway, -1);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
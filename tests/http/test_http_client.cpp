@@ -0,0 +1,407 @@
+/**
+ * @file test_http_client.cpp
+ * @brief HttpClient 测试: keep-alive 复用、流水线、超时、连接失败、HEAD 与以关闭界定的响应
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 18:12:36
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_client.h"
+#include "net/http/http_server.h"
+#include "net/http/http_context.h"
+#include "net/http/http_response.h"
+#include "net/event_loop.h"
+#include "net/net_log.h"
+#include "base/event_loop_thread.h"
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+/// @brief 绑定到回环地址任意端口的监听套接字，不 accept 时连接停留在全连接队列
+struct LoopbackListener
+{
+    LoopbackListener()
+    {
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int32_t on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+           || ::listen(fd, 16) < 0
+           || ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0)
+        {
+            ::close(fd);
+            fd = -1;
+            return;
+        }
+        port = ::ntohs(addr.sin_port);
+    }
+
+    ~LoopbackListener()
+    {
+        if(fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+
+    int32_t fd{-1};
+    uint16_t port{0};
+};
+
+/// @brief 取一个当前没有监听的端口
+uint16_t UnusedPort()
+{
+    LoopbackListener listener;
+    return listener.port;
+}
+
+/// @brief 进程当前打开的 fd 数
+size_t OpenFdCount()
+{
+    size_t count = 0;
+    if(DIR *dir = ::opendir("/proc/self/fd"))
+    {
+        while(::readdir(dir))
+        {
+            ++count;
+        }
+        ::closedir(dir);
+    }
+    return count;
+}
+
+/**
+ * @brief 在独立线程中接受一个连接，收到完整请求头后回写预设报文并关闭
+ */
+class ScriptedServer
+{
+public:
+    explicit ScriptedServer(std::string reply)
+        :_reply(std::move(reply))
+    {
+        _thread = std::thread([this]() { run(); });
+    }
+
+    ~ScriptedServer()
+    {
+        _thread.join();
+    }
+
+    uint16_t port() const { return _listener.port; }
+
+private:
+    void run()
+    {
+        const int32_t fd = ::accept(_listener.fd, nullptr, nullptr);
+        if(fd < 0)
+        {
+            return;
+        }
+        timeval timeout{2, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        std::string request;
+        char buf[1024];
+        while(request.find("\r\n\r\n") == std::string::npos)
+        {
+            const ssize_t n = ::read(fd, buf, sizeof(buf));
+            if(n <= 0)
+            {
+                break;
+            }
+            request.append(buf, static_cast<size_t>(n));
+        }
+        ::write(fd, _reply.data(), _reply.size());
+        ::close(fd);
+    }
+
+private:
+    LoopbackListener _listener;
+    std::string _reply;
+    std::thread _thread;
+};
+
+/**
+ * @brief 服务端循环线程 + 客户端循环线程
+ */
+class HttpClientTest: public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        _clientLoop = _clientThread.startLoop();
+        _serverLoop = _serverThread.startLoop();
+        _port = UnusedPort();
+        ASSERT_NE(0, _port);
+
+        std::promise<void> started;
+        _serverLoop->runInLoop([this, &started]() {
+            _server = std::make_shared<HttpServer>(_serverLoop, InetAddress(_port, "127.0.0.1"), "http-client-test", false, TcpServer::KReusePort);
+            _server->setThreadNum(0);
+            _server->Get("/echo", [](TcpConnectionPtr conn, HttpContextPtr ctx) {
+                auto resp = ctx->response();
+                resp->setVersion(Version::kHttp11);
+                resp->setStateCode(StateCode::k200Ok);
+                resp->body().appendData(ctx->request()->path());
+            });
+            _server->Post("/post", [](TcpConnectionPtr conn, HttpContextPtr ctx) {
+                auto resp = ctx->response();
+                resp->setVersion(Version::kHttp11);
+                resp->setStateCode(StateCode::k200Ok);
+                const std::string_view body = ctx->request()->body().view();
+                resp->body().appendData(body.data(), body.size());
+            });
+            _server->start();
+            started.set_value();
+        });
+        started.get_future().wait();
+    }
+
+    void TearDown() override
+    {
+        // 客户端与服务端对象都在各自循环线程中销毁
+        std::promise<void> client_done;
+        _clientLoop->runInLoop([this, &client_done]() {
+            _client.reset();
+            client_done.set_value();
+        });
+        client_done.get_future().wait();
+
+        std::promise<void> server_done;
+        _serverLoop->runInLoop([this, &server_done]() {
+            _server.reset();
+            server_done.set_value();
+        });
+        server_done.get_future().wait();
+    }
+
+    HttpClient::Ptr makeClient(HttpClient::Config config)
+    {
+        _client = std::make_shared<HttpClient>(_clientLoop, config);
+        return _client;
+    }
+
+    HttpClient::Stats stats()
+    {
+        std::promise<HttpClient::Stats> promise;
+        _clientLoop->runInLoop([this, &promise]() { promise.set_value(_client->stats()); });
+        return promise.get_future().get();
+    }
+
+    InetAddress serverAddr() const { return InetAddress(_port, "127.0.0.1"); }
+
+protected:
+    EventLoopThread _clientThread{nullptr, "http_client_test"};
+    EventLoopThread _serverThread{nullptr, "http_client_server"};
+    EventLoop *_clientLoop{nullptr};
+    EventLoop *_serverLoop{nullptr};
+    uint16_t _port{0};
+    std::shared_ptr<HttpServer> _server;
+    HttpClient::Ptr _client;
+};
+
+}
+
+TEST(HttpClientSerialize, FillsHostUserAgentAndLength)
+{
+    HttpRequest req;
+    req.setMethod(HttpRequest::Method::kPost);
+    req.setPath("/submit?x=1");
+    req.body().appendData("abc");
+
+    const std::string wire = HttpClient::Serialize(req, "127.0.0.1:80", "kit");
+    EXPECT_EQ(0u, wire.find("POST /submit?x=1 HTTP/1.1\r\n"));
+    EXPECT_NE(std::string::npos, wire.find("Host: 127.0.0.1:80\r\n"));
+    EXPECT_NE(std::string::npos, wire.find("User-Agent: kit\r\n"));
+    EXPECT_NE(std::string::npos, wire.find("Content-Length: 3\r\n"));
+    EXPECT_EQ(wire.size() - 7, wire.find("\r\n\r\nabc"));
+
+    HttpRequest get;
+    get.setMethod(HttpRequest::Method::kGet);
+    get.setPath("/");
+    get.addHeader("Host", "example.com");
+    const std::string get_wire = HttpClient::Serialize(get, "127.0.0.1:80", "");
+    EXPECT_NE(std::string::npos, get_wire.find("Host: example.com\r\n"));
+    EXPECT_EQ(std::string::npos, get_wire.find("127.0.0.1:80"));
+    EXPECT_EQ(std::string::npos, get_wire.find("Content-Length"));
+    EXPECT_EQ(std::string::npos, get_wire.find("User-Agent"));
+}
+
+TEST_F(HttpClientTest, KeepAliveReusesOneConnection)
+{
+    HttpClient::Config config;
+    config.maxConnectionsPerHost = 1;
+    auto client = makeClient(config);
+
+    for(int i = 0; i < 10; ++i)
+    {
+        auto result = client->get(serverAddr(), "/echo").get();
+        ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+        EXPECT_EQ(200, result.response->stateCode()());
+        EXPECT_EQ("/echo", result.response->body().view());
+    }
+
+    HttpRequest req;
+    req.setMethod(HttpRequest::Method::kPost);
+    req.setPath("/post");
+    req.body().appendData(std::string(100000, 'p'));
+    auto result = client->request(serverAddr(), std::move(req)).get();
+    ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+    EXPECT_EQ(100000u, result.response->body().size());
+
+    const HttpClient::Stats stats = this->stats();
+    EXPECT_EQ(1u, stats.connects);
+    EXPECT_EQ(10u, stats.reusedRequests);
+    EXPECT_EQ(11u, stats.responses);
+    EXPECT_EQ(1u, stats.idleConnections);
+}
+
+TEST_F(HttpClientTest, ConnectionCloseReleasesSockets)
+{
+    auto client = makeClient(HttpClient::Config());
+    const size_t before = OpenFdCount();
+    for(int i = 0; i < 200; ++i)
+    {
+        HttpRequest req;
+        req.setMethod(HttpRequest::Method::kGet);
+        req.setPath("/echo");
+        req.addHeader("Connection", "close");
+        auto result = client->request(serverAddr(), std::move(req)).get();
+        ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+    }
+    // 关闭的连接在下一轮循环中销毁
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(200u, stats().connects);
+    EXPECT_LT(OpenFdCount(), before + 10);
+}
+
+TEST_F(HttpClientTest, PipelinedResponsesKeepRequestOrder)
+{
+    HttpClient::Config config;
+    config.maxConnectionsPerHost = 2;
+    config.pipelineDepth = 8;
+    auto client = makeClient(config);
+
+    constexpr int kRequests = 64;
+    std::vector<std::future<HttpClient::Result>> futures;
+    for(int i = 0; i < kRequests; ++i)
+    {
+        futures.push_back(client->get(serverAddr(), "/echo?i=" + std::to_string(i)));
+    }
+    for(int i = 0; i < kRequests; ++i)
+    {
+        auto result = futures[i].get();
+        ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+        EXPECT_EQ("/echo", result.response->body().view());
+    }
+
+    const HttpClient::Stats stats = this->stats();
+    EXPECT_LE(stats.connects, 2u);
+    EXPECT_EQ(static_cast<uint64_t>(kRequests), stats.responses);
+    EXPECT_EQ(0u, stats.failures);
+    EXPECT_EQ(0u, stats.inflight);
+}
+
+TEST_F(HttpClientTest, SilentServerTimesOut)
+{
+    // 连接停留在未被 accept 的队列里，请求永远得不到响应
+    LoopbackListener silent;
+    ASSERT_GE(silent.fd, 0);
+
+    HttpClient::Config config;
+    config.requestTimeoutMs = 200;
+    config.timerIntervalMs = 20;
+    auto client = makeClient(config);
+
+    const auto start = std::chrono::steady_clock::now();
+    auto result = client->get(InetAddress(silent.port, "127.0.0.1"), "/").get();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(HttpClient::kTimeout, result.error);
+    EXPECT_GE(elapsed, std::chrono::milliseconds(190));
+    EXPECT_LT(elapsed, std::chrono::seconds(2));
+    EXPECT_EQ(0u, stats().connections);
+}
+
+TEST_F(HttpClientTest, RefusedConnectFailsQueuedRequests)
+{
+    auto client = makeClient(HttpClient::Config());
+    const InetAddress closed(UnusedPort(), "127.0.0.1");
+
+    auto first = client->get(closed, "/a");
+    auto second = client->get(closed, "/b");
+    EXPECT_EQ(HttpClient::kConnectFailed, first.get().error);
+    EXPECT_EQ(HttpClient::kConnectFailed, second.get().error);
+    EXPECT_GE(stats().connectFailures, 1u);
+}
+
+TEST_F(HttpClientTest, HeadResponseHasNoBody)
+{
+    // 带 Content-Length 的 HEAD 响应后面紧跟下一条报文，不能被当作 Body
+    ScriptedServer server("HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\n");
+    auto client = makeClient(HttpClient::Config());
+
+    HttpRequest req;
+    req.setMethod(HttpRequest::Method::kHead);
+    req.setPath("/file");
+    auto result = client->request(InetAddress(server.port(), "127.0.0.1"), std::move(req)).get();
+    ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+    EXPECT_EQ(200, result.response->stateCode()());
+    EXPECT_EQ("5", result.response->header(HttpHeaderId::kContentLength));
+    EXPECT_EQ(0u, result.response->body().size());
+}
+
+TEST_F(HttpClientTest, CloseDelimitedResponse)
+{
+    ScriptedServer server("HTTP/1.1 200 OK\r\nConnection: close\r\n\r\nuntil the end");
+    auto client = makeClient(HttpClient::Config());
+
+    auto result = client->get(InetAddress(server.port(), "127.0.0.1"), "/").get();
+    ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+    EXPECT_EQ("until the end", result.response->body().view());
+}
+
+TEST_F(HttpClientTest, DestroyCancelsPendingRequests)
+{
+    LoopbackListener silent;
+    ASSERT_GE(silent.fd, 0);
+    auto client = makeClient(HttpClient::Config());
+
+    auto result = client->get(InetAddress(silent.port, "127.0.0.1"), "/");
+    client.reset();
+    std::promise<void> done;
+    _clientLoop->runInLoop([this, &done]() {
+        _client.reset();
+        done.set_value();
+    });
+    done.get_future().wait();
+    EXPECT_EQ(HttpClient::kCancelled, result.get().error);
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
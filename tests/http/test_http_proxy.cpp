@@ -0,0 +1,648 @@
+/**
+ * @file test_http_proxy.cpp
+ * @brief ProxyServlet 测试: 负载均衡、故障转移与健康检查、Body 流式转发、chunked 响应、502/504、流水线顺序
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 22:05:48
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/http_proxy.h"
+#include "net/http/http_client.h"
+#include "net/http/http_server.h"
+#include "net/http/http_context.h"
+#include "net/http/http_response.h"
+#include "net/http/http_middleware.h"
+#include "net/event_loop.h"
+#include "net/net_log.h"
+#include "base/event_loop_thread.h"
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+/// @brief 绑定到回环地址任意端口的监听套接字，不 accept 时连接停留在全连接队列
+struct LoopbackListener
+{
+    LoopbackListener()
+    {
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int32_t on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+           || ::listen(fd, 16) < 0
+           || ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0)
+        {
+            ::close(fd);
+            fd = -1;
+            return;
+        }
+        port = ::ntohs(addr.sin_port);
+    }
+
+    ~LoopbackListener()
+    {
+        if(fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+
+    int32_t fd{-1};
+    uint16_t port{0};
+};
+
+uint16_t UnusedPort()
+{
+    LoopbackListener listener;
+    return listener.port;
+}
+
+InetAddress Loopback(uint16_t port)
+{
+    return InetAddress(port, "127.0.0.1");
+}
+
+/**
+ * @brief 独立循环线程上的上游 HttpServer，响应中带上自己的名字
+ */
+class Upstream
+{
+public:
+    Upstream(const std::string &name, uint16_t port)
+        :_thread(nullptr, "proxy_upstream_" + name)
+        ,_port(port)
+    {
+        _loop = _thread.startLoop();
+        std::promise<void> started;
+        _loop->runInLoop([this, name, &started]() {
+            _server = std::make_shared<HttpServer>(_loop, Loopback(_port), "proxy-upstream-" + name, false, TcpServer::KReusePort);
+            _server->setThreadNum(0);
+            _server->Get("/who", [this, name](TcpConnectionPtr conn, HttpContextPtr ctx) {
+                ++hits;
+                auto resp = ctx->response();
+                resp->setVersion(Version::kHttp11);
+                resp->setStateCode(StateCode::k200Ok);
+                resp->headers().set("X-Upstream", name);
+                resp->headers().set("X-Seen-Forwarded-For", ctx->request()->header("X-Forwarded-For"));
+                resp->body().appendData(name + ":" + ctx->request()->path() + "?" + ctx->request()->query());
+            });
+            // 回显代理转发过来的部分请求头
+            _server->Get("/headers", [](TcpConnectionPtr conn, HttpContextPtr ctx) {
+                const HttpRequest &req = *ctx->request();
+                auto resp = ctx->response();
+                resp->setVersion(Version::kHttp11);
+                resp->setStateCode(StateCode::k200Ok);
+                resp->body().appendData("secret=" + std::string(req.header("X-Secret"))
+                                        + ";public=" + std::string(req.header("X-Public"))
+                                        + ";proxy-auth=" + std::string(req.header("Proxy-Authorization")));
+            });
+            _server->Post("/upload", [](TcpConnectionPtr conn, HttpContextPtr ctx) {
+                const std::string_view body = ctx->request()->body().view();
+                uint64_t sum = 0;
+                for(unsigned char c : body)
+                {
+                    sum += c;
+                }
+                auto resp = ctx->response();
+                resp->setVersion(Version::kHttp11);
+                resp->setStateCode(StateCode::k200Ok);
+                resp->body().appendData(std::to_string(body.size()) + ":" + std::to_string(sum));
+            });
+            // 延迟 300ms 才响应，用来制造在途请求
+            _server->Get("/slow", [this, name](TcpConnectionPtr conn, HttpContextPtr ctx) {
+                ctx->response()->setDeferred(true);
+                _loop->runAfter(300, [conn, name]() {
+                    conn->send("HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(name.size()) + "\r\n\r\n" + name);
+                });
+            });
+            _server->start();
+            started.set_value();
+        });
+        started.get_future().wait();
+    }
+
+    ~Upstream()
+    {
+        std::promise<void> done;
+        _loop->runInLoop([this, &done]() {
+            _server.reset();
+            done.set_value();
+        });
+        done.get_future().wait();
+    }
+
+    uint16_t port() const { return _port; }
+    InetAddress addr() const { return Loopback(_port); }
+
+    std::atomic_int hits{0};
+
+private:
+    EventLoopThread _thread;
+    EventLoop *_loop{nullptr};
+    uint16_t _port;
+    std::shared_ptr<HttpServer> _server;
+};
+
+/**
+ * @brief 在独立线程中接受一个连接，收到完整请求头后回写预设报文并关闭
+ */
+class ScriptedUpstream
+{
+public:
+    explicit ScriptedUpstream(std::string reply)
+        :_reply(std::move(reply))
+    {
+        _thread = std::thread([this]() { run(); });
+    }
+
+    ~ScriptedUpstream()
+    {
+        _thread.join();
+    }
+
+    uint16_t port() const { return _listener.port; }
+
+private:
+    void run()
+    {
+        const int32_t fd = ::accept(_listener.fd, nullptr, nullptr);
+        if(fd < 0)
+        {
+            return;
+        }
+        timeval timeout{2, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        std::string request;
+        char buf[1024];
+        while(request.find("\r\n\r\n") == std::string::npos)
+        {
+            const ssize_t n = ::read(fd, buf, sizeof(buf));
+            if(n <= 0)
+            {
+                break;
+            }
+            request.append(buf, static_cast<size_t>(n));
+        }
+        ::write(fd, _reply.data(), _reply.size());
+        ::close(fd);
+    }
+
+private:
+    LoopbackListener _listener;
+    std::string _reply;
+    std::thread _thread;
+};
+
+/**
+ * @brief 代理服务端(2 个 IO 线程) + 客户端循环线程
+ */
+class HttpProxyTest: public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        _clientLoop = _clientThread.startLoop();
+        _proxyLoop = _proxyThread.startLoop();
+        _port = UnusedPort();
+        ASSERT_NE(0, _port);
+    }
+
+    void TearDown() override
+    {
+        std::promise<void> client_done;
+        _clientLoop->runInLoop([this, &client_done]() {
+            _client.reset();
+            client_done.set_value();
+        });
+        client_done.get_future().wait();
+        // TcpServer 析构时 IO 线程上不能还有连接在走关闭流程，等下游断开全部处理完
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        // servlet 需在代理的 IO 线程退出前销毁
+        std::promise<void> server_done;
+        _proxyLoop->runInLoop([this, &server_done]() {
+            _proxy.reset();
+            _server.reset();
+            server_done.set_value();
+        });
+        server_done.get_future().wait();
+    }
+
+    void startProxy(const std::vector<InetAddress> &upstreams, ProxyServlet::Config config, bool isPool = false)
+    {
+        _proxy = std::make_shared<ProxyServlet>(upstreams, config);
+        std::promise<void> started;
+        _proxyLoop->runInLoop([this, isPool, &started]() {
+            _server = std::make_shared<HttpServer>(_proxyLoop, Loopback(_port), "proxy-test", isPool, TcpServer::KReusePort);
+            _server->setThreadNum(2);
+            // 记录转发时代理侧请求对象中的Body大小，应当始终为0
+            _server->use(std::make_shared<FunctionMiddleware>("body-probe", [this](const TcpConnectionPtr&, const HttpContextPtr &ctx) {
+                _proxiedBodyBytes += ctx->request()->body().size();
+                return HttpMiddleware::Action::kContinue;
+            }));
+            _server->addRoute(ExpectHttpMethods::All, "/*", _proxy);
+            _server->start();
+            started.set_value();
+        });
+        started.get_future().wait();
+
+        HttpClient::Config client_config;
+        client_config.maxConnectionsPerHost = 1;
+        client_config.pipelineDepth = 4;
+        _client = std::make_shared<HttpClient>(_clientLoop, client_config);
+    }
+
+    HttpClient::Result get(const std::string &path)
+    {
+        return _client->get(Loopback(_port), path).get();
+    }
+
+protected:
+    EventLoopThread _clientThread{nullptr, "proxy_test_client"};
+    EventLoopThread _proxyThread{nullptr, "proxy_test_server"};
+    EventLoop *_clientLoop{nullptr};
+    EventLoop *_proxyLoop{nullptr};
+    uint16_t _port{0};
+    ProxyServlet::Ptr _proxy;
+    std::shared_ptr<HttpServer> _server;
+    HttpClient::Ptr _client;
+    std::atomic<uint64_t> _proxiedBodyBytes{0};
+};
+
+std::string BodyOf(const HttpClient::Result &result)
+{
+    return result.ok() ? std::string(result.response->body().view()) : std::string();
+}
+
+}
+
+TEST_F(HttpProxyTest, RoundRobinSpreadsAndReusesConnections)
+{
+    Upstream a("a", UnusedPort());
+    Upstream b("b", UnusedPort());
+    startProxy({a.addr(), b.addr()}, ProxyServlet::Config());
+
+    std::map<std::string, int> served;
+    for(int i = 0; i < 10; ++i)
+    {
+        auto result = get("/who?i=" + std::to_string(i));
+        ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+        ASSERT_EQ(200, result.response->stateCode()());
+        const std::string body = BodyOf(result);
+        EXPECT_EQ("?i=" + std::to_string(i), body.substr(body.find('?')));
+        ++served[std::string(result.response->header("X-Upstream"))];
+        EXPECT_EQ("127.0.0.1", result.response->header("X-Seen-Forwarded-For"));
+    }
+    EXPECT_EQ(5, served["a"]);
+    EXPECT_EQ(5, served["b"]);
+
+    // 同一下游连接始终落在同一 IO 线程，每个上游只需建一条连接
+    const ProxyServlet::Stats stats = _proxy->stats();
+    EXPECT_EQ(10u, stats.responses);
+    EXPECT_EQ(2u, stats.connects);
+    EXPECT_EQ(8u, stats.reused);
+}
+
+TEST_F(HttpProxyTest, LeastConnectionsAvoidsBusyUpstream)
+{
+    Upstream a("a", UnusedPort());
+    Upstream b("b", UnusedPort());
+    ProxyServlet::Config config;
+    config.balance = ProxyServlet::Balance::kLeastConnections;
+    startProxy({a.addr(), b.addr()}, config);
+
+    // 慢请求走单独的客户端连接，占住一个上游
+    auto slow_client = std::make_shared<HttpClient>(_clientLoop);
+    std::future<HttpClient::Result> slow = slow_client->get(Loopback(_port), "/slow");
+    for(int i = 0; i < 100 && 0 == _proxy->upstreamStats()[0].active + _proxy->upstreamStats()[1].active; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    const auto upstreams = _proxy->upstreamStats();
+    ASSERT_EQ(1, upstreams[0].active + upstreams[1].active);
+    const std::string busy = 1 == upstreams[0].active ? "a" : "b";
+
+    for(int i = 0; i < 4; ++i)
+    {
+        auto result = get("/who");
+        ASSERT_TRUE(result.ok());
+        EXPECT_NE(busy, result.response->header("X-Upstream"));
+    }
+    auto slow_result = slow.get();
+    ASSERT_TRUE(slow_result.ok());
+    EXPECT_EQ(busy, BodyOf(slow_result));
+
+    std::promise<void> done;
+    _clientLoop->runInLoop([&]() {
+        slow_client.reset();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
+TEST_F(HttpProxyTest, DeadUpstreamFailsOverAndIsMarkedUnhealthy)
+{
+    Upstream a("a", UnusedPort());
+    ProxyServlet::Config config;
+    config.unhealthyThreshold = 2;
+    startProxy({Loopback(UnusedPort()), a.addr()}, config);
+
+    for(int i = 0; i < 6; ++i)
+    {
+        auto result = get("/who");
+        ASSERT_TRUE(result.ok());
+        ASSERT_EQ(200, result.response->stateCode()());
+        EXPECT_EQ("a", result.response->header("X-Upstream"));
+    }
+    const auto upstreams = _proxy->upstreamStats();
+    EXPECT_FALSE(upstreams[0].healthy);
+    // 标记为不健康后不再尝试
+    EXPECT_EQ(2u, upstreams[0].failures);
+    EXPECT_TRUE(upstreams[1].healthy);
+    EXPECT_EQ(0u, _proxy->stats().badGateway);
+}
+
+TEST_F(HttpProxyTest, HealthCheckTracksUpstreamState)
+{
+    Upstream a("a", UnusedPort());
+    const uint16_t later_port = UnusedPort();
+    ProxyServlet::Config config;
+    config.unhealthyThreshold = 1;
+    config.healthCheckPath = "/who";
+    config.healthCheckIntervalMs = 50;
+    startProxy({a.addr(), Loopback(later_port)}, config);
+    _proxy->startHealthCheck(_proxyLoop);
+
+    auto wait_health = [this](size_t idx, bool healthy) {
+        for(int i = 0; i < 200 && _proxy->upstreamStats()[idx].healthy != healthy; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return _proxy->upstreamStats()[idx].healthy == healthy;
+    };
+    ASSERT_TRUE(wait_health(1, false));
+    EXPECT_TRUE(_proxy->upstreamStats()[0].healthy);
+
+    // 不健康的上游不参与轮转
+    for(int i = 0; i < 4; ++i)
+    {
+        auto result = get("/who");
+        ASSERT_TRUE(result.ok());
+        EXPECT_EQ("a", result.response->header("X-Upstream"));
+    }
+
+    Upstream b("b", later_port);
+    ASSERT_TRUE(wait_health(1, true));
+
+    std::promise<void> stopped;
+    _proxyLoop->runInLoop([&]() {
+        _proxy->stopHealthCheck();
+        stopped.set_value();
+    });
+    stopped.get_future().wait();
+}
+
+TEST_F(HttpProxyTest, StreamsLargeRequestBodyWithoutBuffering)
+{
+    Upstream a("a", UnusedPort());
+    ProxyServlet::Config config;
+    config.highWaterMark = 64 * 1024;
+    startProxy({a.addr()}, config);
+
+    const size_t size = 4 * 1024 * 1024;
+    HttpRequest req;
+    req.setMethod(HttpRequest::Method::kPost);
+    req.setPath("/upload");
+    std::string body(size, '\0');
+    uint64_t sum = 0;
+    for(size_t i = 0; i < size; ++i)
+    {
+        body[i] = static_cast<char>(i * 131 % 251);
+        sum += static_cast<unsigned char>(body[i]);
+    }
+    req.body().appendData(body.data(), body.size());
+
+    auto result = _client->request(Loopback(_port), std::move(req)).get();
+    ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+    ASSERT_EQ(200, result.response->stateCode()());
+    EXPECT_EQ(std::to_string(size) + ":" + std::to_string(sum), BodyOf(result));
+    EXPECT_EQ(0u, _proxiedBodyBytes.load());
+}
+
+TEST_F(HttpProxyTest, RelaysChunkedResponse)
+{
+    ScriptedUpstream upstream("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\nConnection: close\r\n\r\n"
+                              "5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n");
+    startProxy({Loopback(upstream.port())}, ProxyServlet::Config());
+
+    auto result = get("/stream");
+    ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+    EXPECT_EQ(200, result.response->stateCode()());
+    EXPECT_EQ("hello world", BodyOf(result));
+    EXPECT_EQ("chunked", result.response->header("Transfer-Encoding"));
+    EXPECT_EQ(1u, _proxy->stats().connects);
+}
+
+TEST_F(HttpProxyTest, RelaysCloseDelimitedResponse)
+{
+    ScriptedUpstream upstream("HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\n\r\nuntil close");
+    startProxy({Loopback(upstream.port())}, ProxyServlet::Config());
+
+    auto result = get("/legacy");
+    ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+    EXPECT_EQ("until close", BodyOf(result));
+    // 下游仍可 keep-alive，Body 改为 chunked
+    EXPECT_EQ("chunked", result.response->header("Transfer-Encoding"));
+}
+
+TEST_F(HttpProxyTest, StripsHeadersListedInConnection)
+{
+    Upstream a("a", UnusedPort());
+    startProxy({a.addr()}, ProxyServlet::Config());
+
+    // 上行: Connection 中列出的 X-Secret 与 Proxy-Authorization 不转发给上游
+    HttpRequest req;
+    req.setMethod(HttpRequest::Method::kGet);
+    req.setPath("/headers");
+    req.headers().set("Connection", "keep-alive, X-Secret");
+    req.headers().set("X-Secret", "s3cr3t");
+    req.headers().set("X-Public", "visible");
+    req.headers().set("Proxy-Authorization", "Basic dXNlcjpwYXNz");
+    auto result = _client->request(Loopback(_port), std::move(req)).get();
+    ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+    EXPECT_EQ("secret=;public=visible;proxy-auth=", BodyOf(result));
+}
+
+TEST_F(HttpProxyTest, StripsResponseHeadersListedInConnection)
+{
+    // 下行: 上游 Connection 中列出的 X-Private 与 Proxy-Authenticate 不返回给客户端
+    ScriptedUpstream upstream("HTTP/1.1 200 OK\r\nConnection: close, X-Private\r\nX-Private: internal\r\n"
+                              "X-Public: visible\r\nProxy-Authenticate: Basic\r\nContent-Length: 2\r\n\r\nok");
+    startProxy({Loopback(upstream.port())}, ProxyServlet::Config());
+
+    auto result = get("/private");
+    ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+    EXPECT_EQ("ok", BodyOf(result));
+    EXPECT_EQ("visible", result.response->header("X-Public"));
+    EXPECT_FALSE(result.response->headers().has("X-Private"));
+    EXPECT_FALSE(result.response->headers().has("Proxy-Authenticate"));
+    // 下游连接的 Connection 由代理自己决定
+    EXPECT_EQ("keep-alive", result.response->header("Connection"));
+}
+
+TEST_F(HttpProxyTest, NoUpstreamReturnsBadGateway)
+{
+    startProxy({Loopback(UnusedPort())}, ProxyServlet::Config());
+
+    auto result = get("/who");
+    ASSERT_TRUE(result.ok());
+    EXPECT_EQ(502, result.response->stateCode()());
+    EXPECT_EQ(1u, _proxy->stats().badGateway);
+
+    // 同一下游连接仍可继续使用
+    auto again = get("/who");
+    ASSERT_TRUE(again.ok());
+    EXPECT_EQ(502, again.response->stateCode()());
+}
+
+TEST_F(HttpProxyTest, SilentUpstreamReturnsGatewayTimeout)
+{
+    LoopbackListener silent;
+    ASSERT_NE(0, silent.port);
+    ProxyServlet::Config config;
+    config.ioTimeoutMs = 200;
+    config.timerIntervalMs = 20;
+    startProxy({Loopback(silent.port)}, config);
+
+    auto result = get("/who");
+    ASSERT_TRUE(result.ok());
+    EXPECT_EQ(504, result.response->stateCode()());
+    EXPECT_EQ(1u, _proxy->stats().gatewayTimeout);
+}
+
+TEST_F(HttpProxyTest, PipelinedResponsesKeepRequestOrder)
+{
+    Upstream a("a", UnusedPort());
+    Upstream b("b", UnusedPort());
+    startProxy({a.addr(), b.addr()}, ProxyServlet::Config());
+
+    // 单连接流水线: 慢请求在前，后面的响应不能越过它
+    std::vector<std::future<HttpClient::Result>> results;
+    results.push_back(_client->get(Loopback(_port), "/slow"));
+    for(int i = 0; i < 3; ++i)
+    {
+        results.push_back(_client->get(Loopback(_port), "/who?i=" + std::to_string(i)));
+    }
+    auto slow = results[0].get();
+    ASSERT_TRUE(slow.ok());
+    const std::string slow_body = BodyOf(slow);
+    EXPECT_TRUE("a" == slow_body || "b" == slow_body);
+    for(int i = 0; i < 3; ++i)
+    {
+        auto result = results[i + 1].get();
+        ASSERT_TRUE(result.ok());
+        const std::string body = BodyOf(result);
+        EXPECT_EQ("?i=" + std::to_string(i), body.substr(body.find('?')));
+    }
+}
+
+TEST_F(HttpProxyTest, PooledPipelineKeepsOrderAcrossGetAndPost)
+{
+    Upstream a("a", UnusedPort());
+    startProxy({a.addr()}, ProxyServlet::Config(), true);
+    // 业务线程中拖慢带 delay 的请求，让后面的请求先被分发
+    _server->use(std::make_shared<FunctionMiddleware>("delay", [](const TcpConnectionPtr&, const HttpContextPtr &ctx) {
+        if(ctx->request()->query().find("delay") != std::string::npos)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        return HttpMiddleware::Action::kContinue;
+    }));
+
+    auto upload = [this](const std::string &body) {
+        HttpRequest req;
+        req.setMethod(HttpRequest::Method::kPost);
+        req.setPath("/upload");
+        req.body().appendData(body.data(), body.size());
+        return _client->request(Loopback(_port), std::move(req));
+    };
+
+    // 同一连接上: 没有Body的慢请求、POST、再一个没有Body的慢请求、普通 GET
+    std::vector<std::future<HttpClient::Result>> results;
+    results.push_back(_client->get(Loopback(_port), "/who?i=0&delay"));
+    results.push_back(upload("abc"));
+    results.push_back(_client->get(Loopback(_port), "/who?i=1&delay"));
+    results.push_back(_client->get(Loopback(_port), "/who?i=2"));
+
+    auto first = results[0].get();
+    ASSERT_TRUE(first.ok()) << HttpClient::ErrorString(first.error);
+    EXPECT_EQ("a:/who?i=0&delay", BodyOf(first));
+    auto posted = results[1].get();
+    ASSERT_TRUE(posted.ok()) << HttpClient::ErrorString(posted.error);
+    EXPECT_EQ("3:" + std::to_string('a' + 'b' + 'c'), BodyOf(posted));
+    auto second = results[2].get();
+    ASSERT_TRUE(second.ok()) << HttpClient::ErrorString(second.error);
+    EXPECT_EQ("a:/who?i=1&delay", BodyOf(second));
+    auto third = results[3].get();
+    ASSERT_TRUE(third.ok()) << HttpClient::ErrorString(third.error);
+    EXPECT_EQ("a:/who?i=2", BodyOf(third));
+}
+
+TEST_F(HttpProxyTest, RejectedRequestReleasesPipelineSlot)
+{
+    Upstream a("a", UnusedPort());
+    startProxy({a.addr()}, ProxyServlet::Config(), true);
+    _server->use(std::make_shared<FunctionMiddleware>("deny", [](const TcpConnectionPtr&, const HttpContextPtr &ctx) {
+        if(ctx->request()->query().find("deny") == std::string::npos)
+        {
+            return HttpMiddleware::Action::kContinue;
+        }
+        auto resp = ctx->response();
+        resp->setVersion(Version::kHttp11);
+        resp->setStateCode(StateCode::k403Forbidden);
+        resp->body().appendData("denied");
+        return HttpMiddleware::Action::kRespond;
+    }));
+
+    // 被中间件拒绝的请求不转发，也不能占住连接上的转发队列
+    auto denied = _client->get(Loopback(_port), "/who?deny");
+    auto allowed = _client->get(Loopback(_port), "/who?i=0");
+    auto result = denied.get();
+    ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+    EXPECT_EQ(403, result.response->stateCode()());
+    result = allowed.get();
+    ASSERT_TRUE(result.ok()) << HttpClient::ErrorString(result.error);
+    EXPECT_EQ("a:/who?i=0", BodyOf(result));
+    EXPECT_EQ(1, a.hits.load());
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -13,14 +13,22 @@
 #include "net/http/http_context.h"
 #include "net/http/http_request.h"
 #include "net/http/http_response.h"
+#include "net/http/http_response_cache.h"
 #include "net/http/http_servlet.h"
 #include "net/http/http_util.h"
 #include "net/inet_address.h"
 #include "net/tcp_connection.h"
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
 #include <memory>
 #include <regex>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace kit_muduo;
 using namespace kit_muduo::http;
@@ -68,6 +76,23 @@ HttpServlet::Ptr Servlet(const std::string &body)
     return std::make_shared<TextServlet>(body);
 }
 
+/// @brief 析构时执行回调的servlet
+class DestructorHookServlet : public HttpServlet
+{
+public:
+    explicit DestructorHookServlet(std::function<void()> onDestroy)
+        :HttpServlet("DestructorHookServlet")
+        ,on_destroy_(std::move(onDestroy))
+    {}
+
+    ~DestructorHookServlet() override { on_destroy_(); }
+
+    void handle(TcpConnectionPtr conn, HttpContextPtr ctx) override {}
+
+private:
+    std::function<void()> on_destroy_;
+};
+
 } // namespace
 
 TEST(TestRouter, regex)
@@ -501,6 +526,561 @@ TEST(TestRouter, ListRoutes_AfterRemoveByIdDoesNotAppear)
     ASSERT_EQ(routes[0].pattern, "/keep");
 }
 
+// ==================================================================
+// 路由快照(RCU)测试
+// ==================================================================
+
+TEST(TestRouter, ConcurrentDispatchWhileRoutesChange)
+{
+    DispatchFixture f;
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/stable", Servlet("stable")).ok());
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/user/:id", Servlet("user")).ok());
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> failures{0};
+    std::vector<std::thread> readers;
+    for(int i = 0; i < 4; ++i)
+    {
+        readers.emplace_back([&f, &stop, &failures]() {
+            while(!stop.load(std::memory_order_relaxed))
+            {
+                auto stable = f.Request("/stable", HttpRequest::Method::kGet);
+                auto user = f.Request("/user/7", HttpRequest::Method::kGet);
+                if(stable->body().toString() != "stable" || user->body().toString() != "user")
+                {
+                    failures.fetch_add(1);
+                }
+                // 临时路由可能存在也可能不存在，但结果必须是完整的 200 或 404
+                auto temp = f.Request("/temp", HttpRequest::Method::kGet);
+                int code = temp->stateCode().toInt();
+                if(code != StateCode::k200Ok && code != StateCode::k404NotFound)
+                {
+                    failures.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    for(int i = 0; i < 500; ++i)
+    {
+        auto r = f.dispatch.addRoute(ExpectHttpMethods::Get, "/temp", Servlet("temp"));
+        ASSERT_TRUE(r.ok());
+        ASSERT_TRUE(f.dispatch.removeRoute(r.route_id));
+    }
+
+    stop.store(true);
+    for(auto &t : readers)
+    {
+        t.join();
+    }
+
+    ASSERT_EQ(failures.load(), 0);
+    ASSERT_EQ(f.dispatch.listRoutes().size(), 2u);
+}
+
+TEST(TestRouter, RemovedServletIsReleasedAfterSnapshotSwap)
+{
+    DispatchFixture f;
+    auto servlet = Servlet("once");
+    std::weak_ptr<HttpServlet> weak = servlet;
+
+    auto r = f.dispatch.addRoute(ExpectHttpMethods::Get, "/once", std::move(servlet));
+    ASSERT_TRUE(r.ok());
+    ASSERT_EQ(f.Request("/once", HttpRequest::Method::kGet)->stateCode().toInt(), StateCode::k200Ok);
+
+    ASSERT_TRUE(f.dispatch.removeRoute(r.route_id));
+    // 没有分发在进行时旧快照在发布新快照时即被回收
+    ASSERT_TRUE(weak.expired());
+    ASSERT_EQ(f.Request("/once", HttpRequest::Method::kGet)->stateCode().toInt(), StateCode::k404NotFound);
+}
+
+TEST(TestRouter, RemovedServletIsReleasedWhileReaderThreadIdles)
+{
+    DispatchFixture f;
+    auto servlet = Servlet("idle");
+    std::weak_ptr<HttpServlet> weak = servlet;
+    auto r = f.dispatch.addRoute(ExpectHttpMethods::Get, "/idle", std::move(servlet));
+    ASSERT_TRUE(r.ok());
+
+    // 另一线程分发一次后保持空闲，不再分发
+    std::promise<void> dispatched;
+    std::promise<void> quit;
+    std::thread reader([&]() {
+        EXPECT_EQ(f.Request("/idle", HttpRequest::Method::kGet)->stateCode().toInt(), StateCode::k200Ok);
+        dispatched.set_value();
+        quit.get_future().wait();
+    });
+    dispatched.get_future().wait();
+
+    // 其他实例在同一线程上的分发不影响本实例的回收
+    HttpServletDispatch other;
+    ASSERT_TRUE(other.addRoute(ExpectHttpMethods::Get, "/other", Servlet("other")).ok());
+    auto ctx = std::make_shared<HttpContext>();
+    ctx->request()->setPath("/other");
+    ctx->request()->setMethod(HttpRequest::Method::kGet);
+    other.handle(f.conn, ctx);
+    ASSERT_EQ(ctx->response()->body().toString(), "other");
+
+    ASSERT_TRUE(f.dispatch.removeRoute(r.route_id));
+    EXPECT_TRUE(weak.expired());
+
+    quit.set_value();
+    reader.join();
+}
+
+TEST(TestRouter, RemovedServletIsReleasedWhenInFlightDispatchEnds)
+{
+    DispatchFixture f;
+    std::promise<void> entered;
+    std::promise<void> resume;
+    std::shared_future<void> resume_future = resume.get_future().share();
+    auto servlet = std::make_shared<FunctionServlet>([&entered, resume_future](TcpConnectionPtr, HttpContextPtr ctx) {
+        entered.set_value();
+        resume_future.wait();
+        ctx->response()->setVersion(Version::kHttp11);
+        ctx->response()->setStateCode(StateCode::k200Ok);
+    });
+    std::weak_ptr<HttpServlet> weak = servlet;
+    auto r = f.dispatch.addRoute(ExpectHttpMethods::Get, "/slow", std::move(servlet));
+    ASSERT_TRUE(r.ok());
+
+    std::thread reader([&]() {
+        EXPECT_EQ(f.Request("/slow", HttpRequest::Method::kGet)->stateCode().toInt(), StateCode::k200Ok);
+    });
+    entered.get_future().wait();
+
+    // 分发仍在使用旧快照，删除后不能立即回收
+    ASSERT_TRUE(f.dispatch.removeRoute(r.route_id));
+    EXPECT_FALSE(weak.expired());
+
+    // 分发结束时由读者补做回收，无需再次分发
+    resume.set_value();
+    reader.join();
+    EXPECT_TRUE(weak.expired());
+}
+
+TEST(TestRouter, RemovedServletIsReleasedWhenLastReaderExitsDuringWrite)
+{
+    DispatchFixture f;
+    std::promise<void> entered;
+    std::promise<void> resume;
+    std::shared_future<void> resume_future = resume.get_future().share();
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/slow",
+        std::make_shared<FunctionServlet>([&entered, resume_future](TcpConnectionPtr, HttpContextPtr ctx) {
+            entered.set_value();
+            resume_future.wait();
+            ctx->response()->setVersion(Version::kHttp11);
+            ctx->response()->setStateCode(StateCode::k200Ok);
+        })).ok());
+    auto held = Servlet("held");
+    std::weak_ptr<HttpServlet> weak_held = held;
+    auto held_route = f.dispatch.addRoute(ExpectHttpMethods::Get, "/held", std::move(held));
+    ASSERT_TRUE(held_route.ok());
+
+    // 读者停在持有 /held 的快照上
+    std::thread reader([&]() {
+        EXPECT_EQ(f.Request("/slow", HttpRequest::Method::kGet)->stateCode().toInt(), StateCode::k200Ok);
+    });
+    entered.get_future().wait();
+    ASSERT_TRUE(f.dispatch.removeRoute(held_route.route_id));
+    EXPECT_FALSE(weak_held.expired());
+
+    // 写者回收另一张快照时在锁内析构servlet，借此让写者持锁停住
+    std::promise<void> in_destructor;
+    std::promise<void> finish_destructor;
+    std::shared_future<void> finish_future = finish_destructor.get_future().share();
+    auto blocking = std::make_shared<DestructorHookServlet>([&in_destructor, finish_future]() {
+        in_destructor.set_value();
+        finish_future.wait();
+    });
+    auto blocking_route = f.dispatch.addRoute(ExpectHttpMethods::Get, "/blocking", std::move(blocking));
+    ASSERT_TRUE(blocking_route.ok());
+    std::thread writer([&]() { EXPECT_TRUE(f.dispatch.removeRoute(blocking_route.route_id)); });
+    in_destructor.get_future().wait();
+
+    // 最后一个读者在写者持锁时离开，拿不到锁
+    resume.set_value();
+    reader.join();
+    EXPECT_FALSE(weak_held.expired());
+
+    // 写者解锁后补做回收，无需再次分发或发布
+    finish_destructor.set_value();
+    writer.join();
+    EXPECT_TRUE(weak_held.expired());
+}
+
+TEST(TestRouter, ShortLivedThreadsKeepLockFreeSnapshots)
+{
+    DispatchFixture f;
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/hello", Servlet("hello")).ok());
+
+    // 模拟 CACHE_MOD 线程池反复创建、回收线程，累计线程数远超槽位数
+    for(int i = 0; i < 300; ++i)
+    {
+        std::thread([&f]() {
+            EXPECT_EQ(f.Request("/hello", HttpRequest::Method::kGet)->body().toString(), "hello");
+        }).join();
+    }
+    EXPECT_EQ(f.dispatch.snapshotFallbacks(), 0u);
+}
+
+namespace {
+
+/// @brief 把 before/after 调用顺序记录到共享日志中
+HttpMiddleware::Ptr Recorder(const std::string &name, std::vector<std::string> *log, bool respond = false)
+{
+    return std::make_shared<FunctionMiddleware>(name,
+        [name, log, respond](const TcpConnectionPtr&, const HttpContextPtr &ctx) {
+            log->push_back(name + ".before");
+            if(respond)
+            {
+                ctx->response()->setVersion(Version::kHttp11);
+                ctx->response()->setStateCode(StateCode::k403Forbidden);
+                return HttpMiddleware::Action::kRespond;
+            }
+            return HttpMiddleware::Action::kContinue;
+        },
+        [name, log](const TcpConnectionPtr&, const HttpContextPtr&) {
+            log->push_back(name + ".after");
+        });
+}
+
+} // namespace
+
+TEST(TestRouter, MiddlewareRunsAroundServletInOrder)
+{
+    DispatchFixture f;
+    std::vector<std::string> log;
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/hello", Servlet("hello")).ok());
+    f.dispatch.use(Recorder("a", &log));
+    f.dispatch.use(Recorder("b", &log));
+
+    auto resp = f.Request("/hello", HttpRequest::Method::kGet);
+    ASSERT_EQ(resp->stateCode().toInt(), StateCode::k200Ok);
+    ASSERT_EQ(log, (std::vector<std::string>{"a.before", "b.before", "b.after", "a.after"}));
+}
+
+TEST(TestRouter, MiddlewareShortCircuitSkipsServlet)
+{
+    DispatchFixture f;
+    std::vector<std::string> log;
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/secret", Servlet("secret")).ok());
+    f.dispatch.use(Recorder("log", &log));
+    f.dispatch.use(Recorder("auth", &log, true));
+    f.dispatch.use(Recorder("late", &log));
+
+    auto resp = f.Request("/secret", HttpRequest::Method::kGet);
+    ASSERT_EQ(resp->stateCode().toInt(), StateCode::k403Forbidden);
+    ASSERT_EQ(resp->body().size(), 0u);
+    // 短路后的中间件不执行，已进入的按逆序收到 after
+    ASSERT_EQ(log, (std::vector<std::string>{"log.before", "auth.before", "auth.after", "log.after"}));
+}
+
+TEST(TestRouter, RouteScopedMiddleware)
+{
+    DispatchFixture f;
+    std::vector<std::string> log;
+    f.dispatch.use(Recorder("global", &log));
+    f.dispatch.use("/api/", Recorder("api", &log));
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/api/users/:id", Servlet("user")).ok());
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/index", Servlet("index")).ok());
+
+    // 先注册中间件后加路由，新路由同样编入链
+    ASSERT_EQ(f.Request("/api/users/7", HttpRequest::Method::kGet)->stateCode().toInt(), StateCode::k200Ok);
+    ASSERT_EQ(log, (std::vector<std::string>{"global.before", "api.before", "api.after", "global.after"}));
+
+    log.clear();
+    ASSERT_EQ(f.Request("/index", HttpRequest::Method::kGet)->stateCode().toInt(), StateCode::k200Ok);
+    ASSERT_EQ(log, (std::vector<std::string>{"global.before", "global.after"}));
+
+    // 未命中的请求只经过全局中间件
+    log.clear();
+    ASSERT_EQ(f.Request("/api/missing", HttpRequest::Method::kGet)->stateCode().toInt(), StateCode::k404NotFound);
+    ASSERT_EQ(log, (std::vector<std::string>{"global.before", "global.after"}));
+}
+
+TEST(TestRouter, RemoveMiddleware)
+{
+    DispatchFixture f;
+    std::vector<std::string> log;
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/hello", Servlet("hello")).ok());
+    f.dispatch.use(Recorder("auth", &log, true));
+    ASSERT_EQ(f.Request("/hello", HttpRequest::Method::kGet)->stateCode().toInt(), StateCode::k403Forbidden);
+
+    ASSERT_EQ(f.dispatch.removeMiddleware("auth"), 1u);
+    ASSERT_EQ(f.dispatch.removeMiddleware("auth"), 0u);
+    log.clear();
+    ASSERT_EQ(f.Request("/hello", HttpRequest::Method::kGet)->stateCode().toInt(), StateCode::k200Ok);
+    ASSERT_TRUE(log.empty());
+}
+
+namespace {
+
+/// @brief 计数的servlet，可设置耗时与额外响应头
+HttpServlet::Ptr CountingServlet(std::atomic<int> *calls, const std::string &header = "", const std::string &value = "",
+                                 int32_t delayMs = 0)
+{
+    return std::make_shared<FunctionServlet>([=](TcpConnectionPtr, HttpContextPtr ctx) {
+        const int n = ++*calls;
+        if(delayMs > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+        }
+        auto resp = ctx->response();
+        resp->setVersion(Version::kHttp11);
+        resp->setStateCode(StateCode::k200Ok);
+        if(!header.empty())
+        {
+            resp->addHeader(header, value);
+        }
+        resp->body().appendData(ctx->request()->path() + "#" + std::to_string(n));
+    });
+}
+
+std::string Serialized(const HttpResponsePtr &resp)
+{
+    std::string out;
+    for(auto &buf : resp->serialized())
+    {
+        out += *buf;
+    }
+    return out;
+}
+
+HttpResponsePtr CacheRequest(DispatchFixture &f, const std::string &path,
+                             const std::vector<std::pair<std::string, std::string>> &query = {},
+                             const std::vector<std::pair<std::string, std::string>> &headers = {})
+{
+    auto ctx = std::make_shared<HttpContext>();
+    ctx->request()->setPath(path);
+    ctx->request()->setMethod(HttpRequest::Method::kGet);
+    for(auto &q : query)
+    {
+        ctx->request()->addQureyParam(q.first, q.second);
+    }
+    for(auto &h : headers)
+    {
+        ctx->request()->addHeader(h.first, h.second);
+    }
+    f.dispatch.handle(f.conn, ctx);
+    return ctx->response();
+}
+
+} // namespace
+
+TEST(TestResponseCache, HitIsServedPreSerialized)
+{
+    DispatchFixture f;
+    std::atomic<int> calls{0};
+    HttpResponseCache::Config config;
+    config.queryParams = {"page"};
+    auto cache = std::make_shared<HttpResponseCache>(config);
+    f.dispatch.use(cache);
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/list", CountingServlet(&calls, "X-Tag", "t1")).ok());
+
+    auto miss = CacheRequest(f, "/list", {{"page", "1"}});
+    ASSERT_TRUE(miss->serialized().empty());
+    ASSERT_EQ(miss->body().toString(), "/list#1");
+
+    // 未列出的查询参数不影响命中
+    auto hit = CacheRequest(f, "/list", {{"page", "1"}, {"utm", "x"}});
+    ASSERT_EQ(calls.load(), 1);
+    const std::string wire = Serialized(hit);
+    ASSERT_EQ(wire.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    ASSERT_NE(wire.find("X-Tag: t1\r\n"), std::string::npos);
+    ASSERT_NE(wire.find("Content-Length: 7\r\n"), std::string::npos);
+    ASSERT_NE(wire.find("Date: "), std::string::npos);
+    ASSERT_EQ(wire.substr(wire.size() - 11), "\r\n\r\n/list#1");
+
+    ASSERT_TRUE(CacheRequest(f, "/list", {{"page", "2"}})->serialized().empty());
+    ASSERT_EQ(calls.load(), 2);
+
+    auto stats = cache->stats();
+    ASSERT_EQ(stats.hits, 1u);
+    ASSERT_EQ(stats.misses, 2u);
+    ASSERT_EQ(stats.stores, 2u);
+    ASSERT_EQ(stats.entries, 2u);
+
+    ASSERT_EQ(cache->invalidate("/list"), 2u);
+    ASSERT_TRUE(CacheRequest(f, "/list", {{"page", "1"}})->serialized().empty());
+    ASSERT_EQ(calls.load(), 3);
+}
+
+TEST(TestResponseCache, VaryAndCacheControl)
+{
+    DispatchFixture f;
+    std::atomic<int> lang_calls{0};
+    std::atomic<int> private_calls{0};
+    std::atomic<int> vary_calls{0};
+    HttpResponseCache::Config config;
+    config.varyHeaders = {"Accept-Language"};
+    auto cache = std::make_shared<HttpResponseCache>(config);
+    f.dispatch.use(cache);
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/lang", CountingServlet(&lang_calls, "Vary", "accept-language")).ok());
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/private", CountingServlet(&private_calls, "Cache-Control", "private, max-age=60")).ok());
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/agent", CountingServlet(&vary_calls, "Vary", "User-Agent")).ok());
+
+    CacheRequest(f, "/lang", {}, {{"Accept-Language", "en"}});
+    CacheRequest(f, "/lang", {}, {{"Accept-Language", "zh"}});
+    ASSERT_FALSE(CacheRequest(f, "/lang", {}, {{"Accept-Language", "en"}})->serialized().empty());
+    ASSERT_EQ(lang_calls.load(), 2);
+
+    // 带鉴权或 no-cache 的请求绕过缓存
+    ASSERT_TRUE(CacheRequest(f, "/lang", {}, {{"Accept-Language", "en"}, {"Authorization", "Bearer x"}})->serialized().empty());
+    ASSERT_TRUE(CacheRequest(f, "/lang", {}, {{"Accept-Language", "en"}, {"Cache-Control", "no-cache"}})->serialized().empty());
+    ASSERT_EQ(lang_calls.load(), 4);
+
+    // private 与按未参与键的头部变化的响应不缓存
+    CacheRequest(f, "/private");
+    CacheRequest(f, "/private");
+    ASSERT_EQ(private_calls.load(), 2);
+    CacheRequest(f, "/agent");
+    CacheRequest(f, "/agent");
+    ASSERT_EQ(vary_calls.load(), 2);
+    ASSERT_EQ(cache->stats().uncacheable, 4u);
+    ASSERT_EQ(cache->stats().bypassed, 2u);
+}
+
+TEST(TestResponseCache, TtlAndByteBudget)
+{
+    DispatchFixture f;
+    std::atomic<int> calls{0};
+    std::atomic<int> aged_calls{0};
+    HttpResponseCache::Config config;
+    config.ttlMs = 30;
+    config.maxBytes = 600;
+    auto cache = std::make_shared<HttpResponseCache>(config);
+    f.dispatch.use(cache);
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/item/:id", CountingServlet(&calls)).ok());
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/aged", CountingServlet(&aged_calls, "Cache-Control", "max-age=60")).ok());
+
+    CacheRequest(f, "/aged");
+    CacheRequest(f, "/item/1");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // 默认TTL已过期，max-age 覆盖的条目仍有效
+    ASSERT_TRUE(CacheRequest(f, "/item/1")->serialized().empty());
+    ASSERT_FALSE(CacheRequest(f, "/aged")->serialized().empty());
+    ASSERT_EQ(calls.load(), 2);
+    ASSERT_EQ(aged_calls.load(), 1);
+    ASSERT_EQ(cache->stats().expired, 1u);
+
+    // 按字节预算淘汰最久未用的条目
+    for(int i = 2; i < 10; ++i)
+    {
+        CacheRequest(f, "/item/" + std::to_string(i));
+    }
+    auto stats = cache->stats();
+    ASSERT_GT(stats.evictions, 0u);
+    ASSERT_LE(stats.bytes, config.maxBytes);
+}
+
+TEST(TestResponseCache, ConcurrentMissesRunServletOnce)
+{
+    DispatchFixture f;
+    std::atomic<int> calls{0};
+    auto cache = std::make_shared<HttpResponseCache>();
+    f.dispatch.use(cache);
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/slow", CountingServlet(&calls, "", "", 100)).ok());
+
+    constexpr int kThreads = 8;
+    std::atomic<int> served{0};
+    std::vector<std::thread> threads;
+    for(int i = 0; i < kThreads; ++i)
+    {
+        threads.emplace_back([&]() {
+            auto resp = CacheRequest(f, "/slow");
+            const std::string wire = resp->serialized().empty() ? resp->body().toString() : Serialized(resp);
+            if(wire.size() >= 7 && 0 == wire.compare(wire.size() - 7, 7, "/slow#1"))
+            {
+                ++served;
+            }
+        });
+    }
+    for(auto &t : threads)
+    {
+        t.join();
+    }
+
+    ASSERT_EQ(calls.load(), 1);
+    ASSERT_EQ(served.load(), kThreads);
+    auto stats = cache->stats();
+    ASSERT_EQ(stats.stores, 1u);
+    ASSERT_EQ(stats.coalesced + stats.hits, static_cast<uint64_t>(kThreads - 1));
+}
+
+TEST(TestResponseCache, LoopThreadMissDoesNotWaitForLeader)
+{
+    DispatchFixture f;
+    std::atomic<int> calls{0};
+    auto cache = std::make_shared<HttpResponseCache>();
+    f.dispatch.use(cache);
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/slow", CountingServlet(&calls, "", "", 300)).ok());
+
+    std::thread leader([&]() { CacheRequest(f, "/slow"); });
+    while(0 == calls.load())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // 夹具的连接属于本线程的事件循环: 不等 leader，自行执行servlet
+    auto resp = CacheRequest(f, "/slow");
+    leader.join();
+    ASSERT_TRUE(resp->serialized().empty());
+    ASSERT_EQ(resp->body().toString(), "/slow#2");
+    ASSERT_EQ(calls.load(), 2);
+    ASSERT_EQ(cache->stats().coalesced, 0u);
+}
+
+TEST(TestResponseCache, ThrowingLeaderReleasesWaiters)
+{
+    DispatchFixture f;
+    std::atomic<int> calls{0};
+    HttpResponseCache::Config config;
+    config.coalesceTimeoutMs = 60 * 1000;
+    auto cache = std::make_shared<HttpResponseCache>(config);
+    f.dispatch.use(cache);
+    ASSERT_TRUE(f.dispatch.addRoute(ExpectHttpMethods::Get, "/flaky",
+        std::make_shared<FunctionServlet>([&calls](TcpConnectionPtr, HttpContextPtr ctx) {
+            if(1 == ++calls)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                throw std::runtime_error("boom");
+            }
+            auto resp = ctx->response();
+            resp->setVersion(Version::kHttp11);
+            resp->setStateCode(StateCode::k200Ok);
+            resp->body().appendData("ok");
+        })).ok());
+
+    std::promise<int32_t> leader_status;
+    std::thread leader([&]() {
+        auto ctx = std::make_shared<HttpContext>();
+        ctx->request()->setPath("/flaky");
+        ctx->request()->setMethod(HttpRequest::Method::kGet);
+        try
+        {
+            f.dispatch.handle(f.conn, ctx);
+        }
+        catch(const std::runtime_error &)
+        {
+        }
+        leader_status.set_value(ctx->response()->stateCode().toInt());
+    });
+    while(0 == calls.load())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // 等待者不会等满 coalesceTimeoutMs，leader 异常后自行执行servlet
+    auto waiter = std::async(std::launch::async, [&]() { return CacheRequest(f, "/flaky"); });
+    ASSERT_EQ(waiter.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    auto resp = waiter.get();
+    leader.join();
+    ASSERT_EQ(leader_status.get_future().get(), StateCode::k500InternalServerError);
+    ASSERT_EQ(resp->body().toString(), "ok");
+    ASSERT_EQ(calls.load(), 2);
+    ASSERT_EQ(cache->stats().uncacheable, 1u);
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,352 @@
+/**
+ * @file test_video.cpp
+ * @brief 视频分发测试: TS 时间戳探测、HLS 播放列表生成、分片类型/区间与分片缓存
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 10:03:26
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "../test_log.h"
+#include "net/http/http_video.h"
+#include "net/http/http_asset_cache.h"
+#include "net/http/http_server.h"
+#include "net/event_loop.h"
+#include "base/event_loop_thread.h"
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <future>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+struct FdGuard
+{
+    explicit FdGuard(int32_t input_fd = -1)
+        :fd(input_fd)
+    {}
+
+    ~FdGuard()
+    {
+        if(fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+
+    int32_t fd;
+};
+
+uint16_t PickUnusedLoopbackPort()
+{
+    FdGuard listen_fd(::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if(listen_fd.fd < 0)
+    {
+        return 0;
+    }
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if(::bind(listen_fd.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+        || ::getsockname(listen_fd.fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) < 0)
+    {
+        return 0;
+    }
+    return ::ntohs(addr.sin_port);
+}
+
+int32_t ConnectLoopback(uint16_t port)
+{
+    for(int32_t i = 0; i < 50; ++i)
+    {
+        int32_t fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        timeval timeout;
+        timeout.tv_sec = 2;
+        timeout.tv_usec = 0;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = ::htons(port);
+        addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+        if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+        {
+            return fd;
+        }
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return -1;
+}
+
+/// @brief 发送请求并读到对端关闭
+std::string Roundtrip(uint16_t port, const std::string &request)
+{
+    FdGuard fd(ConnectLoopback(port));
+    if(fd.fd < 0 || ::send(fd.fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size()))
+    {
+        return "";
+    }
+    std::string data;
+    char buf[4096];
+    ssize_t n;
+    while((n = ::recv(fd.fd, buf, sizeof(buf), 0)) > 0)
+    {
+        data.append(buf, static_cast<size_t>(n));
+    }
+    return data;
+}
+
+std::string Get(const std::string &path, const std::string &extra = "")
+{
+    return "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n" + extra + "Connection: close\r\n\r\n";
+}
+
+/**
+ * @brief 构造 MPEG-TS 分片: 一个空包 + 一个带 PTS 的视频 PES 起始包
+ */
+std::string MakeTsSegment(int64_t pts, size_t packets = 4)
+{
+    std::string ts;
+    std::string null_packet(188, '\xFF');
+    null_packet[0] = 0x47;
+    null_packet[1] = 0x1F;
+    null_packet[2] = static_cast<char>(0xFF);
+    null_packet[3] = 0x10;
+    ts += null_packet;
+
+    std::string pes(188, '\xFF');
+    const unsigned char head[] = {
+        0x47, 0x41, 0x00, 0x10,
+        0x00, 0x00, 0x01, 0xE0, 0x00, 0x00, 0x80, 0x80, 0x05,
+        static_cast<unsigned char>(0x21 | ((pts >> 29) & 0x0E)),
+        static_cast<unsigned char>(pts >> 22),
+        static_cast<unsigned char>(((pts >> 14) & 0xFE) | 0x01),
+        static_cast<unsigned char>(pts >> 7),
+        static_cast<unsigned char>(((pts << 1) & 0xFE) | 0x01),
+    };
+    std::memcpy(&pes[0], head, sizeof(head));
+    ts += pes;
+    for(size_t i = 2; i < packets; ++i)
+    {
+        ts += null_packet;
+    }
+    return ts;
+}
+
+void WriteFile(const std::string &path, const std::string &content, int64_t ageSeconds)
+{
+    FILE *f = ::fopen(path.c_str(), "wb");
+    ASSERT_NE(f, nullptr);
+    ::fwrite(content.data(), 1, content.size(), f);
+    ::fclose(f);
+
+    timespec times[2];
+    ::clock_gettime(CLOCK_REALTIME, &times[0]);
+    times[0].tv_sec -= ageSeconds;
+    times[1] = times[0];
+    ASSERT_EQ(::utimensat(AT_FDCWD, path.c_str(), times, 0), 0);
+}
+
+int64_t NowWallMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void RemoveTree(const std::string &root)
+{
+    const std::string cmd = "rm -rf '" + root + "'";
+    ASSERT_EQ(std::system(cmd.c_str()), 0);
+}
+
+}
+
+TEST(TestVideo, ProbesTsPtsAndMimeTypes)
+{
+    const int64_t pts = (1LL << 32) + 12345;
+    const std::string ts = MakeTsSegment(pts);
+    ASSERT_EQ(VideoServlet::ProbeTsPts(ts.data(), ts.size()), pts);
+    // 前导垃圾字节后仍能找到同步
+    const std::string shifted = "abc" + ts;
+    ASSERT_EQ(VideoServlet::ProbeTsPts(shifted.data(), shifted.size()), pts);
+    ASSERT_EQ(VideoServlet::ProbeTsPts("not a ts", 8), -1);
+
+    ASSERT_STREQ(StaticFileServlet::MimeType("ts"), "video/mp2t");
+    ASSERT_STREQ(StaticFileServlet::MimeType("m3u8"), "application/vnd.apple.mpegurl");
+    ASSERT_STREQ(StaticFileServlet::MimeType("m4s"), "video/iso.segment");
+    ASSERT_STREQ(StaticFileServlet::MimeType("MP4"), "video/mp4");
+}
+
+TEST(TestVideo, BuildsVodPlaylistFromTsDurations)
+{
+    char dir_tmpl[] = "/tmp/kit_video_vod_XXXXXX";
+    ASSERT_NE(::mkdtemp(dir_tmpl), nullptr);
+    const std::string root = dir_tmpl;
+
+    // seg9 与 seg10 检验自然排序；相邻分片 PTS 相差 4 秒
+    for(int i = 8; i <= 11; ++i)
+    {
+        WriteFile(root + "/seg" + std::to_string(i) + ".ts", MakeTsSegment(90000LL * 4 * i), 3600);
+    }
+    WriteFile(root + "/notes.txt", "ignored", 3600);
+
+    VideoServlet servlet(root, "/video");
+    std::string playlist;
+    bool live = true;
+    ASSERT_TRUE(servlet.buildPlaylist(root, NowWallMs(), &playlist, &live));
+    ASSERT_FALSE(live);
+    ASSERT_EQ(playlist,
+        "#EXTM3U\n"
+        "#EXT-X-VERSION:3\n"
+        "#EXT-X-TARGETDURATION:6\n"
+        "#EXT-X-MEDIA-SEQUENCE:8\n"
+        "#EXT-X-PLAYLIST-TYPE:VOD\n"
+        "#EXTINF:4.000,\nseg8.ts\n"
+        "#EXTINF:4.000,\nseg9.ts\n"
+        "#EXTINF:4.000,\nseg10.ts\n"
+        "#EXTINF:6.000,\nseg11.ts\n"
+        "#EXT-X-ENDLIST\n");
+
+    ASSERT_FALSE(servlet.buildPlaylist(root + "/missing", NowWallMs(), &playlist, &live));
+    RemoveTree(root);
+}
+
+TEST(TestVideo, BuildsLiveWindowForFragmentedMp4)
+{
+    char dir_tmpl[] = "/tmp/kit_video_live_XXXXXX";
+    ASSERT_NE(::mkdtemp(dir_tmpl), nullptr);
+    const std::string root = dir_tmpl;
+
+    WriteFile(root + "/init.mp4", "init", 20);
+    for(int i = 1; i <= 5; ++i)
+    {
+        WriteFile(root + "/chunk-" + std::to_string(i) + ".m4s", std::string(100, 'm'), 12 - 2 * i);
+    }
+    // 刚写出的分片仍在写入，不应列出
+    WriteFile(root + "/chunk-6.m4s", std::string(10, 'm'), 0);
+
+    VideoServlet::Config config;
+    config.targetDuration = 2.0;
+    config.liveWindow = 3;
+    config.settleMs = 1000;
+    VideoServlet servlet(root, "/video", config);
+    std::string playlist;
+    bool live = false;
+    ASSERT_TRUE(servlet.buildPlaylist(root, NowWallMs(), &playlist, &live));
+    ASSERT_TRUE(live);
+    ASSERT_EQ(playlist,
+        "#EXTM3U\n"
+        "#EXT-X-VERSION:7\n"
+        "#EXT-X-TARGETDURATION:2\n"
+        "#EXT-X-MEDIA-SEQUENCE:3\n"
+        "#EXT-X-MAP:URI=\"init.mp4\"\n"
+        "#EXTINF:2.000,\nchunk-3.m4s\n"
+        "#EXTINF:2.000,\nchunk-4.m4s\n"
+        "#EXTINF:2.000,\nchunk-5.m4s\n");
+    RemoveTree(root);
+}
+
+TEST(TestVideo, ServesPlaylistSegmentsAndRangesWithCache)
+{
+    const uint16_t port = PickUnusedLoopbackPort();
+    if(0 == port)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable";
+    }
+
+    char dir_tmpl[] = "/tmp/kit_video_server_XXXXXX";
+    ASSERT_NE(::mkdtemp(dir_tmpl), nullptr);
+    const std::string root = dir_tmpl;
+    ASSERT_EQ(::mkdir((root + "/show").c_str(), 0755), 0);
+    const std::string seg0 = MakeTsSegment(0, 40);
+    WriteFile(root + "/show/s0.ts", seg0, 3600);
+    WriteFile(root + "/show/s1.ts", MakeTsSegment(90000 * 5, 40), 3600);
+    std::string movie(100000, '\0');
+    for(size_t i = 0; i < movie.size(); ++i)
+    {
+        movie[i] = static_cast<char>('a' + i % 26);
+    }
+    WriteFile(root + "/movie.mp4", movie, 3600);
+
+    EventLoopThread loop_thread(nullptr, "video_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    // 分片缓存默认关闭，需要显式开启
+    ASSERT_EQ(VideoServlet(root, "/video").segmentCache(), nullptr);
+    VideoServlet::Config config;
+    config.segmentCacheBytes = 64 * 1024 * 1024;
+    auto servlet = std::make_shared<VideoServlet>(root, "/video", config);
+    std::shared_ptr<HttpServer> server;
+    std::promise<void> started;
+    loop->runInLoop([&](){
+        server = std::make_shared<HttpServer>(loop, InetAddress(port, "127.0.0.1"), "video-test", false, TcpServer::KReusePort);
+        // 路由通配符不跨目录，每层目录各注册一次
+        server->Get("/video/*", servlet);
+        server->Get("/video/*/*", servlet);
+        server->start();
+        started.set_value();
+    });
+    ASSERT_EQ(started.get_future().wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    // 生成的播放列表，第二次命中缓存
+    for(int i = 0; i < 2; ++i)
+    {
+        const std::string resp = Roundtrip(port, Get("/video/show/index.m3u8"));
+        ASSERT_EQ(resp.compare(0, 17, "HTTP/1.1 200 OK\r\n"), 0) << resp;
+        ASSERT_NE(resp.find("Content-Type: application/vnd.apple.mpegurl\r\n"), std::string::npos) << resp;
+        ASSERT_NE(resp.find("Cache-Control: max-age=60\r\n"), std::string::npos) << resp;
+        ASSERT_NE(resp.find("#EXTINF:5.000,\ns0.ts\n#EXTINF:6.000,\ns1.ts\n#EXT-X-ENDLIST\n"), std::string::npos) << resp;
+    }
+    ASSERT_EQ(servlet->stats().playlistBuilds, 1u);
+    ASSERT_EQ(servlet->stats().playlistHits, 1u);
+    ASSERT_NE(Roundtrip(port, Get("/video/none/index.m3u8")).find("404"), std::string::npos);
+    ASSERT_NE(Roundtrip(port, Get("/video/../etc/index.m3u8")).find("404"), std::string::npos);
+
+    // 分片: 首次读入缓存，之后从内存发送
+    for(int i = 0; i < 3; ++i)
+    {
+        const std::string resp = Roundtrip(port, Get("/video/show/s0.ts"));
+        ASSERT_NE(resp.find("Content-Type: video/mp2t\r\n"), std::string::npos) << resp;
+        ASSERT_EQ(resp.substr(resp.size() - seg0.size()), seg0);
+    }
+    HttpAssetCache::Stats cache = servlet->segmentCache()->stats();
+    ASSERT_EQ(cache.hits, 2u);
+    ASSERT_EQ(cache.entries, 1u);
+
+    // 渐进式 MP4 的拖动: 单区间 206
+    const std::string range = Roundtrip(port, Get("/video/movie.mp4", "Range: bytes=50000-50009\r\n"));
+    ASSERT_EQ(range.compare(0, 28, "HTTP/1.1 206 Partial Content"), 0) << range;
+    ASSERT_NE(range.find("Content-Type: video/mp4\r\n"), std::string::npos) << range;
+    ASSERT_NE(range.find("Content-Range: bytes 50000-50009/100000\r\n"), std::string::npos) << range;
+    ASSERT_EQ(range.substr(range.size() - 10), movie.substr(50000, 10));
+
+    std::promise<void> stopped;
+    loop->runInLoop([&](){
+        server.reset();
+        loop->quit();
+        stopped.set_value();
+    });
+    stopped.get_future().wait_for(std::chrono::seconds(2));
+    RemoveTree(root);
+}
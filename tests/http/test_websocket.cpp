@@ -0,0 +1,572 @@
+/**
+ * @file test_websocket.cpp
+ * @brief WebSocket 握手、帧编解码与广播测试
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 23:18:05
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/http/websocket.h"
+#include "net/http/http_context.h"
+#include "net/http/http_request.h"
+#include "net/http/http_server.h"
+#include "net/http/http_scanner.h"
+#include "net/buffer.h"
+#include "net/event_loop.h"
+#include "net/net_log.h"
+#include "base/digest.h"
+#include "base/event_loop_thread.h"
+#include "base/time_stamp.h"
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace kit_muduo;
+using namespace kit_muduo::http;
+
+namespace {
+
+const uint8_t kMaskKey[4] = {0x37, 0xfa, 0x21, 0x3d};
+
+std::string Hex(const Sha1Digest &digest)
+{
+    static const char kHex[] = "0123456789abcdef";
+    std::string out;
+    for(uint8_t b : digest)
+    {
+        out.push_back(kHex[b >> 4]);
+        out.push_back(kHex[b & 0xF]);
+    }
+    return out;
+}
+
+/// @brief 按客户端方式(带掩码)编码
+std::string ClientFrame(WebSocketOpcode opcode, const std::string &payload, bool fin = true)
+{
+    return WebSocketCodec::Encode(opcode, payload.data(), payload.size(), fin, kMaskKey);
+}
+
+WebSocketCodec::Config ClientConfig()
+{
+    WebSocketCodec::Config config;
+    config.expectMasked = false;
+    return config;
+}
+
+struct FdGuard
+{
+    explicit FdGuard(int32_t input_fd = -1) :fd(input_fd) {}
+    ~FdGuard()
+    {
+        if(fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+    int32_t fd;
+};
+
+uint16_t PickUnusedLoopbackPort()
+{
+    FdGuard listen_fd(::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if(listen_fd.fd < 0)
+    {
+        return 0;
+    }
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if(::bind(listen_fd.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+        || ::getsockname(listen_fd.fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) < 0)
+    {
+        return 0;
+    }
+    return ::ntohs(addr.sin_port);
+}
+
+int32_t ConnectLoopback(uint16_t port)
+{
+    for(int32_t i = 0; i < 50; ++i)
+    {
+        int32_t fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        timeval timeout{2, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = ::htons(port);
+        addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+        if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+        {
+            return fd;
+        }
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return -1;
+}
+
+/// @brief 读到 "\r\n\r\n" 为止，多读到的字节留在 rest
+std::string ReadHead(int32_t fd, std::string *rest)
+{
+    std::string data;
+    char buf[4096];
+    size_t end;
+    while(std::string::npos == (end = data.find("\r\n\r\n")))
+    {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if(n <= 0)
+        {
+            return data;
+        }
+        data.append(buf, static_cast<size_t>(n));
+    }
+    rest->assign(data, end + 4, std::string::npos);
+    return data.substr(0, end + 4);
+}
+
+/// @brief 客户端侧: 从 socket 中解码下一条消息
+bool ReadMessage(int32_t fd, WebSocketCodec &codec, Buffer &buf, WebSocketMessage *msg)
+{
+    char tmp[4096];
+    while(true)
+    {
+        switch(codec.decode(buf, msg))
+        {
+        case WebSocketCodec::DecodeResult::kMessage: return true;
+        case WebSocketCodec::DecodeResult::kError: return false;
+        case WebSocketCodec::DecodeResult::kNeedMore: break;
+        }
+        ssize_t n = ::recv(fd, tmp, sizeof(tmp), 0);
+        if(n <= 0)
+        {
+            return false;
+        }
+        buf.append(tmp, static_cast<size_t>(n));
+    }
+}
+
+std::string Handshake(const std::string &path, const std::string &extra = "")
+{
+    return "GET " + path + " HTTP/1.1\r\n"
+           "Host: 127.0.0.1\r\n"
+           "Upgrade: websocket\r\n"
+           "Connection: keep-alive, Upgrade\r\n"
+           "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+           "Sec-WebSocket-Version: 13\r\n" + extra + "\r\n";
+}
+
+/// @brief 回显消息并把连接加入广播组
+class EchoHandler : public WebSocketHandler
+{
+public:
+    bool accept(const HttpRequest &req) override { return req.header("X-Deny").empty(); }
+
+    void onOpen(const WebSocketConnection::Ptr &ws) override { hub.add(ws); }
+
+    void onMessage(const WebSocketConnection::Ptr &ws, const WebSocketMessage &msg) override
+    {
+        if(WebSocketOpcode::kText == msg.opcode && "bye" == msg.payload)
+        {
+            ws->close(WebSocketCloseCode::kGoingAway, "bye");
+            return;
+        }
+        if(WebSocketOpcode::kText == msg.opcode && "broadcast" == msg.payload)
+        {
+            hub.broadcastText("hello all");
+            return;
+        }
+        if(WebSocketOpcode::kText == msg.opcode)
+        {
+            ws->sendText(msg.payload);
+        }
+        else if(WebSocketOpcode::kBinary == msg.opcode)
+        {
+            ws->sendBinary(msg.payload.data(), msg.payload.size());
+        }
+    }
+
+    void onClose(const WebSocketConnection::Ptr &ws, uint16_t code, const std::string &reason) override
+    {
+        hub.remove(ws);
+        closes.fetch_add(1);
+        last_code.store(code);
+    }
+
+    WebSocketHub hub;
+    std::atomic<int> closes{0};
+    std::atomic<uint16_t> last_code{0};
+};
+
+}
+
+TEST(TestWebSocket, Sha1AndBase64)
+{
+    EXPECT_EQ(Hex(Sha1Sum("abc", 3)), "a9993e364706816aba3e25717850c26c9cd0d89d");
+    EXPECT_EQ(Hex(Sha1Sum("", 0)), "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+    // 跨越多个分组、分多次 update
+    const std::string million(1000000, 'a');
+    Sha1 sha1;
+    for(size_t off = 0; off < million.size(); off += 997)
+    {
+        sha1.update(million.data() + off, std::min<size_t>(997, million.size() - off));
+    }
+    EXPECT_EQ(Hex(sha1.finish()), "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+
+    EXPECT_EQ(Base64Encode("f", 1), "Zg==");
+    EXPECT_EQ(Base64Encode("fo", 2), "Zm8=");
+    EXPECT_EQ(Base64Encode("foobar", 6), "Zm9vYmFy");
+    std::string out;
+    EXPECT_TRUE(Base64Decode("Zm9vYg==", &out));
+    EXPECT_EQ(out, "foob");
+    EXPECT_FALSE(Base64Decode("Zm9vY", &out));
+    EXPECT_FALSE(Base64Decode("Zm9v!A==", &out));
+
+    // RFC 6455 1.3 的示例
+    EXPECT_EQ(WebSocketAcceptKey("dGhlIHNhbXBsZSBub25jZQ=="), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST(TestWebSocket, MaskLevelsMatchScalar)
+{
+    const HttpScanLevel best = DetectHttpScanLevel();
+    std::string plain(300, '\0');
+    for(size_t i = 0; i < plain.size(); ++i)
+    {
+        plain[i] = static_cast<char>(i * 31 + 7);
+    }
+    for(uint8_t l = 0; l <= static_cast<uint8_t>(best); ++l)
+    {
+        const HttpScanLevel level = static_cast<HttpScanLevel>(l);
+        SCOPED_TRACE(HttpScanLevelName(level));
+        for(size_t len = 0; len < 200; ++len)
+        {
+            for(size_t offset = 0; offset < 4; ++offset)
+            {
+                std::string expect = plain.substr(0, len);
+                for(size_t i = 0; i < len; ++i)
+                {
+                    expect[i] ^= kMaskKey[(offset + i) & 3];
+                }
+                std::string data = plain.substr(0, len);
+                WebSocketMaskWith(level, &data[0], len, kMaskKey, offset);
+                ASSERT_EQ(data, expect) << "len " << len << " offset " << offset;
+            }
+        }
+    }
+}
+
+TEST(TestWebSocket, CodecFragmentsControlFramesAndPartialInput)
+{
+    WebSocketCodec codec;
+    WebSocketMessage msg;
+    Buffer buf;
+
+    // 分片消息中间夹着 ping；逐字节喂入
+    const std::string wire = ClientFrame(WebSocketOpcode::kText, "Hel", false)
+                           + ClientFrame(WebSocketOpcode::kPing, "p")
+                           + ClientFrame(WebSocketOpcode::kContinuation, "lo, ", false)
+                           + ClientFrame(WebSocketOpcode::kContinuation, "世界", true);
+    std::vector<WebSocketMessage> got;
+    for(char c : wire)
+    {
+        buf.append(&c, 1);
+        WebSocketCodec::DecodeResult result;
+        while(WebSocketCodec::DecodeResult::kMessage == (result = codec.decode(buf, &msg)))
+        {
+            got.push_back(msg);
+        }
+        ASSERT_EQ(result, WebSocketCodec::DecodeResult::kNeedMore);
+    }
+    ASSERT_EQ(got.size(), 2u);
+    EXPECT_EQ(got[0].opcode, WebSocketOpcode::kPing);
+    EXPECT_EQ(got[0].payload, "p");
+    EXPECT_EQ(got[1].opcode, WebSocketOpcode::kText);
+    EXPECT_EQ(got[1].payload, "Hello, 世界");
+    EXPECT_EQ(buf.readableBytes(), 0u);
+
+    // 16 位与 64 位长度
+    for(size_t len : {126u, 70000u})
+    {
+        const std::string payload(len, 'x');
+        const std::string frame = ClientFrame(WebSocketOpcode::kBinary, payload);
+        buf.append(frame.data(), frame.size());
+        ASSERT_EQ(codec.decode(buf, &msg), WebSocketCodec::DecodeResult::kMessage);
+        EXPECT_EQ(msg.opcode, WebSocketOpcode::kBinary);
+        EXPECT_EQ(msg.payload, payload);
+    }
+
+    // 关闭帧
+    std::string close = WebSocketCodec::EncodeClose(WebSocketCloseCode::kGoingAway, "bye");
+    buf.append(close.data(), close.size());
+    WebSocketCodec client(ClientConfig());
+    ASSERT_EQ(client.decode(buf, &msg), WebSocketCodec::DecodeResult::kMessage);
+    EXPECT_EQ(msg.opcode, WebSocketOpcode::kClose);
+    EXPECT_EQ(msg.close_code, WebSocketCloseCode::kGoingAway);
+    EXPECT_EQ(msg.close_reason, "bye");
+}
+
+TEST(TestWebSocket, CodecRejectsProtocolViolations)
+{
+    struct Case {
+        std::string wire;
+        uint16_t code;
+        WebSocketCodec::Config config;
+    };
+    WebSocketCodec::Config small;
+    small.maxMessageBytes = 8;
+    std::string rsv = ClientFrame(WebSocketOpcode::kText, "a");
+    rsv[0] |= 0x40;
+    std::string bad_close_code = "\x03\xe8";
+    bad_close_code[1] = static_cast<char>(0xed);  // 1005 不能出现在线路上
+
+    const Case cases[] = {
+        {WebSocketCodec::Encode(WebSocketOpcode::kText, "a", 1), WebSocketCloseCode::kProtocolError, {}},
+        {rsv, WebSocketCloseCode::kProtocolError, {}},
+        {ClientFrame(WebSocketOpcode::kContinuation, "a"), WebSocketCloseCode::kProtocolError, {}},
+        {ClientFrame(WebSocketOpcode::kText, "a", false) + ClientFrame(WebSocketOpcode::kText, "b"), WebSocketCloseCode::kProtocolError, {}},
+        {ClientFrame(WebSocketOpcode::kPing, std::string(126, 'p')), WebSocketCloseCode::kProtocolError, {}},
+        {ClientFrame(WebSocketOpcode::kPing, "p", false), WebSocketCloseCode::kProtocolError, {}},
+        {ClientFrame(static_cast<WebSocketOpcode>(0x3), "a"), WebSocketCloseCode::kProtocolError, {}},
+        {ClientFrame(WebSocketOpcode::kClose, "x"), WebSocketCloseCode::kProtocolError, {}},
+        {ClientFrame(WebSocketOpcode::kClose, bad_close_code), WebSocketCloseCode::kProtocolError, {}},
+        {ClientFrame(WebSocketOpcode::kText, "\xc0\xaf"), WebSocketCloseCode::kInvalidPayload, {}},
+        {ClientFrame(WebSocketOpcode::kText, "\xed\xa0\x80"), WebSocketCloseCode::kInvalidPayload, {}},
+        {ClientFrame(WebSocketOpcode::kBinary, "123456789"), WebSocketCloseCode::kMessageTooBig, small},
+        {ClientFrame(WebSocketOpcode::kBinary, "12345", false) + ClientFrame(WebSocketOpcode::kContinuation, "6789"),
+            WebSocketCloseCode::kMessageTooBig, small},
+    };
+    for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+    {
+        SCOPED_TRACE(i);
+        WebSocketCodec codec(cases[i].config);
+        WebSocketMessage msg;
+        Buffer buf;
+        buf.append(cases[i].wire.data(), cases[i].wire.size());
+        WebSocketCodec::DecodeResult result;
+        while(WebSocketCodec::DecodeResult::kMessage == (result = codec.decode(buf, &msg)))
+        {
+        }
+        EXPECT_EQ(result, WebSocketCodec::DecodeResult::kError);
+        EXPECT_EQ(codec.errorCode(), cases[i].code);
+    }
+
+    EXPECT_TRUE(WebSocketCodec::ValidUtf8("\xf0\x9f\x98\x80 ok", 7));
+    EXPECT_FALSE(WebSocketCodec::ValidUtf8("\xf4\x90\x80\x80", 4));
+    EXPECT_FALSE(WebSocketCodec::ValidUtf8("abcdefgh\xe4\xb8", 10));
+}
+
+TEST(TestWebSocket, UpgradeRequestValidation)
+{
+    auto check = [](const std::string &raw, bool expect, int32_t expect_status) {
+        HttpContext ctx;
+        ASSERT_TRUE(ctx.parseRequest(raw, TimeStamp::Now()));
+        int32_t status = -1;
+        EXPECT_EQ(IsWebSocketUpgrade(*ctx.request(), &status), expect) << raw;
+        EXPECT_EQ(status, expect_status) << raw;
+    };
+    check(Handshake("/ws"), true, 0);
+    check("GET /ws HTTP/1.1\r\nHost: a\r\n\r\n", false, 0);
+    check("GET /ws HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 8\r\n\r\n",
+          false, StateCode::k426UpgradeRequired);
+    check("GET /ws HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+          "Sec-WebSocket-Key: c2hvcnQ=\r\nSec-WebSocket-Version: 13\r\n\r\n",
+          false, StateCode::k400BadRequest);
+    check("GET /ws HTTP/1.1\r\nUpgrade: websocket\r\n"
+          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n",
+          false, StateCode::k400BadRequest);
+}
+
+TEST(TestWebSocket, ServerEchoBroadcastAndClose)
+{
+    const uint16_t port = PickUnusedLoopbackPort();
+    if(0 == port)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable";
+    }
+
+    EventLoopThread loop_thread(nullptr, "websocket_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    auto handler = std::make_shared<EchoHandler>();
+    std::shared_ptr<HttpServer> server;
+    std::promise<void> started;
+    loop->runInLoop([&]() {
+        server = std::make_shared<HttpServer>(loop, InetAddress(port, "127.0.0.1"), "websocket-test", false, TcpServer::KReusePort);
+        server->addWebSocket("/ws", handler);
+        server->start();
+        started.set_value();
+    });
+    ASSERT_EQ(started.get_future().wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    // 被 accept 拒绝
+    {
+        FdGuard fd(ConnectLoopback(port));
+        ASSERT_GE(fd.fd, 0);
+        ASSERT_GT(::send(fd.fd, Handshake("/ws", "X-Deny: 1\r\n").data(), Handshake("/ws", "X-Deny: 1\r\n").size(), 0), 0);
+        std::string rest;
+        EXPECT_NE(ReadHead(fd.fd, &rest).find("HTTP/1.1 403 "), std::string::npos);
+    }
+
+    FdGuard a(ConnectLoopback(port));
+    FdGuard b(ConnectLoopback(port));
+    ASSERT_GE(a.fd, 0);
+    ASSERT_GE(b.fd, 0);
+    WebSocketCodec codec_a(ClientConfig());
+    WebSocketCodec codec_b(ClientConfig());
+    Buffer buf_a;
+    Buffer buf_b;
+
+    // 握手后紧跟一帧，验证残留数据交给了 WebSocket
+    const std::string first = Handshake("/ws") + ClientFrame(WebSocketOpcode::kText, "early");
+    ASSERT_EQ(::send(a.fd, first.data(), first.size(), 0), static_cast<ssize_t>(first.size()));
+    std::string rest;
+    const std::string head = ReadHead(a.fd, &rest);
+    EXPECT_NE(head.find("HTTP/1.1 101 Switching Protocols\r\n"), std::string::npos) << head;
+    EXPECT_NE(head.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"), std::string::npos) << head;
+    buf_a.append(rest.data(), rest.size());
+    WebSocketMessage msg;
+    ASSERT_TRUE(ReadMessage(a.fd, codec_a, buf_a, &msg));
+    EXPECT_EQ(msg.payload, "early");
+
+    ASSERT_GT(::send(b.fd, Handshake("/ws").data(), Handshake("/ws").size(), 0), 0);
+    ReadHead(b.fd, &rest);
+    buf_b.append(rest.data(), rest.size());
+
+    // ping 自动回复 pong
+    const std::string ping = ClientFrame(WebSocketOpcode::kPing, "hb");
+    ASSERT_GT(::send(b.fd, ping.data(), ping.size(), 0), 0);
+    ASSERT_TRUE(ReadMessage(b.fd, codec_b, buf_b, &msg));
+    EXPECT_EQ(msg.opcode, WebSocketOpcode::kPong);
+    EXPECT_EQ(msg.payload, "hb");
+
+    // 大消息分片回显
+    const std::string big(100000, 'z');
+    const std::string frames = ClientFrame(WebSocketOpcode::kBinary, big.substr(0, 60000), false)
+                             + ClientFrame(WebSocketOpcode::kContinuation, big.substr(60000));
+    ASSERT_EQ(::send(a.fd, frames.data(), frames.size(), 0), static_cast<ssize_t>(frames.size()));
+    ASSERT_TRUE(ReadMessage(a.fd, codec_a, buf_a, &msg));
+    EXPECT_EQ(msg.opcode, WebSocketOpcode::kBinary);
+    EXPECT_EQ(msg.payload, big);
+
+    // 广播到两个连接
+    const std::string cmd = ClientFrame(WebSocketOpcode::kText, "broadcast");
+    ASSERT_GT(::send(a.fd, cmd.data(), cmd.size(), 0), 0);
+    ASSERT_TRUE(ReadMessage(a.fd, codec_a, buf_a, &msg));
+    EXPECT_EQ(msg.payload, "hello all");
+    ASSERT_TRUE(ReadMessage(b.fd, codec_b, buf_b, &msg));
+    EXPECT_EQ(msg.payload, "hello all");
+
+    // 客户端发起关闭，服务端回应同样的状态码后断开
+    const std::string close = WebSocketCodec::EncodeClose(WebSocketCloseCode::kNormal, "done");
+    std::string masked_close = ClientFrame(WebSocketOpcode::kClose, close.substr(2));
+    ASSERT_GT(::send(a.fd, masked_close.data(), masked_close.size(), 0), 0);
+    ASSERT_TRUE(ReadMessage(a.fd, codec_a, buf_a, &msg));
+    EXPECT_EQ(msg.opcode, WebSocketOpcode::kClose);
+    EXPECT_EQ(msg.close_code, WebSocketCloseCode::kNormal);
+    char tmp;
+    EXPECT_EQ(::recv(a.fd, &tmp, 1, 0), 0);
+
+    // 未加掩码的帧是协议错误
+    const std::string unmasked = WebSocketCodec::Encode(WebSocketOpcode::kText, "x", 1);
+    ASSERT_GT(::send(b.fd, unmasked.data(), unmasked.size(), 0), 0);
+    ASSERT_TRUE(ReadMessage(b.fd, codec_b, buf_b, &msg));
+    EXPECT_EQ(msg.opcode, WebSocketOpcode::kClose);
+    EXPECT_EQ(msg.close_code, WebSocketCloseCode::kProtocolError);
+
+    for(int i = 0; i < 100 && handler->closes.load() < 2; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(handler->closes.load(), 2);
+    EXPECT_EQ(handler->last_code.load(), WebSocketCloseCode::kProtocolError);
+    EXPECT_EQ(handler->hub.size(), 0u);
+
+    std::promise<void> stopped;
+    loop->runInLoop([&]() {
+        server.reset();
+        loop->quit();
+        stopped.set_value();
+    });
+    stopped.get_future().wait_for(std::chrono::seconds(2));
+}
+
+TEST(TestWebSocket, ServerCloseTimesOutSilentPeer)
+{
+    const uint16_t port = PickUnusedLoopbackPort();
+    if(0 == port)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable";
+    }
+
+    EventLoopThread loop_thread(nullptr, "websocket_close_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    auto handler = std::make_shared<EchoHandler>();
+    std::shared_ptr<HttpServer> server;
+    std::promise<void> started;
+    loop->runInLoop([&]() {
+        server = std::make_shared<HttpServer>(loop, InetAddress(port, "127.0.0.1"), "websocket-close-test", false, TcpServer::KReusePort);
+        server->addWebSocket("/ws", handler);
+        server->start();
+        started.set_value();
+    });
+    ASSERT_EQ(started.get_future().wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    FdGuard fd(ConnectLoopback(port));
+    ASSERT_GE(fd.fd, 0);
+    WebSocketCodec codec(ClientConfig());
+    Buffer buf;
+    const std::string first = Handshake("/ws") + ClientFrame(WebSocketOpcode::kText, "bye");
+    ASSERT_EQ(::send(fd.fd, first.data(), first.size(), 0), static_cast<ssize_t>(first.size()));
+    std::string rest;
+    ASSERT_NE(ReadHead(fd.fd, &rest).find("HTTP/1.1 101 "), std::string::npos);
+    buf.append(rest.data(), rest.size());
+
+    // 收到服务端关闭帧后既不回应也不关闭 socket
+    WebSocketMessage msg;
+    ASSERT_TRUE(ReadMessage(fd.fd, codec, buf, &msg));
+    EXPECT_EQ(msg.opcode, WebSocketOpcode::kClose);
+    EXPECT_EQ(msg.close_code, WebSocketCloseCode::kGoingAway);
+
+    // 超时后服务端强制断开并回调 onClose
+    for(int i = 0; i < 600 && 0 == handler->closes.load(); ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(handler->closes.load(), 1);
+    EXPECT_EQ(handler->hub.size(), 0u);
+    char tmp;
+    EXPECT_LE(::recv(fd.fd, &tmp, 1, 0), 0);
+
+    std::promise<void> stopped;
+    loop->runInLoop([&]() {
+        server.reset();
+        loop->quit();
+        stopped.set_value();
+    });
+    stopped.get_future().wait_for(std::chrono::seconds(2));
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,614 @@
+/**
+ * @file test_rtsp.cpp
+ * @brief RTP 打包、Transport 解析与 RTSP 会话/推流测试
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 06:25:31
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "net/rtsp/rtsp_server.h"
+#include "net/rtsp/rtp.h"
+#include "net/event_loop.h"
+#include "net/net_log.h"
+#include "base/event_loop_thread.h"
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace kit_muduo;
+using namespace kit_muduo::rtsp;
+
+namespace {
+
+struct FdGuard
+{
+    explicit FdGuard(int32_t input_fd = -1) :fd(input_fd) {}
+    ~FdGuard()
+    {
+        if(fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+    int32_t fd;
+};
+
+uint16_t PickUnusedLoopbackPort(int type = SOCK_STREAM)
+{
+    FdGuard fd(::socket(AF_INET, type | SOCK_CLOEXEC, 0));
+    if(fd.fd < 0)
+    {
+        return 0;
+    }
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if(::bind(fd.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+        || ::getsockname(fd.fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) < 0)
+    {
+        return 0;
+    }
+    return ::ntohs(addr.sin_port);
+}
+
+int32_t ConnectLoopback(uint16_t port)
+{
+    for(int32_t i = 0; i < 50; ++i)
+    {
+        int32_t fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        timeval timeout{2, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = ::htons(port);
+        addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+        if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+        {
+            return fd;
+        }
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return -1;
+}
+
+/// @brief 阻塞式 RTSP 客户端，回复与 interleaved 帧共用一个接收缓冲
+class RtspClient
+{
+public:
+    explicit RtspClient(uint16_t port) :_fd(ConnectLoopback(port)), _url("rtsp://127.0.0.1:" + std::to_string(port)) {}
+
+    bool valid() const { return _fd.fd >= 0; }
+    const std::string& url() const { return _url; }
+
+    /// @brief 发送请求并返回完整回复(头+体)
+    std::string request(const std::string &method, const std::string &url, const std::string &headers = "")
+    {
+        const std::string req = method + " " + url + " RTSP/1.0\r\nCSeq: " + std::to_string(++_cseq) + "\r\n" + headers + "\r\n";
+        if(!sendRaw(req))
+        {
+            return std::string();
+        }
+        return readReply();
+    }
+
+    bool sendRaw(const std::string &data)
+    {
+        return ::send(_fd.fd, data.data(), data.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(data.size());
+    }
+
+    std::string readReply()
+    {
+        size_t end;
+        while(std::string::npos == (end = _in.find("\r\n\r\n")))
+        {
+            if(!fill())
+            {
+                return std::string();
+            }
+        }
+        size_t body = 0;
+        const size_t pos = _in.find("Content-Length: ");
+        if(pos < end)
+        {
+            body = std::strtoul(_in.c_str() + pos + 16, nullptr, 10);
+        }
+        while(_in.size() < end + 4 + body)
+        {
+            if(!fill())
+            {
+                return std::string();
+            }
+        }
+        std::string reply = _in.substr(0, end + 4 + body);
+        _in.erase(0, end + 4 + body);
+        return reply;
+    }
+
+    /// @brief 读一个 interleaved 帧
+    bool readInterleaved(uint8_t *channel, std::string *rtp)
+    {
+        while(_in.size() < 4 || _in.size() < 4 + ((static_cast<uint8_t>(_in[2]) << 8) | static_cast<uint8_t>(_in[3])))
+        {
+            if(!fill())
+            {
+                return false;
+            }
+        }
+        if('$' != _in[0])
+        {
+            return false;
+        }
+        const size_t len = (static_cast<uint8_t>(_in[2]) << 8) | static_cast<uint8_t>(_in[3]);
+        *channel = static_cast<uint8_t>(_in[1]);
+        rtp->assign(_in, 4, len);
+        _in.erase(0, 4 + len);
+        return true;
+    }
+
+private:
+    bool fill()
+    {
+        char buf[8192];
+        const ssize_t n = ::recv(_fd.fd, buf, sizeof(buf), 0);
+        if(n <= 0)
+        {
+            return false;
+        }
+        _in.append(buf, static_cast<size_t>(n));
+        return true;
+    }
+
+private:
+    FdGuard _fd;
+    std::string _url;
+    int _cseq{0};
+    std::string _in;
+};
+
+std::string HeaderValue(const std::string &reply, const std::string &name)
+{
+    const size_t pos = reply.find("\r\n" + name + ": ");
+    if(std::string::npos == pos)
+    {
+        return std::string();
+    }
+    const size_t begin = pos + name.size() + 4;
+    return reply.substr(begin, reply.find("\r\n", begin) - begin);
+}
+
+std::string SessionOf(const std::string &reply)
+{
+    const std::string value = HeaderValue(reply, "Session");
+    return value.substr(0, value.find(';'));
+}
+
+/// @brief Annex-B 帧: [SPS][PPS] + 指定类型、指定长度的 NAL
+std::string MakeH264Frame(uint8_t nalType, size_t nalSize, bool withParams)
+{
+    static const std::string kStart("\x00\x00\x00\x01", 4);
+    std::string frame;
+    if(withParams)
+    {
+        frame += kStart + std::string("\x67\x42\xC0\x1F\xDA\x01", 6);
+        frame += kStart + std::string("\x68\xCE\x3C\x80", 4);
+    }
+    frame += kStart;
+    frame.push_back(static_cast<char>(0x60 | nalType));
+    for(size_t i = 1; i < nalSize; ++i)
+    {
+        frame.push_back(static_cast<char>(1 + i % 251));
+    }
+    return frame;
+}
+
+class RtspServerFixture
+{
+public:
+    explicit RtspServerFixture(RtspServer::Config config = RtspServer::Config())
+        :_thread(nullptr, "test_rtsp")
+        ,port(PickUnusedLoopbackPort())
+        ,source(std::make_shared<RtspMediaSource>("/live/cam"))
+    {
+        source->addTrack(RtspMediaSource::TrackConfig());
+        RtspMediaSource::TrackConfig audio;
+        audio.media = "audio";
+        audio.payloadType = 8;
+        audio.clockRate = 8000;
+        audio.encoding = "PCMA";
+        source->addTrack(audio);
+
+        loop = _thread.startLoop();
+        std::promise<void> started;
+        loop->runInLoop([&]() {
+            server = std::make_unique<RtspServer>(loop, InetAddress(port, "127.0.0.1"), "test-rtsp", config);
+            server->addSource(source);
+            server->start();
+            started.set_value();
+        });
+        started.get_future().wait();
+    }
+
+    ~RtspServerFixture()
+    {
+        std::promise<void> stopped;
+        loop->runInLoop([&]() {
+            server.reset();
+            loop->quit();
+            stopped.set_value();
+        });
+        stopped.get_future().wait_for(std::chrono::seconds(2));
+    }
+
+private:
+    EventLoopThread _thread;
+
+public:
+    EventLoop *loop{nullptr};
+    uint16_t port;
+    RtspMediaSource::Ptr source;
+    std::unique_ptr<RtspServer> server;
+};
+
+}
+
+TEST(RtpTest, HeaderRoundTrip)
+{
+    RtpHeader header;
+    header.payloadType = 96;
+    header.marker = true;
+    header.seq = 0xBEEF;
+    header.timestamp = 0x01020304;
+    header.ssrc = 0xCAFEBABE;
+    char buf[kRtpHeaderSize];
+    WriteRtpHeader(buf, header);
+    EXPECT_EQ(static_cast<uint8_t>(buf[0]), 0x80);
+    EXPECT_EQ(static_cast<uint8_t>(buf[1]), 0x80 | 96);
+
+    RtpHeader parsed;
+    size_t offset = 0;
+    ASSERT_TRUE(ParseRtpHeader(buf, sizeof(buf), &parsed, &offset));
+    EXPECT_EQ(offset, kRtpHeaderSize);
+    EXPECT_TRUE(parsed.marker);
+    EXPECT_EQ(parsed.payloadType, 96);
+    EXPECT_EQ(parsed.seq, 0xBEEF);
+    EXPECT_EQ(parsed.timestamp, 0x01020304u);
+    EXPECT_EQ(parsed.ssrc, 0xCAFEBABEu);
+
+    buf[0] = 0x40;
+    EXPECT_FALSE(ParseRtpHeader(buf, sizeof(buf), &parsed, &offset));
+}
+
+TEST(RtpTest, SplitAnnexB)
+{
+    const std::string stream("\x00\x00\x00\x01\x67\x42\x00\x00\x01\x68\xCE\x00\x00\x00\x01\x65\x88", 17);
+    auto nals = RtpPacketizer::SplitAnnexB(stream.data(), stream.size());
+    ASSERT_EQ(nals.size(), 3u);
+    EXPECT_EQ(nals[0], std::string("\x67\x42", 2));
+    EXPECT_EQ(nals[1], std::string("\x68\xCE", 2));
+    EXPECT_EQ(nals[2], std::string("\x65\x88", 2));
+
+    // 无起始码时整段视为一个 NAL
+    nals = RtpPacketizer::SplitAnnexB("\x41\x9A", 2);
+    ASSERT_EQ(nals.size(), 1u);
+    EXPECT_EQ(nals[0].size(), 2u);
+}
+
+TEST(RtpTest, H264FragmentsLargeNalWithFuA)
+{
+    RtpPacketPool pool;
+    RtpPacketizer packetizer(RtpPacketizer::Codec::kH264, 96, 0x11223344, 0, 1000, &pool);
+    const std::string frame = MakeH264Frame(5, 2500, true);
+    std::vector<SharedBuffer> packets;
+    const uint16_t first_seq = packetizer.nextSeq();
+    ASSERT_TRUE(packetizer.packetize(frame.data(), frame.size(), 9000, &packets));
+
+    // SPS + PPS 单包，2500 字节 IDR 按 998 字节负载切成 3 个 FU-A
+    ASSERT_EQ(packets.size(), 5u);
+    std::string reassembled;
+    for(size_t i = 0; i < packets.size(); ++i)
+    {
+        const std::string &p = *packets[i];
+        ASSERT_EQ(p[0], '$');
+        ASSERT_EQ(p[1], 0);
+        ASSERT_EQ(((static_cast<uint8_t>(p[2]) << 8) | static_cast<uint8_t>(p[3])), static_cast<int>(p.size() - 4));
+        RtpHeader header;
+        size_t offset = 0;
+        ASSERT_TRUE(ParseRtpHeader(p.data() + 4, p.size() - 4, &header, &offset));
+        EXPECT_EQ(header.seq, static_cast<uint16_t>(first_seq + i));
+        EXPECT_EQ(header.timestamp, 9000u);
+        EXPECT_EQ(header.ssrc, 0x11223344u);
+        EXPECT_EQ(header.marker, i + 1 == packets.size());
+        const char *payload = p.data() + 4 + offset;
+        if(i < 2)
+        {
+            continue;
+        }
+        EXPECT_EQ(static_cast<uint8_t>(payload[0]), 0x60 | 28);
+        const uint8_t fu_header = static_cast<uint8_t>(payload[1]);
+        EXPECT_EQ(fu_header & 0x1F, 5);
+        EXPECT_EQ(0 != (fu_header & 0x80), 2 == i);
+        EXPECT_EQ(0 != (fu_header & 0x40), 4 == i);
+        EXPECT_LE(p.size() - 4 - offset, 1000u);
+        reassembled.append(payload + 2, p.size() - 4 - offset - 2);
+    }
+    EXPECT_EQ(reassembled, frame.substr(frame.size() - 2499));
+
+    const std::string fmtp = packetizer.h264Fmtp();
+    EXPECT_NE(fmtp.find("packetization-mode=1"), std::string::npos);
+    EXPECT_NE(fmtp.find("profile-level-id=42C01F"), std::string::npos);
+    EXPECT_NE(fmtp.find("sprop-parameter-sets=Z0LAH9oB,aM48gA=="), std::string::npos);
+
+    // 非 IDR 帧不是关键帧
+    packets.clear();
+    const std::string p_frame = MakeH264Frame(1, 100, false);
+    EXPECT_FALSE(packetizer.packetize(p_frame.data(), p_frame.size(), 12000, &packets));
+    EXPECT_EQ(packets.size(), 1u);
+}
+
+TEST(RtpTest, PoolRecyclesPacketBuffers)
+{
+    RtpPacketPool pool(4);
+    RtpPacketizer packetizer(RtpPacketizer::Codec::kGeneric, 8, 1, 2, 160, &pool);
+    const std::string audio(400, 'a');
+    for(int i = 0; i < 10; ++i)
+    {
+        std::vector<SharedBuffer> packets;
+        EXPECT_TRUE(packetizer.packetize(audio.data(), audio.size(), i * 400, &packets));
+        ASSERT_EQ(packets.size(), 3u);
+        EXPECT_EQ(packets[0]->at(1), 2);
+    }
+    const RtpPacketPool::Stats stats = pool.stats();
+    EXPECT_EQ(stats.acquired, 30u);
+    EXPECT_EQ(stats.allocated, 3u);
+    EXPECT_EQ(stats.cached, 3u);
+
+    std::vector<SharedBuffer> packets;
+    packetizer.packetize(audio.data(), 100, 0, &packets);
+    SharedBuffer copy = RewriteInterleavedChannel(packets[0], 6, &pool);
+    EXPECT_EQ(copy->at(1), 6);
+    EXPECT_EQ(copy->substr(2), packets[0]->substr(2));
+}
+
+TEST(RtspParseTest, Transport)
+{
+    RtspTransport transport;
+    ASSERT_TRUE(ParseRtspTransport("RTP/AVP/TCP;unicast;interleaved=2-3", &transport));
+    EXPECT_EQ(transport.mode, RtspTransport::kTcpInterleaved);
+    EXPECT_EQ(transport.rtpChannel, 2);
+    EXPECT_EQ(transport.rtcpChannel, 3);
+
+    ASSERT_TRUE(ParseRtspTransport("RTP/AVP;unicast;client_port=5000-5001", &transport));
+    EXPECT_EQ(transport.mode, RtspTransport::kUdpUnicast);
+    EXPECT_EQ(transport.clientRtpPort, 5000);
+    EXPECT_EQ(transport.clientRtcpPort, 5001);
+
+    // 第一个候选不支持时取下一个
+    ASSERT_TRUE(ParseRtspTransport("RTP/AVP;multicast;ttl=4, RTP/AVP/TCP;unicast", &transport));
+    EXPECT_EQ(transport.mode, RtspTransport::kTcpInterleaved);
+    EXPECT_EQ(transport.rtpChannel, 0);
+
+    EXPECT_FALSE(ParseRtspTransport("RTP/SAVP;unicast;client_port=5000-5001", &transport));
+    EXPECT_FALSE(ParseRtspTransport("RTP/AVP;unicast", &transport));
+    EXPECT_FALSE(ParseRtspTransport("RTP/AVP/TCP;interleaved=300-301", &transport));
+}
+
+TEST(RtspParseTest, Url)
+{
+    std::string path;
+    int track = 0;
+    SplitRtspUrl("rtsp://127.0.0.1:8554/live/cam/trackID=1", &path, &track);
+    EXPECT_EQ(path, "/live/cam");
+    EXPECT_EQ(track, 1);
+
+    SplitRtspUrl("rtsp://host/live/cam/", &path, &track);
+    EXPECT_EQ(path, "/live/cam");
+    EXPECT_EQ(track, -1);
+
+    SplitRtspUrl("/live/cam", &path, &track);
+    EXPECT_EQ(path, "/live/cam");
+
+    SplitRtspUrl("rtsp://host", &path, &track);
+    EXPECT_EQ(path, "/");
+}
+
+TEST(RtspServerTest, InterleavedSessionLifecycle)
+{
+    RtspServerFixture fixture;
+    RtspClient client(fixture.port);
+    ASSERT_TRUE(client.valid());
+    const std::string base = client.url() + "/live/cam";
+
+    std::string reply = client.request("OPTIONS", base);
+    EXPECT_EQ(reply.find("RTSP/1.0 200 OK\r\n"), 0u);
+    EXPECT_EQ(HeaderValue(reply, "CSeq"), "1");
+    EXPECT_NE(HeaderValue(reply, "Public").find("DESCRIBE"), std::string::npos);
+
+    // 先推一帧带 SPS/PPS 的关键帧，SDP 中才有 sprop-parameter-sets
+    const std::string idr = MakeH264Frame(5, 3000, true);
+    EXPECT_EQ(fixture.source->pushFrame(0, idr.data(), idr.size(), 0), 0u);
+
+    reply = client.request("DESCRIBE", base, "Accept: application/sdp\r\n");
+    EXPECT_EQ(reply.find("RTSP/1.0 200 OK\r\n"), 0u);
+    EXPECT_EQ(HeaderValue(reply, "Content-Type"), "application/sdp");
+    EXPECT_EQ(HeaderValue(reply, "Content-Base"), base + "/");
+    EXPECT_NE(reply.find("m=video 0 RTP/AVP 96\r\n"), std::string::npos);
+    EXPECT_NE(reply.find("a=rtpmap:96 H264/90000\r\n"), std::string::npos);
+    EXPECT_NE(reply.find("sprop-parameter-sets="), std::string::npos);
+    EXPECT_NE(reply.find("m=audio 0 RTP/AVP 8\r\n"), std::string::npos);
+    EXPECT_NE(reply.find("a=control:trackID=1\r\n"), std::string::npos);
+
+    EXPECT_EQ(client.request("DESCRIBE", client.url() + "/nope").find("RTSP/1.0 404"), 0u);
+    EXPECT_EQ(client.request("PLAY", base, "Session: 1234\r\n").find("RTSP/1.0 454"), 0u);
+    // 未配置 UDP 端口
+    EXPECT_EQ(client.request("SETUP", base + "/trackID=0", "Transport: RTP/AVP;unicast;client_port=5000-5001\r\n")
+              .find("RTSP/1.0 461"), 0u);
+
+    // 客户端选择非默认通道号，服务端为其复制改写通道号
+    reply = client.request("SETUP", base + "/trackID=0", "Transport: RTP/AVP/TCP;unicast;interleaved=4-5\r\n");
+    ASSERT_EQ(reply.find("RTSP/1.0 200 OK\r\n"), 0u);
+    EXPECT_EQ(HeaderValue(reply, "Transport").find("RTP/AVP/TCP;unicast;interleaved=4-5;ssrc="), 0u);
+    const std::string session = SessionOf(reply);
+    ASSERT_FALSE(session.empty());
+    EXPECT_NE(HeaderValue(reply, "Session").find(";timeout=60"), std::string::npos);
+
+    reply = client.request("SETUP", base + "/trackID=1",
+                           "Transport: RTP/AVP/TCP;unicast;interleaved=2-3\r\nSession: " + session + "\r\n");
+    ASSERT_EQ(reply.find("RTSP/1.0 200 OK\r\n"), 0u);
+    EXPECT_EQ(SessionOf(reply), session);
+
+    reply = client.request("PLAY", base + "/", "Session: " + session + "\r\nRange: npt=0.000-\r\n");
+    ASSERT_EQ(reply.find("RTSP/1.0 200 OK\r\n"), 0u);
+    EXPECT_NE(HeaderValue(reply, "RTP-Info").find(base + "/trackID=0;seq="), std::string::npos);
+    EXPECT_NE(HeaderValue(reply, "RTP-Info").find(",url=" + base + "/trackID=1;seq="), std::string::npos);
+
+    // 新观众等待关键帧: P 帧被跳过，随后的 IDR 与音频送达
+    const std::string p_frame = MakeH264Frame(1, 200, false);
+    EXPECT_EQ(fixture.source->pushFrame(0, p_frame.data(), p_frame.size(), 3000), 0u);
+    EXPECT_EQ(fixture.source->pushFrame(0, idr.data(), idr.size(), 6000), 1u);
+    const std::string pcma(160, '\xD5');
+    EXPECT_EQ(fixture.source->pushFrame(1, pcma.data(), pcma.size(), 160), 1u);
+
+    // SPS、PPS、3个 FU-A
+    for(int i = 0; i < 5; ++i)
+    {
+        uint8_t channel = 0;
+        std::string rtp;
+        ASSERT_TRUE(client.readInterleaved(&channel, &rtp));
+        EXPECT_EQ(channel, 4);
+        RtpHeader header;
+        size_t offset = 0;
+        ASSERT_TRUE(ParseRtpHeader(rtp.data(), rtp.size(), &header, &offset));
+        EXPECT_EQ(header.timestamp, 6000u);
+        EXPECT_EQ(header.marker, 4 == i);
+    }
+    uint8_t channel = 0;
+    std::string rtp;
+    ASSERT_TRUE(client.readInterleaved(&channel, &rtp));
+    EXPECT_EQ(channel, 2);
+    EXPECT_EQ(rtp.size(), kRtpHeaderSize + 160);
+
+    // interleaved RTCP 夹在请求之间，服务端跳过
+    const std::string rtcp("$\x05\x00\x08\x81\xC9\x00\x01\x00\x00\x00\x01", 12);
+    ASSERT_TRUE(client.sendRaw(rtcp));
+    reply = client.request("GET_PARAMETER", base, "Session: " + session + "\r\n");
+    EXPECT_EQ(reply.find("RTSP/1.0 200 OK\r\n"), 0u);
+
+    EXPECT_EQ(fixture.server->stats().playing, 1u);
+    reply = client.request("TEARDOWN", base, "Session: " + session + "\r\n");
+    EXPECT_EQ(reply.find("RTSP/1.0 200 OK\r\n"), 0u);
+    EXPECT_EQ(fixture.server->stats().sessions, 0u);
+    EXPECT_EQ(fixture.source->pushFrame(0, idr.data(), idr.size(), 9000), 0u);
+    EXPECT_EQ(client.request("PLAY", base, "Session: " + session + "\r\n").find("RTSP/1.0 454"), 0u);
+
+    const RtspMediaSource::Stats stats = fixture.source->stats();
+    EXPECT_EQ(stats.delivered, 2u);
+    EXPECT_EQ(stats.dropped, 1u);
+    EXPECT_EQ(stats.copiedPackets, 5u);
+}
+
+TEST(RtspServerTest, UdpUnicastAndSessionTimeout)
+{
+    RtspServer::Config config;
+    config.rtpPort = PickUnusedLoopbackPort(SOCK_DGRAM);
+    config.sessionTimeoutMs = 400;
+    ASSERT_NE(config.rtpPort, 0);
+    RtspServerFixture fixture(config);
+
+    FdGuard udp(::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0));
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    ASSERT_EQ(::bind(udp.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    ASSERT_EQ(::getsockname(udp.fd, reinterpret_cast<sockaddr*>(&addr), &addr_len), 0);
+    const uint16_t client_port = ::ntohs(addr.sin_port);
+    timeval timeout{2, 0};
+    ::setsockopt(udp.fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    RtspClient client(fixture.port);
+    ASSERT_TRUE(client.valid());
+    const std::string base = client.url() + "/live/cam";
+    std::string reply = client.request("SETUP", base + "/trackID=1",
+        "Transport: RTP/AVP;unicast;client_port=" + std::to_string(client_port) + "-" + std::to_string(client_port + 1) + "\r\n");
+    ASSERT_EQ(reply.find("RTSP/1.0 200 OK\r\n"), 0u);
+    EXPECT_NE(HeaderValue(reply, "Transport").find(";server_port=" + std::to_string(config.rtpPort) + "-"), std::string::npos);
+    EXPECT_NE(HeaderValue(reply, "Session").find(";timeout=1"), std::string::npos);
+    const std::string session = SessionOf(reply);
+
+    // UDP 与 TCP 不能混在同一会话
+    EXPECT_EQ(client.request("SETUP", base + "/trackID=0",
+                             "Transport: RTP/AVP/TCP;interleaved=0-1\r\nSession: " + session + "\r\n").find("RTSP/1.0 459"), 0u);
+
+    ASSERT_EQ(client.request("PLAY", base, "Session: " + session + "\r\n").find("RTSP/1.0 200 OK\r\n"), 0u);
+    const std::string pcma(320, '\xD5');
+    EXPECT_EQ(fixture.source->pushFrame(1, pcma.data(), pcma.size(), 320), 1u);
+
+    char buf[2048];
+    const ssize_t n = ::recv(udp.fd, buf, sizeof(buf), 0);
+    ASSERT_EQ(n, static_cast<ssize_t>(kRtpHeaderSize + 320));
+    RtpHeader header;
+    size_t offset = 0;
+    ASSERT_TRUE(ParseRtpHeader(buf, static_cast<size_t>(n), &header, &offset));
+    EXPECT_EQ(header.payloadType, 8);
+    EXPECT_EQ(header.timestamp, 320u);
+    EXPECT_TRUE(header.marker);
+
+    // 暂停后不再投递
+    ASSERT_EQ(client.request("PAUSE", base, "Session: " + session + "\r\n").find("RTSP/1.0 200 OK\r\n"), 0u);
+    EXPECT_EQ(fixture.source->pushFrame(1, pcma.data(), pcma.size(), 640), 0u);
+
+    // 不再有任何请求或 RTCP，会话超时回收
+    for(int i = 0; i < 50 && 0 == fixture.server->stats().expired; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    EXPECT_EQ(fixture.server->stats().expired, 1u);
+    EXPECT_EQ(fixture.server->stats().sessions, 0u);
+    EXPECT_EQ(client.request("PLAY", base, "Session: " + session + "\r\n").find("RTSP/1.0 454"), 0u);
+}
+
+TEST(RtspServerTest, ConnectionCloseDestroysSessions)
+{
+    RtspServerFixture fixture;
+    {
+        RtspClient client(fixture.port);
+        ASSERT_TRUE(client.valid());
+        const std::string base = client.url() + "/live/cam";
+        const std::string reply = client.request("SETUP", base + "/trackID=0", "Transport: RTP/AVP/TCP;interleaved=0-1\r\n");
+        ASSERT_EQ(client.request("PLAY", base, "Session: " + SessionOf(reply) + "\r\n").find("RTSP/1.0 200 OK\r\n"), 0u);
+        EXPECT_EQ(fixture.server->stats().playing, 1u);
+
+        // 未知方法
+        EXPECT_EQ(client.request("RECORD", base).find("RTSP/1.0 4"), 0u);
+    }
+    for(int i = 0; i < 50 && fixture.server->stats().sessions > 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    EXPECT_EQ(fixture.server->stats().sessions, 0u);
+    EXPECT_EQ(fixture.source->stats().viewers, 0u);
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,199 @@
+/**
+ * @file test_json_stream.cpp
+ * @brief 流式 JSON 写入器与无 DOM 解析器测试
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 12:26:10
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "gtest/gtest.h"
+#include "test_log.h"
+
+#include "base/json_stream.h"
+#include "net/buffer.h"
+#include "nlohmann/json.hpp"
+
+#include <cmath>
+
+using namespace kit_muduo;
+
+namespace demo {
+
+struct Address {
+    std::string city;
+    std::string street;
+    int32_t zip{0};
+};
+KIT_JSON_FIELDS(Address, city, street, zip)
+
+struct User {
+    int64_t id{0};
+    std::string name;
+    bool active{false};
+    double score{0.0};
+    uint16_t level{0};
+    std::vector<std::string> tags;
+    std::optional<std::string> nickname;
+    Address address;
+    std::vector<Address> history;
+    std::map<std::string, int32_t> counters;
+};
+KIT_JSON_FIELDS(User, id, name, active, score, level, tags, nickname, address, history, counters)
+
+}
+
+namespace {
+
+demo::User MakeUser()
+{
+    demo::User user;
+    user.id = -9007199254740993LL;
+    user.name = "Kewin \"K\" Li\n\t\\";
+    user.active = true;
+    user.score = 98.25;
+    user.level = 7;
+    user.tags = {"admin", "", "\xe4\xb8\xad\xe6\x96\x87"};
+    user.address = {"Shenzhen", "Nanshan", 518000};
+    user.history = {{"Beijing", "Haidian", 100080}, {"Wuhan", "", 430000}};
+    user.counters = {{"login", 12}, {"upload", 0}};
+    return user;
+}
+
+}
+
+/*
+ * 测试思路: 写入器输出为合法 JSON，nlohmann 解析后与原对象逐字段一致；
+ * 再由 JsonDecode 读回，得到与原对象相同的结构
+ */
+TEST(JsonStream, EncodeDecodeRoundTrip)
+{
+    const demo::User user = MakeUser();
+    const std::string json = JsonEncode(user);
+
+    const auto doc = nlohmann::json::parse(json);
+    EXPECT_EQ(doc["id"].get<int64_t>(), user.id);
+    EXPECT_EQ(doc["name"].get<std::string>(), user.name);
+    EXPECT_TRUE(doc["nickname"].is_null());
+    EXPECT_DOUBLE_EQ(doc["score"].get<double>(), 98.25);
+    EXPECT_EQ(doc["tags"][2].get<std::string>(), user.tags[2]);
+    EXPECT_EQ(doc["address"]["zip"].get<int>(), 518000);
+    EXPECT_EQ(doc["history"][1]["city"].get<std::string>(), "Wuhan");
+    EXPECT_EQ(doc["counters"]["login"].get<int>(), 12);
+    // 字段按声明顺序输出
+    EXPECT_EQ(json.compare(0, 6, "{\"id\":"), 0);
+
+    demo::User parsed;
+    parsed.nickname = "stale";
+    std::string err;
+    ASSERT_TRUE(JsonDecode(json, &parsed, &err)) << err;
+    EXPECT_EQ(parsed.id, user.id);
+    EXPECT_EQ(parsed.name, user.name);
+    EXPECT_TRUE(parsed.active);
+    EXPECT_EQ(parsed.score, user.score);
+    EXPECT_EQ(parsed.level, 7);
+    EXPECT_EQ(parsed.tags, user.tags);
+    EXPECT_FALSE(parsed.nickname.has_value());
+    EXPECT_EQ(parsed.address.street, "Nanshan");
+    ASSERT_EQ(parsed.history.size(), 2u);
+    EXPECT_EQ(parsed.history[0].zip, 100080);
+    EXPECT_EQ(parsed.counters, user.counters);
+    EXPECT_EQ(JsonEncode(parsed), json);
+}
+
+/*
+ * 测试思路: 写入器可直接写入网络 Buffer；手工调用与嵌套容器的逗号正确
+ */
+TEST(JsonStream, WriterIntoBuffer)
+{
+    Buffer buf;
+    JsonWriter<Buffer> writer(&buf);
+    writer.beginObject();
+    writer.key("empty");
+    writer.beginArray();
+    writer.endArray();
+    writer.key("nested");
+    writer.beginArray();
+    writer.beginObject();
+    writer.endObject();
+    writer.intValue(-1);
+    writer.doubleValue(2.0);
+    writer.doubleValue(NAN);
+    writer.nullValue();
+    writer.endArray();
+    writer.key("raw");
+    writer.rawValue("{\"a\":1}");
+    writer.key("ctl");
+    writer.stringValue(std::string("\x01\x1f", 2));
+    writer.endObject();
+
+    EXPECT_EQ(buf.resetAllAsString(),
+              "{\"empty\":[],\"nested\":[{},-1,2.0,null,null],\"raw\":{\"a\":1},\"ctl\":\"\\u0001\\u001f\"}");
+}
+
+/*
+ * 测试思路: 未声明的键(含嵌套结构)被跳过，缺失的键保持原值；
+ * 转义与 \u 代理对解码为 UTF-8；键本身含转义也能匹配
+ */
+TEST(JsonStream, DecodeSkipsUnknownAndDecodesEscapes)
+{
+    const std::string json = R"( {
+        "unknown": {"deep": [1, 2.5e3, "x", true, null, {"k": []}]},
+        "n\u0061me": "a\/b\u00e9\ud83d\ude00",
+        "address": {"city": "X", "extra": false},
+        "score": 3,
+        "id": 1.0e2
+    } )";
+
+    demo::User user;
+    user.level = 5;
+    user.address.zip = 42;
+    std::string err;
+    ASSERT_TRUE(JsonDecode(json, &user, &err)) << err;
+    EXPECT_EQ(user.name, "a/b\xc3\xa9\xf0\x9f\x98\x80");
+    EXPECT_EQ(user.address.city, "X");
+    EXPECT_EQ(user.address.zip, 42);
+    EXPECT_EQ(user.level, 5);
+    EXPECT_EQ(user.score, 3.0);
+    EXPECT_EQ(user.id, 100);
+}
+
+/*
+ * 测试思路: 各类非法输入与类型不符都返回 false 并给出错误位置，不抛异常
+ */
+TEST(JsonStream, DecodeRejectsInvalidInput)
+{
+    const char *cases[] = {
+        "",
+        "{",
+        "{\"id\":1,}",
+        "{\"id\":1 \"name\":\"a\"}",
+        "{\"id\":\"1\"}",
+        "{\"id\":1.5}",
+        "{\"id\":01}",
+        "{\"id\":99999999999999999999}",
+        "{\"level\":70000}",
+        "{\"level\":-1}",
+        "{\"name\":\"a\nb\"}",
+        "{\"name\":\"\\ud800\"}",
+        "{\"name\":\"\\x\"}",
+        "{\"tags\":[\"a\",]}",
+        "{\"active\":tru}",
+        "{\"id\":1} x",
+        "[]",
+    };
+    for(const char *text : cases)
+    {
+        demo::User user;
+        std::string err;
+        EXPECT_FALSE(JsonDecode(text, &user, &err)) << text;
+        EXPECT_NE(err.find(" at offset "), std::string::npos) << text;
+    }
+
+    // 嵌套过深
+    std::string deep = "{\"unknown\":";
+    deep.append(JsonReader::kMaxDepth + 1, '[');
+    demo::User user;
+    std::string err;
+    EXPECT_FALSE(JsonDecode(deep, &user, &err));
+    EXPECT_EQ(err.find("nesting too deep"), 0u);
+}
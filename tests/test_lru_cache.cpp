@@ -345,3 +345,33 @@ TEST(TestLruCache, MutilThreadRW)
 
     ASSERT_EQ(cache.size(), 10);
 }
+
+TEST(TestLruCache, WeightBudget)
+{
+    struct LengthWeigher {
+        size_t operator()(const std::string &value) const { return value.size(); }
+    };
+    LruCache<int, std::string, LengthWeigher> cache(10);
+
+    ASSERT_TRUE(cache.put(1, "aaaa"));
+    ASSERT_TRUE(cache.put(2, "bbbb"));
+    ASSERT_EQ(cache.weight(), 8u);
+
+    // 超出预算时从队尾淘汰，直到总权重不超过容量
+    ASSERT_TRUE(cache.put(3, "cccccc"));
+    ASSERT_FALSE(cache.exist(1));
+    ASSERT_TRUE(cache.exist(2));
+    ASSERT_EQ(cache.weight(), 10u);
+    ASSERT_EQ(cache.evictions(), 1u);
+
+    // 单个条目超过容量时不缓存，同名旧值一并移除
+    ASSERT_FALSE(cache.put(3, std::string(11, 'x')));
+    ASSERT_FALSE(cache.exist(3));
+    ASSERT_EQ(cache.weight(), 4u);
+
+    // 更新已有条目时按新旧权重差调整
+    ASSERT_TRUE(cache.put(2, "bb"));
+    ASSERT_EQ(cache.weight(), 2u);
+    ASSERT_EQ(cache.eraseIf([](int key, const std::string&) { return 2 == key; }), 1u);
+    ASSERT_EQ(cache.weight(), 0u);
+}
@@ -0,0 +1,198 @@
+/**
+ * @file test_metrics.cpp
+ * @brief 指标注册表测试: 分片计数、直方图分桶与分位、内置埋点
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 19:40:26
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "./test_log.h"
+#include <gtest/gtest.h>
+#include <future>
+#include <thread>
+#include <vector>
+#include "base/metrics.h"
+#include "base/event_loop_thread.h"
+#include "base/thread_pool.h"
+#include "net/event_loop.h"
+
+using namespace kit_muduo;
+using namespace kit_muduo::metrics;
+
+namespace {
+
+int64_t SampleValue(const std::string &name)
+{
+    for(auto &sample : MetricsRegistry::Instance().snapshot())
+    {
+        if(sample.name == name)
+        {
+            return MetricType::kHistogram == sample.type ? static_cast<int64_t>(sample.histogram.count) : sample.value;
+        }
+    }
+    return 0;
+}
+
+}
+
+TEST(TestMetrics, counter_and_gauge_across_threads)
+{
+    auto &registry = MetricsRegistry::Instance();
+    Counter &counter = registry.counter("test_counter_total", "test counter");
+    Gauge &gauge = registry.gauge("test_gauge", "test gauge");
+    EXPECT_EQ(&counter, &registry.counter("test_counter_total", "other help"));
+
+    constexpr int32_t kThreads = 8;
+    constexpr int32_t kLoops = 100000;
+    std::vector<std::thread> threads;
+    for(int32_t i = 0; i < kThreads; ++i)
+    {
+        threads.emplace_back([&](){
+            for(int32_t n = 0; n < kLoops; ++n)
+            {
+                counter.inc();
+                gauge.inc(2);
+                gauge.dec();
+            }
+        });
+    }
+    for(auto &t : threads)
+    {
+        t.join();
+    }
+
+    EXPECT_EQ(counter.value(), int64_t(kThreads) * kLoops);
+    EXPECT_EQ(gauge.value(), int64_t(kThreads) * kLoops);
+    EXPECT_EQ(SampleValue("test_counter_total"), int64_t(kThreads) * kLoops);
+}
+
+TEST(TestMetrics, type_conflict_returns_detached_metric)
+{
+    auto &registry = MetricsRegistry::Instance();
+    Counter &counter = registry.counter("test_conflict", "counter");
+    Gauge &gauge = registry.gauge("test_conflict", "gauge");
+    gauge.inc(5);
+    counter.inc(1);
+
+    // 冲突的注册仍可用，但不影响已导出的指标
+    EXPECT_EQ(SampleValue("test_conflict"), 1);
+    EXPECT_EQ(gauge.value(), 5);
+}
+
+TEST(TestMetrics, histogram_buckets)
+{
+    // 桶下标随值单调不减，且每个值都落在所在桶的上下界之间
+    size_t last = 0;
+    for(int64_t v = 0; v < 200000; v += (v < 1000 ? 1 : 97))
+    {
+        size_t index = Histogram::BucketIndex(v);
+        ASSERT_GE(index, last);
+        ASSERT_LT(index, Histogram::kBucketCount);
+        ASSERT_LE(Histogram::BucketLowerBound(index), v);
+        ASSERT_GE(Histogram::BucketUpperBound(index), v);
+        last = index;
+    }
+    EXPECT_EQ(Histogram::BucketIndex(Histogram::kMaxValue), Histogram::kBucketCount - 1);
+    EXPECT_EQ(Histogram::BucketUpperBound(Histogram::kBucketCount - 1), Histogram::kMaxValue);
+
+    // 相邻桶首尾相接
+    for(size_t i = 1; i < Histogram::kBucketCount; ++i)
+    {
+        ASSERT_EQ(Histogram::BucketUpperBound(i - 1) + 1, Histogram::BucketLowerBound(i));
+    }
+}
+
+TEST(TestMetrics, histogram_percentiles)
+{
+    Histogram &histogram = MetricsRegistry::Instance().histogram("test_latency_ns", "test histogram");
+
+    constexpr int32_t kThreads = 4;
+    std::vector<std::thread> threads;
+    for(int32_t i = 0; i < kThreads; ++i)
+    {
+        threads.emplace_back([&histogram, i](){
+            // 每个线程记录 1..100000 中的一部分
+            for(int64_t v = 1 + i; v <= 100000; v += kThreads)
+            {
+                histogram.record(v);
+            }
+        });
+    }
+    for(auto &t : threads)
+    {
+        t.join();
+    }
+    histogram.record(-3);
+
+    Histogram::Snapshot snap = histogram.snapshot();
+    EXPECT_EQ(snap.count, 100001u);
+    EXPECT_EQ(snap.max, 100000);
+    EXPECT_EQ(snap.sum, int64_t(100000) * 100001 / 2);
+
+    // 分桶相对误差不超过 1/16
+    auto expect_near = [&snap](double q, double expected){
+        double got = static_cast<double>(snap.percentile(q));
+        EXPECT_GE(got, expected) << "q=" << q;
+        EXPECT_LE(got, expected * (1.0 + 1.0 / 16)) << "q=" << q;
+    };
+    expect_near(0.5, 50000);
+    expect_near(0.99, 99000);
+    expect_near(0.999, 99900);
+    EXPECT_EQ(snap.percentile(1.0), 100000);
+    EXPECT_EQ(snap.percentile(0.0), 0);
+}
+
+TEST(TestMetrics, builtin_instrumentation)
+{
+    const int64_t funcs_before = SampleValue("kit_event_loop_funcs_total");
+    {
+        EventLoopThread loop_thread(nullptr, "metrics_loop");
+        EventLoop *loop = loop_thread.startLoop();
+        std::promise<void> done;
+        for(int32_t i = 0; i < 10; ++i)
+        {
+            loop->queueInLoop([](){});
+        }
+        loop->queueInLoop([&done](){ done.set_value(); });
+        done.get_future().wait();
+    }
+    EXPECT_GE(SampleValue("kit_event_loop_funcs_total"), funcs_before + 11);
+    EXPECT_EQ(SampleValue("kit_event_loop_pending_funcs"), 0);
+
+    const int64_t waits_before = SampleValue("kit_thread_pool_wait_ns");
+    {
+        ThreadPool pool(2);
+        pool.start();
+        std::vector<std::future<int>> results;
+        for(int32_t i = 0; i < 20; ++i)
+        {
+            results.push_back(pool.submitTask([i](){ return i; }).result_future);
+        }
+        for(auto &r : results)
+        {
+            r.get();
+        }
+    }
+    EXPECT_EQ(SampleValue("kit_thread_pool_wait_ns"), waits_before + 20);
+    EXPECT_EQ(SampleValue("kit_thread_pool_queue_depth"), 0);
+}
+
+TEST(TestMetrics, prometheus_text_format)
+{
+    auto &registry = MetricsRegistry::Instance();
+    registry.counter("test_prom_total", "line1\nline2").inc(3);
+    Histogram &histogram = registry.histogram("test_prom_ns", "prom histogram");
+    histogram.record(90);
+    histogram.record(2000);
+    histogram.record(20000000000);
+
+    const std::string text = FormatPrometheus(registry.snapshot());
+    EXPECT_NE(text.find("# HELP test_prom_total line1\\nline2\n# TYPE test_prom_total counter\ntest_prom_total 3\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_prom_ns histogram\n"), std::string::npos);
+    // 桶为累计计数，超出最大上界的值只计入 +Inf
+    EXPECT_NE(text.find("test_prom_ns_bucket{le=\"100\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_prom_ns_bucket{le=\"2500\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("test_prom_ns_bucket{le=\"10000000000\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("test_prom_ns_bucket{le=\"+Inf\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("test_prom_ns_count 3\n"), std::string::npos);
+}
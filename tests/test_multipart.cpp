@@ -0,0 +1,227 @@
+/**
+ * @file test_multipart.cpp
+ * @brief 增量 multipart 解析器测试
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 14:52:30
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "gtest/gtest.h"
+#include "test_log.h"
+
+#include "base/multipart.h"
+#include "base/content_parser.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+
+using namespace kit_muduo;
+
+namespace {
+
+const char kContentType[] = "multipart/form-data; boundary=\"----KitBoundary7MA4YWxk\"";
+
+/// @brief 二进制内容: 含 NUL、CRLF 与以 boundary 开头但后缀不合法的误匹配
+std::string BinaryPayload(size_t len)
+{
+    std::string data;
+    for(size_t i = 0; data.size() < len; ++i)
+    {
+        data.push_back(static_cast<char>(i * 131 % 256));
+        if(i % 97 == 0)
+        {
+            data += "\r\n------KitBoundary7MA4YWxkX";
+        }
+    }
+    data.resize(len);
+    return data;
+}
+
+std::string MakeBody(const std::string &file)
+{
+    std::ostringstream oss;
+    oss << "preamble is ignored\r\n";
+    oss << "------KitBoundary7MA4YWxk\r\n";
+    oss << "Content-Disposition: form-data; name=\"title\"\r\n\r\n";
+    oss << "hello world\r\n";
+    oss << "------KitBoundary7MA4YWxk  \r\n";
+    oss << "content-disposition: form-data; name=\"upload\"; filename=\"a;b.bin\"\r\n";
+    oss << "Content-Type: application/octet-stream\r\n";
+    oss << "X-Trace: 42\r\n\r\n";
+    oss << file << "\r\n";
+    // 只有 LF 的换行
+    oss << "------KitBoundary7MA4YWxk\n";
+    oss << "Content-Disposition: form-data; name=empty\n\n";
+    oss << "\n";
+    oss << "------KitBoundary7MA4YWxk--\r\n";
+    oss << "epilogue is ignored";
+    return oss.str();
+}
+
+}
+
+/*
+ * 测试思路: 一次性解析时 part 内容直接指向输入；头部参数、误匹配的分隔符、只有 LF 的换行均正确处理
+ */
+TEST(Multipart, ParseReturnsViewsIntoInput)
+{
+    const std::string file = BinaryPayload(10000);
+    const std::string body = MakeBody(file);
+
+    MultipartForm form;
+    ASSERT_TRUE(form.parse(body.data(), body.size(), kContentType)) << form.error();
+    ASSERT_EQ(form.parts().size(), 3u);
+
+    const auto *title = form.find("title");
+    ASSERT_NE(title, nullptr);
+    EXPECT_EQ(title->data(), "hello world");
+    EXPECT_FALSE(title->isFile());
+
+    const auto *upload = form.find("upload");
+    ASSERT_NE(upload, nullptr);
+    EXPECT_EQ(upload->filename, "a;b.bin");
+    EXPECT_EQ(upload->contentType, "application/octet-stream");
+    ASSERT_EQ(upload->headers.size(), 1u);
+    EXPECT_EQ(upload->headers[0].second, "42");
+    EXPECT_EQ(upload->size, file.size());
+    EXPECT_TRUE(upload->data() == file);
+    // 零拷贝: 内容就在输入缓冲中
+    EXPECT_GE(upload->data().data(), body.data());
+    EXPECT_LE(upload->data().data() + upload->data().size(), body.data() + body.size());
+
+    const auto *empty = form.find("empty");
+    ASSERT_NE(empty, nullptr);
+    EXPECT_EQ(empty->data(), "");
+
+    // 旧解析器头部名称大小写敏感、name 必须带引号，只识别 title
+    auto legacy = MultiFormParser::parse(body.data(), body.size(), kContentType);
+    ASSERT_EQ(legacy.count("title"), 1u);
+    EXPECT_EQ(std::string(legacy["title"].data.begin(), legacy["title"].data.end()), "hello world");
+}
+
+/*
+ * 测试思路: 以 1 字节到大于分隔符长度的各种块大小分块输入，结果都与一次性解析相同，
+ * 覆盖分隔符、"\r"、头部跨块的所有切分位置
+ */
+TEST(Multipart, FeedInAnyChunkSizeMatchesParse)
+{
+    const std::string file = BinaryPayload(3000);
+    const std::string body = MakeBody(file);
+
+    for(size_t chunk = 1; chunk <= 64; ++chunk)
+    {
+        MultipartForm::Config config;
+        config.spillBytes = 0;
+        MultipartForm form(config);
+        ASSERT_TRUE(form.begin(kContentType));
+        for(size_t off = 0; off < body.size(); off += chunk)
+        {
+            ASSERT_TRUE(form.feed(body.data() + off, std::min(chunk, body.size() - off))) << "chunk " << chunk << ": " << form.error();
+        }
+        ASSERT_TRUE(form.finish()) << "chunk " << chunk << ": " << form.error();
+        ASSERT_EQ(form.parts().size(), 3u) << "chunk " << chunk;
+        EXPECT_EQ(form.parts()[0].data(), "hello world") << "chunk " << chunk;
+        EXPECT_TRUE(form.parts()[1].data() == file) << "chunk " << chunk;
+        EXPECT_EQ(form.parts()[1].filename, "a;b.bin") << "chunk " << chunk;
+        EXPECT_EQ(form.parts()[2].data(), "") << "chunk " << chunk;
+    }
+}
+
+/*
+ * 测试思路: 超过 spillBytes 的 part 写入临时文件，内容完整；析构时删除，moveFile 取走的保留
+ */
+TEST(Multipart, SpillsLargePartsToTempFiles)
+{
+    const std::string file = BinaryPayload(200000);
+    const std::string body = MakeBody(file);
+    const std::string kept = "/tmp/kit_multipart_kept_" + std::to_string(::getpid());
+    std::string spilled_path;
+    {
+        MultipartForm::Config config;
+        config.spillBytes = 4096;
+        MultipartForm form(config);
+        ASSERT_TRUE(form.begin(kContentType));
+        for(size_t off = 0; off < body.size(); off += 1000)
+        {
+            ASSERT_TRUE(form.feed(body.data() + off, std::min<size_t>(1000, body.size() - off)));
+        }
+        ASSERT_TRUE(form.finish()) << form.error();
+
+        EXPECT_FALSE(form.parts()[0].spilled());
+        const auto &upload = form.parts()[1];
+        ASSERT_TRUE(upload.spilled());
+        EXPECT_TRUE(upload.data().empty());
+        EXPECT_EQ(upload.size, file.size());
+        spilled_path = upload.file;
+
+        std::ifstream in(upload.file, std::ios::binary);
+        const std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        EXPECT_TRUE(content == file);
+    }
+    struct stat st;
+    EXPECT_NE(::stat(spilled_path.c_str(), &st), 0);
+
+    {
+        MultipartForm::Config config;
+        config.spillBytes = 4096;
+        MultipartForm form(config);
+        ASSERT_TRUE(form.begin(kContentType));
+        ASSERT_TRUE(form.feed(body.data(), body.size()));
+        ASSERT_TRUE(form.finish());
+        ASSERT_TRUE(form.moveFile(1, kept));
+        EXPECT_FALSE(form.moveFile(0, kept));
+    }
+    ASSERT_EQ(::stat(kept.c_str(), &st), 0);
+    EXPECT_EQ(static_cast<size_t>(st.st_size), file.size());
+    ::unlink(kept.c_str());
+}
+
+/*
+ * 测试思路: 格式错误、超限与回调中止都返回 false 并给出原因
+ */
+TEST(Multipart, RejectsMalformedInput)
+{
+    const std::string ok_body = MakeBody("x");
+
+    MultipartForm no_boundary;
+    EXPECT_FALSE(no_boundary.parse(ok_body.data(), ok_body.size(), "multipart/form-data"));
+
+    // 缺少结束分隔符
+    const std::string truncated = ok_body.substr(0, ok_body.find("------KitBoundary7MA4YWxk--"));
+    MultipartForm form1;
+    EXPECT_FALSE(form1.parse(truncated.data(), truncated.size(), kContentType));
+    EXPECT_STREQ(form1.error(), "missing closing boundary");
+
+    // 分隔符后紧跟非法字符以外的内容: "--boundary -x"
+    const std::string bad_line = "------KitBoundary7MA4YWxk -x\r\n";
+    MultipartForm form2;
+    EXPECT_FALSE(form2.parse(bad_line.data(), bad_line.size(), kContentType));
+
+    // 头部过大
+    MultipartForm::Config small;
+    small.maxHeaderBytes = 32;
+    MultipartForm form3(small);
+    EXPECT_FALSE(form3.parse(ok_body.data(), ok_body.size(), kContentType));
+    EXPECT_STREQ(form3.error(), "part header too large");
+
+    // part 数超限
+    MultipartForm::Config few;
+    few.maxParts = 2;
+    MultipartForm form4(few);
+    EXPECT_FALSE(form4.parse(ok_body.data(), ok_body.size(), kContentType));
+    EXPECT_STREQ(form4.error(), "too many parts");
+
+    // 回调中止
+    MultipartReader reader("----KitBoundary7MA4YWxk");
+    int begins = 0;
+    reader.setPartBeginCallback([&](const MultipartReader::PartInfo &info) {
+        ++begins;
+        return info.name != "upload";
+    });
+    EXPECT_FALSE(reader.feed(ok_body.data(), ok_body.size()));
+    EXPECT_EQ(begins, 2);
+    EXPECT_EQ(reader.partCount(), 2u);
+}
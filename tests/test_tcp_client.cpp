@@ -0,0 +1,296 @@
+/**
+ * @file test_tcp_client.cpp
+ * @brief Connector/TcpClient测试: 非阻塞连接、退避重试、断线重连
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-20 20:06:17
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "base/event_loop_thread.h"
+#include "net/connector.h"
+#include "net/event_loop.h"
+#include "net/inet_address.h"
+#include "net/tcp_client.h"
+#include "net/tcp_server.h"
+#include "./test_log.h"
+
+#include "gtest/gtest.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <future>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace kit_muduo;
+
+namespace {
+
+/// @brief 取一个当前没有监听的回环端口
+uint16_t PickUnusedLoopbackPort()
+{
+    const int32_t fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    uint16_t port = 0;
+    if(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0
+       && ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0)
+    {
+        port = ::ntohs(addr.sin_port);
+    }
+    ::close(fd);
+    return port;
+}
+
+/**
+ * @brief 独立循环线程上的 TcpServer，closeOnConnect 时连接一建立就关闭
+ */
+class TestServer
+{
+public:
+    TestServer(uint16_t port, bool closeOnConnect)
+        :_thread(nullptr, "tcp_client_server")
+    {
+        _loop = _thread.startLoop();
+        std::promise<void> started;
+        _loop->runInLoop([&]() {
+            _server = std::make_shared<TcpServer>(_loop, InetAddress(port, "127.0.0.1"), "tcp-client-test", TcpServer::KReusePort);
+            _server->setThreadNum(0);
+            _server->setConnectionCallback([this, closeOnConnect](const TcpConnectionPtr &conn) {
+                if(conn->connected())
+                {
+                    ++accepted;
+                    if(closeOnConnect)
+                    {
+                        conn->forceClose();
+                    }
+                }
+            });
+            _server->setMessageCallback([](const TcpConnectionPtr &conn, Buffer *buffer, TimeStamp) {
+                conn->send(buffer->resetAllAsString());
+            });
+            _server->start();
+            started.set_value();
+        });
+        started.get_future().wait();
+    }
+
+    ~TestServer()
+    {
+        std::promise<void> done;
+        _loop->runInLoop([&]() {
+            _server.reset();
+            done.set_value();
+        });
+        done.get_future().wait();
+    }
+
+    std::atomic_int accepted{0};
+
+private:
+    EventLoopThread _thread;
+    EventLoop *_loop;
+    std::shared_ptr<TcpServer> _server;
+};
+
+/// @brief 在循环线程中销毁 TcpClient
+void DestroyInLoop(EventLoop *loop, std::unique_ptr<TcpClient> &client)
+{
+    std::promise<void> done;
+    loop->runInLoop([&]() {
+        client.reset();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
+}
+
+TEST(TestConnector, JitterStaysWithinBounds)
+{
+    EXPECT_EQ(1000, Connector::JitterDelay(1000, 0.0));
+    int64_t min_delay = 1000;
+    int64_t max_delay = 0;
+    for(int32_t i = 0; i < 1000; ++i)
+    {
+        const int64_t delay = Connector::JitterDelay(1000, 0.2);
+        min_delay = std::min(min_delay, delay);
+        max_delay = std::max(max_delay, delay);
+    }
+    EXPECT_GE(min_delay, 800);
+    EXPECT_LE(max_delay, 1200);
+    // 1000 次采样应当覆盖区间的大部分
+    EXPECT_LT(min_delay, 900);
+    EXPECT_GT(max_delay, 1100);
+}
+
+TEST(TestConnector, RefusedWithoutRetryReportsError)
+{
+    const uint16_t port = PickUnusedLoopbackPort();
+    ASSERT_NE(0, port);
+
+    EventLoopThread loop_thread(nullptr, "connector_refused_test");
+    EventLoop *loop = loop_thread.startLoop();
+
+    auto connector = std::make_shared<Connector>(loop, InetAddress(port, "127.0.0.1"));
+    std::promise<int32_t> error;
+    connector->setNewConnectionCallback([](int32_t sockfd) { ::close(sockfd); });
+    connector->setErrorCallback([&error](int32_t err) { error.set_value(err); });
+    connector->start();
+
+    auto future = error.get_future();
+    ASSERT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(2)));
+    EXPECT_EQ(ECONNREFUSED, future.get());
+}
+
+TEST(TestTcpClient, EchoOverTcpConnection)
+{
+    const uint16_t port = PickUnusedLoopbackPort();
+    ASSERT_NE(0, port);
+    TestServer server(port, false);
+
+    EventLoopThread loop_thread(nullptr, "tcp_client_echo_test");
+    EventLoop *loop = loop_thread.startLoop();
+    auto client = std::make_unique<TcpClient>(loop, InetAddress(port, "127.0.0.1"), "echo-client");
+
+    std::promise<std::string> echoed;
+    std::string received;
+    client->setConnectionCallback([](const TcpConnectionPtr &conn) {
+        if(conn->connected())
+        {
+            conn->send(std::string("ping over tcp client"));
+        }
+    });
+    client->setMessageCallback([&](const TcpConnectionPtr &conn, Buffer *buffer, TimeStamp) {
+        received += buffer->resetAllAsString();
+        if(received.size() >= 20)
+        {
+            echoed.set_value(received);
+        }
+    });
+    client->connect();
+
+    auto future = echoed.get_future();
+    ASSERT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(2)));
+    EXPECT_EQ("ping over tcp client", future.get());
+    ASSERT_NE(nullptr, client->connection());
+    EXPECT_EQ(port, client->connection()->peerAddr().toPort());
+
+    DestroyInLoop(loop, client);
+}
+
+TEST(TestTcpClient, RetriesUntilServerListens)
+{
+    const uint16_t port = PickUnusedLoopbackPort();
+    ASSERT_NE(0, port);
+
+    EventLoopThread loop_thread(nullptr, "tcp_client_retry_test");
+    EventLoop *loop = loop_thread.startLoop();
+    auto client = std::make_unique<TcpClient>(loop, InetAddress(port, "127.0.0.1"), "retry-client");
+    Connector::Backoff backoff;
+    backoff.initialDelayMs = 20;
+    backoff.maxDelayMs = 80;
+    client->setBackoff(backoff);
+
+    std::promise<void> up;
+    client->setConnectionCallback([&up](const TcpConnectionPtr &conn) {
+        if(conn->connected())
+        {
+            up.set_value();
+        }
+    });
+    client->connect();
+
+    // 先让连接失败几次，再启动服务端
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    EXPECT_EQ(nullptr, client->connection());
+    TestServer server(port, false);
+
+    auto future = up.get_future();
+    ASSERT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(2)));
+    // 客户端先于服务端循环看到连接建立
+    for(int32_t i = 0; i < 100 && server.accepted.load() == 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(1, server.accepted.load());
+
+    DestroyInLoop(loop, client);
+}
+
+TEST(TestTcpClient, ReconnectsAfterPeerClose)
+{
+    const uint16_t port = PickUnusedLoopbackPort();
+    ASSERT_NE(0, port);
+    TestServer server(port, true);
+
+    EventLoopThread loop_thread(nullptr, "tcp_client_reconnect_test");
+    EventLoop *loop = loop_thread.startLoop();
+    auto client = std::make_unique<TcpClient>(loop, InetAddress(port, "127.0.0.1"), "reconnect-client");
+    client->enableRetry();
+
+    std::atomic_int ups{0};
+    std::promise<void> enough;
+    client->setConnectionCallback([&](const TcpConnectionPtr &conn) {
+        if(conn->connected() && ++ups == 3)
+        {
+            enough.set_value();
+        }
+    });
+    client->connect();
+
+    auto future = enough.get_future();
+    ASSERT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(2)));
+    client->stop();
+    client->disconnect();
+    DestroyInLoop(loop, client);
+    EXPECT_GE(server.accepted.load(), 3);
+}
+
+TEST(TestTcpClient, DestroyWhileConnectedClosesConnection)
+{
+    const uint16_t port = PickUnusedLoopbackPort();
+    ASSERT_NE(0, port);
+    TestServer server(port, false);
+
+    EventLoopThread loop_thread(nullptr, "tcp_client_destroy_test");
+    EventLoop *loop = loop_thread.startLoop();
+    auto client = std::make_unique<TcpClient>(loop, InetAddress(port, "127.0.0.1"), "destroy-client");
+
+    std::promise<void> up;
+    std::promise<void> down;
+    client->setConnectionCallback([&](const TcpConnectionPtr &conn) {
+        if(conn->connected())
+        {
+            up.set_value();
+        }
+        else
+        {
+            down.set_value();
+        }
+    });
+    client->connect();
+    ASSERT_EQ(std::future_status::ready, up.get_future().wait_for(std::chrono::seconds(2)));
+
+    TcpConnectionPtr conn = client->connection();
+    DestroyInLoop(loop, client);
+    ASSERT_EQ(std::future_status::ready, down.get_future().wait_for(std::chrono::seconds(2)));
+    EXPECT_FALSE(conn->connected());
+}
+
+int main(int argc, char **argv)
+{
+    KIT_LOGGER("net")->setLevel(LogLevel::ERROR);
+    KIT_LOGGER("base")->setLevel(LogLevel::ERROR);
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -237,6 +237,89 @@ TEST(TestTcpServer, CrossThreadSendStringKeepsPayloadAliveUntilLoopCallback)
     ASSERT_EQ(done_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
 }
 
+TEST(TestTcpServer, EmptySendAfterQueuedSegmentDoesNotStallLoop)
+{
+    auto port_result = PickUnusedLoopbackPort();
+    if(!port_result.ok)
+    {
+        GTEST_SKIP() << "loopback TCP socket unavailable: " << port_result.error;
+    }
+    const uint16_t port = port_result.port;
+
+    EventLoopThread loop_thread(nullptr, "tcp_empty_send_test");
+    EventLoop *loop = loop_thread.startLoop();
+    ASSERT_NE(loop, nullptr);
+
+    std::shared_ptr<TcpServer> server;
+    TcpConnectionPtr server_conn;
+    std::promise<void> started;
+    auto started_future = started.get_future();
+    std::promise<void> connected;
+    auto connected_future = connected.get_future();
+
+    // 远大于套接字缓冲区，保证有共享分段排队
+    const size_t big_size = 8 * 1024 * 1024;
+    auto big = std::make_shared<const std::string>(big_size, 'b');
+    loop->runInLoop([&]() {
+        server = std::make_shared<TcpServer>(
+            loop,
+            InetAddress(port, "127.0.0.1"),
+            "tcp-empty-send-test",
+            TcpServer::KReusePort);
+        server->setThreadNum(0);
+        server->setConnectionCallback([&](const TcpConnectionPtr &conn) {
+            if(!conn->connected())
+            {
+                return;
+            }
+            server_conn = conn;
+            conn->send(std::vector<SharedBuffer>{big});
+            conn->send(std::string());
+            conn->send(std::vector<char>());
+            conn->send(std::vector<SharedBuffer>{std::make_shared<const std::string>()});
+            connected.set_value();
+        });
+        server->start();
+        started.set_value();
+    });
+
+    ASSERT_EQ(started_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    FdGuard client_fd(ConnectLoopback(port));
+    ASSERT_GE(client_fd.fd, 0);
+    ASSERT_EQ(connected_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+
+    size_t received = 0;
+    while(received < big_size)
+    {
+        const std::string data = RecvSome(client_fd.fd);
+        ASSERT_FALSE(data.empty());
+        received += data.size();
+    }
+    EXPECT_EQ(received, big_size);
+
+    // 队列排空后IO线程仍能处理任务，后续数据照常发出
+    std::promise<size_t> pending;
+    auto pending_future = pending.get_future();
+    loop->runInLoop([&]() {
+        server_conn->send(std::string("tail"));
+        pending.set_value(server_conn->pendingBytes());
+    });
+    ASSERT_EQ(pending_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    EXPECT_EQ(pending_future.get(), 0u);
+    EXPECT_EQ(RecvSome(client_fd.fd), "tail");
+
+    std::promise<void> done;
+    auto done_future = done.get_future();
+    loop->runInLoop([&]() {
+        server_conn.reset();
+        server.reset();
+        loop->quit();
+        done.set_value();
+    });
+    ASSERT_EQ(done_future.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+}
+
 TEST(TestTcpServer, EchoServerCanExit)
 {
     auto port_result = PickUnusedLoopbackPort();
@@ -0,0 +1,123 @@
+/**
+ * @file test_trace.cpp
+ * @brief 请求追踪测试: 采样率、环形覆盖、Chrome trace-event 导出
+ * @author Kewin Li
+ * @version 1.0
+ * @date 2026-10-19 20:58:40
+ * @copyright Copyright (c) 2026 Kewin Li
+ */
+#include "./test_log.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "nlohmann/json.hpp"
+#include "base/trace.h"
+#include "base/metrics.h"
+
+using namespace kit_muduo;
+
+namespace {
+
+/// @brief 导出并解析，只保留区间事件
+std::vector<nlohmann::json> DumpSpans()
+{
+    auto doc = nlohmann::json::parse(trace::DumpChromeTrace());
+    std::vector<nlohmann::json> spans;
+    for(auto &event : doc["traceEvents"])
+    {
+        if("X" == event["ph"])
+        {
+            spans.push_back(event);
+        }
+    }
+    return spans;
+}
+
+}
+
+TEST(TestTrace, sample_rate)
+{
+    trace::SetSampleRate(0);
+    EXPECT_FALSE(trace::Enabled());
+    EXPECT_EQ(trace::Sample(), 0u);
+
+    trace::SetSampleRate(1);
+    EXPECT_TRUE(trace::Enabled());
+    uint64_t last = 0;
+    for(int i = 0; i < 100; ++i)
+    {
+        uint64_t id = trace::Sample();
+        ASSERT_GT(id, last);
+        last = id;
+    }
+
+    trace::SetSampleRate(0.25);
+    int32_t sampled = 0;
+    for(int i = 0; i < 40000; ++i)
+    {
+        sampled += trace::Sample() ? 1 : 0;
+    }
+    EXPECT_GT(sampled, 9000);
+    EXPECT_LT(sampled, 11000);
+    trace::SetSampleRate(0);
+}
+
+TEST(TestTrace, ring_overwrites_oldest_and_exports_chrome_json)
+{
+    trace::Clear();
+    // 环形容量只对首次记录的线程生效，在新线程中验证覆盖
+    trace::SetRingCapacity(8);
+    std::thread worker([](){
+        for(uint64_t id = 1; id <= 20; ++id)
+        {
+            trace::Record(id, "unit", 1000 * id, 1000 * id + 500, 5 == id ? "a\"b" : "");
+        }
+        trace::Span untraced(0, "never");
+        trace::Span span(99, "scoped");
+    });
+    worker.join();
+    trace::SetRingCapacity(4096);
+
+    auto spans = DumpSpans();
+    ASSERT_EQ(spans.size(), 8u);
+    // 保留最新的 8 个，按写入顺序导出
+    EXPECT_EQ(spans.front()["args"]["trace_id"].get<uint64_t>(), 14u);
+    EXPECT_EQ(spans.back()["name"].get<std::string>(), "scoped");
+    EXPECT_DOUBLE_EQ(spans.front()["ts"].get<double>(), 14.0);
+    EXPECT_DOUBLE_EQ(spans.front()["dur"].get<double>(), 0.5);
+
+    // 已退出线程的缓冲在 Clear 时释放
+    trace::Clear();
+    EXPECT_TRUE(DumpSpans().empty());
+}
+
+TEST(TestTrace, detail_is_escaped)
+{
+    trace::Clear();
+    const int64_t now = metrics::NowNs();
+    trace::Record(7, "http.request", now, now + 10, "GET /a\"b\\c\n");
+    auto spans = DumpSpans();
+    ASSERT_EQ(spans.size(), 1u);
+    EXPECT_EQ(spans[0]["args"]["detail"].get<std::string>(), "GET /a\"b\\c\n");
+    trace::Clear();
+}
+
+TEST(TestTrace, disabled_overhead)
+{
+    trace::SetSampleRate(0);
+    constexpr int32_t kLoops = 10000000;
+    uint64_t sink = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for(int32_t i = 0; i < kLoops; ++i)
+    {
+        if(trace::Enabled())
+        {
+            sink += trace::Sample();
+        }
+        trace::Span span(sink, "off");
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+    TEST_F_INFO("disabled check + span: %.2f ns/op\n", static_cast<double>(ns) / kLoops);
+    EXPECT_EQ(sink, 0u);
+}